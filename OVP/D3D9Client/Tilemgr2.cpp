@@ -1031,7 +1031,9 @@ DWORD WINAPI TileLoader::Load_ThreadProc (void *data)
 		ReleaseMutex ();
 
 		if (nload) {
-			
+#ifdef ORBITER_PROFILE
+			oapi::ProfileZone zone ("TileLoader::Load_ThreadProc");
+#endif
 			for (i = 0; i < nload; i++) {
 				tile[i]->PreLoad(); // load/create the tile
 				tile[i]->Load();
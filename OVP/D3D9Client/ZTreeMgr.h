@@ -18,6 +18,13 @@
 
 #include <iostream>
 #include <windows.h>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
 
 /// \defgroup ztree Z-Tree management for tile archive access
 /// @{
@@ -92,6 +99,47 @@ private:
 };
 
 
+// =======================================================================
+/**
+ * \brief Size-bounded cache of inflated tree nodes, shared by all tree
+ * managers (surface, mask, elevation, labels, clouds) of a planet.
+ * Inflated data are allocated from a pool of recycled buffers.
+ */
+class ZTreeCache : public std::enable_shared_from_this<ZTreeCache> {
+public:
+	typedef std::shared_ptr<BYTE> Block;
+
+	/// Cache for the planet at PlanetPath, created if necessary
+	static std::shared_ptr<ZTreeCache> Get (const char *PlanetPath);
+
+	ZTreeCache (size_t _maxSize);
+	~ZTreeCache ();
+
+	/// Cached node and its size (marked as most recently used), or NULL
+	Block Find (uint64_t key, DWORD *size);
+
+	/// Add a node. If the node is already cached, the cached block is returned.
+	Block Insert (uint64_t key, Block data, DWORD size);
+
+	/// Buffer from the pool. Released buffers go back to the pool.
+	Block Alloc (DWORD size);
+
+private:
+	void Recycle (BYTE *buf, DWORD size);
+
+	struct Entry {
+		Block data;
+		DWORD size;
+		std::list<uint64_t>::iterator lru;
+	};
+	std::mutex mutex;
+	std::unordered_map<uint64_t, Entry> node;            ///< cached nodes
+	std::list<uint64_t> lru;                             ///< node keys, most recently used first
+	std::unordered_map<DWORD, std::vector<BYTE*> > pool; ///< free buffers by size
+	size_t size, maxSize;                                ///< cached data size, limit [bytes]
+	size_t poolSize;                                     ///< free buffer size [bytes]
+};
+
 // =======================================================================
 /**
  * \brief ZTreeMgr class: manage a single layer tree for a planet
@@ -110,10 +158,12 @@ public:
 
 	inline const TreeTOC &TOC () const { return toc; }
 
-	DWORD Idx (int lvl, int ilat, int ilng);
+	DWORD Idx (int lvl, int ilat, int ilng) const;
 	// return the array index of an arbitrary tile ((DWORD)-1: not present)
 
 	DWORD ReadData (DWORD idx, BYTE **outp);
+	// Inflated node data. The buffer may be shared with other readers
+	// and must not be modified. Release with ReleaseData.
 
 	inline DWORD ReadData (int lvl, int ilat, int ilng, BYTE **outp)
 	{ return ReadData(Idx(lvl, ilat, ilng), outp); }
@@ -125,18 +175,34 @@ public:
 
 protected:
 	bool OpenArchive ();
+	void MapArchive (const char *fname);
+	void BuildIndex ();
+	void AddIndex (int lvl, int ilat, int ilng, DWORD idx);
 	inline DWORD Inflate (const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
 
+	static inline uint64_t NodeKey (int lvl, int ilat, int ilng)
+	{ return ((uint64_t)lvl << 56) | ((uint64_t)ilat << 28) | (uint64_t)ilng; }
+
 private:
 	char    *path;       ///< file path of the tree-file
 	Layer   layer;	     ///< layer type (enum)
-	FILE    *treef;      ///< file pointer to tree-file
+	FILE    *treef;      ///< file pointer to tree-file, if it couldn't be mapped
+	std::mutex fileMutex;
+	HANDLE  hFile, hMap;
+	const BYTE *mapData; ///< mapped tree-file
 	TreeTOC toc;         ///< tree table of contents
 	DWORD   rootPos1;    ///< index of level-1 tile ((DWORD)-1 for not present)
 	DWORD   rootPos2;    ///< index of level-2 tile ((DWORD)-1 for not present)
 	DWORD   rootPos3;    ///< index of level-3 tile ((DWORD)-1 for not present)
 	DWORD   rootPos4[2]; ///< index of the level-4 tiles (quadtree roots; (DWORD)-1 for not present)
 	__int64 dofs;
+
+	struct IndexEntry { uint64_t key; DWORD idx; };
+	std::vector<IndexEntry> index;     ///< open-addressing hash (lvl,ilat,ilng) -> node index, for lvl > 4
+	uint64_t indexMask;
+	std::shared_ptr<ZTreeCache> cache; ///< node cache shared with the other layers of the planet
+	std::mutex outMutex;
+	std::unordered_map<BYTE*, std::pair<ZTreeCache::Block, int> > out; ///< buffers handed out by ReadData
 };
 
 /// @}
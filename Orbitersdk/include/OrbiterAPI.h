@@ -2615,6 +2615,40 @@ OAPIFUNC DWORD oapiGetVesselCount ();
  */
 OAPIFUNC bool oapiIsVessel (OBJHANDLE hVessel);
 
+/**
+ * \brief Returns the vessels within a given distance of a point.
+ * \param gpos point in global coordinates [<b>m</b>]
+ * \param r search radius [<b>m</b>]
+ * \param list array receiving the vessel handles
+ * \param maxn size of \e list
+ * \param hExclude vessel to be omitted from the search (e.g. the caller), or NULL
+ * \return Number of vessels within range. This can be larger than \e maxn,
+ *   in which case only the first \e maxn handles are written to \e list.
+ * \note The handles are returned in no particular order.
+ * \note The search uses a spatial index of all vessels which is built once
+ *   per frame, so it is much faster than a loop over all vessels in large
+ *   scenarios. Vessel positions refer to the end of the last completed
+ *   time step.
+ * \sa oapiGetNearestVessels, oapiGetVesselByIndex
+ */
+OAPIFUNC int oapiGetVesselsInRange (const VECTOR3 &gpos, double r, OBJHANDLE *list, int maxn, OBJHANDLE hExclude = NULL);
+
+/**
+ * \brief Returns the vessels closest to a point.
+ * \param gpos point in global coordinates [<b>m</b>]
+ * \param k max. number of vessels to return
+ * \param list array of size >= \e k receiving the vessel handles
+ * \param dist array of size >= \e k receiving the distances of the vessels
+ *   from \e gpos [<b>m</b>] (or NULL if not required)
+ * \param hExclude vessel to be omitted from the search (e.g. the caller), or NULL
+ * \return Number of vessels written to \e list (less than \e k only if the
+ *   simulation contains fewer vessels).
+ * \note The vessels are sorted by increasing distance.
+ * \note Vessel positions refer to the end of the last completed time step.
+ * \sa oapiGetVesselsInRange
+ */
+OAPIFUNC int oapiGetNearestVessels (const VECTOR3 &gpos, int k, OBJHANDLE *list, double *dist = NULL, OBJHANDLE hExclude = NULL);
+
 /**
  * \brief Returns the handle of a celestial body (sun, planet or moon) identified
  *   by its name.
@@ -6286,6 +6320,51 @@ OAPIFUNC void oapiWriteLogV (const char *format, ...);
 #define oapiWriteLogError(format, ...) __writeLogError(__FUNCTION__,__FILE__,__LINE__, format, __VA_ARGS__)
 OAPIFUNC void __writeLogError(const char *func, const char *file, int line, const char *format, ...);
 
+	/**
+	* \brief Opens a named profiler zone on the calling thread.
+	* \param name zone name (zero-terminated). The string is copied.
+	* \note Zones are only recorded if Orbiter was built with the ORBITER_PROFILER
+	*  CMake option. Otherwise this function does nothing.
+	* \note Each call must be matched by a call to oapiProfileEnd on the same thread.
+	*  Zones can be nested. oapi::ProfileZone closes the zone automatically at the
+	*  end of the enclosing scope.
+	* \note The recorded zones are written to Orbiter_trace.json at the end of the
+	*  session, or on request with oapiProfileDump, and can be viewed in
+	*  chrome://tracing. This allows frame spikes to be attributed to a
+	*  particular module callback.
+	* \sa oapiProfileEnd, oapiProfileDump
+	*/
+OAPIFUNC void oapiProfileBegin (const char *name);
+
+	/**
+	* \brief Closes the innermost profiler zone opened on the calling thread.
+	* \sa oapiProfileBegin
+	*/
+OAPIFUNC void oapiProfileEnd ();
+
+	/**
+	* \brief Writes the recorded profiler zones of all threads to a file in
+	*  Chrome trace-event JSON format.
+	* \param fname file name (relative to the Orbiter root directory)
+	* \return \e false if Orbiter was built without profiler support, or the file
+	*  could not be written.
+	* \note Only the most recent zones of each thread are kept (65536 per thread).
+	* \sa oapiProfileBegin
+	*/
+OAPIFUNC bool oapiProfileDump (const char *fname);
+
+namespace oapi {
+	/**
+	* \brief Profiler zone covering the enclosing scope.
+	* \sa oapiProfileBegin
+	*/
+	class ProfileZone {
+	public:
+		explicit ProfileZone (const char *name) { oapiProfileBegin (name); }
+		~ProfileZone () { oapiProfileEnd (); }
+	};
+}
+
    /**
 	* \brief Writes a string-valued item to a scenario file.
 	* \param scn file handle
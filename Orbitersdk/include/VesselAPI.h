@@ -1575,6 +1575,35 @@ public:
 	 */
 	void EditAirfoil (AIRFOILHANDLE hAirfoil, DWORD flag, const VECTOR3 &ref, AirfoilCoeffFunc cf, double c, double S, double A) const;
 
+	/**
+	 * \brief Replaces the coefficient callback of an airfoil with a table.
+	 * \param hAirfoil airfoil handle
+	 * \param tabulate \e true to use a table, \e false to revert to the callback function
+	 * \return \e false if the airfoil does not support tabulation (airfoils
+	 *   created with \ref CreateAirfoil4).
+	 * \note Orbiter samples the callback function once over a grid of angle
+	 *   of attack, Mach number and Reynolds number (about 1 deg, 0.025-0.8
+	 *   and half a decade spacing), and afterwards interpolates the
+	 *   coefficients from the table. This is faster than calling the
+	 *   function at every force evaluation, in particular for vessels with
+	 *   many airfoils or at high time step subdivision.
+	 * \note Only use tables for coefficient functions that depend on the
+	 *   flow parameters alone. Functions returning identical coefficients
+	 *   for identical arguments (including the \e context pointer) share a
+	 *   single table across all vessels.
+	 * \note The interpolation error is written to the log file when the
+	 *   table is sampled.
+	 * \note Tabulation can also be enabled for all airfoils of a vessel class
+	 *   with the "TabulateAirfoils = TRUE" entry in the class config file.
+	 *   With "AirfoilTables = <file>", the tables are loaded from the given
+	 *   file (relative to the Config directory, without ".cfg"), and written
+	 *   to it if they have to be sampled. Delete the file after changing the
+	 *   coefficient functions.
+	 * \note Changing the callback with \ref EditAirfoil discards the table.
+	 * \sa CreateAirfoil2, CreateAirfoil3, EditAirfoil
+	 */
+	bool TabulateAirfoil (AIRFOILHANDLE hAirfoil, bool tabulate = true) const;
+
 	/**
 	 * \brief Deletes a previously defined airfoil.
 	 * \param hAirfoil airfoil handle
@@ -4170,6 +4199,20 @@ public:
 	 */
 	bool GetSuperstructureCG (VECTOR3 &cg) const;
 
+	/**
+	 * \brief Returns the principal moments of inertia of the superstructure
+	 *   to which the vessel belongs, if applicable.
+	 * \param pmi superstructure moments of inertia [<b>m<sup>2</sup></b>]
+	 * \return \e true if the vessel is part of a superstructure, \e false
+	 *   otherwise.
+	 * \note The returned values are the mass-normalised moments of inertia
+	 *   of the superstructure about its centre of gravity, for rotations
+	 *   around the axes of the local vessel frame.
+	 * \note If the vessel is not part of a superstructure, pmi returns (0,0,0).
+	 * \sa GetSuperstructureCG, GetPMI
+	 */
+	bool GetSuperstructurePMI (VECTOR3 &pmi) const;
+
 	/**
 	 * \brief Returns the current rotation matrix for transformations
 	 *   from the vessel's local frame of reference to the global frame.
@@ -0,0 +1,12 @@
+-- Superstructure benchmark load: every vessel in the scenario gets a tank and
+-- a pair of opposed thrusters, so that propellant flows in all components of
+-- the assembly. The simulation is terminated by the benchmark driver.
+
+for i = 0, vessel.get_count()-1 do
+	local v = vessel.get_interface(i)
+	local ph = v:create_propellantresource(2000)
+	local th1 = v:create_thruster({pos={x=0, y=2, z=0}, dir={x=1, y=0, z=0}, maxth0=2e4, hprop=ph, isp0=3000})
+	local th2 = v:create_thruster({pos={x=0, y=2, z=0}, dir={x=-1, y=0, z=0}, maxth0=1e4, hprop=ph, isp0=3000})
+	v:set_thrusterlevel(th1, 1)
+	v:set_thrusterlevel(th2, 1)
+end
@@ -0,0 +1,160 @@
+-- Superstructure stress test: 60 docked modules with propellant flowing in
+-- several components. The superstructure CG and PMI maintained incrementally
+-- by Orbiter are compared with values calculated from the current components.
+
+nmodule = 60
+
+function add_line(line)
+	oapi.dbg_out(line)
+	oapi.write_log(line)
+end
+
+function assert(cond)
+	if cond == false then
+		add_line(" - FAILED!")
+		error("Assertion failed\n"..debug.traceback())
+        oapi.exit(1)
+	end
+end
+
+function pass()
+	add_line(" - passed")
+end
+
+-- CG of the assembly containing module m[i0] from the component masses, and
+-- as reported by the superstructure, both in global coordinates
+function check_cg(i0, i1)
+	local msum = 0
+	local cg = {x=0, y=0, z=0}
+	for i = i0, i1 do
+		local mi = m[i]:get_mass()
+		local p = m[i]:get_globalpos()
+		msum = msum + mi
+		cg.x = cg.x + p.x*mi
+		cg.y = cg.y + p.y*mi
+		cg.z = cg.z + p.z*mi
+	end
+	cg.x = cg.x/msum
+	cg.y = cg.y/msum
+	cg.z = cg.z/msum
+	local scg = m[i0]:get_superstructurecg()
+	assert(scg ~= nil)
+	scg = m[i0]:local2global(scg)
+	local d = vec.dist(cg, scg)
+	add_line(string.format("   modules %d-%d: mass %.1f kg, CG deviation %.3g m", i0, i1, msum, d))
+	assert(d < 0.01)
+end
+
+-- PMI of the assembly containing module m[i0] from the current component
+-- masses and PMIs, as a rebuild of the superstructure mass sums would give,
+-- compared with the incrementally maintained superstructure PMI. Only valid
+-- when no masses are changing, since the superstructure registers mass
+-- changes one frame late.
+function check_pmi(i0, i1)
+	-- second moments of the component mass models (6 point masses on the
+	-- principal axes of each component) in the frame of m[i0]
+	local msum = 0
+	local mr = {x=0, y=0, z=0}
+	local mq = {x=0, y=0, z=0}
+	for i = i0, i1 do
+		local mi = m[i]:get_mass()
+		local pmi = m[i]:get_pmi()
+		local rx = math.sqrt(1.5*math.abs(-pmi.x + pmi.y + pmi.z))
+		local ry = math.sqrt(1.5*math.abs( pmi.x - pmi.y + pmi.z))
+		local rz = math.sqrt(1.5*math.abs( pmi.x + pmi.y - pmi.z))
+		local pts = {{x=rx, y=0, z=0}, {x=-rx, y=0, z=0}, {x=0, y=ry, z=0},
+		             {x=0, y=-ry, z=0}, {x=0, y=0, z=rz}, {x=0, y=0, z=-rz}}
+		for _, p in ipairs(pts) do
+			local r = m[i0]:global2local(m[i]:local2global(p))
+			mq.x = mq.x + r.x*r.x*mi/6
+			mq.y = mq.y + r.y*r.y*mi/6
+			mq.z = mq.z + r.z*r.z*mi/6
+		end
+		local r = m[i0]:global2local(m[i]:get_globalpos())
+		msum = msum + mi
+		mr.x = mr.x + r.x*mi
+		mr.y = mr.y + r.y*mi
+		mr.z = mr.z + r.z*mi
+	end
+	local cg = {x=mr.x/msum, y=mr.y/msum, z=mr.z/msum}
+	local q = {x=mq.x/msum, y=mq.y/msum, z=mq.z/msum}
+	local ref = {x=q.y + q.z - (cg.y*cg.y + cg.z*cg.z),
+	             y=q.x + q.z - (cg.x*cg.x + cg.z*cg.z),
+	             z=q.x + q.y - (cg.x*cg.x + cg.y*cg.y)}
+	local spmi = m[i0]:get_superstructurepmi()
+	assert(spmi ~= nil)
+	local d = vec.dist(ref, spmi)/vec.length(ref)
+	add_line(string.format("   modules %d-%d: PMI %.4g %.4g %.4g m^2, relative deviation %.3g",
+		i0, i1, spmi.x, spmi.y, spmi.z, d))
+	assert(d < 1e-6)
+end
+
+add_line("=== Superstructure stress test ===")
+
+m = {}
+for i = 0, nmodule-1 do
+	m[i] = vessel.get_interface(string.format("M-%02d", i))
+	assert(m[i] ~= nil)
+end
+
+add_line("Test: assembly is docked")
+for i = 0, nmodule-2 do
+	assert(m[i]:dockingstatus(0) == 1)
+end
+assert(m[0]:get_superstructurecg() ~= nil)
+check_cg(0, nmodule-1)
+check_pmi(0, nmodule-1)
+pass()
+
+add_line("Test: propellant flow in several components")
+-- every 6th module gets a tank and a pair of opposed thrusters with different
+-- ratings, so that its mass decreases without changing the overall motion much
+th = {}
+for i = 0, nmodule-1, 6 do
+	local ph = m[i]:create_propellantresource(2000)
+	local th1 = m[i]:create_thruster({pos={x=0, y=2, z=0}, dir={x=1, y=0, z=0}, maxth0=2e4, hprop=ph, isp0=3000})
+	local th2 = m[i]:create_thruster({pos={x=0, y=2, z=0}, dir={x=-1, y=0, z=0}, maxth0=1e4, hprop=ph, isp0=3000})
+	m[i]:set_thrusterlevel(th1, 1)
+	m[i]:set_thrusterlevel(th2, 1)
+	th[i] = {th1, th2}
+end
+m0 = m[0]:get_mass()
+oapi.set_tacc(10)
+for k = 1, 5 do
+	proc.wait_simdt(5)
+	check_cg(0, nmodule-1)
+end
+assert(m[0]:get_mass() < m0)
+-- stop the flow, so that the PMI can be compared after many incremental updates
+for i, t in pairs(th) do
+	m[i]:set_thrusterlevel(t[1], 0)
+	m[i]:set_thrusterlevel(t[2], 0)
+end
+proc.wait_simdt(1)
+check_pmi(0, nmodule-1)
+pass()
+
+add_line("Test: empty mass changes")
+for i = 3, nmodule-1, 12 do
+	m[i]:set_emptymass(m[i]:get_emptymass() * 2)
+end
+proc.wait_simdt(1)
+check_cg(0, nmodule-1)
+check_pmi(0, nmodule-1)
+pass()
+
+add_line("Test: undocking splits the assembly")
+m[29]:undock(0)
+proc.wait_simdt(1)
+assert(m[29]:dockingstatus(0) == 0)
+check_cg(0, 29)
+check_cg(30, nmodule-1)
+proc.wait_simdt(5)
+check_cg(0, 29)
+check_cg(30, nmodule-1)
+check_pmi(0, 29)
+check_pmi(30, nmodule-1)
+pass()
+
+add_line("=== All tests passed ===")
+oapi.exit(0)
@@ -34,79 +34,35 @@ function run_global (script)
 end
 
 -- -------------------------------------------------
--- Branch management
--- Branch threads are stored in table 'branch' with
--- counter 'branch.count'
+-- Background jobs
+-- Jobs are coroutines managed by the interpreter's
+-- scheduler. Each job gets one cycle per frame unless
+-- it is blocked in one of the wait functions below.
 -- -------------------------------------------------
 
-branch = {}
-branch.count = 0
-branch.nslot = 0
-
--- Create a new branch coroutine, store it in the branch
--- table, and execute its first cycle
+-- Create a new background job and execute its first cycle
 
 function proc.bg (func,...)
-	-- first, collect all dead branches
-	for i=1,branch.nslot do
-		if branch[i] ~= nil then
-			if coroutine.status(branch[i]) == 'dead' then
-				branch[i] = nil
-				branch.count = branch.count-1
-			end
-		end
-	end
-
-	-- check if there is a free slot
-	local slot = 0
-	for i=1,branch.nslot do
-		if branch[i] == nil then
-			slot = i
-			break
-		end
-	end
-
-	-- no free slot: increase branch counter
-	if slot == 0 then
-		branch.nslot = branch.nslot+1
-		slot = branch.nslot
-	end
-
-	-- create the new branch
-	local th = coroutine.create (func)
-	branch[slot] = th
-	branch.count = branch.count+1
-	coroutine.resume (th,...)
-	term.out ('job id='..slot..' ('..branch.count..' jobs)')
-	return slot
+	local id = proc.Spawn (func,...)
+	term.out ('job id='..id..' ('..proc.Jobs()..' jobs)')
+	return id
 end
 
--- Remove a branch from the branch table (and keep fingers
--- crossed that the coroutine will be garbage-collected)
+-- Terminate a background job
 
 function proc.kill (n)
-	if branch[n] ~= nil then
-		branch[n] = nil
-		branch.count = branch.count-1
-		while (branch.nslot > 0) and (branch[branch.nslot] == nil) do
-			branch.nslot = branch.nslot-1
-		end
-		term.out ('job '..n..' killed ('..branch.count..' jobs left)')
+	if proc.Kill (n) then
+		term.out ('job '..n..' killed ('..proc.Jobs()..' jobs left)')
 	end
 end
 
--- Time skip: branches yield, the main trunk resumes all
--- coroutines for a single cycle, then calls proc.Frameskip
--- to pass control back to orbiter for a new simulation cycle
+-- Time skip: jobs yield, the main trunk resumes all
+-- jobs for a single cycle, then passes control back
+-- to orbiter for a new simulation cycle
 
 function proc.skip ()
 	if coroutine.running() == nil then  -- we are in the main trunk
-		for i=1,branch.nslot do
-			if branch[i] ~= nil then
-				coroutine.resume (branch[i])
-			end
-		end
-		proc.Frameskip() -- hand control to orbiter for one cycle
+		proc.Frameskip() -- run jobs and hand control to orbiter for one cycle
             if wait_exit ~= nil then
                 error()   -- return to caller immediately
             end
@@ -115,6 +71,18 @@ function proc.skip ()
 	end
 end
 
+-- List the CPU time used by the main trunk and the
+-- background jobs, to find scripts that stall the
+-- simulation
+
+function proc.top ()
+	term.out ('  id state        last[ms]  peak[ms]  total[s] over  name')
+	for _,u in ipairs (proc.usage()) do
+		term.out (string.format ('%4d %-10s %9.3f %9.3f %9.3f %5d  %s',
+			u.id, u.state, u.last*1e3, u.peak*1e3, u.total, u.overrun, u.name))
+	end
+end
+
 -- -------------------------------------------------
 -- A few waiting functions
 -- -------------------------------------------------
@@ -122,6 +90,9 @@ end
 -- wait for simulation time t.
 -- Optionally execute a function at each frame while waiting
 function proc.wait_simtime (t, f, ...)
+	if f == nil and proc.WaitSimtime (t) then
+		return  -- suspended by the scheduler
+	end
     while oapi.get_simtime() < t do
 		if f then
 			f(unpack(arg))
@@ -134,6 +105,9 @@ end
 -- Optionally execute a function at each frame while waiting
 function proc.wait_simdt (dt, f, ...)
     local t1 = oapi.get_simtime()+dt
+	if f == nil and proc.WaitSimtime (t1) then
+		return  -- suspended by the scheduler
+	end
     while oapi.get_simtime() < t1 do
 		if f then
 			f(unpack(arg))
@@ -188,6 +162,36 @@ function proc.wait_le (f, tgt, ...)
     while f(unpack(arg)) > tgt do proc.skip() end
 end
 
+-- wait until f() returns true.
+-- Optionally give up after dt seconds of simulation time.
+-- Returns false on timeout
+function proc.wait_until (f, dt)
+	local handled, res = proc.WaitUntil (f, dt)
+	if handled then
+		return res
+	end
+	-- not a scheduler-managed coroutine: poll
+	local t1 = dt and oapi.get_simtime()+dt
+	while not f() do
+		if t1 and oapi.get_simtime() >= t1 then
+			return false
+		end
+		proc.skip()
+	end
+	return true
+end
+
+-- wait until event 'name' is raised with proc.signal.
+-- Optionally give up after dt seconds of simulation time.
+-- Returns false on timeout
+function proc.wait_event (name, dt)
+	local handled, res = proc.WaitEvent (name, dt)
+	if not handled then
+		error ('proc.wait_event: not available in this coroutine', 2)
+	end
+	return res
+end
+
 -- wait for input
 function proc.wait_input (title)
     oapi.open_inputbox (title)
@@ -199,29 +203,6 @@ function proc.wait_input (title)
     return ans
 end
 
--- -------------------------------------------------
--- Private functions (should not be directly called)
--- -------------------------------------------------
-
--- Idle loop (called after command returns, to allow
--- background jobs to continue executing)
-
-function _idle ()
-	for i=1,branch.nslot do
-		if branch[i] ~= nil then
-			coroutine.resume (branch[i])
-		end
-	end
-	return branch.count
-end
-
--- Returns the number of background jobs
-
-function _nbranch ()
-    return branch.count
-end
-
-
 -- helpers for basic types
 function _V(x,y,z)
 	return {x=x, y=y, z=z}
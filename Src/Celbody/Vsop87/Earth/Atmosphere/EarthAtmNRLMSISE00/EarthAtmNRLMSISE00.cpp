@@ -8,9 +8,8 @@
 
 #define ORBITER_MODULE
 #include "EarthAtmNRLMSISE00.h"
-#include "nrlmsise-00.h"
 
-EarthAtmosphere_NRLMSISE00::EarthAtmosphere_NRLMSISE00 (CELBODY2 *body): ATMOSPHERE (body)
+EarthAtmosphere_NRLMSISE00::EarthAtmosphere_NRLMSISE00 (CELBODY2 *body): ATMOSPHERE (body), cache (&msis)
 {
 	pmjd = -1000000;  // invalidate
 	doy = 0;
@@ -33,22 +32,6 @@ bool EarthAtmosphere_NRLMSISE00::clbkConstants (ATMCONST *atmc) const
 
 bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 {
-	static struct nrlmsise_output output = {0};
-	static struct nrlmsise_input input = {
-		0,    // year, currently ignored
-		172,  // day of year
-		29000,// second in day
-		0,    // altitude [km]
-		0,    // geodetic latitude [deg]
-		0,    // geodetic longitude [deg]
-		0,    // local apparent solar time (hours)
-		140,  // 81 day average of F10.7 flux (centered on doy)
-		140,  // daily F10.7 flux for previous day
-		3.0,  // magnetic index(daily)
-		NULL  // pointer to detailed magnetic values
-	};
-	static struct nrlmsise_flags flags = {0,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1};
-
 	double mjd = oapiGetSimMJD();
 
 	// second in the day calculation
@@ -78,23 +61,23 @@ bool EarthAtmosphere_NRLMSISE00::clbkParams (const PRM_IN *prm_in, PRM_OUT *prm)
 		pmjd = (int)mjd;
 	}
 
-	input.doy    = doy;
-	input.sec    = h*3600.0;
-
-	input.alt    = (prm_in->flag & PRM_ALT ? prm_in->alt*1e-3 : 0.0);
-	input.g_long = (prm_in->flag & PRM_LNG ? prm_in->lng*DEG : 0.0);
-	input.g_lat  = (prm_in->flag & PRM_LAT ? prm_in->lat*DEG : 0.0);
-	input.lst    = h+input.g_long/15.0;
-	input.f107A  = (prm_in->flag & PRM_FBR ? prm_in->f107bar : 140.0);
-	input.f107   = (prm_in->flag & PRM_F   ? prm_in->f107 : input.f107A);
-	input.ap     = (prm_in->flag & PRM_AP  ? prm_in->ap : 3.0);
-
-	gtd7 (&input, &flags, &output);
-	double n = output.d[0]+output.d[1]+output.d[2]+output.d[3]+output.d[4]+output.d[6]+output.d[7]; // total number density [1/cm^3]
-	static double k = 1.38066e-23*1e6; // Boltzmann constant and scale from cm^-3 to m^-3
-	prm->T = output.t[1];
-	prm->p = n*k*prm->T;
-	prm->rho = output.d[5]*1e3;
+	double f107A = (prm_in->flag & PRM_FBR ? prm_in->f107bar : 140.0);
+	double f107  = (prm_in->flag & PRM_F   ? prm_in->f107 : f107A);
+	double ap    = (prm_in->flag & PRM_AP  ? prm_in->ap : 3.0);
+	msis.SetEpoch (doy, h*3600.0, f107A, f107, ap); // only updates terms that changed
+
+	double alt = (prm_in->flag & PRM_ALT ? prm_in->alt*1e-3 : 0.0);
+	double lng = (prm_in->flag & PRM_LNG ? prm_in->lng*DEG : 0.0);
+	double lat = (prm_in->flag & PRM_LAT ? prm_in->lat*DEG : 0.0);
+
+	MsisEvaluator::Prm res;
+	if (!cache.Eval (alt, lat, lng, res)) {
+		MsisEvaluator::Point pt = msis.At (alt, lat, lng);
+		msis.Eval (&pt, &res, 1);
+	}
+	prm->T = res.T;
+	prm->p = res.p;
+	prm->rho = res.rho;
 
 	return true;
 }
@@ -6,6 +6,7 @@
 
 #include "OrbiterAPI.h"
 #include "CelbodyAPI.h"
+#include "MsisEvaluator.h"
 
 // ======================================================================
 // class EarthAtmosphere_NRLMSISE00
@@ -22,6 +23,8 @@ public:
 private:
 	int pmjd; // date of previous day-of-year calculation
 	int doy;  // current day-of-year value
+	MsisEvaluator msis;   // model with terms of the current epoch
+	MsisBandCache cache;  // thermosphere parameter cache
 };
 
 #endif // !__EARTHATMNRLMSISE00
\ No newline at end of file
@@ -0,0 +1,1212 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// class MsisEvaluator
+// The model functions below follow gtd7, gts7, globe7 and glob7s of
+// nrlmsise-00.c. State that the reference code passes between these
+// functions in file-scope variables is kept in a per-point Local
+// structure instead.
+// ======================================================================
+
+#include "MsisEvaluator.h"
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+// model parameters (nrlmsise-00_data.c)
+extern "C" {
+	extern double pt[150];
+	extern double pd[9][150];
+	extern double ps[150];
+	extern double pdl[2][25];
+	extern double ptl[4][100];
+	extern double pma[10][100];
+	extern double ptm[50];
+	extern double pdm[8][10];
+	extern double pavgm[10];
+}
+
+static const double dgtr = 1.74533E-2;
+static const double dr = 1.72142E-2;
+static const double hr = 0.2618;
+static const double sr = 7.2722E-5;
+static const double rgas = 831.4;
+
+struct MsisEvaluator::Local {
+	double lat, lng;          // geodetic latitude and longitude [deg]
+	double gsurf, re;         // surface gravity and effective radius (PARMB)
+	double plg[4][9];         // associated Legendre polynomials of latitude
+	double ctloc, stloc, c2tloc, s2tloc, c3tloc, s3tloc; // local time harmonics
+	double clng, slng, c2lng, s2lng; // longitude harmonics
+	double apdf, apt0;        // magnetic activity of the last globe7 evaluation, used by glob7s
+	double dm28;              // mixed N2 density (gts7 -> gtd7)
+	double tn1[5], tgn1[2];   // temperature nodes and gradients (MESO7)
+	double tn2[4], tgn2[2];
+	double tn3[5], tgn3[2];
+};
+
+// ----------------------------------------------------------------------
+
+MsisEvaluator::MsisEvaluator (const int *switches)
+{
+	for (int i = 0; i < 24; i++) {
+		int s = (switches ? switches[i] : i ? 1 : 0);
+		if (i != 9) {
+			sw[i] = (s == 1 ? 1 : 0);
+			swc[i] = (s > 0 ? 1 : 0);
+		} else
+			sw[i] = swc[i] = s;
+	}
+
+	// phase offsets of the local time and longitude terms of the upper
+	// atmosphere parameter sets, so that globe7 can use the harmonics of
+	// the evaluation point
+	Globe *g[11] = {&gpt, &gps};
+	const double *p[11] = {pt, ps};
+	for (int i = 0; i < 9; i++)
+		g[i+2] = gpd+i, p[i+2] = pd[i];
+	for (int i = 0; i < 11; i++) {
+		memset (g[i], 0, sizeof(Globe));
+		g[i]->p = p[i];
+		g[i]->c124 = cos (hr*p[i][124]), g[i]->s124 = sin (hr*p[i][124]);
+		g[i]->c131 = cos (hr*p[i][131]), g[i]->s131 = sin (hr*p[i][131]);
+		g[i]->c63  = cos (dgtr*p[i][63]),  g[i]->s63  = sin (dgtr*p[i][63]);
+		g[i]->c97  = cos (dgtr*p[i][97]),  g[i]->s97  = sin (dgtr*p[i][97]);
+		g[i]->c118 = cos (dgtr*p[i][118]), g[i]->s118 = sin (dgtr*p[i][118]);
+		g[i]->c136 = cos (dgtr*p[i][136]), g[i]->s136 = sin (dgtr*p[i][136]);
+	}
+	for (int i = 0; i < 4; i++) {
+		memset (gptl+i, 0, sizeof(Globe));
+		gptl[i].p = ptl[i];
+	}
+	for (int i = 0; i < 10; i++) {
+		memset (gpma+i, 0, sizeof(Globe));
+		gpma[i].p = pma[i];
+	}
+
+	memset (&apa, 0, sizeof(ap_array));
+	epochid = 0;
+	doy = -1;
+	sec = f107A = f107 = ap = dfa = 0.0;
+	SetEpoch (172, 29000.0, 150.0, 150.0, 4.0);
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::SetEpoch (int _doy, double _sec, double _f107A, double _f107, double _ap, const ap_array *ap_a)
+{
+	bool season = (_doy != doy || _f107A != f107A || _f107 != f107 || _ap != ap ||
+		(sw[9] == -1 && ap_a && memcmp (ap_a, &apa, sizeof(ap_array))));
+	bool ut = (season || _sec != sec);
+	doy = _doy;
+	sec = _sec;
+	f107A = _f107A;
+	f107 = _f107;
+	ap = _ap;
+	if (season) {
+		if (ap_a) apa = *ap_a;
+		SetSeason ();
+		epochid++;
+	}
+	if (ut) SetUT ();
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::SetSeason ()
+{
+	double df = f107 - f107A;
+	double apd = ap - 4.0;
+	dfa = f107A - 150.0;
+
+	auto season = [this](Globe &g) {
+		const double *p = g.p;
+		g.cd32 = cos (dr*(doy-p[31]));
+		g.cd18 = cos (2.0*dr*(doy-p[17]));
+		g.cd14 = cos (dr*(doy-p[13]));
+		g.cd39 = cos (2.0*dr*(doy-p[38]));
+	};
+
+	Globe *g[11] = {&gpt, &gps};
+	for (int i = 0; i < 9; i++) g[i+2] = gpd+i;
+	for (int i = 0; i < 11; i++) {
+		const double *p = g[i]->p;
+		season (*g[i]);
+		// F10.7 effect
+		g[i]->t0 = p[19]*df*(1.0+p[59]*dfa) + p[20]*df*df + p[21]*dfa + p[29]*dfa*dfa;
+		g[i]->f1 = 1.0 + (p[47]*dfa + p[19]*df + p[20]*df*df)*swc[1];
+		g[i]->f2 = 1.0 + (p[49]*dfa + p[19]*df + p[20]*df*df)*swc[1];
+		// daily ap
+		double p44 = (p[43] < 0 ? 1.0E-5 : p[43]), p45 = p[44];
+		g[i]->apdf = apd + (p45-1.0)*(apd + (exp(-p44*apd) - 1.0)/p44);
+	}
+
+	Globe *gl[14];
+	for (int i = 0; i < 4; i++) gl[i] = gptl+i;
+	for (int i = 0; i < 10; i++) gl[i+4] = gpma+i;
+	for (int i = 0; i < 14; i++) {
+		const double *p = gl[i]->p;
+		season (*gl[i]);
+		gl[i]->lng0 = p[80]*swc[5]*cos(dr*(doy-p[81])) + p[85]*swc[6]*cos(2.0*dr*(doy-p[86]));
+		gl[i]->lng1 = p[83]*swc[3]*cos(dr*(doy-p[84])) + p[87]*swc[4]*cos(2.0*dr*(doy-p[88]));
+	}
+
+	cdzhf = cos (dr*(doy-pt[13]));
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::SetUT ()
+{
+	Globe *g[11] = {&gpt, &gps};
+	for (int i = 0; i < 9; i++) g[i+2] = gpd+i;
+	for (int i = 0; i < 11; i++) {
+		const double *p = g[i]->p;
+		g[i]->ut71 = cos (sr*(sec-p[71]));
+		g[i]->ut58 = cos (sr*(sec-p[58]));
+		g[i]->ut75 = cos (sr*(sec-p[75]));
+		double a = sr*(sec-p[79]);
+		g[i]->cut79 = cos (a), g[i]->sut79 = sin (a);
+	}
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::SetLocal (const Point &pt, Local &L) const
+{
+	L.lat = pt.lat;
+	L.lng = pt.lng;
+
+	// latitude variation of gravity (none for sw[2]=0)
+	double xlat = (sw[2] == 0 ? 45.0 : pt.lat);
+	double c2 = cos (2.0*dgtr*xlat);
+	L.gsurf = 980.616 * (1.0 - 0.0026373 * c2);
+	L.re = 2.0 * L.gsurf / (3.085462E-6 + 2.27E-9 * c2) * 1.0E-5;
+
+	// Legendre polynomials
+	double (*plg)[9] = L.plg;
+	double c = sin (pt.lat*dgtr);
+	double s = cos (pt.lat*dgtr);
+	double c4, s2;
+	c2 = c*c;
+	c4 = c2*c2;
+	s2 = s*s;
+	plg[0][1] = c;
+	plg[0][2] = 0.5*(3.0*c2 -1.0);
+	plg[0][3] = 0.5*(5.0*c*c2-3.0*c);
+	plg[0][4] = (35.0*c4 - 30.0*c2 + 3.0)/8.0;
+	plg[0][5] = (63.0*c2*c2*c - 70.0*c2*c + 15.0*c)/8.0;
+	plg[0][6] = (11.0*c*plg[0][5] - 5.0*plg[0][4])/6.0;
+	plg[1][1] = s;
+	plg[1][2] = 3.0*c*s;
+	plg[1][3] = 1.5*(5.0*c2-1.0)*s;
+	plg[1][4] = 2.5*(7.0*c2*c-3.0*c)*s;
+	plg[1][5] = 1.875*(21.0*c4 - 14.0*c2 +1.0)*s;
+	plg[1][6] = (11.0*c*plg[1][5]-6.0*plg[1][4])/5.0;
+	plg[2][2] = 3.0*s2;
+	plg[2][3] = 15.0*s2*c;
+	plg[2][4] = 7.5*(7.0*c2 -1.0)*s2;
+	plg[2][5] = 3.0*c*plg[2][4]-2.0*plg[2][3];
+	plg[2][6] = (11.0*c*plg[2][5]-7.0*plg[2][4])/4.0;
+	plg[2][7] = (13.0*c*plg[2][6]-8.0*plg[2][5])/5.0;
+	plg[3][3] = 15.0*s2*s;
+	plg[3][4] = 105.0*s2*s*c;
+	plg[3][5] = (9.0*c*plg[3][4]-7.*plg[3][3])/2.0;
+	plg[3][6] = (11.0*c*plg[3][5]-8.*plg[3][4])/3.0;
+
+	// local time and longitude harmonics
+	L.stloc = sin (hr*pt.lst);
+	L.ctloc = cos (hr*pt.lst);
+	L.s2tloc = 2.0*L.stloc*L.ctloc;
+	L.c2tloc = L.ctloc*L.ctloc - L.stloc*L.stloc;
+	L.s3tloc = L.stloc*(3.0 - 4.0*L.stloc*L.stloc);
+	L.c3tloc = L.ctloc*(4.0*L.ctloc*L.ctloc - 3.0);
+	L.slng = sin (dgtr*pt.lng);
+	L.clng = cos (dgtr*pt.lng);
+	L.s2lng = 2.0*L.slng*L.clng;
+	L.c2lng = L.clng*L.clng - L.slng*L.slng;
+
+	L.apdf = L.apt0 = 0.0;
+	L.dm28 = 0.0;
+}
+
+// ----------------------------------------------------------------------
+// 3hr magnetic activity functions (Eq. A24a-d)
+
+static inline double g0 (double a, const double *p, double p24)
+{
+	return (a - 4.0 + (p[25] - 1.0) * (a - 4.0 + (exp(-p24 * (a - 4.0)) - 1.0) / p24));
+}
+
+static inline double sumex (double ex)
+{
+	return (1.0 + (1.0 - pow(ex,19.0)) / (1.0 - ex) * pow(ex,0.5));
+}
+
+static double sg0 (double ex, const double *p, const double *ap)
+{
+	double p24 = std::max (p[24], 1.0E-4);
+	return (g0(ap[1],p,p24) + (g0(ap[2],p,p24)*ex + g0(ap[3],p,p24)*ex*ex +
+		g0(ap[4],p,p24)*pow(ex,3.0) + (g0(ap[5],p,p24)*pow(ex,4.0) +
+		g0(ap[6],p,p24)*pow(ex,12.0))*(1.0-pow(ex,8.0))/(1.0-ex)))/sumex(ex);
+}
+
+// ----------------------------------------------------------------------
+
+double MsisEvaluator::Globe7 (const Globe &g, Local &L) const
+{
+	// G(L) function, upper thermosphere parameters
+	const double *p = g.p;
+	const double (*plg)[9] = L.plg;
+	double t[14] = {0};
+
+	// F10.7 effect
+	t[0] = g.t0;
+
+	// time independent
+	t[1] = (p[1]*plg[0][2] + p[2]*plg[0][4] + p[22]*plg[0][6]) +
+		(p[14]*plg[0][2])*dfa*swc[1] + p[26]*plg[0][1];
+
+	// symmetrical annual
+	t[2] = p[18]*g.cd32;
+
+	// symmetrical semiannual
+	t[3] = (p[15]+p[16]*plg[0][2])*g.cd18;
+
+	// asymmetrical annual
+	t[4] = g.f1*(p[9]*plg[0][1]+p[10]*plg[0][3])*g.cd14;
+
+	// asymmetrical semiannual
+	t[5] = p[37]*plg[0][1]*g.cd39;
+
+	// diurnal
+	if (sw[7]) {
+		double t71 = (p[11]*plg[1][2])*g.cd14*swc[5];
+		double t72 = (p[12]*plg[1][2])*g.cd14*swc[5];
+		t[6] = g.f2*((p[3]*plg[1][1] + p[4]*plg[1][3] + p[27]*plg[1][5] + t71)*L.ctloc +
+			(p[6]*plg[1][1] + p[7]*plg[1][3] + p[28]*plg[1][5] + t72)*L.stloc);
+	}
+
+	// semidiurnal
+	if (sw[8]) {
+		double t81 = (p[23]*plg[2][3]+p[35]*plg[2][5])*g.cd14*swc[5];
+		double t82 = (p[33]*plg[2][3]+p[36]*plg[2][5])*g.cd14*swc[5];
+		t[7] = g.f2*((p[5]*plg[2][2] + p[41]*plg[2][4] + t81)*L.c2tloc +
+			(p[8]*plg[2][2] + p[42]*plg[2][4] + t82)*L.s2tloc);
+	}
+
+	// terdiurnal
+	if (sw[14]) {
+		t[13] = g.f2*((p[39]*plg[3][3] + (p[93]*plg[3][4]+p[46]*plg[3][6])*g.cd14*swc[5])*L.s3tloc +
+			(p[40]*plg[3][3] + (p[94]*plg[3][4]+p[48]*plg[3][6])*g.cd14*swc[5])*L.c3tloc);
+	}
+
+	// magnetic activity
+	if (sw[9] == -1) {
+		// 3hr ap
+		if (p[51] != 0) {
+			double exp1 = exp (-10800.0*fabs(p[51])/(1.0+p[138]*(45.0-fabs(L.lat))));
+			if (exp1 > 0.99999) exp1 = 0.99999;
+			L.apt0 = sg0 (exp1, p, apa.a);
+			t[8] = L.apt0*(p[50]+p[96]*plg[0][2]+p[54]*plg[0][4] +
+				(p[125]*plg[0][1]+p[126]*plg[0][3]+p[127]*plg[0][5])*g.cd14*swc[5] +
+				(p[128]*plg[1][1]+p[129]*plg[1][3]+p[130]*plg[1][5])*swc[7] *
+				(L.ctloc*g.c131 + L.stloc*g.s131));
+		}
+	} else {
+		// daily ap
+		L.apdf = g.apdf;
+		if (sw[9]) {
+			t[8] = g.apdf*(p[32]+p[45]*plg[0][2]+p[34]*plg[0][4] +
+				(p[100]*plg[0][1]+p[101]*plg[0][3]+p[102]*plg[0][5])*g.cd14*swc[5] +
+				(p[121]*plg[1][1]+p[122]*plg[1][3]+p[123]*plg[1][5])*swc[7] *
+				(L.ctloc*g.c124 + L.stloc*g.s124));
+		}
+	}
+
+	if (sw[10] && L.lng > -1000.0) {
+
+		// longitudinal
+		if (sw[11]) {
+			t[10] = (1.0 + p[80]*dfa*swc[1]) *
+				((p[64]*plg[1][2]+p[65]*plg[1][4]+p[66]*plg[1][6] +
+				p[103]*plg[1][1]+p[104]*plg[1][3]+p[105]*plg[1][5] +
+				swc[5]*(p[109]*plg[1][1]+p[110]*plg[1][3]+p[111]*plg[1][5])*g.cd14)*L.clng +
+				(p[90]*plg[1][2]+p[91]*plg[1][4]+p[92]*plg[1][6] +
+				p[106]*plg[1][1]+p[107]*plg[1][3]+p[108]*plg[1][5] +
+				swc[5]*(p[112]*plg[1][1]+p[113]*plg[1][3]+p[114]*plg[1][5])*g.cd14)*L.slng);
+		}
+
+		// ut and mixed ut, longitude
+		if (sw[12]) {
+			t[11] = (1.0+p[95]*plg[0][1])*(1.0+p[81]*dfa*swc[1]) *
+				(1.0+p[119]*plg[0][1]*swc[5]*g.cd14) *
+				((p[68]*plg[0][1]+p[69]*plg[0][3]+p[70]*plg[0][5])*g.ut71);
+			t[11] += swc[11]*(p[76]*plg[2][3]+p[77]*plg[2][5]+p[78]*plg[2][7]) *
+				(g.cut79*L.c2lng - g.sut79*L.s2lng)*(1.0+p[137]*dfa*swc[1]);
+		}
+
+		// ut, longitude magnetic activity
+		if (sw[13]) {
+			if (sw[9] == -1) {
+				if (p[51]) {
+					t[12] = L.apt0*swc[11]*(1.+p[132]*plg[0][1]) *
+						((p[52]*plg[1][2]+p[98]*plg[1][4]+p[67]*plg[1][6]) *
+						(L.clng*g.c97 + L.slng*g.s97)) +
+						L.apt0*swc[11]*swc[5]*(p[133]*plg[1][1]+p[134]*plg[1][3]+p[135]*plg[1][5]) *
+						g.cd14*(L.clng*g.c136 + L.slng*g.s136) +
+						L.apt0*swc[12]*(p[55]*plg[0][1]+p[56]*plg[0][3]+p[57]*plg[0][5])*g.ut58;
+				}
+			} else {
+				t[12] = g.apdf*swc[11]*(1.0+p[120]*plg[0][1]) *
+					((p[60]*plg[1][2]+p[61]*plg[1][4]+p[62]*plg[1][6]) *
+					(L.clng*g.c63 + L.slng*g.s63)) +
+					g.apdf*swc[11]*swc[5]*(p[115]*plg[1][1]+p[116]*plg[1][3]+p[117]*plg[1][5]) *
+					g.cd14*(L.clng*g.c118 + L.slng*g.s118) +
+					g.apdf*swc[12]*(p[83]*plg[0][1]+p[84]*plg[0][3]+p[85]*plg[0][5])*g.ut75;
+			}
+		}
+	}
+
+	double tinf = p[30];
+	for (int i = 0; i < 14; i++)
+		tinf += fabs(sw[i+1])*t[i];
+	return tinf;
+}
+
+// ----------------------------------------------------------------------
+
+double MsisEvaluator::Glob7s (const Globe &g, const Local &L) const
+{
+	// version of globe for lower atmosphere
+	const double *p = g.p;
+	const double (*plg)[9] = L.plg;
+	double t[14] = {0};
+
+	if (p[99] != 0.0 && p[99] != 2.0)
+		return -1.0; // wrong parameter set
+
+	// t[0] (F10.7 effect) stays zero: the reference code uses a file-scope
+	// dfa here that is never assigned
+
+	// time independent
+	t[1] = p[1]*plg[0][2] + p[2]*plg[0][4] + p[22]*plg[0][6] + p[26]*plg[0][1] + p[14]*plg[0][3] + p[59]*plg[0][5];
+
+	// symmetrical annual
+	t[2] = (p[18]+p[47]*plg[0][2]+p[29]*plg[0][4])*g.cd32;
+
+	// symmetrical semiannual
+	t[3] = (p[15]+p[16]*plg[0][2]+p[30]*plg[0][4])*g.cd18;
+
+	// asymmetrical annual
+	t[4] = (p[9]*plg[0][1]+p[10]*plg[0][3]+p[20]*plg[0][5])*g.cd14;
+
+	// asymmetrical semiannual
+	t[5] = (p[37]*plg[0][1])*g.cd39;
+
+	// diurnal
+	if (sw[7]) {
+		double t71 = p[11]*plg[1][2]*g.cd14*swc[5];
+		double t72 = p[12]*plg[1][2]*g.cd14*swc[5];
+		t[6] = (p[3]*plg[1][1] + p[4]*plg[1][3] + t71)*L.ctloc + (p[6]*plg[1][1] + p[7]*plg[1][3] + t72)*L.stloc;
+	}
+
+	// semidiurnal
+	if (sw[8]) {
+		double t81 = (p[23]*plg[2][3]+p[35]*plg[2][5])*g.cd14*swc[5];
+		double t82 = (p[33]*plg[2][3]+p[36]*plg[2][5])*g.cd14*swc[5];
+		t[7] = (p[5]*plg[2][2] + p[41]*plg[2][4] + t81)*L.c2tloc + (p[8]*plg[2][2] + p[42]*plg[2][4] + t82)*L.s2tloc;
+	}
+
+	// terdiurnal
+	if (sw[14])
+		t[13] = p[39]*plg[3][3]*L.s3tloc + p[40]*plg[3][3]*L.c3tloc;
+
+	// magnetic activity
+	if (sw[9] == 1)
+		t[8] = L.apdf*(p[32] + p[45]*plg[0][2]*swc[2]);
+	else if (sw[9] == -1)
+		t[8] = p[50]*L.apt0 + p[96]*plg[0][2]*L.apt0*swc[2];
+
+	// longitudinal
+	if (!(sw[10] == 0 || sw[11] == 0 || L.lng <= -1000.0)) {
+		t[10] = (1.0 + plg[0][1]*g.lng0 + g.lng1) *
+			((p[64]*plg[1][2]+p[65]*plg[1][4]+p[66]*plg[1][6] +
+			p[74]*plg[1][1]+p[75]*plg[1][3]+p[76]*plg[1][5])*L.clng +
+			(p[90]*plg[1][2]+p[91]*plg[1][4]+p[92]*plg[1][6] +
+			p[77]*plg[1][1]+p[78]*plg[1][3]+p[79]*plg[1][5])*L.slng);
+	}
+
+	double tt = 0.0;
+	for (int i = 0; i < 14; i++)
+		tt += fabs(sw[i+1])*t[i];
+	return tt;
+}
+
+// ----------------------------------------------------------------------
+// Profile functions (see nrlmsise-00.c)
+
+static double ccor (double alt, double r, double h1, double zh)
+{
+	// chemistry/dissociation correction
+	double e = (alt - zh) / h1;
+	if (e > 70) return 1.0;
+	if (e < -70) return exp(r);
+	return exp (r / (1.0 + exp(e)));
+}
+
+static double ccor2 (double alt, double r, double h1, double zh, double h2)
+{
+	double e1 = (alt - zh) / h1;
+	double e2 = (alt - zh) / h2;
+	if ((e1 > 70) || (e2 > 70)) return 1.0;
+	if ((e1 < -70) && (e2 < -70)) return exp(r);
+	return exp (r / (1.0 + 0.5 * (exp(e1) + exp(e2))));
+}
+
+static double dnet (double dd, double dm, double zhm, double xmm, double xm)
+{
+	// turbopause correction: combined density of diffusive density dd and
+	// full mixed density dm
+	double a = zhm / (xmm-xm);
+	if (!((dm > 0) && (dd > 0))) {
+		if ((dd == 0) && (dm == 0)) dd = 1;
+		if (dm == 0) return dd;
+		if (dd == 0) return dm;
+	}
+	double ylog = a * log(dm/dd);
+	if (ylog < -10) return dd;
+	if (ylog > 10) return dm;
+	return dd*pow((1.0 + exp(ylog)), (1.0/a));
+}
+
+static void splini (const double *xa, const double *ya, const double *y2a, int n, double x, double *y)
+{
+	// integrate cubic spline function from xa[0] to x
+	double yi = 0;
+	int klo = 0, khi = 1;
+	while ((x > xa[klo]) && (khi < n)) {
+		double xx = x;
+		if (khi < n-1 && x >= xa[khi])
+			xx = xa[khi];
+		double h = xa[khi] - xa[klo];
+		double a = (xa[khi] - xx)/h;
+		double b = (xx - xa[klo])/h;
+		double a2 = a*a, b2 = b*b;
+		yi += ((1.0 - a2) * ya[klo] / 2.0 + b2 * ya[khi] / 2.0 + ((-(1.0+a2*a2)/4.0 + a2/2.0) * y2a[klo] + (b2*b2/4.0 - b2/2.0) * y2a[khi]) * h * h / 6.0) * h;
+		klo++, khi++;
+	}
+	*y = yi;
+}
+
+static void splint (const double *xa, const double *ya, const double *y2a, int n, double x, double *y)
+{
+	// cubic spline interpolation
+	int klo = 0, khi = n-1;
+	while (khi-klo > 1) {
+		int k = (khi+klo)/2;
+		if (xa[k] > x) khi = k;
+		else           klo = k;
+	}
+	double h = xa[khi] - xa[klo];
+	double a = (xa[khi] - x)/h;
+	double b = (x - xa[klo])/h;
+	*y = a * ya[klo] + b * ya[khi] + ((a*a*a - a) * y2a[klo] + (b*b*b - b) * y2a[khi]) * h * h/6.0;
+}
+
+static void spline (const double *x, const double *y, int n, double yp1, double ypn, double *y2)
+{
+	// second derivatives of cubic spline interpolation function (n <= 10)
+	double u[10];
+	double sig, p, qn, un;
+	int i, k;
+	if (yp1 > 0.99E30) {
+		y2[0] = 0;
+		u[0] = 0;
+	} else {
+		y2[0] = -0.5;
+		u[0] = (3.0/(x[1]-x[0]))*((y[1]-y[0])/(x[1]-x[0])-yp1);
+	}
+	for (i = 1; i < n-1; i++) {
+		sig = (x[i]-x[i-1])/(x[i+1] - x[i-1]);
+		p = sig * y2[i-1] + 2.0;
+		y2[i] = (sig - 1.0) / p;
+		u[i] = (6.0 * ((y[i+1] - y[i])/(x[i+1] - x[i]) -(y[i] - y[i-1]) / (x[i] - x[i-1]))/(x[i+1] - x[i-1]) - sig * u[i-1])/p;
+	}
+	if (ypn > 0.99E30) {
+		qn = 0;
+		un = 0;
+	} else {
+		qn = 0.5;
+		un = (3.0 / (x[n-1] - x[n-2])) * (ypn - (y[n-1] - y[n-2])/(x[n-1] - x[n-2]));
+	}
+	y2[n-1] = (un - qn * u[n-2]) / (qn * y2[n-2] + 1.0);
+	for (k = n-2; k >= 0; k--)
+		y2[k] = y2[k] * y2[k+1] + u[k];
+}
+
+static inline double zeta (double re, double zz, double zl)
+{
+	return ((zz-zl)*(re+zl)/(re+zz));
+}
+
+// ----------------------------------------------------------------------
+
+double MsisEvaluator::Densm (const Local &L, double alt, double d0, double xm, double *tz, int mn3, const double *zn3,
+	const double *tn3, const double *tgn3, int mn2, const double *zn2, const double *tn2, const double *tgn2) const
+{
+	// temperature and density profiles for the lower atmosphere
+	const double re = L.re;
+	double xs[10], ys[10], y2out[10];
+	double z, z1, z2, t1, t2, zg, zgdif;
+	double yd1, yd2, x, y, yi, expl, gamm, glb, arg;
+	double densm_tmp = d0;
+	int mn, k;
+
+	if (alt > zn2[0])
+		return (xm == 0.0 ? *tz : d0);
+
+	// stratosphere/mesosphere temperature
+	z = (alt > zn2[mn2-1] ? alt : zn2[mn2-1]);
+	mn = mn2;
+	z1 = zn2[0];
+	z2 = zn2[mn-1];
+	t1 = tn2[0];
+	t2 = tn2[mn-1];
+	zg = zeta (re, z, z1);
+	zgdif = zeta (re, z2, z1);
+	for (k = 0; k < mn; k++) {
+		xs[k] = zeta (re, zn2[k], z1)/zgdif;
+		ys[k] = 1.0 / tn2[k];
+	}
+	yd1 = -tgn2[0] / (t1*t1) * zgdif;
+	arg = (re+z2)/(re+z1);
+	yd2 = -tgn2[1] / (t2*t2) * zgdif * (arg*arg);
+	spline (xs, ys, mn, yd1, yd2, y2out);
+	x = zg/zgdif;
+	splint (xs, ys, y2out, mn, x, &y);
+	*tz = 1.0 / y;
+	if (xm != 0.0) {
+		// stratosphere/mesosphere density
+		arg = 1.0 + z1/re;
+		glb = L.gsurf / (arg*arg);
+		gamm = xm * glb * zgdif / rgas;
+		splini (xs, ys, y2out, mn, x, &yi);
+		expl = gamm*yi;
+		if (expl > 50.0) expl = 50.0;
+		densm_tmp = densm_tmp * (t1 / *tz) * exp(-expl);
+	}
+
+	if (alt > zn3[0])
+		return (xm == 0.0 ? *tz : densm_tmp);
+
+	// troposphere/stratosphere temperature
+	z = alt;
+	mn = mn3;
+	z1 = zn3[0];
+	z2 = zn3[mn-1];
+	t1 = tn3[0];
+	t2 = tn3[mn-1];
+	zg = zeta (re, z, z1);
+	zgdif = zeta (re, z2, z1);
+	for (k = 0; k < mn; k++) {
+		xs[k] = zeta (re, zn3[k], z1) / zgdif;
+		ys[k] = 1.0 / tn3[k];
+	}
+	yd1 = -tgn3[0] / (t1*t1) * zgdif;
+	arg = (re+z2)/(re+z1);
+	yd2 = -tgn3[1] / (t2*t2) * zgdif * (arg*arg);
+	spline (xs, ys, mn, yd1, yd2, y2out);
+	x = zg/zgdif;
+	splint (xs, ys, y2out, mn, x, &y);
+	*tz = 1.0 / y;
+	if (xm != 0.0) {
+		// troposphere/stratosphere density
+		arg = 1.0 + z1/re;
+		glb = L.gsurf / (arg*arg);
+		gamm = xm * glb * zgdif / rgas;
+		splini (xs, ys, y2out, mn, x, &yi);
+		expl = gamm*yi;
+		if (expl > 50.0) expl = 50.0;
+		densm_tmp = densm_tmp * (t1 / *tz) * exp(-expl);
+	}
+	return (xm == 0.0 ? *tz : densm_tmp);
+}
+
+// ----------------------------------------------------------------------
+
+double MsisEvaluator::Densu (const Local &L, double alt, double dlb, double tinf, double tlb, double xm, double alpha,
+	double *tz, double zlb, double s2, int mn1, const double *zn1, double *tn1, double *tgn1) const
+{
+	// temperature and density profiles for the thermosphere
+	const double re = L.re;
+	double yd2, yd1, x = 0, y;
+	double za, z, zg2, tt, ta;
+	double dta, z1 = 0, z2, t1 = 0, t2, zg, zgdif = 0;
+	double glb, expl, yi, densa, gamma, gamm, arg;
+	double xs[5], ys[5], y2out[5];
+	double densu_temp;
+	int mn = 0, k;
+
+	// joining altitudes of Bates and spline
+	za = zn1[0];
+	z = (alt > za ? alt : za);
+
+	// geopotential altitude difference from zlb
+	zg2 = zeta (re, z, zlb);
+
+	// Bates temperature
+	tt = tinf - (tinf - tlb) * exp(-s2*zg2);
+	ta = tt;
+	*tz = tt;
+	densu_temp = *tz;
+
+	if (alt < za) {
+		// temperature below za; temperature gradient at za from Bates profile
+		arg = (re+zlb)/(re+za);
+		dta = (tinf - ta) * s2 * (arg*arg);
+		tgn1[0] = dta;
+		tn1[0] = ta;
+		z = (alt > zn1[mn1-1] ? alt : zn1[mn1-1]);
+		mn = mn1;
+		z1 = zn1[0];
+		z2 = zn1[mn-1];
+		t1 = tn1[0];
+		t2 = tn1[mn-1];
+		zg = zeta (re, z, z1);
+		zgdif = zeta (re, z2, z1);
+		for (k = 0; k < mn; k++) {
+			xs[k] = zeta (re, zn1[k], z1) / zgdif;
+			ys[k] = 1.0 / tn1[k];
+		}
+		yd1 = -tgn1[0] / (t1*t1) * zgdif;
+		arg = (re+z2)/(re+z1);
+		yd2 = -tgn1[1] / (t2*t2) * zgdif * (arg*arg);
+		spline (xs, ys, mn, yd1, yd2, y2out);
+		x = zg / zgdif;
+		splint (xs, ys, y2out, mn, x, &y);
+		*tz = 1.0 / y;
+		densu_temp = *tz;
+	}
+	if (xm == 0)
+		return densu_temp;
+
+	// density above za
+	arg = 1.0 + zlb/re;
+	glb = L.gsurf / (arg*arg);
+	gamma = xm * glb / (s2 * rgas * tinf);
+	expl = exp(-s2 * gamma * zg2);
+	if (expl > 50.0 || tt <= 0) expl = 50.0;
+	densa = dlb * pow((tlb/tt), (1.0+alpha+gamma)) * expl;
+	densu_temp = densa;
+	if (alt >= za)
+		return densu_temp;
+
+	// density below za
+	arg = 1.0 + z1/re;
+	glb = L.gsurf / (arg*arg);
+	gamm = xm * glb * zgdif / rgas;
+	splini (xs, ys, y2out, mn, x, &yi);
+	expl = gamm * yi;
+	if (expl > 50.0 || *tz <= 0) expl = 50.0;
+	densu_temp = densu_temp * pow ((t1 / *tz), (1.0 + alpha)) * exp(-expl);
+	return densu_temp;
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::Gts7 (Local &L, double alt, nrlmsise_output *output) const
+{
+	// thermospheric portion of NRLMSISE-00 (alt > 72.5 km)
+	static const double alpha[9] = {-0.38, 0.0, 0.0, 0.0, 0.17, 0.0, -0.38, 0.0, 0.0};
+	static const double altl[8] = {200.0, 300.0, 160.0, 250.0, 240.0, 450.0, 320.0, 450.0};
+	const int mn1 = 5;
+	double zn1[5] = {120.0, 110.0, 100.0, 90.0, 72.5};
+	double *tn1 = L.tn1, *tgn1 = L.tgn1;
+	double *t1 = &output->t[1];
+	double za, z, tinf, g0, tlb, s, arg, rl, tz, dd;
+	double g28, g4, g16, g32, g40, g1, g14, g16h;
+	double db01, db04, db14, db16, db28, db32, db40, db16h;
+	double b28, b04, b16, b32, b40, b01, b14;
+	double dm04, dm16, dm32, dm40, dm01, dm14;
+	double zhf, xmm, zh28, zhm28, xmd, tho, zsht, zmho, zsho;
+	int i;
+
+	za = pdl[1][15];
+	zn1[0] = za;
+	for (i = 0; i < 9; i++)
+		output->d[i] = 0;
+
+	// tinf variations not important below za or zn1[0]
+	if (alt > zn1[0])
+		tinf = ptm[0]*pt[0] * (1.0+sw[16]*Globe7 (gpt, L));
+	else
+		tinf = ptm[0]*pt[0];
+	output->t[0] = tinf;
+
+	// gradient variations not important below zn1[4]
+	if (alt > zn1[4])
+		g0 = ptm[3]*ps[0] * (1.0+sw[19]*Globe7 (gps, L));
+	else
+		g0 = ptm[3]*ps[0];
+	tlb = ptm[1] * (1.0 + sw[17]*Globe7 (gpd[3], L))*pd[3][0];
+	s = g0 / (tinf - tlb);
+
+	// lower thermosphere temp variations not significant for density above 300 km
+	arg = ptm[4]*ptl[3][0];
+	if (alt < 300.0) {
+		tn1[1] = ptm[6]*ptl[0][0]/(1.0-sw[18]*Glob7s (gptl[0], L));
+		tn1[2] = ptm[2]*ptl[1][0]/(1.0-sw[18]*Glob7s (gptl[1], L));
+		tn1[3] = ptm[7]*ptl[2][0]/(1.0-sw[18]*Glob7s (gptl[2], L));
+		tn1[4] = ptm[4]*ptl[3][0]/(1.0-sw[18]*sw[20]*Glob7s (gptl[3], L));
+		tgn1[1] = ptm[8]*pma[8][0]*(1.0+sw[18]*sw[20]*Glob7s (gpma[8], L))*tn1[4]*tn1[4]/(arg*arg);
+	} else {
+		tn1[1] = ptm[6]*ptl[0][0];
+		tn1[2] = ptm[2]*ptl[1][0];
+		tn1[3] = ptm[7]*ptl[2][0];
+		tn1[4] = ptm[4]*ptl[3][0];
+		tgn1[1] = ptm[8]*pma[8][0]*tn1[4]*tn1[4]/(arg*arg);
+	}
+
+	// N2 variation factor at zlb
+	g28 = sw[21]*Globe7 (gpd[2], L);
+
+	// variation of turbopause height
+	zhf = pdl[1][24]*(1.0+sw[5]*pdl[0][24]*L.plg[0][1]*cdzhf);
+	xmm = pdm[2][4];
+	z = alt;
+
+	// N2 density
+	db28 = pdm[2][0]*exp(g28)*pd[2][0];
+	output->d[2] = Densu (L, z, db28, tinf, tlb, 28.0, alpha[2], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	zh28 = pdm[2][2]*zhf;
+	zhm28 = pdm[2][3]*pdl[1][5];
+	xmd = 28.0-xmm;
+	b28 = Densu (L, zh28, db28, tinf, tlb, xmd, (alpha[2]-1.0), &tz, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (z <= altl[2]) {
+		// mixed density (also needed by gtd7 below zn2[0])
+		L.dm28 = Densu (L, z, b28, tinf, tlb, xmm, alpha[2], &tz, ptm[5], s, mn1, zn1, tn1, tgn1);
+		if (sw[15])
+			output->d[2] = dnet (output->d[2], L.dm28, zhm28, xmm, 28.0);
+	}
+
+	// He density
+	g4 = sw[21]*Globe7 (gpd[0], L);
+	db04 = pdm[0][0]*exp(g4)*pd[0][0];
+	output->d[0] = Densu (L, z, db04, tinf, tlb, 4., alpha[0], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[15] && z < altl[0]) {
+		b04 = Densu (L, pdm[0][2], db04, tinf, tlb, 4.-xmm, alpha[0]-1., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		dm04 = Densu (L, z, b04, tinf, tlb, xmm, 0., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		output->d[0] = dnet (output->d[0], dm04, zhm28, xmm, 4.);
+		rl = log(b28*pdm[0][1]/b04);
+		output->d[0] *= ccor (z, rl, pdm[0][5]*pdl[1][1], pdm[0][4]*pdl[1][0]);
+	}
+
+	// O density
+	g16 = sw[21]*Globe7 (gpd[1], L);
+	db16 = pdm[1][0]*exp(g16)*pd[1][0];
+	output->d[1] = Densu (L, z, db16, tinf, tlb, 16., alpha[1], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[15] && z <= altl[1]) {
+		b16 = Densu (L, pdm[1][2], db16, tinf, tlb, 16.0-xmm, (alpha[1]-1.0), t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		dm16 = Densu (L, z, b16, tinf, tlb, xmm, 0., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		output->d[1] = dnet (output->d[1], dm16, zhm28, xmm, 16.);
+		rl = pdm[1][1]*pdl[1][16]*(1.0+sw[1]*pdl[0][23]*(f107A-150.0));
+		output->d[1] *= ccor2 (z, rl, pdm[1][5]*pdl[1][3], pdm[1][4]*pdl[1][2], pdm[1][5]*pdl[1][4]);
+		// chemistry correction
+		output->d[1] *= ccor (z, pdm[1][3]*pdl[1][14], pdm[1][7]*pdl[1][13], pdm[1][6]*pdl[1][12]);
+	}
+
+	// O2 density
+	g32 = sw[21]*Globe7 (gpd[4], L);
+	db32 = pdm[3][0]*exp(g32)*pd[4][0];
+	output->d[3] = Densu (L, z, db32, tinf, tlb, 32., alpha[3], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[15]) {
+		if (z <= altl[3]) {
+			b32 = Densu (L, pdm[3][2], db32, tinf, tlb, 32.-xmm, alpha[3]-1., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+			dm32 = Densu (L, z, b32, tinf, tlb, xmm, 0., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+			output->d[3] = dnet (output->d[3], dm32, zhm28, xmm, 32.);
+			rl = log(b28*pdm[3][1]/b32);
+			output->d[3] *= ccor (z, rl, pdm[3][5]*pdl[1][7], pdm[3][4]*pdl[1][6]);
+		}
+		// correction for general departure from diffusive equilibrium above zlb
+		rl = pdm[3][3]*pdl[1][23]*(1.+sw[1]*pdl[0][23]*(f107A-150.));
+		output->d[3] *= ccor2 (z, rl, pdm[3][7]*pdl[1][22], pdm[3][6]*pdl[1][21], pdm[3][7]*pdl[0][22]);
+	}
+
+	// Ar density
+	g40 = sw[21]*Globe7 (gpd[5], L);
+	db40 = pdm[4][0]*exp(g40)*pd[5][0];
+	output->d[4] = Densu (L, z, db40, tinf, tlb, 40., alpha[4], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[15] && z <= altl[4]) {
+		b40 = Densu (L, pdm[4][2], db40, tinf, tlb, 40.-xmm, alpha[4]-1., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		dm40 = Densu (L, z, b40, tinf, tlb, xmm, 0., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		output->d[4] = dnet (output->d[4], dm40, zhm28, xmm, 40.);
+		rl = log(b28*pdm[4][1]/b40);
+		output->d[4] *= ccor (z, rl, pdm[4][5]*pdl[1][9], pdm[4][4]*pdl[1][8]);
+	}
+
+	// H density
+	g1 = sw[21]*Globe7 (gpd[6], L);
+	db01 = pdm[5][0]*exp(g1)*pd[6][0];
+	output->d[6] = Densu (L, z, db01, tinf, tlb, 1., alpha[6], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[15] && z <= altl[6]) {
+		b01 = Densu (L, pdm[5][2], db01, tinf, tlb, 1.-xmm, alpha[6]-1., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		dm01 = Densu (L, z, b01, tinf, tlb, xmm, 0., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		output->d[6] = dnet (output->d[6], dm01, zhm28, xmm, 1.);
+		rl = log(b28*pdm[5][1]*fabs(pdl[1][17])/b01);
+		output->d[6] *= ccor (z, rl, pdm[5][5]*pdl[1][11], pdm[5][4]*pdl[1][10]);
+		// chemistry correction
+		output->d[6] *= ccor (z, pdm[5][3]*pdl[1][20], pdm[5][7]*pdl[1][19], pdm[5][6]*pdl[1][18]);
+	}
+
+	// atomic N density
+	g14 = sw[21]*Globe7 (gpd[7], L);
+	db14 = pdm[6][0]*exp(g14)*pd[7][0];
+	output->d[7] = Densu (L, z, db14, tinf, tlb, 14., alpha[7], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[15] && z <= altl[7]) {
+		b14 = Densu (L, pdm[6][2], db14, tinf, tlb, 14.-xmm, alpha[7]-1., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		dm14 = Densu (L, z, b14, tinf, tlb, xmm, 0., t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+		output->d[7] = dnet (output->d[7], dm14, zhm28, xmm, 14.);
+		rl = log(b28*pdm[6][1]*fabs(pdl[0][2])/b14);
+		output->d[7] *= ccor (z, rl, pdm[6][5]*pdl[0][1], pdm[6][4]*pdl[0][0]);
+		// chemistry correction
+		output->d[7] *= ccor (z, pdm[6][3]*pdl[0][5], pdm[6][7]*pdl[0][4], pdm[6][6]*pdl[0][3]);
+	}
+
+	// anomalous O density
+	g16h = sw[21]*Globe7 (gpd[8], L);
+	db16h = pdm[7][0]*exp(g16h)*pd[8][0];
+	tho = pdm[7][9]*pdl[0][6];
+	dd = Densu (L, z, db16h, tho, tho, 16., alpha[8], t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	zsht = pdm[7][5];
+	zmho = pdm[7][4];
+	arg = 1.0 + zmho/L.re;
+	zsho = rgas * tho / (L.gsurf / (arg*arg) * 16.0);
+	output->d[8] = dd*exp(-zsht/zsho*(exp(-(z-zmho)/zsht)-1.));
+
+	// total mass density
+	output->d[5] = 1.66E-24*(4.0*output->d[0]+16.0*output->d[1]+28.0*output->d[2]+32.0*output->d[3]+40.0*output->d[4]+output->d[6]+14.0*output->d[7]);
+
+	// temperature
+	Densu (L, fabs(alt), 1.0, tinf, tlb, 0.0, 0.0, t1, ptm[5], s, mn1, zn1, tn1, tgn1);
+	if (sw[0]) {
+		for (i = 0; i < 9; i++)
+			output->d[i] *= 1.0E6;
+		output->d[5] /= 1000;
+	}
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::Gtd7 (Local &L, double alt, nrlmsise_output *output) const
+{
+	// neutral atmosphere from the surface to the lower exosphere
+	const int mn3 = 5, mn2 = 4;
+	static const double zn3[5] = {32.5, 20.0, 15.0, 10.0, 0.0};
+	static const double zn2[4] = {72.5, 55.0, 45.0, 32.5};
+	const double zmix = 62.5;
+	double xmm = pdm[2][4];
+	double tz, dmc, dmr, dz28, dm28m;
+	nrlmsise_output soutput;
+	int i;
+
+	// thermosphere/mesosphere (above zn2[0])
+	Gts7 (L, std::max (alt, zn2[0]), &soutput);
+	dm28m = (sw[0] ? L.dm28*1.0E6 : L.dm28);
+	output->t[0] = soutput.t[0];
+	output->t[1] = soutput.t[1];
+	if (alt >= zn2[0]) {
+		for (i = 0; i < 9; i++)
+			output->d[i] = soutput.d[i];
+		return;
+	}
+
+	// lower mesosphere/upper stratosphere (between zn3[0] and zn2[0]):
+	// temperature at nodes and gradients at end nodes
+	L.tgn2[0] = L.tgn1[1];
+	L.tn2[0] = L.tn1[4];
+	L.tn2[1] = pma[0][0]*pavgm[0]/(1.0-sw[20]*Glob7s (gpma[0], L));
+	L.tn2[2] = pma[1][0]*pavgm[1]/(1.0-sw[20]*Glob7s (gpma[1], L));
+	L.tn2[3] = pma[2][0]*pavgm[2]/(1.0-sw[20]*sw[22]*Glob7s (gpma[2], L));
+	L.tgn2[1] = pavgm[8]*pma[9][0]*(1.0+sw[20]*sw[22]*Glob7s (gpma[9], L))*L.tn2[3]*L.tn2[3]/((pma[2][0]*pavgm[2])*(pma[2][0]*pavgm[2]));
+	L.tn3[0] = L.tn2[3];
+
+	if (alt <= zn3[0]) {
+		// lower stratosphere and troposphere (below zn3[0])
+		L.tgn3[0] = L.tgn2[1];
+		L.tn3[1] = pma[3][0]*pavgm[3]/(1.0-sw[22]*Glob7s (gpma[3], L));
+		L.tn3[2] = pma[4][0]*pavgm[4]/(1.0-sw[22]*Glob7s (gpma[4], L));
+		L.tn3[3] = pma[5][0]*pavgm[5]/(1.0-sw[22]*Glob7s (gpma[5], L));
+		L.tn3[4] = pma[6][0]*pavgm[6]/(1.0-sw[22]*Glob7s (gpma[6], L));
+		L.tgn3[1] = pma[7][0]*pavgm[7]*(1.0+sw[22]*Glob7s (gpma[7], L))*L.tn3[4]*L.tn3[4]/((pma[6][0]*pavgm[6])*(pma[6][0]*pavgm[6]));
+	}
+
+	// linear transition to full mixing below zn2[0]
+	dmc = 0;
+	if (alt > zmix)
+		dmc = 1.0 - (zn2[0]-alt)/(zn2[0] - zmix);
+	dz28 = soutput.d[2];
+
+	// N2 density
+	dmr = soutput.d[2] / dm28m - 1.0;
+	output->d[2] = Densm (L, alt, dm28m, xmm, &tz, mn3, zn3, L.tn3, L.tgn3, mn2, zn2, L.tn2, L.tgn2);
+	output->d[2] = output->d[2] * (1.0 + dmr*dmc);
+
+	// He density
+	dmr = soutput.d[0] / (dz28 * pdm[0][1]) - 1.0;
+	output->d[0] = output->d[2] * pdm[0][1] * (1.0 + dmr*dmc);
+
+	// O density
+	output->d[1] = 0;
+	output->d[8] = 0;
+
+	// O2 density
+	dmr = soutput.d[3] / (dz28 * pdm[3][1]) - 1.0;
+	output->d[3] = output->d[2] * pdm[3][1] * (1.0 + dmr*dmc);
+
+	// Ar density
+	dmr = soutput.d[4] / (dz28 * pdm[4][1]) - 1.0;
+	output->d[4] = output->d[2] * pdm[4][1] * (1.0 + dmr*dmc);
+
+	// H and N density
+	output->d[6] = 0;
+	output->d[7] = 0;
+
+	// total mass density
+	output->d[5] = 1.66E-24 * (4.0 * output->d[0] + 16.0 * output->d[1] + 28.0 * output->d[2] + 32.0 * output->d[3] + 40.0 * output->d[4] + output->d[6] + 14.0 * output->d[7]);
+	if (sw[0])
+		output->d[5] = output->d[5]/1000;
+
+	// temperature at altitude
+	Densm (L, alt, 1.0, 0, &tz, mn3, zn3, L.tn3, L.tgn3, mn2, zn2, L.tn2, L.tgn2);
+	output->t[1] = tz;
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::Eval (const Point *pt, nrlmsise_output *out, int n) const
+{
+	Local L;
+	for (int i = 0; i < n; i++) {
+		SetLocal (pt[i], L);
+		Gtd7 (L, pt[i].alt, out+i);
+	}
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::Eval (const Point *pt, Prm *prm, int n) const
+{
+	Local L;
+	nrlmsise_output out;
+	for (int i = 0; i < n; i++) {
+		SetLocal (pt[i], L);
+		Gtd7 (L, pt[i].alt, &out);
+		Convert (out, prm[i]);
+	}
+}
+
+// ----------------------------------------------------------------------
+
+void MsisEvaluator::Convert (const nrlmsise_output &out, Prm &prm)
+{
+	static const double k = 1.38066e-23*1e6; // Boltzmann constant and scale from cm^-3 to m^-3
+	double n = out.d[0]+out.d[1]+out.d[2]+out.d[3]+out.d[4]+out.d[6]+out.d[7]; // total number density [1/cm^3]
+	prm.T = out.t[1];
+	prm.p = n*k*prm.T;
+	prm.rho = out.d[5]*1e3;
+}
+
+
+// ======================================================================
+// class MsisBandCache
+// ======================================================================
+
+const double MsisBandCache::ALTMIN = 120.0;
+const double MsisBandCache::ALTMAX = 2500.0;
+const double MsisBandCache::MAXAGE = 10.0;
+
+static const int NLAT = 180, NLNG = 360; // 1 deg cells
+static const size_t MAXCELL = 4096;      // cell count that triggers pruning
+static const size_t WINDOW = 64;         // miss rate monitoring window
+static const size_t NBYPASS = 1024;      // bypassed queries after a high miss rate
+
+// altitude segments with uniform band width, resolving the density scale
+// height (~10 km at 120 km, ~60 km at 400 km)
+static const struct { double z0, z1, dz; } bandseg[] = {
+	{120.0, 200.0, 1.0}, {200.0, 400.0, 2.5}, {400.0, 1000.0, 5.0}, {1000.0, 2500.0, 10.0}
+};
+
+MsisBandCache::MsisBandCache (const MsisEvaluator *_msis, double _tol)
+{
+	msis = _msis;
+	tol = _tol;
+	epochid = msis->EpochId();
+	memset (&stats, 0, sizeof(Stats));
+	wquery = wmiss = nbypass = 0;
+}
+
+// ----------------------------------------------------------------------
+
+void MsisBandCache::Clear ()
+{
+	node.clear();
+	cell.clear();
+	wquery = wmiss = nbypass = 0;
+}
+
+// ----------------------------------------------------------------------
+
+bool MsisBandCache::Band (double alt, int &k, double &z0, double &dz)
+{
+	int k0 = 0;
+	for (auto &seg : bandseg) {
+		int n = (int)((seg.z1-seg.z0)/seg.dz + 0.5);
+		if (alt >= seg.z0 && alt < seg.z1) {
+			int i = std::min ((int)((alt-seg.z0)/seg.dz), n-1);
+			k = k0+i;
+			z0 = seg.z0 + i*seg.dz;
+			dz = seg.dz;
+			return true;
+		}
+		k0 += n;
+	}
+	return false;
+}
+
+// ----------------------------------------------------------------------
+
+bool MsisBandCache::Eval (double alt, double lat, double lng, MsisEvaluator::Prm &prm)
+{
+	int k;
+	double z0, dz;
+	if (!Band (alt, k, z0, dz)) return false;
+
+	if (msis->EpochId() != epochid) {
+		Clear();
+		epochid = msis->EpochId();
+	}
+	if (nbypass) {
+		nbypass--;
+		stats.bypass++;
+		return false;
+	}
+
+	// cell and interpolation coefficients
+	double u = (lat+90.0), w = fmod (lng+180.0, 360.0);
+	if (w < 0.0) w += 360.0;
+	int i = std::max (0, std::min ((int)u, NLAT-1));
+	int j = std::min ((int)w, NLNG-1);
+	double f = (alt-z0)/dz;
+	u -= i, w -= j;
+
+	MsisEvaluator::Point pt = msis->At (alt, lat, lng);
+	auto it = cell.find (Key (k, i, j));
+	if (it != cell.end() && fabs (msis->Sec() - it->second.t) < MAXAGE) {
+		if (it->second.exact) {
+			msis->Eval (&pt, &prm, 1);
+			stats.exact++;
+		} else {
+			Interpolate (it->second, f, u, w, prm);
+			stats.hit++;
+		}
+	} else {
+		if (it == cell.end()) {
+			if (cell.size() >= MAXCELL) Prune();
+			it = cell.insert (std::make_pair (Key (k, i, j), Cell())).first;
+		}
+		NewCell (it->second, k, z0, dz, i, j, pt, f, u, w, prm);
+		stats.miss++;
+		wmiss++;
+	}
+
+	// bypass the cache for a while if most queries create new cells
+	if (++wquery == WINDOW) {
+		if (wmiss*8 > WINDOW) nbypass = NBYPASS;
+		wquery = wmiss = 0;
+	}
+	return true;
+}
+
+// ----------------------------------------------------------------------
+
+void MsisBandCache::Interpolate (const Cell &c, double f, double u, double w, MsisEvaluator::Prm &prm)
+{
+	double r[3];
+	for (int m = 0; m < 3; m++) {
+		double a0 = c.v[0][m] + w*(c.v[1][m]-c.v[0][m]);
+		double a1 = c.v[2][m] + w*(c.v[3][m]-c.v[2][m]);
+		double b0 = c.v[4][m] + w*(c.v[5][m]-c.v[4][m]);
+		double b1 = c.v[6][m] + w*(c.v[7][m]-c.v[6][m]);
+		double a = a0 + u*(a1-a0);
+		double b = b0 + u*(b1-b0);
+		r[m] = a + f*(b-a);
+	}
+	prm.rho = exp (r[0]);
+	prm.p = exp (r[1]);
+	prm.T = r[2];
+}
+
+// ----------------------------------------------------------------------
+
+void MsisBandCache::NewCell (Cell &c, int k, double z0, double dz, int i, int j, const MsisEvaluator::Point &pt,
+	double f, double u, double w, MsisEvaluator::Prm &prm)
+{
+	// collect the corner nodes, and evaluate the missing or expired ones
+	// together with the query point
+	double t = msis->Sec();
+	MsisEvaluator::Point p[9];
+	MsisEvaluator::Prm res[9];
+	Node *nd[8], *eval[8];
+	int n = 0;
+	for (int m = 0; m < 8; m++) {
+		int a = m >> 2, b = (m >> 1) & 1, jj = (j + (m & 1)) % NLNG;
+		auto r = node.insert (std::make_pair (Key (k+a, i+b, jj), Node()));
+		nd[m] = &r.first->second;
+		if (r.second || fabs (t - nd[m]->t) >= MAXAGE) {
+			p[n] = msis->At (z0 + a*dz, -90.0 + i+b, -180.0 + jj);
+			eval[n++] = nd[m];
+		}
+	}
+	p[n] = pt;
+	msis->Eval (p, res, n+1);
+	for (int m = 0; m < n; m++) {
+		eval[m]->v[0] = log (res[m].rho);
+		eval[m]->v[1] = log (res[m].p);
+		eval[m]->v[2] = res[m].T;
+		eval[m]->t = t;
+	}
+	stats.node += n;
+
+	c.t = t;
+	for (int m = 0; m < 8; m++) {
+		memcpy (c.v[m], nd[m]->v, 3*sizeof(double));
+		if (fabs (t - nd[m]->t) > fabs (t - c.t)) c.t = nd[m]->t;
+	}
+
+	// verify the cell at the query point
+	MsisEvaluator::Prm q;
+	Interpolate (c, f, u, w, q);
+	prm = res[n];
+	double err = std::max (fabs (q.rho/prm.rho - 1.0), std::max (fabs (q.p/prm.p - 1.0), fabs (q.T/prm.T - 1.0)));
+	c.exact = (err > tol);
+}
+
+// ----------------------------------------------------------------------
+
+void MsisBandCache::Prune ()
+{
+	// remove expired cells and nodes, or everything if that isn't enough
+	double t = msis->Sec();
+	for (auto it = cell.begin(); it != cell.end();)
+		if (fabs (t - it->second.t) >= MAXAGE) it = cell.erase (it);
+		else it++;
+	for (auto it = node.begin(); it != node.end();)
+		if (fabs (t - it->second.t) >= MAXAGE) it = node.erase (it);
+		else it++;
+	if (cell.size() >= MAXCELL/2) {
+		node.clear();
+		cell.clear();
+	}
+}
@@ -0,0 +1,167 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// ======================================================================
+// class MsisEvaluator
+// Restructured NRLMSISE-00 model. Produces the results of gtd7 (see
+// nrlmsise-00.c), but separates the terms that depend only on date, UT
+// and solar/geomagnetic indices from those that depend on position.
+// The former are computed once per epoch (SetEpoch), the latter once per
+// point and shared by all parameter sets, instead of being recomputed in
+// each of the ~20 globe7/glob7s calls of a gtd7 evaluation.
+// ======================================================================
+
+#ifndef __MSISEVALUATOR_H
+#define __MSISEVALUATOR_H
+
+#include "nrlmsise-00.h"
+#include <unordered_map>
+#include <stddef.h>
+#include <stdint.h>
+
+class MsisEvaluator {
+public:
+	struct Point {
+		double alt;       // altitude [km]
+		double lat;       // geodetic latitude [deg]
+		double lng;       // geodetic longitude [deg]
+		double lst;       // local apparent solar time [h]
+	};
+
+	struct Prm {
+		double T;         // temperature [K]
+		double p;         // pressure [Pa]
+		double rho;       // mass density [kg/m^3]
+	};
+
+	MsisEvaluator (const int *switches = 0);
+	// switches: the 24 model switches as in nrlmsise_flags. Default:
+	// 0 for switch 0, 1 for all others.
+
+	void SetEpoch (int doy, double sec, double f107A, double f107, double ap, const ap_array *ap_a = 0);
+	// Set day of year, UT [s] and solar/geomagnetic indices for subsequent
+	// evaluations. The seasonal and flux terms are only recomputed if doy
+	// or the indices change; a change of sec only updates the UT terms.
+	// ap_a is only used if switch 9 is -1.
+
+	inline int Doy () const { return doy; }
+	inline double Sec () const { return sec; }
+	inline unsigned int EpochId () const { return epochid; }
+	// EpochId changes whenever doy or the indices change
+
+	inline Point At (double alt, double lat, double lng) const
+	{ Point p = {alt, lat, lng, sec/3600.0 + lng/15.0}; return p; }
+	// Point with local solar time derived from UT and longitude
+
+	void Eval (const Point *pt, nrlmsise_output *out, int n) const;
+	// Evaluate the model at n points (equivalent to n calls to gtd7 with the
+	// current epoch).
+
+	void Eval (const Point *pt, Prm *prm, int n) const;
+	// As above, returning temperature, pressure and mass density in SI units
+
+	static void Convert (const nrlmsise_output &out, Prm &prm);
+	// Temperature, pressure and mass density from model output
+
+private:
+	struct Globe {            // terms of a globe7/glob7s parameter set
+		const double *p;      // parameters
+		double cd14, cd18, cd32, cd39; // seasonal variations
+		double t0, f1, f2;    // F10.7 effect
+		double apdf;          // daily ap effect
+		double ut71, ut58, ut75, cut79, sut79; // UT variations
+		double lng0, lng1;    // seasonal factors of the longitudinal variation (glob7s)
+		double c124, s124, c131, s131; // phase offsets of local time terms
+		double c63, s63, c97, s97, c118, s118, c136, s136; // phase offsets of longitude terms
+	};
+	struct Local;
+
+	void SetSeason ();
+	void SetUT ();
+	void SetLocal (const Point &pt, Local &L) const;
+	double Globe7 (const Globe &g, Local &L) const;
+	double Glob7s (const Globe &g, const Local &L) const;
+	void Gts7 (Local &L, double alt, nrlmsise_output *output) const;
+	void Gtd7 (Local &L, double alt, nrlmsise_output *output) const;
+	double Densu (const Local &L, double alt, double dlb, double tinf, double tlb, double xm, double alpha,
+		double *tz, double zlb, double s2, int mn1, const double *zn1, double *tn1, double *tgn1) const;
+	double Densm (const Local &L, double alt, double d0, double xm, double *tz, int mn3, const double *zn3,
+		const double *tn3, const double *tgn3, int mn2, const double *zn2, const double *tn2, const double *tgn2) const;
+
+	double sw[24], swc[24];   // model switches (see tselec)
+	int doy;                  // day of year
+	double sec;               // UT [s]
+	double f107A, f107, ap;   // solar and geomagnetic indices
+	double dfa;               // f107A-150
+	ap_array apa;             // 3-hourly ap values (switch 9 = -1 only)
+	unsigned int epochid;
+
+	Globe gpt, gps, gpd[9];   // upper atmosphere parameter sets (globe7)
+	Globe gptl[4], gpma[10];  // lower atmosphere parameter sets (glob7s)
+	double cdzhf;             // seasonal factor of the turbopause height
+};
+
+// ======================================================================
+// class MsisBandCache
+// Cache of MSIS parameters for the thermosphere, for vessels in low orbit.
+// Parameters are tabulated on nodes in altitude bands and 1 deg cells in
+// latitude and longitude as they are requested, and interpolated
+// trilinearly (logarithmically for pressure and density). Each cell is
+// verified against the full model at its first query point; cells that
+// exceed the error tolerance are always evaluated exactly. Nodes expire
+// after a few seconds of simulation time, and the cache is bypassed while
+// the miss rate is high (e.g. at high time acceleration).
+// ======================================================================
+
+class MsisBandCache {
+public:
+	MsisBandCache (const MsisEvaluator *msis, double tol = 1e-3);
+	// tol: relative error tolerance of density and pressure, and of temperature
+
+	void Clear ();
+
+	bool Eval (double alt, double lat, double lng, MsisEvaluator::Prm &prm);
+	// Parameters at alt [km], lat, lng [deg] at the current epoch of the
+	// evaluator. Returns false (and leaves prm unchanged) if alt is outside
+	// the cached range or the cache is bypassed.
+
+	struct Stats {
+		size_t hit;       // queries interpolated from the cache
+		size_t miss;      // queries that created a cell
+		size_t exact;     // queries in cells that failed verification
+		size_t bypass;    // queries not served because of a high miss rate
+		size_t node;      // node evaluations
+	};
+	inline const Stats &GetStats () const { return stats; }
+
+	static const double ALTMIN, ALTMAX; // cached altitude range [km]
+	static const double MAXAGE;         // node lifetime [s]
+
+private:
+	struct Node {
+		double v[3];      // log(rho), log(p), T
+		double t;         // UT of evaluation
+	};
+	struct Cell {
+		double v[8][3];   // corner nodes (index 4*alt+2*lat+lng)
+		double t;         // UT of the oldest node
+		bool exact;       // failed verification
+	};
+	static bool Band (double alt, int &k, double &z0, double &dz);
+	static inline uint64_t Key (int k, int i, int j) { return ((uint64_t)k << 20) | ((uint64_t)i << 10) | (uint64_t)j; }
+	static void Interpolate (const Cell &c, double f, double u, double w, MsisEvaluator::Prm &prm);
+	void NewCell (Cell &c, int k, double z0, double dz, int i, int j, const MsisEvaluator::Point &pt,
+		double f, double u, double w, MsisEvaluator::Prm &prm);
+	void Prune ();
+
+	const MsisEvaluator *msis;
+	double tol;
+	unsigned int epochid;
+	std::unordered_map<uint64_t,Node> node;
+	std::unordered_map<uint64_t,Cell> cell;
+	Stats stats;
+	size_t wquery, wmiss;     // queries and misses in the current monitoring window
+	size_t nbypass;           // remaining queries to bypass
+};
+
+#endif // !__MSISEVALUATOR_H
@@ -128,7 +128,7 @@ void InterpreterList::clbkPostStep (double simt, double simdt, double mjd)
 		if (!list[i]->interp) DelInterpreter (list[i--]);
 
 	for (i = 0; i < nlist; i++) { // let the interpreter do some work
-		if (list[i]->interp->IsBusy() || list[i]->cmd || list[i]->interp->nJobs()) {
+		if (list[i]->interp->Schedule (simt) || list[i]->cmd) {
 			list[i]->interp->EndExec();
 			list[i]->interp->WaitExec();
 		}
@@ -36,8 +36,28 @@ int OpenHelp (void *context);
 // ============================================================================
 // nonmember functions
 
+// metatables of VECTOR3 and MATRIX3 userdata
+static const char *VECTOR_MT = "VECTOR3.vtable";
+static const char *MATRIX_MT = "MATRIX3.vtable";
+
+// returns the userdata block at stack position idx if it carries metatable tname, NULL otherwise
+static void *lua_tomathud (lua_State *L, int idx, const char *tname)
+{
+	void *p = lua_touserdata (L, idx);
+	if (p && lua_getmetatable (L, idx)) {
+		lua_getfield (L, LUA_REGISTRYINDEX, tname);
+		if (!lua_rawequal (L, -1, -2)) p = NULL;
+		lua_pop (L, 2);
+		return p;
+	}
+	return NULL;
+}
+
 VECTOR3 lua_tovector (lua_State *L, int idx)
 {
+	VECTOR3 *pv = (VECTOR3*)lua_tomathud (L, idx, VECTOR_MT);
+	if (pv) return *pv;
+
 	VECTOR3 vec;
 	lua_getfield (L, idx, "x");
 	vec.x = lua_tonumber (L, -1); lua_pop (L,1);
@@ -67,6 +87,21 @@ Interpreter::Interpreter ()
 	lua_pushlightuserdata (L, this);
 	lua_setfield (L, LUA_REGISTRYINDEX, "interp");
 
+	// script scheduler
+	curtask = NULL;
+	nexttask = 1;
+	cpucur = NULL;
+	sched_simt = 0.0;
+	budget_ninstr = 0;
+	budget_t = 0.01;
+	hookcount = 1000;
+	ninstr = 0;
+	execthread = 0;
+	incycle = false;
+	preempted = false;
+	Lsvc = lua_newthread (L); // keep the thread referenced in the registry
+	lua_setfield (L, LUA_REGISTRYINDEX, "sched_svc");
+
 	hExecMutex = CreateMutex (NULL, TRUE, NULL);
 	hWaitMutex = CreateMutex (NULL, FALSE, NULL);
 
@@ -151,6 +186,240 @@ void Interpreter::PostStep (double simt, double simdt, double mjd)
 	}
 }
 
+bool Interpreter::Schedule (double simt)
+{
+	sched_simt = simt;
+	bool run = preempted || (is_busy && trunkwait.type == WAIT_NONE);
+	if (trunkwait.type != WAIT_NONE && (trunkwait.ready || CheckWait (trunkwait)))
+		run = true;
+	for (auto it = tasks.begin(); it != tasks.end(); it++) {
+		if (it->dead) continue;
+		if (it->wait.type == WAIT_NONE || it->wait.ready || CheckWait (it->wait))
+			run = true;
+	}
+	return run;
+}
+
+void Interpreter::SignalEvent (const char *name)
+{
+	if (trunkwait.type == WAIT_EVENT && trunkwait.event == name)
+		trunkwait.ready = trunkwait.result = true;
+	for (auto it = tasks.begin(); it != tasks.end(); it++)
+		if (it->wait.type == WAIT_EVENT && it->wait.event == name)
+			it->wait.ready = it->wait.result = true;
+}
+
+void Interpreter::SetBudget (int ninstr, double t)
+{
+	budget_ninstr = max (ninstr, 0);
+	budget_t = max (t, 0.0);
+	hookcount = (budget_ninstr && budget_ninstr < 1000 ? budget_ninstr : 1000);
+}
+
+void Interpreter::GetCpuTime (double &total, double &last) const
+{
+	total = trunkcpu.total;
+	last = trunkcpu.last;
+	for (auto it = tasks.begin(); it != tasks.end(); it++) {
+		total += it->cpu.total;
+		last += it->cpu.last;
+	}
+}
+
+void Interpreter::BeginCycle ()
+{
+	tcycle = tswitch = Clock::now();
+	ninstr = 0;
+	execthread = GetCurrentThreadId();
+	incycle = true;
+}
+
+void Interpreter::EndCycle ()
+{
+	SwitchCpu (cpucur);
+	trunkcpu.EndCycle();
+	for (auto it = tasks.begin(); it != tasks.end(); it++)
+		it->cpu.EndCycle();
+	incycle = false;
+}
+
+void Interpreter::SwitchCpu (CpuStat *stat)
+{
+	// charge the time since the last switch to the running script
+	Clock::time_point t = Clock::now();
+	if (cpucur) cpucur->cycle += std::chrono::duration<double>(t - tswitch).count();
+	tswitch = t;
+	cpucur = stat;
+}
+
+void Interpreter::SetHook (lua_State *Lx)
+{
+	if (budget_ninstr || budget_t)
+		lua_sethook (Lx, BudgetHook, LUA_MASKCOUNT, hookcount);
+	else
+		lua_sethook (Lx, NULL, 0, 0);
+}
+
+void Interpreter::BudgetHook (lua_State *Lx, lua_Debug *ar)
+{
+	Interpreter *interp = GetInterpreter (Lx);
+	// coroutines inherit the hook, so it can also be called from code the
+	// orbiter thread runs directly (e.g. vessel callbacks)
+	if (!interp->incycle || GetCurrentThreadId() != interp->execthread) return;
+
+	interp->ninstr += interp->hookcount;
+	if ((interp->budget_ninstr && interp->ninstr >= interp->budget_ninstr) ||
+		(interp->budget_t && std::chrono::duration<double>(Clock::now() - interp->tcycle).count() >= interp->budget_t))
+		interp->Preempt (Lx);
+}
+
+void Interpreter::Preempt (lua_State *Lx)
+{
+	// Suspend the running script until the next cycle. Unlike a coroutine
+	// yield, this works at any call depth (inside pcall, metamethods, etc.)
+	if (cpucur && cpucur->overrun++ == 0) {
+		if (curtask)
+			oapiWriteLogV ("Lua: job %d (%s) exceeded the execution budget and was suspended", curtask->id, curtask->name.c_str());
+		else
+			oapiWriteLogV ("Lua: script exceeded the execution budget and was suspended");
+	}
+	preempted = true;
+	frameskip (Lx);
+	preempted = false;
+	if (status == 1) { // termination request
+		lua_pushnil (Lx);
+		lua_error (Lx);
+	}
+}
+
+void Interpreter::ResumeTask (Task &task, int narg)
+{
+	Task *prevtask = curtask;
+	CpuStat *prevcpu = cpucur;
+	curtask = &task;
+	SwitchCpu (&task.cpu);
+	SetHook (task.co);
+	int res = lua_resume (task.co, narg);
+	lua_sethook (task.co, NULL, 0, 0);
+	SwitchCpu (prevcpu);
+	curtask = prevtask;
+
+	if (res == LUA_YIELD) {
+		lua_settop (task.co, 0); // discard yielded values
+	} else {
+		if (res) {
+			const char *err = lua_tostring (task.co, -1);
+			if (!err) err = "(no error message)";
+			oapiWriteLogError ("Lua job %d (%s): %s", task.id, task.name.c_str(), err);
+			oapiAnnotationSetText (errorbox, const_cast<char*>(err));
+			if (is_term) term_strout (err, true);
+		}
+		task.dead = true;
+	}
+}
+
+void Interpreter::RunTasks ()
+{
+	if (curtask) return; // jobs are only scheduled from the main script or the idle loop
+
+	size_t n = tasks.size(); // jobs created in this pass have run their first cycle already
+	for (auto it = tasks.begin(); n; it++, n--) {
+		if (it->dead) continue;
+		int narg = 0;
+		if (it->wait.type != WAIT_NONE) {
+			if (!it->wait.ready) continue;
+			bool result = it->wait.result;
+			ReleaseWait (it->wait);
+			lua_pushboolean (it->co, 1);
+			lua_pushboolean (it->co, result);
+			narg = 2;
+		}
+		ResumeTask (*it, narg);
+	}
+
+	// remove finished and killed jobs
+	for (auto it = tasks.begin(); it != tasks.end();) {
+		if (it->dead) {
+			ReleaseWait (it->wait);
+			luaL_unref (L, LUA_REGISTRYINDEX, it->ref);
+			it = tasks.erase (it);
+		} else it++;
+	}
+	jobs = (int)tasks.size();
+}
+
+void Interpreter::ReleaseWait (WaitCond &w)
+{
+	if (w.pred != LUA_NOREF) luaL_unref (L, LUA_REGISTRYINDEX, w.pred);
+	w = WaitCond();
+}
+
+bool Interpreter::CheckWait (WaitCond &w)
+{
+	switch (w.type) {
+	case WAIT_SIMTIME:
+		if (sched_simt >= w.t) w.ready = w.result = true;
+		break;
+	case WAIT_UNTIL:
+		lua_rawgeti (Lsvc, LUA_REGISTRYINDEX, w.pred);
+		if (LuaCall (Lsvc, 0, 1)) {
+			w.ready = true; // predicate failed: release the script
+			w.result = false;
+		} else if (lua_toboolean (Lsvc, -1)) {
+			w.ready = w.result = true;
+		}
+		lua_settop (Lsvc, 0);
+		// fall through to timeout check
+	case WAIT_EVENT:
+		if (!w.ready && w.t >= 0.0 && sched_simt >= w.t) {
+			w.ready = true; // timed out
+			w.result = false;
+		}
+		break;
+	default:
+		break;
+	}
+	return w.ready;
+}
+
+int Interpreter::Wait (lua_State *Lx, WaitCond &w)
+{
+	// Suspends the calling script until condition w is met. The main script
+	// hands control back to orbiter until Schedule reports the condition as
+	// met; a job yields and is resumed by RunTasks. Other coroutines are not
+	// managed by the scheduler: returns false, so the caller can poll instead.
+
+	WaitCond *slot;
+	if (Lx == L && !curtask) slot = &trunkwait;
+	else if (curtask && Lx == curtask->co) slot = &curtask->wait;
+	else {
+		ReleaseWait (w);
+		lua_pushboolean (Lx, 0);
+		return 1;
+	}
+	*slot = w;
+
+	if (!CheckWait (*slot)) {
+		if (slot != &trunkwait)
+			return lua_yield (Lx, 0); // RunTasks resumes the job with (true, result)
+
+		while (!trunkwait.ready) {
+			RunTasks ();
+			frameskip (Lx);
+			if (status == 1) { // termination request
+				ReleaseWait (trunkwait);
+				lua_pushnil (Lx);
+				return lua_error (Lx);
+			}
+		}
+	}
+	bool result = slot->result;
+	ReleaseWait (*slot);
+	lua_pushboolean (Lx, 1);
+	lua_pushboolean (Lx, result);
+	return 2;
+}
+
 int Interpreter::lua_tointeger_safe (lua_State *L, int idx, int prmno, const char *funcname)
 {
 	AssertPrmType(L, idx, prmno, PRMTP_NUMBER, funcname);
@@ -395,17 +664,28 @@ const char *Interpreter::lua_tostringex (lua_State *L, int idx, char *cbuf)
 
 void Interpreter::lua_pushvector (lua_State *L, const VECTOR3 &vec)
 {
-	lua_createtable (L, 0, 3);
-	lua_pushnumber (L, vec.x);
-	lua_setfield (L, -2, "x");
-	lua_pushnumber (L, vec.y);
-	lua_setfield (L, -2, "y");
-	lua_pushnumber (L, vec.z);
-	lua_setfield (L, -2, "z");
+	VECTOR3 *pv = (VECTOR3*)lua_newuserdata (L, sizeof(VECTOR3));
+	*pv = vec;
+	luaL_getmetatable (L, VECTOR_MT);
+	lua_setmetatable (L, -2);
+}
+
+void Interpreter::lua_setvector (lua_State *L, int idx, const VECTOR3 &vec)
+{
+	VECTOR3 *pv = (VECTOR3*)lua_tomathud (L, idx, VECTOR_MT);
+	if (pv) {
+		*pv = vec;
+	} else {
+		if (idx < 0) idx = lua_gettop (L) + idx + 1;
+		lua_pushnumber (L, vec.x);  lua_setfield (L, idx, "x");
+		lua_pushnumber (L, vec.y);  lua_setfield (L, idx, "y");
+		lua_pushnumber (L, vec.z);  lua_setfield (L, idx, "z");
+	}
 }
 
 int Interpreter::lua_isvector (lua_State *L, int idx)
 {
+	if (lua_tomathud (L, idx, VECTOR_MT)) return 1;
 	if (!lua_istable (L, idx)) return 0;
 	static char fieldname[3] = {'x','y','z'};
 	static char field[2] = "x";
@@ -433,20 +713,36 @@ int Interpreter::lua_isvector (lua_State *L, int idx)
 
 void Interpreter::lua_pushmatrix (lua_State *L, const MATRIX3 &mat)
 {
-	lua_createtable(L,0,9);
-	lua_pushnumber(L,mat.m11);  lua_setfield(L,-2,"m11");
-	lua_pushnumber(L,mat.m12);  lua_setfield(L,-2,"m12");
-	lua_pushnumber(L,mat.m13);  lua_setfield(L,-2,"m13");
-	lua_pushnumber(L,mat.m21);  lua_setfield(L,-2,"m21");
-	lua_pushnumber(L,mat.m22);  lua_setfield(L,-2,"m22");
-	lua_pushnumber(L,mat.m23);  lua_setfield(L,-2,"m23");
-	lua_pushnumber(L,mat.m31);  lua_setfield(L,-2,"m31");
-	lua_pushnumber(L,mat.m32);  lua_setfield(L,-2,"m32");
-	lua_pushnumber(L,mat.m33);  lua_setfield(L,-2,"m33");
+	MATRIX3 *pm = (MATRIX3*)lua_newuserdata (L, sizeof(MATRIX3));
+	*pm = mat;
+	luaL_getmetatable (L, MATRIX_MT);
+	lua_setmetatable (L, -2);
+}
+
+void Interpreter::lua_setmatrix (lua_State *L, int idx, const MATRIX3 &mat)
+{
+	MATRIX3 *pm = (MATRIX3*)lua_tomathud (L, idx, MATRIX_MT);
+	if (pm) {
+		*pm = mat;
+	} else {
+		if (idx < 0) idx = lua_gettop (L) + idx + 1;
+		lua_pushnumber(L,mat.m11);  lua_setfield(L,idx,"m11");
+		lua_pushnumber(L,mat.m12);  lua_setfield(L,idx,"m12");
+		lua_pushnumber(L,mat.m13);  lua_setfield(L,idx,"m13");
+		lua_pushnumber(L,mat.m21);  lua_setfield(L,idx,"m21");
+		lua_pushnumber(L,mat.m22);  lua_setfield(L,idx,"m22");
+		lua_pushnumber(L,mat.m23);  lua_setfield(L,idx,"m23");
+		lua_pushnumber(L,mat.m31);  lua_setfield(L,idx,"m31");
+		lua_pushnumber(L,mat.m32);  lua_setfield(L,idx,"m32");
+		lua_pushnumber(L,mat.m33);  lua_setfield(L,idx,"m33");
+	}
 }
 
 MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 {
+	MATRIX3 *pm = (MATRIX3*)lua_tomathud (L, idx, MATRIX_MT);
+	if (pm) return *pm;
+
 	MATRIX3 mat;
 	lua_getfield (L, idx, "m11");  mat.m11 = lua_tonumber (L, -1);  lua_pop (L,1);
 	lua_getfield (L, idx, "m12");  mat.m12 = lua_tonumber (L, -1);  lua_pop (L,1);
@@ -462,6 +758,7 @@ MATRIX3 Interpreter::lua_tomatrix (lua_State *L, int idx)
 
 int Interpreter::lua_ismatrix (lua_State *L, int idx)
 {
+	if (lua_tomathud (L, idx, MATRIX_MT)) return 1;
 	if (!lua_istable (L, idx)) return 0;
 	static const char *fieldname[9] = {"m11","m12","m13","m21","m22","m23","m31","m32","m33"};
 	int i, ii, n;
@@ -687,8 +984,10 @@ void Interpreter::frameskip (lua_State *L)
 		lua_pushboolean(L, 1);
 		lua_setfield (L, LUA_GLOBALSINDEX, "wait_exit");
 	} else {
+		EndCycle();
 		EndExec();
 		WaitExec();
+		BeginCycle();
 	}
 }
 
@@ -703,11 +1002,17 @@ int Interpreter::ProcessChunk (const char *chunk, int n)
 int Interpreter::RunChunk (const char *chunk, int n)
 {
 	int res = 0;
+	BeginCycle();
 	if (chunk[0]) {
 		is_busy = true;
 		// run command
+		SwitchCpu (&trunkcpu);
+		SetHook (L);
 		luaL_loadbuffer (L, chunk, n, "line");
 		res = LuaCall (L, 0, 0);
+		lua_sethook (L, NULL, 0, 0);
+		SwitchCpu (NULL);
+		ReleaseWait (trunkwait);
 		if (res) {
 			auto error = lua_tostring(L, -1);
 			if (error) { // can be nullptr
@@ -716,23 +1021,21 @@ int Interpreter::RunChunk (const char *chunk, int n)
 					term_strout(error, true);
 				}
 				is_busy = false;
+				EndCycle();
 				return res;
 			}
 		}
 		// check for leftover background jobs
-		lua_getfield (L, LUA_GLOBALSINDEX, "_nbranch");
-		LuaCall (L, 0, 1);
-		jobs = lua_tointeger (L, -1);
-		lua_pop (L, 1);
+		jobs = 0;
+		for (auto it = tasks.begin(); it != tasks.end(); it++)
+			if (!it->dead) jobs++;
 		is_busy = false;
 	} else {
 		// idle loop: execute background jobs
-		lua_getfield (L, LUA_GLOBALSINDEX, "_idle");
-		LuaCall (L, 0, 1);
-		jobs = lua_tointeger (L, -1);
-		lua_pop (L, 1);
+		RunTasks();
 		res = -1;
 	}
+	EndCycle();
 	return res;
 }
 
@@ -767,6 +1070,13 @@ void Interpreter::LoadAPI ()
 		{"length", vec_length},
 		{"dist", vec_dist},
 		{"unit", vec_unit},
+		{"assign", vec_assign},
+		{"add_to", vec_add_to},
+		{"sub_to", vec_sub_to},
+		{"mul_to", vec_mul_to},
+		{"div_to", vec_div_to},
+		{"crossp_to", vec_crossp_to},
+		{"unit_to", vec_unit_to},
 		{NULL, NULL}
 	};
 	luaL_openlib (L, "vec", vecLib, 0);
@@ -777,13 +1087,54 @@ void Interpreter::LoadAPI ()
 		{"tmul", mat_tmul},
 		{"mmul", mat_mmul},
 		{"rotm", mat_rotm},
+		{"mul_to", mat_mul_to},
+		{"tmul_to", mat_tmul_to},
+		{"mmul_to", mat_mmul_to},
 		{NULL, NULL}
 	};
 	luaL_openlib (L, "mat", matLib, 0);
 
+	// Metatables for vector and matrix userdata
+	static const struct luaL_reg vecMt[] = {
+		{"__index", vec_index},
+		{"__newindex", vec_newindex},
+		{"__add", vec_add},
+		{"__sub", vec_sub},
+		{"__mul", vec_mul},
+		{"__div", vec_div},
+		{"__unm", vec_unm},
+		{"__eq", vec_eq},
+		{"__tostring", vec_tostring},
+		{NULL, NULL}
+	};
+	luaL_newmetatable (L, VECTOR_MT);
+	luaL_openlib (L, NULL, vecMt, 0);
+	lua_pop (L, 1);
+
+	static const struct luaL_reg matMt[] = {
+		{"__index", mat_index},
+		{"__newindex", mat_newindex},
+		{"__mul", mat_mulop},
+		{"__eq", mat_eq},
+		{"__tostring", mat_tostring},
+		{NULL, NULL}
+	};
+	luaL_newmetatable (L, MATRIX_MT);
+	luaL_openlib (L, NULL, matMt, 0);
+	lua_pop (L, 1);
+
 	// Load the process library
 	static const struct luaL_reg procLib[] = {
 		{"Frameskip", procFrameskip},
+		{"Spawn", procSpawn},
+		{"Kill", procKill},
+		{"Jobs", procJobs},
+		{"WaitSimtime", procWaitSimtime},
+		{"WaitUntil", procWaitUntil},
+		{"WaitEvent", procWaitEvent},
+		{"signal", procSignal},
+		{"usage", procUsage},
+		{"set_budget", procSetBudget},
 		{NULL, NULL}
 	};
 	luaL_openlib (L, "proc", procLib, 0);
@@ -2161,8 +2512,11 @@ Vector library functions.
 /***
 Define a vector from its components.
 
-You can also use standard Lua syntax to define the components of the vector
-(vectors are defined as tables with fields 'x', 'y' and 'z').
+Vectors returned by the API are userdata objects with fields 'x', 'y' and 'z'
+that support the arithmetic operators +, - (binary and unary), * and / (elementwise,
+or with a number), and ==. You can also use standard Lua syntax to define a
+vector as a table with fields 'x', 'y' and 'z'; such tables are accepted
+wherever a vector is expected.
 
 The _V function provides a handier notation :
     v = _V(0,0,1)
@@ -2449,6 +2803,167 @@ int Interpreter::vec_unit (lua_State *L)
 	return 1;
 }
 
+/***
+In-place vector operations.
+
+The `_to` functions write their result into an existing vector `out`
+instead of creating a new one, and return `out`. They do not allocate
+any memory, and should be preferred in functions that are called every frame.
+`out` may be identical to one of the arguments.
+@section inplace
+*/
+
+bool Interpreter::lua_tovecoperand (lua_State *L, int idx, VECTOR3 &v)
+{
+	if (lua_isnumber (L, idx)) {
+		v.x = v.y = v.z = lua_tonumber (L, idx);
+		return true;
+	} else if (lua_isvector (L, idx)) {
+		v = lua_tovector (L, idx);
+		return true;
+	}
+	return false;
+}
+
+/***
+Copy vector components.
+@function assign
+@tparam vector out target vector
+@tparam (vector|number) x source vector, or x-component
+@tparam[opt] number y y-component
+@tparam[opt] number z z-component
+@treturn vector out
+@usage vec.assign(v, 0, 0, 1)
+*/
+int Interpreter::vec_assign (lua_State *L)
+{
+	VECTOR3 v;
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	if (lua_gettop(L) >= 4) {
+		for (int i = 0; i < 3; i++) {
+			ASSERT_SYNTAX(lua_isnumber(L,i+2), "expected three numeric components");
+			v.data[i] = lua_tonumber(L,i+2);
+		}
+	} else {
+		ASSERT_SYNTAX(lua_isvector(L,2), "Argument 2: expected vector");
+		v = lua_tovector(L,2);
+	}
+	lua_setvector (L, 1, v);
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place vector sum: out = a+b.
+@function add_to
+@tparam vector out result vector
+@tparam (vector|number) a
+@tparam (vector|number) b
+@treturn vector out
+@usage vec.add_to(pos, pos, dpos)
+*/
+int Interpreter::vec_add_to (lua_State *L)
+{
+	VECTOR3 a, b;
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_tovecoperand(L,2,a), "Argument 2: expected vector or number");
+	ASSERT_SYNTAX(lua_tovecoperand(L,3,b), "Argument 3: expected vector or number");
+	lua_setvector (L, 1, a+b);
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place vector difference: out = a-b.
+@function sub_to
+@tparam vector out result vector
+@tparam (vector|number) a
+@tparam (vector|number) b
+@treturn vector out
+*/
+int Interpreter::vec_sub_to (lua_State *L)
+{
+	VECTOR3 a, b;
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_tovecoperand(L,2,a), "Argument 2: expected vector or number");
+	ASSERT_SYNTAX(lua_tovecoperand(L,3,b), "Argument 3: expected vector or number");
+	lua_setvector (L, 1, a-b);
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place elementwise vector multiplication: out = a*b.
+@function mul_to
+@tparam vector out result vector
+@tparam (vector|number) a
+@tparam (vector|number) b
+@treturn vector out
+*/
+int Interpreter::vec_mul_to (lua_State *L)
+{
+	VECTOR3 a, b;
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_tovecoperand(L,2,a), "Argument 2: expected vector or number");
+	ASSERT_SYNTAX(lua_tovecoperand(L,3,b), "Argument 3: expected vector or number");
+	lua_setvector (L, 1, _V(a.x*b.x, a.y*b.y, a.z*b.z));
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place elementwise vector division: out = a/b.
+@function div_to
+@tparam vector out result vector
+@tparam (vector|number) a
+@tparam (vector|number) b
+@treturn vector out
+*/
+int Interpreter::vec_div_to (lua_State *L)
+{
+	VECTOR3 a, b;
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_tovecoperand(L,2,a), "Argument 2: expected vector or number");
+	ASSERT_SYNTAX(lua_tovecoperand(L,3,b), "Argument 3: expected vector or number");
+	lua_setvector (L, 1, _V(a.x/b.x, a.y/b.y, a.z/b.z));
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place cross product: out = a x b.
+@function crossp_to
+@tparam vector out result vector
+@tparam vector a
+@tparam vector b
+@treturn vector out
+*/
+int Interpreter::vec_crossp_to (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_isvector(L,2), "Argument 2: expected vector");
+	ASSERT_SYNTAX(lua_isvector(L,3), "Argument 3: expected vector");
+	lua_setvector (L, 1, crossp (lua_tovector(L,2), lua_tovector(L,3)));
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place unit vector: out = a/|a|.
+@function unit_to
+@tparam vector out result vector
+@tparam vector a
+@treturn vector out
+*/
+int Interpreter::vec_unit_to (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_isvector(L,2), "Argument 2: expected vector");
+	lua_setvector (L, 1, unit (lua_tovector(L,2)));
+	lua_settop (L, 1);
+	return 1;
+}
+
 /***
 Matrix library functions.
 @module mat
@@ -2537,6 +3052,173 @@ int Interpreter::mat_rotm (lua_State *L) {
 	return 1;
 }
 
+/***
+In-place matrix operations.
+
+Like the in-place vector functions, these write their result into an
+existing vector or matrix `out` and return it, without allocating memory.
+@section inplace
+*/
+
+/***
+In-place matrix vector multiplication: out = M v.
+@function mul_to
+@tparam vector out result vector
+@tparam matrix m
+@tparam vector v
+@treturn vector out
+*/
+int Interpreter::mat_mul_to (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_ismatrix(L,2), "Argument 2: expected matrix");
+	ASSERT_SYNTAX(lua_isvector(L,3), "Argument 3: expected vector");
+	lua_setvector (L, 1, mul (lua_tomatrix(L,2), lua_tovector(L,3)));
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place matrix-transpose vector multiplication: out = M<sup>T</sup> v.
+@function tmul_to
+@tparam vector out result vector
+@tparam matrix m
+@tparam vector v
+@treturn vector out
+*/
+int Interpreter::mat_tmul_to (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_isvector(L,1), "Argument 1: expected vector");
+	ASSERT_SYNTAX(lua_ismatrix(L,2), "Argument 2: expected matrix");
+	ASSERT_SYNTAX(lua_isvector(L,3), "Argument 3: expected vector");
+	lua_setvector (L, 1, tmul (lua_tomatrix(L,2), lua_tovector(L,3)));
+	lua_settop (L, 1);
+	return 1;
+}
+
+/***
+In-place matrix matrix multiplication: out = A B.
+@function mmul_to
+@tparam matrix out result matrix
+@tparam matrix A
+@tparam matrix B
+@treturn matrix out
+*/
+int Interpreter::mat_mmul_to (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_ismatrix(L,1), "Argument 1: expected matrix");
+	ASSERT_SYNTAX(lua_ismatrix(L,2), "Argument 2: expected matrix");
+	ASSERT_SYNTAX(lua_ismatrix(L,3), "Argument 3: expected matrix");
+	lua_setmatrix (L, 1, mul (lua_tomatrix(L,2), lua_tomatrix(L,3)));
+	lua_settop (L, 1);
+	return 1;
+}
+
+// ============================================================================
+// vector and matrix userdata metamethods
+
+// component index of key 'x', 'y' or 'z' at stack position idx, or -1
+static int veckey (lua_State *L, int idx)
+{
+	size_t len;
+	const char *key = (lua_type (L, idx) == LUA_TSTRING ? lua_tolstring (L, idx, &len) : 0);
+	if (!key || len != 1 || key[0] < 'x' || key[0] > 'z') return -1;
+	return key[0]-'x';
+}
+
+// element index of key 'm11' ... 'm33' at stack position idx, or -1
+static int matkey (lua_State *L, int idx)
+{
+	size_t len;
+	const char *key = (lua_type (L, idx) == LUA_TSTRING ? lua_tolstring (L, idx, &len) : 0);
+	if (!key || len != 3 || key[0] != 'm' || key[1] < '1' || key[1] > '3' || key[2] < '1' || key[2] > '3') return -1;
+	return (key[1]-'1')*3 + (key[2]-'1');
+}
+
+int Interpreter::vec_index (lua_State *L)
+{
+	VECTOR3 *pv = (VECTOR3*)lua_touserdata (L, 1);
+	int i = veckey (L, 2);
+	if (i >= 0) lua_pushnumber (L, pv->data[i]);
+	else lua_pushnil (L);
+	return 1;
+}
+
+int Interpreter::vec_newindex (lua_State *L)
+{
+	VECTOR3 *pv = (VECTOR3*)lua_touserdata (L, 1);
+	int i = veckey (L, 2);
+	ASSERT_SYNTAX(i >= 0, "vector: invalid field (expected x, y or z)");
+	ASSERT_SYNTAX(lua_isnumber (L, 3), "vector: expected number");
+	pv->data[i] = lua_tonumber (L, 3);
+	return 0;
+}
+
+int Interpreter::vec_unm (lua_State *L)
+{
+	lua_pushvector (L, -lua_tovector (L, 1));
+	return 1;
+}
+
+int Interpreter::vec_eq (lua_State *L)
+{
+	VECTOR3 a = lua_tovector (L, 1), b = lua_tovector (L, 2);
+	lua_pushboolean (L, a.x == b.x && a.y == b.y && a.z == b.z);
+	return 1;
+}
+
+int Interpreter::vec_tostring (lua_State *L)
+{
+	lua_pushstring (L, lua_tostringex (L, 1));
+	return 1;
+}
+
+int Interpreter::mat_index (lua_State *L)
+{
+	MATRIX3 *pm = (MATRIX3*)lua_touserdata (L, 1);
+	int i = matkey (L, 2);
+	if (i >= 0) lua_pushnumber (L, pm->data[i]);
+	else lua_pushnil (L);
+	return 1;
+}
+
+int Interpreter::mat_newindex (lua_State *L)
+{
+	MATRIX3 *pm = (MATRIX3*)lua_touserdata (L, 1);
+	int i = matkey (L, 2);
+	ASSERT_SYNTAX(i >= 0, "matrix: invalid field (expected m11 ... m33)");
+	ASSERT_SYNTAX(lua_isnumber (L, 3), "matrix: expected number");
+	pm->data[i] = lua_tonumber (L, 3);
+	return 0;
+}
+
+int Interpreter::mat_mulop (lua_State *L)
+{
+	ASSERT_SYNTAX(lua_ismatrix(L,1), "Argument 1: expected matrix");
+	if (lua_ismatrix (L, 2)) {
+		lua_pushmatrix (L, mul (lua_tomatrix(L,1), lua_tomatrix(L,2)));
+	} else {
+		ASSERT_SYNTAX(lua_isvector(L,2), "Argument 2: expected matrix or vector");
+		lua_pushvector (L, mul (lua_tomatrix(L,1), lua_tovector(L,2)));
+	}
+	return 1;
+}
+
+int Interpreter::mat_eq (lua_State *L)
+{
+	MATRIX3 a = lua_tomatrix (L, 1), b = lua_tomatrix (L, 2);
+	bool eq = true;
+	for (int i = 0; i < 9 && eq; i++) eq = (a.data[i] == b.data[i]);
+	lua_pushboolean (L, eq);
+	return 1;
+}
+
+int Interpreter::mat_tostring (lua_State *L)
+{
+	lua_pushstring (L, lua_tostringex (L, 1));
+	return 1;
+}
+
 // ============================================================================
 // process library functions
 
@@ -2546,10 +3228,166 @@ int Interpreter::procFrameskip (lua_State *L)
 	// This should be called in the loop of any "wait"-type function
 
 	Interpreter *interp = GetInterpreter(L);
+	interp->RunTasks ();
 	interp->frameskip (L);
 	return 0;
 }
 
+int Interpreter::procSpawn (lua_State *L)
+{
+	// create a background job from function (arg 1) and run its first cycle
+	// with the remaining arguments. Returns the job id.
+
+	ASSERT_SYNTAX(lua_isfunction (L, 1), "Argument 1: function expected");
+	Interpreter *interp = GetInterpreter(L);
+	int narg = lua_gettop (L) - 1;
+
+	Task task;
+	task.id = interp->nexttask++;
+	task.dead = false;
+	task.co = lua_newthread (L);
+	task.ref = luaL_ref (L, LUA_REGISTRYINDEX);
+
+	lua_Debug ar;
+	lua_pushvalue (L, 1);
+	lua_getinfo (L, ">S", &ar);
+	char cbuf[256];
+	sprintf (cbuf, "%s:%d", ar.short_src, ar.linedefined);
+	task.name = cbuf;
+
+	lua_xmove (L, task.co, narg+1); // function and arguments
+	interp->tasks.push_back (task);
+	interp->ResumeTask (interp->tasks.back(), narg);
+	lua_pushinteger (L, task.id);
+	return 1;
+}
+
+int Interpreter::procKill (lua_State *L)
+{
+	// terminate a background job. Returns true if the job was found.
+	// A job killing itself continues until it yields.
+
+	int id = lua_tointeger_safe (L, 1, "proc.Kill");
+	Interpreter *interp = GetInterpreter(L);
+	bool found = false;
+	for (auto it = interp->tasks.begin(); it != interp->tasks.end(); it++)
+		if (it->id == id && !it->dead) {
+			it->dead = true;
+			found = true;
+			break;
+		}
+	lua_pushboolean (L, found);
+	return 1;
+}
+
+int Interpreter::procJobs (lua_State *L)
+{
+	// returns the number of active background jobs
+	Interpreter *interp = GetInterpreter(L);
+	int n = 0;
+	for (auto it = interp->tasks.begin(); it != interp->tasks.end(); it++)
+		if (!it->dead) n++;
+	lua_pushinteger (L, n);
+	return 1;
+}
+
+int Interpreter::procWaitSimtime (lua_State *L)
+{
+	// suspend until simulation time t (arg 1)
+	// Returns true, or false if the caller is not managed by the scheduler.
+
+	WaitCond w;
+	w.type = WAIT_SIMTIME;
+	w.t = lua_tonumber_safe (L, 1, "proc.WaitSimtime");
+	return GetInterpreter(L)->Wait (L, w);
+}
+
+int Interpreter::procWaitUntil (lua_State *L)
+{
+	// suspend until predicate (arg 1) returns true, or until the optional
+	// timeout interval dt (arg 2) [s] has passed.
+	// Returns true, result (false on timeout or predicate error), or false if
+	// the caller is not managed by the scheduler.
+
+	ASSERT_SYNTAX(lua_isfunction (L, 1), "Argument 1: function expected");
+	Interpreter *interp = GetInterpreter(L);
+	WaitCond w;
+	w.type = WAIT_UNTIL;
+	if (!lua_isnoneornil (L, 2))
+		w.t = interp->sched_simt + lua_tonumber_safe (L, 2, "proc.WaitUntil");
+	lua_pushvalue (L, 1);
+	w.pred = luaL_ref (L, LUA_REGISTRYINDEX);
+	return interp->Wait (L, w);
+}
+
+int Interpreter::procWaitEvent (lua_State *L)
+{
+	// suspend until event 'name' (arg 1) is signalled, or until the optional
+	// timeout interval dt (arg 2) [s] has passed.
+	// Returns true, result (false on timeout), or false if the caller is not
+	// managed by the scheduler.
+
+	Interpreter *interp = GetInterpreter(L);
+	WaitCond w;
+	w.type = WAIT_EVENT;
+	w.event = lua_tostring_safe (L, 1, "proc.WaitEvent");
+	if (!lua_isnoneornil (L, 2))
+		w.t = interp->sched_simt + lua_tonumber_safe (L, 2, "proc.WaitEvent");
+	return interp->Wait (L, w);
+}
+
+int Interpreter::procSignal (lua_State *L)
+{
+	// wake all scripts waiting for event 'name' (arg 1)
+	GetInterpreter(L)->SignalEvent (lua_tostring_safe (L, 1, "proc.signal"));
+	return 0;
+}
+
+int Interpreter::procUsage (lua_State *L)
+{
+	// returns a list of CPU usage records for the main script (id 0) and
+	// all background jobs. Times are in seconds.
+
+	Interpreter *interp = GetInterpreter(L);
+	int i = 0;
+	auto push = [&](int id, const char *name, const char *state, const CpuStat &stat) {
+		lua_newtable (L);
+		lua_pushinteger (L, id);
+		lua_setfield (L, -2, "id");
+		lua_pushstring (L, name);
+		lua_setfield (L, -2, "name");
+		lua_pushstring (L, state);
+		lua_setfield (L, -2, "state");
+		lua_pushnumber (L, stat.total + stat.cycle);
+		lua_setfield (L, -2, "total");
+		lua_pushnumber (L, stat.last);
+		lua_setfield (L, -2, "last");
+		lua_pushnumber (L, stat.peak);
+		lua_setfield (L, -2, "peak");
+		lua_pushinteger (L, stat.overrun);
+		lua_setfield (L, -2, "overrun");
+		lua_rawseti (L, -2, ++i);
+	};
+
+	lua_newtable (L);
+	push (0, "main", interp->trunkwait.type != WAIT_NONE ? "waiting" : interp->is_busy ? "running" : "idle", interp->trunkcpu);
+	for (auto it = interp->tasks.begin(); it != interp->tasks.end(); it++)
+		if (!it->dead)
+			push (it->id, it->name.c_str(), it->wait.type != WAIT_NONE ? "waiting" : "running", it->cpu);
+	return 1;
+}
+
+int Interpreter::procSetBudget (lua_State *L)
+{
+	// set the execution budget per cycle: max. instruction count (arg 1) and
+	// max. CPU time [ms] (arg 2). 0 or nil means unlimited.
+
+	int ninstr = (lua_isnoneornil (L, 1) ? 0 : lua_tointeger_safe (L, 1, "proc.set_budget"));
+	double t = (lua_isnoneornil (L, 2) ? 0.0 : lua_tonumber_safe (L, 2, "proc.set_budget"));
+	GetInterpreter(L)->SetBudget (ninstr, t*1e-3);
+	return 0;
+}
+
 // ============================================================================
 // oapi library functions
 
@@ -12,6 +12,9 @@ extern "C" {
 
 #include "OrbiterAPI.h"
 #include "VesselAPI.h" // for TOUCHDOWNVTX
+#include <chrono>
+#include <list>
+#include <string>
 #include <unordered_set>
 
 class gcCore;
@@ -82,6 +85,7 @@ typedef struct  {
 // Nonmember functions
 
 // converts the vector at stack position 'idx' into a VECTOR3
+// (accepts VECTOR3 userdata and tables with x, y, z fields)
 INTERPRETERLIB VECTOR3 lua_tovector (lua_State *L, int idx);
 
 // ======================================================================
@@ -135,6 +139,46 @@ public:
 	
 	void PostStep (double simt, double simdt, double mjd);
 
+	/**
+	 * \brief Services the wait conditions of the main script and its
+	 *   background jobs.
+	 * \param simt current simulation time [s]
+	 * \return \e true if the interpreter has work to do in this cycle (a
+	 *   running command, a job that is not waiting, or a wait condition that
+	 *   has been met), \e false if all scripts are blocked in a wait.
+	 * \note Must be called by the orbiter thread while it holds execution
+	 *   control (typically from clbkPreStep), before handing control to the
+	 *   interpreter thread. Predicates passed to proc.wait_until are
+	 *   evaluated here, so waiting scripts don't need a cycle each frame.
+	 */
+	bool Schedule (double simt);
+
+	/**
+	 * \brief Wakes all scripts waiting for an event.
+	 * \param name event name
+	 * \note Equivalent to proc.signal(name) on the script side. Must be
+	 *   called by a thread holding execution control.
+	 */
+	void SignalEvent (const char *name);
+
+	/**
+	 * \brief Sets the execution budget for a single cycle.
+	 * \param ninstr max. number of Lua instructions per cycle (0: unlimited)
+	 * \param t max. CPU time per cycle [s] (0: unlimited)
+	 * \note A script exceeding the budget is suspended and continues in the
+	 *   next cycle, so a long computation no longer stalls the simulation.
+	 * \note Default: no instruction limit, 10 ms per cycle.
+	 */
+	void SetBudget (int ninstr, double t);
+
+	/**
+	 * \brief Returns the CPU time used by the main script and all
+	 *   background jobs.
+	 * \param total total CPU time since the interpreter was created [s]
+	 * \param last CPU time used in the last execution cycle [s]
+	 */
+	void GetCpuTime (double &total, double &last) const;
+
 	/**
 	 * \brief Wait for thread execution.
 	 * \note This is called by either the orbiter thread or the interpreter
@@ -270,6 +314,9 @@ protected:
 	// suspend script execution for one cycle
 	void frameskip (lua_State *L);
 
+	// resume all background jobs that are not waiting
+	void RunTasks ();
+
 	// extract interpreter pointer from lua state
 	static Interpreter *GetInterpreter (lua_State *L);
 
@@ -277,16 +324,24 @@ protected:
 	// This also handles vector and nil entries.
 	static const char *lua_tostringex (lua_State *L, int idx, char *cbuf = 0);
 
-	// pushes vector 'vec' into a table on top of the stack
+	// pushes vector 'vec' as a VECTOR3 userdata on top of the stack
 	static void lua_pushvector (lua_State *L, const VECTOR3 &vec);
 
-	// returns 1 if stack entry idx is a vector, 0 otherwise
+	// overwrites the vector (userdata or table) at stack position idx with 'vec'
+	static void lua_setvector (lua_State *L, int idx, const VECTOR3 &vec);
+
+	// returns 1 if stack entry idx is a vector (VECTOR3 userdata or table
+	// with x, y, z fields), 0 otherwise
 	static int lua_isvector (lua_State *L, int idx);
 
-	// pushes matrix 'mat' into a table on top of the stack
+	// pushes matrix 'mat' as a MATRIX3 userdata on top of the stack
 	static void lua_pushmatrix (lua_State *L, const MATRIX3 &mat);
 
+	// overwrites the matrix (userdata or table) at stack position idx with 'mat'
+	static void lua_setmatrix (lua_State *L, int idx, const MATRIX3 &mat);
+
 	// converts the matrix at stack position 'idx' into a MATRIX3
+	// (accepts MATRIX3 userdata and tables with m11 ... m33 fields)
 	static MATRIX3 lua_tomatrix (lua_State *L, int idx);
 
 	// returns 1 if stack entry idx is a matrix, 0 otherwise
@@ -361,11 +416,36 @@ protected:
 	static int vec_length (lua_State *L);
 	static int vec_dist (lua_State *L);
 	static int vec_unit (lua_State *L);
+	static int vec_assign (lua_State *L);
+	static int vec_add_to (lua_State *L);
+	static int vec_sub_to (lua_State *L);
+	static int vec_mul_to (lua_State *L);
+	static int vec_div_to (lua_State *L);
+	static int vec_crossp_to (lua_State *L);
+	static int vec_unit_to (lua_State *L);
 	static int mat_identity (lua_State *L);
 	static int mat_mul (lua_State *L);
 	static int mat_tmul (lua_State *L);
 	static int mat_mmul (lua_State *L);
 	static int mat_rotm (lua_State *L);
+	static int mat_mul_to (lua_State *L);
+	static int mat_tmul_to (lua_State *L);
+	static int mat_mmul_to (lua_State *L);
+
+	// VECTOR3 and MATRIX3 userdata metamethods
+	static int vec_index (lua_State *L);
+	static int vec_newindex (lua_State *L);
+	static int vec_unm (lua_State *L);
+	static int vec_eq (lua_State *L);
+	static int vec_tostring (lua_State *L);
+	static int mat_index (lua_State *L);
+	static int mat_newindex (lua_State *L);
+	static int mat_mulop (lua_State *L);
+	static int mat_eq (lua_State *L);
+	static int mat_tostring (lua_State *L);
+
+	// reads a vector operand; a number is expanded to a vector with three equal components
+	static bool lua_tovecoperand (lua_State *L, int idx, VECTOR3 &v);
 
 	// bit manipulations
 	static int bit_anyset(lua_State* L);
@@ -383,6 +463,15 @@ protected:
 
 	// process library functions
 	static int procFrameskip (lua_State *L);
+	static int procSpawn (lua_State *L);
+	static int procKill (lua_State *L);
+	static int procJobs (lua_State *L);
+	static int procWaitSimtime (lua_State *L);
+	static int procWaitUntil (lua_State *L);
+	static int procWaitEvent (lua_State *L);
+	static int procSignal (lua_State *L);
+	static int procUsage (lua_State *L);
+	static int procSetBudget (lua_State *L);
 
 	// -------------------------------------------
 	// oapi library functions
@@ -690,6 +779,8 @@ protected:
 	static int v_set_emptymass (lua_State *L);
 	static int v_get_pmi (lua_State *L);
 	static int v_set_pmi (lua_State *L);
+	static int v_get_superstructurecg (lua_State *L);
+	static int v_get_superstructurepmi (lua_State *L);
 	static int v_get_crosssections (lua_State *L);
 	static int v_set_crosssections (lua_State *L);
 	static int v_get_gravitygradientdamping (lua_State *L);
@@ -1155,6 +1246,70 @@ private:
 	int (*postfunc)(void*);
 	void *postcontext;
 
+	// script scheduler
+	typedef std::chrono::steady_clock Clock;
+
+	enum WaitType { WAIT_NONE, WAIT_SIMTIME, WAIT_UNTIL, WAIT_EVENT };
+
+	struct WaitCond {        // condition a suspended script is waiting for
+		WaitType type;
+		double t;            // wake-up or timeout simulation time [s] (<0: none)
+		int pred;            // registry reference of the predicate (WAIT_UNTIL)
+		std::string event;   // event name (WAIT_EVENT)
+		bool ready;          // condition met, script can be resumed
+		bool result;         // value returned to the script on wake-up
+		WaitCond (): type(WAIT_NONE), t(-1.0), pred(LUA_NOREF), ready(false), result(false) {}
+	};
+
+	struct CpuStat {         // CPU usage of the main script or a job
+		double total;        // total CPU time [s]
+		double cycle;        // CPU time in the current cycle [s]
+		double last;         // CPU time in the last cycle [s]
+		double peak;         // max. CPU time in a single cycle [s]
+		int overrun;         // number of times the budget was exceeded
+		CpuStat (): total(0.0), cycle(0.0), last(0.0), peak(0.0), overrun(0) {}
+		void EndCycle () { last = cycle; total += cycle; if (cycle > peak) peak = cycle; cycle = 0.0; }
+	};
+
+	struct Task {            // background job created by proc.bg
+		int id;              // job id
+		int ref;             // registry reference of the coroutine
+		lua_State *co;       // coroutine
+		std::string name;    // source location of the job function
+		WaitCond wait;
+		CpuStat cpu;
+		bool dead;           // finished or killed
+	};
+
+	std::list<Task> tasks;   // background jobs
+	Task *curtask;           // job currently running (NULL: main script)
+	int nexttask;            // id of the next job
+	WaitCond trunkwait;      // wait condition of the main script
+	CpuStat trunkcpu;        // CPU usage of the main script
+	CpuStat *cpucur;         // statistics charged for the running code
+	lua_State *Lsvc;         // thread for evaluating wait predicates
+	double sched_simt;       // simulation time at the last Schedule call
+	int budget_ninstr;       // instruction budget per cycle (0: unlimited)
+	double budget_t;         // CPU time budget per cycle [s] (0: unlimited)
+	int hookcount;           // instructions between budget checks
+	int ninstr;              // instructions executed in the current cycle
+	Clock::time_point tcycle;  // start of the current cycle
+	Clock::time_point tswitch; // time of the last CPU statistics switch
+	DWORD execthread;        // thread executing the current cycle
+	bool incycle;            // inside an execution cycle
+	bool preempted;          // script suspended for exceeding the budget
+
+	void BeginCycle ();
+	void EndCycle ();
+	void SwitchCpu (CpuStat *stat);
+	void SetHook (lua_State *Lx);
+	void ResumeTask (Task &task, int narg);
+	void ReleaseWait (WaitCond &w);
+	bool CheckWait (WaitCond &w);
+	int Wait (lua_State *Lx, WaitCond &w);
+	void Preempt (lua_State *Lx);
+	static void BudgetHook (lua_State *Lx, lua_Debug *ar);
+
 	static inline std::unordered_set<VESSEL *>knownVessels; // for lua_isvessel
 
 
@@ -244,6 +244,8 @@ void Interpreter::LoadVesselAPI ()
 		{"set_emptymass", v_set_emptymass},
 		{"get_pmi", v_get_pmi},
 		{"set_pmi", v_set_pmi},
+		{"get_superstructurecg", v_get_superstructurecg},
+		{"get_superstructurepmi", v_get_superstructurepmi},
 		{"get_crosssections", v_get_crosssections},
 		{"set_crosssections", v_set_crosssections},
 		{"get_gravitygradientdamping", v_get_gravitygradientdamping},
@@ -1211,6 +1213,49 @@ int Interpreter::v_set_pmi (lua_State *L)
 	return 0;
 }
 
+/***
+Get superstructure centre of gravity.
+
+Returns the centre of gravity of the superstructure (docked assembly) to which
+the vessel belongs, in coordinates of the local vessel frame.
+
+@function get_superstructurecg
+@treturn vector superstructure centre of gravity [<b>m</b>], or nil if the vessel is not part of a superstructure
+@see vessel:get_pmi
+*/
+int Interpreter::v_get_superstructurecg (lua_State *L)
+{
+	static const char *funcname = "get_superstructurecg";
+	AssertMtdMinPrmCount(L, 1, funcname);
+	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
+	VECTOR3 cg;
+	if (v->GetSuperstructureCG (cg)) lua_pushvector (L, cg);
+	else lua_pushnil (L);
+	return 1;
+}
+
+/***
+Get superstructure principal moments of inertia.
+
+Returns the mass-normalised moments of inertia of the superstructure (docked
+assembly) to which the vessel belongs, about its centre of gravity, for the
+axes of the local vessel frame.
+
+@function get_superstructurepmi
+@treturn vector superstructure moments of inertia [<b>m<sup>2</sup></b>], or nil if the vessel is not part of a superstructure
+@see vessel:get_superstructurecg, vessel:get_pmi
+*/
+int Interpreter::v_get_superstructurepmi (lua_State *L)
+{
+	static const char *funcname = "get_superstructurepmi";
+	AssertMtdMinPrmCount(L, 1, funcname);
+	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
+	VECTOR3 pmi;
+	if (v->GetSuperstructurePMI (pmi)) lua_pushvector (L, pmi);
+	else lua_pushnil (L);
+	return 1;
+}
+
 /***
 Get vessel cross sections.
 
@@ -1689,7 +1734,11 @@ Get position vector in global coordinates.
 Orbiter's global reference frame is the solar system's barycentric
 ecliptic frame at epoch J2000.0.
 
+If a vector `out` is provided, the result is written into it instead of
+creating a new vector.
+
 @function get_globalpos
+@param[opt] out (<i><b>@{types.vector|vector}</b></i>) vector receiving the result
 @return (<i><b>@{types.vector|vector}</b></i>) cartesian position vector [<b>m</b>]
 @see vessel:get_globalvel, vessel:get_relativepos
 */
@@ -1700,7 +1749,11 @@ int Interpreter::v_get_globalpos (lua_State *L)
 	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
 	VECTOR3 pos;
 	v->GetGlobalPos (pos);
-	lua_pushvector (L, pos);
+	if (lua_gettop (L) >= 2 && lua_isvector (L, 2)) {
+		lua_setvector (L, 2, pos);
+		lua_settop (L, 2);
+	} else
+		lua_pushvector (L, pos);
 	return 1;
 }
 
@@ -1710,7 +1763,11 @@ Get velocity vector in global coordinates.
 Orbiter's global reference frame is the solar system's barycentric
 ecliptic frame at epoch J2000.0.
 
+If a vector `out` is provided, the result is written into it instead of
+creating a new vector.
+
 @function get_globalvel
+@param[opt] out (<i><b>@{types.vector|vector}</b></i>) vector receiving the result
 @return (<i><b>@{types.vector|vector}</b></i>) cartesian velocity vector [<b>m/s</b>]
 @see vessel:get_globalpos, vessel:get_relativevel
 */
@@ -1721,7 +1778,11 @@ int Interpreter::v_get_globalvel (lua_State *L)
 	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
 	VECTOR3 vel;
 	v->GetGlobalVel (vel);
-	lua_pushvector (L, vel);
+	if (lua_gettop (L) >= 2 && lua_isvector (L, 2)) {
+		lua_setvector (L, 2, vel);
+		lua_settop (L, 2);
+	} else
+		lua_pushvector (L, vel);
 	return 1;
 }
 
@@ -1797,7 +1858,11 @@ local frame to the global frame and vice versa. Example:
 The global frame is defined by the ecliptic and equinox of J2000.0, with
 origin at the solar system's barycentre.
 
+If a matrix `out` is provided, the result is written into it instead of
+creating a new matrix.
+
 @function get_rotationmatrix
+@param[opt] out (<i><b>@{types.matrix|matrix}</b></i>) matrix receiving the result
 @return (<i><b>@{types.matrix|matrix}</b></i>) rotation matrix
 @see vessel:get_globalpos
 */
@@ -1808,7 +1873,11 @@ int Interpreter::v_get_rotationmatrix (lua_State *L)
 	VESSEL *v = lua_tovessel_safe(L, 1, funcname);
 	MATRIX3 rot;
 	v->GetRotationMatrix (rot);
-	lua_pushmatrix (L, rot);
+	if (lua_gettop (L) >= 2 && lua_ismatrix (L, 2)) {
+		lua_setmatrix (L, 2, rot);
+		lua_settop (L, 2);
+	} else
+		lua_pushmatrix (L, rot);
 	return 1;
 }
 
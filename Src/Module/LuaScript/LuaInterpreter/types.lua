@@ -6,14 +6,21 @@
 
 --- A 3D cartesian vector.
 --
--- Any 3-D vectors passed into or returned from Orbiter API script functions conform to the following convention:
--- A vector is defined as a table containing three numerical fields with keys "x", "y" and "z". (Vectors passed as arguments to API functions can have additional fields, which are ignored by the interpreter).
--- Vectors can be defined and initialised by normal Lua syntax, or with the _V(x, y, z) function to mimic C++ syntax.
+-- Vectors returned from Orbiter API script functions are userdata objects with the numerical fields "x", "y" and "z".
+-- They support the operators +, -, * and / (elementwise, or combined with a number), unary minus and ==.
+-- Vectors passed as arguments to API functions can also be tables containing three numerical fields with keys
+-- "x", "y" and "z". (Additional fields are ignored by the interpreter).
+-- Vectors can be defined and initialised by normal Lua syntax, with vec.set(x, y, z), or with the _V(x, y, z)
+-- function to mimic C++ syntax.
+-- To avoid creating new objects in code that runs every frame, use the in-place functions of the vec and mat
+-- libraries (vec.add_to, mat.mul_to, etc.), which write their result into an existing vector.
 -- @usage
 -- V1 = {x=1,y=0,z=-1}
 -- V2 = {}; V2.x=0; V2.y=1.1; V2.z=-16
 -- V3 = {}; V3["x"]=15; V3["y"]=-3.145; V3["z"]=1e3
 -- V4 = _V(1, 0, -1)
+-- V5 = vec.set(1, 0, -1) * 2 + V1
+-- vec.add_to(V5, V5, V4)
 -- @field x x-component [m]
 -- @field y y-component [m]
 -- @field z z-component [m]
@@ -26,10 +33,11 @@
 --	m21 m22 m23
 --	m31 m32 m33
 --
--- Any 3x3 matrices passed into or returned from Orbiter API script functions conform to the following convention:
--- A matrix is defined as a table containing nine numerical fields with keys "m11", "m12", "m13",
--- "m21", "m22", "m23", "m31", "m32", "m33".
--- (Matrices passed as arguments to API functions can have additional fields, which are ignored by the interpreter).
+-- Matrices returned from Orbiter API script functions are userdata objects with the nine numerical fields
+-- "m11", "m12", "m13", "m21", "m22", "m23", "m31", "m32", "m33". They support the * operator for
+-- matrix-vector and matrix-matrix products, and ==.
+-- Matrices passed as arguments to API functions can also be tables containing these nine fields.
+-- (Additional fields are ignored by the interpreter).
 -- Matrices can be defined and initialised by normal Lua syntax, or with the _M(...) function to mimic C++ syntax.
 -- @usage
 -- M1 = {m11=1,m12=0,m13=0,m21=0,m22=1,m23=0,m31=0,m32=0,m33=1}
@@ -0,0 +1,181 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class AirfoilTable
+// =======================================================================
+
+#include "AirfoilTable.h"
+#include <string>
+#include <string.h>
+
+using namespace std;
+
+static const double Pi = 3.14159265358979323846;
+
+// 1 deg AoA resolution, Mach 0-30 (0.03 spacing at M=1, 2.3 at M=25), Re 1e3-1e10
+const AirfoilTable::Grid AirfoilTable::DefaultGrid = {361, 30.0, 141, 3.0, 10.0, 8};
+const double AirfoilTable::MACHSCALE = 2.0;
+
+// -----------------------------------------------------------------------
+
+void AirfoilTable::Axis::Set (double _x0, double _x1, int _n)
+{
+	x0 = _x0, x1 = _x1, n = (_n > 1 ? _n : 1);
+	scale = (n > 1 && x1 > x0 ? (n-1)/(x1-x0) : 0.0);
+	if (!scale) n = 1;
+}
+
+// -----------------------------------------------------------------------
+
+AirfoilTable::AirfoilTable ()
+{
+	grid = DefaultGrid;
+	for (int i = 0; i < 3; i++) {
+		ax[i].Set (0, 0, 1);
+		ax[i].stride = 0;
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void AirfoilTable::SetStrides ()
+{
+	int s = 3;
+	for (int i = 0; i < 3; i++) {
+		ax[i].stride = (ax[i].n > 1 ? s : 0);
+		s *= ax[i].n;
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void AirfoilTable::Sample (const CoeffFunc &cf, const Grid &g)
+{
+	grid = g;
+	ax[0].Set (-Pi, Pi, g.naoa);
+	ax[1].Set (0.0, MachVar (g.mmax), g.nmach);
+	ax[2].Set (g.lgre0, g.lgre1, g.nre);
+	int n0 = ax[0].n, n1 = ax[1].n, n2 = ax[2].n;
+
+	vector<double> v ((size_t)n0*n1*n2*3);
+	double *p = v.data();
+	for (int i2 = 0; i2 < n2; i2++) {
+		double Re = pow (10.0, ax[2].Node (i2));
+		for (int i1 = 0; i1 < n1; i1++) {
+			double M = MachVal (ax[1].Node (i1));
+			for (int i0 = 0; i0 < n0; i0++, p += 3)
+				cf (ax[0].Node (i0), M, Re, p, p+1, p+2);
+		}
+	}
+
+	// collapse the Re and Mach axes if the coefficients don't depend on them
+	auto same = [](const double *a, const double *b, size_t n) {
+		for (size_t i = 0; i < n; i++)
+			if (fabs (a[i]-b[i]) > 1e-9*(1.0+fabs(a[i]))) return false;
+		return true;
+	};
+	size_t slice = (size_t)n0*n1*3;
+	bool collapse = (n2 > 1);
+	for (int i2 = 1; i2 < n2 && collapse; i2++)
+		collapse = same (v.data(), v.data()+i2*slice, slice);
+	if (collapse) {
+		v.resize (slice);
+		ax[2].n = 1, n2 = 1;
+	}
+	size_t row = (size_t)n0*3;
+	collapse = (n1 > 1);
+	for (int i2 = 0; i2 < n2 && collapse; i2++)
+		for (int i1 = 1; i1 < n1 && collapse; i1++)
+			collapse = same (v.data()+i2*slice, v.data()+i2*slice+i1*row, row);
+	if (collapse) {
+		for (int i2 = 0; i2 < n2; i2++)
+			memmove (v.data()+i2*row, v.data()+i2*slice, row*sizeof(double));
+		v.resize (row*n2);
+		ax[1].n = 1;
+	}
+
+	val.assign (v.begin(), v.end());
+	SetStrides ();
+}
+
+// -----------------------------------------------------------------------
+
+void AirfoilTable::Validate (const CoeffFunc &cf, Error &err) const
+{
+	// test points: cell centres of the sampling grid (the range centre for
+	// axes with a single node)
+	Axis a[3];
+	a[0].Set (-Pi, Pi, grid.naoa);
+	a[1].Set (0.0, MachVar (grid.mmax), grid.nmach);
+	a[2].Set (grid.lgre0, grid.lgre1, grid.nre);
+	auto centre = [](const Axis &x, int i) { return (x.n > 1 ? x.x0 + (i+0.5)/x.scale : 0.5*(x.x0+x.x1)); };
+	int nc[3];
+	for (int i = 0; i < 3; i++) nc[i] = (a[i].n > 1 ? a[i].n-1 : 1);
+
+	double sum2[3] = {0.0, 0.0, 0.0};
+	memset (&err, 0, sizeof(Error));
+	for (int i2 = 0; i2 < nc[2]; i2++) {
+		double Re = pow (10.0, centre (a[2], i2));
+		for (int i1 = 0; i1 < nc[1]; i1++) {
+			double M = MachVal (centre (a[1], i1));
+			for (int i0 = 0; i0 < nc[0]; i0++) {
+				double aoa = centre (a[0], i0);
+				double c0[3], c1[3];
+				cf (aoa, M, Re, c0, c0+1, c0+2);
+				Eval (aoa, M, Re, c1, c1+1, c1+2);
+				for (int k = 0; k < 3; k++) {
+					double d = fabs (c1[k]-c0[k]);
+					sum2[k] += d*d;
+					if (d > err.maxerr[k]) {
+						err.maxerr[k] = d;
+						err.aoa[k] = aoa, err.M[k] = M, err.Re[k] = Re;
+					}
+				}
+				err.nsample++;
+			}
+		}
+	}
+	for (int k = 0; k < 3; k++)
+		err.rmserr[k] = (err.nsample ? sqrt (sum2[k]/err.nsample) : 0.0);
+}
+
+// -----------------------------------------------------------------------
+
+bool AirfoilTable::Read (istream &is)
+{
+	string item;
+	Grid g;
+	if (!(is >> item) || item != "AOA" || !(is >> g.naoa)) return false;
+	if (!(is >> item) || item != "MACH" || !(is >> g.mmax >> g.nmach)) return false;
+	if (!(is >> item) || item != "LOGRE" || !(is >> g.lgre0 >> g.lgre1 >> g.nre)) return false;
+	if (g.naoa < 1 || g.nmach < 1 || g.nre < 1) return false;
+
+	grid = g;
+	ax[0].Set (-Pi, Pi, g.naoa);
+	ax[1].Set (0.0, MachVar (g.mmax), g.nmach);
+	ax[2].Set (g.lgre0, g.lgre1, g.nre);
+	size_t n = (size_t)ax[0].n*ax[1].n*ax[2].n*3;
+	val.resize (n);
+	for (size_t i = 0; i < n; i++)
+		if (!(is >> val[i])) {
+			val.clear();
+			return false;
+		}
+	SetStrides ();
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+void AirfoilTable::Write (ostream &os) const
+{
+	// the stored node counts are written, so collapsed axes stay collapsed
+	os << "AOA " << ax[0].n << '\n';
+	os << "MACH " << grid.mmax << ' ' << ax[1].n << '\n';
+	os << "LOGRE " << grid.lgre0 << ' ' << grid.lgre1 << ' ' << ax[2].n << '\n';
+	streamsize prec = os.precision (9);
+	for (size_t i = 0; i < val.size(); i += 3)
+		os << val[i] << ' ' << val[i+1] << ' ' << val[i+2] << '\n';
+	os.precision (prec);
+}
@@ -0,0 +1,129 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class AirfoilTable
+// Tabulated airfoil coefficients (lift CL, moment Cm, drag CD) on a
+// regular grid over angle of attack, Mach number and Reynolds number,
+// evaluated by trilinear interpolation. Used in place of a vessel's
+// airfoil coefficient callback when the vessel opts in (see
+// Vessel::TabulateAirfoil).
+// Grid axes: AoA is uniform over [-pi,pi], Mach number is uniform in
+// M/(M+2) over [0,Mmax], so that the transonic range is sampled more
+// densely than the hypersonic range, and Reynolds number is uniform in
+// log10(Re). Axes on which the coefficients do not depend are collapsed
+// to a single node when sampling.
+// =======================================================================
+
+#ifndef __AIRFOILTABLE_H
+#define __AIRFOILTABLE_H
+
+#include <functional>
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+class AirfoilTable {
+public:
+	struct Grid {
+		int naoa;             // number of AoA nodes over [-pi,pi]
+		double mmax;          // upper Mach number limit
+		int nmach;            // number of Mach nodes over [0,mmax]
+		double lgre0, lgre1;  // log10(Re) range
+		int nre;              // number of Reynolds number nodes
+	};
+	static const Grid DefaultGrid;
+
+	typedef std::function<void(double aoa, double M, double Re, double *cl, double *cm, double *cd)> CoeffFunc;
+	// Coefficient function in the form of AirfoilCoeffFunc
+
+	struct Error {
+		double maxerr[3];     // max. absolute error of CL, Cm, CD
+		double rmserr[3];     // rms error of CL, Cm, CD
+		double aoa[3], M[3], Re[3]; // location of the max. error
+		size_t nsample;       // number of test points
+	};
+
+	AirfoilTable ();
+
+	void Sample (const CoeffFunc &cf, const Grid &grid = DefaultGrid);
+	// Tabulate cf over grid. Axes on which cf does not depend are collapsed.
+
+	void Validate (const CoeffFunc &cf, Error &err) const;
+	// Compare the interpolated coefficients with cf at the centres of all
+	// grid cells of the sampling grid, where the interpolation error of a
+	// smooth function is largest.
+
+	inline bool Empty () const { return val.empty(); }
+	inline int nNode (int axis) const { return ax[axis].n; }
+	// Number of nodes along an axis (0=AoA, 1=Mach, 2=Re) of the stored table
+
+	inline void Eval (double aoa, double M, double Re, double *cl, double *cm, double *cd) const;
+	// Interpolated coefficients at the given flow parameters. Parameters
+	// outside the grid are clamped to its boundary.
+
+	bool Read (std::istream &is);
+	void Write (std::ostream &os) const;
+	// Read/write the table in text format: the lines "AOA <n>",
+	// "MACH <mmax> <n>" and "LOGRE <lgre0> <lgre1> <n>" are followed by
+	// one line "CL Cm CD" per node (AoA varies fastest, then Mach, then Re).
+
+private:
+	struct Axis {
+		double x0, x1;        // range (in the transformed variable)
+		int n;                // number of nodes
+		int stride;           // node stride in val (0 if n == 1)
+		double scale;         // (n-1)/(x1-x0)
+		void Set (double _x0, double _x1, int _n);
+		inline double Node (int i) const { return (n > 1 ? x0 + i/scale : 0.5*(x0+x1)); }
+		inline void Locate (double x, int &i, double &f) const
+		{
+			double t = (x-x0)*scale;
+			if (t <= 0.0) i = 0, f = 0.0;
+			else if (t >= n-1) i = (n > 1 ? n-2 : 0), f = (n > 1 ? 1.0 : 0.0);
+			else i = (int)t, f = t-i;
+		}
+	};
+
+	static inline double MachVar (double M) { return (M > 0.0 ? M/(M+MACHSCALE) : 0.0); }
+	static inline double MachVal (double u) { return MACHSCALE*u/(1.0-u); }
+	static const double MACHSCALE;
+	static inline double ReVar (double Re) { return log10 (Re > 1.0 ? Re : 1.0); }
+	void SetStrides ();
+
+	Grid grid;                // sampling grid
+	Axis ax[3];               // 0=AoA, 1=M/(M+2), 2=log10(Re)
+	std::vector<float> val;   // CL,Cm,CD per node
+};
+
+// =======================================================================
+// Inline functions
+
+inline void AirfoilTable::Eval (double aoa, double M, double Re, double *cl, double *cm, double *cd) const
+{
+	// the Mach and Re axes are often collapsed, in which case their
+	// transformation and interpolation is skipped
+	int i0, i1 = 0, i2 = 0;
+	double f0, f1 = 0.0, f2 = 0.0;
+	ax[0].Locate (aoa, i0, f0);
+	const int s0 = ax[0].stride, s1 = ax[1].stride, s2 = ax[2].stride;
+	if (s1) ax[1].Locate (MachVar (M), i1, f1);
+	if (s2) ax[2].Locate (ReVar (Re), i2, f2);
+	const float *p = val.data() + i0*s0 + i1*s1 + i2*s2;
+	double c[3];
+	for (int k = 0; k < 3; k++) {
+		const float *q = p+k;
+		double a = q[0] + f0*(q[s0]-q[0]);                      // AoA
+		if (s1) a += f1*(q[s1] + f0*(q[s1+s0]-q[s1]) - a);      // Mach
+		if (s2) {                                               // Re
+			const float *r = q+s2;
+			double b = r[0] + f0*(r[s0]-r[0]);
+			if (s1) b += f1*(r[s1] + f0*(r[s1+s0]-r[s1]) - b);
+			a += f2*(b-a);
+		}
+		c[k] = a;
+	}
+	*cl = c[0], *cm = c[1], *cd = c[2];
+}
+
+#endif // !__AIRFOILTABLE_H
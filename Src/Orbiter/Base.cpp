@@ -44,7 +44,8 @@ Base::Base (char *fname, Planet *_planet, double _lng, double _lat)
 	int texid = 0, bias = 0;
 	//visual = 0;
 	sundir.Set(0,-1,0);
-	sundir_updt = 0.0;
+	bLazyState = true;
+	s1 = s0;                       // bases don't take part in the update phase
 
 	InitDeviceObjects ();
 
@@ -293,6 +294,7 @@ void Base::Setup ()
 	if (elev) {
 		rad += elev;
 		cbody->EquatorialToLocal (lng, lat, rad, rpos);
+		planetseq = (size_t)-1; // force state update
 	}
 
 	for (DWORD i = 0; i < nobj; i++)
@@ -381,6 +383,7 @@ void Base::Attach (Planet *_parent)
 
 	double v = Pi2*rad*clat / cbody->RotT(); // surface velocity
 	rotvel.Set (-v*slng, 0.0, v*clng);        // velocity vector in non-rotating planet coords
+	planetseq = (size_t)-1;
 }
 
 DWORD Base::GetTileList (const SurftileSpec **_tile) const
@@ -529,23 +532,33 @@ void Base::ScanObjectMeshes () const
 	objmsh_valid = true;
 }
 
-void Base::Update (bool force)
+void Base::SyncState () const
 {
-	s1->R.Set (rrot);
-	s1->R.premul (cbody->s1->R);
-	s1->Q.Set (s1->R);
+	// The sequence number is published only after the state has been
+	// written, so that concurrent callers either find the state up to date,
+	// or wait for the sync in progress
+	size_t seq = cbody->StateSeq();
+	if (planetseq.load (std::memory_order_acquire) == seq) return;
+	std::lock_guard<std::mutex> lock (syncmutex);
+	if (planetseq.load (std::memory_order_relaxed) == seq) return;
+
+	const Matrix &prot = cbody->GRot();
+	s0->R.Set (rrot);
+	s0->R.premul (prot);
+	s0->Q.Set (s0->R);
 	// WARNING: this should work the other way round: combine the
 	// two quaternions and extract grot
 
-	s1->pos.Set (mul (cbody->s1->R, rpos) + cbody->s1->pos);
-	s1->vel.Set (mul (cbody->s1->R, rotvel) + cbody->s1->vel);
+	s0->pos.Set (mul (prot, rpos) + cbody->GPos());
+	s0->vel.Set (mul (prot, rotvel) + cbody->GVel());
+	planetseq.store (seq, std::memory_order_release);
+}
 
-	// periodically update some secondary parameters
-	if (td.SimT1 > sundir_updt || force) {
-		sundir = SunDirection();
-		double csun = sundir.y;
-		sundir_updt = td.SimT1 + (csun < -0.1 ? 50.0 : csun > 0.1 ? 10.0 : 2.0);
-	}
+double Base::UpdateSunDirection ()
+{
+	sundir = SunDirection();
+	double csun = sundir.y;
+	return td.SimT1 + (csun < -0.1 ? 50.0 : csun > 0.1 ? 10.0 : 2.0);
 }
 
 void Base::Rel_EquPos (const Vector &relpos, double &_lng, double &_lat) const
@@ -729,5 +742,7 @@ int Base::ReportTouchdown (VesselBase *vessel, double vlng, double vlat)
 
 double Base::CosSunAlt () const
 {
-	return (s0->R.m12*s0->pos.x + s0->R.m22*s0->pos.y + s0->R.m32*s0->pos.z) / (-s0->pos.length());
+	const Matrix &R = GRot();
+	const Vector &p = GPos();
+	return (R.m12*p.x + R.m22*p.y + R.m32*p.z) / (-p.length());
 }
@@ -9,6 +9,8 @@
 
 #include "Body.h"
 #include "Nav.h"
+#include <atomic>
+#include <mutex>
 
 class Planet;
 class PlanetarySystem;
@@ -50,7 +52,10 @@ public:
 
 	void Setup();
 
-	virtual void Update (bool force = false);
+	double UpdateSunDirection ();
+	// Refresh the buffered sun direction (see SunDirectionBuffered) and
+	// return the simulation time at which it should be refreshed next.
+	// Called by the planetary system's base update scheduler.
 
 	virtual void Attach (Planet *_parent);
 	// Add *this as a child to "_parent"
@@ -62,6 +67,9 @@ public:
 	{ _lng = lng, _lat = lat; }
 	// Return equatoral coordinates
 
+	inline const Vector &PlanetPos () const { return rpos; }
+	// Return base position in local planet frame
+
 	inline double Elevation() const { return elev; }
 	// Return mean base elevation
 
@@ -120,7 +128,7 @@ public:
 	// the sun (which is assumed in the centre of the global coord system)
 
 	inline Vector SunDirection () const
-	{ return (s1 ? tmul(s1->R, -s1->pos.unit()) : tmul (s0->R, -s0->pos.unit())); }
+	{ return tmul (GRot(), -GPos().unit()); }
 	// Return vector pointing towards sun (= world coordiate origin) in
 	// base local coordinates
 
@@ -167,6 +175,13 @@ public:
 	void DestroyDeviceObjects ();
 	// Load and free textures required by the planet's visual
 
+protected:
+	void SyncState () const;
+	// Base state vectors are not propagated in the update phase, but
+	// derived from the planet state when first accessed after the planet
+	// has moved. Safe to call concurrently (e.g. from the vessel
+	// propagation threads).
+
 private:
 	//const Planet *planet;
 	double rad, lng, lat;          // equatorial coords of the base
@@ -176,6 +191,8 @@ private:
 	double objscale;               // size of "typical" base object (for camera-distance dependent render cutoff)
 	bool bObjmapsphere;            // map base objects onto spherical planet surface?
 	Vector rotvel;                 // base velocity as result of planet rotation in local planet coords (rotvel.y=0)
+	mutable std::atomic<size_t> planetseq; // planet state sequence number at last state sync
+	mutable std::mutex syncmutex;  // serialises state syncs
 
 	DWORD npad;                    // number of landing pads
 	int padfree;                   // number of available (unoccupied) pads
@@ -205,7 +222,6 @@ private:
 	DWORD ntile;                   // number of surface tiles
 
 	Vector sundir;                 // sun direction in base coordinates
-	double sundir_updt;            // time of next buffered sun direction update
 
 	// common resources
 	static char **generic_mesh_name;         // list of names for generic meshes
@@ -0,0 +1,168 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class FrameBench
+// =======================================================================
+
+#include "Bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <new>
+
+using namespace std;
+
+FrameBench *g_bench = 0;
+
+// -----------------------------------------------------------------------
+// Heap allocation counter
+// Only compiled into benchmark builds (CMake option ORBITER_BENCH_ALLOC),
+// since it replaces the global allocator. The replacement operators belong
+// to the Orbiter executable, so allocations inside plugin and vessel
+// modules are not counted. Counting is only enabled while a FrameBench
+// exists.
+
+static std::atomic<bool> s_countAlloc (false);
+static std::atomic<uint64_t> s_nalloc (0), s_allocsize (0);
+
+#ifdef ORBITER_BENCH_ALLOC
+void *operator new (size_t size)
+{
+	if (s_countAlloc.load (std::memory_order_relaxed)) {
+		s_nalloc.fetch_add (1, std::memory_order_relaxed);
+		s_allocsize.fetch_add (size, std::memory_order_relaxed);
+	}
+	void *p = malloc (size ? size : 1);
+	if (!p) throw std::bad_alloc();
+	return p;
+}
+
+void operator delete (void *p) noexcept
+{
+	free (p);
+}
+
+void operator delete (void *p, size_t) noexcept
+{
+	free (p);
+}
+#endif // ORBITER_BENCH_ALLOC
+
+// -----------------------------------------------------------------------
+
+static void WriteString (FILE *f, const char *str)
+{
+	fputc ('"', f);
+	for (const char *c = str; *c; c++) {
+		if (*c == '"' || *c == '\\') fputc ('\\', f);
+		if ((unsigned char)*c >= 0x20) fputc (*c, f);
+	}
+	fputc ('"', f);
+}
+
+static void WriteStat (FILE *f, const char *name, double sum, double max, size_t n, double scale, const char *unit)
+{
+	fprintf (f, "\"%s\": {\"total_%s\": %0.3f, \"mean_%s\": %0.3f, \"max_%s\": %0.3f}",
+		name, unit, sum*scale, unit, n ? sum*scale/n : 0.0, unit, max*scale);
+}
+
+// -----------------------------------------------------------------------
+
+FrameBench::FrameBench ()
+{
+	for (int i = 0; i < NPHASE; i++) cur[i] = 0.0;
+	running = -1;
+	nalloc0 = allocsize0 = 0;
+	tstart = tframe = tphase = Clock::now();
+	s_countAlloc = true;
+}
+
+FrameBench::~FrameBench ()
+{
+	s_countAlloc = false;
+}
+
+void FrameBench::BeginFrame ()
+{
+	for (int i = 0; i < NPHASE; i++) cur[i] = 0.0;
+	running = -1;
+	nalloc0 = s_nalloc.load();
+	allocsize0 = s_allocsize.load();
+	tframe = Clock::now();
+}
+
+void FrameBench::EndFrame ()
+{
+	End ();
+	frame.Add (chrono::duration<double>(Clock::now() - tframe).count());
+	for (int i = 0; i < NPHASE; i++) phase[i].Add (cur[i]);
+	nalloc.Add ((double)(s_nalloc.load() - nalloc0));
+	allocsize.Add ((double)(s_allocsize.load() - allocsize0));
+	for (auto it = vessel.begin(); it != vessel.end(); it++)
+		if (it->second.cur) {
+			it->second.t.Add (it->second.cur);
+			it->second.cur = 0.0;
+		}
+}
+
+void FrameBench::Begin (Phase ph)
+{
+	Clock::time_point t = Clock::now();
+	if (running >= 0) cur[running] += chrono::duration<double>(t - tphase).count();
+	running = ph;
+	tphase = t;
+}
+
+void FrameBench::End ()
+{
+	if (running >= 0) {
+		cur[running] += chrono::duration<double>(Clock::now() - tphase).count();
+		running = -1;
+	}
+}
+
+void FrameBench::AddVessel (const char *name, double t)
+{
+	vessel[name].cur += t;
+}
+
+bool FrameBench::Write (const char *fname, const char *scenario, double step) const
+{
+	static const char *phasename[NPHASE] = {
+		"ModulePreStep", "CelestialUpdate", "VesselForces", "Propagation", "ModulePostStep", "KillVessels"
+	};
+	FILE *f = fopen (fname, "wt");
+	if (!f) return false;
+
+	double tphase = 0.0;
+	for (int i = 0; i < NPHASE; i++) tphase += phase[i].sum;
+
+	fprintf (f, "{\n  \"scenario\": ");
+	WriteString (f, scenario);
+	fprintf (f, ",\n  \"frames\": %zu,\n  \"step\": %0.6g,\n", frame.n, step);
+	fprintf (f, "  \"wall_time_s\": %0.3f,\n", chrono::duration<double>(Clock::now() - tstart).count());
+	fprintf (f, "  ");
+	WriteStat (f, "frame", frame.sum, frame.max, frame.n, 1e3, "ms");
+	fprintf (f, ",\n  \"phases\": {\n");
+	for (int i = 0; i < NPHASE; i++) {
+		fprintf (f, "    ");
+		WriteStat (f, phasename[i], phase[i].sum, phase[i].max, phase[i].n, 1e3, "ms");
+		fprintf (f, ",\n");
+	}
+	fprintf (f, "    \"Other\": {\"total_ms\": %0.3f}\n  },\n", (frame.sum - tphase)*1e3);
+	fprintf (f, "  \"vessels\": [");
+	for (auto it = vessel.begin(); it != vessel.end(); it++) {
+		fprintf (f, "%s\n    {\"name\": ", it == vessel.begin() ? "" : ",");
+		WriteString (f, it->first.c_str());
+		fprintf (f, ", \"frames\": %zu, \"total_ms\": %0.3f, \"mean_us\": %0.3f, \"max_us\": %0.3f}",
+			it->second.t.n, it->second.t.sum*1e3, it->second.t.n ? it->second.t.sum*1e6/it->second.t.n : 0.0, it->second.t.max*1e6);
+	}
+	fprintf (f, "\n  ]");
+#ifdef ORBITER_BENCH_ALLOC
+	fprintf (f, ",\n  \"allocations\": {\"total\": %0.0f, \"mean_per_frame\": %0.6g, \"max_per_frame\": %0.0f, \"mean_bytes_per_frame\": %0.6g}",
+		nalloc.sum, nalloc.n ? nalloc.sum/nalloc.n : 0.0, nalloc.max, allocsize.n ? allocsize.sum/allocsize.n : 0.0);
+#endif
+	fprintf (f, "\n}\n");
+	return fclose (f) == 0;
+}
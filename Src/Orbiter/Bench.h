@@ -0,0 +1,87 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class FrameBench
+// Frame timing statistics for benchmark runs (command line option
+// --bench=<file>). Records the wall time of the phases of each simulation
+// frame, the propagation cost of each vessel and, in builds with the CMake
+// option ORBITER_BENCH_ALLOC, the number of heap allocations per frame, and
+// writes a summary in JSON format at the end of the session.
+// =======================================================================
+
+#ifndef __BENCH_H
+#define __BENCH_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <stdint.h>
+
+class FrameBench {
+public:
+	enum Phase {
+		PH_PRESTEP,      // module and vessel pre-step callbacks
+		PH_CELESTIAL,    // celestial body updates
+		PH_FORCES,       // vessel body forces and supervessel updates
+		PH_PROPAGATION,  // vessel state propagation
+		PH_POSTSTEP,     // module and vessel post-step callbacks
+		PH_KILL,         // removal of deleted vessels
+		NPHASE
+	};
+
+	FrameBench ();
+	~FrameBench ();
+
+	void BeginFrame ();
+	void EndFrame ();
+	// Frame boundaries. Phase and vessel times are collected per frame.
+
+	void Begin (Phase ph);
+	// Start timing phase ph. Ends the phase currently being timed, if any.
+
+	void End ();
+	// End the phase currently being timed
+
+	void AddVessel (const char *name, double t);
+	// Add propagation time t [s] for a vessel to the current frame.
+	// May be called from worker threads only if distinct threads never
+	// pass the same vessel, and never concurrently with BeginFrame/EndFrame.
+
+	bool Write (const char *fname, const char *scenario, double step) const;
+	// Write the statistics to file fname. step: fixed step length [s]
+
+	inline size_t nFrame () const { return frame.n; }
+
+private:
+	typedef std::chrono::steady_clock Clock;
+
+	struct Stat {        // per-frame statistics of a quantity
+		double sum, max;
+		size_t n;
+		Stat (): sum(0.0), max(0.0), n(0) {}
+		void Add (double v) { sum += v; if (v > max) max = v; n++; }
+	};
+	struct VesselStat {
+		Stat t;          // propagation time per frame [s]
+		double cur;      // time in current frame [s]
+		VesselStat (): cur(0.0) {}
+	};
+
+	Stat phase[NPHASE];  // phase times per frame [s]
+	Stat frame;          // frame times [s]
+	Stat nalloc;         // allocations per frame
+	Stat allocsize;      // allocated bytes per frame
+	std::map<std::string, VesselStat> vessel;
+
+	double cur[NPHASE];  // phase times in current frame [s]
+	int running;         // phase currently being timed (-1: none)
+	Clock::time_point tphase;  // start of current phase
+	Clock::time_point tframe;  // start of current frame
+	Clock::time_point tstart;  // start of benchmark
+	uint64_t nalloc0, allocsize0; // allocation counters at frame start
+};
+
+extern FrameBench *g_bench; // frame statistics (NULL if not in benchmark mode)
+
+#endif // !__BENCH_H
@@ -96,6 +96,7 @@ void Body::RPlace (const Vector &rpos, const Vector &rvel)
 	rpos_add.Set (0,0,0);
 	s1->vel = rvel_base = rvel;
 	rvel_add.Set (0,0,0);
+	stateseq++;
 }
 
 void Body::SetRPos (const Vector &p)
@@ -170,4 +171,5 @@ void Body::EndStateUpdate ()
 {
 	// disable the update state, to avoid it being addressed outside the update phase
 	s1 = s0 = (s0 == sv ? sv + 1 : sv);
+	stateseq++;
 }
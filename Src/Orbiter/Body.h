@@ -54,13 +54,21 @@ public:
 	inline const Vector &Albedo () const { return albedo; }
 	// object albedo (RGB, 0-1)
 
-	inline const Vector &GPos() const { return s0->pos; }
-	inline const Vector &GVel() const { return s0->vel; }
-	inline const Matrix &GRot() const { return s0->R; }
-	inline const Quaternion &GQ() const { return s0->Q; }
+	inline const Vector &GPos() const { if (bLazyState) SyncState(); return s0->pos; }
+	inline const Vector &GVel() const { if (bLazyState) SyncState(); return s0->vel; }
+	inline const Matrix &GRot() const { if (bLazyState) SyncState(); return s0->R; }
+	inline const Quaternion &GQ() const { if (bLazyState) SyncState(); return s0->Q; }
 	// Object position, velocity and orientation in global coords. To transform
 	// a point between local object coords p_loc and global coords p_glob:
 	// p_glob = GRot * p_loc + GPos
+	// For bodies with lazily evaluated state (see SyncState), these are the
+	// only valid way to access the current state. SyncState implementations
+	// must be safe to call concurrently, since the accessors are used by the
+	// vessel propagation threads.
+
+	inline size_t StateSeq() const { return stateseq; }
+	// State sequence number. Changes whenever the body's state vectors are
+	// replaced (at the end of each update phase, or on RPlace)
 
 	void SetRPos (const Vector &p);
 	void AddRPos (const Vector &dp);
@@ -71,15 +79,15 @@ public:
 	void FlushRVel ();
 
 	inline Vector GlobalToLocal (const Vector &glob) const
-	{ return tmul (s0->R, glob - s0->pos); }
+	{ return tmul (GRot(), glob - GPos()); }
 	// Convert global position glob into body's local coordinate system
 
 	inline void GlobalToLocal (const Vector &glob, Vector &loc) const
-	{ loc.Set (tmul (s0->R, glob - s0->pos)); }
+	{ loc.Set (tmul (GRot(), glob - GPos())); }
 	// same with different interface
 
 	inline void LocalToGlobal (const Vector &loc, Vector &glob) const
-	{ glob.Set (mul (s0->R, loc) + s0->pos); }
+	{ glob.Set (mul (GRot(), loc) + GPos()); }
 
 	void LocalToEquatorial (const Vector &loc, double &lng, double &lat, double &rad) const;
 	inline void GlobalToEquatorial (const Vector &glob, double &lng, double &lat, double &rad) const
@@ -163,6 +171,14 @@ public:
 	inline const Vector &Acceleration() const { return acc; };
 
 protected:
+	virtual void SyncState () const {}
+	// Bring s0 up to date. Only called if bLazyState is set, for bodies whose
+	// state is derived from another body and computed on demand rather than
+	// in every update phase. Must be thread-safe (see GPos).
+
+	bool bLazyState { false };   // state is evaluated on demand (see SyncState)
+	size_t stateseq { 0 };       // state sequence number (see StateSeq)
+
 	double mass { 0.0 };         // current body mass [kg]
 	double size { 0.0 };         // (mean) body radius [m]
 	Vector albedo { 1, 1, 1 };   // object albedo (RGB, 0-1)
@@ -43,10 +43,17 @@
 #include "Orbiter.h"
 #include "Rigidbody.h"
 #include "Element.h"
+#include "Psys.h"
+#include "Planet.h"
 #include "Log.h"
+#include "RKAdaptive.h"
+#include "ConicCoast.h"
 #include <stdio.h>
+#include <algorithm>
 
+extern Orbiter *g_pOrbiter;
 extern TimeData td;
+extern PlanetarySystem *g_psys;
 extern char DBG_MSG[256];
 
 // ===========================================================================
@@ -120,31 +127,8 @@ static const double RK7_gamma[RK7_n] = {
 	41.0/840.0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 41.0/840.0
 };
 
-// ---------------------------------------------------------------------------
-// RK8 13-stage parameters
-// ---------------------------------------------------------------------------
-
-static const int RK8_n = 13;
-static const double RK8_alpha[RK8_n-1] = {
-	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0, 0, 1.0
-};
-static const double RK8_beta[(RK8_n-1)*(RK8_n-1)] = {
-	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0, 0, 0,
-	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0, 0, 0,
-	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0, 0, 0,
-	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0, 0, 0,
-	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0, 0, 0,
-	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0, 0, 0,
-	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0, 0, 0,
-	3.0/205.0, 0, 0, 0, 0, -6.0/41.0, -3.0/205.0, -3.0/41.0, 3.0/41.0, 6.0/41.0, 0, 0,
-	-1777.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -289.0/82.0, 2193.0/4100.0, 51.0/82.0, 33.0/164.0, 12.0/41.0, 0, 1.0
-};
-static const double RK8_gamma[RK8_n] = {
-	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
-};
+// RK8 13-stage parameters: the 8th order solution of the Runge-Kutta-Fehlberg
+// 7(8) pair (RK_RKF78, see RKAdaptive.cpp)
 
 // ===========================================================================
 // Propagators for linear and angular state vectors combined
@@ -213,27 +197,18 @@ void RigidBody::RK4_LinAng (double h, int nsub, int isub)
 
 // ---------------------------------------------------------------------------
 // Driver routine for Runge-Kutta solvers RK5-RK8 (linear+angular)
-// Note: NOT THREADSAFE
+// Stage buffers are local, so bodies can be propagated concurrently
 // ---------------------------------------------------------------------------
 
 void RigidBody::RKdrv_LinAng (double h, int nsub, int isub, int n, const double *alpha, const double *beta, const double *gamma)
 {
 	int i, j;
 	double bh;
-	static int nbuf = 8;
-	static StateVectors *s = new StateVectors[nbuf]; TRACENEW
-	static Vector *a       = new Vector[nbuf]; TRACENEW  // linear acceleration
-	static Vector *d       = new Vector[nbuf]; TRACENEW  // angular acceleration
+	StateVectors s[RK_MAXSTAGE];
+	Vector a[RK_MAXSTAGE];       // linear acceleration
+	Vector d[RK_MAXSTAGE];       // angular acceleration
 	Vector tau;
-	if (n > nbuf) { // grow buffers
-		delete []s;
-		delete []a;
-		delete []d;
-		s = new StateVectors[n]; TRACENEW
-		a = new Vector[n]; TRACENEW
-		d = new Vector[n]; TRACENEW
-		nbuf = n;
-	}
+	dASSERT(n <= RK_MAXSTAGE, "Too many Runge-Kutta stages");
 
 	s[0].Set (s1->vel, s1->pos, s1->omega, s1->Q);
 	a[0].Set (acc);
@@ -289,9 +264,106 @@ void RigidBody::RK7_LinAng (double h, int nsub, int isub)
 
 void RigidBody::RK8_LinAng (double h, int nsub, int isub)
 {
-	RKdrv_LinAng (h, nsub, isub, RK8_n, RK8_alpha, RK8_beta, RK8_gamma);
+	RKdrv_LinAng (h, nsub, isub, RK_RKF78.n, RK_RKF78.alpha, RK_RKF78.beta, RK_RKF78.gamma);
+}
+
+
+// ---------------------------------------------------------------------------
+// Driver routine for embedded Runge-Kutta pairs with step size control
+// (linear+angular)
+// The interval h is covered by internal steps whose length is adapted to
+// keep the estimated local error of the linear state within PropAdaptTol,
+// relative to the distance and speed w.r.t. the reference body. The step
+// size is carried over to the next call. The angle step target of the
+// current propagator level limits the internal steps for rotating bodies.
+// ---------------------------------------------------------------------------
+
+void RigidBody::RKdrv_LinAng_Adaptive (double h, int nsub, int isub, const RKPair &rk)
+{
+	int i, j, n = rk.n;
+	double bh;
+	StateVectors s[RK_MAXSTAGE];
+	Vector a[RK_MAXSTAGE];       // linear acceleration
+	Vector d[RK_MAXSTAGE];       // angular acceleration
+	Vector tau;
+
+	RKStepControl ctrl (rk, h, adaptStep);
+	double pscale = PropAdaptTol * std::max (cpos.length(), 1.0);
+	double vscale = PropAdaptTol * std::max (cvel.length(), 1.0);
+
+	while (!ctrl.Done()) {
+		double w = s1->omega.length();
+		double t = ctrl.Time();
+		double hh = ctrl.Step (w > 0.0 ? PropMode[PropLevel].atgt/w : 1e20);
+
+		const double *b = rk.beta;
+		s[0].Set (s1->vel, s1->pos, s1->omega, s1->Q);
+		a[0].Set (acc);
+		d[0].Set (arot);
+		for (i = 1; i < n; i++) {
+			s[i].Set (s1->vel, s1->pos, s1->omega, s1->Q);
+			for (j = 0; j < i; j++)
+				s[i].Advance (b[j]*hh, a[j], s[j].vel, d[j], s[j].omega);
+			GetIntermediateMoments (a[i],tau,s[i],(isub+(t+rk.alpha[i-1]*hh)/h)/nsub, hh);
+			d[i].Set (EulerInv_full (tau, s[i].omega));
+			b += n-1;
+		}
+
+		// local error estimate
+		Vector ep, ev;
+		for (i = 0; i < n; i++) {
+			if (!rk.gerr[i]) continue;
+			bh = rk.gerr[i]*hh;
+			ep += s[i].vel * bh;
+			ev += a[i]     * bh;
+		}
+		if (!ctrl.Update (std::max (ep.length()/pscale, ev.length()/vscale)))
+			continue; // rejected: repeat with smaller step
+
+		// accept step
+		for (i = 0; i < n; i++) {
+			if (!rk.gamma[i]) continue;
+			bh = rk.gamma[i]*hh;
+			rvel_add += a[i]       * bh;
+			rpos_add += s[i].vel   * bh;
+			s1->Q.Rotate (s[i].omega * bh);
+			s1->omega += d[i]      * bh;
+		}
+		s1->pos = rpos_base + rpos_add;
+		s1->vel = rvel_base + rvel_add;
+
+		// moments at the new state, for the next internal step
+		if (!ctrl.Done()) {
+			if (rk.fsal) {
+				acc.Set (a[n-1]);
+				arot.Set (d[n-1]);
+			} else {
+				s1->R.Set (s1->Q);
+				GetIntermediateMoments (acc, tau, *s1, (isub+ctrl.Time()/h)/nsub, hh);
+				arot.Set (EulerInv_full (tau, s1->omega));
+			}
+		}
+	}
+	adaptStep = ctrl.NextStep();
+}
+
+// ---------------------------------------------------------------------------
+// Dormand-Prince 5(4), adaptive (linear+angular)
+// ---------------------------------------------------------------------------
+
+void RigidBody::DP5_LinAng (double h, int nsub, int isub)
+{
+	RKdrv_LinAng_Adaptive (h, nsub, isub, RK_DP54);
 }
 
+// ---------------------------------------------------------------------------
+// Runge-Kutta-Fehlberg 7(8), adaptive (linear+angular)
+// ---------------------------------------------------------------------------
+
+void RigidBody::RK78_LinAng (double h, int nsub, int isub)
+{
+	RKdrv_LinAng_Adaptive (h, nsub, isub, RK_RKF78);
+}
 
 // ---------------------------------------------------------------------------
 // 2nd order symplectic propagator (linear+angular)
@@ -424,6 +496,109 @@ void RigidBody::SY8_LinAng (double h, int nsub, int isub)
 	}
 }
 
+// ===========================================================================
+// Analytic conic coast
+// For force-free bodies in a nearly unperturbed 2-body orbit at large time
+// steps: the linear state follows the osculating conic, and the attitude
+// the torque-free rotation of the body. The cost of a step is independent
+// of the step length.
+// ===========================================================================
+
+bool RigidBody::ConicCoast ()
+{
+	const double alt_margin = 2e4; // min. altitude above surface or atmosphere [m]
+	const int minsample = 4, maxsample = 64; // perturbation samples along the arc
+	const double plimit = g_pOrbiter->Cfg()->CfgPhysicsPrm.ConicCoast_PLimit;
+	bool coast = bConicCoast;
+	bConicCoast = false;
+
+	if (plimit <= 0.0 || !cbody || !el) return false;
+	if (td.SimDT < PropMode[0].tlim) return false; // short steps are cheap to integrate dynamically
+	if (pmi.x <= 0.0 || pmi.y <= 0.0 || pmi.z <= 0.0) return false;
+	if (!CanCoastConic ()) return false;
+
+	// Perturbation at the start of the step. If the previous step was a
+	// conic coast, this has already been checked at its end.
+	Vector g;
+	if (!coast && PerturbationRatio (s0->pos, cpos, 0.0, g) > plimit) return false;
+
+	// Continue along the conic of the previous step, unless the state has
+	// been modified since, or the elements have been reset. The conic is
+	// evaluated on a copy, so that a rejected coast leaves the osculating
+	// elements of the body unchanged.
+	const double eps = 1e-9;
+	Elements cel;
+	cel = *el;
+	if (!coast || !el_valid ||
+		(cpos-cel.RVec()).length() > eps*cpos.length() ||
+		(cvel-cel.VVec()).length() > eps*cvel.length())
+		cel.Calculate (cpos, cvel, td.SimT0);
+
+	Vector pos, vel;
+	cel.Update (pos, vel); // cbody-relative state at SimT1
+
+	// The conic must stay clear of the surface and atmosphere of cbody,
+	// including a periapsis passage during the step
+	double rmin = cbody->Size() + alt_margin;
+	if (cbody->Type() == OBJTP_PLANET && ((Planet*)cbody)->HasAtmosphere())
+		rmin += ((Planet*)cbody)->AtmAltLimit();
+	if (ConicArcMinRadius (cpos, cvel, pos, vel, cel.e, cel.PeDist(), cel.OrbitT(), td.SimDT) < rmin) return false;
+
+	// Perturbation along the arc, so that a close approach to another body
+	// during the step is not missed. Closed orbits are sampled at least 16
+	// times per revolution.
+	int i, nsample = minsample;
+	if (cel.e < 1.0)
+		nsample = std::max (nsample, (int)std::min (ceil (16.0*td.SimDT/cel.OrbitT()), (double)maxsample));
+	Vector spos, svel;
+	for (i = 1; i < nsample; i++) {
+		double tfrac = (double)i/(double)nsample;
+		cel.PosVel (spos, svel, td.SimT0 + tfrac*td.SimDT);
+		if (PerturbationRatio (cbody->InterpolatePosition (tfrac) + spos, spos, tfrac, g) > plimit) return false;
+	}
+
+	// Perturbation at the end of the step (this also catches the approach
+	// to another body's sphere of influence)
+	Vector gpos (cbody->s1->pos + pos);
+	if (PerturbationRatio (gpos, pos, 1.0, g) > plimit) return false;
+
+	// Attitude drift due to gravity gradient torque must be negligible
+	if (!bIgnoreGravTorque) {
+		double r = pos.length();
+		if (3.0*Ggrav*cbody->Mass()/(r*r*r) * td.SimDT*td.SimDT > plimit) return false;
+	}
+
+	*el = cel;
+	s1->Set (*s0);
+	s1->pos.Set (gpos);
+	s1->vel.Set (cbody->s1->vel + vel);
+	FlushRPos();
+	FlushRVel();
+	// torque-free steps are cheap (no force evaluations), so the angle step
+	// target of the first propagation level is used
+	TorqueFreeRotation (s1->Q, s1->omega, pmi, td.SimDT, PropMode[0].atgt);
+	s1->R.Set (s1->Q);
+	acc.Set (g);
+	arot.Set (EulerInv_full (Vector(0,0,0), s1->omega));
+	nPropSubsteps = 1;
+	return (bConicCoast = true);
+}
+
+// ---------------------------------------------------------------------------
+
+double RigidBody::PerturbationRatio (const Vector &gpos, const Vector &rpos, double tfrac, Vector &g)
+{
+	g = g_psys->Gacc_intermediate (gpos, tfrac, this, &gfielddata);
+
+	// cbody is accelerated by the other sources as well, so only the
+	// differential part perturbs the relative orbit
+	Vector gref (g_psys->Gacc_intermediate (cbody->InterpolatePosition (tfrac), tfrac, cbody, &gfielddata));
+
+	double r = rpos.length();
+	Vector g2b (rpos * (-Ggrav*cbody->Mass()/(r*r*r)));
+	return (g - gref - g2b).length() / g2b.length();
+}
+
 #ifdef UNDEF
 // ===========================================================================
 // Propagators for 2-body orbit perturbations
@@ -532,7 +707,7 @@ void RigidBody::RKdrv_Pert (const PertIntData &data, int n, const double *alpha,
 
 void RigidBody::RK8_Pert (const PertIntData &data)
 {
-	RKdrv_Pert (data, RK8_n, RK8_alpha, RK8_beta, RK8_gamma);
+	RKdrv_Pert (data, RK_RKF78.n, RK_RKF78.alpha, RK_RKF78.beta, RK_RKF78.gamma);
 }
 #endif
 
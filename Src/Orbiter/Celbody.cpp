@@ -16,6 +16,8 @@
 #include "Log.h"
 #include "Orbitersdk.h"
 #include "PinesGrav.h"
+#include "GravCache.h"
+#include "ChebEphem.h"
 
 using namespace std;
 
@@ -36,6 +38,8 @@ CelestialBody::CelestialBody (double _mass, double _size)
 	el = new Elements; TRACENEW
 	ClearModule();
 	usePinesGravity = false;
+	gcache = NULL;
+	interp_nhit = interp_nmiss = 0;
 }
 
 CelestialBody::CelestialBody (char *fname)
@@ -44,6 +48,8 @@ CelestialBody::CelestialBody (char *fname)
 	char cbuf[256];
 	int gravcoeff = 0;
 	usePinesGravity = false;
+	gcache = NULL;
+	interp_nhit = interp_nmiss = 0;
 
 	DefaultParam ();
 	ClearModule ();
@@ -103,6 +109,12 @@ CelestialBody::CelestialBody (char *fname)
 
 		if (readResult == 0) {
 			usePinesGravity = true;
+			double tol = g_pOrbiter->Cfg()->CfgPhysicsPrm.GravCacheTol;
+			if (tol > 0.0) {
+				gcache = new GravCache ([this](const Vector &lpos, int degree) {
+					return pinesAccel (lpos, degree, degree);
+				}, tol); TRACENEW
+			}
 		}
 	}
 
@@ -140,6 +152,25 @@ CelestialBody::CelestialBody (char *fname)
 		if (module->bEphemeris()) { // ephemerides calculated by module
 			bDynamicPosVel = false;
 			bFixedElements = false;
+			if (g_pOrbiter->Cfg()->CfgPhysicsPrm.bEphemTables) {
+				ChebEphemeris *tab = new ChebEphemeris; TRACENEW
+				if (tab->Open (EphemerisTablePath().c_str())) {
+					// only use the table if it was fitted to this module
+					const ChebEphemeris::Header *hdr = tab->GetHeader();
+					ChebEphemeris::Source src;
+					uint32_t vecmask;
+					bool havevel;
+					ephemcaps = ModuleEphemerisSource (hdr->mjd0, src, vecmask, havevel);
+					if (tab->Matches (EphemerisSourceId().c_str(), src)) {
+						LOGOUT("Ephemeris table %s: MJD %0.1f-%0.1f, %u segments", name.c_str(), hdr->mjd0, hdr->mjd1, hdr->nseg);
+						ephemtab = tab;
+					} else {
+						LOGOUT_WARN("Ephemeris table %s: not fitted to the current ephemeris module, ignored", name.c_str());
+						delete tab;
+					}
+				} else
+					delete tab;
+			}
 		}
 	}
 	if (modIntf.oplanetEphemeris) { // old module interface
@@ -165,6 +196,11 @@ CelestialBody::~CelestialBody ()
 		delete []jcoeff;
 		jcoeff = NULL;
 	}
+	if (gcache) {
+		LOGOUT("Gravity cache %s: %llu interpolated, %llu direct evaluations, %zu cells",
+			name.c_str(), (unsigned long long)gcache->nHit(), (unsigned long long)gcache->nMiss(), gcache->nCell());
+		delete gcache;
+	}
 }
 
 void CelestialBody::DefaultParam ()
@@ -186,6 +222,8 @@ void CelestialBody::DefaultParam ()
 	bInitFromElements = false;
 	hMod              = 0;
 	module            = 0;
+	ephemtab          = 0;
+	ephemcaps         = 0;
 	bFixedElements = false;
 }
 
@@ -549,6 +587,8 @@ void CelestialBody::GetRotation (double t, Matrix &rot) const
 
 int CelestialBody::ExternEphemeris (double mjd, int req, double *res) const
 {
+	int flg = TableEphemeris (mjd, req, res);
+	if (flg) return flg;
 	if (module)
 		return module->clbkEphemeris (mjd, req, res); // new interface
 	if (modIntf.oplanetEphemeris) {                   // OBSOLETE!
@@ -561,6 +601,8 @@ int CelestialBody::ExternEphemeris (double mjd, int req, double *res) const
 
 int CelestialBody::ExternFastEphemeris (double simt, int req, double *res) const
 {
+	int flg = TableEphemeris (td.MJD_ref + Day(simt), req, res);
+	if (flg) return flg;
 	if (module) {
 		return module->clbkFastEphemeris (simt, req, res); // new interface
 	}
@@ -573,6 +615,99 @@ int CelestialBody::ExternFastEphemeris (double simt, int req, double *res) const
 	return 0;
 }
 
+int CelestialBody::TableEphemeris (double mjd, int req, double *res) const
+{
+	const int data = EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL;
+	if (!ephemtab || (req & data & ephemcaps & ~(int)ephemtab->GetHeader()->flags))
+		return 0;
+	return ephemtab->Eval (mjd, res);
+}
+
+int CelestialBody::ModuleEphemerisSource (double mjd, ChebEphemeris::Source &src, uint32_t &vecmask, bool &havevel) const
+{
+	vecmask = 0;
+	havevel = false;
+	if (!module || !module->bEphemeris()) return 0;
+
+	// find out which data the module provides
+	const int req = EPHEM_TRUEPOS | EPHEM_TRUEVEL | EPHEM_BARYPOS | EPHEM_BARYVEL;
+	double res[12];
+	int flg = module->clbkEphemeris (mjd, req, res);
+	bool dotrue = ((flg & EPHEM_TRUEPOS) != 0);
+	bool dobary = ((flg & EPHEM_BARYPOS) != 0) && !(dotrue && (flg & EPHEM_BARYISTRUE));
+	bool hv = (!dotrue || (flg & EPHEM_TRUEVEL)) && (!dobary || (flg & EPHEM_BARYVEL));
+	vecmask = (dotrue ? 1 : 0) | (dobary ? 2 : 0);
+	havevel = hv;
+
+	CELBODY *mod = module;
+	src = [=](double t, double *r) {
+		int f = mod->clbkEphemeris (t, req, r);
+		if (f & EPHEM_POLAR) {
+			if (dotrue) Pol2Crt (r, r, true, hv);
+			if (dobary) Pol2Crt (r+6, r+6, true, hv);
+		}
+		if (!hv) r[3] = r[4] = r[5] = r[9] = r[10] = r[11] = 0.0;
+	};
+	return flg;
+}
+
+std::string CelestialBody::EphemerisSourceId () const
+{
+	// module file name, without path
+	char path[MAX_PATH];
+	if (!hMod || !GetModuleFileNameA (hMod, path, MAX_PATH)) return std::string();
+	const char *fname = strrchr (path, '\\');
+	return std::string (fname ? fname+1 : path);
+}
+
+bool CelestialBody::FitEphemerisTable (double mjd0, double mjd1, double tol)
+{
+	ChebEphemeris::Source src;
+	uint32_t vecmask;
+	bool havevel;
+	int flg = ModuleEphemerisSource (mjd0, src, vecmask, havevel);
+	if (!vecmask) return false;
+
+	// the table is fitted to cartesian positions; velocities are always
+	// provided by the table
+	int tabflg = flg & ~EPHEM_POLAR;
+	if (vecmask & 1) tabflg |= EPHEM_TRUEVEL;
+	if (vecmask & 2) tabflg |= EPHEM_BARYVEL;
+
+	// velocity tolerance: position tolerance over 1000 seconds, not
+	// tested if the module doesn't provide velocities
+	ChebEphemeris *tab = new ChebEphemeris; TRACENEW
+	if (!tab->Fit (src, tabflg, vecmask, mjd0, mjd1, tol, havevel ? tol*1e-3 : 1e100)) {
+		LOGOUT_ERR("Ephemeris table %s: fit failed for tolerance %g m", name.c_str(), tol);
+		delete tab;
+		return false;
+	}
+	tab->SetSource (EphemerisSourceId().c_str());
+	std::string path = EphemerisTablePath();
+	if (!tab->Save (path.c_str()))
+		LOGOUT_ERR("Ephemeris table %s: could not write %s", name.c_str(), path.c_str());
+
+	// accuracy report against the module ephemeris
+	const ChebEphemeris::Header *hdr = tab->GetHeader();
+	ChebEphemeris::Accuracy acc = tab->Compare (src, 2000);
+	LOGOUT("Ephemeris table %s: MJD %0.1f-%0.1f, %u segments of %0.4g days, %u coefficients, %zu bytes",
+		name.c_str(), hdr->mjd0, hdr->mjd1, hdr->nseg, hdr->seglen, hdr->ncoeff, tab->Size());
+	LOGOUT("  position error: max %0.3g m, rms %0.3g m", acc.perr_max, acc.perr_rms);
+	if (havevel)
+		LOGOUT("  velocity error: max %0.3g m/s, rms %0.3g m/s", acc.verr_max, acc.verr_rms);
+	LOGOUT("  evaluation time: module %0.3g us, table %0.3g us", acc.t_source*1e6, acc.t_table*1e6);
+
+	if (ephemtab) delete ephemtab;
+	ephemtab = tab;
+	ephemcaps = flg;
+	return true;
+}
+
+std::string CelestialBody::EphemerisTablePath () const
+{
+	return std::string("Config\\") + name + "\\Data\\" + name + ".cheb";
+}
+
 int CelestialBody::ExternPosition ()
 {
 	static double res[12];
@@ -640,13 +775,82 @@ bool CelestialBody::PosVelAtTime (double t, Vector *p, Vector *v) const
 	return true;
 }
 
-Vector CelestialBody::InterpolatePosition (double n) const
+// -----------------------------------------------------------------------
+// Memoised intermediate positions. Each body holds a small direct-mapped
+// table indexed by a hash of the fractional step. Entries are tagged with
+// a global generation counter, which is advanced whenever body states
+// change, so invalidation doesn't need to touch the tables. Readers and
+// writers don't block each other: a reader that finds an entry being
+// written evaluates the position itself, and a writer that finds an entry
+// locked by another thread skips storing its result.
+
+static std::atomic<uint32_t> g_interpGen(1); // 0 marks unused entries
+
+void CelestialBody::InvalidateInterpolation ()
 {
-	// Interpolate global position of body by iterative bisection
+	g_interpGen++;
+}
 
+void CelestialBody::InterpolationStats (uint64_t &nhit, uint64_t &nmiss) const
+{
+	nhit = interp_nhit;
+	nmiss = interp_nmiss;
+}
+
+Vector CelestialBody::InterpolatePosition (double n) const
+{
 	if      (n == 0)   return s0->pos;
 	else if (n == 1.0) return s1->pos;
 
+	uint64_t bits;
+	memcpy (&bits, &n, sizeof(double));
+	InterpSlot &slot = interp[(bits * 0x9E3779B97F4A7C15ull) >> 57 & (NINTERPSLOT-1)];
+	uint32_t gen = g_interpGen.load (std::memory_order_relaxed);
+
+	uint32_t seq = slot.seq.load (std::memory_order_acquire);
+	if (!(seq & 1) && slot.gen.load (std::memory_order_relaxed) == gen && slot.n.load (std::memory_order_relaxed) == n) {
+		Vector p (slot.x.load (std::memory_order_relaxed), slot.y.load (std::memory_order_relaxed), slot.z.load (std::memory_order_relaxed));
+		std::atomic_thread_fence (std::memory_order_acquire);
+		if (slot.seq.load (std::memory_order_relaxed) == seq) {
+			interp_nhit.fetch_add (1, std::memory_order_relaxed);
+			return p;
+		}
+	}
+
+	interp_nmiss.fetch_add (1, std::memory_order_relaxed);
+	Vector p (g_pOrbiter->Cfg()->CfgPhysicsPrm.bCelInterpHermite ?
+		InterpolatePositionHermite (n) : InterpolatePositionBisect (n));
+
+	seq = slot.seq.load (std::memory_order_relaxed);
+	if (!(seq & 1) && slot.seq.compare_exchange_strong (seq, seq+1, std::memory_order_acquire)) {
+		slot.gen.store (gen, std::memory_order_relaxed);
+		slot.n.store (n, std::memory_order_relaxed);
+		slot.x.store (p.x, std::memory_order_relaxed);
+		slot.y.store (p.y, std::memory_order_relaxed);
+		slot.z.store (p.z, std::memory_order_relaxed);
+		slot.seq.store (seq+2, std::memory_order_release);
+	}
+	return p;
+}
+
+Vector CelestialBody::InterpolatePositionHermite (double n) const
+{
+	// Cubic Hermite interpolation of the global position from the
+	// positions and velocities at both ends of the step
+
+	double dt = td.SimDT;
+	double n2 = n*n, n3 = n2*n;
+	double h00 = 2.0*n3 - 3.0*n2 + 1.0;
+	double h10 = n3 - 2.0*n2 + n;
+	double h01 = 3.0*n2 - 2.0*n3;
+	double h11 = n3 - n2;
+	return s0->pos*h00 + s0->vel*(h10*dt) + s1->pos*h01 + s1->vel*(h11*dt);
+}
+
+Vector CelestialBody::InterpolatePositionBisect (double n) const
+{
+	// Interpolate global position of body by iterative bisection
+
 	Vector refp0, refp1, refpm;
 	const CelestialBody *ref = ElRef();
 	if (ref) {
@@ -704,7 +908,12 @@ StateVectors CelestialBody::InterpolateState (double n) const
 
 	StateVectors sv;
 	sv.pos = InterpolatePosition (n);
-	sv.vel = s0->vel*(1.0-n) + s1->vel*n; // may need a better interpolation
+	if (g_pOrbiter->Cfg()->CfgPhysicsPrm.bCelInterpHermite) {
+		// derivative of the Hermite position interpolant
+		double dt = td.SimDT, n2 = n*n;
+		sv.vel = (s0->pos - s1->pos)*((6.0*n2 - 6.0*n)/dt) + s0->vel*(3.0*n2 - 4.0*n + 1.0) + s1->vel*(3.0*n2 - 2.0*n);
+	} else
+		sv.vel = s0->vel*(1.0-n) + s1->vel*n; // may need a better interpolation
 	GetRotation (td.SimT0 + td.SimDT*n, sv.R);
 	sv.Q.Set (sv.R);
 	sv.omega.Set (s0->omega*(1.0-n) + s1->omega*n); // is this ok?
@@ -764,6 +973,10 @@ void CelestialBody::ClearModule ()
 		FreeLibrary (hMod);
 		hMod = 0;
 	}
+	if (ephemtab) {
+		delete ephemtab;
+		ephemtab = 0;
+	}
 	memset (&modIntf, 0, sizeof (modIntf)); // old interface
 }
 
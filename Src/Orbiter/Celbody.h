@@ -12,6 +12,11 @@
 #include "RigidBody.h"
 #include "OrbiterAPI.h"
 #include "PinesGrav.h"
+#include "ChebEphem.h"
+#include <atomic>
+#include <stdint.h>
+
+class GravCache;
 
 // Module interface methods - OBSOLETE
 typedef void   (*OPLANET_SetPrecision)(double prec);
@@ -40,6 +45,15 @@ public:
 	CELBODY *GetModuleInterface() { return module; }
 	// module interface pointer, if available
 
+	bool FitEphemerisTable (double mjd0, double mjd1, double tol);
+	// Fit a Chebyshev ephemeris table to the module ephemeris over the
+	// date range [mjd0,mjd1] with position tolerance tol [m], write it
+	// to EphemerisTablePath() and log an accuracy report.
+	// Returns false if the body has no ephemeris module or the fit fails.
+
+	std::string EphemerisTablePath () const;
+	// Ephemeris table file: Config\<name>\Data\<name>.cheb
+
 	void Attach (CelestialBody *_parent);
 	// Set the objects's central body
 
@@ -104,7 +118,18 @@ public:
 	// interpolate a planet position to a time between last and current time step,
 	// where n=0 refers to last step, and n=1 to current step.
 	// linear interpolation of position, plus linear interpolation of radius, if
-	// body's element reference exists
+	// body's element reference exists, or cubic Hermite interpolation of
+	// position and velocity if enabled in the physics configuration.
+	// Results are memoised for the current step, so that repeated requests
+	// for the same n (e.g. a Runge-Kutta stage of many vessels) are only
+	// evaluated once. May be called concurrently.
+
+	static void InvalidateInterpolation ();
+	// discard memoised intermediate positions of all bodies. Must be
+	// called whenever s0 or s1 of any celestial body changes.
+
+	void InterpolationStats (uint64_t &nhit, uint64_t &nmiss) const;
+	// number of memoised and evaluated InterpolatePosition requests
 
 	StateVectors InterpolateState (double n) const;
 	// Celestial body state vectors at fractional time n [0..1] between
@@ -123,12 +148,18 @@ public:
 
 	// returns true if the body uses Pines Algorithm to calculate gravitational acceleration from spherical harmonics
 	inline bool usePines() const { return usePinesGravity; }
-	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder){
+	inline Vector pinesAccel(const Vector rposmax, const int maxDegree, const int maxOrder) const {
 		return pinesgrav.GetPinesGrav(rposmax, maxDegree, maxOrder);
 	}
+	// returns the perturbation accelerations for a batch of positions (body frame, km)
+	inline void pinesAccel(const Vector* rpos, Vector* acc, int npos, const int maxDegree, const int maxOrder) const {
+		pinesgrav.GetPinesGrav(rpos, acc, npos, maxDegree, maxOrder);
+	}
 	inline unsigned int GetPinesCutoff() const {
 		return pinesgrav.GetCoeffCutoff(); 
 	}
+	// returns the gravity field cache for the Pines model, or NULL if not used
+	inline GravCache *GravFieldCache() const { return gcache; }
 
 protected:
 	//Matrix R_ref_rel;     // rotation matrix for tilting the axis of rotation (including precession)
@@ -165,6 +196,20 @@ protected:
 	// external module.
 	// Returns false if not supported by module
 
+	int TableEphemeris (double mjd, int req, double *res) const;
+	// Try to obtain ephemeris data at mjd from the ephemeris table. Returns
+	// 0 if there is no table, mjd is outside its range, or the table lacks
+	// requested data the module can provide
+
+	int ModuleEphemerisSource (double mjd, ChebEphemeris::Source &src, uint32_t &vecmask, bool &havevel) const;
+	// Set src to the module ephemeris in cartesian coordinates, as fitted by
+	// ephemeris tables. vecmask: stored state vectors (bit 0: true, bit 1:
+	// barycentric), havevel: module provides velocities.
+	// Returns the module data flags at mjd (0 if the module has no ephemeris)
+
+	std::string EphemerisSourceId () const;
+	// Identification of the ephemeris module in ephemeris table headers
+
 	int ExternState (double *res);
 	// Try to obtain current ephemeris data (true and barycentric) from external
 	// module. This tries first FastEphemeris, then Ephemeris. Return value
@@ -184,6 +229,8 @@ protected:
 	void RegisterModule (char *dllname);
 	void ClearModule ();
 	CELBODY *module;         // pointer to module interface class, if available
+	ChebEphemeris *ephemtab; // Chebyshev ephemeris table, used in place of module ephemerides within its range
+	int ephemcaps;           // data flags provided by the module ephemeris
 
 	bool bFixedElements;
 	// Set this to true if the object's elements never change
@@ -223,6 +270,22 @@ private:
 
 	PinesGravProp pinesgrav; // coefficients and methods for calculating non-spherical gravity vectors using Pines Algorithm
 	bool usePinesGravity;    // use Pines Algorithm if true, if false use the older jcoeff method
+	GravCache *gcache;       // cache for the Pines perturbation field (NULL if disabled)
+
+	Vector InterpolatePositionBisect (double n) const;
+	Vector InterpolatePositionHermite (double n) const;
+	// intermediate position evaluation methods used by InterpolatePosition
+
+	struct InterpSlot {      // memoised intermediate position, written as a seqlock
+		InterpSlot (): seq(0), gen(0), n(0.0), x(0.0), y(0.0), z(0.0) {}
+		std::atomic<uint32_t> seq;       // odd while the entry is being written
+		std::atomic<uint32_t> gen;       // interpolation generation of the entry
+		std::atomic<double> n;           // fractional step
+		std::atomic<double> x, y, z;     // global position
+	};
+	static const int NINTERPSLOT = 128;  // must be a power of 2
+	mutable InterpSlot interp[NINTERPSLOT];
+	mutable std::atomic<uint64_t> interp_nhit, interp_nmiss; // cache statistics
 
 	Vector bpos, bvel;       // object's barycentre state (the barycentre of the set of bodies including *this and its children) with respect to the true position of the parent of *this
 	Vector bposofs, bvelofs; // body barycentre state - true state
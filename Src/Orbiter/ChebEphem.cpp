@@ -0,0 +1,384 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class ChebEphemeris
+// =======================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <algorithm>
+#include "ChebEphem.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const char MAGIC[8] = {'O','C','H','E','B','E','P','H'};
+static const uint32_t VERSION = 2;
+static const int MAXCOEFF = 32;          // max. polynomial order + 1
+static const double MAXSEGLEN = 64.0;    // initial segment length for fitting [days]
+static const double MINSEGLEN = 1.0/64.0; // give up below this segment length [days]
+static const double PI = 3.14159265358979323846;
+
+// -----------------------------------------------------------------------
+// Chebyshev polynomials T_k(t) and their derivatives, k < n
+
+static inline void ChebBasis (double t, int n, double *T, double *dT)
+{
+	T[0] = 1.0, dT[0] = 0.0;
+	T[1] = t,   dT[1] = 1.0;
+	for (int k = 2; k < n; k++) {
+		T[k]  = 2.0*t*T[k-1] - T[k-2];
+		dT[k] = 2.0*T[k-1] + 2.0*t*dT[k-1] - dT[k-2];
+	}
+}
+
+// -----------------------------------------------------------------------
+// State vectors from the coefficient record c of a segment, at segment
+// parameter t in [-1,1]. vscale: dt/d(mjd) [1/s]
+
+static void EvalSegment (const double *c, int n, uint32_t vecmask, double t, double vscale, double *res)
+{
+	double T[MAXCOEFF], dT[MAXCOEFF];
+	ChebBasis (t, n, T, dT);
+
+	for (int s = 0; s < 2; s++) {
+		if (!(vecmask & (1 << s))) continue;
+		double *r = res + s*6;
+		for (int i = 0; i < 3; i++, c += n) {
+			double p = 0.0, v = 0.0;
+			for (int j = 0; j < n; j++) {
+				p += c[j]*T[j];
+				v += c[j]*dT[j];
+			}
+			r[i] = p;
+			r[i+3] = v*vscale;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+// Positions of the first stored state vector at mjd0, the range centre
+// and mjd1, as provided by src
+
+static void Fingerprint (const ChebEphemeris::Source &src, uint32_t vecmask, double mjd0, double mjd1, double *fp)
+{
+	double res[12];
+	int s = (vecmask & 1 ? 0 : 6);
+	double mjd[3] = {mjd0, 0.5*(mjd0+mjd1), mjd1};
+	for (int i = 0; i < 3; i++) {
+		src (mjd[i], res);
+		memcpy (fp + i*3, res + s, 3*sizeof(double));
+	}
+}
+
+// -----------------------------------------------------------------------
+
+ChebEphemeris::ChebEphemeris ()
+: m_hdr(0), m_coeff(0), m_map(0), m_mapsize(0)
+{
+#ifdef _WIN32
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMap = NULL;
+#endif
+}
+
+// -----------------------------------------------------------------------
+
+ChebEphemeris::~ChebEphemeris ()
+{
+	Close ();
+}
+
+// -----------------------------------------------------------------------
+
+bool ChebEphemeris::Open (const char *fname)
+{
+	Close ();
+
+#ifdef _WIN32
+	m_hFile = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (m_hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fsize;
+	if (GetFileSizeEx (m_hFile, &fsize) && fsize.QuadPart >= (LONGLONG)sizeof(Header)) {
+		m_hMap = CreateFileMappingA (m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (m_hMap) {
+			m_map = MapViewOfFile (m_hMap, FILE_MAP_READ, 0, 0, 0);
+			m_mapsize = (size_t)fsize.QuadPart;
+		}
+	}
+#else
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat (fd, &st) == 0 && st.st_size >= (off_t)sizeof(Header)) {
+		void *p = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED) {
+			m_map = p;
+			m_mapsize = (size_t)st.st_size;
+		}
+	}
+	close (fd);
+#endif
+	if (!m_map) {
+		Close ();
+		return false;
+	}
+
+	// sanity checks
+	const Header *hdr = (const Header*)m_map;
+	bool ok = (!memcmp (hdr->magic, MAGIC, 8) && hdr->version == VERSION &&
+		hdr->ncoeff >= 2 && hdr->ncoeff <= MAXCOEFF && hdr->nseg > 0 &&
+		hdr->vecmask && !(hdr->vecmask & ~3u) &&
+		hdr->nvec == (hdr->vecmask == 3 ? 2u : 1u) &&
+		memchr (hdr->source, 0, sizeof(hdr->source)) &&
+		hdr->seglen > 0.0 && hdr->mjd1 > hdr->mjd0);
+	if (ok) {
+		SetData (hdr);
+		ok = (Size() == m_mapsize);
+	}
+	if (!ok) {
+		Close ();
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+void ChebEphemeris::Close ()
+{
+#ifdef _WIN32
+	if (m_map) UnmapViewOfFile (m_map);
+	if (m_hMap) CloseHandle (m_hMap);
+	if (m_hFile != INVALID_HANDLE_VALUE) CloseHandle (m_hFile);
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMap = NULL;
+#else
+	if (m_map) munmap (m_map, m_mapsize);
+#endif
+	m_map = 0;
+	m_mapsize = 0;
+	m_data.clear();
+	m_hdr = 0;
+	m_coeff = 0;
+}
+
+// -----------------------------------------------------------------------
+
+bool ChebEphemeris::Save (const char *fname) const
+{
+	if (!m_hdr) return false;
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+	size_t size = Size();
+	bool ok = (fwrite (m_hdr, 1, size, f) == size);
+	fclose (f);
+	return ok;
+}
+
+// -----------------------------------------------------------------------
+
+void ChebEphemeris::SetData (const Header *hdr)
+{
+	m_hdr = hdr;
+	m_coeff = (const double*)(hdr+1);
+}
+
+// -----------------------------------------------------------------------
+
+size_t ChebEphemeris::Size () const
+{
+	if (!m_hdr) return 0;
+	return sizeof(Header) + (size_t)m_hdr->nseg * m_hdr->nvec * 3 * m_hdr->ncoeff * sizeof(double);
+}
+
+// -----------------------------------------------------------------------
+
+int ChebEphemeris::Eval (double mjd, double *res) const
+{
+	if (!InRange (mjd)) return 0;
+
+	const Header *hdr = m_hdr;
+	int n = hdr->ncoeff;
+	double dt = mjd - hdr->mjd0;
+	uint32_t k = (uint32_t)(dt / hdr->seglen);
+	if (k >= hdr->nseg) k = hdr->nseg-1;
+	double t = 2.0*(dt - k*hdr->seglen)/hdr->seglen - 1.0;
+	double vscale = 2.0/(hdr->seglen*86400.0); // d/dt [1/s]
+
+	EvalSegment (m_coeff + (size_t)k * hdr->nvec * 3 * n, n, hdr->vecmask, t, vscale, res);
+	return hdr->flags;
+}
+
+// -----------------------------------------------------------------------
+
+bool ChebEphemeris::Fit (const Source &src, uint32_t flags, uint32_t vecmask, double mjd0, double mjd1,
+	double tol, double vtol, int ncoeff)
+{
+	Close ();
+	vecmask &= 3;
+	if (!vecmask || mjd1 <= mjd0 || ncoeff < 2 || ncoeff > MAXCOEFF) return false;
+	int nvec = (vecmask == 3 ? 2 : 1);
+	int n = ncoeff;
+
+	// Chebyshev nodes, and test points between them and at the segment ends
+	std::vector<double> node(n), test;
+	for (int j = 0; j < n; j++)
+		node[j] = cos (PI*(j+0.5)/n);
+	test.push_back (1.0);
+	for (int j = 0; j < n-1; j++)
+		test.push_back (0.5*(node[j]+node[j+1]));
+	test.push_back (-1.0);
+
+	std::vector<double> f(n*12);
+	double res[12], fp[9];
+	double range = mjd1 - mjd0;
+	Fingerprint (src, vecmask, mjd0, mjd1, fp);
+
+	for (double seglen = std::min (range, MAXSEGLEN); seglen >= MINSEGLEN; seglen *= 0.5) {
+		uint32_t nseg = (uint32_t)ceil (range/seglen - 1e-9);
+		double len = range/nseg;
+		size_t nrec = (size_t)nvec * 3 * n;
+		m_data.assign (sizeof(Header)/sizeof(double) + nseg*nrec, 0.0);
+
+		Header *hdr = (Header*)m_data.data();
+		memcpy (hdr->magic, MAGIC, 8);
+		hdr->version = VERSION;
+		hdr->flags = flags;
+		hdr->vecmask = vecmask;
+		hdr->nvec = nvec;
+		hdr->ncoeff = n;
+		hdr->nseg = nseg;
+		hdr->mjd0 = mjd0;
+		hdr->mjd1 = mjd1;
+		hdr->seglen = len;
+		hdr->maxerr = tol;
+		memcpy (hdr->fingerprint, fp, sizeof(fp));
+		SetData (hdr);
+
+		double vscale = 2.0/(len*86400.0);
+		bool ok = true;
+		for (uint32_t k = 0; k < nseg && ok; k++) {
+			double s0 = mjd0 + k*len;
+
+			// sample at the nodes
+			for (int j = 0; j < n; j++) {
+				src (s0 + 0.5*(node[j]+1.0)*len, res);
+				memcpy (f.data() + j*12, res, 12*sizeof(double));
+			}
+
+			// coefficients by discrete cosine transform of the node samples
+			double *c0 = m_data.data() + sizeof(Header)/sizeof(double) + k*nrec, *c = c0;
+			for (int s = 0; s < 2; s++) {
+				if (!(vecmask & (1 << s))) continue;
+				for (int i = 0; i < 3; i++, c += n) {
+					for (int m = 0; m < n; m++) {
+						double sum = 0.0;
+						for (int j = 0; j < n; j++)
+							sum += f[j*12 + s*6 + i] * cos (PI*m*(j+0.5)/n);
+						c[m] = sum * (m ? 2.0 : 1.0)/n;
+					}
+				}
+			}
+
+			// validate between the nodes
+			for (size_t j = 0; j < test.size() && ok; j++) {
+				double tab[12];
+				src (s0 + 0.5*(test[j]+1.0)*len, res);
+				EvalSegment (c0, n, vecmask, test[j], vscale, tab);
+				for (int s = 0; s < 2; s++) {
+					if (!(vecmask & (1 << s))) continue;
+					const double *a = res + s*6, *b = tab + s*6;
+					double dp = sqrt ((a[0]-b[0])*(a[0]-b[0]) + (a[1]-b[1])*(a[1]-b[1]) + (a[2]-b[2])*(a[2]-b[2]));
+					double dv = sqrt ((a[3]-b[3])*(a[3]-b[3]) + (a[4]-b[4])*(a[4]-b[4]) + (a[5]-b[5])*(a[5]-b[5]));
+					if (dp > tol || dv > vtol) ok = false;
+				}
+			}
+		}
+		if (ok) return true;
+	}
+	Close ();
+	return false;
+}
+
+// -----------------------------------------------------------------------
+
+void ChebEphemeris::SetSource (const char *source)
+{
+	if (m_data.empty()) return; // mapped tables are read-only
+	Header *hdr = (Header*)m_data.data();
+	strncpy (hdr->source, source, sizeof(hdr->source)-1);
+	hdr->source[sizeof(hdr->source)-1] = '\0';
+}
+
+// -----------------------------------------------------------------------
+
+bool ChebEphemeris::Matches (const char *source, const Source &src) const
+{
+	if (!m_hdr || strncmp (m_hdr->source, source, sizeof(m_hdr->source)))
+		return false;
+	double fp[9];
+	Fingerprint (src, m_hdr->vecmask, m_hdr->mjd0, m_hdr->mjd1, fp);
+	for (int i = 0; i < 9; i += 3) {
+		const double *a = fp + i, *b = m_hdr->fingerprint + i;
+		double dp = sqrt ((a[0]-b[0])*(a[0]-b[0]) + (a[1]-b[1])*(a[1]-b[1]) + (a[2]-b[2])*(a[2]-b[2]));
+		if (!(dp <= m_hdr->maxerr)) return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+ChebEphemeris::Accuracy ChebEphemeris::Compare (const Source &src, int nsample) const
+{
+	Accuracy acc;
+	memset (&acc, 0, sizeof(Accuracy));
+	if (!m_hdr || nsample <= 0) return acc;
+
+	// sample dates from a low-discrepancy sequence, so that they don't
+	// line up with the fit nodes
+	std::vector<double> mjd(nsample), ref(nsample*12), tab(nsample*12);
+	double range = m_hdr->mjd1 - m_hdr->mjd0;
+	for (int i = 0; i < nsample; i++) {
+		double x = (i+0.5)*0.6180339887498949;
+		mjd[i] = m_hdr->mjd0 + (x - floor (x))*range;
+	}
+
+	auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < nsample; i++)
+		src (mjd[i], ref.data() + i*12);
+	auto t1 = std::chrono::steady_clock::now();
+	for (int i = 0; i < nsample; i++)
+		Eval (mjd[i], tab.data() + i*12);
+	auto t2 = std::chrono::steady_clock::now();
+	acc.t_source = std::chrono::duration<double>(t1-t0).count() / nsample;
+	acc.t_table  = std::chrono::duration<double>(t2-t1).count() / nsample;
+
+	double psum = 0.0, vsum = 0.0;
+	int nval = 0;
+	for (int i = 0; i < nsample; i++) {
+		for (int s = 0; s < 2; s++) {
+			if (!(m_hdr->vecmask & (1 << s))) continue;
+			const double *a = ref.data() + i*12 + s*6, *b = tab.data() + i*12 + s*6;
+			double dp2 = (a[0]-b[0])*(a[0]-b[0]) + (a[1]-b[1])*(a[1]-b[1]) + (a[2]-b[2])*(a[2]-b[2]);
+			double dv2 = (a[3]-b[3])*(a[3]-b[3]) + (a[4]-b[4])*(a[4]-b[4]) + (a[5]-b[5])*(a[5]-b[5]);
+			acc.perr_max = std::max (acc.perr_max, sqrt (dp2));
+			acc.verr_max = std::max (acc.verr_max, sqrt (dv2));
+			psum += dp2, vsum += dv2;
+			nval++;
+		}
+	}
+	acc.perr_rms = sqrt (psum/nval);
+	acc.verr_rms = sqrt (vsum/nval);
+	acc.nsample = nsample;
+	return acc;
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class ChebEphemeris
+// Chebyshev-packed ephemeris table. The cartesian position of a body,
+// as returned by its ephemeris module, is fitted over a date range by
+// Chebyshev polynomials on segments of equal length. Velocities are
+// obtained from the derivative of the position polynomials. Tables are
+// stored in a binary file which is memory-mapped at runtime, so that
+// evaluation does not require any series terms to be computed.
+//
+// File layout: a 200-byte header (ChebEphemeris::Header), followed by
+// nseg records of nvec x 3 x ncoeff doubles (coefficient fastest, then
+// x,y,z, then state vector).
+// The header identifies the source the table was fitted to, and holds a
+// fingerprint of source positions, so that a table that no longer
+// matches its source (e.g. after an update of an ephemeris module) can
+// be rejected.
+// =======================================================================
+
+#ifndef __CHEBEPHEM_H
+#define __CHEBEPHEM_H
+
+#include <vector>
+#include <functional>
+#include <stdint.h>
+
+class ChebEphemeris {
+public:
+	struct Header {
+		char     magic[8];     // "OCHEBEPH"
+		uint32_t version;      // file format version
+		uint32_t flags;        // ephemeris flags returned by Eval (opaque to this class)
+		uint32_t vecmask;      // bit 0: res[0-5] stored, bit 1: res[6-11] stored
+		uint32_t nvec;         // number of stored state vectors (1 or 2)
+		uint32_t ncoeff;       // Chebyshev coefficients per component
+		uint32_t nseg;         // number of segments
+		double   mjd0, mjd1;   // table range [MJD]
+		double   seglen;       // segment length [days]
+		double   maxerr;       // position tolerance used for the fit [m]
+		char     source[64];   // source identification (zero-terminated)
+		double   fingerprint[9]; // source positions at mjd0, range centre and mjd1 [m]
+	};
+
+	struct Accuracy {
+		double perr_max, perr_rms; // position error [m]
+		double verr_max, verr_rms; // velocity error [m/s]
+		double t_source;           // time per source evaluation [s]
+		double t_table;            // time per table evaluation [s]
+		int nsample;               // number of samples
+	};
+
+	typedef std::function<void(double mjd, double *res)> Source;
+	// Source of the data to be fitted. Must write the cartesian state
+	// vectors (position [m], velocity [m/s]) into res[0-5] and/or res[6-11].
+
+	ChebEphemeris ();
+	~ChebEphemeris ();
+
+	bool Open (const char *fname);
+	// Map a table file. Returns false if the file doesn't exist or is
+	// not a valid table.
+
+	void Close ();
+	// Release the table
+
+	bool Save (const char *fname) const;
+	// Write a fitted table to file
+
+	bool Fit (const Source &src, uint32_t flags, uint32_t vecmask, double mjd0, double mjd1,
+		double tol, double vtol, int ncoeff = 14);
+	// Fit the data provided by src over [mjd0,mjd1]. The segment length is
+	// halved until position and velocity errors at the test points are
+	// below tol [m] and vtol [m/s]. flags are returned by Eval.
+	// Returns false if the tolerance can't be met.
+
+	void SetSource (const char *source);
+	// Set the source identification of a fitted table (truncated to 63
+	// characters)
+
+	bool Matches (const char *source, const Source &src) const;
+	// Check that the table was fitted to this source: the identification
+	// must be equal, and src must reproduce the fingerprint positions
+	// within the fit tolerance.
+
+	Accuracy Compare (const Source &src, int nsample) const;
+	// Compare the table against the source at nsample dates that are
+	// unrelated to the fit nodes, and time both evaluations.
+
+	inline bool IsValid () const { return m_hdr != 0; }
+	inline bool InRange (double mjd) const { return m_hdr && mjd >= m_hdr->mjd0 && mjd <= m_hdr->mjd1; }
+	inline const Header *GetHeader () const { return m_hdr; }
+	size_t Size () const;
+	// table size [bytes]
+
+	int Eval (double mjd, double *res) const;
+	// Cartesian state vectors at mjd in res[0-5] and/or res[6-11], as fitted.
+	// Returns the table flags, or 0 if mjd is outside the table range.
+
+protected:
+	void SetData (const Header *hdr);
+
+private:
+	const Header *m_hdr;       // table header (mapped or in m_data)
+	const double *m_coeff;     // start of coefficient records
+	std::vector<double> m_data; // storage for fitted tables
+	void *m_map;               // mapped view, if the table was opened from file
+	size_t m_mapsize;
+#ifdef _WIN32
+	void *m_hFile, *m_hMap;
+#endif
+};
+
+#endif // !__CHEBEPHEM_H
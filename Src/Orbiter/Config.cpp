@@ -60,7 +60,13 @@ CFG_PHYSICSPRM CfgPhysicsPrm_default = {
 	20.0*RAD,	// APropSubLimit (angle step limit for angular subsampling)
 	10, 		// PropSubMax (max number of subsampling steps)
 	30.0*RAD,	// APropCouplingLimit (angle step limit for cross term suppresion)
-	3600.0*RAD	// APropTorqueLimit (angle step limit for torque suppression)
+	3600.0*RAD,	// APropTorqueLimit (angle step limit for torque suppression)
+	0,			// PropThreads (threads for concurrent vessel propagation, 0=auto)
+	0.0,		// GravCacheTol (gravity field cache tolerance, 0=no cache)
+	1e-10,		// PropAdaptTol (relative error tolerance of adaptive propagators)
+	0.0,		// ConicCoast_PLimit (perturbation limit for conic coasting, 0=disabled)
+	false,		// bEphemTables (use Chebyshev ephemeris tables where available)
+	false		// bCelInterpHermite (radius bisection for intermediate celestial body positions)
 };
 
 CFG_LOGICPRM CfgLogicPrm_default = {
@@ -145,7 +151,8 @@ CFG_DEBUGPRM CfgDebugPrm_default = {
 	true,       // bSaveExitScreen (capture screen on scenario exit)
 	false,      // bWireframeMode (don't set renderer to wireframe mode)
 	false,      // bNormaliseNormals (don't auto-normalise all normals)
-	false       // bVerboseLog (no verbose log output)
+	false,      // bVerboseLog (no verbose log output)
+	false       // bPropStats (no propagation statistics in the debug string)
 };
 
 CFG_PLANETRENDERPRM CfgPRenderPrm_default = {
@@ -158,7 +165,9 @@ CFG_PLANETRENDERPRM CfgPRenderPrm_default = {
 	5,          // patch mesh resolution power
 	50,			// load frequency (Hz)
 	3,			// aniso mode (1=none)
-	0x0003      // TileLoadFlags (load from individual tile files + compressed archives)
+	0x0003,     // TileLoadFlags (load from individual tile files + compressed archives)
+	256,        // ElevCacheSize (number of elevation tiles cached by ElevationManager)
+	true        // bElevLoadOnThread (prefetch elevation tiles in separate thread)
 };
 
 CFG_MAPPRM CfgMapPrm_default = {
@@ -168,6 +177,7 @@ CFG_MAPPRM CfgMapPrm_default = {
 CFG_RECPLAYPRM CfgRecPlayPrm_default = {
 	1,			// RecordPosFrame (equatorial frame for recording position streams)
 	1,			// RecordAttFrame (local horizon frame for recording attitude streams)
+	1,			// RecordFormat (binary vessel streams)
 	true,		// bRecordWarp (record time acceleration events?)
 	true,		// bRecordFocus (record focus events?)
 	true,		// bReplayWarp (replay time acceleration events?)
@@ -244,6 +254,12 @@ CFG_CMDLINEPRM CfgCmdlinePrm_default = {
 	0.0,                // fixed time step length (0 = disabled)
 	0.0,                // Max sys time (0 = unlimited)
 	0.0,                // Max sim time (0 = unlimited)
+	-1,                 // threads for vessel propagation (-1 = use config setting)
+	0.0,                // ephemeris table fit: start date [MJD]
+	0.0,                // ephemeris table fit: end date [MJD] (<= start: no fit)
+	1.0,                // ephemeris table fit: position tolerance [m]
+	std::string(),      // flight recording to convert (empty: none)
+	std::string(),      // benchmark output file (empty: no benchmark)
 	std::string(),      // launch scenario (empty: open Launchpad dialog)
 	std::list<std::string>() // list of plugins to load
 };
@@ -559,6 +575,9 @@ bool Config::Load(const char *fname)
 		CfgPRenderPrm.ResolutionBias = max (-2.0, min (2.0, d));
 	if (GetInt (ifs, "TileLoadFlags", i))
 		CfgPRenderPrm.TileLoadFlags = max (min(i, 3), 1);
+	if (GetInt (ifs, "ElevTileCacheSize", i))
+		CfgPRenderPrm.ElevCacheSize = max (16, i);
+	GetBool (ifs, "ElevTileLoadThread", CfgPRenderPrm.bElevLoadOnThread);
 
 	// map dialog parameters
 	if (GetInt (ifs, "MapDlgFlag", i))
@@ -606,6 +625,16 @@ bool Config::Load(const char *fname)
 	CfgPhysicsPrm.PropTLim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	CfgPhysicsPrm.PropALim[CfgPhysicsPrm.nLPropLevel-1] = 1e10;
 	GetInt (ifs, "PropSubsampling", CfgPhysicsPrm.PropSubMax);
+	if (GetInt (ifs, "PropThreads", i) && i >= 0)
+		CfgPhysicsPrm.PropThreads = i;
+	if (GetReal (ifs, "GravCacheTol", d) && d >= 0.0)
+		CfgPhysicsPrm.GravCacheTol = d;
+	if (GetReal (ifs, "PropAdaptiveTol", d) && d > 0.0)
+		CfgPhysicsPrm.PropAdaptTol = d;
+	if (GetReal (ifs, "ConicCoastPLimit", d) && d >= 0.0)
+		CfgPhysicsPrm.ConicCoast_PLimit = d;
+	GetBool (ifs, "EphemerisTables", CfgPhysicsPrm.bEphemTables);
+	GetBool (ifs, "CelestialHermiteInterp", CfgPhysicsPrm.bCelInterpHermite);
 
 #ifdef UNDEF
 	// BEGIN OBSOLETE
@@ -705,6 +734,7 @@ bool Config::Load(const char *fname)
 	GetBool (ifs, "WireframeMode", CfgDebugPrm.bWireframeMode);
     GetBool (ifs, "NormaliseNormals", CfgDebugPrm.bNormaliseNormals);
 	GetBool (ifs, "VerboseLog", CfgDebugPrm.bVerboseLog);
+	GetBool (ifs, "ShowPropStats", CfgDebugPrm.bPropStats);
 
 	GetReal (ifs, "CameraPanspeed", CfgCameraPrm.Panspeed);
 	GetReal (ifs, "CameraTerrainLimit", CfgCameraPrm.TerrainLimit);
@@ -747,6 +777,7 @@ bool Config::Load(const char *fname)
 	// record/playback parameters
 	GetInt (ifs, "RecordPosFrame", CfgRecPlayPrm.RecordPosFrame);
 	GetInt (ifs, "RecordAttFrame", CfgRecPlayPrm.RecordAttFrame);
+	GetInt (ifs, "RecordFormat", CfgRecPlayPrm.RecordFormat);
 	GetBool (ifs, "RecordTimewarp", CfgRecPlayPrm.bRecordWarp);
 	GetBool (ifs, "RecordFocusEvent", CfgRecPlayPrm.bRecordFocus);
 	GetBool (ifs, "ReplayTimewarp", CfgRecPlayPrm.bReplayWarp);
@@ -1135,6 +1166,8 @@ BOOL Config::Write (const char *fname) const
 			ofs << "NormaliseNormals = " << BoolStr (CfgDebugPrm.bNormaliseNormals) << '\n';
 		if (CfgDebugPrm.bVerboseLog != CfgDebugPrm_default.bVerboseLog || bEchoAll)
 			ofs << "VerboseLog = " << BoolStr (CfgDebugPrm.bVerboseLog) << '\n';
+		if (CfgDebugPrm.bPropStats != CfgDebugPrm_default.bPropStats || bEchoAll)
+			ofs << "ShowPropStats = " << BoolStr (CfgDebugPrm.bPropStats) << '\n';
 	}
 
 	if (memcmp (&CfgPhysicsPrm, &CfgPhysicsPrm_default, sizeof(CFG_PHYSICSPRM)) || bEchoAll) {
@@ -1177,6 +1210,18 @@ BOOL Config::Write (const char *fname) const
 #endif
 		if (CfgPhysicsPrm.PropSubMax != CfgPhysicsPrm_default.PropSubMax || bEchoAll)
 			ofs << "PropSubsampling = " << CfgPhysicsPrm.PropSubMax << '\n';
+		if (CfgPhysicsPrm.PropThreads != CfgPhysicsPrm_default.PropThreads || bEchoAll)
+			ofs << "PropThreads = " << CfgPhysicsPrm.PropThreads << '\n';
+		if (CfgPhysicsPrm.GravCacheTol != CfgPhysicsPrm_default.GravCacheTol || bEchoAll)
+			ofs << "GravCacheTol = " << CfgPhysicsPrm.GravCacheTol << '\n';
+		if (CfgPhysicsPrm.PropAdaptTol != CfgPhysicsPrm_default.PropAdaptTol || bEchoAll)
+			ofs << "PropAdaptiveTol = " << CfgPhysicsPrm.PropAdaptTol << '\n';
+		if (CfgPhysicsPrm.ConicCoast_PLimit != CfgPhysicsPrm_default.ConicCoast_PLimit || bEchoAll)
+			ofs << "ConicCoastPLimit = " << CfgPhysicsPrm.ConicCoast_PLimit << '\n';
+		if (CfgPhysicsPrm.bEphemTables != CfgPhysicsPrm_default.bEphemTables || bEchoAll)
+			ofs << "EphemerisTables = " << BoolStr (CfgPhysicsPrm.bEphemTables) << '\n';
+		if (CfgPhysicsPrm.bCelInterpHermite != CfgPhysicsPrm_default.bCelInterpHermite || bEchoAll)
+			ofs << "CelestialHermiteInterp = " << BoolStr (CfgPhysicsPrm.bCelInterpHermite) << '\n';
 	}
 
 	if (memcmp (&CfgPRenderPrm, &CfgPRenderPrm_default, sizeof(CFG_PLANETRENDERPRM)) || bEchoAll) {
@@ -1201,6 +1246,10 @@ BOOL Config::Write (const char *fname) const
 			ofs << "PlanetResolutionBias = " << CfgPRenderPrm.ResolutionBias << '\n';
 		if (CfgPRenderPrm.TileLoadFlags != CfgPRenderPrm_default.TileLoadFlags || bEchoAll)
 			ofs << "TileLoadFlags = " << CfgPRenderPrm.TileLoadFlags << '\n';
+		if (CfgPRenderPrm.ElevCacheSize != CfgPRenderPrm_default.ElevCacheSize || bEchoAll)
+			ofs << "ElevTileCacheSize = " << CfgPRenderPrm.ElevCacheSize << '\n';
+		if (CfgPRenderPrm.bElevLoadOnThread != CfgPRenderPrm_default.bElevLoadOnThread || bEchoAll)
+			ofs << "ElevTileLoadThread = " << BoolStr (CfgPRenderPrm.bElevLoadOnThread) << '\n';
 	}
 
 	if (memcmp (&CfgMapPrm, &CfgMapPrm_default, sizeof (CFG_MAPPRM)) || bEchoAll) {
@@ -1310,6 +1359,8 @@ BOOL Config::Write (const char *fname) const
 			ofs << "RecordPosFrame = " << CfgRecPlayPrm.RecordPosFrame << '\n';
 		if (CfgRecPlayPrm.RecordAttFrame != CfgRecPlayPrm_default.RecordAttFrame || bEchoAll)
 			ofs << "RecordAttFrame = " << CfgRecPlayPrm.RecordAttFrame << '\n';
+		if (CfgRecPlayPrm.RecordFormat != CfgRecPlayPrm_default.RecordFormat || bEchoAll)
+			ofs << "RecordFormat = " << CfgRecPlayPrm.RecordFormat << '\n';
 		if (CfgRecPlayPrm.bRecordWarp != CfgRecPlayPrm_default.bRecordWarp || bEchoAll)
 			ofs << "RecordTimewarp = " << BoolStr (CfgRecPlayPrm.bRecordWarp) << '\n';
 		if (CfgRecPlayPrm.bRecordFocus != CfgRecPlayPrm_default.bRecordFocus || bEchoAll)
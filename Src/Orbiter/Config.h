@@ -21,7 +21,7 @@
 // dynamic state propagation methods
 #define MAX_PROP_LEVEL  5
 #define MAX_APROP_LEVEL 5
-#define NPROP_METHOD   10
+#define NPROP_METHOD   12
 #define NAPROP_METHOD   6
 #define PROP_RK2        0
 #define PROP_RK4        1
@@ -33,6 +33,8 @@
 #define PROP_SY4        7
 #define PROP_SY6        8
 #define PROP_SY8        9
+#define PROP_DP5       10
+#define PROP_RK78      11
 
 #define SURF_MAX_PATCHLEVEL 14
 #define SURF_MAX_PATCHLEVEL2 21
@@ -78,6 +80,12 @@ struct CFG_PHYSICSPRM {
 	int    PropSubMax;			// max number of subsampling steps
 	double APropCouplingLimit;	// angle step limit for cross term suppresion
 	double APropTorqueLimit;	// angle step limit for torque suppression
+	int    PropThreads;			// threads for concurrent vessel propagation (0=auto, 1=single-threaded)
+	double GravCacheTol;		// relative error tolerance of the nonspherical gravity field cache (0=no cache)
+	double PropAdaptTol;		// relative error tolerance for the adaptive propagators (DP5, RK78)
+	double ConicCoast_PLimit;	// perturbation limit for analytic conic coasting (0=disabled)
+	bool   bEphemTables;		// use Chebyshev ephemeris tables for module ephemerides, where available
+	bool   bCelInterpHermite;	// cubic Hermite interpolation of celestial body positions within a time step
 };
 
 struct CFG_LOGICPRM {
@@ -171,6 +179,7 @@ struct CFG_DEBUGPRM {
 	bool   bWireframeMode;      // set renderer to wireframe mode?
 	bool   bNormaliseNormals;   // force auto-normalisation of all normals?
 	bool   bVerboseLog;         // verbose log output?
+	bool   bPropStats;          // show vessel propagation statistics in the debug string?
 };
 
 struct CFG_PLANETRENDERPRM {
@@ -184,6 +193,8 @@ struct CFG_PLANETRENDERPRM {
 	int    LoadFrequency;       // tile load frequency
 	int    AnisoMode;
 	DWORD  TileLoadFlags;       // flags for planetary tile load mechanism
+	int    ElevCacheSize;       // number of elevation tiles cached per planet for surface collision
+	bool   bElevLoadOnThread;   // load elevation tiles for surface collision in a separate thread
 };
 
 struct CFG_MAPPRM {
@@ -193,6 +204,7 @@ struct CFG_MAPPRM {
 struct CFG_RECPLAYPRM {
 	int    RecordPosFrame;		// recorder position/velocity data frame (0=ecl, 1=equ)
 	int    RecordAttFrame;		// recorder attitude data frame (0=ecl., 1=local hor.)
+	int    RecordFormat;		// vessel stream format (0=text, 1=binary, 2=binary with quantised attitude)
 	bool   bRecordWarp;			// write time acceleration info to recording?
 	bool   bRecordFocus;		// write focus vessel events to recording?
 	bool   bReplayWarp;			// use recorded acceleration data during playback?
@@ -282,6 +294,12 @@ struct CFG_CMDLINEPRM {
 	double FixedStep;           // fixed time step length (0 = disabled). If != 0, overrides CFG_DEBUGPRM::FixedStep
 	double MaxSysTime;          // Max session runtime (sys time). 0 = unlimited
 	double MaxSimTime;          // Max session runtime (sim time). 0 = unlimited
+	int    PropThreads;         // threads for concurrent vessel propagation (-1 = use config setting). If >= 0, overrides CFG_PHYSICSPRM::PropThreads
+	double EphemFitMJD0;        // date range for fitting ephemeris tables at session start
+	double EphemFitMJD1;        //   (EphemFitMJD1 <= EphemFitMJD0: no fit)
+	double EphemFitTol;         // position tolerance for ephemeris table fits [m]
+	std::string FRConvert;      // if not empty, convert the vessel streams of this flight recording at startup
+	std::string BenchOut;       // if not empty, run in benchmark mode and write frame statistics to this file
 	std::string LaunchScenario; // if not empty, start scenario instantly without opening Launchpad
 	std::list<std::string> LoadPlugins; // list of plugins to load
 };
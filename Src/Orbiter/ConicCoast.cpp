@@ -0,0 +1,93 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// State propagation for the analytic conic coast
+// =======================================================================
+
+#include <math.h>
+#include <algorithm>
+#include "ConicCoast.h"
+
+// ---------------------------------------------------------------------------
+
+static Quaternion RotationQuaternion (const Vector &rot)
+{
+	// quaternion for a finite rotation by rot.length() around rot
+	double a = rot.length();
+	if (!a) return Quaternion();
+	return Quaternion (rot * (sin (0.5*a)/a), cos (0.5*a));
+}
+
+// ---------------------------------------------------------------------------
+
+static Vector TorqueFreeAcc (const Vector &pmi, const Vector &omega)
+{
+	// Euler's equation without torque (left-handed system), see
+	// RigidBody::EulerInv_full
+	return Vector (
+		-(pmi.y-pmi.z)*omega.y*omega.z / pmi.x,
+		-(pmi.z-pmi.x)*omega.z*omega.x / pmi.y,
+		-(pmi.x-pmi.y)*omega.x*omega.y / pmi.z);
+}
+
+// ---------------------------------------------------------------------------
+
+void TorqueFreeRotation (Quaternion &Q, Vector &omega, const Vector &pmi, double dt,
+	double atgt, int maxstep)
+{
+	double astep = omega.length()*dt;
+	if (!astep) return;
+
+	// axisymmetric body (including the spherical case): the transverse
+	// part of omega precesses around the symmetry axis k, and the body
+	// rotates around the fixed angular momentum vector
+	const double symtol = 1e-9;
+	for (int k = 0; k < 3; k++) {
+		int i = (k+1)%3, j = (k+2)%3;
+		double I1 = pmi.data[i];
+		if (fabs (pmi.data[j]-I1) > symtol*I1) continue;
+		double lambda = (pmi.data[k]-I1)/I1 * omega.data[k] * dt;
+		Vector L (omega.x*pmi.x/I1, omega.y*pmi.y/I1, omega.z*pmi.z/I1); // angular momentum/I1
+		Vector p;
+		p.data[k] = -lambda;
+		Q.postmul (RotationQuaternion (L*dt));
+		Q.postmul (RotationQuaternion (p));
+		Q.normalise();
+		double sinl = sin(lambda), cosl = cos(lambda);
+		double wi = omega.data[i], wj = omega.data[j];
+		omega.data[i] =  wi*cosl + wj*sinl;
+		omega.data[j] = -wi*sinl + wj*cosl;
+		return;
+	}
+
+	// asymmetric body: integrate Euler's equations without torque. These
+	// steps are cheap (no force evaluations). The attitude is rotated by the
+	// mean angular velocity over the step, with a commutator term for the
+	// change of the rotation axis (2nd order Magnus expansion)
+	int nstep = (int)std::min (ceil (astep/atgt), (double)maxstep);
+	double h = dt/nstep, h05 = h*0.5, hi6 = h/6.0;
+	for (int n = 0; n < nstep; n++) {
+		Vector w0 (omega);
+		Vector a0 (TorqueFreeAcc (pmi, w0));
+		Vector w1 (w0 + a0*h05), a1 (TorqueFreeAcc (pmi, w1));
+		Vector w2 (w0 + a1*h05), a2 (TorqueFreeAcc (pmi, w2));
+		Vector w3 (w0 + a2*h),   a3 (TorqueFreeAcc (pmi, w3));
+		Q.postmul (RotationQuaternion ((w0+(w1+w2)*2.0+w3)*hi6 - crossp (w0, w3)*(h*h/12.0)));
+		omega += (a0+(a1+a2)*2.0+a3)*hi6;
+	}
+	Q.normalise();
+}
+
+// ---------------------------------------------------------------------------
+
+double ConicArcMinRadius (const Vector &r0, const Vector &v0, const Vector &r1, const Vector &v1,
+	double e, double pedist, double T, double dt)
+{
+	// the radial velocity changes sign from negative to positive only at
+	// periapsis; a closed orbit passes it at least once in half a period
+	if ((dotp (r0, v0) < 0.0 && dotp (r1, v1) >= 0.0) ||
+		(e < 1.0 && dt >= 0.5*T))
+		return pedist;
+	return std::min (r0.length(), r1.length());
+}
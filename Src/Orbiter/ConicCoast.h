@@ -0,0 +1,35 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// State propagation for the analytic conic coast (RigidBody::ConicCoast)
+// of force-free bodies: torque-free rotation of the attitude, and the
+// clearance of the conic arc covered by a step.
+// =======================================================================
+
+#ifndef __CONICCOAST_H
+#define __CONICCOAST_H
+
+#include "Vecmat.h"
+
+const int TORQUEFREE_MAXSTEP = 10000;
+// Default limit for the number of integration steps of TorqueFreeRotation
+
+void TorqueFreeRotation (Quaternion &Q, Vector &omega, const Vector &pmi, double dt,
+	double atgt, int maxstep = TORQUEFREE_MAXSTEP);
+// Propagate attitude Q and angular velocity omega (body frame) over dt
+// without external torques.
+// pmi: principal moments of inertia (mass-normalised)
+// atgt: max. rotation angle [rad] of a numerical integration step
+// maxstep: max. number of numerical integration steps
+// Axisymmetric bodies are propagated in closed form, others by integrating
+// Euler's equations.
+
+double ConicArcMinRadius (const Vector &r0, const Vector &v0, const Vector &r1, const Vector &v1,
+	double e, double pedist, double T, double dt);
+// Smallest radius of the conic arc from (r0,v0) to (r1,v1) covered in a
+// step of length dt. This is the periapsis distance pedist if the arc
+// passes periapsis (for closed orbits with period T, always if dt >= T/2),
+// otherwise the smaller of the end point radii.
+
+#endif // !__CONICCOAST_H
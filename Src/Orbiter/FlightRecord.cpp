@@ -0,0 +1,740 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Binary flight recorder streams
+// =======================================================================
+
+#include "FlightRecord.h"
+#include <string.h>
+#include <math.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+using namespace std;
+
+static const char MAGIC[8] = {'O','F','R','E','C','B','I','N'};
+static const uint32_t VERSION = 1;
+static const double EPS = 1e-8;
+
+// -----------------------------------------------------------------------
+// Background chunk writer, shared by all open records
+
+namespace {
+
+class WriteQueue {
+public:
+	static WriteQueue *Get ()
+	{
+		// never destroyed: the thread may still be running at static destruction
+		static WriteQueue *wq = new WriteQueue;
+		return wq;
+	}
+
+	void Push (FILE *f, uint64_t ofs, std::vector<char> &data)
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (!running) {
+			// a single writer, so that jobs for a file are written in order
+			// and never concurrently
+			std::thread (&WriteQueue::Proc, this).detach();
+			running = true;
+		}
+		Job job;
+		job.f = f;
+		job.ofs = ofs;
+		job.data.swap (data);
+		queue.push_back (std::move (job));
+		pending[f]++;
+		cond.notify_all();
+	}
+
+	void Wait (FILE *f)
+	{
+		// block until all jobs for f have been written
+		std::unique_lock<std::mutex> lock(mutex);
+		cond.wait (lock, [this, f] { return !pending.count (f); });
+	}
+
+private:
+	struct Job {
+		FILE *f;
+		uint64_t ofs;
+		std::vector<char> data;
+	};
+
+	WriteQueue (): running(false) {}
+
+	void Proc ()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		for (;;) {
+			cond.wait (lock, [this] { return !queue.empty(); });
+			Job job = std::move (queue.front());
+			queue.pop_front();
+			lock.unlock();
+			_fseeki64 (job.f, (__int64)job.ofs, SEEK_SET);
+			fwrite (job.data.data(), 1, job.data.size(), job.f);
+			lock.lock();
+			if (!--pending[job.f]) pending.erase (job.f);
+			cond.notify_all();
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable cond;
+	std::deque<Job> queue;
+	std::map<FILE*,int> pending; // queued or active jobs per file
+	bool running;                // writer thread started
+};
+
+template<typename T> void Append (std::vector<char> &buf, const T &v)
+{
+	const char *p = (const char*)&v;
+	buf.insert (buf.end(), p, p+sizeof(T));
+}
+
+template<typename T> T Take (const char *&p)
+{
+	T v;
+	memcpy (&v, p, sizeof(T));
+	p += sizeof(T);
+	return v;
+}
+
+}
+
+// =======================================================================
+// Helper functions
+
+bool FlightRecord::IsBinary (const char *fname)
+{
+	FILE *f = fopen (fname, "rb");
+	if (!f) return false;
+	char magic[8];
+	bool ok = (fread (magic, 1, 8, f) == 8 && !memcmp (magic, MAGIC, 8));
+	fclose (f);
+	return ok;
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecord::Euler2Quaternion (const double *a, Quaternion &q, int frm)
+{
+	double sinx = sin(a[0]), cosx = cos(a[0]);
+	double siny = sin(a[1]), cosy = cos(a[1]);
+	double sinz = sin(a[2]), cosz = cos(a[2]);
+	if (frm == 0) { // global frame
+		Matrix R (1,0,0,  0,cosx,sinx,  0,-sinx,cosx);
+		R.postmul (Matrix (cosy,0,-siny,  0,1,0,  siny,0,cosy));
+		R.postmul (Matrix (cosz,sinz,0,  -sinz,cosz,0,  0,0,1));
+		q.Set (R);
+	} else {        // local horizon frame
+		Matrix R (cosx,sinx,0,  -sinx,cosx,0,  0,0,1);
+		R.postmul (Matrix (1,0,0,  0,cosy,-siny,  0,siny,cosy));
+		R.postmul (Matrix (cosz,0,-sinz,  0,1,0,  sinz,0,cosz));
+		q.Set (R);
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecord::Quaternion2Euler (const Quaternion &q, double *a, int frm)
+{
+	// inverse of Euler2Quaternion, as computed by the text recorder
+	Matrix R;
+	R.Set (q);
+	if (frm == 0) {
+		a[0] = atan2 (R.m23, R.m33);
+		a[1] = -asin (max (-1.0, min (1.0, R.m13)));
+		a[2] = atan2 (R.m12, R.m11);
+	} else {
+		a[0] = atan2 (R.m12, R.m22);
+		a[1] = asin (max (-1.0, min (1.0, R.m32)));
+		a[2] = atan2 (R.m31, R.m33);
+	}
+}
+
+// =======================================================================
+// class FlightRecordWriter
+
+FlightRecordWriter::FlightRecordWriter ()
+{
+	f = 0;
+	fileOfs = 0;
+	nrefWritten = 0;
+	memset (&hdr, 0, sizeof(FRecHeader));
+}
+
+// -----------------------------------------------------------------------
+
+FlightRecordWriter::~FlightRecordWriter ()
+{
+	Close ();
+}
+
+// -----------------------------------------------------------------------
+
+bool FlightRecordWriter::Open (const char *fname, double mjd0, bool quantise, bool append)
+{
+	Close ();
+
+	if (append && (f = fopen (fname, "r+b"))) {
+		// continue an existing record: keep its chunks and name table, and
+		// overwrite the old chunk index. A record without index (interrupted
+		// recording) is continued after its last complete chunk.
+		FlightRecordReader rec;
+		if (rec.Open (fname) && ReadIndex ()) {
+			refs = rec.Refs();
+			nrefWritten = refs.size();
+			hdr.indexOfs = 0;
+			_fseeki64 (f, 0, SEEK_SET);
+			fwrite (&hdr, sizeof(FRecHeader), 1, f);
+			return true;
+		}
+		// not a valid record: fail rather than overwrite it
+		fclose (f);
+		f = 0;
+		index.clear();
+		return false;
+	}
+
+	f = fopen (fname, "wb");
+	if (!f) return false;
+	memcpy (hdr.magic, MAGIC, 8);
+	hdr.version = VERSION;
+	hdr.flags = (quantise ? FREC_QUANTISED : 0);
+	hdr.mjd0 = mjd0;
+	hdr.indexOfs = 0;
+	hdr.nchunk = 0;
+	fwrite (&hdr, sizeof(FRecHeader), 1, f);
+	fileOfs = sizeof(FRecHeader);
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool FlightRecordWriter::ReadIndex ()
+{
+	_fseeki64 (f, 0, SEEK_END);
+	uint64_t fsize = (uint64_t)_ftelli64 (f);
+	_fseeki64 (f, 0, SEEK_SET);
+	if (fread (&hdr, sizeof(FRecHeader), 1, f) != 1) return false;
+
+	if (hdr.indexOfs && hdr.indexOfs + (uint64_t)hdr.nchunk*sizeof(FRecChunkInfo) <= fsize) {
+		index.resize (hdr.nchunk);
+		_fseeki64 (f, (__int64)hdr.indexOfs, SEEK_SET);
+		if (fread (index.data(), sizeof(FRecChunkInfo), hdr.nchunk, f) == hdr.nchunk) {
+			fileOfs = hdr.indexOfs;
+			return true;
+		}
+	}
+
+	// no valid index: rebuild it from the chunk headers, up to the last
+	// complete chunk
+	uint64_t end = (hdr.indexOfs && hdr.indexOfs <= fsize ? hdr.indexOfs : fsize);
+	uint64_t ofs = sizeof(FRecHeader);
+	index.clear();
+	for (;;) {
+		FRecChunkHeader ch;
+		_fseeki64 (f, (__int64)ofs, SEEK_SET);
+		if (ofs + sizeof(FRecChunkHeader) > end || fread (&ch, sizeof(FRecChunkHeader), 1, f) != 1) break;
+		if (ofs + sizeof(FRecChunkHeader) + ch.size > end) break; // truncated chunk
+		FRecChunkInfo ci;
+		ci.stream = ch.stream;
+		ci.n = ch.n;
+		ci.t0 = ch.t0;
+		ci.t1 = ch.t1;
+		ci.ofs = ofs;
+		index.push_back (ci);
+		ofs += sizeof(FRecChunkHeader) + ch.size;
+	}
+	fileOfs = ofs;
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::Close ()
+{
+	if (!f) return;
+	Flush ();
+	WriteQueue::Get()->Wait (f);
+
+	// chunk index
+	hdr.indexOfs = fileOfs;
+	hdr.nchunk = (uint32_t)index.size();
+	_fseeki64 (f, (__int64)fileOfs, SEEK_SET);
+	fwrite (index.data(), sizeof(FRecChunkInfo), index.size(), f);
+	_fseeki64 (f, 0, SEEK_SET);
+	fwrite (&hdr, sizeof(FRecHeader), 1, f);
+	fclose (f);
+	f = 0;
+
+	index.clear();
+	refs.clear();
+	nrefWritten = 0;
+}
+
+// -----------------------------------------------------------------------
+
+int FlightRecordWriter::RefIndex (const char *name)
+{
+	for (size_t i = 0; i < refs.size(); i++)
+		if (refs[i] == name) return (int)i;
+	refs.push_back (name);
+	return (int)refs.size()-1;
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::AddPos (const FRecPosSample &s)
+{
+	pos.push_back (s);
+	if (pos.size() == FREC_CHUNKSIZE) FlushPos ();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::AddAtt (const FRecAttSample &s)
+{
+	att.push_back (s);
+	if (att.size() == FREC_CHUNKSIZE) FlushAtt ();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::AddEvent (double simt, const char *type, const char *data)
+{
+	FRecEvent e;
+	e.simt = simt;
+	e.type = type;
+	e.data = data;
+	evt.push_back (e);
+	if (evt.size() == FREC_CHUNKSIZE) FlushEvent ();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::Flush ()
+{
+	FlushPos ();
+	FlushAtt ();
+	FlushEvent ();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::FlushRef ()
+{
+	// name table entries must precede the first chunk that refers to them
+	if (nrefWritten == refs.size()) return;
+	std::vector<char> buf;
+	for (size_t i = nrefWritten; i < refs.size(); i++)
+		buf.insert (buf.end(), refs[i].c_str(), refs[i].c_str() + refs[i].size() + 1);
+	QueueChunk (FlightRecord::STREAM_REF, (uint32_t)(refs.size()-nrefWritten), 0.0, 0.0, buf);
+	nrefWritten = refs.size();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::FlushPos ()
+{
+	if (!f || pos.empty()) return;
+	FlushRef ();
+	size_t i, n = pos.size();
+	std::vector<char> buf;
+	buf.reserve (n*(8*sizeof(double)+3));
+	for (i = 0; i < n; i++) Append (buf, pos[i].simt);
+	for (i = 0; i < n; i++) Append (buf, (uint8_t)pos[i].frm);
+	for (i = 0; i < n; i++) Append (buf, (int16_t)pos[i].ref);
+	for (int j = 0; j < 3; j++)
+		for (i = 0; i < n; i++) Append (buf, pos[i].rpos.data[j]);
+	for (int j = 0; j < 3; j++)
+		for (i = 0; i < n; i++) Append (buf, pos[i].rvel.data[j]);
+	QueueChunk (FlightRecord::STREAM_POS, (uint32_t)n, pos.front().simt, pos.back().simt, buf);
+	pos.clear();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::FlushAtt ()
+{
+	if (!f || att.empty()) return;
+	FlushRef ();
+	size_t i, n = att.size();
+	std::vector<char> buf;
+	buf.reserve (n*(5*sizeof(double)+3));
+	for (i = 0; i < n; i++) Append (buf, att[i].simt);
+	for (i = 0; i < n; i++) Append (buf, (uint8_t)att[i].frm);
+	for (i = 0; i < n; i++) Append (buf, (int16_t)att[i].ref);
+	for (int j = 0; j < 4; j++) {
+		for (i = 0; i < n; i++) {
+			const Quaternion &q = att[i].q;
+			double v = (j == 0 ? q.qs : j == 1 ? q.qvx : j == 2 ? q.qvy : q.qvz);
+			if (hdr.flags & FREC_QUANTISED) Append (buf, (int16_t)floor (v*32767.0 + 0.5));
+			else                            Append (buf, v);
+		}
+	}
+	QueueChunk (FlightRecord::STREAM_ATT, (uint32_t)n, att.front().simt, att.back().simt, buf);
+	att.clear();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::FlushEvent ()
+{
+	if (!f || evt.empty()) return;
+	size_t i, n = evt.size();
+	std::vector<char> buf;
+	for (i = 0; i < n; i++) Append (buf, evt[i].simt);
+	for (i = 0; i < n; i++) Append (buf, (uint32_t)(evt[i].type.size() + evt[i].data.size() + 2));
+	for (i = 0; i < n; i++) {
+		buf.insert (buf.end(), evt[i].type.c_str(), evt[i].type.c_str() + evt[i].type.size() + 1);
+		buf.insert (buf.end(), evt[i].data.c_str(), evt[i].data.c_str() + evt[i].data.size() + 1);
+	}
+	QueueChunk (FlightRecord::STREAM_EVENT, (uint32_t)n, evt.front().simt, evt.back().simt, buf);
+	evt.clear();
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordWriter::QueueChunk (uint32_t stream, uint32_t n, double t0, double t1, std::vector<char> &data)
+{
+	FRecChunkHeader ch;
+	memset (&ch, 0, sizeof(FRecChunkHeader));
+	ch.stream = stream;
+	ch.n = n;
+	ch.t0 = t0;
+	ch.t1 = t1;
+	ch.size = (uint32_t)data.size();
+	data.insert (data.begin(), (const char*)&ch, (const char*)&ch + sizeof(FRecChunkHeader));
+
+	FRecChunkInfo ci;
+	ci.stream = stream;
+	ci.n = n;
+	ci.t0 = t0;
+	ci.t1 = t1;
+	ci.ofs = fileOfs;
+	index.push_back (ci);
+
+	uint64_t ofs = fileOfs;
+	fileOfs += data.size();
+	WriteQueue::Get()->Push (f, ofs, data);
+}
+
+// -----------------------------------------------------------------------
+
+bool FlightRecordWriter::ImportText (const char *posname, const char *frbname, bool quantise)
+{
+	ifstream ifs (posname);
+	if (!ifs) return false;
+
+	FlightRecordWriter w;
+	if (!w.Open (frbname, 0.0, quantise)) return false;
+
+	char cbuf[1024];
+	string fname (posname);
+	int ref = -1, frm = 0, crd = 0;
+	double simt, x, y, z, vx, vy, vz;
+
+	// position/velocity stream
+	while (ifs.getline (cbuf, 1024)) {
+		if (!strncmp (cbuf, "REF", 3)) {
+			istringstream iss (cbuf+4); string name; iss >> name;
+			ref = w.RefIndex (name.c_str());
+		} else if (!strncmp (cbuf, "FRM", 3)) {
+			frm = (strstr (cbuf+4, "EQUATORIAL") ? 1 : 0);
+		} else if (!strncmp (cbuf, "CRD", 3)) {
+			crd = (strstr (cbuf+4, "POLAR") ? 1 : 0);
+		} else if (!strncmp (cbuf, "STARTMJD", 8)) {
+			sscanf (cbuf+9, "%lf", &w.hdr.mjd0);
+		} else if (sscanf (cbuf, "%lf%lf%lf%lf%lf%lf%lf", &simt, &x, &y, &z, &vx, &vy, &vz) == 7) {
+			if (crd == 1) { // map from polar coords
+				double xz, r = x, phi = y, tht = z;
+				double vr = vx, vphi = vy, vtht = vz;
+				double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
+				y = r*stht; xz = r*ctht;
+				x = xz*cphi; z = xz*sphi;
+				vx = vr*cphi*ctht - r*vphi*sphi*ctht - r*vtht*cphi*stht;
+				vy = vr*stht + r*vtht*ctht;
+				vz = vr*sphi*ctht + r*vphi*cphi*ctht - r*vtht*sphi*stht;
+			}
+			FRecPosSample s;
+			s.simt = simt;
+			s.frm = frm;
+			s.ref = (ref >= 0 ? ref : w.RefIndex (""));
+			s.rpos.Set (x, y, z);
+			s.rvel.Set (vx, vy, vz);
+			w.AddPos (s);
+		}
+	}
+
+	// attitude stream
+	ifs.close(); ifs.clear();
+	ifs.open (fname.substr (0, fname.size()-3) + "att");
+	ref = -1, frm = 0;
+	while (ifs && ifs.getline (cbuf, 1024)) {
+		if (!strncmp (cbuf, "REF", 3)) {
+			istringstream iss (cbuf+4); string name; iss >> name;
+			ref = w.RefIndex (name.c_str());
+		} else if (!strncmp (cbuf, "FRM", 3)) {
+			frm = (strstr (cbuf+4, "HORIZON") ? 1 : 0);
+		} else if (strncmp (cbuf, "STARTMJD", 8)) {
+			double a[3];
+			if (sscanf (cbuf, "%lf%lf%lf%lf", &simt, a+0, a+1, a+2) != 4) continue;
+			FRecAttSample s;
+			s.simt = simt;
+			s.frm = frm;
+			s.ref = ref;
+			FlightRecord::Euler2Quaternion (a, s.q, frm);
+			w.AddAtt (s);
+		}
+	}
+
+	// articulation stream
+	ifs.close(); ifs.clear();
+	ifs.open (fname.substr (0, fname.size()-3) + "atc");
+	while (ifs && ifs.getline (cbuf, 1024)) {
+		char *s = cbuf, *e;
+		simt = strtod (s, &e);
+		if (e == s) continue;
+		while (*e == ' ' || *e == '\t') e++;
+		char *d = e + strcspn (e, " \t");
+		if (*d) *d++ = '\0';
+		w.AddEvent (simt, e, d);
+	}
+
+	w.Close ();
+	return true;
+}
+
+// =======================================================================
+// class FlightRecordReader
+
+FlightRecordReader::FlightRecordReader ()
+{
+	mjd0 = 0.0;
+}
+
+// -----------------------------------------------------------------------
+
+bool FlightRecordReader::Open (const char *fname)
+{
+	FILE *f = fopen (fname, "rb");
+	if (!f) return false;
+	_fseeki64 (f, 0, SEEK_END);
+	uint64_t fsize = (uint64_t)_ftelli64 (f);
+	_fseeki64 (f, 0, SEEK_SET);
+	std::vector<char> buf ((size_t)fsize);
+	bool ok = (fsize >= sizeof(FRecHeader) && fread (buf.data(), 1, buf.size(), f) == buf.size());
+	fclose (f);
+	if (!ok) return false;
+
+	FRecHeader hdr;
+	memcpy (&hdr, buf.data(), sizeof(FRecHeader));
+	if (memcmp (hdr.magic, MAGIC, 8) || hdr.version != VERSION) return false;
+	bool quantised = (hdr.flags & FREC_QUANTISED) != 0;
+	mjd0 = hdr.mjd0;
+
+	// use the index to size the columns. Without index (interrupted
+	// recording), chunks are scanned up to the end of the file.
+	uint64_t end = fsize;
+	if (hdr.indexOfs && hdr.indexOfs + (uint64_t)hdr.nchunk*sizeof(FRecChunkInfo) <= fsize) {
+		size_t npos = 0, natt = 0, nevt = 0;
+		const FRecChunkInfo *ci = (const FRecChunkInfo*)(buf.data() + hdr.indexOfs);
+		for (uint32_t i = 0; i < hdr.nchunk; i++) {
+			FRecChunkInfo c;
+			memcpy (&c, ci+i, sizeof(FRecChunkInfo));
+			if      (c.stream == FlightRecord::STREAM_POS)   npos += c.n;
+			else if (c.stream == FlightRecord::STREAM_ATT)   natt += c.n;
+			else if (c.stream == FlightRecord::STREAM_EVENT) nevt += c.n;
+		}
+		// a damaged index must not reserve more samples than the file can hold
+		npos = (size_t)min ((uint64_t)npos, fsize/(7*sizeof(double)+3));
+		natt = (size_t)min ((uint64_t)natt, fsize/(sizeof(double)+3+4*sizeof(int16_t)));
+		nevt = (size_t)min ((uint64_t)nevt, fsize/(sizeof(double)+sizeof(uint32_t)+2));
+		pos_t.reserve (npos); pos_frm.reserve (npos); pos_ref.reserve (npos);
+		for (int j = 0; j < 6; j++) pos_v[j].reserve (npos);
+		att_t.reserve (natt); att_frm.reserve (natt); att_ref.reserve (natt);
+		for (int j = 0; j < 4; j++) att_q[j].reserve (natt);
+		evt.reserve (nevt);
+		end = hdr.indexOfs;
+	}
+
+	uint64_t ofs = sizeof(FRecHeader);
+	while (ofs + sizeof(FRecChunkHeader) <= end) {
+		FRecChunkHeader ch;
+		memcpy (&ch, buf.data() + ofs, sizeof(FRecChunkHeader));
+		ofs += sizeof(FRecChunkHeader);
+		if (ofs + ch.size > end) break; // truncated chunk
+		if (!ReadChunk (buf.data() + ofs, ch, quantised)) return false;
+		ofs += ch.size;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+bool FlightRecordReader::ReadChunk (const char *p, const FRecChunkHeader &ch, bool quantised)
+{
+	// The sample count and sizes come from the file: they are checked against
+	// the chunk size (which the caller has checked against the file size)
+	// before any data is read
+	uint32_t i, n = ch.n;
+	const char *end = p + ch.size;
+	switch (ch.stream) {
+	case FlightRecord::STREAM_POS:
+		if (ch.size != (uint64_t)n*(7*sizeof(double)+3)) return false;
+		for (i = 0; i < n; i++) pos_t.push_back (Take<double> (p));
+		for (i = 0; i < n; i++) pos_frm.push_back (Take<uint8_t> (p));
+		for (i = 0; i < n; i++) pos_ref.push_back (Take<int16_t> (p));
+		for (int j = 0; j < 6; j++)
+			for (i = 0; i < n; i++) pos_v[j].push_back (Take<double> (p));
+		break;
+	case FlightRecord::STREAM_ATT:
+		if (ch.size != (uint64_t)n*(sizeof(double)+3+4*(quantised ? sizeof(int16_t) : sizeof(double)))) return false;
+		for (i = 0; i < n; i++) att_t.push_back (Take<double> (p));
+		for (i = 0; i < n; i++) att_frm.push_back (Take<uint8_t> (p));
+		for (i = 0; i < n; i++) att_ref.push_back (Take<int16_t> (p));
+		for (int j = 0; j < 4; j++)
+			for (i = 0; i < n; i++)
+				att_q[j].push_back (quantised ? Take<int16_t> (p)/32767.0 : Take<double> (p));
+		break;
+	case FlightRecord::STREAM_EVENT: {
+		if ((uint64_t)n*(sizeof(double)+sizeof(uint32_t)) > ch.size) return false;
+		const char *pt = p, *pl = p + n*sizeof(double), *ps = pl + n*sizeof(uint32_t);
+		for (i = 0; i < n; i++) {
+			FRecEvent e;
+			e.simt = Take<double> (pt);
+			uint32_t len = Take<uint32_t> (pl);
+			// "type\0data\0", within the chunk
+			if (len > (size_t)(end-ps)) return false;
+			const char *pd = (const char*)memchr (ps, '\0', len);
+			if (!pd || !memchr (pd+1, '\0', ps+len-pd-1)) return false;
+			e.type = ps;
+			e.data = pd+1;
+			ps += len;
+			evt.push_back (e);
+		}
+		} break;
+	case FlightRecord::STREAM_REF:
+		if (n > ch.size) return false;
+		for (i = 0; i < n; i++) {
+			const char *pe = (const char*)memchr (p, '\0', end-p);
+			if (!pe) return false;
+			refs.push_back (p);
+			p = pe+1;
+		}
+		break;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordReader::GetPos (size_t i, FRecPosSample &s) const
+{
+	s.simt = pos_t[i];
+	s.frm = pos_frm[i];
+	s.ref = pos_ref[i];
+	s.rpos.Set (pos_v[0][i], pos_v[1][i], pos_v[2][i]);
+	s.rvel.Set (pos_v[3][i], pos_v[4][i], pos_v[5][i]);
+}
+
+// -----------------------------------------------------------------------
+
+void FlightRecordReader::GetAtt (size_t i, FRecAttSample &s) const
+{
+	s.simt = att_t[i];
+	s.frm = att_frm[i];
+	s.ref = att_ref[i];
+	s.q.Set (att_q[1][i], att_q[2][i], att_q[3][i], att_q[0][i]);
+	double len = sqrt (s.q.qs*s.q.qs + s.q.qvx*s.q.qvx + s.q.qvy*s.q.qvy + s.q.qvz*s.q.qvz);
+	if (len > EPS && fabs (len-1.0) > EPS) { // renormalise quantised values
+		s.q.Set (s.q.qvx/len, s.q.qvy/len, s.q.qvz/len, s.q.qs/len);
+	}
+}
+
+// -----------------------------------------------------------------------
+
+size_t FlightRecordReader::FindPos (double t) const
+{
+	size_t i = upper_bound (pos_t.begin(), pos_t.end(), t) - pos_t.begin();
+	return (i ? i-1 : 0);
+}
+
+// -----------------------------------------------------------------------
+
+size_t FlightRecordReader::FindAtt (double t) const
+{
+	size_t i = upper_bound (att_t.begin(), att_t.end(), t) - att_t.begin();
+	return (i ? i-1 : 0);
+}
+
+// -----------------------------------------------------------------------
+
+bool FlightRecordReader::ExportText (const char *posname) const
+{
+	string fname (posname), base (fname.substr (0, fname.size()-3));
+	size_t i;
+	int ref, frm;
+
+	// position/velocity stream (cartesian)
+	ofstream ofs (fname);
+	if (!ofs) return false;
+	ofs << "STARTMJD " << setprecision(12) << mjd0 << endl;
+	ref = -1, frm = -1;
+	for (i = 0; i < nPos(); i++) {
+		FRecPosSample s;
+		GetPos (i, s);
+		if (s.ref != ref || s.frm != frm) {
+			ref = s.ref, frm = s.frm;
+			ofs << "REF " << (ref >= 0 && ref < (int)refs.size() ? refs[ref] : string()) << endl;
+			ofs << "FRM " << (frm == 0 ? "ECLIPTIC" : "EQUATORIAL") << endl;
+			ofs << "CRD CARTESIAN" << endl;
+		}
+		ofs << setprecision(10) << s.simt << ' ';
+		ofs << setprecision(12) << s.rpos.x << ' ' << s.rpos.y << ' ' << s.rpos.z << ' ';
+		ofs << setprecision(10) << s.rvel.x << ' ' << s.rvel.y << ' ' << s.rvel.z << endl;
+	}
+	ofs.close();
+
+	// attitude stream (Euler angles)
+	ofs.open (base + "att");
+	if (!ofs) return false;
+	ofs << "STARTMJD " << setprecision(12) << mjd0 << endl;
+	ref = -2, frm = -1;
+	for (i = 0; i < nAtt(); i++) {
+		FRecAttSample s;
+		GetAtt (i, s);
+		if (s.frm != frm || (s.frm == 1 && s.ref != ref)) {
+			ref = s.ref, frm = s.frm;
+			if (frm == 0) ofs << "FRM ECLIPTIC" << endl;
+			else ofs << "REF " << (ref >= 0 && ref < (int)refs.size() ? refs[ref] : string()) << "\nFRM HORIZON" << endl;
+		}
+		double a[3];
+		FlightRecord::Quaternion2Euler (s.q, a, s.frm);
+		ofs << setprecision(10) << s.simt << setprecision(6);
+		for (int j = 0; j < 3; j++) ofs << ' ' << a[j];
+		ofs << endl;
+	}
+	ofs.close();
+
+	// articulation stream
+	ofs.open (base + "atc");
+	if (!ofs) return false;
+	for (i = 0; i < nEvent(); i++) {
+		ofs << setprecision(10) << evt[i].simt << ' ' << evt[i].type;
+		if (evt[i].data.size()) ofs << ' ' << evt[i].data;
+		ofs << endl;
+	}
+	return true;
+}
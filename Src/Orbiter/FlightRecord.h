@@ -0,0 +1,203 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Binary flight recorder streams (.frb)
+// The position, attitude and articulation streams of a vessel are stored
+// in a single file as a sequence of chunks. Each chunk holds up to
+// FREC_CHUNKSIZE samples of one stream, column by column. Positions and
+// attitudes are stored as cartesian vectors and quaternions, so no
+// coordinate conversion is required on playback. Celestial bodies are
+// referred to by index into a name table stored in the same file.
+//
+// File layout:
+//   FRecHeader
+//   chunks: FRecChunkHeader, followed by the column data
+//   chunk index: FRecChunkInfo[nchunk] at FRecHeader::indexOfs
+// A file without index (recording interrupted) is read by scanning the
+// chunks sequentially.
+//
+// Column layout by stream:
+//   POS:   t[n], frm[n] (uint8), ref[n] (int16), x,y,z,vx,vy,vz [n] (double)
+//   ATT:   t[n], frm[n] (uint8), ref[n] (int16), qs,qx,qy,qz [n]
+//          (double, or int16 scaled by 32767 if FREC_QUANTISED is set)
+//   EVENT: t[n], len[n] (uint32), then n strings "type\0data\0" of length len
+//   REF:   n strings "name\0"; indices continue from previous REF chunks
+// =======================================================================
+
+#ifndef __FLIGHTRECORD_H
+#define __FLIGHTRECORD_H
+
+#include "Vecmat.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <string>
+
+#define FREC_QUANTISED 0x0001 // attitude quaternions stored as int16
+
+const int FREC_CHUNKSIZE = 1024;
+
+struct FRecHeader {
+	char     magic[8];   // "OFRECBIN"
+	uint32_t version;    // file format version
+	uint32_t flags;      // FREC_xxx
+	double   mjd0;       // MJD at recording time 0
+	uint64_t indexOfs;   // file offset of chunk index (0: no index)
+	uint32_t nchunk;     // number of entries in chunk index
+	uint32_t reserved;
+};
+
+struct FRecChunkHeader {
+	uint32_t stream;     // FlightRecord::Stream
+	uint32_t n;          // number of samples
+	double   t0, t1;     // time range [s]
+	uint32_t size;       // column data size [bytes]
+	uint32_t reserved;
+};
+
+struct FRecChunkInfo {
+	uint32_t stream;     // FlightRecord::Stream
+	uint32_t n;          // number of samples
+	double   t0, t1;     // time range [s]
+	uint64_t ofs;        // file offset of chunk header
+};
+
+struct FRecPosSample {   // position/velocity sample
+	double simt;         // recording time [s]
+	int frm;             // 0=ecliptic, 1=equatorial
+	int ref;             // reference body index
+	Vector rpos, rvel;   // reference-relative position, velocity
+};
+
+struct FRecAttSample {   // attitude sample
+	double simt;         // recording time [s]
+	int frm;             // 0=ecliptic, 1=local horizon
+	int ref;             // reference body index (-1 if not defined)
+	Quaternion q;        // orientation
+};
+
+struct FRecEvent {       // articulation or custom event
+	double simt;         // recording time [s]
+	std::string type;    // event type, e.g. "ENG"
+	std::string data;    // event parameters
+};
+
+namespace FlightRecord {
+	enum Stream { STREAM_POS = 1, STREAM_ATT = 2, STREAM_EVENT = 3, STREAM_REF = 4 };
+
+	bool IsBinary (const char *fname);
+	// true if fname is a binary flight record
+
+	void Euler2Quaternion (const double *a, Quaternion &q, int frm);
+	void Quaternion2Euler (const Quaternion &q, double *a, int frm);
+	// convert between the Euler angles of the text attitude stream and
+	// quaternions, for the given attitude frame (0=ecliptic, 1=horizon)
+}
+
+// =======================================================================
+// Writes a binary flight record. Completed chunks are written on a
+// background thread, so that adding samples never blocks on file I/O.
+
+class FlightRecordWriter {
+public:
+	FlightRecordWriter ();
+	~FlightRecordWriter ();
+
+	bool Open (const char *fname, double mjd0, bool quantise = false, bool append = false);
+	// Create a record file. If append is set, an existing record is continued.
+	// Returns false if append is set and the file exists but is not a valid
+	// record.
+
+	void Close ();
+	// Write outstanding samples and the chunk index, and close the file
+
+	inline bool IsOpen () const { return f != 0; }
+
+	int RefIndex (const char *name);
+	// index of a reference body name, added to the name table if required
+
+	void AddPos (const FRecPosSample &s);
+	void AddAtt (const FRecAttSample &s);
+	void AddEvent (double simt, const char *type, const char *data);
+
+	void Flush ();
+	// Queue partially filled chunks for writing
+
+	static bool ImportText (const char *posname, const char *frbname, bool quantise = false);
+	// Convert the text streams (.pos, .att, .atc) of a vessel to a binary
+	// record. posname is the name of the position stream.
+
+private:
+	void FlushPos ();
+	void FlushAtt ();
+	void FlushEvent ();
+	void FlushRef ();
+	void QueueChunk (uint32_t stream, uint32_t n, double t0, double t1, std::vector<char> &data);
+
+	bool ReadIndex ();
+	// Read the header and chunk index of the open file for appending, or
+	// rebuild the index from the chunk headers if the file has none.
+	// Sets fileOfs to the end of the last chunk.
+
+	FILE *f;
+	FRecHeader hdr;
+	uint64_t fileOfs;                   // file size after all queued chunks
+	std::vector<FRecChunkInfo> index;
+	std::vector<std::string> refs;      // reference body name table
+	size_t nrefWritten;                 // names already written to file
+
+	std::vector<FRecPosSample> pos;     // samples of unfinished chunks
+	std::vector<FRecAttSample> att;
+	std::vector<FRecEvent> evt;
+};
+
+// =======================================================================
+// Reads a binary flight record into memory. Samples are located by binary
+// search on the time columns.
+
+class FlightRecordReader {
+public:
+	FlightRecordReader ();
+
+	bool Open (const char *fname);
+	// Read a binary record. Returns false if the file doesn't exist or is
+	// not a valid record.
+
+	inline double MJD0 () const { return mjd0; }
+	inline const std::vector<std::string> &Refs () const { return refs; }
+
+	inline size_t nPos () const { return pos_t.size(); }
+	inline double PosTime (size_t i) const { return pos_t[i]; }
+	void GetPos (size_t i, FRecPosSample &s) const;
+
+	inline size_t nAtt () const { return att_t.size(); }
+	inline double AttTime (size_t i) const { return att_t[i]; }
+	void GetAtt (size_t i, FRecAttSample &s) const;
+
+	inline size_t nEvent () const { return evt.size(); }
+	inline const FRecEvent &GetEvent (size_t i) const { return evt[i]; }
+
+	size_t FindPos (double t) const;
+	size_t FindAtt (double t) const;
+	// index of the last sample with time <= t (0 if t precedes all samples)
+
+	bool ExportText (const char *posname) const;
+	// write the record as text streams (.pos, .att, .atc). posname is the
+	// name of the position stream.
+
+private:
+	bool ReadChunk (const char *p, const FRecChunkHeader &ch, bool quantised);
+
+	double mjd0;
+	std::vector<std::string> refs;
+	std::vector<double> pos_t, pos_v[6];
+	std::vector<uint8_t> pos_frm;
+	std::vector<int16_t> pos_ref;
+	std::vector<double> att_t, att_q[4];
+	std::vector<uint8_t> att_frm;
+	std::vector<int16_t> att_ref;
+	std::vector<FRecEvent> evt;
+};
+
+#endif // !__FLIGHTRECORD_H
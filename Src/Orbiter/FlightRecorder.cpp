@@ -15,8 +15,12 @@
 #include "Pane.h"
 #include "State.h"
 #include "MenuInfoBar.h"
+#include "FlightRecord.h"
 #include <fstream>
+#include <sstream>
 #include <string>
+#include <algorithm>
+#include <climits>
 #include <filesystem>
 namespace fs = std::filesystem;
 
@@ -55,7 +59,7 @@ Vessel *vfocus = NULL;  // focus vessel as defined by playback stream
 // Local prototypes
 // ================================================================
 
-void Euler2Quaternion (double *a, Quaternion &q, int frm);
+template<class T> int SeekSample (const T *rec, int n, int i, double t);
 
 
 // ================================================================
@@ -86,6 +90,7 @@ void Vessel::FRecorder_Reset ()
 	WarpDelay = 0.0;
 	vfocus = NULL;
 	FRatc_stream = 0;
+	FRwriter = 0;
 }
 
 void Vessel::FRecorder_Activate (bool active, const char *fname, bool append)
@@ -103,9 +108,23 @@ void Vessel::FRecorder_Activate (bool active, const char *fname, bool append)
 		MJDofs = td.MJD0;
 		//frec_last.frm = 1;  // for now, record in equatorial frame by default
 		frec_last.crd = 1;  // for now, record in polar coordinates by default
+		int fmt = g_pOrbiter->Cfg()->CfgRecPlayPrm.RecordFormat;
+		if (fmt > 0) { // binary stream
+			strcpy (cbuf+strlen(cbuf)-3, "frb");
+			FRwriter = new FlightRecordWriter; TRACENEW
+			if (!FRwriter->Open (cbuf, MJDofs, fmt == 2, append)) {
+				LOGOUT_ERR("Could not open flight record %s", cbuf);
+				delete FRwriter;
+				FRwriter = 0;
+			}
+		}
 	} else {
 		bFRrecord = false;
 		FRecorder_Save (true);
+		if (FRwriter) {
+			delete FRwriter; // closes the stream
+			FRwriter = 0;
+		}
 	}
 }
 
@@ -156,31 +175,43 @@ void Vessel::FRecorder_Save (bool force)
 				}
 				frec_last.rvel    = vel;
 
-				ofstream ofs (FRfname, ios::app);
-				ofs << setprecision(10)  << (frec_last.simt-Tofs) << ' ';
-				if (frec_last.crd == 1) { // store in polar coords
-					double r = frec_last.rpos.length();
-					double phi = atan2 (frec_last.rpos.z, frec_last.rpos.x);
-					double tht = asin (frec_last.rpos.y/r);
-					ofs << setprecision(12) << r << ' ' << phi << ' ' << tht << ' ';
-					double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
-					double arg  = cphi*frec_last.rvel.x + sphi*frec_last.rvel.z;
-					double vr   = stht*frec_last.rvel.y + ctht*arg;
-					double vphi = (cphi*frec_last.rvel.z - sphi*frec_last.rvel.x) / (r*ctht);
-					double vtht = (ctht*frec_last.rvel.y - stht*arg)/r;
-					ofs << setprecision(10) << vr << ' ' << vphi << ' ' << vtht << endl;
+				if (FRwriter) {
+					FRecPosSample s;
+					s.simt = frec_last.simt-Tofs;
+					s.frm  = frec_last.frm;
+					s.ref  = FRwriter->RefIndex (ref->Name());
+					s.rpos = frec_last.rpos;
+					s.rvel = frec_last.rvel;
+					FRwriter->AddPos (s);
 				} else {
-					ofs << setprecision(12) << frec_last.rpos.x << ' ' << frec_last.rpos.y << ' ' << frec_last.rpos.z << ' ';
-					ofs << setprecision(10) << frec_last.rvel.x << ' ' << frec_last.rvel.y << ' ' << frec_last.rvel.z << endl;
+					ofstream ofs (FRfname, ios::app);
+					ofs << setprecision(10)  << (frec_last.simt-Tofs) << ' ';
+					if (frec_last.crd == 1) { // store in polar coords
+						double r = frec_last.rpos.length();
+						double phi = atan2 (frec_last.rpos.z, frec_last.rpos.x);
+						double tht = asin (frec_last.rpos.y/r);
+						ofs << setprecision(12) << r << ' ' << phi << ' ' << tht << ' ';
+						double sphi = sin(phi), cphi = cos(phi), stht = sin(tht), ctht = cos(tht);
+						double arg  = cphi*frec_last.rvel.x + sphi*frec_last.rvel.z;
+						double vr   = stht*frec_last.rvel.y + ctht*arg;
+						double vphi = (cphi*frec_last.rvel.z - sphi*frec_last.rvel.x) / (r*ctht);
+						double vtht = (ctht*frec_last.rvel.y - stht*arg)/r;
+						ofs << setprecision(10) << vr << ' ' << vphi << ' ' << vtht << endl;
+					} else {
+						ofs << setprecision(12) << frec_last.rpos.x << ' ' << frec_last.rpos.y << ' ' << frec_last.rpos.z << ' ';
+						ofs << setprecision(10) << frec_last.rvel.x << ' ' << frec_last.rvel.y << ' ' << frec_last.rvel.z << endl;
+					}
 				}
 			}
 		}
 		if (cbody != ref) {
-			ofstream ofs(FRfname, isfirst ? ios::trunc : ios::app);
-			ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
-			ofs << "REF " << cbody->Name() << endl;
-			ofs << "FRM " << (frec_last.frm == 0 ? "ECLIPTIC" : "EQUATORIAL") << endl;
-			ofs << "CRD " << (frec_last.crd == 0 ? "CARTESIAN" : "POLAR") << endl;
+			if (!FRwriter) { // binary samples carry their reference
+				ofstream ofs(FRfname, isfirst ? ios::trunc : ios::app);
+				ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
+				ofs << "REF " << cbody->Name() << endl;
+				ofs << "FRM " << (frec_last.frm == 0 ? "ECLIPTIC" : "EQUATORIAL") << endl;
+				ofs << "CRD " << (frec_last.crd == 0 ? "CARTESIAN" : "POLAR") << endl;
+			}
 			frec_last.ref = ref = cbody;
 		}
 	} 
@@ -234,13 +265,24 @@ void Vessel::FRecorder_Save (bool force)
 				if (diff > alim) attforce = true;
 			}
 			if (attforce) {
-				char cbuf[256];
-				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
-				ofstream ofs (cbuf, ios::app);
-				ofs << setprecision(10) << (td.SimT1-Tofs) << setprecision(6);
-				for (i = 0; i < 3; i++)
-					ofs << ' ' << (/*frec_att_last.att[i] =*/ a[i]);
-				ofs << endl;
+				if (FRwriter) {
+					// store the orientation as reconstructed from the angles, so
+					// that playback is identical to the text stream
+					FRecAttSample s;
+					s.simt = td.SimT1-Tofs;
+					s.frm  = frec_att_last.frm;
+					s.ref  = (s.frm == 1 ? FRwriter->RefIndex (ref->Name()) : -1);
+					FlightRecord::Euler2Quaternion (a, s.q, s.frm);
+					FRwriter->AddAtt (s);
+				} else {
+					char cbuf[256];
+					strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
+					ofstream ofs (cbuf, ios::app);
+					ofs << setprecision(10) << (td.SimT1-Tofs) << setprecision(6);
+					for (i = 0; i < 3; i++)
+						ofs << ' ' << (/*frec_att_last.att[i] =*/ a[i]);
+					ofs << endl;
+				}
 				frec_att_last.q.Set (q);
 				frec_att_last_syst = td.SysT1;
 				frec_att_last.simt = td.SimT1;
@@ -248,19 +290,21 @@ void Vessel::FRecorder_Save (bool force)
 		
 		}
 		if (ref != sp.ref) {
-			char cbuf[256];
-			strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
-			ofstream ofs (cbuf, isfirst ? ios::trunc : ios::app);
-			if (isfirst)
-				ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
-			switch (frec_att_last.frm) {
-			case 0:
-				ofs << "FRM ECLIPTIC" << endl;
-				break;
-			case 1:
-				ofs << "REF " << sp.ref->Name() << endl;
-				ofs << "FRM HORIZON" << endl;
-				break;
+			if (!FRwriter) {
+				char cbuf[256];
+				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "att");
+				ofstream ofs (cbuf, isfirst ? ios::trunc : ios::app);
+				if (isfirst)
+					ofs << "STARTMJD " << setprecision(12) << MJDofs << endl;
+				switch (frec_att_last.frm) {
+				case 0:
+					ofs << "FRM ECLIPTIC" << endl;
+					break;
+				case 1:
+					ofs << "REF " << sp.ref->Name() << endl;
+					ofs << "FRM HORIZON" << endl;
+					break;
+				}
 			}
 			frec_att_last.ref = ref = sp.ref;
 		}
@@ -283,22 +327,30 @@ void Vessel::FRecorder_Save (bool force)
 	dt = td.SimT1-frec_eng_simt;
 	alim = min (0.2, 0.1/dt);
 	ofstream ofs;
+	ostringstream oss;
+	ostream &eng = (FRwriter ? (ostream&)oss : (ostream&)ofs);
 	for (j = 0; j < m_thruster.size(); j++) {
 		if (fabs(frec_eng[j]-m_thruster[j]->level) > alim || force) {
 			if (!bfopen) {
 				frec_eng_simt = td.SimT1;
-				char cbuf[256];
-				strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
-				ofs.open (cbuf, isfirst ? ios::trunc : ios::app);
-				ofs << setprecision(10) << (frec_eng_simt-Tofs) << " ENG";
+				if (!FRwriter) {
+					char cbuf[256];
+					strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
+					ofs.open (cbuf, isfirst ? ios::trunc : ios::app);
+					ofs << setprecision(10) << (frec_eng_simt-Tofs) << " ENG";
+				}
 				bfopen = true;
 			}
-			ofs << ' ' << j << ':' << setprecision(2) << (frec_eng[j] = m_thruster[j]->level);
+			eng << ' ' << j << ':' << setprecision(2) << (frec_eng[j] = m_thruster[j]->level);
 		}
 	}
 	if (bfopen) {
-		ofs << endl;
-		ofs.close();
+		if (FRwriter) {
+			FRwriter->AddEvent (frec_eng_simt-Tofs, "ENG", oss.str().c_str()+1);
+		} else {
+			ofs << endl;
+			ofs.close();
+		}
 	}
 }
 
@@ -306,6 +358,10 @@ void Vessel::FRecorder_Save (bool force)
 void Vessel::FRecorder_SaveEvent (const char *event_type, const char *event)
 {
 	if (!bFRrecord) return;
+	if (FRwriter) {
+		FRwriter->AddEvent (td.SimT1-Tofs, event_type, event);
+		return;
+	}
 	char cbuf[256];
 	strcpy (cbuf, FRfname); strcpy (cbuf+strlen(cbuf)-3, "atc");
 	ofstream ofs(cbuf, ios::app);
@@ -349,6 +405,10 @@ void Vessel::FRecorder_Clear ()
 		delete FRatc_stream;
 		FRatc_stream = 0;
 	}
+	if (FRwriter) {
+		delete FRwriter;
+		FRwriter = 0;
+	}
 	bFRplayback = false;
 	bFRrecord = false;
 }
@@ -362,6 +422,11 @@ bool Vessel::FRecorder_Read (const char *scname)
 		if (scname[i-1] == '\\') break;
 	sprintf (fname, "Flights/%s/%s.pos", scname+i, name.c_str());
 
+	// binary stream takes precedence over text streams
+	strcpy (cbuf, fname); strcpy (cbuf+strlen(cbuf)-3, "frb");
+	if (FlightRecord::IsBinary (cbuf))
+		return FRecorder_ReadBinary (cbuf);
+
 	ifstream ifs (fname);
 	if (!ifs) {
 		bFRplayback = false;
@@ -453,7 +518,7 @@ bool Vessel::FRecorder_Read (const char *scname)
 			frec_att[nfrec_att].ref = ref;
 
 			// convert Euler angles to quaternions
-			Euler2Quaternion (a, frec_att[nfrec_att].q, frec_att[nfrec_att].frm);
+			FlightRecord::Euler2Quaternion (a, frec_att[nfrec_att].q, frec_att[nfrec_att].frm);
 			//for (int i = 0; i < 3; i++)
 			//	frec_att[nfrec_att].att[i] = a[i];
 
@@ -475,6 +540,73 @@ bool Vessel::FRecorder_Read (const char *scname)
 	return true;
 }
 
+bool Vessel::FRecorder_ReadBinary (const char *fname)
+{
+	FlightRecordReader rec;
+	if (!rec.Open (fname) || rec.nPos() > INT_MAX || rec.nAtt() > INT_MAX) {
+		LOGOUT_ERR("Invalid flight record %s", fname);
+		bFRplayback = false;
+		return false;
+	}
+
+	FRecorder_Clear();
+
+	size_t i;
+	std::vector<const CelestialBody*> ref(rec.Refs().size());
+	for (i = 0; i < ref.size(); i++) {
+		ref[i] = g_psys->GetGravObj (rec.Refs()[i].c_str(), true);
+		if (!ref[i]) ref[i] = g_psys->GetGravObj (0);
+	}
+	MJDofs = rec.MJD0();
+
+	nfrec = (int)rec.nPos();
+	if (nfrec) {
+		frec = new FRecord[nfrec]; TRACENEW
+		for (i = 0; i < rec.nPos(); i++) {
+			FRecPosSample s;
+			rec.GetPos (i, s);
+			frec[i].simt = s.simt;
+			frec[i].frm  = s.frm;
+			frec[i].ref  = (s.ref >= 0 && s.ref < (int)ref.size() ? ref[s.ref] : g_psys->GetGravObj(0));
+			frec[i].rpos = s.rpos;
+			frec[i].rvel = s.rvel;
+		}
+	}
+	nfrec_att = (int)rec.nAtt();
+	if (nfrec_att) {
+		frec_att = new FRecord_att[nfrec_att]; TRACENEW
+		for (i = 0; i < rec.nAtt(); i++) {
+			FRecAttSample s;
+			rec.GetAtt (i, s);
+			frec_att[i].simt = s.simt;
+			frec_att[i].frm  = s.frm;
+			frec_att[i].ref  = (s.ref >= 0 && s.ref < (int)ref.size() ? ref[s.ref] : g_psys->GetGravObj(0));
+			frec_att[i].q    = s.q;
+		}
+	}
+	cfrec = 0;
+	cfrec_att = 0;
+
+	// articulation events are passed to FRecorder_PlayEvent in text stream format
+	if (rec.nEvent()) {
+		ostringstream oss;
+		oss << setprecision(17);
+		for (i = 0; i < rec.nEvent(); i++) {
+			const FRecEvent &e = rec.GetEvent (i);
+			oss << e.simt << ' ' << e.type << ' ' << e.data << '\n';
+		}
+		FRatc_stream = new istringstream (oss.str()); TRACENEW
+		*FRatc_stream >> frec_eng_simt;
+		if (!FRatc_stream->good()) {
+			delete FRatc_stream;
+			FRatc_stream = 0;
+		}
+	}
+
+	bFRplayback = true;
+	return true;
+}
+
 void Vessel::FRecorder_Play ()
 {
 	dCHECK(s1, "Update state not available.")
@@ -487,7 +619,7 @@ void Vessel::FRecorder_Play ()
 		int i;
 		static Vector s;
 
-		while (cfrec+2 < nfrec && frec[cfrec+1].simt < td.SimT1) cfrec++;
+		cfrec = SeekSample (frec, nfrec, cfrec, td.SimT1);
 		dT = frec[cfrec+1].simt - frec[cfrec].simt;
 		dt = td.SimT1 - frec[cfrec].simt;
 
@@ -543,7 +675,7 @@ void Vessel::FRecorder_Play ()
 			Vector r2 (sv->R.m12, sv->R.m22, sv->R.m32);
 			Vector r3 (sv->R.m13, sv->R.m23, sv->R.m33);
 
-			while (cfrec_att+2 < nfrec_att && frec_att[cfrec_att+1].simt < td.SimT1) cfrec_att++;
+			cfrec_att = SeekSample (frec_att, nfrec_att, cfrec_att, td.SimT1);
 			dt = frec_att[cfrec_att+1].simt - frec_att[cfrec_att].simt;
 			w1 = (td.SimT1-frec_att[cfrec_att].simt)/dt;
 			w0 = 1.0-w1;
@@ -788,6 +920,45 @@ bool Orbiter::FRecorder_PrepareDir (const char *fname, bool force)
 	return true;
 }
 
+void Orbiter::FRecorder_Convert (const char *fname)
+{
+	// Binary vessel streams are converted to text, text streams to binary.
+	// The source streams are removed, so that playback picks up the result.
+	fs::path dir = fs::path("Flights") / fname;
+	std::error_code ec;
+	std::vector<fs::path> src;
+	for (auto &entry : fs::directory_iterator (dir, ec)) {
+		const fs::path &p = entry.path();
+		if (p.extension() == ".frb" || (p.extension() == ".pos" && !fs::exists (fs::path(p).replace_extension (".frb"))))
+			src.push_back (p);
+	}
+	if (ec) {
+		LOGOUT_ERR("Flight recording not found: %s", dir.string().c_str());
+		return;
+	}
+	bool quantise = (pConfig->CfgRecPlayPrm.RecordFormat == 2);
+	for (auto &p : src) {
+		fs::path pos = fs::path(p).replace_extension (".pos");
+		fs::path frb = fs::path(p).replace_extension (".frb");
+		if (p.extension() == ".frb") {
+			FlightRecordReader rec;
+			if (rec.Open (frb.string().c_str()) && rec.ExportText (pos.string().c_str())) {
+				fs::remove (frb, ec);
+				LOGOUT("Flight record converted to text: %s", pos.string().c_str());
+			} else
+				LOGOUT_ERR("Flight record conversion failed: %s", frb.string().c_str());
+		} else {
+			if (FlightRecordWriter::ImportText (pos.string().c_str(), frb.string().c_str(), quantise)) {
+				fs::remove (pos, ec);
+				fs::remove (fs::path(p).replace_extension (".att"), ec);
+				fs::remove (fs::path(p).replace_extension (".atc"), ec);
+				LOGOUT("Flight record converted to binary: %s", frb.string().c_str());
+			} else
+				LOGOUT_ERR("Flight record conversion failed: %s", pos.string().c_str());
+		}
+	}
+}
+
 void Orbiter::FRecorder_Activate (bool active, const char *fname, bool append)
 {
 	if (bRecord == active) return; // nothing to do
@@ -947,22 +1118,13 @@ void Orbiter::FRecorder_ToggleEditor ()
 // ================================================================
 // helper functions
 
-// convert Euler angles from given reference frame to quaternion
-void Euler2Quaternion (double *a, Quaternion &q, int frm)
+// advance playback sample index i to the last sample before t.
+// Uses a binary search, since a time step can skip many samples at high
+// time acceleration or after a jump.
+template<class T> int SeekSample (const T *rec, int n, int i, double t)
 {
-	double sinx = sin(a[0]), cosx = cos(a[0]);
-	double siny = sin(a[1]), cosy = cos(a[1]);
-	double sinz = sin(a[2]), cosz = cos(a[2]);
-	if (frm == 0) { // global frame
-		Matrix R (1,0,0,  0,cosx,sinx,  0,-sinx,cosx);
-		R.postmul (Matrix (cosy,0,-siny,  0,1,0,  siny,0,cosy));
-		R.postmul (Matrix (cosz,sinz,0,  -sinz,cosz,0,  0,0,1));
-		q.Set (R);
-	} else {        // local horizon frame
-		Matrix R (cosx,sinx,0,  -sinx,cosx,0,  0,0,1);
-		R.postmul (Matrix (1,0,0,  0,cosy,-siny,  0,siny,cosy));
-		R.postmul (Matrix (cosz,0,-sinz,  0,1,0,  sinz,0,cosz));
-		q.Set (R);
-	}
+	if (i+2 >= n || rec[i+1].simt >= t) return i;
+	const T *r = std::lower_bound (rec+i+1, rec+n-1, t,
+		[](const T &s, double t) { return s.simt < t; });
+	return (int)(r-rec)-1;
 }
-
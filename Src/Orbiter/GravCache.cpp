@@ -0,0 +1,174 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class GravCache
+// =======================================================================
+
+#include <mutex>
+#include <algorithm>
+#include "GravCache.h"
+
+static const size_t MAXCELL = 1 << 16; // cache is flushed when it grows beyond this
+static const int MAXREFINE = 4;         // max. subdivisions of a base level cell
+
+// -----------------------------------------------------------------------
+
+size_t GravCache::CellKeyHash::operator() (const CellKey &k) const
+{
+	uint64_t h = (uint64_t)k.ix * 0x9E3779B97F4A7C15ull;
+	h ^= (uint64_t)k.iy * 0xC2B2AE3D27D4EB4Full + (h << 6) + (h >> 2);
+	h ^= (uint64_t)k.iz * 0x165667B19E3779F9ull + (h << 6) + (h >> 2);
+	h ^= (uint64_t)(k.level + 64) | ((uint64_t)k.refine << 8) | ((uint64_t)k.degree << 16);
+	return (size_t)h;
+}
+
+// -----------------------------------------------------------------------
+
+GravCache::GravCache (const Field &field, double tol)
+: m_field(field), m_tol(tol), m_nhit(0), m_nmiss(0), m_ncell(0)
+{
+	// The trilinear interpolation error for a field varying on length
+	// scale L is about (h/L)^2/8 for cell size h. Start from the cell size
+	// that meets the tolerance for the shortest wavelength of the model;
+	// each cell is checked before it is used.
+	m_cellscale = sqrt (8.0*tol);
+}
+
+// -----------------------------------------------------------------------
+
+void GravCache::Clear ()
+{
+	std::unique_lock<std::shared_mutex> lock(m_mutex);
+	m_cell.clear();
+	m_ncell = 0;
+}
+
+// -----------------------------------------------------------------------
+
+GravCache::CellKey GravCache::GetKey (const Vector &lpos, int maxDegree) const
+{
+	// shortest resolved wavelength at this radius is about 2 pi r / n
+	double lmin = Pi2 * lpos.length() / (maxDegree > 1 ? maxDegree : 1);
+	CellKey key;
+	key.level  = (int)floor (log2 (lmin * m_cellscale));
+	key.refine = 0;
+	double h   = ldexp (1.0, key.level);
+	key.ix     = (int64_t)floor (lpos.x / h);
+	key.iy     = (int64_t)floor (lpos.y / h);
+	key.iz     = (int64_t)floor (lpos.z / h);
+	key.degree = maxDegree;
+	return key;
+}
+
+// -----------------------------------------------------------------------
+
+GravCache::CellKey GravCache::SubKey (const CellKey &key, const Vector &lpos) const
+{
+	CellKey sub = key;
+	sub.refine++;
+	double h = ldexp (1.0, sub.cellLevel());
+	sub.ix = (int64_t)floor (lpos.x / h);
+	sub.iy = (int64_t)floor (lpos.y / h);
+	sub.iz = (int64_t)floor (lpos.z / h);
+	return sub;
+}
+
+// -----------------------------------------------------------------------
+
+bool GravCache::BuildCell (const CellKey &key, Cell &cell) const
+{
+	double h = ldexp (1.0, key.cellLevel());
+	Vector p0 (key.ix*h, key.iy*h, key.iz*h);
+	for (int i = 0; i < 8; i++) {
+		Vector p (p0.x + (i & 1 ? h : 0.0), p0.y + (i & 2 ? h : 0.0), p0.z + (i & 4 ? h : 0.0));
+		cell.g[i] = m_field (p, key.degree);
+	}
+
+	// error estimate: compare interpolation and model at the midpoints of
+	// three cell edges and at the cell centre. (The centre alone is not
+	// sufficient: the perturbation is a potential gradient, so the second
+	// derivatives which determine the centre error largely cancel.)
+	static const double chk[4][3] = {{0.5,0,0}, {0,0.5,0}, {0,0,0.5}, {0.5,0.5,0.5}};
+	double gmax = 0.0, err = 0.0;
+	for (int i = 0; i < 8; i++)
+		gmax = std::max (gmax, cell.g[i].length());
+	for (int i = 0; i < 4; i++) {
+		Vector p (p0.x + chk[i][0]*h, p0.y + chk[i][1]*h, p0.z + chk[i][2]*h);
+		Vector gm = m_field (p, key.degree);
+		err = std::max (err, (Interpolate (cell, key, p) - gm).length());
+	}
+	return (err <= 0.5 * m_tol * gmax); // margin for the unchecked points
+}
+
+// -----------------------------------------------------------------------
+
+Vector GravCache::Interpolate (const Cell &cell, const CellKey &key, const Vector &lpos) const
+{
+	double ih = ldexp (1.0, -key.cellLevel());
+	double u = lpos.x*ih - key.ix, v = lpos.y*ih - key.iy, w = lpos.z*ih - key.iz;
+	const Vector *g = cell.g;
+	Vector g00 (g[0] + (g[1]-g[0])*u), g10 (g[2] + (g[3]-g[2])*u);
+	Vector g01 (g[4] + (g[5]-g[4])*u), g11 (g[6] + (g[7]-g[6])*u);
+	Vector g0 (g00 + (g10-g00)*v), g1 (g01 + (g11-g01)*v);
+	return g0 + (g1-g0)*w;
+}
+
+// -----------------------------------------------------------------------
+
+Vector GravCache::Eval (const Vector &lpos, int maxDegree)
+{
+	CellKey key = GetKey (lpos, maxDegree);
+
+	{
+		std::shared_lock<std::shared_mutex> lock(m_mutex);
+		for (;;) {
+			auto it = m_cell.find (key);
+			if (it == m_cell.end()) break;
+			if (it->second.state == CELL_VALID) {
+				m_nhit++;
+				return Interpolate (it->second, key, lpos);
+			}
+			if (it->second.state == CELL_INVALID) {
+				lock.unlock();
+				m_nmiss++;
+				return m_field (lpos, maxDegree);
+			}
+			key = SubKey (key, lpos);
+		}
+	}
+
+	// Build the missing cell outside the lock, subdividing it down to
+	// MAXREFINE levels until the interpolation is accurate enough. Only the
+	// cells containing lpos are built; their siblings are built when they
+	// are needed. If another thread builds the same cell concurrently, the
+	// first one to insert wins (both results are identical).
+	CellKey build[MAXREFINE+1];
+	Cell cell[MAXREFINE+1];
+	int nbuild;
+	for (nbuild = 0;; nbuild++) {
+		build[nbuild] = key;
+		if (BuildCell (key, cell[nbuild])) {
+			cell[nbuild].state = CELL_VALID;
+			break;
+		}
+		if (key.refine == MAXREFINE) {
+			cell[nbuild].state = CELL_INVALID;
+			break;
+		}
+		cell[nbuild].state = CELL_REFINED;
+		key = SubKey (key, lpos);
+	}
+	nbuild++;
+	{
+		std::unique_lock<std::shared_mutex> lock(m_mutex);
+		if (m_cell.size() + nbuild > MAXCELL)
+			m_cell.clear();
+		for (int i = 0; i < nbuild; i++)
+			m_cell.emplace (build[i], cell[i]);
+		m_ncell = m_cell.size();
+	}
+	m_nmiss++;
+	const Cell &leaf = cell[nbuild-1];
+	return (leaf.state == CELL_VALID ? Interpolate (leaf, key, lpos) : m_field (lpos, maxDegree));
+}
@@ -0,0 +1,97 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class GravCache
+// Error-bounded cache for the nonspherical gravity perturbation of a
+// celestial body. The perturbation field is sampled at the corners of
+// cubic cells and trilinearly interpolated inside them. Cells are built
+// on demand where vessels need the field, and are only accepted if the
+// interpolation error estimated at three edge midpoints and the cell
+// centre is within tolerance. Cells that fail the test are subdivided
+// locally, so rough regions of the field don't affect the cell size
+// elsewhere. Cells are defined in the body-fixed frame, in which the
+// field is stationary, so they stay valid as the body rotates.
+// =======================================================================
+
+#ifndef __GRAVCACHE_H
+#define __GRAVCACHE_H
+
+#include "Vecmat.h"
+#include <unordered_map>
+#include <shared_mutex>
+#include <atomic>
+#include <functional>
+#include <stdint.h>
+
+class GravCache {
+public:
+	typedef std::function<Vector(const Vector &lpos, int degree)> Field;
+	// Perturbation model: acceleration at position lpos [km] in the body
+	// frame, up to degree and order degree. Must be reentrant.
+
+	GravCache (const Field &field, double tol);
+	// field: perturbation model of the body (e.g. its Pines gravity model)
+	// tol: tolerated interpolation error, relative to the local perturbation
+
+	Vector Eval (const Vector &lpos, int maxDegree);
+	// Perturbation at position lpos [km] in the body's right-handed
+	// model frame, up to degree and order maxDegree. Returns an
+	// interpolated value if lpos is inside a valid cell, otherwise
+	// evaluates the model directly (and builds a cell if possible).
+	// May be called concurrently.
+
+	void Clear ();
+	// Discard all cells (e.g. when the model resolution changes)
+
+	inline uint64_t nHit () const { return m_nhit; }
+	inline uint64_t nMiss () const { return m_nmiss; }
+	inline size_t nCell () const { return m_ncell; }
+	// cache statistics: interpolated evaluations, direct evaluations, cells
+
+protected:
+	struct CellKey {
+		int level;             // base cell size is 2^level km
+		int refine;            // subdivision level: cell size is 2^cellLevel() km
+		int64_t ix, iy, iz;    // cell index
+		int degree;            // model degree and order
+		inline int cellLevel () const { return level-refine; }
+		bool operator== (const CellKey &k) const
+		{ return ix == k.ix && iy == k.iy && iz == k.iz && level == k.level && refine == k.refine && degree == k.degree; }
+	};
+	struct CellKeyHash {
+		size_t operator() (const CellKey &k) const;
+	};
+	enum CellState {
+		CELL_VALID,            // interpolate
+		CELL_REFINED,          // interpolation not accurate enough, use the subcell
+		CELL_INVALID           // interpolation not accurate enough at the finest level, evaluate directly
+	};
+	struct Cell {
+		Vector g[8];           // perturbation at the corners (x fastest)
+		CellState state;
+	};
+
+	CellKey GetKey (const Vector &lpos, int maxDegree) const;
+	// Base level cell containing lpos
+
+	CellKey SubKey (const CellKey &key, const Vector &lpos) const;
+	// Subcell of key (half the size) containing lpos
+
+	bool BuildCell (const CellKey &key, Cell &cell) const;
+	// Samples the field at the cell corners and returns true if the
+	// interpolation error is within tolerance
+
+	Vector Interpolate (const Cell &cell, const CellKey &key, const Vector &lpos) const;
+
+private:
+	Field m_field;
+	double m_tol;              // relative error tolerance
+	double m_cellscale;        // base cell size relative to the shortest resolved wavelength
+	std::unordered_map<CellKey,Cell,CellKeyHash> m_cell;
+	mutable std::shared_mutex m_mutex;
+	std::atomic<uint64_t> m_nhit, m_nmiss;
+	std::atomic<size_t> m_ncell;
+};
+
+#endif // !__GRAVCACHE_H
@@ -0,0 +1,163 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Batched point-mass gravity kernel
+// =======================================================================
+
+#include "GravKernel.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define GRAVKERNEL_X64
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define AVX2_TARGET
+#else
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// -----------------------------------------------------------------------
+// Scalar version
+
+static Vector GaccPointMass_scalar (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos)
+{
+	double ax = 0.0, ay = 0.0, az = 0.0;
+	for (int j = 0; j < nidx; j++) {
+		int i = idx[j];
+		double dx = src.x[i]-gpos.x, dy = src.y[i]-gpos.y, dz = src.z[i]-gpos.z;
+		double d2 = dx*dx + dy*dy + dz*dz;
+		double s = src.gm[i] / (d2*sqrt(d2));
+		ax += dx*s, ay += dy*s, az += dz*s;
+	}
+	return Vector (ax, ay, az);
+}
+
+#ifdef GRAVKERNEL_X64
+
+// -----------------------------------------------------------------------
+// SSE2 version: 2 sources per iteration (SSE2 is the x64 baseline)
+
+static Vector GaccPointMass_sse2 (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos)
+{
+	__m128d px = _mm_set1_pd (gpos.x), py = _mm_set1_pd (gpos.y), pz = _mm_set1_pd (gpos.z);
+	__m128d ax = _mm_setzero_pd(), ay = _mm_setzero_pd(), az = _mm_setzero_pd();
+	int j;
+
+	for (j = 0; j+2 <= nidx; j += 2) {
+		int i0 = idx[j], i1 = idx[j+1];
+		__m128d dx = _mm_sub_pd (_mm_set_pd (src.x[i1], src.x[i0]), px);
+		__m128d dy = _mm_sub_pd (_mm_set_pd (src.y[i1], src.y[i0]), py);
+		__m128d dz = _mm_sub_pd (_mm_set_pd (src.z[i1], src.z[i0]), pz);
+		__m128d d2 = _mm_add_pd (_mm_add_pd (_mm_mul_pd (dx, dx), _mm_mul_pd (dy, dy)), _mm_mul_pd (dz, dz));
+		__m128d s  = _mm_div_pd (_mm_set_pd (src.gm[i1], src.gm[i0]), _mm_mul_pd (d2, _mm_sqrt_pd (d2)));
+		ax = _mm_add_pd (ax, _mm_mul_pd (dx, s));
+		ay = _mm_add_pd (ay, _mm_mul_pd (dy, s));
+		az = _mm_add_pd (az, _mm_mul_pd (dz, s));
+	}
+	double bx[2], by[2], bz[2];
+	_mm_storeu_pd (bx, ax); _mm_storeu_pd (by, ay); _mm_storeu_pd (bz, az);
+	Vector acc (bx[0]+bx[1], by[0]+by[1], bz[0]+bz[1]);
+	if (j < nidx)
+		acc += GaccPointMass_scalar (src, idx+j, nidx-j, gpos);
+	return acc;
+}
+
+// -----------------------------------------------------------------------
+// AVX2 version: 4 sources per iteration, gathered from the source arrays
+
+AVX2_TARGET static Vector GaccPointMass_avx2 (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos)
+{
+	__m256d px = _mm256_set1_pd (gpos.x), py = _mm256_set1_pd (gpos.y), pz = _mm256_set1_pd (gpos.z);
+	__m256d ax = _mm256_setzero_pd(), ay = _mm256_setzero_pd(), az = _mm256_setzero_pd();
+	int j;
+
+	for (j = 0; j+4 <= nidx; j += 4) {
+		__m128i vi = _mm_loadu_si128 ((const __m128i*)(idx+j));
+		__m256d dx = _mm256_sub_pd (_mm256_i32gather_pd (src.x, vi, 8), px);
+		__m256d dy = _mm256_sub_pd (_mm256_i32gather_pd (src.y, vi, 8), py);
+		__m256d dz = _mm256_sub_pd (_mm256_i32gather_pd (src.z, vi, 8), pz);
+		__m256d d2 = _mm256_add_pd (_mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)), _mm256_mul_pd (dz, dz));
+		__m256d s  = _mm256_div_pd (_mm256_i32gather_pd (src.gm, vi, 8), _mm256_mul_pd (d2, _mm256_sqrt_pd (d2)));
+		ax = _mm256_add_pd (ax, _mm256_mul_pd (dx, s));
+		ay = _mm256_add_pd (ay, _mm256_mul_pd (dy, s));
+		az = _mm256_add_pd (az, _mm256_mul_pd (dz, s));
+	}
+	double bx[4], by[4], bz[4];
+	_mm256_storeu_pd (bx, ax); _mm256_storeu_pd (by, ay); _mm256_storeu_pd (bz, az);
+	Vector acc ((bx[0]+bx[1])+(bx[2]+bx[3]), (by[0]+by[1])+(by[2]+by[3]), (bz[0]+bz[1])+(bz[2]+bz[3]));
+	if (j < nidx)
+		acc += GaccPointMass_sse2 (src, idx+j, nidx-j, gpos);
+	return acc;
+}
+
+// -----------------------------------------------------------------------
+
+static bool CpuHasAVX2 ()
+{
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid (info, 0);
+	if (info[0] < 7) return false;
+	__cpuid (info, 1);
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx     = (info[2] & (1 << 28)) != 0;
+	if (!osxsave || !avx) return false;
+	if ((_xgetbv (0) & 0x6) != 0x6) return false; // OS saves YMM state
+	__cpuidex (info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init ();
+	return __builtin_cpu_supports ("avx2") != 0;
+#endif
+}
+
+#endif // GRAVKERNEL_X64
+
+// -----------------------------------------------------------------------
+
+GravKernelType GravKernelSupported ()
+{
+#ifdef GRAVKERNEL_X64
+	static const GravKernelType type = (CpuHasAVX2() ? GRAVKERNEL_AVX2 : GRAVKERNEL_SSE2);
+	return type;
+#else
+	return GRAVKERNEL_SCALAR;
+#endif
+}
+
+// -----------------------------------------------------------------------
+
+const char *GravKernelName (GravKernelType type)
+{
+	switch (type) {
+	case GRAVKERNEL_AVX2: return "AVX2";
+	case GRAVKERNEL_SSE2: return "SSE2";
+	default:              return "scalar";
+	}
+}
+
+// -----------------------------------------------------------------------
+
+Vector GaccPointMass (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos, GravKernelType type)
+{
+	if (type > GravKernelSupported())
+		type = GRAVKERNEL_SCALAR;
+
+	switch (type) {
+#ifdef GRAVKERNEL_X64
+	case GRAVKERNEL_AVX2: return GaccPointMass_avx2 (src, idx, nidx, gpos);
+	case GRAVKERNEL_SSE2: return GaccPointMass_sse2 (src, idx, nidx, gpos);
+#endif
+	default:              return GaccPointMass_scalar (src, idx, nidx, gpos);
+	}
+}
+
+// -----------------------------------------------------------------------
+
+Vector GaccPointMass (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos)
+{
+	static const GravKernelType type = GravKernelSupported();
+	return GaccPointMass (src, idx, nidx, gpos, type);
+}
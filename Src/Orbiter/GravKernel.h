@@ -0,0 +1,44 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Batched point-mass gravity kernel
+// Sums the gravitational accelerations of a list of point masses at a
+// single position in one pass. The sources are stored as structure of
+// arrays and addressed via an index list (e.g. a body's gravity source
+// list). AVX2 or SSE2 code paths are selected at runtime, with a scalar
+// fallback on other platforms.
+// =======================================================================
+
+#ifndef __GRAVKERNEL_H
+#define __GRAVKERNEL_H
+
+#include "Vecmat.h"
+
+struct GravSourceArray {
+	const double *x;  // source positions (global frame) [m]
+	const double *y;
+	const double *z;
+	const double *gm; // source gravitational parameters G*M [m^3/s^2]
+};
+
+enum GravKernelType {
+	GRAVKERNEL_SCALAR,
+	GRAVKERNEL_SSE2,
+	GRAVKERNEL_AVX2
+};
+
+Vector GaccPointMass (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos);
+// Acceleration at global position gpos due to the sources src[idx[0..nidx-1]],
+// using the best code path supported by the CPU
+
+Vector GaccPointMass (const GravSourceArray &src, const int *idx, int nidx, const Vector &gpos, GravKernelType type);
+// As above, but with an explicit code path (falls back to scalar if the
+// requested path is not supported)
+
+GravKernelType GravKernelSupported ();
+// Best code path supported by the CPU
+
+const char *GravKernelName (GravKernelType type);
+
+#endif // !__GRAVKERNEL_H
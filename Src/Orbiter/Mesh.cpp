@@ -7,6 +7,10 @@
 #include "Orbiter.h"
 #include "Log.h"
 #include "Util.h"
+#include "ThreadPool.h"
+#include <fstream>
+#include <chrono>
+#include <algorithm>
 
 using namespace std;
 
@@ -813,7 +817,7 @@ void Mesh::RenderGroup (LPDIRECT3DDEVICE7 dev, DWORD grp, bool setstate) const
 {
 }
 
-istream &operator>> (istream &is, Mesh &mesh)
+istream &Mesh::Read (istream &is, vector<MeshBinTexture> &tex)
 {
 	char cbuf[256];
 	int i, j, g, ngrp, nvtx, ntri, nidx, nmtrl, mtrl_idx, ntex, tex_idx, flag, res;
@@ -822,7 +826,7 @@ istream &operator>> (istream &is, Mesh &mesh)
 	D3DMATERIAL7 mtrl;
 	bool term, staticmesh = false;
 
-	mesh.Clear();
+	Clear();
 
 	if (!is.getline (cbuf, 256)) return is;
 	if (strcmp (cbuf, "MSHX1")) return is;
@@ -923,11 +927,11 @@ istream &operator>> (istream &is, Mesh &mesh)
 			}
 		}
 		if (nvtx && nidx) {
-			mesh.AddGroup (vtx, nvtx, idx, nidx, mtrl_idx, tex_idx, zbias);
-			mesh.Grp[g].Flags = flag;
-			mesh.Grp[g].UsrFlag = uflag;
-			if (calcnml) mesh.CalcNormals (g, true);
-			if (flag & 0x04) mesh.MakeGroupVertexBuffer (g);
+			AddGroup (vtx, nvtx, idx, nidx, mtrl_idx, tex_idx, zbias);
+			Grp[g].Flags = flag;
+			Grp[g].UsrFlag = uflag;
+			if (calcnml) CalcNormals (g, true);
+			if (flag & 0x04) MakeGroupVertexBuffer (g);
 		}
 	}
 
@@ -952,35 +956,109 @@ istream &operator>> (istream &is, Mesh &mesh)
 			if (res < 5) mtrl.power = 0.0;
 			is.getline (cbuf, 256);
 			sscanf (cbuf, "%f%f%f%f", &mtrl.emissive.r, &mtrl.emissive.g, &mtrl.emissive.b, &mtrl.emissive.a);
-			mesh.AddMaterial (mtrl);
+			AddMaterial (mtrl);
 		}
 		delete []matname;
 		matname = NULL;
 	}
 
 	// read texture list
-	mesh.ReleaseTextures ();
+	ReleaseTextures ();
+	tex.clear();
 	if (is.getline (cbuf, 256) && !strncmp (cbuf, "TEXTURES", 8) && (sscanf (cbuf+8, "%d", &ntex) == 1)) {
-		mesh.Tex = new SURFHANDLE[mesh.nTex = ntex]; TRACENEW
+		Tex = new SURFHANDLE[nTex = ntex]; TRACENEW
+		tex.resize (ntex);
 		Str256 texname, flagstr;
 		for (i = 0; i < ntex; i++) {
 			is.getline (cbuf, 256);
 			flagstr[0] = '\0';
 			sscanf (cbuf, "%255s%255s", texname, flagstr);
-			mesh.Tex[i] = 0;
+			Tex[i] = 0;
+			tex[i].name[0] = '\0';
+			tex[i].flags = 0;
 			if (texname[0] != '0' || texname[1] != '\0') {
-				bool uncompress = (toupper(flagstr[0]) == 'D');
-				if (g_pOrbiter->GetGraphicsClient())
-					mesh.Tex[i] = g_pOrbiter->GetGraphicsClient()->clbkLoadTexture (texname, 8 | (uncompress ? 2:0));
+				strcpy (tex[i].name, texname);
+				if (toupper(flagstr[0]) == 'D') tex[i].flags |= MESHBIN_TEX_UNCOMPRESS;
 			}
 		}
 	}
 
-	mesh.Setup();
+	Setup();
 	is.clear();
 	return is;
 }
 
+istream &operator>> (istream &is, Mesh &mesh)
+{
+	vector<MeshBinTexture> tex;
+	mesh.Read (is, tex);
+	mesh.LoadTextures (tex);
+	return is;
+}
+
+void Mesh::Read (const MeshBinFile &f, vector<MeshBinTexture> &tex)
+{
+	static_assert (sizeof(NTVERTEX) == sizeof(MeshBinVertex), "NTVERTEX layout");
+	static_assert (sizeof(D3DMATERIAL7) == sizeof(MeshBinMaterial), "D3DMATERIAL7 layout");
+	const MeshBinHeader &hdr = f.Header();
+	DWORD g, i;
+
+	Clear();
+	for (g = 0; g < hdr.ngrp; g++) {
+		const MeshBinGroup &gs = f.Group (g);
+		NTVERTEX *vtx = new NTVERTEX[gs.nVtx]; TRACENEW
+		memcpy (vtx, f.Vertices (g), gs.nVtx*sizeof(NTVERTEX));
+		WORD *idx = new WORD[gs.nIdx]; TRACENEW
+		memcpy (idx, f.Indices (g), gs.nIdx*sizeof(WORD));
+		int grp = AddGroup (vtx, gs.nVtx, idx, gs.nIdx, gs.mtrlIdx, gs.texIdx, gs.zBias);
+		Grp[grp].Flags = gs.flags;
+		Grp[grp].UsrFlag = gs.usrFlag;
+		if (gs.flags & 0x04) MakeGroupVertexBuffer (grp);
+	}
+	for (i = 0; i < hdr.nmtrl; i++) {
+		D3DMATERIAL7 mtrl;
+		memcpy (&mtrl, &f.Material (i), sizeof(D3DMATERIAL7));
+		AddMaterial (mtrl);
+	}
+	ReleaseTextures ();
+	tex.clear();
+	if (hdr.ntex) {
+		Tex = new SURFHANDLE[nTex = hdr.ntex]; TRACENEW
+		for (i = 0; i < nTex; i++) {
+			Tex[i] = 0;
+			tex.push_back (f.Texture (i));
+		}
+	}
+	Setup();
+}
+
+bool Mesh::Load (const char *fname, vector<MeshBinTexture> *tex, bool *compiled)
+{
+	vector<MeshBinTexture> ltex;
+	vector<MeshBinTexture> &t = (tex ? *tex : ltex);
+	MeshBinFile f;
+	bool ok, bin = f.Open ((std::string(fname) + 'b').c_str(), fname);
+	if (bin) {
+		Read (f, t);
+		ok = true;
+	} else {
+		ifstream ifs (fname, ios::in);
+		ok = Read (ifs, t).good();
+	}
+	if (compiled) *compiled = bin;
+	if (!tex) LoadTextures (t);
+	return ok;
+}
+
+void Mesh::LoadTextures (const vector<MeshBinTexture> &tex)
+{
+	oapi::GraphicsClient *gc = g_pOrbiter->GetGraphicsClient();
+	if (!gc) return;
+	for (DWORD i = 0; i < nTex && i < tex.size(); i++)
+		if (tex[i].name[0] && !Tex[i])
+			Tex[i] = gc->clbkLoadTexture (tex[i].name, 8 | (tex[i].flags & MESHBIN_TEX_UNCOMPRESS ? 2:0));
+}
+
 ostream &operator<< (ostream &os, const Mesh &mesh)
 {
 	DWORD g, i, ntri;
@@ -1063,7 +1141,8 @@ bool Mesh::bEnableSpecular = false;
 
 MeshManager::MeshManager()
 {
-	nmlist = nmlistbuf = 0;
+	nload = ncompiled = 0;
+	tload = 0.0;
 }
 
 MeshManager::~MeshManager()
@@ -1073,28 +1152,39 @@ MeshManager::~MeshManager()
 
 void MeshManager::Flush()
 {
-	for (int i = 0; i < nmlist; i++)
-		delete mlist[i].mesh;
-	if (nmlistbuf) {
-		delete []mlist;
-		nmlist = nmlistbuf = 0;
+	for (auto it = mlist.begin(); it != mlist.end(); it++)
+		delete it->second;
+	mlist.clear();
+	if (nload) {
+		LOGOUT("Mesh manager: %d meshes loaded (%d compiled) in %0.1f ms", nload, ncompiled, tload*1e3);
+		nload = ncompiled = 0;
+		tload = 0.0;
 	}
 }
 
+std::string MeshManager::Key (const char *fname)
+{
+	std::string key (fname);
+	for (size_t i = 0; i < key.size(); i++) {
+		key[i] = (char)tolower ((unsigned char)key[i]);
+		if (key[i] == '/') key[i] = '\\';
+	}
+	return key;
+}
+
 const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 {
-	int i;
-	DWORDLONG crc = Str2Crc (fname);
-	for (i = 0; i < nmlist; i++) {
-		if (crc == mlist[i].crc && !_strnicmp (fname, mlist[i].fname, 32)) {
-			if (firstload) *firstload = false;
-			return mlist[i].mesh; // found it
-		}
+	std::string key = Key (fname);
+	auto it = mlist.find (key);
+	if (it != mlist.end()) {
+		if (firstload) *firstload = false;
+		return it->second; // found it
 	}
 	// not found, so load from file
-	ifstream ifs (g_pOrbiter->MeshPath (fname), ios::in);
+	auto t0 = chrono::steady_clock::now();
 	Mesh *mesh = new Mesh; TRACENEW
-	ifs >> *mesh;
+	bool compiled;
+	mesh->Load (g_pOrbiter->MeshPath (fname), NULL, &compiled);
 	if (!mesh->nGroup()) { // load error
 		if (!fname[0]) LOGOUT_ERR ("Mesh file name not provided");
 		else LOGOUT_ERR ("Mesh not found: %s", g_pOrbiter->MeshPath (fname));
@@ -1102,32 +1192,73 @@ const Mesh *MeshManager::LoadMesh (const char *fname, bool *firstload)
 		delete mesh;
 		return 0;
 	}
-	if (nmlist == nmlistbuf) { // need to allocate buffer
-		MeshBuffer *tmp = new MeshBuffer[nmlistbuf += 32]; TRACENEW
-		if (nmlist) {
-			memcpy (tmp, mlist, nmlist*sizeof(MeshBuffer));
-			delete []mlist;
-			mlist = NULL;
-		}
-		mlist = tmp;
-	}
 	mesh->SetName(fname);
-	mlist[nmlist].mesh = mesh;
-	mlist[nmlist].crc  = crc;
-	strncpy (mlist[nmlist].fname, fname, 32);
-	nmlist++;
+	mlist[key] = mesh;
+	nload++;
+	if (compiled) ncompiled++;
+	tload += chrono::duration<double>(chrono::steady_clock::now() - t0).count();
 	if (firstload) *firstload = true;
 	return mesh;
 }
 
+void MeshManager::Preload (const std::vector<std::string> &fnames)
+{
+	struct Job {
+		std::string key, fname, path;
+		Mesh *mesh;
+		vector<MeshBinTexture> tex;
+		bool compiled;
+	};
+	vector<Job> job;
+	for (size_t i = 0; i < fnames.size(); i++) {
+		std::string key = Key (fnames[i].c_str());
+		if (fnames[i].empty() || mlist.find (key) != mlist.end()) continue;
+		bool dup = false;
+		for (size_t j = 0; j < job.size() && !dup; j++)
+			dup = (job[j].key == key);
+		if (dup) continue;
+		Job jb;
+		jb.key = key;
+		jb.fname = fnames[i];
+		jb.path = g_pOrbiter->MeshPath (fnames[i].c_str()); // not thread-safe
+		jb.mesh = 0;
+		jb.compiled = false;
+		job.push_back (jb);
+	}
+	if (!job.size()) return;
+
+	// geometry is read by the pool, textures by the calling thread
+	auto t0 = chrono::steady_clock::now();
+	ThreadPool pool ((int)min (job.size(), (size_t)thread::hardware_concurrency()));
+	pool.ParallelFor (job.size(), [&](size_t i) {
+		Mesh *mesh = new Mesh;
+		if (mesh->Load (job[i].path.c_str(), &job[i].tex, &job[i].compiled) && mesh->nGroup())
+			job[i].mesh = mesh;
+		else
+			delete mesh;
+	});
+	int n = 0, nc = 0;
+	for (size_t i = 0; i < job.size(); i++) {
+		if (!job[i].mesh) continue;
+		job[i].mesh->LoadTextures (job[i].tex);
+		job[i].mesh->SetName (job[i].fname.c_str());
+		mlist[job[i].key] = job[i].mesh;
+		n++;
+		if (job[i].compiled) nc++;
+	}
+	double dt = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+	nload += n;
+	ncompiled += nc;
+	tload += dt;
+	LOGOUT("Preloaded %d meshes (%d compiled) in %0.1f ms, %d threads", n, nc, dt*1e3, pool.nThread());
+}
+
 // =======================================================================
 // Nonmember functions
 
 bool LoadMesh (const char *meshname, Mesh &mesh)
 {
-	ifstream ifs (g_pOrbiter->MeshPath (meshname), ios::in);
-	ifs >> mesh;
-	if (ifs.good()) {
+	if (mesh.Load (g_pOrbiter->MeshPath (meshname))) {
 		mesh.SetName(meshname);
 		return true;
 	} else {
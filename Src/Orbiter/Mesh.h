@@ -13,7 +13,11 @@
 #include <d3d.h>
 #include <d3dtypes.h>
 #include <iostream>
+#include <vector>
+#include <string>
+#include <unordered_map>
 #include "OrbiterAPI.h"
+#include "MeshBin.h"
 
 typedef char Str256[256];
 
@@ -76,6 +80,18 @@ public:
 
 	void Set (const Mesh &mesh);
 
+	bool Load (const char *fname, std::vector<MeshBinTexture> *tex = 0, bool *compiled = 0);
+	// Load the mesh from file fname (path of the .msh file). A compiled mesh
+	// (fname + "b", see MeshBin.h) is used instead if it exists and is up
+	// to date. If tex is provided, textures are not loaded, but returned in
+	// tex, to be passed to LoadTextures later. This allows the geometry to
+	// be loaded outside the main thread. If compiled is provided, it is set
+	// to true if the mesh was read from a compiled file.
+	// Returns false if the mesh could not be read.
+
+	void LoadTextures (const std::vector<MeshBinTexture> &tex);
+	// Load the textures listed by Load. Must be called from the main thread.
+
 	void Setup ();
 	// call after all groups are assembled or whenever groups change,
 	// to set up group parameters
@@ -215,6 +231,11 @@ protected:
 	// Release textures acquired by the mesh
 
 private:
+	std::istream &Read (std::istream &is, std::vector<MeshBinTexture> &tex);
+	void Read (const MeshBinFile &f, std::vector<MeshBinTexture> &tex);
+	// read mesh from a text stream or compiled mesh, without loading
+	// the textures
+
 	DWORD nGrp;         // number of groups
 	GroupSpec *Grp;     // list of group specs	
 
@@ -254,13 +275,18 @@ public:
 	// If firstload is used, it is set to true if the mesh was loaded from
 	// file, and false if the mesh was in memory already
 
+	void Preload (const std::vector<std::string> &fnames);
+	// Load a list of meshes in parallel on a thread pool. Meshes already
+	// loaded are skipped, and meshes which can't be read are ignored (an
+	// error is reported when they are requested with LoadMesh).
+
 private:
-	struct MeshBuffer {
-		Mesh *mesh;
-		DWORDLONG crc;
-		char fname[32];
-	} *mlist;
-	int nmlist, nmlistbuf;
+	static std::string Key (const char *fname);
+	// cache key for a mesh file name (case-insensitive)
+
+	std::unordered_map<std::string, Mesh*> mlist; // loaded meshes
+	int nload, ncompiled;  // meshes loaded from file, and from compiled files
+	double tload;          // time spent loading meshes [s]
 };
 
 // =======================================================================
@@ -0,0 +1,436 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Compiled binary meshes
+// =======================================================================
+
+#include "MeshBin.h"
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <ctype.h>
+#include <fstream>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <sys/stat.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <strings.h>
+#define _strnicmp strncasecmp
+#endif
+
+using namespace std;
+
+static const char MAGIC[8] = {'O','M','E','S','H','B','I','N'};
+static const uint32_t VERSION = 1;
+static const uint32_t IDX_INHERIT = (uint32_t)(-2); // SPEC_INHERIT
+
+static inline uint64_t Align8 (uint64_t ofs) { return (ofs + 7) & ~(uint64_t)7; }
+
+// -----------------------------------------------------------------------
+// Read a line, removing the carriage return of DOS line ends if the stream
+// was not opened in text mode
+
+static bool GetLine (istream &is, char *cbuf)
+{
+	if (!is.getline (cbuf, 256)) return false;
+	size_t len = strlen (cbuf);
+	if (len && cbuf[len-1] == '\r') cbuf[len-1] = '\0';
+	return true;
+}
+
+// -----------------------------------------------------------------------
+// Vertex normals of a group, as in Mesh::CalcNormals (missingonly = true)
+
+static void CalcNormals (MeshBinData::Group &g)
+{
+	const float eps = 1e-8f;
+	size_t i, nv = g.vtx.size(), nt = g.idx.size()/3;
+	MeshBinVertex *vtx = g.vtx.data();
+	vector<bool> calcNml (nv);
+	for (i = 0; i < nv; i++) {
+		if (vtx[i].nx*vtx[i].nx + vtx[i].ny*vtx[i].ny + vtx[i].nz*vtx[i].nz > 0.1f) {
+			calcNml[i] = false;
+		} else {
+			calcNml[i] = true;
+			vtx[i].nx = vtx[i].ny = vtx[i].nz = 0.0f;
+		}
+	}
+	for (i = 0; i < nt; i++) {
+		uint32_t i0 = g.idx[i*3], i1 = g.idx[i*3+1], i2 = g.idx[i*3+2];
+		if (i0 >= nv || i1 >= nv || i2 >= nv) continue;
+		if (!calcNml[i0] && !calcNml[i1] && !calcNml[i2]) continue;
+		float v01[3] = {vtx[i1].x - vtx[i0].x, vtx[i1].y - vtx[i0].y, vtx[i1].z - vtx[i0].z};
+		float v02[3] = {vtx[i2].x - vtx[i0].x, vtx[i2].y - vtx[i0].y, vtx[i2].z - vtx[i0].z};
+		float v12[3] = {vtx[i2].x - vtx[i1].x, vtx[i2].y - vtx[i1].y, vtx[i2].z - vtx[i1].z};
+		float nm[3] = {v01[1]*v02[2] - v01[2]*v02[1], v01[2]*v02[0] - v01[0]*v02[2], v01[0]*v02[1] - v01[1]*v02[0]};
+		float len = sqrtf (nm[0]*nm[0] + nm[1]*nm[1] + nm[2]*nm[2]);
+		if (len >= eps) {
+			nm[0] /= len, nm[1] /= len, nm[2] /= len;
+			float d01 = sqrtf (v01[0]*v01[0] + v01[1]*v01[1] + v01[2]*v01[2]);
+			float d02 = sqrtf (v02[0]*v02[0] + v02[1]*v02[1] + v02[2]*v02[2]);
+			float d12 = sqrtf (v12[0]*v12[0] + v12[1]*v12[1] + v12[2]*v12[2]);
+			if (calcNml[i0]) {
+				float a0 = acosf ((d01*d01 + d02*d02 - d12*d12) / (2.0f*d01*d02));
+				vtx[i0].nx += nm[0]*a0, vtx[i0].ny += nm[1]*a0, vtx[i0].nz += nm[2]*a0;
+			}
+			if (calcNml[i1]) {
+				float a1 = acosf ((d01*d01 + d12*d12 - d02*d02) / (2.0f*d01*d12));
+				vtx[i1].nx += nm[0]*a1, vtx[i1].ny += nm[1]*a1, vtx[i1].nz += nm[2]*a1;
+			}
+			if (calcNml[i2]) {
+				float a2 = acosf ((d02*d02 + d12*d12 - d01*d01) / (2.0f*d02*d12));
+				vtx[i2].nx += nm[0]*a2, vtx[i2].ny += nm[1]*a2, vtx[i2].nz += nm[2]*a2;
+			}
+		}
+	}
+	for (i = 0; i < nv; i++)
+		if (calcNml[i]) {
+			float len = sqrtf (vtx[i].nx*vtx[i].nx + vtx[i].ny*vtx[i].ny + vtx[i].nz*vtx[i].nz);
+			vtx[i].nx /= len, vtx[i].ny /= len, vtx[i].nz /= len;
+		}
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshBin::ParseText (istream &is, MeshBinData &mesh)
+{
+	char cbuf[256];
+	int i, j, g, ngrp, nvtx, ntri, nmtrl, ntex, mtrl_idx, tex_idx, res;
+	unsigned long uflag;
+	unsigned short zbias;
+	bool term, staticmesh = false;
+
+	mesh.grp.clear();
+	mesh.mtrl.clear();
+	mesh.tex.clear();
+
+	if (!GetLine (is, cbuf)) return false;
+	if (strcmp (cbuf, "MSHX1")) return false;
+
+	for (;;) {
+		if (!GetLine (is, cbuf)) return false;
+		if (!_strnicmp (cbuf, "GROUPS", 6)) {
+			if (sscanf (cbuf+6, "%d", &ngrp) != 1) return false;
+			break;
+		} else if (!_strnicmp (cbuf, "STATICMESH", 10)) {
+			staticmesh = true;
+		}
+	}
+
+	for (g = 0, term = false; g < ngrp && !term; g++) {
+		MeshBinData::Group grp;
+		int flag = (staticmesh ? 0x04 : 0);
+		bool bnormal = true, calcnml = false, flipidx = false;
+		mtrl_idx = (int)IDX_INHERIT;
+		tex_idx  = (int)IDX_INHERIT;
+		zbias    = 0;
+		uflag    = 0;
+		nvtx = ntri = 0;
+
+		for (;;) {
+			if (!GetLine (is, cbuf)) { term = true; break; }
+			if (!_strnicmp (cbuf, "MATERIAL", 8)) {
+				sscanf (cbuf+8, "%d", &mtrl_idx);
+				mtrl_idx--;
+			} else if (!_strnicmp (cbuf, "TEXTURE", 7)) {
+				sscanf (cbuf+7, "%d", &tex_idx);
+				tex_idx--;
+			} else if (!_strnicmp (cbuf, "ZBIAS", 5)) {
+				sscanf (cbuf+5, "%hu", &zbias);
+			} else if (!_strnicmp (cbuf, "TEXWRAP", 7)) {
+				char uvstr[10] = "";
+				sscanf (cbuf+7, "%9s", uvstr);
+				if (uvstr[0] == 'U' || uvstr[1] == 'U') flag |= 0x01;
+				if (uvstr[0] == 'V' || uvstr[1] == 'V') flag |= 0x02;
+			} else if (!_strnicmp (cbuf, "NONORMAL", 8)) {
+				bnormal = false; calcnml = true;
+			} else if (!_strnicmp (cbuf, "FLAG", 4)) {
+				sscanf (cbuf+4, "%lx", &uflag);
+			} else if (!_strnicmp (cbuf, "FLIP", 4)) {
+				flipidx = true;
+			} else if (!_strnicmp (cbuf, "LABEL", 5)) {
+				// group labels are not used by the loader
+			} else if (!_strnicmp (cbuf, "STATIC", 6)) {
+				flag |= 0x04;
+			} else if (!_strnicmp (cbuf, "DYNAMIC", 7)) {
+				flag ^= 0x04;
+			} else if (!_strnicmp (cbuf, "GEOM", 4)) {
+				if (sscanf (cbuf+4, "%d%d", &nvtx, &ntri) != 2 || nvtx < 0 || ntri < 0) {
+					nvtx = ntri = 0;
+					break; // parse error - skip group
+				}
+				grp.vtx.assign (nvtx, MeshBinVertex());
+				memset (grp.vtx.data(), 0, nvtx*sizeof(MeshBinVertex));
+				for (i = 0; i < nvtx; i++) {
+					MeshBinVertex &v = grp.vtx[i];
+					if (!GetLine (is, cbuf)) { nvtx = 0; break; }
+					if (bnormal) {
+						j = sscanf (cbuf, "%f%f%f%f%f%f%f%f", &v.x, &v.y, &v.z, &v.nx, &v.ny, &v.nz, &v.tu, &v.tv);
+						if (j < 6) calcnml = true;
+					} else {
+						sscanf (cbuf, "%f%f%f%f%f", &v.x, &v.y, &v.z, &v.tu, &v.tv);
+					}
+				}
+				grp.idx.assign (ntri*3, 0);
+				for (i = 0; i < ntri && nvtx; i++) {
+					if (!GetLine (is, cbuf)) { nvtx = 0; break; }
+					sscanf (cbuf, "%hu%hu%hu", &grp.idx[i*3], &grp.idx[i*3+1], &grp.idx[i*3+2]);
+				}
+				if (flipidx)
+					for (i = 0; i < ntri; i++)
+						std::swap (grp.idx[i*3+1], grp.idx[i*3+2]);
+				break;
+			}
+		}
+		if (nvtx && ntri) {
+			memset (&grp.spec, 0, sizeof(MeshBinGroup));
+			grp.spec.mtrlIdx = (uint32_t)mtrl_idx;
+			grp.spec.texIdx  = (uint32_t)tex_idx;
+			grp.spec.usrFlag = (uint32_t)uflag;
+			grp.spec.zBias   = zbias;
+			grp.spec.flags   = (uint16_t)flag;
+			grp.spec.nVtx    = (uint32_t)grp.vtx.size();
+			grp.spec.nIdx    = (uint32_t)grp.idx.size();
+			if (calcnml) CalcNormals (grp);
+			mesh.grp.push_back (std::move (grp));
+		}
+	}
+
+	// material list
+	if (GetLine (is, cbuf) && !strncmp (cbuf, "MATERIALS", 9) && (sscanf (cbuf+9, "%d", &nmtrl) == 1)) {
+		for (i = 0; i < nmtrl; i++)
+			GetLine (is, cbuf); // material names
+		for (i = 0; i < nmtrl; i++) {
+			MeshBinMaterial m;
+			memset (&m, 0, sizeof(MeshBinMaterial));
+			GetLine (is, cbuf);
+			GetLine (is, cbuf);
+			sscanf (cbuf, "%f%f%f%f", m.diffuse, m.diffuse+1, m.diffuse+2, m.diffuse+3);
+			GetLine (is, cbuf);
+			sscanf (cbuf, "%f%f%f%f", m.ambient, m.ambient+1, m.ambient+2, m.ambient+3);
+			GetLine (is, cbuf);
+			res = sscanf (cbuf, "%f%f%f%f%f", m.specular, m.specular+1, m.specular+2, m.specular+3, &m.power);
+			if (res < 5) m.power = 0.0f;
+			GetLine (is, cbuf);
+			sscanf (cbuf, "%f%f%f%f", m.emissive, m.emissive+1, m.emissive+2, m.emissive+3);
+			mesh.mtrl.push_back (m);
+		}
+	}
+
+	// texture list
+	if (GetLine (is, cbuf) && !strncmp (cbuf, "TEXTURES", 8) && (sscanf (cbuf+8, "%d", &ntex) == 1)) {
+		char texname[256], flagstr[256];
+		for (i = 0; i < ntex; i++) {
+			MeshBinTexture t;
+			memset (&t, 0, sizeof(MeshBinTexture));
+			texname[0] = flagstr[0] = '\0';
+			GetLine (is, cbuf);
+			sscanf (cbuf, "%255s%255s", texname, flagstr);
+			if (texname[0] != '0' || texname[1] != '\0') {
+				strcpy (t.name, texname);
+				if (toupper (flagstr[0]) == 'D') t.flags |= MESHBIN_TEX_UNCOMPRESS;
+			}
+			mesh.tex.push_back (t);
+		}
+	}
+
+	return mesh.grp.size() > 0;
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshBin::Write (const char *fname, const MeshBinData &mesh, uint64_t srcSize, int64_t srcTime)
+{
+	MeshBinHeader hdr;
+	memset (&hdr, 0, sizeof(MeshBinHeader));
+	memcpy (hdr.magic, MAGIC, 8);
+	hdr.version = VERSION;
+	hdr.srcSize = srcSize;
+	hdr.srcTime = srcTime;
+	hdr.ngrp    = (uint32_t)mesh.grp.size();
+	hdr.nmtrl   = (uint32_t)mesh.mtrl.size();
+	hdr.ntex    = (uint32_t)mesh.tex.size();
+
+	// group table with data offsets
+	vector<MeshBinGroup> grp (hdr.ngrp);
+	uint64_t ofs = Align8 (sizeof(MeshBinHeader) + hdr.ngrp*sizeof(MeshBinGroup) +
+		hdr.nmtrl*sizeof(MeshBinMaterial) + hdr.ntex*sizeof(MeshBinTexture));
+	for (uint32_t g = 0; g < hdr.ngrp; g++) {
+		grp[g] = mesh.grp[g].spec;
+		grp[g].nVtx = (uint32_t)mesh.grp[g].vtx.size();
+		grp[g].nIdx = (uint32_t)mesh.grp[g].idx.size();
+		grp[g].vtxOfs = ofs;
+		ofs = Align8 (ofs + grp[g].nVtx*sizeof(MeshBinVertex));
+		grp[g].idxOfs = ofs;
+		ofs = Align8 (ofs + grp[g].nIdx*sizeof(uint16_t));
+	}
+	hdr.size = ofs;
+
+	FILE *f = fopen (fname, "wb");
+	if (!f) return false;
+	static const char pad[8] = {0};
+	uint64_t pos;
+	bool ok = (fwrite (&hdr, sizeof(MeshBinHeader), 1, f) == 1);
+	if (ok && hdr.ngrp)  ok = (fwrite (grp.data(), sizeof(MeshBinGroup), hdr.ngrp, f) == hdr.ngrp);
+	if (ok && hdr.nmtrl) ok = (fwrite (mesh.mtrl.data(), sizeof(MeshBinMaterial), hdr.nmtrl, f) == hdr.nmtrl);
+	if (ok && hdr.ntex)  ok = (fwrite (mesh.tex.data(), sizeof(MeshBinTexture), hdr.ntex, f) == hdr.ntex);
+	pos = sizeof(MeshBinHeader) + hdr.ngrp*sizeof(MeshBinGroup) + hdr.nmtrl*sizeof(MeshBinMaterial) + hdr.ntex*sizeof(MeshBinTexture);
+	for (uint32_t g = 0; ok && g < hdr.ngrp; g++) {
+		const MeshBinData::Group &mg = mesh.grp[g];
+		ok = (fwrite (pad, 1, (size_t)(grp[g].vtxOfs-pos), f) == grp[g].vtxOfs-pos &&
+			fwrite (mg.vtx.data(), sizeof(MeshBinVertex), mg.vtx.size(), f) == mg.vtx.size());
+		pos = grp[g].vtxOfs + mg.vtx.size()*sizeof(MeshBinVertex);
+		ok = ok && (fwrite (pad, 1, (size_t)(grp[g].idxOfs-pos), f) == grp[g].idxOfs-pos &&
+			fwrite (mg.idx.data(), sizeof(uint16_t), mg.idx.size(), f) == mg.idx.size());
+		pos = grp[g].idxOfs + mg.idx.size()*sizeof(uint16_t);
+	}
+	if (ok) ok = (fwrite (pad, 1, (size_t)(hdr.size-pos), f) == hdr.size-pos);
+	if (fclose (f)) ok = false;
+	if (!ok) remove (fname);
+	return ok;
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshBin::Compile (const char *srcname, const char *binname)
+{
+	uint64_t size;
+	int64_t mtime;
+	if (!FileStamp (srcname, size, mtime)) return false;
+	ifstream ifs (srcname);
+	MeshBinData mesh;
+	if (!ParseText (ifs, mesh)) return false;
+	return Write (binname, mesh, size, mtime);
+}
+
+// -----------------------------------------------------------------------
+
+bool MeshBin::FileStamp (const char *fname, uint64_t &size, int64_t &mtime)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64 (fname, &st)) return false;
+#else
+	struct stat st;
+	if (stat (fname, &st)) return false;
+#endif
+	size = (uint64_t)st.st_size;
+	mtime = (int64_t)st.st_mtime;
+	return true;
+}
+
+// =======================================================================
+// class MeshBinFile
+
+MeshBinFile::MeshBinFile ()
+{
+	data = 0;
+	size = 0;
+	hdr = 0;
+	grp = 0;
+	mtrl = 0;
+	tex = 0;
+#ifdef _WIN32
+	hFile = INVALID_HANDLE_VALUE;
+	hMap = NULL;
+#endif
+}
+
+MeshBinFile::~MeshBinFile ()
+{
+	Close ();
+}
+
+bool MeshBinFile::Open (const char *fname, const char *srcname)
+{
+	Close ();
+
+#ifdef _WIN32
+	hFile = CreateFileA (fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return false;
+	LARGE_INTEGER fsize;
+	if (GetFileSizeEx (hFile, &fsize) && fsize.QuadPart >= (LONGLONG)sizeof(MeshBinHeader)) {
+		hMap = CreateFileMappingA (hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap) {
+			data = (const char*)MapViewOfFile (hMap, FILE_MAP_READ, 0, 0, 0);
+			size = (size_t)fsize.QuadPart;
+		}
+	}
+#else
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0) return false;
+	struct stat st;
+	if (fstat (fd, &st) == 0 && st.st_size >= (off_t)sizeof(MeshBinHeader)) {
+		void *p = mmap (NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED) {
+			data = (const char*)p;
+			size = (size_t)st.st_size;
+		}
+	}
+	close (fd);
+#endif
+	if (!data) {
+		Close ();
+		return false;
+	}
+
+	// sanity checks
+	hdr = (const MeshBinHeader*)data;
+	uint64_t tblsize = sizeof(MeshBinHeader) + (uint64_t)hdr->ngrp*sizeof(MeshBinGroup) +
+		(uint64_t)hdr->nmtrl*sizeof(MeshBinMaterial) + (uint64_t)hdr->ntex*sizeof(MeshBinTexture);
+	bool ok = (!memcmp (hdr->magic, MAGIC, 8) && hdr->version == VERSION &&
+		hdr->size == size && tblsize <= size);
+	if (ok) {
+		grp  = (const MeshBinGroup*)(data + sizeof(MeshBinHeader));
+		mtrl = (const MeshBinMaterial*)(grp + hdr->ngrp);
+		tex  = (const MeshBinTexture*)(mtrl + hdr->nmtrl);
+		for (uint32_t g = 0; ok && g < hdr->ngrp; g++) {
+			ok = (grp[g].vtxOfs % 8 == 0 && grp[g].idxOfs % 8 == 0 &&
+				grp[g].vtxOfs + (uint64_t)grp[g].nVtx*sizeof(MeshBinVertex) <= size &&
+				grp[g].idxOfs + (uint64_t)grp[g].nIdx*sizeof(uint16_t) <= size);
+			const uint16_t *idx = Indices (g);
+			for (uint32_t i = 0; ok && i < grp[g].nIdx; i++)
+				ok = (idx[i] < grp[g].nVtx);
+		}
+		for (uint32_t i = 0; ok && i < hdr->ntex; i++)
+			ok = (memchr (tex[i].name, 0, sizeof(tex[i].name)) != 0);
+	}
+
+	// outdated?
+	uint64_t srcSize;
+	int64_t srcTime;
+	if (ok && srcname && MeshBin::FileStamp (srcname, srcSize, srcTime))
+		ok = (srcSize == hdr->srcSize && srcTime == hdr->srcTime);
+
+	if (!ok) {
+		Close ();
+		return false;
+	}
+	return true;
+}
+
+void MeshBinFile::Close ()
+{
+#ifdef _WIN32
+	if (data) UnmapViewOfFile (data);
+	if (hMap) CloseHandle (hMap);
+	if (hFile != INVALID_HANDLE_VALUE) CloseHandle (hFile);
+	hFile = INVALID_HANDLE_VALUE;
+	hMap = NULL;
+#else
+	if (data) munmap ((void*)data, size);
+#endif
+	data = 0;
+	size = 0;
+	hdr = 0;
+	grp = 0;
+	mtrl = 0;
+	tex = 0;
+}
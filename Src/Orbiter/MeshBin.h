@@ -0,0 +1,140 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Compiled binary meshes (.mshb)
+// A compiled mesh holds the contents of a .msh file in the in-memory
+// layout used by the Mesh class, so that it can be memory-mapped and
+// copied into a mesh without parsing. Compiled meshes are created with
+// "meshc --compile" and placed next to the .msh source, with extension
+// .mshb. The size and modification time of the source are stored in the
+// header, so that an outdated compiled mesh can be detected and ignored.
+//
+// File layout:
+//   MeshBinHeader
+//   MeshBinGroup[ngrp]
+//   MeshBinMaterial[nmtrl]
+//   MeshBinTexture[ntex]
+//   vertex and index lists of all groups, 8-byte aligned
+// =======================================================================
+
+#ifndef __MESHBIN_H
+#define __MESHBIN_H
+
+#include <stdint.h>
+#include <iostream>
+#include <vector>
+
+#define MESHBIN_TEX_UNCOMPRESS 0x0001 // texture flag: decompress on load
+
+struct MeshBinHeader {
+	char     magic[8];   // "OMESHBIN"
+	uint32_t version;    // file format version
+	uint32_t flags;      // reserved
+	uint64_t srcSize;    // size of the source .msh file [bytes]
+	int64_t  srcTime;    // modification time of the source .msh file
+	uint32_t ngrp;       // number of groups
+	uint32_t nmtrl;      // number of materials
+	uint32_t ntex;       // number of textures
+	uint32_t reserved;
+	uint64_t size;       // file size [bytes]
+};
+
+struct MeshBinGroup {
+	uint32_t mtrlIdx;    // material index (or SPEC_DEFAULT/SPEC_INHERIT)
+	uint32_t texIdx;     // texture index (or SPEC_DEFAULT/SPEC_INHERIT)
+	uint32_t usrFlag;    // user-defined group flag (FLAG)
+	uint16_t zBias;      // z-bias (ZBIAS)
+	uint16_t flags;      // 0x01/0x02: wrap u/v, 0x04: static group
+	uint32_t nVtx;       // number of vertices
+	uint32_t nIdx;       // number of indices
+	uint64_t vtxOfs;     // file offset of vertex list (MeshBinVertex[nVtx])
+	uint64_t idxOfs;     // file offset of index list (uint16_t[nIdx])
+};
+
+struct MeshBinVertex {   // layout of NTVERTEX
+	float x, y, z;       // position
+	float nx, ny, nz;    // normal
+	float tu, tv;        // texture coordinates
+};
+
+struct MeshBinMaterial { // layout of D3DMATERIAL7
+	float diffuse[4];
+	float ambient[4];
+	float specular[4];
+	float emissive[4];
+	float power;
+};
+
+struct MeshBinTexture {
+	char     name[256];  // texture file name (empty: no texture)
+	uint32_t flags;      // MESHBIN_TEX_xxx
+};
+
+// =======================================================================
+// Mesh contents as read from a text mesh file, for writing a compiled mesh
+
+struct MeshBinData {
+	struct Group {
+		MeshBinGroup spec;   // group parameters (offsets are ignored)
+		std::vector<MeshBinVertex> vtx;
+		std::vector<uint16_t> idx;
+	};
+	std::vector<Group> grp;
+	std::vector<MeshBinMaterial> mtrl;
+	std::vector<MeshBinTexture> tex;
+};
+
+namespace MeshBin {
+	bool ParseText (std::istream &is, MeshBinData &mesh);
+	// Read a text mesh (MSHX1), with the same interpretation as the
+	// Orbiter mesh loader (including the calculation of missing normals).
+	// Returns false if the mesh is invalid or contains no groups.
+
+	bool Write (const char *fname, const MeshBinData &mesh, uint64_t srcSize = 0, int64_t srcTime = 0);
+	// Write a compiled mesh. srcSize and srcTime identify the source file.
+
+	bool Compile (const char *srcname, const char *binname);
+	// Compile text mesh srcname into binary mesh binname
+
+	bool FileStamp (const char *fname, uint64_t &size, int64_t &mtime);
+	// size and modification time of a file. Returns false if the file
+	// doesn't exist.
+}
+
+// =======================================================================
+// Read access to a memory-mapped compiled mesh
+
+class MeshBinFile {
+public:
+	MeshBinFile ();
+	~MeshBinFile ();
+
+	bool Open (const char *fname, const char *srcname = 0);
+	// Map a compiled mesh. If srcname is provided, the mesh is rejected if
+	// the source file exists and doesn't match the size and modification
+	// time recorded at compile time. Returns false if the file doesn't
+	// exist, is not a valid compiled mesh, or is outdated.
+
+	void Close ();
+
+	inline const MeshBinHeader &Header () const { return *hdr; }
+	inline const MeshBinGroup &Group (uint32_t i) const { return grp[i]; }
+	inline const MeshBinMaterial &Material (uint32_t i) const { return mtrl[i]; }
+	inline const MeshBinTexture &Texture (uint32_t i) const { return tex[i]; }
+	inline const MeshBinVertex *Vertices (uint32_t i) const { return (const MeshBinVertex*)(data + grp[i].vtxOfs); }
+	inline const uint16_t *Indices (uint32_t i) const { return (const uint16_t*)(data + grp[i].idxOfs); }
+
+private:
+	const char *data;             // mapped view
+	size_t size;
+	const MeshBinHeader *hdr;
+	const MeshBinGroup *grp;
+	const MeshBinMaterial *mtrl;
+	const MeshBinTexture *tex;
+#ifdef _WIN32
+	void *hFile, *hMap;
+#endif
+};
+
+#endif // !__MESHBIN_H
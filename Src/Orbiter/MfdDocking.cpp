@@ -665,9 +665,11 @@ bool Instrument_Docking::ClbkSelection_Target (Select *menu, int item, char *str
 	if (!str) { // main menu
 		menu->Append ("By name ...");
 		menu->AppendSeparator ();
-		for (i = 0; i < g_psys->nVessel(); i++) {
-			vessel = g_psys->GetVessel (i);
-			if (vessel == mfd->vessel) continue;
+		// list the other vessels in order of distance
+		std::vector<Vessel*> vlist;
+		g_psys->NearestVessels (mfd->vessel->GPos(), g_psys->nVessel(), vlist, mfd->vessel);
+		for (i = 0; i < vlist.size(); i++) {
+			vessel = vlist[i];
 			menu->Append (vessel->Name(), vessel->nDock() ? ITEM_SUBMENU : 0);
 		}
 		return true;
@@ -43,7 +43,10 @@
 #include "DlgCtrl.h"
 #include "GraphicsAPI.h"
 #include "ConsoleManager.h"
+#include "Bench.h"
+#include "Profiler.h"
 #include <filesystem>
+#include <algorithm>
 namespace fs = std::filesystem;
 
 using namespace std;
@@ -259,6 +262,14 @@ bool Orbiter::InitializeWorld (char *name)
 		DestroyWorld();
 		return false;
 	}
+
+	// fit ephemeris tables, if requested from the command line
+	const CFG_CMDLINEPRM &clp = pConfig->CfgCmdlinePrm;
+	if (clp.EphemFitMJD1 > clp.EphemFitMJD0) {
+		OutputLoadStatus ("Ephemeris tables", 0);
+		for (size_t i = 0; i < g_psys->nGrav(); i++)
+			g_psys->GetGravObj(i)->FitEphemerisTable (clp.EphemFitMJD0, clp.EphemFitMJD1, clp.EphemFitTol);
+	}
 	return true;
 }
 
@@ -377,6 +388,10 @@ HRESULT Orbiter::Create (HINSTANCE hInstance)
 	// Read key mapping from file (or write default keymap)
 	if (!keymap.Read ("keymap.cfg")) keymap.Write ("keymap.cfg");
 
+	// convert flight recording streams, if requested from the command line
+	if (pConfig->CfgCmdlinePrm.FRConvert.size())
+		FRecorder_Convert (pConfig->CfgCmdlinePrm.FRConvert.c_str());
+
     pState = new State(); TRACENEW
 
 	// Register main dialog window class
@@ -729,6 +744,13 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 	else if (Cfg()->CfgDebugPrm.FixedStep > 0.0)
 		td.SetFixedStep(Cfg()->CfgDebugPrm.FixedStep);
 
+	// benchmark mode: fixed number of fixed-length steps
+	if (pConfig->CfgCmdlinePrm.BenchOut.size()) {
+		if (!td.FixedStep()) td.SetFixedStep(0.1);
+		if (!pConfig->CfgCmdlinePrm.FrameLimit) pConfig->CfgCmdlinePrm.FrameLimit = 1000;
+		g_bench = new FrameBench;
+	}
+
 	if (!InitializeWorld (pState->Solsys())) {
 		LOGOUT_ERR_FILENOTFOUND_MSG(g_pOrbiter->ConfigPath (pState->Solsys()), "while initialising solar system %s", pState->Solsys());
 		TerminateOnError();
@@ -737,6 +759,7 @@ HWND Orbiter::CreateRenderWindow (Config *pCfg, const char *scenario)
 	LOGOUT("Finished initialising world");
 	ms_prev = timeGetTime () - 1; // make sure SimDT > 0 for first frame
 
+	PreloadMeshes (ScnPath (scenario));
 	g_psys->InitState (ScnPath (scenario));
 
 	g_focusobj = 0;
@@ -866,6 +889,20 @@ void Orbiter::CloseSession ()
 
 	bSession = false;
 
+	if (g_bench) {
+		if (g_bench->Write (pConfig->CfgCmdlinePrm.BenchOut.c_str(), ScenarioName, td.FixedStep()))
+			LOGOUT("Benchmark: %d frames written to %s", (int)g_bench->nFrame(), pConfig->CfgCmdlinePrm.BenchOut.c_str());
+		else
+			LOGOUT_WARN("Benchmark: could not write %s", pConfig->CfgCmdlinePrm.BenchOut.c_str());
+		delete g_bench;
+		g_bench = 0;
+	}
+
+#ifdef ORBITER_PROFILE
+	if (Profiler::Dump ("Orbiter_trace.json"))
+		LOGOUT("Profiler: trace written to Orbiter_trace.json");
+#endif
+
 	if      (bRecord)   ToggleRecorder();
 	else if (bPlayback) EndPlayback();
 	const char* desc = pConfig->CfgDebugPrm.bSaveExitScreen ? "CurrentState_img" : "CurrentState";
@@ -1760,6 +1797,48 @@ const Mesh *Orbiter::LoadMeshGlobal (const char *fname, LoadMeshClbkFunc fClbk)
 	return mesh;
 }
 
+//-----------------------------------------------------------------------------
+// Collect the meshes of the vessel classes (MeshName entry of the class
+// configuration files) in the scenario ship list, and pass them to the mesh
+// manager for parallel loading. Meshes loaded by vessel modules are not
+// known in advance and are still loaded on demand.
+//-----------------------------------------------------------------------------
+void Orbiter::PreloadMeshes (const char *scenario)
+{
+	char cbuf[256], cls[256], *pc, *pd;
+	std::vector<std::string> meshes, classes;
+	ifstream ifs (scenario);
+	if (!ifs || !FindLine (ifs, "BEGIN_SHIPS")) return;
+	for (;;) {
+		if (!ifs.getline (cbuf, 256)) break;
+		pc = trim_string (cbuf);
+		if (!_stricmp (pc, "END_SHIPS")) break;
+		for (pd = pc; *pd != '\0' && *pd != ':'; pd++);
+		if (*pd) *pd++ = '\0';
+		else pd = pc;
+		if (*pd) classes.push_back (pd);
+		while (ifs.getline (cbuf, 256) && _stricmp (trim_string (cbuf), "END")); // skip vessel state
+	}
+	std::sort (classes.begin(), classes.end());
+	classes.erase (std::unique (classes.begin(), classes.end()), classes.end());
+
+	for (size_t i = 0; i < classes.size(); i++) {
+		strcpy (cls, classes[i].c_str());
+		for (int depth = 0; cls[0] && depth < 8; depth++) { // follow BaseClass entries
+			ifstream cfg;
+			if (!depth) {
+				sprintf (cbuf, "Vessels\\%s", cls);
+				cfg.open (ConfigPath (cbuf));
+				if (!cfg) { cfg.clear(); cfg.open (ConfigPath (cls)); }
+			} else cfg.open (ConfigPath (cls));
+			if (!cfg) break;
+			if (GetItemString (cfg, "MeshName", cbuf)) meshes.push_back (cbuf);
+			if (!GetItemString (cfg, "BaseClass", cls)) cls[0] = '\0';
+		}
+	}
+	meshmanager.Preload (meshes);
+}
+
 //-----------------------------------------------------------------------------
 // Name: Output2DData()
 // Desc: Output HUD and other 2D information on top of the render window
@@ -1859,6 +1938,8 @@ void Orbiter::EndTimeStep (bool running)
 		//ModulePostStep();
 	}
 
+	if (g_bench && running) g_bench->EndFrame ();
+
 	// Copy frame times from T1 to T0
 	td.EndStep (running);
 
@@ -1972,12 +2053,16 @@ bool Orbiter::UnregisterCustomCmd (int cmdId)
 void Orbiter::ModulePreStep ()
 {
 	// broadcast to modules
-	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
+	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++) {
+		PROFILE_ZONE_NAMED("clbkPreStep", it->sName.c_str());
 		it->pModule->clbkPreStep(td.SimT0, td.SimDT, td.MJD0);
+	}
 
 	// broadcast to vessels
-	for (DWORD i = 0; i < g_psys->nVessel(); i++)
+	for (DWORD i = 0; i < g_psys->nVessel(); i++) {
+		PROFILE_ZONE_NAMED("clbkPreStep", g_psys->GetVessel(i)->ClassName());
 		g_psys->GetVessel(i)->ModulePreStep (td.SimT0, td.SimDT, td.MJD0);
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -1987,12 +2072,16 @@ void Orbiter::ModulePreStep ()
 void Orbiter::ModulePostStep ()
 {
 	// broadcast to vessels
-	for (DWORD i = 0; i < g_psys->nVessel(); i++)
+	for (DWORD i = 0; i < g_psys->nVessel(); i++) {
+		PROFILE_ZONE_NAMED("clbkPostStep", g_psys->GetVessel(i)->ClassName());
 		g_psys->GetVessel(i)->ModulePostStep (td.SimT1, td.SimDT, td.MJD1);
+	}
 
 	// broadcast to modules
-	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++)
+	for (auto it = m_Plugin.begin(); it != m_Plugin.end(); it++) {
+		PROFILE_ZONE_NAMED("clbkPostStep", it->sName.c_str());
 		it->pModule->clbkPostStep(td.SimT1, td.SimDT, td.MJD1);
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -2001,24 +2090,37 @@ void Orbiter::ModulePostStep ()
 //-----------------------------------------------------------------------------
 VOID Orbiter::UpdateWorld ()
 {
+	PROFILE_ZONE("Orbiter::UpdateWorld");
+
+	if (g_bench) {
+		g_bench->BeginFrame ();
+		g_bench->Begin (FrameBench::PH_PRESTEP);
+	}
+
 	// module pre-timestep callbacks
 	if (bRunning) ModulePreStep ();
+	if (g_bench) g_bench->End ();
 
 	// update world
 	g_bStateUpdate = true;
 	if (bRunning && td.SimDT) {
 		if (bPlayback) FRecorder_Play();
 		g_psys->Update (g_bForceUpdate);           // logical objects
+		if (pConfig->CfgDebugPrm.bPropStats)
+			g_psys->PropagationStats (DBG_MSG, sizeof(DBG_MSG));
 	}
 	if (pDlgMgr) pDlgMgr->UpdateDialogs(); // SHOULD BE DONE BY GRAPHICS CLIENT!
 
 	// module post-timestep callbacks
+	if (g_bench) g_bench->Begin (FrameBench::PH_POSTSTEP);
 	if (bRunning) ModulePostStep ();
 
 	g_bStateUpdate = false;
 
+	if (g_bench) g_bench->Begin (FrameBench::PH_KILL);
 	if (!KillVessels())  // kill any vessels marked for deletion
 		if (hRenderWnd) DestroyWindow (hRenderWnd);
+	if (g_bench) g_bench->End ();
 
 	//g_texmanager->OutputInfo();
 }
@@ -219,6 +219,8 @@ public:
 	// reset flight recorder status
 	bool FRecorder_PrepareDir (const char *fname, bool force);
 	// clear the flight recording directory
+	void FRecorder_Convert (const char *fname);
+	// convert the vessel streams of a recording between text and binary format
 	void FRecorder_Activate (bool active, const char *fname, bool append = false);
 	// activate the flight recorder
 	void FRecorder_SaveEvent (const char *event_type, const char *event);
@@ -256,6 +258,10 @@ public:
 	const Mesh *LoadMeshGlobal (const char *fname);
 	const Mesh *LoadMeshGlobal (const char *fname, LoadMeshClbkFunc fClbk);
 
+	// Load the meshes of the vessel classes used in a scenario, in
+	// parallel, before the vessels are created
+	void PreloadMeshes (const char *scenario);
+
 	// graphics client shortcuts
 	inline SURFHANDLE LoadTexture (const char *fname, DWORD flags = 0)
 	{ return (gclient ? gclient->clbkLoadTexture (fname, flags) : NULL); }
@@ -23,6 +23,7 @@
 #include "resource.h"
 #include "Mesh.h"
 #include "MenuInfoBar.h"
+#include "Profiler.h"
 #include <zlib.h>
 #include "DrawAPI.h"
 
@@ -174,6 +175,32 @@ DLLEXPORT bool oapiIsVessel (OBJHANDLE hVessel)
 	return (g_psys ? g_psys->isVessel ((const Vessel*)hVessel) : false);
 }
 
+DLLEXPORT int oapiGetVesselsInRange (const VECTOR3 &gpos, double r, OBJHANDLE *list, int maxn, OBJHANDLE hExclude)
+{
+	if (!g_psys) return 0;
+	static std::vector<Vessel*> vlist;
+	vlist.clear();
+	g_psys->VesselsInRange (MakeVector(gpos), r, vlist, (const Vessel*)hExclude);
+	for (int i = 0; i < maxn && i < (int)vlist.size(); i++)
+		list[i] = (OBJHANDLE)vlist[i];
+	return (int)vlist.size();
+}
+
+DLLEXPORT int oapiGetNearestVessels (const VECTOR3 &gpos, int k, OBJHANDLE *list, double *dist, OBJHANDLE hExclude)
+{
+	if (!g_psys || k <= 0) return 0;
+	static std::vector<Vessel*> vlist;
+	static std::vector<double> dlist;
+	vlist.clear();
+	dlist.clear();
+	g_psys->NearestVessels (MakeVector(gpos), k, vlist, (const Vessel*)hExclude, dist ? &dlist : 0);
+	for (int i = 0; i < (int)vlist.size(); i++) {
+		list[i] = (OBJHANDLE)vlist[i];
+		if (dist) dist[i] = dlist[i];
+	}
+	return (int)vlist.size();
+}
+
 DLLEXPORT OBJHANDLE oapiGetStationByName (char *name)
 {
 	static bool bWarning = true;
@@ -2310,6 +2337,29 @@ DLLEXPORT void oapiWriteLog (char *line)
 	LOGOUT (line);
 }
 
+DLLEXPORT void oapiProfileBegin (const char *name)
+{
+#ifdef ORBITER_PROFILE
+	Profiler::Begin (Profiler::Intern (name));
+#endif
+}
+
+DLLEXPORT void oapiProfileEnd ()
+{
+#ifdef ORBITER_PROFILE
+	Profiler::End ();
+#endif
+}
+
+DLLEXPORT bool oapiProfileDump (const char *fname)
+{
+#ifdef ORBITER_PROFILE
+	return Profiler::Dump (fname);
+#else
+	return false;
+#endif
+}
+
 DLLEXPORT void oapiExitOrbiter(int code)
 {
 	exit(code);
@@ -22,10 +22,21 @@
 
 #include <fstream>
 #include <cmath>
+#include <vector>
 #include "Vecmat.h"
 #include "PinesGrav.h"
 #include "Orbiter.h"
 
+struct PinesWorkspace {
+	std::vector<double> A; // normalized associated Legendre functions
+	std::vector<double> R; // real parts of (s + i t)^m
+	std::vector<double> I; // imaginary parts of (s + i t)^m
+};
+
+// Working arrays for GetPinesGrav. They are per thread rather than per body,
+// so that several threads can evaluate the same model concurrently.
+static thread_local PinesWorkspace g_pinesWorkspace;
+
 PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 {
 	parentBody = celestialbody;
@@ -39,64 +50,74 @@ PinesGravProp::PinesGravProp(CelestialBody* celestialbody)
 	referenceLon = 0.0;
 	C = NULL;
 	S = NULL;
-	A = NULL;
-	R = NULL;
-	I = NULL;
+	ALPHA = NULL;
+	BETA = NULL;
+	DIAG = NULL;
+	OFFD = NULL;
+	GRADA = NULL;
 	numCoeff = 0;
 	CoeffCutoff = 0;
-
-	r = 0.0;
-	s = 0.0;
-	t = 0.0;
-	u = 0.0;
-	rho = 0.0;
-	rhop = 0.0;
-
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
+	tableDegree = 0;
 }
 
 PinesGravProp::~PinesGravProp()
 {
 	delete[] C;
 	delete[] S;
-	delete[] A;
-	delete[] R;
-	delete[] I;
+	delete[] ALPHA;
+	delete[] BETA;
+	delete[] DIAG;
+	delete[] OFFD;
+	delete[] GRADA;
+}
+
+void PinesGravProp::GenerateRecursionTables(unsigned int maxDegree)
+{
+	// Coefficients of the Legendre recursion and of the acceleration sums.
+	// They depend only on n and m, so they are computed once per model.
+	int nmax = (int)maxDegree + 2;
+
+	DIAG[0] = sqrt(2.0);
+	for (int m = 0; m <= nmax; m++) {
+		if (m != 0)
+			DIAG[m] = sqrt(1. + (1. / (2. * (double)m))) * DIAG[m - 1];
+		OFFD[m] = sqrt(2. * (double)m + 3.);
+		for (int n = m + 2; n <= nmax; n++) {
+			double ALPHA_NUM = (2. * (double)n + 1.) * (2. * (double)n - 1.);
+			double ALPHA_DEN = ((double)n - (double)m) * ((double)n + (double)m);
+			ALPHA[NM(n, m)] = sqrt(ALPHA_NUM / ALPHA_DEN);
+			double BETA_NUM = (2. * (double)n + 1.) * ((double)n - (double)m - 1.) * ((double)n + (double)m - 1.);
+			double BETA_DEN = (2. * (double)n - 3.) * ((double)n + (double)m) * ((double)n - (double)m);
+			BETA[NM(n, m)] = sqrt(BETA_NUM / BETA_DEN);
+		}
+	}
+
+	for (int n = 0; n <= (int)maxDegree; n++) {
+		for (int m = 0; m <= n; m++) {
+			double SM = (m == 0 ? 0.5 : 1.0);
+			GRADA[NM(n, m)] = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
+		}
+	}
+	tableDegree = maxDegree;
 }
 
-inline void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree)
+void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree, double u, double* __restrict A) const
 {
-	A[0] = sqrt(2.0);
+	A[0] = DIAG[0];
 
 	for (int m = 0; m <= (maxDegree + 2); m++) {
 
 		if (m != 0) {
-			A[NM(m, m)] = sqrt(1. + (1. / (2. * (double)m))) * A[NM(m - 1, m - 1)]; // diagonal terms
+			A[NM(m, m)] = DIAG[m]; // diagonal terms
 		}
 
 		if (m != (maxDegree + 2)) {
-			A[NM(m + 1, m)] = sqrt(2. * (double)m + 3.) * u * A[NM(m, m)]; // off-diagonal terms
+			A[NM(m + 1, m)] = OFFD[m] * u * A[NM(m, m)]; // off-diagonal terms
 		}
 
 		if (m < maxDegree + 1) {
 			for (int n = m + 2; n <= (maxDegree + 2); n++) {
-				double ALPHA_NUM = (2. * (double)n + 1.) * (2. * (double)n - 1.);
-				double ALPHA_DEN = ((double)n - (double)m) * ((double)n + (double)m);
-				double ALPHA = sqrt(ALPHA_NUM / ALPHA_DEN);
-				double BETA_NUM = (2. * (double)n + 1.) * ((double)n - (double)m - 1.) * ((double)n + (double)m - 1.);
-				double BETA_DEN = (2. * (double)n - 3.) * ((double)n + (double)m) * ((double)n - (double)m);
-				double BETA = sqrt(BETA_NUM / BETA_DEN);
-
-
-				A[NM(n, m)] = ALPHA * u * A[NM(n - 1, m)] - BETA * A[NM(n - 2, m)]; // remaining terms in the column
+				A[NM(n, m)] = ALPHA[NM(n, m)] * u * A[NM(n - 1, m)] - BETA[NM(n, m)] * A[NM(n - 2, m)]; // remaining terms in the column
 			}
 		}
 	}
@@ -106,7 +127,6 @@ inline void PinesGravProp::GenerateAssocLegendreMatrix(int maxDegree)
 	}
 
 }
-
 int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTerms, int &maxModelTerms)
 {
 	FILE* gravModelFile = nullptr;
@@ -120,14 +140,17 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	try {
 		C = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
 		S = new double[(size_t)NM(cutoff + 1, cutoff + 1)];
-		R = new double[(size_t)cutoff + 2];
-		I = new double[(size_t)cutoff + 2];
-		A = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		ALPHA = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		BETA = new double[NM((size_t)cutoff + 3, (size_t)cutoff + 3)];
+		DIAG = new double[(size_t)cutoff + 3];
+		OFFD = new double[(size_t)cutoff + 3];
+		GRADA = new double[NM((size_t)cutoff + 1, (size_t)cutoff + 1)];
 	}
 	catch (std::bad_alloc) {
 		return 2; //Could not allocate space
 	}
 	numCoeff = 0;
+	GenerateRecursionTables(cutoff);
 
 	C[0] = 0;	//This needs to be 0 unless you want the point-mass gravity as well.
 	S[0] = 0; 
@@ -182,68 +205,78 @@ int PinesGravProp::readGravModel(char* filename, int cutoff, int &actualLoadedTe
 	}
 }
 
-Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder)
+Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const
 {
-	r = rpos.length();
-	s = rpos.x / r;
-	t = rpos.y / r;
-	u = rpos.z / r;
+	return EvalPinesGrav(rpos, maxDegree, maxOrder, g_pinesWorkspace);
+}
+
+void PinesGravProp::GetPinesGrav(const Vector* rpos, Vector* acc, int npos, const int maxDegree, const int maxOrder) const
+{
+	PinesWorkspace& ws = g_pinesWorkspace;
+	for (int i = 0; i < npos; i++)
+		acc[i] = EvalPinesGrav(rpos[i], maxDegree, maxOrder, ws);
+}
+
+Vector PinesGravProp::EvalPinesGrav(const Vector& rpos, const int maxDegree, const int maxOrder, PinesWorkspace& ws) const
+{
+	int nmax = (maxDegree < (int)tableDegree ? maxDegree : (int)tableDegree);
+	int mmax = (maxOrder < nmax ? maxOrder : nmax);
+
+	if (ws.A.size() < NM(nmax + 3, nmax + 3)) ws.A.resize(NM(nmax + 3, nmax + 3));
+	if (ws.R.size() < (size_t)mmax + 2) ws.R.resize((size_t)mmax + 2), ws.I.resize((size_t)mmax + 2);
+	double* __restrict A = ws.A.data();
+	double* __restrict R = ws.R.data();
+	double* __restrict I = ws.I.data();
 
-	rho = GM / (r * refRad);
-	rhop = refRad / r;
+	double r = rpos.length();
+	double s = rpos.x / r;
+	double t = rpos.y / r;
+	double u = rpos.z / r;
+
+	double rho = GM / (r * refRad);
+	double rhop = refRad / r;
 
 	R[0] = 0.0;
 	I[0] = 0.0;
 	R[1] = 1.0;
 	I[1] = 0.0;
 
-	for (int m = 2; m <= maxOrder + 1; m++) {
+	for (int m = 2; m <= mmax + 1; m++) {
 		R[m] = s * R[m - 1] - t * I[m - 1];
 		I[m] = s * I[m - 1] + t * R[m - 1];
 	}
 
-	g1temp = 0.0;
-	g2temp = 0.0;
-	g3temp = 0.0;
-	g4temp = 0.0;
-
-	g1 = 0.0;
-	g2 = 0.0;
-	g3 = 0.0;
-	g4 = 0.0;
+	double g1 = 0.0;
+	double g2 = 0.0;
+	double g3 = 0.0;
+	double g4 = 0.0;
 
 	int nmodel = 0;
-	GenerateAssocLegendreMatrix(maxDegree);
-	for (int n = 0; n <= maxDegree; n++) {
+	GenerateAssocLegendreMatrix(nmax, u, A);
+	for (int n = 0; n <= nmax; n++) {
 
-		g1temp = 0.0;
-		g2temp = 0.0;
-		g3temp = 0.0;
-		g4temp = 0.0;
+		double g1temp = 0.0;
+		double g2temp = 0.0;
+		double g3temp = 0.0;
+		double g4temp = 0.0;
 
-		double SM = 0.5;
-
-		if (n > maxOrder)
-			nmodel = maxOrder;
+		if (n > mmax)
+			nmodel = mmax;
 		else
 			nmodel = n;
 
-
 		for (int m = 0; m <= nmodel; m++) {
 
 			double D = C[NM(n, m)] * R[m + 1] + S[NM(n, m)] * I[m + 1];
 			double E = C[NM(n, m)] * R[m] + S[NM(n, m)] * I[m];
 			double F = S[NM(n, m)] * R[m] - C[NM(n, m)] * I[m];
 
-
-			double ALPHA = sqrt(SM * ((double)n - (double)m) * ((double)n + (double)m + 1));
+			double ALPHA_G = GRADA[NM(n, m)];
 
 			g1temp = g1temp + A[NM(n, m)] * (double)m * E;
 			g2temp = g2temp + A[NM(n, m)] * (double)m * F;
-			g3temp = g3temp + ALPHA * A[NM(n, m + 1)] * D;
-			g4temp = g4temp + (((double)n + (double)m + 1) * A[NM(n, m)] + ALPHA * u * A[NM(n, m + 1)]) * D;
-
-			if (m == 0) { SM = 1.0; ; }
+			g3temp = g3temp + ALPHA_G * A[NM(n, m + 1)] * D;
+			g4temp = g4temp + (((double)n + (double)m + 1) * A[NM(n, m)] + ALPHA_G * u * A[NM(n, m + 1)]) * D;
 		}
 		rho = rhop * rho;
 
@@ -261,4 +294,4 @@ Vector PinesGravProp::GetPinesGrav(const Vector rpos, const int maxDegree, const
 	gperturbed.z = (g3 - g4 * u);
 
 	return gperturbed;
-}
\ No newline at end of file
+}
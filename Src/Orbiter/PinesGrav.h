@@ -22,6 +22,7 @@
 #ifndef __PINESGRAV_H
 #define __PINESGRAV_H
 class CelestialBody;
+struct PinesWorkspace; // per-thread working arrays
 
 class PinesGravProp
 {
@@ -29,41 +30,42 @@ public:
 	PinesGravProp(CelestialBody* celestialbody);
 	~PinesGravProp();
 	int readGravModel(char* filename, int cutoff, int& actualLoadedTerms, int& maxModelTerms);
-	Vector GetPinesGrav(const Vector rposmax, const int maxDegree, const int maxOrder);
+
+	// Perturbation acceleration at body-relative position rpos [km] (right-handed body frame).
+	// Reentrant: the working arrays are kept per thread, so this may be called concurrently.
+	Vector GetPinesGrav(const Vector rpos, const int maxDegree, const int maxOrder) const;
+
+	// Batched version: evaluates npos positions in one call
+	void GetPinesGrav(const Vector* rpos, Vector* acc, int npos, const int maxDegree, const int maxOrder) const;
+
 	inline unsigned int GetCoeffCutoff() const { return CoeffCutoff; }
 private:
-	CelestialBody* parentBody;
-	inline void GenerateAssocLegendreMatrix(int maxDegree);
+	Vector EvalPinesGrav(const Vector& rpos, const int maxDegree, const int maxOrder, PinesWorkspace& ws) const;
+	void GenerateAssocLegendreMatrix(int maxDegree, double u, double* __restrict A) const;
+	void GenerateRecursionTables(unsigned int maxDegree);
 
 	static inline unsigned int NM(unsigned int n, unsigned int m) { return (n * n + n) / 2 + m; }
 
+	CelestialBody* parentBody;
 	double refRad;
 	double GM;
 	unsigned int degree;
 	unsigned int order;
 	unsigned int normalized;
 	unsigned int CoeffCutoff;
+	unsigned int tableDegree; // max degree covered by the recursion tables
 	double referenceLat;
 	double referenceLon;
 	double* __restrict C;
 	double* __restrict S;
-	double* __restrict A;
-	double* __restrict R;
-	double* __restrict I;
 	unsigned long int numCoeff;
 
-	double r, s, t, u;
-	double rho, rhop;
-
-	double g1temp;
-	double g2temp;
-	double g3temp;
-	double g4temp;
-
-	double g1;
-	double g2;
-	double g3;
-	double g4;
+	// Recursion coefficients, precomputed when the model is loaded
+	double* __restrict ALPHA;  // column recursion factor for A(n,m) from A(n-1,m)
+	double* __restrict BETA;   // column recursion factor for A(n,m) from A(n-2,m)
+	double* __restrict DIAG;   // diagonal terms A(m,m)
+	double* __restrict OFFD;   // off-diagonal factors sqrt(2m+3)
+	double* __restrict GRADA;  // derivative factors sqrt(SM(n-m)(n+m+1)) of the acceleration sums
 };
 
 #endif
\ No newline at end of file
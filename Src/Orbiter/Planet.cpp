@@ -758,20 +758,6 @@ void Planet::ElToEcliptic (const Elements *el_equ, Elements *el_ecl) const
 	el_ecl->Calculate (mul (GRot(), pos), mul (GRot(), vel), 0.0);
 }
 
-void Planet::BeginStateUpdate ()
-{
-	CelestialBody::BeginStateUpdate();
-	for (DWORD i = 0; i < nbase; i++)
-		baselist[i]->BeginStateUpdate();
-}
-
-void Planet::EndStateUpdate ()
-{
-	CelestialBody::EndStateUpdate();
-	for (DWORD i = 0; i < nbase; i++)
-		baselist[i]->EndStateUpdate();
-}
-
 void Planet::Update (bool force)
 {
 	if (bHasCloudlayer) {
@@ -781,10 +767,9 @@ void Planet::Update (bool force)
 
 	CelestialBody::Update (force);
 
-	// Update bases
-	for (DWORD i = 0; i < nbase; i++)
-		baselist[i]->Update (force);
-
+	// Note: base states are derived from the planet state on demand (see
+	// Base::SyncState), and their buffered sun directions are refreshed by
+	// PlanetarySystem::UpdateBases
 }
 
 void Planet::AddObserverSite (double lng, double lat, double alt, char *site, char *addr)
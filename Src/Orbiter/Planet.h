@@ -118,9 +118,6 @@ public:
 	void ScanBases (char *path);
 	// create surface bases by scanning config files in directory 'path'
 
-	void BeginStateUpdate ();
-	void EndStateUpdate ();
-
 	void Update (bool force = false);
 	// Perform time step
 
@@ -0,0 +1,190 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Scoped-zone profiler
+// Each thread writes completed zones into its own ring buffer; only the
+// owning thread writes to a buffer, so recording is lock-free. Dump reads
+// the buffers concurrently and discards entries that were overwritten
+// while being copied.
+// =======================================================================
+
+#ifdef ORBITER_PROFILE
+
+#include "Profiler.h"
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+	const size_t NEVENT = 1 << 16; // ring buffer size per thread (power of 2)
+	const int MAXDEPTH = 64;       // max. nesting depth of open zones
+	const size_t NCACHE = 256;     // interned name cache size per thread (power of 2)
+
+	typedef chrono::steady_clock Clock;
+	const Clock::time_point t_origin = Clock::now();
+
+	inline int64_t Now ()
+	{
+		return chrono::duration_cast<chrono::nanoseconds>(Clock::now() - t_origin).count();
+	}
+
+	struct Event {
+		const char *name;
+		int64_t t0;  // start time [ns]
+		int64_t dt;  // duration [ns]
+	};
+
+	struct ThreadBuffer {
+		int tid;                   // trace thread id
+		Event ev[NEVENT];
+		atomic<uint64_t> head;     // number of events written
+		struct {
+			const char *name;
+			int64_t t0;
+		} open[MAXDEPTH];          // stack of open zones
+		int depth;
+		ThreadBuffer (int id): tid(id), head(0), depth(0) {}
+	};
+
+	mutex s_mutex;                         // protects s_buffers and s_names
+	vector<unique_ptr<ThreadBuffer> > s_buffers;
+	unordered_set<string> s_names;         // interned zone names
+
+	ThreadBuffer *Buffer ()
+	{
+		// buffers are kept after their thread exits, so their events can still be written
+		thread_local ThreadBuffer *buf = 0;
+		if (!buf) {
+			lock_guard<mutex> lock (s_mutex);
+			s_buffers.emplace_back (new ThreadBuffer ((int)s_buffers.size()+1));
+			buf = s_buffers.back().get();
+		}
+		return buf;
+	}
+
+	bool NameMatches (const char *str, const char *prefix, const char *name)
+	{
+		// str == "<prefix> <name>" (or "<prefix>" if name is 0)?
+		while (*prefix) if (*str++ != *prefix++) return false;
+		if (!name) return !*str;
+		if (*str++ != ' ') return false;
+		return !strcmp (str, name);
+	}
+
+	void WriteString (FILE *f, const char *str)
+	{
+		fputc ('"', f);
+		for (const char *c = str; *c; c++) {
+			if (*c == '"' || *c == '\\') fputc ('\\', f);
+			if ((unsigned char)*c >= 0x20) fputc (*c, f);
+		}
+		fputc ('"', f);
+	}
+
+}
+
+void Profiler::Begin (const char *name)
+{
+	ThreadBuffer *buf = Buffer();
+	if (buf->depth < MAXDEPTH) {
+		buf->open[buf->depth].name = name;
+		buf->open[buf->depth].t0 = Now();
+	}
+	buf->depth++;
+}
+
+void Profiler::End ()
+{
+	ThreadBuffer *buf = Buffer();
+	if (!buf->depth) return; // unbalanced End
+	if (--buf->depth < MAXDEPTH) {
+		uint64_t h = buf->head.load (memory_order_relaxed);
+		Event &e = buf->ev[h & (NEVENT-1)];
+		e.name = buf->open[buf->depth].name;
+		e.t0 = buf->open[buf->depth].t0;
+		e.dt = Now() - e.t0;
+		buf->head.store (h+1, memory_order_release);
+	}
+}
+
+const char *Profiler::Intern (const char *prefix, const char *name)
+{
+	// Zones are opened repeatedly with the same strings, so names are looked
+	// up in a per-thread cache keyed by the string addresses first, which
+	// doesn't need the lock. The contents are compared as well, since a
+	// transient string can reuse an address.
+	struct CacheEntry {
+		const char *prefix, *name;
+		const char *str;           // interned name
+	};
+	thread_local CacheEntry cache[NCACHE] = {};
+	size_t h = (((uintptr_t)prefix >> 3) * 31 + ((uintptr_t)name >> 3)) & (NCACHE-1);
+	CacheEntry &c = cache[h];
+	if (c.str && c.prefix == prefix && c.name == name && NameMatches (c.str, prefix, name))
+		return c.str;
+
+	string str (prefix);
+	if (name) str.append (1, ' ').append (name);
+	{
+		lock_guard<mutex> lock (s_mutex);
+		c.str = s_names.insert (str).first->c_str();
+	}
+	c.prefix = prefix;
+	c.name = name;
+	return c.str;
+}
+
+bool Profiler::Dump (const char *fname)
+{
+	FILE *f = fopen (fname, "wt");
+	if (!f) return false;
+
+	vector<ThreadBuffer*> bufs;
+	{
+		lock_guard<mutex> lock (s_mutex);
+		for (auto it = s_buffers.begin(); it != s_buffers.end(); it++)
+			bufs.push_back (it->get());
+	}
+
+	vector<Event> ev;
+	bool first = true;
+	fprintf (f, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+	for (auto it = bufs.begin(); it != bufs.end(); it++) {
+		ThreadBuffer *buf = *it;
+		uint64_t h1 = buf->head.load (memory_order_acquire);
+		uint64_t h0 = (h1 > NEVENT ? h1-NEVENT : 0);
+		ev.clear();
+		for (uint64_t h = h0; h < h1; h++)
+			ev.push_back (buf->ev[h & (NEVENT-1)]);
+		// discard entries the owning thread overwrote (or may have been
+		// writing) while we were copying
+		uint64_t h2 = buf->head.load (memory_order_acquire) + 1;
+		size_t skip = (size_t)min<uint64_t> (h2 > h0+NEVENT ? h2-(h0+NEVENT) : 0, ev.size());
+
+		fprintf (f, "%s\n{\"ph\": \"M\", \"pid\": 1, \"tid\": %d, \"name\": \"thread_name\", \"args\": {\"name\": \"Thread %d\"}}",
+			first ? "" : ",", buf->tid, buf->tid);
+		first = false;
+		for (size_t i = skip; i < ev.size(); i++) {
+			fprintf (f, ",\n{\"ph\": \"X\", \"pid\": 1, \"tid\": %d, \"ts\": %0.3f, \"dur\": %0.3f, \"name\": ",
+				buf->tid, ev[i].t0*1e-3, ev[i].dt*1e-3);
+			WriteString (f, ev[i].name);
+			fputc ('}', f);
+		}
+	}
+	fprintf (f, "\n]}\n");
+	return fclose (f) == 0;
+}
+
+#endif // ORBITER_PROFILE
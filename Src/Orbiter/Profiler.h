@@ -0,0 +1,60 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Scoped-zone profiler
+// Records the start and end times of named code zones into per-thread
+// ring buffers and writes them in Chrome trace-event format (viewable in
+// chrome://tracing or ui.perfetto.dev).
+// The profiler is compiled out unless ORBITER_PROFILE is defined (CMake
+// option ORBITER_PROFILER). In that case the PROFILE_ZONE macros expand
+// to nothing.
+// =======================================================================
+
+#ifndef __PROFILER_H
+#define __PROFILER_H
+
+#ifdef ORBITER_PROFILE
+
+#define PROFILE_ZONE(name) Profiler::Zone _profile_zone(name)
+// Time the enclosing scope. name must be a string that remains valid
+// until the trace is written (e.g. a literal).
+
+#define PROFILE_ZONE_NAMED(prefix, name) Profiler::Zone _profile_zone(Profiler::Intern(prefix, name))
+// Time the enclosing scope under the name "<prefix> <name>", where name
+// is a transient string (e.g. a module name)
+
+namespace Profiler {
+
+	void Begin (const char *name);
+	// Open a zone on the calling thread. name must remain valid until the
+	// trace is written.
+
+	void End ();
+	// Close the innermost open zone of the calling thread
+
+	const char *Intern (const char *prefix, const char *name = 0);
+	// Returns a persistent copy of "<prefix> <name>". Repeated calls from a
+	// thread with the same strings are served from a per-thread cache
+	// without locking.
+
+	bool Dump (const char *fname);
+	// Write the events currently held in the ring buffers of all threads to
+	// fname in Chrome trace-event JSON format. Can be called from any thread.
+
+	class Zone {
+	public:
+		explicit Zone (const char *name) { Begin (name); }
+		~Zone () { End (); }
+	};
+
+}
+
+#else // !ORBITER_PROFILE
+
+#define PROFILE_ZONE(name)
+#define PROFILE_ZONE_NAMED(prefix, name)
+
+#endif // ORBITER_PROFILE
+
+#endif // !__PROFILER_H
@@ -6,7 +6,10 @@
 #include <fstream>
 #include <stdio.h>
 #include <string.h>
+#include <ctype.h>
 #include <algorithm>
+#include <chrono>
+#include <atomic>
 
 #include "Config.h"
 #include "Psys.h"
@@ -14,7 +17,12 @@
 #include "Element.h"
 #include "Vessel.h"
 #include "SuperVessel.h"
+#include "ThreadPool.h"
+#include "GravKernel.h"
+#include "GravCache.h"
 #include "Log.h"
+#include "Bench.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -24,12 +32,64 @@ extern char DBG_MSG[256];
 
 PlanetarySystem::PlanetarySystem (char *fname, const Config* config, OutputLoadStatusCallback outputLoadStatus, void* callbackContext)
 {
+	int nthread = (config->CfgCmdlinePrm.PropThreads >= 0 ?
+		config->CfgCmdlinePrm.PropThreads : config->CfgPhysicsPrm.PropThreads);
+	m_propPool = new ThreadPool (nthread); TRACENEW
+	m_gravStateId = NewGravStateId();
+	m_nBaseQueued = 0;
+	m_baseForce = true;
+	m_propThreads = m_propPool->nThread();
+	memset (&m_propStats, 0, sizeof(m_propStats));
+
 	Read (fname, config, outputLoadStatus, callbackContext);
 }
 
 PlanetarySystem::~PlanetarySystem ()
 {
+	if (m_propStats.nframe) {
+		LOGOUT("Vessel propagation: %d thread(s), %0.1f concurrent vessels/frame, %0.4f ms/frame, %0.1f%% conic coast",
+			m_propThreads, (double)m_propStats.nvessel/m_propStats.nframe, m_propStats.t*1e3/m_propStats.nframe,
+			m_propStats.nvessel ? m_propStats.nconic*100.0/m_propStats.nvessel : 0.0);
+	}
+	uint64_t nhit = 0, nmiss = 0;
+	for (auto it = celestials.begin(); it != celestials.end(); it++) {
+		uint64_t h, m;
+		(*it)->InterpolationStats (h, m);
+		nhit += h, nmiss += m;
+	}
+	if (nhit + nmiss) {
+		LOGOUT("Celestial body interpolation: %llu requests, %0.1f%% memoised",
+			(unsigned long long)(nhit+nmiss), nhit*100.0/(nhit+nmiss));
+	}
 	Clear ();
+	delete m_propPool;
+}
+
+void PlanetarySystem::PropagationStats (char *str, size_t len) const
+{
+	size_t nframe = (m_propStats.nframe ? m_propStats.nframe : 1);
+	int n = snprintf (str, len, "Prop: %d thr, %0.1f ves/frame, %0.3f ms/frame, %0.1f%% conic",
+		m_propThreads, (double)m_propStats.nvessel/nframe, m_propStats.t*1e3/nframe,
+		m_propStats.nvessel ? m_propStats.nconic*100.0/m_propStats.nvessel : 0.0);
+
+	uint64_t nhit = 0, nmiss = 0;
+	size_t ncell = 0;
+	for (auto it = celestials.begin(); it != celestials.end(); it++) {
+		const GravCache *gc = (*it)->GravFieldCache();
+		if (gc) nhit += gc->nHit(), nmiss += gc->nMiss(), ncell += gc->nCell();
+	}
+	if (nhit + nmiss && n > 0 && (size_t)n < len)
+		n += snprintf (str+n, len-n, " | Gcache: %0.1f%% interp, %zu cells",
+			nhit*100.0/(nhit+nmiss), ncell);
+
+	nhit = nmiss = 0;
+	for (auto it = celestials.begin(); it != celestials.end(); it++) {
+		uint64_t h, m;
+		(*it)->InterpolationStats (h, m);
+		nhit += h, nmiss += m;
+	}
+	if (nhit + nmiss && n > 0 && (size_t)n < len)
+		snprintf (str+n, len-n, " | Memo: %0.1f%%", nhit*100.0/(nhit+nmiss));
 }
 
 void PlanetarySystem::Clear ()
@@ -39,6 +99,10 @@ void PlanetarySystem::Clear ()
 
 	//Vessel destructor broadcasts messages to every other vessel in 'vessels'.
 	//We remove it from the collection as soon as we deleted it to prevent the next Vessel to broadcast to the free'd one.
+	m_vesselName.clear();
+	m_vesselNameLC.clear();
+	m_vesselSet.clear();
+	m_vesselIndex.Clear();
 	while (vessels.size()) {
 		DelBody(vessels.back());
 		vessels.pop_back();
@@ -54,6 +118,9 @@ void PlanetarySystem::Clear ()
 	stars     .clear();
 	planets   .clear();
 	celestials.clear();
+	StatesChanged ();
+	m_baseQueue = decltype(m_baseQueue)();
+	m_nBaseQueued = 0;
 
 	g_bForceUpdate = true;
 
@@ -118,11 +185,53 @@ Planet *PlanetarySystem::GetPlanet (const char *name, bool ignorecase)
 	return 0;
 }
 
+static std::string LowerCase (const char *str)
+{
+	std::string lc (str);
+	for (auto it = lc.begin(); it != lc.end(); it++)
+		*it = (char)tolower ((unsigned char)*it);
+	return lc;
+}
+
 Vessel *PlanetarySystem::GetVessel (const char *name, bool ignorecase) const
 {
-	for (DWORD i = 0; i < vessels.size(); i++)
-		if (!StrComp (vessels[i]->Name(), name, ignorecase)) return vessels[i];
-	return 0;
+	if (ignorecase) {
+		auto it = m_vesselNameLC.find (LowerCase (name));
+		return (it != m_vesselNameLC.end() ? it->second : 0);
+	} else {
+		auto it = m_vesselName.find (name);
+		return (it != m_vesselName.end() ? it->second : 0);
+	}
+}
+
+void PlanetarySystem::IndexVessel (Vessel *v)
+{
+	// emplace keeps an existing entry, so duplicate names resolve to the
+	// first vessel, as with a linear search
+	m_vesselName.emplace (v->Name(), v);
+	m_vesselNameLC.emplace (LowerCase (v->Name()), v);
+	m_vesselSet.insert (v);
+}
+
+void PlanetarySystem::UnindexVessel (Vessel *v)
+{
+	// if another vessel shares the name, it takes over the table entry
+	auto successor = [this,v](bool ignorecase) -> Vessel* {
+		for (auto it = vessels.begin(); it != vessels.end(); it++)
+			if (*it != v && !StrComp ((*it)->Name(), v->Name(), ignorecase)) return *it;
+		return 0;
+	};
+	auto it = m_vesselName.find (v->Name());
+	if (it != m_vesselName.end() && it->second == v) {
+		if (Vessel *w = successor (false)) it->second = w;
+		else m_vesselName.erase (it);
+	}
+	auto itlc = m_vesselNameLC.find (LowerCase (v->Name()));
+	if (itlc != m_vesselNameLC.end() && itlc->second == v) {
+		if (Vessel *w = successor (true)) itlc->second = w;
+		else m_vesselNameLC.erase (itlc);
+	}
+	m_vesselSet.erase (v);
 }
 
 bool PlanetarySystem::isObject (const Body *obj) const
@@ -134,9 +243,7 @@ bool PlanetarySystem::isObject (const Body *obj) const
 
 bool PlanetarySystem::isVessel (const Vessel *v) const
 {
-	for (DWORD i = 0; i < vessels.size(); i++)
-		if (vessels[i] == v) return true;
-	return false;
+	return m_vesselSet.count (v) > 0;
 }
 
 Base *PlanetarySystem::GetBase (const Planet *planet, const char *name, bool ignorecase)
@@ -386,12 +493,15 @@ void PlanetarySystem::AddGrav (CelestialBody *newBody)
 	//And this is just so much more readable.
 	celestials.emplace_back(newBody);
 	std::sort(celestials.begin(), celestials.end(), [](CelestialBody* a, CelestialBody* b) { return a->Mass() > b->Mass(); });
+	StatesChanged ();
 }
 
 size_t PlanetarySystem::AddVessel (Vessel *_vessel)
 {
 	vessels.emplace_back(_vessel);
 	AddBody (_vessel); // register in general list
+	IndexVessel (_vessel);
+	m_vesselIndex.Invalidate();
 	g_bForceUpdate = true;
 	return vessels.size();
 }
@@ -407,9 +517,11 @@ bool PlanetarySystem::DelVessel (Vessel *_vessel)
 	if (i == vessels.size())
 		return false; // vessels not found in list
 
+	UnindexVessel (_vessel);
 	DelBody (_vessel); //DelBody takes care of freeing the vessel
 	std::iter_swap(vessels.begin() + i, vessels.end() - 1);
 	vessels.pop_back();
+	m_vesselIndex.Invalidate();
 
 	g_bForceUpdate = true;
 	return true;
@@ -596,11 +708,11 @@ Vector SingleGacc_perturbation (const Vector &rpos, const CelestialBody *body)
 
 		unsigned int maxDegreeOrder = body->GetPinesCutoff();
 		//get aceleration vector from spherical harmonics
-		{
-			//Limit scope of the const cast. the internal state of body.PinesGravProp does need to change when this finction is called.
-			CelestialBody* unconstbody = const_cast<CelestialBody*>(body);
-			dg = unconstbody->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
-		}
+		GravCache *gcache = body->GravFieldCache();
+		if (gcache)
+			dg = gcache->Eval(lpos, maxDegreeOrder);
+		else
+			dg = body->pinesAccel(lpos, maxDegreeOrder, maxDegreeOrder);
 
 		//Convert back to Orbiter's lefthandedness
 		temp_y = dg.y;
@@ -673,93 +785,126 @@ Vector SingleGacc (const Vector &rpos, const CelestialBody *body)
 	return rpos * (Ggrav * body->Mass() / (d*d*d)) + SingleGacc_perturbation (rpos, body);
 }
 
-Vector PlanetarySystem::Gacc (const Vector &gpos, const Body *exclude, const GFieldData *gfd) const
+// -----------------------------------------------------------------------
+// Per-thread snapshots of celestial body positions and gravitational
+// parameters at fractional steps of the current time step, in structure of
+// arrays layout for the batched gravity kernel. Entries are filled on demand,
+// so each body position is interpolated at most once per thread and stage
+// (e.g. a Runge-Kutta stage shared by all vessels using the same propagator).
+
+struct GravSnapshot {
+	const PlanetarySystem *psys; // owner
+	DWORD stateid;               // owner state counter at snapshot creation
+	double n;                    // fractional step
+	DWORD gen;                   // slot generation counter
+	std::vector<DWORD> stamp;    // entry i is valid if stamp[i] == gen
+	std::vector<double> x, y, z, gm;
+};
+
+static const int NGRAVSNAPSHOT = 16;
+static thread_local GravSnapshot g_gravSnapshot[NGRAVSNAPSHOT];
+static thread_local int g_gravSnapshotNext = 0;
+static thread_local std::vector<int> g_gravIdx;
+
+DWORD PlanetarySystem::NewGravStateId ()
 {
-	Vector acc;
-	DWORD i, j;
+	static std::atomic<DWORD> s_nextId(1);
+	return s_nextId++;
+}
 
-	if (gfd) {
-		for (j = 0; j < gfd->ngrav; j++) {
-			i = gfd->gravidx[j];
-			if (exclude == celestials[i]) continue;
-			acc += SingleGacc (celestials[i]->s0->pos - gpos, celestials[i]);
-		}
-	} else {
-		for (i = 0; i < celestials.size(); i++) {
-			if (exclude == celestials[i]) continue;
-			acc += SingleGacc (celestials[i]->s0->pos - gpos, celestials[i]);
-		}
+static GravSnapshot *GetGravSnapshot (const PlanetarySystem *psys, DWORD stateid, double n, size_t nbody)
+{
+	int i;
+	for (i = 0; i < NGRAVSNAPSHOT; i++) {
+		GravSnapshot &snap = g_gravSnapshot[i];
+		if (snap.n == n && snap.stateid == stateid && snap.psys == psys)
+			return &snap;
 	}
-	return acc;
+	// not found: recycle the oldest slot
+	GravSnapshot &snap = g_gravSnapshot[g_gravSnapshotNext];
+	g_gravSnapshotNext = (g_gravSnapshotNext+1) % NGRAVSNAPSHOT;
+	snap.psys = psys;
+	snap.stateid = stateid;
+	snap.n = n;
+	snap.gen++;
+	if (snap.stamp.size() < nbody) {
+		snap.stamp.resize (nbody, 0);
+		snap.x.resize (nbody);
+		snap.y.resize (nbody);
+		snap.z.resize (nbody);
+		snap.gm.resize (nbody);
+	}
+	return &snap;
 }
 
-Vector PlanetarySystem::Gacc_intermediate (const Vector &gpos, double n, const Body *exclude, GFieldData *gfd) const
+Vector PlanetarySystem::GaccPointSources (const Vector &gpos, double n, const Body *exclude, const CelestialBody *skip, const GFieldData *gfd) const
 {
-	Vector acc;
-	DWORD i, j;
-	
-	if (gfd) { // use body's source list
-		for (j = 0; j < gfd->ngrav; j++) {
-			i = gfd->gravidx[j];
-			if (exclude == celestials[i]) continue;
-			acc += SingleGacc (celestials[i]->InterpolatePosition (n) - gpos, celestials[i]);
-		}
-	} else { // use full gbody list
-		for (i = 0; i < celestials.size(); i++) {
-			if (exclude == celestials[i]) continue;
-			acc += SingleGacc (celestials[i]->InterpolatePosition (n) - gpos, celestials[i]);
+	GravSnapshot *snap = GetGravSnapshot (this, m_gravStateId, n, celestials.size());
+	DWORD i, j, nsrc = (gfd ? gfd->ngrav : (DWORD)celestials.size());
+	int nidx = 0;
+
+	if (g_gravIdx.size() < nsrc) g_gravIdx.resize (nsrc);
+	int *idx = g_gravIdx.data();
+
+	for (j = 0; j < nsrc; j++) {
+		i = (gfd ? gfd->gravidx[j] : j);
+		const CelestialBody *cb = celestials[i];
+		if (cb == exclude || cb == skip) continue;
+		if (snap->stamp[i] != snap->gen) {
+			Vector p (cb->InterpolatePosition (n));
+			snap->x[i] = p.x, snap->y[i] = p.y, snap->z[i] = p.z;
+			snap->gm[i] = Ggrav * cb->Mass();
+			snap->stamp[i] = snap->gen;
 		}
+		idx[nidx++] = (int)i;
+	}
+
+	GravSourceArray src = { snap->x.data(), snap->y.data(), snap->z.data(), snap->gm.data() };
+	Vector acc (GaccPointMass (src, idx, nidx, gpos));
+
+	// nonspherical terms, only for the sources that have them
+	for (j = 0; j < (DWORD)nidx; j++) {
+		const CelestialBody *cb = celestials[i = idx[j]];
+		if (cb->UseComplexGravity() && (cb->usePines() || cb->nJcoeff() > 0))
+			acc += SingleGacc_perturbation (Vector (snap->x[i], snap->y[i], snap->z[i]) - gpos, cb);
 	}
 	return acc;
 }
 
+Vector PlanetarySystem::Gacc (const Vector &gpos, const Body *exclude, const GFieldData *gfd) const
+{
+	return GaccPointSources (gpos, 0.0, exclude, 0, gfd);
+}
+
+Vector PlanetarySystem::Gacc_intermediate (const Vector &gpos, double n, const Body *exclude, GFieldData *gfd) const
+{
+	return GaccPointSources (gpos, n, exclude, 0, gfd);
+}
+
 Vector PlanetarySystem::Gacc_intermediate_pert (const CelestialBody *cbody, const Vector &relpos, double n, const Body *exclude, GFieldData *gfd) const
 {
-	Vector acc;
-	DWORD i, j;
+	// the central body only contributes its nonspherical perturbation
 	Vector gpos = relpos + cbody->InterpolatePosition (n);
-
-	if (gfd) { // use body's source list
-		for (j = 0; j < gfd->ngrav; j++) {
-			i = gfd->gravidx[j];
-			if (exclude == celestials[i]) continue;
-			if (cbody == celestials[i])
-				acc += SingleGacc_perturbation (-relpos, celestials[i]);
-			else
-				acc += SingleGacc (celestials[i]->InterpolatePosition (n) - gpos, celestials[i]);
-		}
-	} else { // use full gbody list
-		for (i = 0; i < celestials.size(); i++) {
-			if (exclude == celestials[i]) continue;
-			if (cbody == celestials[i])
-				acc += SingleGacc_perturbation (-relpos, celestials[i]);
-			else
-				acc += SingleGacc (celestials[i]->InterpolatePosition (n) - gpos, celestials[i]);
+	Vector acc (GaccPointSources (gpos, n, exclude, cbody, gfd));
+
+	if (cbody != exclude) {
+		bool inlist = true;
+		if (gfd) {
+			DWORD j;
+			for (j = 0; j < gfd->ngrav; j++)
+				if (celestials[gfd->gravidx[j]] == cbody) break;
+			inlist = (j < gfd->ngrav);
 		}
+		if (inlist)
+			acc += SingleGacc_perturbation (-relpos, cbody);
 	}
 	return acc;
 }
 
 Vector PlanetarySystem::GaccRel (const Vector &rpos, const CelestialBody *cbody, double n, const Body *exclude, GFieldData *gfd) const
 {
-	Vector acc;
-	DWORD i, j;
-
 	Vector gpos (rpos + cbody->InterpolatePosition (n));
-
-	if (gfd) { // use bodies's source list
-		for (j = 0; j < gfd->ngrav; j++) {
-			i = gfd->gravidx[j];
-			if (exclude == celestials[i]) continue;
-			acc += SingleGacc (celestials[i]->InterpolatePosition (n) - gpos, celestials[i]);
-		}
-	} else { // use full gbody list
-		for (i = 0; i < celestials.size(); i++) {
-			if (exclude == celestials[i]) continue;
-			acc += SingleGacc (celestials[i]->InterpolatePosition (n) - gpos, celestials[i]);
-		}
-	}
-	return acc;
+	return GaccPointSources (gpos, n, exclude, 0, gfd);
 }
 
 Vector PlanetarySystem::GaccPn_perturbation (const Vector &gpos, double n, const CelestialBody *cbody) const
@@ -813,24 +958,132 @@ Vector PlanetarySystem::GetMomentumFlux (const Vector &gpos) const
 
 void PlanetarySystem::Update (bool force)
 {
+	PROFILE_ZONE("PlanetarySystem::Update");
 	DWORD i;
+	if (g_bench) g_bench->Begin (FrameBench::PH_CELESTIAL);
 	for (i = 0; i < bodies      .size(); i++) bodies      [i]->BeginStateUpdate ();
 	for (i = 0; i < stars       .size(); i++) stars       [i]->RelTrueAndBaryState();
 	for (i = 0; i < stars       .size(); i++) stars       [i]->AbsTrueState();
-	for (i = 0; i < celestials  .size(); i++) celestials  [i]->Update (force);
+	StatesChanged ();
+	for (i = 0; i < celestials  .size(); i++) {
+		celestials[i]->Update (force);
+		StatesChanged (); // s1 changed: discard gravity snapshots
+	}
+	if (force) m_baseForce = true;
+	if (g_bench) g_bench->Begin (FrameBench::PH_FORCES);
 	for (i = 0; i < vessels     .size(); i++) vessels     [i]->UpdateBodyForces ();
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->Update (force);
-	for (i = 0; i < vessels     .size(); i++) vessels     [i]->Update (force);
+	if (g_bench) g_bench->Begin (FrameBench::PH_PROPAGATION);
+	PropagateVessels (force);
+	if (g_bench) {
+		for (i = 0; i < vessels.size(); i++) {
+			auto t0 = std::chrono::steady_clock::now();
+			vessels[i]->Update (force);
+			g_bench->AddVessel (vessels[i]->Name(), std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+		}
+		g_bench->End ();
+	} else {
+		for (i = 0; i < vessels     .size(); i++) vessels     [i]->Update (force);
+	}
+}
+
+void PlanetarySystem::PropagateVessels (bool force)
+{
+	auto t0 = std::chrono::steady_clock::now();
+
+	m_propList.clear();
+	for (auto it = vessels.begin(); it != vessels.end(); it++) {
+		Vessel *v = *it;
+		if (!v->CanPropagateConcurrent()) continue;
+		v->RefreshGFieldSources (force);
+		m_propList.push_back (v);
+	}
+
+	if (g_bench) {
+		// per-vessel timing for the benchmark report
+		m_propTime.resize (m_propList.size());
+		m_propPool->ParallelFor (m_propList.size(), [&](size_t i) {
+			auto t1 = std::chrono::steady_clock::now();
+			m_propList[i]->PropagateConcurrent (force);
+			m_propTime[i] = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+		});
+		for (size_t i = 0; i < m_propList.size(); i++)
+			g_bench->AddVessel (m_propList[i]->Name(), m_propTime[i]);
+	} else {
+		m_propPool->ParallelFor (m_propList.size(), [&](size_t i) {
+			m_propList[i]->PropagateConcurrent (force);
+		});
+	}
+
+	m_propStats.nframe++;
+	m_propStats.nvessel += m_propList.size();
+	for (auto it = m_propList.begin(); it != m_propList.end(); it++)
+		if ((*it)->isConicCoast()) m_propStats.nconic++;
+	m_propStats.t += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
 }
 
 void PlanetarySystem::FinaliseUpdate ()
 {
 	DWORD i;
 	for (i = 0; i < bodies.size(); i++) bodies[i]->EndStateUpdate ();
+	StatesChanged ();
+	UpdateBases (m_baseForce);
+	m_baseForce = false;
+	BuildVesselIndex ();
 	for (i = 0; i < supervessels.size(); i++) supervessels[i]->PostUpdate ();
 	for (i = 0; i < vessels.size(); i++) vessels[i]->PostUpdate ();
 }
 
+void PlanetarySystem::UpdateBases (bool force)
+{
+	PROFILE_ZONE("UpdateBases");
+	size_t nbase = 0;
+	for (auto it = planets.begin(); it != planets.end(); it++)
+		nbase += (*it)->nBase();
+
+	if (force || nbase != m_nBaseQueued) {
+		// (re)build the queue, refreshing all bases
+		m_baseQueue = decltype(m_baseQueue)();
+		for (auto it = planets.begin(); it != planets.end(); it++)
+			for (DWORD i = 0; i < (*it)->nBase(); i++) {
+				Base *base = (*it)->GetBase(i);
+				m_baseQueue.push (BaseEvent(base->UpdateSunDirection(), base));
+			}
+		m_nBaseQueued = nbase;
+		return;
+	}
+
+	// only bases whose refresh time has passed are touched
+	while (!m_baseQueue.empty() && m_baseQueue.top().first < td.SimT1) {
+		Base *base = m_baseQueue.top().second;
+		m_baseQueue.pop();
+		m_baseQueue.push (BaseEvent(base->UpdateSunDirection(), base));
+	}
+}
+
+void PlanetarySystem::BuildVesselIndex ()
+{
+	PROFILE_ZONE("VesselIndex");
+	m_vesselIndex.Clear();
+	for (auto it = vessels.begin(); it != vessels.end(); it++) {
+		Vessel *v = *it;
+		const CelestialBody *ref = v->ProxyBody();
+		m_vesselIndex.Add (v, ref, ref ? ref->GPos() : Vector(0,0,0), v->GPos(), v->Size());
+	}
+	m_vesselIndex.Finalise();
+}
+
+size_t PlanetarySystem::VesselsInRange (const Vector &gpos, double r, std::vector<Vessel*> &list, const Vessel *exclude)
+{
+	return VesselIndexUpdated().InRange (gpos, r, list, exclude);
+}
+
+size_t PlanetarySystem::NearestVessels (const Vector &gpos, size_t k, std::vector<Vessel*> &list, const Vessel *exclude,
+	std::vector<double> *dist)
+{
+	return VesselIndexUpdated().Nearest (gpos, k, list, exclude, dist);
+}
+
 void PlanetarySystem::Timejump (const TimeJumpData& jump)
 {
 	DWORD i;
@@ -839,9 +1092,12 @@ void PlanetarySystem::Timejump (const TimeJumpData& jump)
 	for (i = 0; i < stars.size(); i++) stars[i]->AbsTrueState();
 	for (i = 0; i < celestials.size(); i++) celestials[i]->Update (true);
 	for (i = 0; i < bodies.size(); i++) bodies[i]->EndStateUpdate ();
+	StatesChanged ();
+	UpdateBases (true);
 
 	for (i = 0; i < vessels.size(); i++)
 		vessels[i]->Timejump(jump.dt, jump.mode);
+	m_vesselIndex.Invalidate();
 }
 
 void PlanetarySystem::InitDeviceObjects ()
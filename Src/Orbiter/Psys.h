@@ -9,10 +9,16 @@
 #include "Base.h"
 #include "Star.h"
 #include "Planet.h"
+#include "VesselIndex.h"
 #include <functional>
+#include <queue>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 class Vessel;
 class SuperVessel;
+class ThreadPool;
 struct TimeJumpData;
 
 Vector SingleGacc (const Vector &rpos, const CelestialBody *body);
@@ -65,7 +71,23 @@ public:
 	Vessel *GetVessel (const char *name, bool ignorecase = false) const;
 	inline Vessel *GetVessel (DWORD i) const { return vessels[i]; }
 	inline std::vector<Vessel *> &GetVessels() { return vessels; }
-	// Return pointer to vessel by name or index, or 0 if not present
+	// Return pointer to vessel by name or index, or 0 if not present.
+	// Name lookups are hashed; if several vessels share a name, the one
+	// registered first is returned.
+
+	size_t VesselsInRange (const Vector &gpos, double r, std::vector<Vessel*> &list, const Vessel *exclude = 0);
+	// Append all vessels within distance r of global position gpos to list.
+	// Returns the number of vessels appended.
+
+	size_t NearestVessels (const Vector &gpos, size_t k, std::vector<Vessel*> &list, const Vessel *exclude = 0,
+		std::vector<double> *dist = 0);
+	// Append the (up to) k vessels closest to gpos to list, sorted by
+	// distance, and optionally their distances to dist.
+	// Both queries use the vessel positions at the end of the last
+	// completed time step (see VesselIndex).
+
+	inline double MaxVesselSize () { return VesselIndexUpdated().MaxSize(); }
+	// Largest radius of any vessel in the system
 
 	bool isObject (const Body *obj) const;
 	// returns true if obj is a registered object
@@ -124,6 +146,9 @@ public:
 	void Update (bool force = false);
 	// Perform time step for the planetary system
 
+	inline int nPropThread () const { return m_propThreads; }
+	// Number of threads used for concurrent vessel propagation
+
 	void FinaliseUpdate ();
 
 	void Timejump (const TimeJumpData& jump);
@@ -200,6 +225,12 @@ public:
 
 	void ActivatePlanetLabels(bool activate);
 
+	void PropagationStats (char *str, size_t len) const;
+	// One-line summary of the vessel propagation statistics accumulated since
+	// session start (threads, concurrent vessels and time per frame, conic
+	// coast fraction, gravity cache and interpolation memo hit rates), for the
+	// debug string
+
 	void ForEach(int type, std::function<void(const fs::directory_entry&)> callback) {
 		std::error_code ec;
 		for (const auto& entry : fs::directory_iterator(m_labelPath, ec)) {
@@ -226,13 +257,77 @@ private:
 	std::vector<SuperVessel*> supervessels;
 	// List of spacecraft groups (composite vessels)
 
+	std::unordered_map<std::string, Vessel*> m_vesselName;   ///< vessels by name
+	std::unordered_map<std::string, Vessel*> m_vesselNameLC; ///< vessels by lower-case name
+	std::unordered_set<const Vessel*> m_vesselSet;           ///< registered vessels
+	VesselIndex m_vesselIndex; ///< spatial index of vessel positions, rebuilt in FinaliseUpdate
+
 	std::vector< oapi::GraphicsClient::LABELLIST> m_labelList; ///< list of celestial markers
 	//oapi::GraphicsClient::LABELLIST *labellist;
 	//int nlabellist;
 	std::string m_labelPath; ///< directory containing celestial marker lists for this planetary system
 
+	ThreadPool *m_propPool;   ///< worker threads for concurrent vessel propagation
+	int m_propThreads;        ///< number of threads used for vessel propagation
+	std::vector<Vessel*> m_propList; ///< vessels propagated concurrently in the current step
+	std::vector<double> m_propTime;  ///< propagation times of m_propList entries in benchmark mode [s]
+	struct {
+		size_t nframe;        ///< number of frames with a propagation phase
+		size_t nvessel;       ///< accumulated number of concurrently propagated vessels
+		size_t nconic;        ///< accumulated number of those propagated as conic coast
+		double t;             ///< accumulated wall time of the propagation phase [s]
+	} m_propStats;
+
+	DWORD m_gravStateId;      ///< changes whenever celestial body states change; invalidates gravity snapshots
+
+	static DWORD NewGravStateId ();
+	// Returns a gravity state id that is unique across all planetary system
+	// instances, so that a snapshot can't be matched by a later system
+	// allocated at the address of a deleted one.
+
+	typedef std::pair<double,Base*> BaseEvent; ///< time of next sun direction refresh, base
+	std::priority_queue<BaseEvent, std::vector<BaseEvent>, std::greater<BaseEvent> > m_baseQueue; ///< bases ordered by next refresh time
+	size_t m_nBaseQueued;     ///< number of bases in m_baseQueue
+	bool m_baseForce;         ///< refresh all bases at the end of the current update
+
+	inline void StatesChanged () { m_gravStateId = NewGravStateId(); CelestialBody::InvalidateInterpolation(); }
+	// Invalidate gravity snapshots and memoised intermediate celestial body
+	// positions. Must be called whenever s0 or s1 of a celestial body changes.
+
+	void IndexVessel (Vessel *v);
+	void UnindexVessel (Vessel *v);
+	// Add/remove a vessel to/from the name tables
+
+	void BuildVesselIndex ();
+	// Rebuild the spatial vessel index from the current vessel states
+
+	inline const VesselIndex &VesselIndexUpdated ()
+	{ if (!m_vesselIndex.Valid()) BuildVesselIndex(); return m_vesselIndex; }
+	// Returns the spatial index, rebuilding it first if vessels were added
+	// or removed since the last update
+
 	void OutputLoadStatus(const char* bname, OutputLoadStatusCallback outputLoadStatus, void* callbackContext);
 
+	void UpdateBases (bool force);
+	// Refresh the buffered sun directions of the surface bases that are due.
+	// Base state vectors are not updated here: they follow their planet on
+	// demand (see Base::SyncState). force: refresh all bases
+
+	void PropagateVessels (bool force);
+	// Concurrent dynamic state propagation of all vessels that don't interact
+	// with other objects during the current step. Gravity source lists are
+	// refreshed on the calling thread in list order beforehand, so results are
+	// identical for any number of threads. Module callbacks, docking and
+	// surface contact remain on the main thread (in Vessel::Update).
+
+	Vector GaccPointSources (const Vector &gpos, double n, const Body *exclude, const CelestialBody *skip, const GFieldData *gfd) const;
+	// Acceleration at global position gpos at fractional step n from all
+	// sources in gfd (or all celestial bodies if gfd == 0) except 'exclude',
+	// including nonspherical perturbations. Source 'skip' is omitted from the
+	// sum as well; it is used by callers that treat the central body separately.
+	// Source positions are taken from a per-thread snapshot of the current step,
+	// and the point-mass terms are summed by the batched (SIMD) gravity kernel.
+
 	void AddBody (Body *_body);
 	// Add "body" to the system's general list of objects
 
@@ -0,0 +1,120 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Embedded Runge-Kutta pairs and step size control for the adaptive
+// propagators
+// =======================================================================
+
+#include <math.h>
+#include <algorithm>
+#include "RKAdaptive.h"
+
+// ---------------------------------------------------------------------------
+// RK8 13-stage parameters
+// ---------------------------------------------------------------------------
+
+static const int RK8_n = 13;
+static const double RK8_alpha[RK8_n-1] = {
+	2.0/27.0, 1.0/9.0, 1.0/6.0, 5.0/12.0, 1.0/2.0, 5.0/6.0, 1.0/6.0, 2.0/3.0, 1.0/3.0, 1.0, 0, 1.0
+};
+static const double RK8_beta[(RK8_n-1)*(RK8_n-1)] = {
+	2.0/27.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/36.0, 1.0/12.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/24.0, 0, 1.0/8.0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	5.0/12.0, 0, -25.0/16.0, 25.0/16.0, 0, 0, 0, 0, 0, 0, 0, 0,
+	1.0/20.0, 0, 0, 1.0/4.0, 1.0/5.0, 0, 0, 0, 0, 0, 0, 0,
+	-25.0/108.0, 0, 0, 125.0/108.0, -65.0/27.0, 125.0/54.0, 0, 0, 0, 0, 0, 0,
+	31.0/300.0, 0, 0, 0, 61.0/225.0, -2.0/9.0, 13.0/900.0, 0, 0, 0, 0, 0,
+	2.0, 0, 0, -53.0/6.0, 704.0/45.0, -107.0/9.0, 67.0/90.0, 3.0, 0, 0, 0, 0,
+	-91.0/108.0, 0, 0, 23.0/108.0, -976.0/135.0, 311.0/54.0, -19.0/60.0, 17.0/6.0, -1.0/12.0, 0, 0, 0,
+	2383.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -301.0/82.0, 2133.0/4100.0, 45.0/82.0, 45.0/164.0, 18.0/41.0, 0, 0,
+	3.0/205.0, 0, 0, 0, 0, -6.0/41.0, -3.0/205.0, -3.0/41.0, 3.0/41.0, 6.0/41.0, 0, 0,
+	-1777.0/4100.0, 0, 0, -341.0/164.0, 4496.0/1025.0, -289.0/82.0, 2193.0/4100.0, 51.0/82.0, 33.0/164.0, 12.0/41.0, 0, 1.0
+};
+static const double RK8_gamma[RK8_n] = {
+	0, 0, 0, 0, 0, 34.0/105.0, 9.0/35.0, 9.0/35.0, 9.0/280.0, 9.0/280.0, 0, 41.0/840.0, 41.0/840.0
+};
+
+// ---------------------------------------------------------------------------
+// Dormand-Prince 5(4) 7-stage parameters (adaptive)
+// Stages 1-6 and the 5th order weights are those of RK5. The 7th stage is
+// evaluated at the new state (FSAL) and is only needed for the embedded
+// 4th order solution.
+// ---------------------------------------------------------------------------
+
+static const int DP5_n = 7;
+static const double DP5_alpha[DP5_n-1] = {
+	1.0/5.0, 3.0/10.0, 4.0/5.0, 8.0/9.0, 1.0, 1.0
+};
+static const double DP5_beta[(DP5_n-1)*(DP5_n-1)] = {
+	1.0/5.0, 0, 0, 0, 0, 0,
+	3.0/40.0, 9.0/40.0, 0, 0, 0, 0,
+	44.0/45.0, -56.0/15.0, 32.0/9.0, 0, 0, 0,
+	19372.0/6561.0, -25360.0/2187.0, 64448.0/6561.0, -212.0/729.0, 0, 0,
+	9017.0/3168.0, -355.0/33.0, 46732.0/5247.0, 49.0/176.0, -5103.0/18656.0, 0,
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0
+};
+static const double DP5_gamma[DP5_n] = {
+	35.0/384.0, 0, 500.0/1113.0, 125.0/192.0, -2187.0/6784.0, 11.0/84.0, 0
+};
+static const double DP5_err[DP5_n] = { // 5th minus 4th order weights
+	35.0/384.0-5179.0/57600.0, 0, 500.0/1113.0-7571.0/16695.0, 125.0/192.0-393.0/640.0,
+	-2187.0/6784.0+92097.0/339200.0, 11.0/84.0-187.0/2100.0, -1.0/40.0
+};
+
+// ---------------------------------------------------------------------------
+// Runge-Kutta-Fehlberg 7(8) parameters (adaptive)
+// Uses the RK8 stages and weights; the error estimate is the difference
+// between the 8th order and the embedded 7th order (RK7) solution.
+// ---------------------------------------------------------------------------
+
+static const double RK78_err[RK8_n] = {
+	-41.0/840.0, 0, 0, 0, 0, 0, 0, 0, 0, 0, -41.0/840.0, 41.0/840.0, 41.0/840.0
+};
+
+const RKPair RK_DP54  = { DP5_n, DP5_alpha, DP5_beta, DP5_gamma, DP5_err, 5, true };
+const RKPair RK_RKF78 = { RK8_n, RK8_alpha, RK8_beta, RK8_gamma, RK78_err, 8, false };
+
+// ===========================================================================
+// class RKStepControl
+// ===========================================================================
+
+RKStepControl::RKStepControl (const RKPair &rk, double _h, double hinit, int _maxstep)
+{
+	expo = -1.0/rk.order;
+	h = _h;
+	t = 0.0;
+	hs = (hinit > 0.0 ? hinit : h);
+	hh = 0.0;
+	last = false;
+	maxstep = _maxstep;
+	naccept = nreject = 0;
+}
+
+// ---------------------------------------------------------------------------
+
+double RKStepControl::Step (double hmax)
+{
+	if (hs > hmax) hs = hmax;
+	last = (hs >= h-t);
+	hh = (last ? h-t : hs);
+	return hh;
+}
+
+// ---------------------------------------------------------------------------
+
+bool RKStepControl::Update (double err)
+{
+	double scale = (err > 1e-20 ? 0.9*pow (err, expo) : 5.0);
+	double hnext = hh * std::max (0.2, std::min (5.0, scale));
+	if (err > 1.0 && naccept+nreject < maxstep) { // reject step
+		hs = hnext;
+		nreject++;
+		return false;
+	}
+	t = (last ? h : t+hh);
+	if (!last || hnext < hs) hs = hnext; // don't let a truncated final step grow the step size
+	naccept++;
+	return true;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Embedded Runge-Kutta pairs and step size control for the adaptive
+// propagators (RigidBody::DP5_LinAng, RigidBody::RK78_LinAng)
+// An interval is covered by internal steps whose length follows the
+// error estimate of the embedded pair. The stage evaluation is left to
+// the caller, so the same control applies to any state representation.
+// =======================================================================
+
+#ifndef __RKADAPTIVE_H
+#define __RKADAPTIVE_H
+
+struct RKPair {
+	int n;                 // number of stages
+	const double *alpha;   // stage times, as fractions of the step (n-1)
+	const double *beta;    // stage coefficients ((n-1)x(n-1), row i-1 for stage i)
+	const double *gamma;   // weights of the propagated solution (n)
+	const double *gerr;    // weights of the error estimate (n)
+	int order;             // order of the error estimate + 1
+	bool fsal;             // last stage is evaluated at the new state
+};
+
+const int RK_MAXSTAGE = 13;  // max. number of stages of any pair
+
+extern const RKPair RK_DP54;
+// Dormand-Prince 5(4), 7 stages. Propagates the 5th order solution.
+
+extern const RKPair RK_RKF78;
+// Runge-Kutta-Fehlberg 7(8), 13 stages. Propagates the 8th order
+// solution. Its stages and 8th order weights are also used by the
+// fixed-step RK8 propagators.
+
+class RKStepControl {
+public:
+	RKStepControl (const RKPair &rk, double h, double hinit, int maxstep = 10000);
+	// rk: embedded pair
+	// h: interval to be covered [s]
+	// hinit: initial internal step (e.g. from the previous interval; 0 = h)
+	// maxstep: max. number of steps (accepted and rejected). After this,
+	//    steps are accepted regardless of their error.
+
+	inline bool Done () const { return t >= h; }
+	// Interval completely covered?
+
+	inline double Time () const { return t; }
+	// Start of the current step, relative to the start of the interval [s]
+
+	double Step (double hmax = 1e20);
+	// Length of the next step, limited by hmax and truncated at the end of
+	// the interval
+
+	bool Update (double err);
+	// Step size control after evaluating the step returned by Step.
+	// err: error estimate of the step, relative to the tolerance
+	// Returns true if the step is accepted (the caller then applies it),
+	// or false if it must be repeated with a smaller step
+
+	inline double NextStep () const { return hs; }
+	// Internal step to be carried over to the next interval [s]
+
+	inline int nAccepted () const { return naccept; }
+	inline int nRejected () const { return nreject; }
+
+private:
+	double expo;           // step scaling exponent: -1/order
+	double h;              // interval length
+	double t;              // covered part of the interval
+	double hs;             // current internal step size
+	double hh;             // length of the current step
+	bool last;             // current step ends the interval
+	int maxstep;
+	int naccept, nreject;
+};
+
+#endif // !__RKADAPTIVE_H
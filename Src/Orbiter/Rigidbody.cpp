@@ -20,6 +20,7 @@
 #include "Element.h"
 #include "Astro.h"
 #include "Log.h"
+#include "Profiler.h"
 
 using namespace std;
 
@@ -34,6 +35,7 @@ extern char DBG_MSG[256];
 bool       RigidBody::bDistmass = false;
 bool       RigidBody::bGPerturb = false;
 int        RigidBody::nPropLevel = 1;
+double     RigidBody::PropAdaptTol = 1e-10;
 RigidBody::PROPMODE RigidBody::PropMode[MAX_PROP_LEVEL] = {&RigidBody::RK2_LinAng, 0, 0.0, 0.0, 0.0, 0.0};
 
 const double gfielddata_updt_interval = 60.0;
@@ -87,6 +89,7 @@ void RigidBody::SetDefaultCaps ()
 	bDistmass = g_pOrbiter->Cfg()->CfgPhysicsPrm.bDistributedMass;
 	bGPerturb = g_pOrbiter->Cfg()->CfgPhysicsPrm.bNonsphericalGrav;
 	bOrbitStabilised = false;
+	bConicCoast = false;
 	bIgnoreGravTorque = false;
 	tidaldamp = 0.0;
 	PropLevel = 0;
@@ -94,6 +97,8 @@ void RigidBody::SetDefaultCaps ()
 	nPropSubsteps = 1;
 	gfielddata.ngrav = 0;
 	gfielddata.updt = -1e10; // invalidate
+	bGFieldRefreshed = false;
+	adaptStep = 0.0;
 }
 
 void RigidBody::ReadGenericCaps (ifstream &ifs)
@@ -153,11 +158,14 @@ void RigidBody::SetupPropagationModes ()
 		case PROP_SY4:  PropMode[i].propagator = &RigidBody::SY4_LinAng;  break;
 		case PROP_SY6:  PropMode[i].propagator = &RigidBody::SY6_LinAng;  break;
 		case PROP_SY8:  PropMode[i].propagator = &RigidBody::SY8_LinAng;  break;
+		case PROP_DP5:  PropMode[i].propagator = &RigidBody::DP5_LinAng;  break;
+		case PROP_RK78: PropMode[i].propagator = &RigidBody::RK78_LinAng; break;
 		default:        PropMode[i].propagator = &RigidBody::RK4_LinAng;  break;
 		}
 	}
 	PropMode[nPropLevel-1].tlim = 1e20;
 	PropMode[nPropLevel-1].alim = 1e20;
+	PropAdaptTol = g_pOrbiter->Cfg()->CfgPhysicsPrm.PropAdaptTol;
 }
 
 // =======================================================================
@@ -174,13 +182,18 @@ void RigidBody::SetPropagator (int &plevel, int &nstep) const
 		if (astep < PropMode[plevel].alim)
 			break;
 
-	nstep = min (PropSubMax, (int)ceil (max (td.SimDT / PropMode[plevel].ttgt, astep / PropMode[plevel].atgt)));
+	if (PropMode[plevel].propidx == PROP_DP5 || PropMode[plevel].propidx == PROP_RK78)
+		nstep = 1; // adaptive propagators choose their own internal steps
+	else
+		nstep = min (PropSubMax, (int)ceil (max (td.SimDT / PropMode[plevel].ttgt, astep / PropMode[plevel].atgt)));
 }
 
 // =======================================================================
 
 void RigidBody::Update (bool force)
 {
+	PROFILE_ZONE("RigidBody::Update");
+
 	if (bDynamicPosVel) {
 
 		// Update velocity and position according to
@@ -202,17 +215,17 @@ void RigidBody::Update (bool force)
 		// flag for suppressing gravity-gradient torque (to avoid numerical instability)
 
 		// Update the list of gravity field sources
-		if (force || !gfielddata.ngrav) {
-			ScanGFieldSources (g_psys);
-			gfielddata.updt = td.SimT0 + (gfielddata_updt_interval*rand())/RAND_MAX;
-			// randomize update times
-		} else if (td.SimT0 > gfielddata.updt) {
-			UpdateGFieldSources (g_psys);
-			gfielddata.updt = td.SimT0 + gfielddata_updt_interval;
-		}
+		if (!bGFieldRefreshed) RefreshGFieldSources (force);
+		bGFieldRefreshed = false;
+
+		// First check if the body can coast along its osculating conic,
+		// then if we should do a stabilised state update
+		if (ConicCoast ()) {
 
-		// First check if we should do a stabilised state update
-		if (bCanUpdateStabilised &&
+			el_valid = true;
+			bOrbitStabilised = false;
+
+		} else if (bCanUpdateStabilised &&
 			ostep > g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_SLimit &&
 			g_psys->GetGravityContribution (cbody, cpos+cbody->GPos()) > 1-g_pOrbiter->Cfg()->CfgPhysicsPrm.Stabilise_PLimit) {
 
@@ -303,6 +316,21 @@ void RigidBody::Update (bool force)
 
 // =======================================================================
 
+void RigidBody::RefreshGFieldSources (bool force)
+{
+	if (force || !gfielddata.ngrav) {
+		ScanGFieldSources (g_psys);
+		gfielddata.updt = td.SimT0 + (gfielddata_updt_interval*rand())/RAND_MAX;
+		// randomize update times
+	} else if (td.SimT0 > gfielddata.updt) {
+		UpdateGFieldSources (g_psys);
+		gfielddata.updt = td.SimT0 + gfielddata_updt_interval;
+	}
+	bGFieldRefreshed = true;
+}
+
+// =======================================================================
+
 void RigidBody::ScanGFieldSources (const PlanetarySystem *psys)
 {
 	psys->ScanGFieldSources (&s0->pos, this, &gfielddata);
@@ -525,12 +553,14 @@ void RigidBody::SetDynamicUpdate (bool dynamic)
 const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 	static const char *ShortPropModeStr[NPROP_METHOD] = {
 		"RK2", "RK4", "RK5", "RK6", "RK7", "RK8",
-		"SY2", "SY4", "SY6", "SY8"
+		"SY2", "SY4", "SY6", "SY8",
+		"DP5", "RK78"
 	};
 	static const char *LongPropModeStr[NPROP_METHOD] = {
 		"Runge-Kutta, 2nd order (RK2)", "Runge-Kutta, 4th order (RK4)", "Runge-Kutta, 5th order (RK5)", "Runge-Kutta, 6th order (RK6)",
 		"Runge-Kutta, 7th order (RK7)", "Runge-Kutta, 8th order (RK8)",
-		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)"
+		"Symplectic, 2nd order (SY2)", "Symplectic, 4th order (SY4)", "Symplectic, 6th order (SY6)", "Symplectic, 8th order (SY8)",
+		"Dormand-Prince 5(4), adaptive (DP5)", "Runge-Kutta-Fehlberg 7(8), adaptive (RK78)"
 	};
 	return (idx < NPROP_METHOD ? (verbose ? LongPropModeStr[idx] : ShortPropModeStr[idx]) : "unknown");
 }
@@ -538,6 +568,7 @@ const char *RigidBody::PropagatorStr (DWORD idx, bool verbose) {
 const char *RigidBody::CurPropagatorStr (bool verbose) const
 {
 	if (!bDynamicPosVel) return "none";
+	else if (bConicCoast) return (verbose ? "Conic coast (analytic)" : "Conic");
 	else return PropagatorStr (PropMode[PropLevel].propidx, verbose);
 }
 
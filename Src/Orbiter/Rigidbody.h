@@ -19,6 +19,7 @@
 #include "Body.h"
 
 class RigidBody;
+struct RKPair;
 
 // =======================================================================
 // typdefs
@@ -167,6 +168,9 @@ public:
 	virtual bool isOrbitStabilised () const { return bOrbitStabilised; }
 	// return true if body uses orbit stabilisation for the current step
 
+	inline bool isConicCoast () const { return bConicCoast; }
+	// return true if the current step was an analytic conic coast update
+
 	inline bool canDynamicPosVel () const { return bDynamicPosVel; }
 	// return true if body can update its position by state vector integration
 
@@ -175,6 +179,12 @@ public:
 
 	inline const GFieldData &GetGFieldData() const { return gfielddata; }
 
+	void RefreshGFieldSources (bool force);
+	// Rebuild or update the list of gravity field sources, if due for the
+	// current step. This is called by Update, unless it has already been
+	// called explicitly for the current step (e.g. on the main thread,
+	// before a concurrent propagation phase)
+
 protected:
 	virtual void SetDefaultState ();
 	// Reset all state parameters to default values
@@ -196,6 +206,11 @@ protected:
 	void ReadGenericCaps (std::ifstream &ifs);
 	// Read parameters from a config file
 
+	virtual bool CanCoastConic () const { return false; }
+	// Returns true if no forces other than gravity act on the body during the
+	// current step, so that it may be propagated analytically along a conic
+	// when the gravitational perturbations are small. Default: false
+
 	inline int NumPropLevel() const { return nPropLevel; } // number of defined propagator levels
 	inline int MaxSubStep() const { return PropSubMax; }   // max number of substeps per step update
 
@@ -213,6 +228,10 @@ protected:
 	// Indicates if the current step was updated by "orbit stabilisation",
 	// i.e. Encke's method.
 
+	bool bConicCoast;
+	// Indicates if the current step was propagated analytically along the
+	// osculating conic (see CanCoastConic)
+
 	bool bIgnoreGravTorque;
 	// flag for suppressing gravity-gradient torque (to avoid numerical instability)
 
@@ -232,6 +251,7 @@ protected:
 	static bool bGPerturb;    // nonspherical gravity effects
 
 	GFieldData gfielddata;  // used for dynamic grav updates
+	bool bGFieldRefreshed;  // gravity source list already refreshed for the current step
 
 private:
 	static void SetupPropagationModes ();
@@ -252,6 +272,9 @@ private:
 	void SY4_LinAng (double h, int nsub, int isub);  // symplectic, order 4, linear+angular
 	void SY6_LinAng (double h, int nsub, int isub);  // symplectic, order 6, linear+angular
 	void SY8_LinAng (double h, int nsub, int isub);  // symplectic, order 8, linear+angular
+	void RKdrv_LinAng_Adaptive (double h, int nsub, int isub, const RKPair &rk); // embedded RK engine with step size control, linear+angular
+	void DP5_LinAng (double h, int nsub, int isub);  // Dormand-Prince 5(4), adaptive, linear+angular
+	void RK78_LinAng (double h, int nsub, int isub); // Runge-Kutta-Fehlberg 7(8), adaptive, linear+angular
 
 	// Propagators for 2-body orbit perturbations
 	//void RK2_LinAng_Encke (double h, int nsub, int isub);
@@ -263,6 +286,19 @@ private:
 
 	void Encke ();
 
+	// Analytic state update for unperturbed, force-free coasting
+	bool ConicCoast ();
+	// Propagate the linear state along the osculating conic and the attitude
+	// for torque-free rotation. Returns false without changing the state if
+	// the conditions for a conic step are not met, in which case the caller
+	// should do a dynamic update
+
+	double PerturbationRatio (const Vector &gpos, const Vector &rpos, double tfrac, Vector &g);
+	// Magnitude of the acceleration perturbing the 2-body orbit around cbody,
+	// relative to the point mass acceleration of cbody, for global position gpos
+	// and cbody-relative position rpos at fractional step tfrac. Returns the
+	// total gravitational acceleration in g
+
 	// -----------------------------------------------------------------------
 
 	static struct PROPMODE {
@@ -277,6 +313,8 @@ private:
 	int PropLevel;         // current propagator stage
 	int PropSubMax;        // upper limit for number of subsamples
 	int nPropSubsteps;     // current number of subsamples
+	double adaptStep;      // current internal step size of the adaptive propagators [s] (0=not set)
+	static double PropAdaptTol; // relative error tolerance of the adaptive propagators
 };
 
 #endif // !__RIGIDBODY_H
\ No newline at end of file
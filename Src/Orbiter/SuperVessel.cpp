@@ -23,6 +23,10 @@ extern Vessel *g_focusobj;
 extern bool g_bStateUpdate;
 extern char DBG_MSG[256];
 
+const int MASSSUM_REBUILD = 1000;
+// number of mass updates after which the incremental mass sums are rebuilt
+// from the components, to limit the accumulation of round-off errors
+
 // ==============================================================
 // class SuperVessel
 
@@ -37,6 +41,7 @@ SuperVessel::SuperVessel (Vessel *vessel)
 	vlist[0].rrot.Set (1,0,0, 0,1,0, 0,0,1); // identity
 	vlist[0].rpos.Set (0,0,0);
 	cg.Set (0,0,0);
+	RebuildMassSums();
 	s0->vel.Set (vessel->GVel());
 	rvel_base.Set (s0->vel);
 	rvel_add.Set (0,0,0);
@@ -92,13 +97,9 @@ SuperVessel::SuperVessel (Vessel *vessel1, Vessel *vessel2, int port1, int port2
 	vlist[1].rq.Set (vlist[1].rrot);
 
 	// total mass, centre of gravity and velocity
-	cg.Set(0,0,0);
-	mass = 0.0;
-	for (i = 0; i < 2; i++) {
-		mass += vlist[i].vessel->mass;
-		cg += vlist[i].rpos * vlist[i].vessel->mass;
-	}
-	cg /= mass;
+	RebuildMassSums();
+	mass = msum;
+	cg.Set (mr/msum);
 
 	// supervessel orientation
 	s0->R.Set (vessel1->s0->R);
@@ -460,9 +461,21 @@ void SuperVessel::TransferAllDocked (Vessel *v, SuperVessel *sv, const Vessel *e
 
 bool SuperVessel::isComponent (const Vessel *v) const
 {
+	return ComponentIndex (v) >= 0;
+}
+
+// =======================================================================
+
+int SuperVessel::ComponentIndex (const Vessel *v) const
+{
+	// try the index hint stored with the vessel before searching the list
+	if (v->svcomp < nv && vlist[v->svcomp].vessel == v) return (int)v->svcomp;
 	for (DWORD i = 0; i < nv; i++)
-		if (vlist[i].vessel == v) return true;
-	return false;
+		if (vlist[i].vessel == v) {
+			v->svcomp = i;
+			return (int)i;
+		}
+	return -1;
 }
 
 // =======================================================================
@@ -738,12 +751,60 @@ bool SuperVessel::Merge (Vessel *vessel1, int port1, Vessel *vessel2, int port2)
 bool SuperVessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, double tfrac, double dt) const
 {
 	bool impact = false;
-	DWORD comp;
+	DWORD comp, n;
 	StateVectors scomp;
+
+	// Query the terrain elevations under the touchdown points of all
+	// components in batches. The sampling resolution follows the altitude of
+	// each component, and consecutive components with the same resolution
+	// share a batch. Components that are too high for surface contact return
+	// from Vessel::AddSurfaceForces without using the results.
+	TouchdownBatch &tb = tdbatch;
+	bool batch = false;
+	ElevationManager *emgr = (s && proxybody && proxybody->Type() == OBJTP_PLANET ? ((Planet*)proxybody)->ElevMgr() : 0);
+	if (emgr) {
+		StateVectors ps = proxybody->InterpolateState (tfrac);
+		double alt = s->pos.dist (ps.pos) - proxybody->Size();
+		if (alt < sp.elev + 1e4 + size) {
+			batch = true;
+			tb.ofs.resize (nv+1);
+			tb.reslvl.resize (nv);
+			for (comp = n = 0; comp < nv; comp++) {
+				if (vlist[comp].vessel->proxybody != proxybody) batch = false;
+				tb.ofs[comp] = n;
+				n += vlist[comp].vessel->ntouchdown_vtx;
+			}
+			tb.ofs[nv] = n;
+		}
+		if (batch) {
+			if (tb.elev.size() < n) {
+				tb.lng.resize (n);
+				tb.lat.resize (n);
+				tb.rad.resize (n);
+				tb.elev.resize (n);
+			}
+			for (comp = 0; comp < nv; comp++) {
+				ComponentStateVectors (s, &scomp, comp);
+				DWORD i = tb.ofs[comp];
+				vlist[comp].vessel->TouchdownCoords (scomp, ps, tb.lng.data()+i, tb.lat.data()+i, tb.rad.data()+i);
+				double calt = scomp.pos.dist (ps.pos) - proxybody->Size() - sp.elev;
+				tb.reslvl[comp] = (int)(32.0-log(max(calt,100.0))*LOG2);
+			}
+			for (DWORD c0 = 0, c1; c0 < nv; c0 = c1) {
+				c1 = c0+1;
+				while (c1 < nv && tb.reslvl[c1] == tb.reslvl[c0]) c1++;
+				DWORD i = tb.ofs[c0];
+				emgr->ElevationBatch (tb.ofs[c1]-i, tb.lat.data()+i, tb.lng.data()+i, tb.elev.data()+i, tb.reslvl[c0], &etile);
+			}
+		}
+	}
+
 	for (comp = 0; comp < nv; comp++) {
 		Vector Fcomp, Mcomp;
 		ComponentStateVectors (s, &scomp, comp);
-		if (vlist[comp].vessel->AddSurfaceForces (&Fcomp, &Mcomp, &scomp, tfrac, dt)) {
+		DWORD i = (batch ? tb.ofs[comp] : 0);
+		if (vlist[comp].vessel->AddSurfaceForces (&Fcomp, &Mcomp, &scomp, tfrac, dt, true,
+			batch ? tb.rad.data()+i : NULL, batch ? tb.elev.data()+i : NULL)) {
 			AddComponentForceAndMoment (F, M, &Fcomp, &Mcomp, comp);
 			impact = true;
 		}
@@ -760,7 +821,7 @@ void SuperVessel::Update (bool force)
 	bool el_updated = false;;
 
 	// centre of gravity and total mass
-	ResetMassAndCG();
+	UpdateMassAndCG();
 
 	if (vlist[0].vessel->bFRplayback) {
 
@@ -966,50 +1027,89 @@ void SuperVessel::AddComponentForceAndMoment (Vector *F, Vector *M,
 
 void SuperVessel::NotifyShiftVesselOrigin (Vessel *vessel, const Vector &dr)
 {
-	for (DWORD i = 0; i < nv; i++) {
-		if (vlist[i].vessel == vessel) {
-			vlist[i].rpos += mul (vlist[i].rrot, dr);
-			return;
-		}
+	int i = ComponentIndex (vessel);
+	if (i >= 0) {
+		SubVesselData &sd = vlist[i];
+		mr -= sd.rpos * sd.mass;
+		sd.rpos += mul (sd.rrot, dr);
+		mr += sd.rpos * sd.mass;
+		CalcComponentMoments (i);
 	}
 }
 
 // =======================================================================
 
-bool SuperVessel::GetCG (const Vessel *vessel, Vector &vcg)
+void SuperVessel::NotifyMassChange (Vessel *vessel)
 {
-	for (DWORD i = 0; i < nv; i++) {
-		if (vlist[i].vessel == vessel) {
-			vcg.Set (tmul (vlist[i].rrot, cg-vlist[i].rpos));
-			return true;
-		}
+	int i = ComponentIndex (vessel);
+	if (i >= 0) SetComponentMass (i);
+}
+
+// =======================================================================
+
+void SuperVessel::NotifyPMIChange (Vessel *vessel)
+{
+	int i = ComponentIndex (vessel);
+	if (i >= 0) CalcComponentMoments (i);
+}
+
+// =======================================================================
+
+void SuperVessel::NotifyDampingChange (Vessel *vessel)
+{
+	int i = ComponentIndex (vessel);
+	if (i >= 0) {
+		SubVesselData &sd = vlist[i];
+		mdamp += (vessel->tidaldamp - sd.damp) * sd.mass;
+		sd.damp = vessel->tidaldamp;
+		bMassChanged = true;
 	}
-	return false;
+}
+
+// =======================================================================
+
+bool SuperVessel::GetCG (const Vessel *vessel, Vector &vcg)
+{
+	int i = ComponentIndex (vessel);
+	if (i < 0) return false;
+	vcg.Set (tmul (vlist[i].rrot, cg-vlist[i].rpos));
+	return true;
 }
 
 // =======================================================================
 
 bool SuperVessel::GetPMI (const Vessel *vessel, Vector &vpmi)
 {
-	for (DWORD i = 0; i < nv; i++) {
-		if (vlist[i].vessel == vessel) {
-			vpmi.Set (0,0,0);
-			Vector r0[6], rt;
-			double rtx2, rty2, rtz2;
-			r0[1].x = -(r0[0].x = 0.5 * sqrt (fabs (-pmi.x + pmi.y + pmi.z)));
-			r0[3].y = -(r0[2].y = 0.5 * sqrt (fabs ( pmi.x - pmi.y + pmi.z)));
-			r0[5].z = -(r0[4].z = 0.5 * sqrt (fabs ( pmi.x + pmi.y - pmi.z)));
-			for (DWORD j = 0; j < 6; j++) {
-				rt.Set (tmul (vlist[i].rrot, r0[j] + cg - vlist[i].rpos));
-				rtx2 = rt.x*rt.x, rty2 = rt.y*rt.y, rtz2 = rt.z*rt.z;
-				vpmi.x += rty2 + rtz2;
-				vpmi.y += rtx2 + rtz2;
-				vpmi.z += rtx2 + rty2;
-			}
-			return true;
-		}
+	int i = ComponentIndex (vessel);
+	if (i < 0) return false;
+	vpmi.Set (0,0,0);
+	Vector r0[6], rt;
+	double rtx2, rty2, rtz2;
+	r0[1].x = -(r0[0].x = 0.5 * sqrt (fabs (-pmi.x + pmi.y + pmi.z)));
+	r0[3].y = -(r0[2].y = 0.5 * sqrt (fabs ( pmi.x - pmi.y + pmi.z)));
+	r0[5].z = -(r0[4].z = 0.5 * sqrt (fabs ( pmi.x + pmi.y - pmi.z)));
+	for (DWORD j = 0; j < 6; j++) {
+		rt.Set (tmul (vlist[i].rrot, r0[j] + cg - vlist[i].rpos));
+		rtx2 = rt.x*rt.x, rty2 = rt.y*rt.y, rtz2 = rt.z*rt.z;
+		vpmi.x += rty2 + rtz2;
+		vpmi.y += rtx2 + rtz2;
+		vpmi.z += rtx2 + rty2;
 	}
-	return false;
+	return true;
+}
+
+// =======================================================================
+
+bool SuperVessel::GetCGPMI (const Vessel *vessel, Vector &vpmi)
+{
+	int i = ComponentIndex (vessel);
+	if (i < 0) return false;
+	const Matrix &R = vlist[i].rrot;
+	for (int k = 0; k < 3; k++) {
+		double rx = R.data[k], ry = R.data[3+k], rz = R.data[6+k];
+		vpmi.data[k] = rx*rx*pmi.x + ry*ry*pmi.y + rz*rz*pmi.z;
+	}
+	return true;
 }
 
 // =======================================================================
@@ -1034,16 +1134,89 @@ void SuperVessel::ResetSize ()
 
 // =======================================================================
 
-void SuperVessel::ResetMassAndCG ()
+void SuperVessel::SetComponentMass (DWORD i)
 {
-	// centre of gravity and total mass
-	Vector cg_new;
-	mass = 0.0;
+	SubVesselData &sd = vlist[i];
+	double dm = sd.vessel->mass - sd.mass;
+	if (dm) {
+		msum  += dm;
+		mr    += sd.rpos * dm;
+		mq    += sd.mq * dm;
+		mdamp += sd.damp * dm;
+		sd.mass = sd.vessel->mass;
+		bMassChanged = true;
+	}
+}
+
+// =======================================================================
+
+void SuperVessel::CalcComponentMoments (DWORD i)
+{
+	// The component mass is modelled by 6 point masses on its principal axes
+	// that reproduce its PMI values. For details see "Inertia calculations for
+	// composite vessels" in "Orbiter Technical Reference".
+
+	SubVesselData &sd = vlist[i];
+	const Vector &vpmi = sd.vessel->pmi;
+	Vector r0[6], rt, q;
+	r0[1].x = -(r0[0].x = sqrt (1.5 * fabs (-vpmi.x + vpmi.y + vpmi.z)));
+	r0[3].y = -(r0[2].y = sqrt (1.5 * fabs ( vpmi.x - vpmi.y + vpmi.z)));
+	r0[5].z = -(r0[4].z = sqrt (1.5 * fabs ( vpmi.x + vpmi.y - vpmi.z)));
+	for (DWORD j = 0; j < 6; j++) {
+		rt.Set (mul (sd.rrot, r0[j]) + sd.rpos);
+		q.x += rt.x*rt.x;
+		q.y += rt.y*rt.y;
+		q.z += rt.z*rt.z;
+	}
+	q /= 6.0;
+
+	mq += (q - sd.mq) * sd.mass;
+	sd.mq.Set (q);
+	bMassChanged = true;
+}
+
+// =======================================================================
+
+void SuperVessel::RebuildMassSums ()
+{
+	msum = mdamp = 0.0;
+	mr.Set (0,0,0);
+	mq.Set (0,0,0);
 	for (DWORD i = 0; i < nv; i++) {
-		mass += vlist[i].vessel->mass;
-		cg_new += vlist[i].rpos * vlist[i].vessel->mass;
+		SubVesselData &sd = vlist[i];
+		sd.vessel->svcomp = i;
+		sd.mass = sd.vessel->mass;
+		sd.damp = sd.vessel->tidaldamp;
+		sd.mq.Set (0,0,0);
+		CalcComponentMoments (i);
+		msum  += sd.mass;
+		mr    += sd.rpos * sd.mass;
+		mdamp += sd.damp * sd.mass;
+	}
+	bMassChanged = false;
+	nMassUpdate = 0;
+}
+
+// =======================================================================
+
+void SuperVessel::ResetMassAndCG ()
+{
+	RebuildMassSums ();
+	UpdateMassAndCG ();
+}
+
+// =======================================================================
+
+void SuperVessel::UpdateMassAndCG ()
+{
+	if (bMassChanged && ++nMassUpdate >= MASSSUM_REBUILD) {
+		RebuildMassSums ();
+		bMassChanged = true; // PMI still needs updating
 	}
-	cg_new /= mass;
+
+	// centre of gravity and total mass
+	mass = msum;
+	Vector cg_new (mr/msum);
 
 	// shift CG
 	Vector dp = mul (s0->R, cg_new-cg);
@@ -1051,56 +1224,29 @@ void SuperVessel::ResetMassAndCG ()
 	rpos_add += dp;
 	cpos += dp;
 	cg = cg_new;
+
+	if (bMassChanged) {
+		CalcPMI ();
+		bMassChanged = false;
+	}
 }
 
 // =======================================================================
 
 void SuperVessel::CalcPMI ()
 {
-	// Calculates the PMI values for the supervessel from the layout and component PMI
-	// values. For details see "Inertia calculations for composite vessels" in "Orbiter
-	// Technical Reference".
-
-	DWORD i, j;
-	Vector r0[6], rt;
-	double rtx2, rty2, rtz2, vmass;
-	double vpmix, vpmiy, vpmiz;
-
-	pmi.Set (0,0,0);
+	// Calculates the PMI values for the supervessel from the second moments of
+	// the component mass models about the supervessel origin, shifted to the CG
+	// (parallel axis theorem).
 
-	for (i = 0; i < nv; i++) {
-		Vessel *v = vlist[i].vessel;
-		Vector &vpmi = v->pmi;
-		vmass = v->mass/6.0;
-		r0[1].x = -(r0[0].x = sqrt (1.5 * fabs (-vpmi.x + vpmi.y + vpmi.z)));
-		r0[3].y = -(r0[2].y = sqrt (1.5 * fabs ( vpmi.x - vpmi.y + vpmi.z)));
-		r0[5].z = -(r0[4].z = sqrt (1.5 * fabs ( vpmi.x + vpmi.y - vpmi.z)));
-
-		vpmix = vpmiy = vpmiz = 0.0;
-		for (j = 0; j < 6; j++) {
-			rt.Set (mul (vlist[i].rrot, r0[j]) + vlist[i].rpos - cg);
-			rtx2 = rt.x*rt.x, rty2 = rt.y*rt.y, rtz2 = rt.z*rt.z;
-			vpmix += rty2 + rtz2;
-			vpmiy += rtx2 + rtz2;
-			vpmiz += rtx2 + rty2;
-		}
-		pmi.x += vmass * vpmix;
-		pmi.y += vmass * vpmiy;
-		pmi.z += vmass * vpmiz;
-	}
-	// normalise with total supervessel mass
-	pmi.x /= mass;
-	pmi.y /= mass;
-	pmi.z /= mass;
+	Vector q (mq/msum);
+	pmi.x = q.y + q.z - (cg.y*cg.y + cg.z*cg.z);
+	pmi.y = q.x + q.z - (cg.x*cg.x + cg.z*cg.z);
+	pmi.z = q.x + q.y - (cg.x*cg.x + cg.y*cg.y);
 
 	// we also need to update the damping term for the gravity gradient
 	// torque. This is a weighted average of the vessel component values.
-	tidaldamp = 0;
-	for (i = 0; i < nv; i++) {
-		Vessel *v = vlist[i].vessel;
-		tidaldamp += v->tidaldamp * v->mass;
-	}
-	tidaldamp /= mass;
+	tidaldamp = mdamp/msum;
 }
 
 // =======================================================================
@@ -47,6 +47,10 @@ typedef struct {     // vessel component specs
 	Vector rpos;        // rel vessel position in SuperVessel coords
 	Matrix rrot;        // rel vessel orientation: vessel -> supervessel
 	Quaternion rq;      // rel vessel orientation in quaternion representation
+	double mass;        // vessel mass included in the supervessel mass sums
+	double damp;        // vessel gravity gradient damping included in the sums
+	Vector mq;          // diagonal second moments of the vessel mass model about the
+	                    // supervessel origin, per unit mass
 } SubVesselData;
 
 // ==============================================================
@@ -132,6 +136,15 @@ public:
 	void NotifyShiftVesselOrigin (Vessel *vessel, const Vector &dr);
 	// sent by a vessel to notify a shift of its local coordinate origin (i.e. its centre of mass)
 
+	void NotifyMassChange (Vessel *vessel);
+	// sent by a vessel when its mass has changed (e.g. by propellant flow)
+
+	void NotifyPMIChange (Vessel *vessel);
+	// sent by a vessel when its principal moments of inertia have changed
+
+	void NotifyDampingChange (Vessel *vessel);
+	// sent by a vessel when its gravity gradient damping coefficient has changed
+
 	bool GetCG (const Vessel *vessel, Vector &vcg);
 	// Sets 'vcg' to centre of gravity of super-structure in coordinates of 'vessel', if vessel is
 	// part of the super-structure. Otherwise returns false
@@ -140,6 +153,11 @@ public:
 	// Returns PMI values of supervessel in 'vpmi' rotated into coordinate frame of
 	// vessel 'vessel'
 
+	bool GetCGPMI (const Vessel *vessel, Vector &vpmi);
+	// Sets 'vpmi' to the moments of inertia (mass-normalised) of the super-structure
+	// about its centre of gravity, for the axes of 'vessel', if vessel is part of the
+	// super-structure. Otherwise returns false
+
 	inline double Mass() const { return mass; }
 	// Returns supervessel mass (sum of component masses)
 
@@ -177,15 +195,33 @@ private:
 	void TransferAllDocked (Vessel *v, SuperVessel *sv, const Vessel *exclude);
 	// Transfer all vessels docked to 'v' from *this to 'sv', excluding vessel 'exclude'
 
+	int ComponentIndex (const Vessel *v) const;
+	// index of vessel v in vlist, or -1 if v is not a component
+
+	void SetComponentMass (DWORD i);
+	// update the mass sums with the current mass of component i
+
+	void CalcComponentMoments (DWORD i);
+	// calculate the mass model moments of component i from its layout and PMI,
+	// and update the mass sums accordingly
+
+	void RebuildMassSums ();
+	// re-calculate the mass sums from all components. Required after changes
+	// of the superstructure layout.
+
 	void ResetMassAndCG();
-	// re-calculates superstructure mass and centre of gravity.
+	// re-calculates superstructure mass and centre of gravity from all components.
 	// Shifts global position to reflect CG change
 
+	void UpdateMassAndCG();
+	// as ResetMassAndCG, but from the mass sums. Also updates the PMI if any
+	// component masses have changed.
+
 	void ResetSize();
 
 	void CalcPMI();
 	// calculate PMI (principal axes of inertia for the superstructure,
-	// given the sub-vessels and their relative orientation
+	// given the sub-vessels and their relative orientation, from the mass sums
 
 	void UpdateProxies();
 	// update reference body
@@ -211,6 +247,18 @@ private:
 	// Note: The supervessel origin is the origin of the first vessel in the
 	// list, not the CG of the composite structure.
 
+	// *** mass sums ***
+	// Maintained incrementally as component masses change, so that mass, CG and
+	// PMI updates don't need to loop over all components. Rebuilt from the
+	// component list when the layout changes (docking, undocking), and
+	// periodically to limit the accumulation of round-off errors.
+	double msum;          // sum of component masses
+	Vector mr;            // sum of component mass * position
+	Vector mq;            // sum of component mass * second moments (SubVesselData::mq)
+	double mdamp;         // sum of component mass * gravity gradient damping
+	bool bMassChanged;    // component masses have changed since the last update
+	int nMassUpdate;      // mass updates since the sums were last rebuilt
+
 	Vector Flin, Amom;
 	// linear, angular forces on structure other than gravitational;
 	// collected from vessel components
@@ -225,6 +273,16 @@ private:
 
 	TOUCHDOWN_VTX hullvtx; // used by hull vertex iterator
 	DWORD next_hullvessel; // used by hull vertex iterator
+
+	struct TouchdownBatch {
+		std::vector<double> lng, lat, rad; // touchdown point coordinates of all components
+		std::vector<double> elev;          // surface elevations under the touchdown points
+		std::vector<DWORD> ofs;            // offset of the points of each component (nv+1)
+		std::vector<int> reslvl;           // elevation sampling resolution of each component
+	};
+	mutable TouchdownBatch tdbatch;
+	// work arrays of AddSurfaceForces (per supervessel, so that supervessels
+	// can be processed concurrently)
 };
 
 #endif // !__SUPERVESSEL_H
\ No newline at end of file
@@ -333,7 +333,8 @@ char *ExtraPropagation::Description ()
 
 int ExtraDynamics::PropId[NPROP_METHOD] = {
 	PROP_RK2, PROP_RK4, PROP_RK5, PROP_RK6, PROP_RK7, PROP_RK8,
-	PROP_SY2, PROP_SY4, PROP_SY6, PROP_SY8
+	PROP_SY2, PROP_SY4, PROP_SY6, PROP_SY8,
+	PROP_DP5, PROP_RK78
 };
 
 char *ExtraDynamics::Name ()
@@ -0,0 +1,98 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class ThreadPool
+// =======================================================================
+
+#include <algorithm>
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool (int nthread)
+{
+	m_task = 0;
+	m_ntask = 0;
+	m_next = 0;
+	m_nbusy = 0;
+	m_jobid = 0;
+	m_bTerminate = false;
+
+	if (nthread <= 0)
+		nthread = std::max (1, (int)std::thread::hardware_concurrency());
+	for (int i = 1; i < nthread; i++)
+		m_worker.emplace_back (&ThreadPool::WorkerProc, this);
+}
+
+// -----------------------------------------------------------------------
+
+ThreadPool::~ThreadPool ()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bTerminate = true;
+	}
+	m_cvJob.notify_all();
+	for (auto &t : m_worker)
+		t.join();
+}
+
+// -----------------------------------------------------------------------
+
+void ThreadPool::ParallelFor (size_t ntask, const std::function<void(size_t)> &task)
+{
+	if (!ntask) return;
+
+	if (m_worker.empty() || ntask == 1) { // nothing to distribute
+		for (size_t i = 0; i < ntask; i++)
+			task(i);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_task = &task;
+		m_ntask = ntask;
+		m_next = 0;
+		m_nbusy = (int)m_worker.size();
+		m_jobid++;
+	}
+	m_cvJob.notify_all();
+
+	RunTasks(); // the caller works on the job as well
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_cvDone.wait (lock, [this] { return m_nbusy == 0; });
+	m_task = 0;
+}
+
+// -----------------------------------------------------------------------
+
+void ThreadPool::RunTasks ()
+{
+	for (;;) {
+		size_t i = m_next.fetch_add (1);
+		if (i >= m_ntask) break;
+		(*m_task)(i);
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void ThreadPool::WorkerProc ()
+{
+	unsigned int jobid = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_cvJob.wait (lock, [&] { return m_bTerminate || m_jobid != jobid; });
+			if (m_bTerminate) return;
+			jobid = m_jobid;
+		}
+		RunTasks();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			if (--m_nbusy == 0)
+				m_cvDone.notify_one();
+		}
+	}
+}
@@ -0,0 +1,57 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class ThreadPool
+// A small pool of persistent worker threads for data-parallel jobs
+// inside a simulation frame (e.g. concurrent vessel propagation).
+// Tasks are claimed dynamically from a shared counter, so idle threads
+// pick up the remaining work of a job as soon as they finish their own.
+// The calling thread takes part in every job.
+// =======================================================================
+
+#ifndef __THREADPOOL_H
+#define __THREADPOOL_H
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+class ThreadPool {
+public:
+	ThreadPool (int nthread = 0);
+	// nthread: total number of threads working on a job, including the
+	// calling thread (0 = one per hardware thread, 1 = no worker threads,
+	// all tasks are executed sequentially by the caller)
+
+	~ThreadPool ();
+
+	inline int nThread () const { return (int)m_worker.size() + 1; }
+	// number of threads participating in a job, including the caller
+
+	void ParallelFor (size_t ntask, const std::function<void(size_t)> &task);
+	// Calls task(i) for i = 0..ntask-1, distributed over the pool threads,
+	// and returns when all tasks have completed. Tasks must not depend on
+	// each other's results. Must only be called from the thread that
+	// created the pool, and not recursively from inside a task.
+
+private:
+	void WorkerProc ();
+	void RunTasks ();
+
+	std::vector<std::thread> m_worker;   // worker threads
+	std::mutex m_mutex;
+	std::condition_variable m_cvJob;     // signals a new job (or termination) to the workers
+	std::condition_variable m_cvDone;    // signals job completion to the caller
+	const std::function<void(size_t)> *m_task; // current job
+	size_t m_ntask;                      // number of tasks in current job
+	std::atomic<size_t> m_next;          // next unclaimed task index
+	int m_nbusy;                         // workers still processing the current job
+	unsigned int m_jobid;                // job counter, to wake workers once per job
+	bool m_bTerminate;                   // shut down workers
+};
+
+#endif // !__THREADPOOL_H
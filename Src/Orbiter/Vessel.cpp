@@ -37,8 +37,12 @@
 #include "State.h"
 #include "Util.h"
 #include "elevmgr.h"
+#include "Profiler.h"
+#include "AirfoilTable.h"
 #include <fstream>
 #include <iomanip>
+#include <map>
+#include <tuple>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string>
@@ -264,6 +268,9 @@ void Vessel::SetClassCaps (ifstream &classf)
 
 	// Read specs from class or vessel cfg file
 	ReadGenericCaps (classf);
+
+	if (bTabulateAirfoils || airfoilTableFile.size())
+		TabulateAirfoils ();
 }
 
 // ==============================================================
@@ -296,7 +303,7 @@ void Vessel::SetDefaultState ()
 	undock_t            = -1000;
 	proxyvessel         = 0;
 	supervessel         = 0;
-	scanvessel          = 0;
+	svcomp              = 0;
 	attmode             = 1;
 	ctrlsurfmode        = 0;
 	for (i = 0; i < 6; i++)
@@ -310,6 +317,7 @@ void Vessel::SetDefaultState ()
 	sp.is_in_atm        = false;
 	m_bThrustEngaged    = false;
 	bForceActive        = false;
+	bPropagated         = false;
 	rpressure           = g_pOrbiter->Cfg()->CfgPhysicsPrm.bRadiationPressure;
 	Lift = Drag = SideForce = 0.0;
 	attach_status.pname = 0;
@@ -352,6 +360,8 @@ void Vessel::DefaultGenericCaps ()
 	CWy                = 0.3;
 	wingaspect         = 1.0;
 	wingeff            = 2.8;
+	bTabulateAirfoils  = false;
+	airfoilTableFile.clear();
 	trim_scale         = 0.0;
 	for (i = 0; i < 6; i++)
 		ctrlsurf_level[i].delay = 1.0;
@@ -521,6 +531,9 @@ void Vessel::ReadGenericCaps (ifstream &ifs)
 		sscanf (cbuf, "%lf%lf%lf%lf", CWz, CWz+1, &CWx, &CWy);
 	GetItemReal   (ifs, "WingAspect", wingaspect);
 	GetItemReal   (ifs, "WingEffectiveness", wingeff);
+	GetItemBool   (ifs, "TabulateAirfoils", bTabulateAirfoils);
+	if (GetItemString (ifs, "AirfoilTables", cbuf))
+		airfoilTableFile = cbuf;
 	GetItemVector (ifs, "CrossSections", cs);
 	GetItemVector (ifs, "RotResistance", rdrag);
 	GetItemVector (ifs, "CameraOffset", campos);
@@ -1822,7 +1835,7 @@ bool Vessel::GetAirfoilParam (AirfoilSpec *af, VECTOR3 *ref, AirfoilCoeffFunc *c
 void Vessel::EditAirfoil (AirfoilSpec *af, DWORD flag, const Vector &ref, AirfoilCoeffFunc cf, double c, double S, double A)
 {
 	if (flag & 0x01) af->ref.Set (ref);
-	if (flag & 0x02) af->cf = cf;
+	if (flag & 0x02) af->cf = cf, af->table.reset();
 	if (flag & 0x04) af->c  = c;
 	if (flag & 0x08) af->S  = S;
 	if (flag & 0x10) af->A  = A;
@@ -1830,6 +1843,105 @@ void Vessel::EditAirfoil (AirfoilSpec *af, DWORD flag, const Vector &ref, Airfoi
 
 // ==============================================================
 
+// Tables sampled from the same coefficient function are shared between
+// vessels. Tabulation assumes that the coefficients depend only on the
+// flow parameters, so the calling vessel does not enter the key.
+static std::map<std::tuple<int,AirfoilCoeffFunc,void*>, std::weak_ptr<const AirfoilTable> > s_airfoilTables;
+static std::map<std::string, std::weak_ptr<const AirfoilTable> > s_airfoilTableFiles;
+
+bool Vessel::TabulateAirfoil (AirfoilSpec *af, bool tabulate)
+{
+	if (!tabulate) {
+		af->table.reset();
+		return true;
+	}
+	if (af->version > 1) return false; // FORCE_AND_MOMENT callbacks depend on the full flow direction
+	if (af->table) return true;
+
+	auto key = std::make_tuple (af->version, af->cf, af->context);
+	auto it = s_airfoilTables.find (key);
+	if (it != s_airfoilTables.end() && (af->table = it->second.lock()))
+		return true;
+
+	AirfoilTable::CoeffFunc cf;
+	if (af->version == 0) {
+		AirfoilCoeffFunc f = af->cf;
+		cf = [f](double aoa, double M, double Re, double *cl, double *cm, double *cd) {
+			f (aoa, M, Re, cl, cm, cd);
+		};
+	} else {
+		AirfoilCoeffFuncEx f = (AirfoilCoeffFuncEx)af->cf;
+		VESSEL *v = (VESSEL*)modIntf.v;
+		void *context = af->context;
+		cf = [f,v,context](double aoa, double M, double Re, double *cl, double *cm, double *cd) {
+			f (v, aoa, M, Re, context, cl, cm, cd);
+		};
+	}
+	std::shared_ptr<AirfoilTable> table (new AirfoilTable); TRACENEW
+	table->Sample (cf);
+
+	// report the interpolation error
+	AirfoilTable::Error err;
+	table->Validate (cf, err);
+	LOGOUT("Airfoil table (%s): %dx%dx%d nodes, max. error CL %0.3g (AoA %0.1f, M %0.2f), Cm %0.3g, CD %0.3g (AoA %0.1f, M %0.2f)",
+		classname, table->nNode(0), table->nNode(1), table->nNode(2),
+		err.maxerr[0], err.aoa[0]*DEG, err.M[0], err.maxerr[1], err.maxerr[2], err.aoa[2]*DEG, err.M[2]);
+
+	af->table = table;
+	s_airfoilTables[key] = af->table;
+	return true;
+}
+
+// ==============================================================
+
+void Vessel::TabulateAirfoils ()
+{
+	std::string fname;
+	bool complete = true;
+	if (airfoilTableFile.size()) {
+		fname = g_pOrbiter->ConfigPath (airfoilTableFile.c_str());
+		std::ifstream ifs (fname);
+		std::string item;
+		DWORD i;
+		while (ifs >> item) {
+			if (item != "BEGIN_AIRFOIL" || !(ifs >> i)) break;
+			std::string key = fname + '#' + std::to_string (i);
+			auto it = s_airfoilTableFiles.find (key);
+			std::shared_ptr<const AirfoilTable> table;
+			if (it != s_airfoilTableFiles.end()) table = it->second.lock();
+			if (!table) {
+				std::shared_ptr<AirfoilTable> t (new AirfoilTable); TRACENEW
+				if (!t->Read (ifs)) {
+					LOGOUT_WARN("Invalid airfoil table %d in %s", i, fname.c_str());
+					break;
+				}
+				s_airfoilTableFiles[key] = table = t;
+			} else {
+				AirfoilTable skip;
+				if (!skip.Read (ifs)) break;
+			}
+			if (!(ifs >> item) || item != "END_AIRFOIL") break;
+			if (i < nairfoil && airfoil[i]->version <= 1) airfoil[i]->table = table;
+		}
+	}
+	for (DWORD i = 0; i < nairfoil; i++)
+		if (!airfoil[i]->table && TabulateAirfoil (airfoil[i])) complete = false;
+
+	// store newly sampled tables, so later sessions can load them
+	if (fname.size() && !complete) {
+		std::ofstream ofs (fname);
+		for (DWORD i = 0; i < nairfoil; i++) {
+			if (!airfoil[i]->table) continue;
+			ofs << "BEGIN_AIRFOIL " << i << '\n';
+			airfoil[i]->table->Write (ofs);
+			ofs << "END_AIRFOIL\n";
+		}
+		if (ofs) LOGOUT("Airfoil tables written to %s", fname.c_str());
+	}
+}
+
+// ==============================================================
+
 bool Vessel::DelAirfoil (AirfoilSpec *af)
 {
 	for (DWORD i = 0; i < nairfoil; i++)
@@ -3633,6 +3745,7 @@ void Vessel::UpdateMass ()
 	pfmass = fmass, fmass = 0.0;
 	for (DWORD i = 0; i < ntank; i++) fmass += tank[i]->mass;
 	mass = emass + fmass;
+	if (supervessel) supervessel->NotifyMassChange (this);
 }
 
 bool Vessel::SetNavMode (int mode, bool fromstream)
@@ -3806,6 +3919,22 @@ bool Vessel::GetSuperStructCG (Vector &cg) const
 	}
 }
 
+// =======================================================================
+// If vessel is part of a superstructure: set 'pmi' to the superstructure
+// moments of inertia about its CG for the vessel axes, and return true.
+// Otherwise: set 'pmi' to (0,0,0) and return false
+
+bool Vessel::GetSuperStructPMI (Vector &pmi) const
+{
+	if (!supervessel) {
+		pmi.Set(0,0,0);
+		return false;
+	} else {
+		supervessel->GetCGPMI (this, pmi);
+		return true;
+	}
+}
+
 // =======================================================================
 
 double Vessel::MaxAngularMoment (int axis) const
@@ -3829,6 +3958,7 @@ bool Vessel::SetGravityGradientDamping (double damp)
 {
 	if (bDistmass) {
 		tidaldamp = damp;
+		if (supervessel) supervessel->NotifyDampingChange (this);
 		return true;
 	} else return false;
 }
@@ -4095,6 +4225,7 @@ void Vessel::UpdateRadiationForces ()
 
 void Vessel::UpdateAerodynamicForces ()
 {
+	PROFILE_ZONE("Vessel::UpdateAerodynamicForces");
 	if (!nairfoil) { UpdateAerodynamicForces_OLD (); return; }
 	// use old atmospheric flight model;
 
@@ -4146,7 +4277,9 @@ void Vessel::UpdateAerodynamicForces ()
 	for (i = 0; i < nairfoil; i++) {
 		AirfoilSpec *af = airfoil[i];
 		if (af->align == LIFT_VERTICAL) {
-			if (af->version == 0)
+			if (af->table)
+				af->table->Eval (aoa, sp.atmM, Re0*af->c, &CL, &Cm, &CD);
+			else if (af->version == 0)
 				af->cf (aoa, sp.atmM, Re0*af->c, &CL, &Cm, &CD);
 			else
 				((AirfoilCoeffFuncEx)af->cf)((VESSEL*)modIntf.v, aoa, sp.atmM, Re0*af->c, af->context, &CL, &Cm, &CD);
@@ -4156,7 +4289,9 @@ void Vessel::UpdateAerodynamicForces ()
 			if (Cm) Amom_add.x += Cm*sp.dynp*af->S*af->c;
 			Lift += lift, Drag += drag;
 		} else if (af->align == LIFT_HORIZONTAL) { // horizontal lift component
-			if (af->version == 0)
+			if (af->table)
+				af->table->Eval (beta, sp.atmM, Re0*af->c, &CL, &Cm, &CD);
+			else if (af->version == 0)
 				af->cf (beta, sp.atmM, Re0*af->c, &CL, &Cm, &CD);
 			else
 				((AirfoilCoeffFuncEx)af->cf)((VESSEL*)modIntf.v, beta, sp.atmM, Re0*af->c, af->context, &CL, &Cm, &CD);
@@ -4281,21 +4416,26 @@ void Vessel::UpdateAerodynamicForces_OLD ()
 // If tfrac==1, the full step is calculated
 // Note that no interpolation of rotation states is performed
 
-bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, double tfrac, double dt, bool allow_groundcontact) const
+void Vessel::TouchdownCoords (const StateVectors &s, const StateVectors &ps, double *lng, double *lat, double *rad) const
+{
+	Matrix T (s.R); // transformation vessel local -> planet local
+	T.tpremul (ps.R);
+	Vector shift = tmul(ps.R, s.pos - ps.pos);
+	for (DWORD i = 0; i < ntouchdown_vtx; i++) {
+		Vector p (mul (T, touchdown_vtx[i].pos) + shift);
+		proxybody->LocalToEquatorial (p, lng[i], lat[i], rad[i]);
+	}
+}
+
+bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, double tfrac, double dt, bool allow_groundcontact, const double *tdrad, const double *tdelev) const
 {
 	nforcevec = 0; // should move higher up
 	E_comp = 0.0;  // compression energy
 
 	int i, j;
 	double alt = 0, tdymin = 0;
-	static int *tidx = new int[3];
-	static double *tdy = new double[3];
-	static double *fn = new double[3];
-	static double *flng = new double[3];
-	static double *flat = new double[3];
-	static DWORD ntdy = 3;
-
-	static StateVectors ls; // local state
+
+	StateVectors ls; // local state
 	if (!proxybody) return false;
 	StateVectors ps = proxybody->InterpolateState (tfrac); // intermediate planet state; should probably be passed in as function argument
 	SurfParam surfp; // intermediate surface parameters; should probably be passed in as function argument
@@ -4326,32 +4466,33 @@ bool Vessel::AddSurfaceForces (Vector *F, Vector *M, const StateVectors *s, doub
 	Matrix T (s->R); // transformation vessel local -> planet local
 	T.tpremul (ps.R);
 
-	if (ntdy < ntouchdown_vtx) {
-		ntdy = ntouchdown_vtx;
-		delete []tidx;
-		tidx = new int[ntdy];
-		delete []tdy;
-		tdy = new double[ntdy];
-		delete []fn;
-		fn = new double[ntdy];
-		delete []flng;
-		flng = new double[ntdy];
-		delete []flat;
-		flat = new double[ntdy];
-	}
-
-	ElevationManager* emgr = (cbody->Type() == OBJTP_PLANET ? ((Planet*)cbody)->ElevMgr() : 0);
-	int reslvl = 1;
-	if (emgr) reslvl = (int)(32.0-log(max(alt,100.0))*LOG2);
-
-	Vector shift = tmul(ps.R, s->pos - ps.pos);
+	// work arrays (per vessel, so that vessels can be processed concurrently)
+	DWORD n = ntouchdown_vtx;
+	if (tdwork.size() < 8*n) {
+		tdwork.resize (8*n);
+		tdidx.resize (n);
+	}
+	int *tidx = tdidx.data();
+	double *tdy = tdwork.data(), *fn = tdy+n, *flng = fn+n, *flat = flng+n;
+
+	// touchdown point coordinates and the terrain elevations under all
+	// points in one batch, unless provided by the caller
+	if (!tdrad) {
+		double *tdlng = flat+n, *tdlat = tdlng+n, *rad = tdlat+n;
+		TouchdownCoords (*s, ps, tdlng, tdlat, rad);
+		tdrad = rad;
+		if (!tdelev) {
+			ElevationManager* emgr = (cbody->Type() == OBJTP_PLANET ? ((Planet*)cbody)->ElevMgr() : 0);
+			if (emgr) {
+				double *elev = rad+n;
+				int reslvl = (int)(32.0-log(max(alt,100.0))*LOG2);
+				emgr->ElevationBatch (n, tdlat, tdlng, elev, reslvl, &etile);
+				tdelev = elev;
+			}
+		}
+	}
 	for (i = 0; i < ntouchdown_vtx; i++) {
-		Vector p (mul (T, touchdown_vtx[i].pos) + shift);
-		double lng, lat, rad, elev = 0.0;
-		proxybody->LocalToEquatorial (p, lng, lat, rad);
-		if (emgr)
-			elev = emgr->Elevation (lat, lng, reslvl, &etile);
-		tdy[i] = rad - elev - proxybody->Size();
+		tdy[i] = tdrad[i] - (tdelev ? tdelev[i] : 0.0) - proxybody->Size();
 		if (!i || tdy[i] < tdymin) {
 			tdymin = tdy[i];
 		}
@@ -4723,7 +4864,7 @@ void Vessel::Update (bool force)
 		if (!supervessel) {
 			if (bFRplayback) {
 				FRecorder_Play();          // update from playback stream
-			} else {
+			} else if (!bPropagated) {
 				RigidBody::Update (force); // standard dynamic update
 			}
 		}
@@ -4762,6 +4903,7 @@ void Vessel::Update (bool force)
 
 	} else { // should not get here
 	}
+	bPropagated = false;
 
 	// update surface parameters
 	if (proxybody && fstatus != FLIGHTSTATUS_LANDED)
@@ -4930,6 +5072,39 @@ void Vessel::Update (bool force)
 	UpdateAttachments();
 }
 
+bool Vessel::CanPropagateConcurrent () const
+{
+	if (attach || supervessel || bFRplayback) return false;
+	if (fstatus != FLIGHTSTATUS_FREEFLIGHT || !bDynamicPosVel) return false;
+	if (bSurfaceContact) return false;
+
+	// Ground contact forces use the elevation manager and shared scratch buffers,
+	// so keep vessels on the main thread if they may come close to the surface
+	// during this step (see the early exit in AddSurfaceForces)
+	if (proxybody) {
+		const double alt_margin = 2e4;
+		double vrel = (s0->vel - proxybody->s0->vel).length();
+		if (sp.alt - vrel*td.SimDT < alt_margin) return false;
+	}
+	return true;
+}
+
+void Vessel::PropagateConcurrent (bool force)
+{
+	RigidBody::Update (force);
+	bPropagated = true;
+}
+
+bool Vessel::CanCoastConic () const
+{
+	if (attach || supervessel || bFRplayback) return false;
+	if (fstatus != FLIGHTSTATUS_FREEFLIGHT || bSurfaceContact) return false;
+	if (bForceActive || m_bThrustEngaged) return false;
+	if (Flin_add.x || Flin_add.y || Flin_add.z || Amom_add.x || Amom_add.y || Amom_add.z) return false;
+	if (proxyplanet && sp.is_in_atm) return false;
+	return true;
+}
+
 void Vessel::UpdatePassive ()
 {
 	StateVectors *s = (s1 ? s1:s0); // hack - this should really only be called during update phase
@@ -4991,65 +5166,71 @@ void Vessel::PostUpdate ()
 	if (fstatus == FLIGHTSTATUS_FREEFLIGHT && td.SimT1 > undock_t+1.0) {
 
 		// check for vessel-vessel docking
-		// check one vessel per frame (this may not be enough if universe is densely
-		// populated. Instead there should be a list of vessels, sorted into 2 or 3 distance
-		// bins (eg < 10km, <1000km, rest) and 1 vessel per *bin* should be checked)
+		// all vessels that could be in docking range are retrieved from the
+		// spatial vessel index, so every candidate is checked every frame
 
 		if (ndock) {
-			if (++scanvessel >= g_psys->nVessel()) scanvessel = 0;
-			Vessel *v = g_psys->GetVessel(scanvessel);
-			if (v != this && v->ndock && v->proxybody == proxybody) {
+			double rmax = size + g_psys->MaxVesselSize();
+			static std::vector<Vessel*> cand;
+			cand.clear();
+			g_psys->VesselsInRange (s0->pos, max (1.5*rmax, rmax+1e3), cand, this);
+			Vector dref, gref, vref;
+			bool closeupdated = false;
+			for (auto it = cand.begin(); it != cand.end(); it++) {
+				Vessel *v = *it;
+				if (!v->ndock || v->proxybody != proxybody) continue;
 				double dst = s0->pos.dist (v->GPos());
-
-				if ((dst < 1.5 * (size + v->Size()) || (dst < size + v->Size() + 1e3))) { // valid candidate
-					Vector dref, gref, vref;
-					for (j = 0; j < ndock; j++) { // loop over my own docks
-						if (dock[j]->mate) continue; // dock already busy
-						if (dockmode == 0) { // legacy docking mode
-							if (dotp (s0->vel - v->GVel(), mul (s0->R, dock[j]->dir)) < -0.01) continue; // moving away from dock
-							for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
-								if (v->dock[k]->mate) continue; // dock already busy
-								dref.Set (tmul (v->GRot(), mul (s0->R, dock[j]->ref) + s0->pos - v->GPos()));
-								double d = dref.dist (v->dock[k]->ref);
-								if (d < MIN_DOCK_DIST) {
+				if (dst >= 1.5 * (size + v->Size()) && dst >= size + v->Size() + 1e3) continue; // not a valid candidate
+
+				for (j = 0; j < ndock; j++) { // loop over my own docks
+					if (dock[j]->mate) continue; // dock already busy
+					if (dockmode == 0) { // legacy docking mode
+						if (dotp (s0->vel - v->GVel(), mul (s0->R, dock[j]->dir)) < -0.01) continue; // moving away from dock
+						for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
+							if (v->dock[k]->mate) continue; // dock already busy
+							dref.Set (tmul (v->GRot(), mul (s0->R, dock[j]->ref) + s0->pos - v->GPos()));
+							double d = dref.dist (v->dock[k]->ref);
+							if (d < MIN_DOCK_DIST) {
+								if (dock[j]->autodock && v->dock[k]->autodock)
+									Dock (v, j, k);
+							}
+						}
+					} else { // new docking mode
+						for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
+							if (v->dock[k]->mate) continue; // dock already busy
+							gref.Set (mul (s0->R, dock[j]->ref) + s0->pos);            // my dock in global frame
+							vref.Set (mul (v->GRot(), v->dock[k]->ref) + v->GPos()); // target dock in global frame
+							//dref.Set (tmul (v->GRot(), mul (*grot, dock[j]->ref) + *gpos - v->GPos())); // my dock in the target's frame
+							double d = gref.dist(vref); //dref.dist (v->dock[k]->ref);
+							if (d < MIN_DOCK_DIST) {
+								if (dotp (s0->vel - v->GVel(), vref-gref) >= 0) { // on approach
+									dock[j]->pending = v;
+								} else if (dock[j]->pending == v) {
 									if (dock[j]->autodock && v->dock[k]->autodock)
 										Dock (v, j, k);
 								}
 							}
-						} else { // new docking mode
-							for (k = 0; k < v->ndock; k++) { // loop over other vessel's docks
-								if (v->dock[k]->mate) continue; // dock already busy
-								gref.Set (mul (s0->R, dock[j]->ref) + s0->pos);            // my dock in global frame
-								vref.Set (mul (v->GRot(), v->dock[k]->ref) + v->GPos()); // target dock in global frame
-								//dref.Set (tmul (v->GRot(), mul (*grot, dock[j]->ref) + *gpos - v->GPos())); // my dock in the target's frame
-								double d = gref.dist(vref); //dref.dist (v->dock[k]->ref);
-								if (d < MIN_DOCK_DIST) {
-									if (dotp (s0->vel - v->GVel(), vref-gref) >= 0) { // on approach
-										dock[j]->pending = v;
-									} else if (dock[j]->pending == v) {
-										if (dock[j]->autodock && v->dock[k]->autodock)
-											Dock (v, j, k);
-									}
-								}
-							}
 						}
 					}
-					// update information about closest dock in range of our dock 0
+				}
+				// update information about closest dock in range of our dock 0
+				if (!closeupdated) {
 					if (closedock.vessel && closedock.vessel->ndock && closedock.dock < closedock.vessel->ndock) {
 						dref.Set (tmul (closedock.vessel->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - closedock.vessel->GPos()));
 						closedock.dist = dref.dist (closedock.vessel->dock[closedock.dock]->ref);
 					} else {
 						closedock.dist = 1e50;
 					}
-					for (k = 0; k < v->ndock; k++) {
-						if (v->dock[k]->mate) continue;
-						dref.Set (tmul (v->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - v->GPos()));
-						double d = dref.dist (v->dock[k]->ref);
-						if (d < closedock.dist) {
-							closedock.dist = d;
-							closedock.vessel = v;
-							closedock.dock = k;
-						}
+					closeupdated = true;
+				}
+				for (k = 0; k < v->ndock; k++) {
+					if (v->dock[k]->mate) continue;
+					dref.Set (tmul (v->GRot(), mul (s0->R, dock[0]->ref) + s0->pos - v->GPos()));
+					double d = dref.dist (v->dock[k]->ref);
+					if (d < closedock.dist) {
+						closedock.dist = d;
+						closedock.vessel = v;
+						closedock.dock = k;
 					}
 				}
 			}
@@ -5197,19 +5378,10 @@ void Vessel::UpdateProxies ()
 {
 	VesselBase::UpdateProxies ();
 
-	int i;
-	double dist2, proxydist2;
-
 	// check for closest vessel
-	proxyvessel = 0;
-	for (i = g_psys->nVessel()-1, proxydist2 = 1e100; i >= 0; i--) {
-		Vessel *vessel = g_psys->GetVessel(i);
-		if (vessel == this) continue;
-		if ((dist2 = s0->pos.dist2 (vessel->GPos())) < proxydist2) {
-			proxydist2 = dist2;
-			proxyvessel = vessel;
-		}
-	}
+	std::vector<Vessel*> nearest;
+	g_psys->NearestVessels (s0->pos, 1, nearest, this);
+	proxyvessel = (nearest.size() ? nearest[0] : 0);
 }
 
 void Vessel::UpdateReceiverStatus (DWORD idx)
@@ -5278,34 +5450,34 @@ void Vessel::UpdateReceiverStatus (DWORD idx)
 	}
 
 	// scan for vessel-mounted XPDR and IDS transmitters
-	for (i = g_psys->nVessel()-1; i >= 0; i--) {
-		Vessel *vessel = g_psys->GetVessel(i);
-		if (vessel == this) continue;
-		if ((dist2 = s0->pos.dist2 (vessel->GPos())) < 1e12) { // max XPDR range 1000 km
-
-			for (n = n0; n < n1; n++) {
-				if (vessel->xpdr && vessel->xpdr->GetStep() == nav[n].step) {
-					sig = vessel->xpdr->FieldStrength (s0->pos);
-					if (sig > 0.9 && sig > navsig[n]) {
-						navsig[n] =  sig;
-						nav[n].sender = vessel->xpdr;
-					}
+	static std::vector<Vessel*> vlist;
+	vlist.clear();
+	g_psys->VesselsInRange (s0->pos, 1e6, vlist, this); // max XPDR range 1000 km
+	for (auto it = vlist.begin(); it != vlist.end(); it++) {
+		Vessel *vessel = *it;
+		dist2 = s0->pos.dist2 (vessel->GPos());
+		for (n = n0; n < n1; n++) {
+			if (vessel->xpdr && vessel->xpdr->GetStep() == nav[n].step) {
+				sig = vessel->xpdr->FieldStrength (s0->pos);
+				if (sig > 0.9 && sig > navsig[n]) {
+					navsig[n] =  sig;
+					nav[n].sender = vessel->xpdr;
 				}
 			}
+		}
 
-			if (dist2 < 1e10) { // max IDS range 100 km
-				for (j = (int)vessel->nDock()-1; j >= 0; j--) {
-					const PortSpec *ps = vessel->GetDockParams (j);
-					if (ps->ids) {
-						for (n = n0; n < n1; n++)
-							if (ps->ids->GetStep() == nav[n].step) {
-								sig = ps->ids->FieldStrength (s0->pos);
-								if (sig > 0.9 && sig > navsig[n]) {
-									navsig[n] = sig;
-									nav[n].sender = ps->ids;
-								}
+		if (dist2 < 1e10) { // max IDS range 100 km
+			for (j = (int)vessel->nDock()-1; j >= 0; j--) {
+				const PortSpec *ps = vessel->GetDockParams (j);
+				if (ps->ids) {
+					for (n = n0; n < n1; n++)
+						if (ps->ids->GetStep() == nav[n].step) {
+							sig = ps->ids->FieldStrength (s0->pos);
+							if (sig > 0.9 && sig > navsig[n]) {
+								navsig[n] = sig;
+								nav[n].sender = ps->ids;
 							}
-					}
+						}
 				}
 			}
 		}
@@ -7227,6 +7399,7 @@ void VESSEL::SetBankMomentScale (double scale) const
 void VESSEL::SetPMI (const VECTOR3 &pmi) const
 {
 	vessel->pmi.Set (pmi.x, pmi.y, pmi.z);
+	if (vessel->supervessel) vessel->supervessel->NotifyPMIChange (vessel);
 }
 
 void VESSEL::SetAlbedoRGB (const VECTOR3 &albedo) const
@@ -7548,6 +7721,16 @@ bool VESSEL::GetSuperstructureCG (VECTOR3 &cg) const
 	return ok;
 }
 
+bool VESSEL::GetSuperstructurePMI (VECTOR3 &pmi) const
+{
+	Vector vpmi;
+	bool ok = vessel->GetSuperStructPMI (vpmi);
+	pmi.x = vpmi.x;
+	pmi.y = vpmi.y;
+	pmi.z = vpmi.z;
+	return ok;
+}
+
 void VESSEL::SetTouchdownPoints (const VECTOR3 &pt1, const VECTOR3 &pt2, const VECTOR3 &pt3) const
 {
 	TOUCHDOWNVTX tdvtx[3];
@@ -8557,6 +8740,11 @@ void VESSEL::EditAirfoil (AIRFOILHANDLE hAirfoil, DWORD flag, const VECTOR3 &ref
 	vessel->EditAirfoil ((AirfoilSpec*)hAirfoil, flag, MakeVector(ref), cf, c, S, A);
 }
 
+bool VESSEL::TabulateAirfoil (AIRFOILHANDLE hAirfoil, bool tabulate) const
+{
+	return vessel->TabulateAirfoil ((AirfoilSpec*)hAirfoil, tabulate);
+}
+
 bool VESSEL::DelAirfoil (AIRFOILHANDLE hAirfoil) const
 {
 	return vessel->DelAirfoil ((AirfoilSpec*)hAirfoil);
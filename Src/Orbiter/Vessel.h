@@ -23,6 +23,8 @@
 
 #include <array>
 #include <fstream>
+#include <memory>
+#include <string>
 
 #include "Vesselbase.h"
 #include "Log.h"
@@ -43,6 +45,8 @@ class oapi::Sketchpad;
 class LightEmitter;
 class Select;
 class InputBox;
+class FlightRecordWriter;
+class AirfoilTable;
 struct MFDMODE;
 
 typedef char Str64[64];
@@ -113,6 +117,7 @@ typedef struct {      // airfoil definition
 	double c;             //   airfoil chord length
 	double S;             //   reference area (wing)
 	double A;             //   aspect ratio (b^2/S with wingspan b)
+	std::shared_ptr<const AirfoilTable> table; // tabulated coefficients replacing cf, if set
 } AirfoilSpec;
 
 typedef struct {      // airfoil control surface definition
@@ -821,6 +826,11 @@ public:
 	void EditAirfoil (AirfoilSpec *af, DWORD flag, const Vector &ref, AirfoilCoeffFunc cf, double c, double S, double A);
 	// Edit an existing airfoil definition
 
+	bool TabulateAirfoil (AirfoilSpec *af, bool tabulate = true);
+	// Replace the coefficient callback of an airfoil with a tabulated
+	// version (or revert to the callback if tabulate == false). Returns
+	// false if the airfoil type does not support tabulation.
+
 	bool DelAirfoil (AirfoilSpec *af);
 	// Delete an airfoil. Returns false on failure.
 
@@ -1128,6 +1138,18 @@ public:
 	// Keyboard handler for buffered keys
 
 	void Update (bool force = false);
+
+	bool CanPropagateConcurrent () const;
+	// Returns true if the vessel's dynamic state for the current step depends only
+	// on the frozen celestial states and its own state (free flight, no attachments,
+	// composite structure, playback or possible surface contact). Such vessels can be
+	// propagated concurrently with PropagateConcurrent.
+
+	void PropagateConcurrent (bool force = false);
+	// Dynamic state propagation (s0->s1) for the concurrent update phase. Must only
+	// be called for vessels for which CanPropagateConcurrent returned true, before
+	// Update is called for the current step. Does not call any module callbacks.
+
 	void UpdatePassive ();
 	void UpdateAttachments();
 	void UpdateBodyForces ();
@@ -1137,7 +1159,15 @@ public:
 	void UpdateAerodynamicForces_OLD ();
 	bool AddSurfaceForces (Vector *F, Vector *M,
 		const StateVectors *s=NULL, double tfrac=1.0, double dt=0.0,
-		bool allow_groundcontact=true) const;
+		bool allow_groundcontact=true, const double *tdrad=NULL, const double *tdelev=NULL) const;
+	// tdrad, tdelev: if provided, radial distances of the touchdown points as
+	// returned by TouchdownCoords, and surface elevations under them (from
+	// ElevationManager::ElevationBatch, or NULL for none). Otherwise both are
+	// calculated by the vessel.
+
+	void TouchdownCoords (const StateVectors &s, const StateVectors &ps, double *lng, double *lat, double *rad) const;
+	// Equatorial coordinates of the touchdown points for vessel state s and
+	// proxy body state ps (arrays of length ntouchdown_vtx)
 
 	void PostUpdate ();
 	// called after all vessels have been updated (i.e. states are synced)
@@ -1198,6 +1228,11 @@ public:
 	// superstructure CG in vessel coordinates and return true.
 	// Otherwise: set 'cg' to (0,0,0) and return false
 
+	bool GetSuperStructPMI (Vector &pmi) const;
+	// If vessel is part of a superstructure: set 'pmi' to the superstructure
+	// moments of inertia (mass-normalised) about its CG for the vessel axes and
+	// return true. Otherwise: set 'pmi' to (0,0,0) and return false
+
 	inline const SurfParam *GetSurfParam () const
 	{ return (attach ? attach->mate->GetSurfParam() : proxybody ? &sp : 0); }
 	// return parameters referring to the vessel's position w.r.t. the
@@ -1285,6 +1320,11 @@ public:
 	// read/write vessel status from/to stream
 
 protected:
+	bool CanCoastConic () const override;
+	// Returns true if the vessel is in free flight, outside any atmosphere and
+	// clear of the surface, and no thrust or other non-gravitational forces act
+	// on it during the current step (analytic conic coasting is allowed)
+
 	bool OpenConfigFile (std::ifstream &cfgfile) const;
 	// returns configuration file for the vessel
 	// This first looks in Config\Vessels, then in Config
@@ -1299,6 +1339,10 @@ protected:
 	// true if nongravitational force (thruster, atmospheric effect, user force, etc)
 	// is present at current time step
 
+	bool bPropagated;
+	// true if the dynamic state for the current step has already been propagated
+	// in the concurrent update phase
+
 	//bool bOrbitStabilised;
 	// true if we use 2-body orbit stabilisation
 
@@ -1378,6 +1422,10 @@ protected:
 	void ReadGenericCaps (std::ifstream &ifs);
 	// read generic vessel caps from a class cfg file
 
+	void TabulateAirfoils ();
+	// replace the coefficient callbacks of all airfoils with tables, loaded
+	// from airfoilTableFile if available, otherwise sampled from the callbacks
+
 	UINT AddMesh (const char *mname, const VECTOR3 *ofs = 0);
 	// add a mesh with offset to the list (load from file). Return value is mesh index
 
@@ -1596,6 +1644,8 @@ private:
 	double CWz[2], CWx, CWy;     // wind resistance form factors (forward/backward,vert,side)
 	double wingfactor;           // aspect ratio * effectiveness factor // OBSOLETE
 	double wingaspect, wingeff;  // wing form factors
+	bool bTabulateAirfoils;      // replace airfoil coefficient callbacks by tables
+	std::string airfoilTableFile; // file for precomputed airfoil tables (relative to Config)
 	double pitch_moment_scale;   // scale factor for pitch moment
 	double bank_moment_scale;    // scale factor for bank moment
 	double mu, mu_lng;           // default touchdown friction coeffs in lateral and longitudinal directions
@@ -1616,6 +1666,8 @@ private:
 
 	double E0_comp;              // compression energy due to surface impact at current time step
 	mutable double E_comp;       // compression energy due to surface impact after last AddSurfaceForces call
+	mutable std::vector<double> tdwork; // work arrays of AddSurfaceForces (8 x ntouchdown_vtx)
+	mutable std::vector<int> tdidx;     // touchdown point index work array of AddSurfaceForces
 
 	double vd_forw, vd_back, vd_vert, vd_side;  // resistance constants against translation in atmosphere
 
@@ -1637,10 +1689,10 @@ private:
 
 	Vessel *proxyvessel;      // closest vessel
 	SuperVessel *supervessel; // vessel superstructure (docking complex)
+	mutable DWORD svcomp;     // index in the supervessel component list (lookup hint)
 	Base    *landtgt;         // landing target (base)
 	int   lstatus;            // landing/docking comms status (0=no contact, 1=contact,
 	DWORD nport;              // allocated landing pad/docking port no (>=0, (DWORD)-1=none)
-	UINT  scanvessel;         // next vessel to check for docking event
 
 	mutable bool surfprm_valid;
 	bool pyp_valid;
@@ -1730,7 +1782,8 @@ private:
 	// Flight recorder routines (should be a class!)
 
 private:
-	std::ifstream *FRatc_stream;
+	std::istream *FRatc_stream;
+	FlightRecordWriter *FRwriter; // binary stream writer (0 for text streams)
 
 	bool bRequestPlayback;
 	bool bFRplayback;
@@ -1784,6 +1837,9 @@ private:
 	bool FRecorder_Read (const char *fname);
 	// read playback sample list from file
 
+	bool FRecorder_ReadBinary (const char *fname);
+	// read playback sample list from a binary flight record
+
 	void FRecorder_Play ();
 	// set vessel status from playback sample list
 
@@ -0,0 +1,193 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class VesselIndex
+// =======================================================================
+
+#include "VesselIndex.h"
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+static const int KEYBITS = 21;                          // bits per cell coordinate
+static const int64_t KEYMAX = ((int64_t)1 << (KEYBITS-1)) - 1; // max. cell coordinate
+static const double GROUPCELLS = (double)(1 << (KEYBITS-2)); // max. cells from reference to farthest vessel
+
+VesselIndex::VesselIndex (double cellsize)
+{
+	cellsize0 = cellsize;
+	sizemax = 0.0;
+	valid = true;
+}
+
+void VesselIndex::Clear ()
+{
+	entry.clear();
+	cell.clear();
+	group.clear();
+	sizemax = 0.0;
+	valid = true;
+}
+
+void VesselIndex::Add (Vessel *v, const Body *ref, const Vector &refpos, const Vector &gpos, double size)
+{
+	int g;
+	for (g = 0; g < (int)group.size(); g++)
+		if (group[g].ref == ref) break;
+	if (g == (int)group.size()) {
+		Group grp;
+		grp.ref = ref;
+		grp.refpos = refpos;
+		grp.rmax = 0.0;
+		grp.cellsize = cellsize0;
+		grp.c0 = grp.c1 = 0;
+		group.push_back (grp);
+	}
+	Entry e;
+	e.pos = gpos - group[g].refpos;
+	e.v = v;
+	e.key = 0;
+	e.group = g;
+	entry.push_back (e);
+	group[g].rmax = max (group[g].rmax, e.pos.length());
+	sizemax = max (sizemax, size);
+}
+
+void VesselIndex::Finalise ()
+{
+	// grow the cells of groups that extend far from their reference, so
+	// that all cell coordinates fit into the key
+	for (auto it = group.begin(); it != group.end(); it++)
+		it->cellsize = max (cellsize0, it->rmax / GROUPCELLS);
+
+	int64_t idx[3];
+	for (auto it = entry.begin(); it != entry.end(); it++) {
+		Key (it->pos, group[it->group].cellsize, idx);
+		it->key = Key (idx);
+	}
+	sort (entry.begin(), entry.end(), [](const Entry &a, const Entry &b) {
+		return a.group < b.group || (a.group == b.group && a.key < b.key);
+	});
+
+	cell.clear();
+	for (int i = 0; i < (int)entry.size(); i++) {
+		if (!i || entry[i].group != entry[i-1].group || entry[i].key != entry[i-1].key) {
+			if (!i || entry[i].group != entry[i-1].group)
+				group[entry[i].group].c0 = (int)cell.size();
+			Cell c = {entry[i].key, i, i};
+			cell.push_back (c);
+		}
+		cell.back().i1 = i+1;
+		group[entry[i].group].c1 = (int)cell.size();
+	}
+	valid = true;
+}
+
+void VesselIndex::Key (const Vector &pos, double cellsize, int64_t idx[3]) const
+{
+	for (int i = 0; i < 3; i++) {
+		double c = floor (pos.data[i] / cellsize);
+		idx[i] = (c < -KEYMAX ? -KEYMAX : c > KEYMAX ? KEYMAX : (int64_t)c);
+	}
+}
+
+uint64_t VesselIndex::Key (const int64_t idx[3]) const
+{
+	const uint64_t mask = ((uint64_t)1 << KEYBITS) - 1;
+	return (((uint64_t)(idx[0] + KEYMAX) & mask) << (2*KEYBITS)) |
+	       (((uint64_t)(idx[1] + KEYMAX) & mask) << KEYBITS) |
+	        ((uint64_t)(idx[2] + KEYMAX) & mask);
+}
+
+void VesselIndex::Collect (const Group &g, const Vector &rpos, double r, const Vessel *exclude,
+	vector<Candidate> &res) const
+{
+	double r2 = r*r;
+	int64_t lo[3], hi[3], idx[3];
+	Key (rpos - Vector (r,r,r), g.cellsize, lo);
+	Key (rpos + Vector (r,r,r), g.cellsize, hi);
+	double nbox = (double)(hi[0]-lo[0]+1) * (double)(hi[1]-lo[1]+1) * (double)(hi[2]-lo[2]+1);
+
+	auto test = [&](int i0, int i1) {
+		for (int i = i0; i < i1; i++) {
+			const Entry &e = entry[i];
+			if (e.v == exclude) continue;
+			double d2 = e.pos.dist2 (rpos);
+			if (d2 <= r2) {
+				Candidate c = {d2, e.v};
+				res.push_back (c);
+			}
+		}
+	};
+
+	if (nbox > g.c1 - g.c0) {
+		// search box spans more cells than the group occupies: test all vessels
+		test (cell[g.c0].i0, cell[g.c1-1].i1);
+	} else {
+		auto c0 = cell.begin() + g.c0, c1 = cell.begin() + g.c1;
+		for (idx[0] = lo[0]; idx[0] <= hi[0]; idx[0]++)
+			for (idx[1] = lo[1]; idx[1] <= hi[1]; idx[1]++)
+				for (idx[2] = lo[2]; idx[2] <= hi[2]; idx[2]++) {
+					uint64_t key = Key (idx);
+					auto c = lower_bound (c0, c1, key, [](const Cell &a, uint64_t k) { return a.key < k; });
+					if (c != c1 && c->key == key) test (c->i0, c->i1);
+				}
+	}
+}
+
+size_t VesselIndex::InRange (const Vector &gpos, double r, vector<Vessel*> &list, const Vessel *exclude) const
+{
+	cand.clear();
+	for (auto it = group.begin(); it != group.end(); it++) {
+		if (it->c0 == it->c1) continue;
+		Vector rpos (gpos - it->refpos);
+		if (rpos.length() - it->rmax > r) continue; // group out of range
+		Collect (*it, rpos, r, exclude, cand);
+	}
+	for (auto it = cand.begin(); it != cand.end(); it++)
+		list.push_back (it->v);
+	return cand.size();
+}
+
+size_t VesselIndex::Nearest (const Vector &gpos, size_t k, vector<Vessel*> &list, const Vessel *exclude,
+	vector<double> *dist) const
+{
+	if (!k) return 0;
+
+	// visit the groups in order of their minimum possible distance
+	vector<pair<double,int> > order;
+	for (int g = 0; g < (int)group.size(); g++)
+		if (group[g].c0 < group[g].c1)
+			order.push_back (make_pair (max (0.0, gpos.dist (group[g].refpos) - group[g].rmax), g));
+	sort (order.begin(), order.end());
+
+	cand.clear();
+	for (auto it = order.begin(); it != order.end(); it++) {
+		if (cand.size() >= k && it->first*it->first >= cand.back().d2)
+			break; // no vessel in this or any later group can be closer
+
+		// expand the search radius until the group yields k vessels
+		// or is covered completely
+		const Group &g = group[it->second];
+		Vector rpos (gpos - g.refpos);
+		double rcover = rpos.length() + g.rmax;
+		size_t n0 = cand.size();
+		for (double r = g.cellsize;; r *= 4.0) {
+			cand.resize (n0);
+			Collect (g, rpos, min (r, rcover), exclude, cand);
+			if (cand.size() - n0 >= k || r >= rcover) break;
+		}
+
+		// keep the k closest, sorted
+		sort (cand.begin(), cand.end());
+		if (cand.size() > k) cand.resize (k);
+	}
+
+	for (auto it = cand.begin(); it != cand.end(); it++) {
+		list.push_back (it->v);
+		if (dist) dist->push_back (sqrt (it->d2));
+	}
+	return cand.size();
+}
@@ -0,0 +1,99 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// Class VesselIndex
+// Spatial hash of vessel positions for proximity queries (docking,
+// transponder reception, target selection). Vessels are grouped by
+// their proxy body and sorted into the cells of a uniform grid in
+// body-relative coordinates, so that the cell size stays small near
+// each body regardless of its distance from the origin. The index is
+// rebuilt once per frame, after the vessel states have been updated;
+// positions returned by queries refer to that snapshot.
+// =======================================================================
+
+#ifndef __VESSELINDEX_H
+#define __VESSELINDEX_H
+
+#include "Vecmat.h"
+#include <vector>
+#include <stdint.h>
+
+class Body;
+class Vessel;
+
+class VesselIndex {
+public:
+	VesselIndex (double cellsize = 2e3);
+	// cellsize: edge length of the grid cells near a body [m]
+
+	void Clear ();
+	// Remove all vessels and mark the index as valid (empty)
+
+	void Add (Vessel *v, const Body *ref, const Vector &refpos, const Vector &gpos, double size);
+	// Add vessel v with global position gpos and radius size [m].
+	// ref: reference body (proxy body, may be NULL) at global position refpos.
+	// Call Finalise once all vessels have been added.
+
+	void Finalise ();
+	// Sort the vessels into the grid after a series of Add calls
+
+	inline void Invalidate () { valid = false; }
+	inline bool Valid () const { return valid; }
+	// The index becomes invalid when vessels are created or deleted, and
+	// must then be rebuilt before the next query.
+
+	inline size_t nVessel () const { return entry.size(); }
+	inline double MaxSize () const { return sizemax; }
+	// Number of indexed vessels and largest vessel radius [m]
+
+	size_t InRange (const Vector &gpos, double r, std::vector<Vessel*> &list, const Vessel *exclude = 0) const;
+	// Append all vessels within distance r [m] of global position gpos to
+	// list, in no particular order. Returns the number of vessels appended.
+
+	size_t Nearest (const Vector &gpos, size_t k, std::vector<Vessel*> &list, const Vessel *exclude = 0,
+		std::vector<double> *dist = 0) const;
+	// Append the (up to) k vessels closest to gpos to list, sorted by
+	// increasing distance. If dist is provided, the distances [m] are
+	// appended to it. Returns the number of vessels appended.
+
+private:
+	struct Entry {
+		Vector pos;          // position relative to the group reference [m]
+		Vessel *v;
+		uint64_t key;        // grid cell
+		int group;
+	};
+	struct Cell {
+		uint64_t key;
+		int i0, i1;          // range of entries in the cell
+	};
+	struct Group {
+		const Body *ref;     // reference body
+		Vector refpos;       // global reference position [m]
+		double rmax;         // max. distance of a vessel from refpos [m]
+		double cellsize;     // grid cell size [m]
+		int c0, c1;          // range of cells in the group
+	};
+	struct Candidate {
+		double d2;
+		Vessel *v;
+		bool operator< (const Candidate &c) const { return d2 < c.d2; }
+	};
+
+	void Key (const Vector &pos, double cellsize, int64_t idx[3]) const;
+	uint64_t Key (const int64_t idx[3]) const;
+	void Collect (const Group &g, const Vector &rpos, double r, const Vessel *exclude,
+		std::vector<Candidate> &res) const;
+	// Append all vessels of group g within r of group-relative position rpos
+
+	double cellsize0;        // cell size near the reference bodies
+	double sizemax;          // largest vessel radius
+	bool valid;
+	std::vector<Entry> entry;
+	std::vector<Cell> cell;
+	std::vector<Group> group;
+	mutable std::vector<Candidate> cand; // query buffer
+};
+
+#endif // !__VESSELINDEX_H
@@ -243,7 +243,22 @@ void VesselBase::PostUpdate ()
 
 void VesselBase::UpdateSurfParams ()
 {
-	if (proxybody) sp.Set (s1 ? *s1 : *s0, proxybody->s1 ? *proxybody->s1 : *proxybody->s0, proxybody, &etile, &windp);
+	if (proxybody) {
+		const StateVectors &sref = (proxybody->s1 ? *proxybody->s1 : *proxybody->s0);
+		sp.Set (s1 ? *s1 : *s0, sref, proxybody, &etile, &windp);
+
+		// queue elevation tiles along the predicted ground track
+		if (sp.alt0 < 1e5 && proxybody->Type() == OBJTP_PLANET) {
+			ElevationManager *emgr = ((Planet*)proxybody)->ElevMgr();
+			if (emgr) {
+				Vector hvel (mul (sp.L2H, tmul (sref.R, sp.groundvel_glob))); // ground velocity in local horizon frame
+				double vlng = hvel.x / (sp.rad * max (sp.clat, 1e-6));
+				double vlat = hvel.z / sp.rad;
+				int reslvl = (int)(32.0-log(max(sp.alt0,100.0))*LOG2);
+				emgr->Prefetch (sp.lat, sp.lng, vlat, vlng, reslvl);
+			}
+		}
+	}
 }
 
 // =======================================================================
@@ -347,9 +362,11 @@ void VesselBase::UpdateProxies ()
 	// check for closest spaceport and update NAV reception status
 	proxybase = 0;
 	if (proxyplanet) {
+		// compare in planet frame, where base positions are fixed
+		Vector ploc (proxyplanet->GlobalToLocal (s0->pos));
 		for (i = 0, proxydist2 = 1e100; i < proxyplanet->nBase(); i++) {
 			Base *base = (Base*)proxyplanet->GetBase(i);
-			if ((dist2 = s0->pos.dist2 (base->s0->pos)) < proxydist2) {
+			if ((dist2 = ploc.dist2 (base->PlanetPos())) < proxydist2) {
 				proxydist2 = dist2;
 				proxybase = base;
 			}
@@ -3,7 +3,10 @@
 
 #include "ZTreeMgr.h"
 #include "zlib.h"
-#include "util.h"
+#include "Profiler.h"
+
+static const size_t ZTREE_CACHE_SIZE = 64 << 20; // decompressed node cache limit per planet [bytes]
+static const size_t ZTREE_POOL_SIZE = 16 << 20;  // recycled buffer limit per planet [bytes]
 
 // =======================================================================
 // File header for compressed tree files
@@ -84,6 +87,120 @@ size_t TreeTOC::fread(DWORD size, FILE *f)
 	return ::fread(tree, sizeof(TreeNode), size, f);
 }
 
+// =======================================================================
+// Shared node cache
+
+std::shared_ptr<ZTreeCache> ZTreeCache::Get(const char *PlanetPath)
+{
+	static std::mutex registryMutex;
+	static std::unordered_map<std::string, std::weak_ptr<ZTreeCache> > registry;
+
+	std::lock_guard<std::mutex> lock(registryMutex);
+	std::weak_ptr<ZTreeCache> &entry = registry[PlanetPath];
+	std::shared_ptr<ZTreeCache> cache = entry.lock();
+	if (!cache) {
+		cache = std::make_shared<ZTreeCache>(ZTREE_CACHE_SIZE);
+		entry = cache;
+	}
+	return cache;
+}
+
+// -----------------------------------------------------------------------
+
+ZTreeCache::ZTreeCache(size_t _maxSize)
+{
+	size = 0;
+	maxSize = _maxSize;
+	poolSize = 0;
+}
+
+// -----------------------------------------------------------------------
+
+ZTreeCache::~ZTreeCache()
+{
+	// cached blocks are deleted directly, since the pool is going away
+	node.clear();
+	for (auto &p : pool)
+		for (BYTE *buf : p.second)
+			delete []buf;
+}
+
+// -----------------------------------------------------------------------
+
+ZTreeCache::Block ZTreeCache::Find(uint64_t key, DWORD *nsize)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = node.find(key);
+	if (it == node.end()) return Block();
+	lru.splice(lru.begin(), lru, it->second.lru);
+	*nsize = it->second.size;
+	return it->second.data;
+}
+
+// -----------------------------------------------------------------------
+
+ZTreeCache::Block ZTreeCache::Insert(uint64_t key, Block data, DWORD nsize)
+{
+	std::lock_guard<std::mutex> lock(mutex);
+	auto it = node.find(key);
+	if (it != node.end()) // another reader got there first
+		return it->second.data;
+	if (nsize > maxSize) return data;
+
+	lru.push_front(key);
+	Entry &entry = node[key];
+	entry.data = data;
+	entry.size = nsize;
+	entry.lru = lru.begin();
+	size += nsize;
+	while (size > maxSize) { // evict least recently used nodes
+		auto oldest = node.find(lru.back());
+		size -= oldest->second.size;
+		node.erase(oldest);
+		lru.pop_back();
+	}
+	return data;
+}
+
+// -----------------------------------------------------------------------
+
+ZTreeCache::Block ZTreeCache::Alloc(DWORD nsize)
+{
+	BYTE *buf = 0;
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		auto it = pool.find(nsize);
+		if (it != pool.end() && it->second.size()) {
+			buf = it->second.back();
+			it->second.pop_back();
+			poolSize -= nsize;
+		}
+	}
+	if (!buf) buf = new BYTE[nsize];
+
+	std::weak_ptr<ZTreeCache> owner = weak_from_this();
+	return Block(buf, [owner, nsize](BYTE *b) {
+		std::shared_ptr<ZTreeCache> cache = owner.lock();
+		if (cache) cache->Recycle(b, nsize);
+		else delete []b;
+	});
+}
+
+// -----------------------------------------------------------------------
+
+void ZTreeCache::Recycle(BYTE *buf, DWORD nsize)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (poolSize + nsize <= ZTREE_POOL_SIZE) {
+			pool[nsize].push_back(buf);
+			poolSize += nsize;
+			return;
+		}
+	}
+	delete []buf;
+}
+
 // =======================================================================
 // ZTreeMgr class: manage a single layer tree for a planet
 
@@ -105,16 +222,28 @@ ZTreeMgr::ZTreeMgr(const char *PlanetPath, Layer _layer)
 	strcpy(path, PlanetPath);
 	layer = _layer;
 	treef = 0;
-	OpenArchive();
+	hFile = INVALID_HANDLE_VALUE;
+	hMap = NULL;
+	mapData = 0;
+	indexMask = 0;
+	if (OpenArchive()) {
+		BuildIndex();
+		cache = ZTreeCache::Get(path);
+	}
 }
 
 // -----------------------------------------------------------------------
 
 ZTreeMgr::~ZTreeMgr()
 {
+	out.clear();
+	cache.reset();
 	delete []path;
 	path = NULL;
 	if (treef) fclose(treef);
+	if (mapData) UnmapViewOfFile(mapData);
+	if (hMap) CloseHandle(hMap);
+	if (hFile != INVALID_HANDLE_VALUE) CloseHandle(hFile);
 }
 
 // -----------------------------------------------------------------------
@@ -147,24 +276,96 @@ bool ZTreeMgr::OpenArchive()
 	}
 	toc.totlength = tfh.dataLength;
 
+	// node data are read from a mapped view of the archive if possible
+	MapArchive(fname);
+	if (mapData) {
+		fclose(treef);
+		treef = 0;
+	}
 	return true;
 }
 
 // -----------------------------------------------------------------------
 
-DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng)
+void ZTreeMgr::MapArchive(const char *fname)
+{
+	hFile = CreateFileA(fname, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (hFile == INVALID_HANDLE_VALUE) return;
+	LARGE_INTEGER fsize;
+	if (GetFileSizeEx(hFile, &fsize) && fsize.QuadPart >= dofs + toc.totlength) {
+		hMap = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (hMap)
+			mapData = (const BYTE*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (!mapData) { // e.g. address space exhausted: fall back to file reads
+		if (hMap) CloseHandle(hMap);
+		CloseHandle(hFile);
+		hMap = NULL;
+		hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void ZTreeMgr::BuildIndex()
+{
+	// Flatten the quadtrees below the level-4 roots into a hash table, so
+	// that Idx doesn't need to walk the tree from the root
+	DWORD n = toc.size();
+	size_t nslot = 16;
+	while (nslot < 2*(size_t)n) nslot <<= 1;
+	IndexEntry empty = { (uint64_t)-1, (DWORD)-1 };
+	index.assign(nslot, empty);
+	indexMask = nslot-1;
+
+	for (int i = 0; i < 2; i++)
+		if (rootPos4[i] != (DWORD)-1)
+			AddIndex(4, 0, i, rootPos4[i]);
+}
+
+// -----------------------------------------------------------------------
+
+void ZTreeMgr::AddIndex(int lvl, int ilat, int ilng, DWORD idx)
+{
+	// iterative traversal; tree depth is small, but node counts are large
+	struct Item { int lvl, ilat, ilng; DWORD idx; };
+	std::vector<Item> stack(1, Item{ lvl, ilat, ilng, idx });
+	while (stack.size()) {
+		Item item = stack.back();
+		stack.pop_back();
+		if (item.idx >= toc.size()) continue; // corrupt TOC
+		if (item.lvl > 4) {
+			uint64_t key = NodeKey(item.lvl, item.ilat, item.ilng);
+			size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 20) & indexMask;
+			while (index[slot].key != (uint64_t)-1 && index[slot].key != key)
+				slot = (slot+1) & indexMask;
+			index[slot].key = key;
+			index[slot].idx = item.idx;
+		}
+		for (int c = 0; c < 4; c++) {
+			DWORD cidx = toc[item.idx].child[c];
+			if (cidx != (DWORD)-1)
+				stack.push_back(Item{ item.lvl+1, item.ilat*2 + (c >> 1), item.ilng*2 + (c & 1), cidx });
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+
+DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng) const
 {
 	if (lvl <= 4) {
+		if (lvl == 4 && (ilng < 0 || ilng > 1)) return (DWORD)-1;
 		return (lvl == 1 ? rootPos1 : lvl == 2 ? rootPos2 : lvl == 3 ? rootPos3 : rootPos4[ilng]);
 	} else {
-		int plvl = lvl-1;
-		int pilat = ilat/2;
-		int pilng = ilng/2;
-		DWORD pidx = Idx(plvl, pilat, pilng);
-		if (pidx == (DWORD)-1)
-			return pidx;
-		int cidx = ((ilat&1) << 1) + (ilng&1);
-		return toc[pidx].child[cidx];
+		if (!indexMask || ilat < 0 || ilng < 0) return (DWORD)-1;
+		uint64_t key = NodeKey(lvl, ilat, ilng);
+		size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 20) & indexMask;
+		while (index[slot].key != (uint64_t)-1) {
+			if (index[slot].key == key) return index[slot].idx;
+			slot = (slot+1) & indexMask;
+		}
+		return (DWORD)-1;
 	}
 }
 
@@ -172,30 +373,41 @@ DWORD ZTreeMgr::Idx(int lvl, int ilat, int ilng)
 
 DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp)
 {
-	if (idx == (DWORD)-1) return 0; // sanity check
+	PROFILE_ZONE("ZTreeMgr::ReadData");
+	if (idx == (DWORD)-1 || idx >= toc.size()) return 0; // sanity check
 
 	DWORD esize = NodeSizeInflated(idx);
 	if (!esize) // node doesn't have data, but has descendants with data
 		return 0;
 
-	if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET))
-		return 0;
-
-	DWORD zsize = NodeSizeDeflated(idx);
-	BYTE *zbuf = new BYTE[zsize];	
-	fread(zbuf, 1, zsize, treef);
-
-	BYTE *ebuf = new BYTE[esize];
-
-	DWORD ndata = Inflate(zbuf, zsize, ebuf, esize);
-	delete []zbuf;
-	zbuf = NULL;
-
-	if (!ndata) {
-		delete []ebuf;
-		ebuf = 0;
+	uint64_t key = ((uint64_t)layer << 32) | idx;
+	DWORD ndata = 0;
+	ZTreeCache::Block data = cache->Find(key, &ndata);
+
+	if (!data) {
+		DWORD zsize = NodeSizeDeflated(idx);
+		ZTreeCache::Block ebuf = cache->Alloc(esize);
+		if (mapData) {
+			ndata = Inflate(mapData + dofs + toc[idx].pos, zsize, ebuf.get(), esize);
+		} else {
+			ZTreeCache::Block zbuf = cache->Alloc(zsize);
+			{
+				std::lock_guard<std::mutex> lock(fileMutex);
+				if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET) ||
+					fread(zbuf.get(), 1, zsize, treef) != zsize)
+					return 0;
+			}
+			ndata = Inflate(zbuf.get(), zsize, ebuf.get(), esize);
+		}
+		if (!ndata) return 0;
+		data = cache->Insert(key, ebuf, ndata);
 	}
-	*outp = ebuf;
+
+	*outp = data.get();
+	std::lock_guard<std::mutex> lock(outMutex);
+	auto &entry = out[*outp];
+	entry.first = data;
+	entry.second++;
 	return ndata;
 }
 
@@ -213,6 +425,8 @@ DWORD ZTreeMgr::Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp)
 
 void ZTreeMgr::ReleaseData(BYTE *data)
 {
-	delete []data;
-	data = NULL;
-}
\ No newline at end of file
+	std::lock_guard<std::mutex> lock(outMutex);
+	auto it = out.find(data);
+	if (it != out.end() && !--it->second.second)
+		out.erase(it);
+}
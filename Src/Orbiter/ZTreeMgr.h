@@ -11,6 +11,13 @@
 
 #include <iostream>
 #include <windows.h>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <stdint.h>
 
 // =======================================================================
 // Tree node structure
@@ -77,6 +84,47 @@ private:
 	__int64 totlength; // total data size (deflated)
 };
 
+// =======================================================================
+// Size-bounded cache of inflated tree nodes, shared by all tree managers
+// of a planet. Inflated data are allocated from a pool of recycled
+// buffers.
+
+class ZTreeCache: public std::enable_shared_from_this<ZTreeCache> {
+public:
+	typedef std::shared_ptr<BYTE> Block;
+
+	static std::shared_ptr<ZTreeCache> Get(const char *PlanetPath);
+	// return the cache for the planet at PlanetPath, creating it if necessary
+
+	ZTreeCache(size_t maxSize);
+	~ZTreeCache();
+
+	Block Find(uint64_t key, DWORD *size);
+	// return a cached node and its size, and mark it as most recently used.
+	// Returns null if the node is not cached.
+
+	Block Insert(uint64_t key, Block data, DWORD size);
+	// add a node. If the node is already cached, the cached block is returned.
+
+	Block Alloc(DWORD size);
+	// return a buffer from the pool. Released buffers go back to the pool.
+
+private:
+	void Recycle(BYTE *buf, DWORD size);
+
+	struct Entry {
+		Block data;
+		DWORD size;
+		std::list<uint64_t>::iterator lru;
+	};
+	std::mutex mutex;
+	std::unordered_map<uint64_t, Entry> node;  // cached nodes
+	std::list<uint64_t> lru;                   // node keys, most recently used first
+	std::unordered_map<DWORD, std::vector<BYTE*> > pool; // free buffers by size
+	size_t size, maxSize;                      // cached data size, limit [bytes]
+	size_t poolSize;                           // free buffer size [bytes]
+};
+
 // =======================================================================
 // ZTreeMgr class: manage a single layer tree for a planet
 
@@ -88,10 +136,12 @@ public:
 	~ZTreeMgr();
 	const TreeTOC &TOC() const { return toc; }
 
-	DWORD Idx(int lvl, int ilat, int ilng);
+	DWORD Idx(int lvl, int ilat, int ilng) const;
 	// return the array index of an arbitrary tile ((DWORD)-1: not present)
 
 	DWORD ReadData(DWORD idx, BYTE **outp);
+	// Inflated node data. The buffer may be shared with other readers
+	// and must not be modified. Release with ReleaseData.
 
 	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE **outp)
 	{ return (ilat < 0 || ilng < 0) ? 0 : ReadData(Idx(lvl, ilat, ilng), outp); }
@@ -103,13 +153,28 @@ public:
 
 protected:
 	bool OpenArchive();
+	void MapArchive(const char *fname);
+	void BuildIndex();
+	void AddIndex(int lvl, int ilat, int ilng, DWORD idx);
 	DWORD Inflate(const BYTE *inp, DWORD ninp, BYTE *outp, DWORD noutp);
 
+	static inline uint64_t NodeKey(int lvl, int ilat, int ilng)
+	{ return ((uint64_t)lvl << 56) | ((uint64_t)ilat << 28) | (uint64_t)ilng; }
+
 private:
 	char *path;
 	Layer layer;
-	FILE *treef;
+	FILE *treef;       // archive file, if it couldn't be mapped
+	std::mutex fileMutex;
+	HANDLE hFile, hMap;
+	const BYTE *mapData; // mapped archive
 	TreeTOC toc;
+	struct IndexEntry { uint64_t key; DWORD idx; };
+	std::vector<IndexEntry> index; // open-addressing hash (lvl,ilat,ilng) -> node index, for lvl > 4
+	uint64_t indexMask;
+	std::shared_ptr<ZTreeCache> cache;
+	std::mutex outMutex;
+	std::unordered_map<BYTE*, std::pair<ZTreeCache::Block, int> > out; // buffers handed out by ReadData
 	DWORD rootPos1;    // index of level-1 tile ((DWORD)-1 for not present)
 	DWORD rootPos2;    // index of level-2 tile ((DWORD)-1 for not present)
 	DWORD rootPos3;    // index of level-3 tile ((DWORD)-1 for not present)
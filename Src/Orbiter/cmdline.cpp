@@ -175,6 +175,10 @@ std::vector<::CommandLine::Key>& orbiter::CommandLine::KeyList() const
 		{ KEY_MAXSYSTIME, "maxsystime", 'T', true},
 		{ KEY_MAXSIMTIME, "maxsimtime", 't', true},
 		{ KEY_FRAMECOUNT, "maxframes", '_', true},
+		{ KEY_PROPTHREADS, "propthreads", '_', true},
+		{ KEY_EPHEMFIT, "ephemfit", '_', true},
+		{ KEY_FRCONVERT, "frconvert", '_', true},
+		{ KEY_BENCH, "bench", '_', true},
 		{ KEY_PLUGIN, "plugin", 'p', true}
 	};
 	return keyList;
@@ -182,9 +186,9 @@ std::vector<::CommandLine::Key>& orbiter::CommandLine::KeyList() const
 
 void orbiter::CommandLine::ApplyOption(const Key* key, const std::string& value)
 {
-	int res;
+	int res, i;
 	size_t s;
-	double f;
+	double f, f1, f2;
 	CFG_CMDLINEPRM& cfg = m_pOrbiter->Cfg()->CfgCmdlinePrm;
 
 	switch (key->id) {
@@ -227,6 +231,26 @@ void orbiter::CommandLine::ApplyOption(const Key* key, const std::string& value)
 		if (res == 1)
 			cfg.FrameLimit = s;
 		break;
+	case KEY_PROPTHREADS:
+		res = sscanf(value.c_str(), "%d", &i);
+		if (res == 1 && i >= 0)
+			cfg.PropThreads = i;
+		break;
+	case KEY_EPHEMFIT:
+		res = sscanf(value.c_str(), "%lf,%lf,%lf", &f1, &f2, &f);
+		if (res >= 2 && f2 > f1) {
+			cfg.EphemFitMJD0 = f1;
+			cfg.EphemFitMJD1 = f2;
+			if (res == 3 && f > 0.0)
+				cfg.EphemFitTol = f;
+		}
+		break;
+	case KEY_FRCONVERT:
+		cfg.FRConvert = value;
+		break;
+	case KEY_BENCH:
+		cfg.BenchOut = value;
+		break;
 	case KEY_PLUGIN:
 		cfg.LoadPlugins.push_back(value);
 		break;
@@ -253,6 +277,10 @@ void orbiter::CommandLine::PrintHelpAndExit() const
 	std::cout << "  --maxsystime=<t>, -T <t>: Terminate session after <t> seconds\n";
 	std::cout << "  --maxsimtime=<t>, -t <t>: Terminate session at simulation time <t>\n";
 	std::cout << "  --maxframes=<f>: Terminate session after <f> time frames\n";
+	std::cout << "  --propthreads=<n>: Use <n> threads for vessel propagation (0=auto, 1=single-threaded)\n";
+	std::cout << "  --ephemfit=<mjd0>,<mjd1>[,<tol>]: Fit ephemeris tables over the date range at session start (tolerance in m, default 1)\n";
+	std::cout << "  --frconvert=<flight>: Convert the vessel streams of recording Flights\\<flight> between text and binary format\n";
+	std::cout << "  --bench=<file>: Benchmark mode: run fixed steps and write frame timing statistics to <file> (JSON)\n";
 	std::cout << "  --plugin=<pg>, -p <pg>: Load plugin <pg> (from Modules\\Plugin\\<pg>.dll)\n";
 	std::cout << std::endl;
 
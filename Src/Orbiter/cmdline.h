@@ -74,6 +74,10 @@ namespace orbiter {
 			KEY_MAXSYSTIME,
 			KEY_MAXSIMTIME,
 			KEY_FRAMECOUNT,
+			KEY_PROPTHREADS,
+			KEY_EPHEMFIT,
+			KEY_FRCONVERT,
+			KEY_BENCH,
 			KEY_PLUGIN
 		};
 
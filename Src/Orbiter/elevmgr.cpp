@@ -5,7 +5,9 @@
 #include "Celbody.h"
 #include "Planet.h"
 #include "Orbiter.h"
+#include "Profiler.h"
 #include <filesystem>
+#include <algorithm>
 
 using std::min;
 using std::max;
@@ -14,6 +16,10 @@ static int elev_grid = 256;
 static int elev_stride = elev_grid+3;
 static int MAXLVL_LIMIT = SURF_MAX_PATCHLEVEL2 - 7;
 
+static const double PREFETCH_TIME = 30.0; // ground track prediction time for prefetching [s]
+static const int MAX_PREFETCH = 16;       // max number of track samples per Prefetch call
+static const size_t MAX_QUEUE = 64;       // max number of queued tile requests
+
 extern Orbiter *g_pOrbiter;
 extern TimeData td;
 extern char DBG_MSG[256];
@@ -68,10 +74,29 @@ ElevationManager::ElevationManager (const CelestialBody *_cbody)
 	g_pOrbiter->Cfg()->PTexPath(path, fname);
 	auto y = std::filesystem::status(path);
 	bModExists = std::filesystem::is_directory(y);
+
+	// tile index and cache
+	bLoaded = false;
+	cacheMax = (size_t)g_pOrbiter->Cfg()->CfgPRenderPrm.ElevCacheSize;
+	if (mode) {
+		ScanTileDir ();
+		if (g_pOrbiter->Cfg()->CfgPRenderPrm.bElevLoadOnThread && (dirIndex.size() || treeMgr[0]))
+			loader = std::thread (&ElevationManager::LoaderProc, this);
+	}
 }
 
 ElevationManager::~ElevationManager ()
 {
+	if (loader.joinable()) {
+		{
+			std::lock_guard<std::mutex> lock(cacheMutex);
+			bStopLoader = true;
+		}
+		loadCond.notify_one();
+		loader.join();
+	}
+	for (auto &tile : loaded)
+		if (tile.second) delete []tile.second;
 	if (local_cache) delete local_cache;
 	for (int i = 0; i < 2; i++)
 		if (treeMgr[i])
@@ -104,13 +129,11 @@ bool ElevationManager::TileIdx (double lat, double lng, int lvl, int *ilat, int
 
 bool ElevationManager::HasElevationTile(int lvl, int ilat, int ilng) const
 {
+	// Only uses the directory index and the archive table of contents,
+	// both of which are held in memory
 	if (mode) {
-		if (tilesource & 0x0001 && bDirExists) {
-			char fname[256], path[256];
-			sprintf(fname, "%s\\Elev\\%02d\\%06d\\%06d.elv", cbody->Name(), lvl, ilat, ilng);
-			g_pOrbiter->Cfg()->PTexPath(path, fname);
-			if (std::filesystem::exists(path)) return true;
-		}
+		if (dirIndex.size() && std::binary_search(dirIndex.begin(), dirIndex.end(), TileKey(lvl, ilat, ilng)))
+			return true;
 		if (treeMgr[0]) {
 			if (treeMgr[0]->Idx(lvl, ilat, ilng) != DWORD(-1)) return true;
 		}
@@ -118,6 +141,174 @@ bool ElevationManager::HasElevationTile(int lvl, int ilat, int ilng) const
 	return false;
 }
 
+void ElevationManager::ScanTileDir ()
+{
+	// Collect the tiles in the directory tree (<lvl>\\<ilat>\\<ilng>.elv), so
+	// that existence checks don't need to access the file system
+	dirIndex.clear();
+	if (tilesource & 0x0001 && bDirExists) {
+		char fname[MAX_PATH], path[MAX_PATH];
+		sprintf(fname, "%s\\Elev", cbody->Name());
+		g_pOrbiter->Cfg()->PTexPath(path, fname);
+		std::error_code ec;
+		std::filesystem::recursive_directory_iterator it(path, ec), end;
+		for (; !ec && it != end; it.increment(ec)) {
+			if (it.depth() != 2 || it->path().extension() != ".elv") continue;
+			const std::filesystem::path &p = it->path();
+			int lvl, ilat, ilng;
+			if (sscanf(p.parent_path().parent_path().filename().string().c_str(), "%d", &lvl) == 1 &&
+				sscanf(p.parent_path().filename().string().c_str(), "%d", &ilat) == 1 &&
+				sscanf(p.stem().string().c_str(), "%d", &ilng) == 1)
+				dirIndex.push_back(TileKey(lvl, ilat, ilng));
+		}
+		std::sort(dirIndex.begin(), dirIndex.end());
+	}
+}
+
+INT16 *ElevationManager::ReadTile (int lvl, int ilat, int ilng) const
+{
+	// Read a tile and apply the modifications layer. May be called from
+	// the loader thread.
+	std::lock_guard<std::mutex> lock(ioMutex);
+	INT16 *elev = LoadElevationTile (lvl, ilat, ilng, elev_res);
+	if (elev)
+		LoadElevationTile_mod (lvl, ilat, ilng, elev_res, elev);
+	return elev;
+}
+
+std::shared_ptr<INT16[]> ElevationManager::CachedTile (int lvl, int ilat, int ilng) const
+{
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	auto it = cache.find (TileKey (lvl, ilat, ilng));
+	if (it == cache.end()) return nullptr;
+	lru.splice (lru.begin(), lru, it->second.lru);
+	return it->second.data;
+}
+
+std::shared_ptr<INT16[]> ElevationManager::LoadTile (int lvl, int ilat, int ilng) const
+{
+	// Synchronous load, for tiles needed immediately
+	return InsertTile (TileKey (lvl, ilat, ilng), ReadTile (lvl, ilat, ilng));
+}
+
+std::shared_ptr<INT16[]> ElevationManager::InsertTile (uint64_t key, INT16 *data) const
+{
+	// Pass a tile through the graphics client's elevation filter and add
+	// it to the cache. Takes ownership of data. Must be called from the
+	// thread that queries the elevations.
+	int lvl = (int)(key >> 56), ilat = (int)((key >> 28) & 0xFFFFFFF), ilng = (int)(key & 0xFFFFFFF);
+	if (data) {
+		auto gc = g_pOrbiter->GetGraphicsClient();
+		if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl-4, elev_res, data);
+	}
+
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	pending.erase (key);
+	if (!data) {
+		failed.insert (key);
+		return nullptr;
+	}
+	auto it = cache.find (key);
+	if (it != cache.end()) { // loaded twice (synchronous load while queued)
+		delete []data;
+		return it->second.data;
+	}
+	lru.push_front (key);
+	CacheEntry &entry = cache[key];
+	entry.data = std::shared_ptr<INT16[]>(data);
+	entry.lru = lru.begin();
+	while (cache.size() > cacheMax) { // evict least recently used
+		cache.erase (lru.back());
+		lru.pop_back();
+	}
+	cacheGen++;
+	return entry.data;
+}
+
+bool ElevationManager::RequestTile (uint64_t key, bool urgent) const
+{
+	// Queue a tile for the loader thread. Urgent requests go to the front
+	// of the queue. Returns true if the tile is or will be loaded.
+	if (!loader.joinable()) return false;
+	std::lock_guard<std::mutex> lock(cacheMutex);
+	if (failed.count (key)) return false;
+	if (pending.count (key) || cache.count (key)) return true;
+	if (urgent) {
+		queue.push_front (key);
+		if (queue.size() > MAX_QUEUE) { // drop the most distant prefetch
+			pending.erase (queue.back());
+			queue.pop_back();
+		}
+	} else {
+		if (queue.size() >= MAX_QUEUE) return false;
+		queue.push_back (key);
+	}
+	pending.insert (key);
+	loadCond.notify_one();
+	return true;
+}
+
+void ElevationManager::ProcessLoaded () const
+{
+	std::vector<std::pair<uint64_t,INT16*>> tiles;
+	{
+		std::lock_guard<std::mutex> lock(cacheMutex);
+		tiles.swap (loaded);
+		bLoaded = false;
+	}
+	for (auto &tile : tiles)
+		InsertTile (tile.first, tile.second);
+}
+
+void ElevationManager::LoaderProc ()
+{
+	std::unique_lock<std::mutex> lock(cacheMutex);
+	for (;;) {
+		loadCond.wait (lock, [this] { return bStopLoader || !queue.empty(); });
+		if (bStopLoader) break;
+		uint64_t key = queue.front();
+		queue.pop_front();
+		lock.unlock();
+		INT16 *data = ReadTile ((int)(key >> 56), (int)((key >> 28) & 0xFFFFFFF), (int)(key & 0xFFFFFFF));
+		lock.lock();
+		loaded.push_back (std::make_pair (key, data));
+		bLoaded = true;
+	}
+}
+
+void ElevationManager::Prefetch (double lat, double lng, double vlat, double vlng, int reqlvl) const
+{
+	if (!mode || !loader.joinable()) return;
+	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+
+	// sample the predicted track at half the tile size, up to MAX_PREFETCH samples
+	double dtile = Pi / (double)(1 << reqlvl);
+	double vang = sqrt (vlat*vlat + vlng*vlng*cos(lat)*cos(lat));
+	double dist = vang*PREFETCH_TIME;
+	if (dist < 0.5*dtile) return; // tile under the vessel is requested by Elevation
+	int nstep = min (MAX_PREFETCH, (int)ceil (dist/(0.5*dtile)));
+	double dt = PREFETCH_TIME/nstep;
+	uint64_t prev = 0;
+
+	for (int i = 1; i <= nstep; i++) {
+		double plat = lat + vlat*dt*i;
+		if (plat > Pi05 || plat < -Pi05) break;
+		double plng = fmod (lng + vlng*dt*i + Pi, Pi2);
+		if (plng < 0.0) plng += Pi2;
+		plng -= Pi;
+		for (int lvl = reqlvl; lvl >= 0; lvl--) {
+			int ilat, ilng;
+			TileIdx (plat, plng, lvl, &ilat, &ilng);
+			if (HasElevationTile (lvl+4, ilat, ilng)) {
+				uint64_t key = TileKey (lvl+4, ilat, ilng);
+				if (key != prev && !RequestTile (key, false)) return; // queue full
+				prev = key;
+				break;
+			}
+		}
+	}
+}
+
 INT16 *ElevationManager::LoadElevationTile (int lvl, int ilat, int ilng, double tgt_res) const
 {
 	INT16 *elev = 0;
@@ -318,186 +509,200 @@ bool ElevationManager::LoadElevationTile_mod (int lvl, int ilat, int ilng, doubl
 // lat(PI) = North pole, lat(-PI) = South Pole
 // lng(-PI) = 180deg West, lng(PI) = 180deg East
 
-double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vector<ElevationTile> *tilecache, Vector *normal, int *reslvl) const
+ElevationTile *ElevationManager::FindTile (double lat, double lng, int reqlvl, std::vector<ElevationTile> *tilecache) const
 {
-	double e = 0.0;
-	if (reslvl) *reslvl = 0;
-	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+	ElevationTile *tile;
+	int ntile = 0;
+	if (tilecache) {
+		tile = tilecache->data();
+		ntile = tilecache->size();
+	}
 
-	if (mode) {
-		ElevationTile *tile;
-		int ntile = 0;
-		if (tilecache) {
-			tile = tilecache->data();
-			ntile = tilecache->size();
-		}
+	if (!ntile) {
+		if (!local_cache) local_cache = new std::vector<ElevationTile>(8);
+		tile = local_cache->data();
+		ntile = local_cache->size();
+	}
 
-		if (!ntile) {
-			if (!local_cache) local_cache = new std::vector<ElevationTile>(8);
-			tile = local_cache->data();
-			ntile = local_cache->size();
-		}
+	int i, lvl, ilat, ilng;
+	ElevationTile *t = 0;
 
-		int i, lvl, ilat, ilng;
-		ElevationTile *t = 0;
-
-		for (i = 0; i < ntile; i++) {
-			if (tile[i].data &&
-				reqlvl == tile[i].tgtlvl && tile[i].mgr == this &&
-				lat >= tile[i].latmin && lat <= tile[i].latmax &&
-				lng >= tile[i].lngmin && lng <= tile[i].lngmax) {
-				int q = -1;
-				if (tile[i].quadrants != 0) { // Tile contain higher lvl data for some of it's quadtants
-					q = 0;
-					// Calculate quadrant being accessed
-					if (lng > (tile[i].lngmin + tile[i].lngmax) * 0.5) q += 1;
-					if (lat < (tile[i].latmin + tile[i].latmax) * 0.5) q += 2;
-					if (tile[i].quadrants & (1 << q)) continue; // Tile not usable, continue search
-				}
-				//oapiWriteLogV("CacheHit idx=%d, lvl=%d, f=0x%X, q=%d, ilat=%d, ilng=%d", i, tile[i].lvl, tile[i].quadrants, q, tile[i].ilat, tile[i].ilng);
-				t = tile + i;
-				break;
+	for (i = 0; i < ntile; i++) {
+		if (tile[i].data && tile[i].provisional && tile[i].gen != cacheGen) {
+			tile[i].Clear(); // a better tile may have arrived
+			continue;
+		}
+		if (tile[i].data &&
+			reqlvl == tile[i].tgtlvl && tile[i].mgr == this &&
+			lat >= tile[i].latmin && lat <= tile[i].latmax &&
+			lng >= tile[i].lngmin && lng <= tile[i].lngmax) {
+			int q = -1;
+			if (tile[i].quadrants != 0) { // Tile contain higher lvl data for some of it's quadtants
+				q = 0;
+				// Calculate quadrant being accessed
+				if (lng > (tile[i].lngmin + tile[i].lngmax) * 0.5) q += 1;
+				if (lat < (tile[i].latmin + tile[i].latmax) * 0.5) q += 2;
+				if (tile[i].quadrants & (1 << q)) continue; // Tile not usable, continue search
 			}
+			//oapiWriteLogV("CacheHit idx=%d, lvl=%d, f=0x%X, q=%d, ilat=%d, ilng=%d", i, tile[i].lvl, tile[i].quadrants, q, tile[i].ilat, tile[i].ilng);
+			t = tile + i;
+			break;
 		}
-		if (!t) { // correct tile not in list - need to load from file
-			t = tile;  // find oldest tile
-			for (i = 1; i < ntile; i++) 
-				if (tile[i].last_access < t->last_access)
-					t = tile+i;
-
-			if (t->data) t->Clear();
-
+	}
+	if (!t) { // correct tile not in list - take it from the tile cache, or load it
+		t = tile;  // find oldest tile
+		for (i = 1; i < ntile; i++) 
+			if (tile[i].last_access < t->last_access)
+				t = tile+i;
+
+		if (t->data) t->Clear();
+
+		// Use the best resident tile. If a better one exists, request
+		// it from the loader, and mark the tile as provisional. Without
+		// loader thread, or if no tile is resident, load synchronously.
+		std::shared_ptr<INT16[]> data;
+		bool provisional = false;
+		for (lvl = reqlvl; lvl >= 0; lvl--) {
+			TileIdx (lat, lng, lvl, &ilat, &ilng);
+			if (!HasElevationTile (lvl+4, ilat, ilng)) continue;
+			if ((data = CachedTile (lvl+4, ilat, ilng))) break;
+			if (!provisional && RequestTile (TileKey (lvl+4, ilat, ilng), true)) {
+				provisional = true;
+				continue;
+			}
+			if (!loader.joinable() && (data = LoadTile (lvl+4, ilat, ilng))) break;
+		}
+		if (!data && provisional) {
+			provisional = false;
 			for (lvl = reqlvl; lvl >= 0; lvl--) {
 				TileIdx (lat, lng, lvl, &ilat, &ilng);
-				t->data = LoadElevationTile (lvl+4, ilat, ilng, elev_res);
-				if (t->data) {
-					LoadElevationTile_mod (lvl+4, ilat, ilng, elev_res, t->data); // load modifications
-					int nlat = 1 << lvl;
-					int nlng = 2 << lvl;
-					t->mgr = this;
-					t->lvl = lvl;
-					t->ilat = ilat;
-					t->ilng = ilng;
-					t->tgtlvl = reqlvl;
-					t->latmin = (0.5-(double)(ilat+1)/double(nlat))*Pi;
-					t->latmax = (0.5-(double)ilat/double(nlat))*Pi;
-					t->lngmin = (double)ilng/(double)nlng*Pi2 - Pi;
-					t->lngmax = (double)(ilng+1)/(double)nlng*Pi2 - Pi;
-					t->quadrants = 0;
-
-					if (reqlvl > lvl) 
-					{
-						// Check if higher lvl data exists for any of the quadrants, 
-						// set flag bit to mark it dirty (un-usable)
-						int qlat = ilat * 2, qlng = ilng * 2, qlvl = lvl + 1;
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 0)) << 0; // NW
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 1)) << 1;	// NE
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 0)) << 2; // SW
-						t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 1)) << 3;	// SE
-					}
-
-					//int q = Quadrant(lat, lng, lvl);
-					//oapiWriteLogV("LoadTile[0x%X]: lvl=%d, flags=0x%X, q=%d, i(%d, %d)", t, lvl, t->quadrants, q, ilng, ilat);
+				if (HasElevationTile (lvl+4, ilat, ilng) && (data = LoadTile (lvl+4, ilat, ilng))) break;
+			}
+		}
 
-					// still need to store emin and emax
-					auto gc = g_pOrbiter->GetGraphicsClient();
-					if (gc) gc->clbkFilterElevation((OBJHANDLE)cbody, ilat, ilng, lvl, elev_res, t->data);
-					break;
-				}
+		if (data) {
+			t->data = data;
+			int nlat = 1 << lvl;
+			int nlng = 2 << lvl;
+			t->mgr = this;
+			t->lvl = lvl;
+			t->ilat = ilat;
+			t->ilng = ilng;
+			t->tgtlvl = reqlvl;
+			t->provisional = provisional;
+			t->gen = cacheGen;
+			t->latmin = (0.5-(double)(ilat+1)/double(nlat))*Pi;
+			t->latmax = (0.5-(double)ilat/double(nlat))*Pi;
+			t->lngmin = (double)ilng/(double)nlng*Pi2 - Pi;
+			t->lngmax = (double)(ilng+1)/(double)nlng*Pi2 - Pi;
+			t->quadrants = 0;
+
+			if (reqlvl > lvl && !provisional) 
+			{
+				// Check if higher lvl data exists for any of the quadrants, 
+				// set flag bit to mark it dirty (un-usable)
+				int qlat = ilat * 2, qlng = ilng * 2, qlvl = lvl + 1;
+				t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 0)) << 0; // NW
+				t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 0, qlng + 1)) << 1;	// NE
+				t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 0)) << 2; // SW
+				t->quadrants |= DWORD(HasElevationTile(qlvl + 4, qlat + 1, qlng + 1)) << 3;	// SE
 			}
-			t->lat0 = t->lng0 = t->nmlidx = -1;
+
+			//int q = Quadrant(lat, lng, lvl);
+			//oapiWriteLogV("LoadTile[0x%X]: lvl=%d, flags=0x%X, q=%d, i(%d, %d)", t, lvl, t->quadrants, q, ilng, ilat);
 		}
+		t->lat0 = t->lng0 = t->nmlidx = -1;
+	}
+	return t;
+}
+
+// Interpolation kernels, shared by Elevation and ElevationBatch.
+// eptr points to the grid node at or below/left of the sample point,
+// (wlat,wlng) are the fractional offsets from that node, and (dx,dz) the
+// grid spacing in metres in longitude and latitude direction.
+
+static inline double CatmullRom (double a_m1, double a_0, double a_p1, double a_p2, double t)
+{
+	return 0.5 * (2.0*a_0 + t*(-a_m1+a_p1) +
+		t*t*(2.0*a_m1-5.0*a_0+4.0*a_p1-a_p2) +
+		t*t*t*(-a_m1+3.0*a_0-3.0*a_p1+a_p2));
+}
+
+static inline double InterpLinear (const INT16 *eptr, double wlat, double wlng)
+{
+	double e01 = eptr[0]*(1.0-wlng) + eptr[1]*wlng;
+	double e02 = eptr[elev_stride]*(1.0-wlng) + eptr[elev_stride+1]*wlng;
+	return e01*(1.0-wlat) + e02*wlat;
+}
+
+static inline double InterpCubic (const INT16 *eptr, double wlat, double wlng)
+{
+	const INT16 *p = eptr-elev_stride;
+	double b_m1 = CatmullRom (p[-1], p[0], p[1], p[2], wlng); p += elev_stride;
+	double b_0  = CatmullRom (p[-1], p[0], p[1], p[2], wlng); p += elev_stride;
+	double b_p1 = CatmullRom (p[-1], p[0], p[1], p[2], wlng); p += elev_stride;
+	double b_p2 = CatmullRom (p[-1], p[0], p[1], p[2], wlng);
+	return CatmullRom (b_m1, b_0, b_p1, b_p2, wlat);
+}
+
+static inline Vector NormalLinear (const INT16 *eptr, double wlat, double wlng, double dx, double dz)
+{
+	double nx01 = eptr[1]-eptr[0];
+	double nx02 = eptr[elev_stride+1]-eptr[elev_stride];
+	double nx = wlat*nx02 + (1.0-wlat)*nx01;
+	Vector vnx(dx,nx,0);
+	double nz01 = eptr[elev_stride]-eptr[0];
+	double nz02 = eptr[elev_stride+1]-eptr[1];
+	double nz = wlng*nz02 + (1.0-wlng)*nz01;
+	Vector vnz(0,nz,dz);
+	return crossp(vnz,vnx).unit();
+}
+
+static inline Vector NormalCubic (const INT16 *eptr, double wlat, double wlng, double dx, double dz)
+{
+	double dex00 = 0.5*(eptr[1]-eptr[-1]);
+	double dex01 = 0.5*(eptr[2]-eptr[0]);
+	double dex10 = 0.5*(eptr[elev_stride+1]-eptr[elev_stride-1]);
+	double dex11 = 0.5*(eptr[elev_stride+2]-eptr[elev_stride]);
+	double dez00 = 0.5*(eptr[elev_stride]-eptr[-elev_stride]);
+	double dez01 = 0.5*(eptr[elev_stride*2]-eptr[0]);
+	double dez10 = 0.5*(eptr[elev_stride+1]-eptr[-elev_stride+1]);
+	double dez11 = 0.5*(eptr[elev_stride*2+1]-eptr[1]);
+	double dex = (dex00+dex10)*0.5*(1.0-wlng) + (dex01+dex11)*0.5*wlng;
+	double dez = (dez00+dez10)*0.5*(1.0-wlat) + (dez01+dez11)*0.5*wlat;
+	Vector nml (-dex, 0.5*(dx+dz), -dez);
+	nml.unify();
+	return nml;
+}
+
+double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vector<ElevationTile> *tilecache, Vector *normal, int *reslvl) const
+{
+	PROFILE_ZONE("ElevationManager::Elevation");
+	double e = 0.0;
+	if (reslvl) *reslvl = 0;
+	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+
+	if (mode) {
+		if (bLoaded) ProcessLoaded();
 
+		ElevationTile *t = FindTile (lat, lng, reqlvl, tilecache);
 		if (t->data) {
-			INT16 *elev_base = t->data+elev_stride+1; // strip padding
+			INT16 *elev_base = t->data.get()+elev_stride+1; // strip padding
 			double latidx = (lat-t->latmin) * elev_grid/(t->latmax-t->latmin);
 			double lngidx = (lng-t->lngmin) * elev_grid/(t->lngmax-t->lngmin);
 			int lat0 = (int)latidx;
 			int lng0 = (int)lngidx;
 			INT16 *eptr = elev_base + lat0*elev_stride + lng0;
-			if (mode == 1) { // linear interpolation
-				bool tri;
-				double w_lat = latidx-lat0;
-				double w_lng = lngidx-lng0;
-
-				double e01 = eptr[0]*(1.0-w_lng) + eptr[1]*w_lng;
-				double e02 = eptr[elev_stride]*(1.0-w_lng) + eptr[elev_stride+1]*w_lng;
-				e = e01*(1.0-w_lat) + e02*w_lat;
-
-				if (normal) {
-					double dlat = (t->latmax-t->latmin)/elev_grid;
-					double dlng = (t->lngmax-t->lngmin)/elev_grid;
-					double dz = dlat * cbody->Size();
-					double dx = dlng * cbody->Size() * cos(lat);
-					double nx01 = eptr[1]-eptr[0];
-					double nx02 = eptr[elev_stride+1]-eptr[elev_stride];
-					double nx = w_lat*nx02 + (1.0-w_lat)*nx01;
-					Vector vnx(dx,nx,0);
-					double nz01 = eptr[elev_stride]-eptr[0];
-					double nz02 = eptr[elev_stride+1]-eptr[1];
-					double nz = w_lng*nz02 + (1.0-w_lng)*nz01;
-					Vector vnz(0,nz,dz);
-					*normal = crossp(vnz,vnx).unit();
-				}
-			} else { // cubic spline interpolation
-				double a_m1, a_0, a_p1, a_p2, b_m1, b_0, b_p1, b_p2;
-				double tlat = latidx-lat0;
-				double tlng = lngidx-lng0;
-				a_m1 = eptr[-elev_stride-1];
-				a_0  = eptr[-elev_stride];
-				a_p1 = eptr[-elev_stride+1];
-				a_p2 = eptr[-elev_stride+2];
-				b_m1 = 0.5 * (2.0*a_0 + tlng*(-a_m1+a_p1) +
-					tlng*tlng*(2.0*a_m1-5.0*a_0+4.0*a_p1-a_p2) +
-					tlng*tlng*tlng*(-a_m1+3.0*a_0-3.0*a_p1+a_p2));
-				a_m1 = eptr[-1];
-				a_0  = eptr[0];
-				a_p1 = eptr[1];
-				a_p2 = eptr[2];
-				b_0 = 0.5 * (2.0*a_0 + tlng*(-a_m1+a_p1) +
-					tlng*tlng*(2.0*a_m1-5.0*a_0+4.0*a_p1-a_p2) +
-					tlng*tlng*tlng*(-a_m1+3.0*a_0-3.0*a_p1+a_p2));
-				a_m1 = eptr[elev_stride-1];
-				a_0  = eptr[elev_stride];
-				a_p1 = eptr[elev_stride+1];
-				a_p2 = eptr[elev_stride+2];
-				b_p1 = 0.5 * (2.0*a_0 + tlng*(-a_m1+a_p1) +
-					tlng*tlng*(2.0*a_m1-5.0*a_0+4.0*a_p1-a_p2) +
-					tlng*tlng*tlng*(-a_m1+3.0*a_0-3.0*a_p1+a_p2));
-				a_m1 = eptr[2*elev_stride-1];
-				a_0  = eptr[2*elev_stride];
-				a_p1 = eptr[2*elev_stride+1];
-				a_p2 = eptr[2*elev_stride+2];
-				b_p2 = 0.5 * (2.0*a_0 + tlng*(-a_m1+a_p1) +
-					tlng*tlng*(2.0*a_m1-5.0*a_0+4.0*a_p1-a_p2) +
-					tlng*tlng*tlng*(-a_m1+3.0*a_0-3.0*a_p1+a_p2));
-				e =	0.5 * (2.0*b_0 + tlat*(-b_m1+b_p1) +
-					tlat*tlat*(2.0*b_m1-5.0*b_0+4.0*b_p1-b_p2) +
-					tlat*tlat*tlat*(-b_m1+3.0*b_0-3.0*b_p1+b_p2));
-				if (normal) {
-					double dlat = (t->latmax-t->latmin)/elev_grid;
-					double dlng = (t->lngmax-t->lngmin)/elev_grid;
-					double dz = dlat * cbody->Size();
-					double dx = dlng * cbody->Size() * cos(lat);
-					double dex00 = 0.5*(eptr[1]-eptr[-1]);
-					double dex01 = 0.5*(eptr[2]-eptr[0]);
-					double dex10 = 0.5*(eptr[elev_stride+1]-eptr[elev_stride-1]);
-					double dex11 = 0.5*(eptr[elev_stride+2]-eptr[elev_stride]);
-					double dez00 = 0.5*(eptr[elev_stride]-eptr[-elev_stride]);
-					double dez01 = 0.5*(eptr[elev_stride*2]-eptr[0]);
-					double dez10 = 0.5*(eptr[elev_stride+1]-eptr[-elev_stride+1]);
-					double dez11 = 0.5*(eptr[elev_stride*2+1]-eptr[1]);
-					double w1_lat = latidx - lat0;
-					double w0_lat = 1.0-w1_lat;
-					double w1_lng = lngidx - lng0;
-					double w0_lng = 1.0-w1_lng;
-					double dex = (dex00+dex10)*0.5*w0_lng + (dex01+dex11)*0.5*w1_lng;
-					double dez = (dez00+dez10)*0.5*w0_lat + (dez01+dez11)*0.5*w1_lat;
-					normal->x = -dex;
-					normal->z = -dez;
-					normal->y = 0.5*(dx+dz);
-					normal->unify();
-				}
+			double w_lat = latidx-lat0;
+			double w_lng = lngidx-lng0;
+			if (mode == 1) e = InterpLinear (eptr, w_lat, w_lng); // linear interpolation
+			else           e = InterpCubic (eptr, w_lat, w_lng);  // cubic spline interpolation
+			if (normal) {
+				double dlat = (t->latmax-t->latmin)/elev_grid;
+				double dlng = (t->lngmax-t->lngmin)/elev_grid;
+				double dz = dlat * cbody->Size();
+				double dx = dlng * cbody->Size() * cos(lat);
+				*normal = (mode == 1 ? NormalLinear (eptr, w_lat, w_lng, dx, dz) : NormalCubic (eptr, w_lat, w_lng, dx, dz));
 			}
 			t->last_access = td.SysT0;
 			t->lat0 = lat0;
@@ -508,6 +713,81 @@ double ElevationManager::Elevation (double lat, double lng, int reqlvl, std::vec
 	return e*elev_res;
 }
 
+void ElevationManager::ElevationBatch (int n, const double *lat, const double *lng, double *elev, int reqlvl, std::vector<ElevationTile> *tilecache, Vector *normal) const
+{
+	// grid node and weights of each point, from the tile resolution pass
+	struct Node {
+		const INT16 *eptr; // 0: no elevation data
+		double wlat, wlng;
+		double dx, dz;     // grid spacing [m]
+	};
+	static thread_local std::vector<Node> node;
+	static thread_local std::vector<std::shared_ptr<INT16[]>> keep;
+
+	int i;
+	for (i = 0; i < n; i++) elev[i] = 0.0;
+	if (!mode || !n) return;
+	reqlvl = (reqlvl ? min (max(0,reqlvl-7), maxlvl) : maxlvl);
+	if (bLoaded) ProcessLoaded();
+
+	// Pass 1: resolve the tile of each point. Neighbouring points are
+	// usually on the same tile, so the tile of the previous point is tested
+	// first. Tiles used in the batch are kept alive in case a later point
+	// evicts them from the tile cache.
+	if (node.size() < (size_t)n) node.resize (n);
+	keep.clear();
+	ElevationTile *t = 0;
+	double latmin = 0, latmax = -1, lngmin = 0, lngmax = -1, latscale = 0, lngscale = 0, dz = 0, dx0 = 0;
+	const INT16 *elev_base = 0;
+	for (i = 0; i < n; i++) {
+		if (!(lat[i] >= latmin && lat[i] <= latmax && lng[i] >= lngmin && lng[i] <= lngmax) ||
+			(t->quadrants && t->quadrants & (1 << (int(lng[i] > (lngmin+lngmax)*0.5) + 2*int(lat[i] < (latmin+latmax)*0.5))))) {
+			t = FindTile (lat[i], lng[i], reqlvl, tilecache);
+			if (t->data) {
+				keep.push_back (t->data);
+				t->last_access = td.SysT0;
+				latmin = t->latmin, latmax = t->latmax;
+				lngmin = t->lngmin, lngmax = t->lngmax;
+				latscale = elev_grid/(latmax-latmin);
+				lngscale = elev_grid/(lngmax-lngmin);
+				dz = (latmax-latmin)/elev_grid * cbody->Size();
+				dx0 = (lngmax-lngmin)/elev_grid * cbody->Size();
+				elev_base = t->data.get()+elev_stride+1; // strip padding
+			} else {
+				node[i].eptr = 0;
+				latmin = lngmin = 0, latmax = lngmax = -1; // no tile: resolve the next point again
+				continue;
+			}
+		}
+		double latidx = (lat[i]-latmin) * latscale;
+		double lngidx = (lng[i]-lngmin) * lngscale;
+		int lat0 = (int)latidx;
+		int lng0 = (int)lngidx;
+		Node &nd = node[i];
+		nd.eptr = elev_base + lat0*elev_stride + lng0;
+		nd.wlat = latidx-lat0;
+		nd.wlng = lngidx-lng0;
+		nd.dz = dz;
+		nd.dx = (normal ? dx0 * cos(lat[i]) : 0.0);
+	}
+
+	// Pass 2: interpolation
+	if (mode == 1) {
+		for (i = 0; i < n; i++)
+			if (node[i].eptr) elev[i] = InterpLinear (node[i].eptr, node[i].wlat, node[i].wlng) * elev_res;
+		if (normal)
+			for (i = 0; i < n; i++)
+				if (node[i].eptr) normal[i] = NormalLinear (node[i].eptr, node[i].wlat, node[i].wlng, node[i].dx, node[i].dz);
+	} else {
+		for (i = 0; i < n; i++)
+			if (node[i].eptr) elev[i] = InterpCubic (node[i].eptr, node[i].wlat, node[i].wlng) * elev_res;
+		if (normal)
+			for (i = 0; i < n; i++)
+				if (node[i].eptr) normal[i] = NormalCubic (node[i].eptr, node[i].wlat, node[i].wlng, node[i].dx, node[i].dz);
+	}
+	keep.clear();
+}
+
 void ElevationManager::ElevationGrid (int ilat, int ilng, int lvl, int pilat, int pilng, int plvl, INT16 *pelev, float *elev, double *emean) const
 {
 	int i, j, nmean;
@@ -8,19 +8,26 @@
 #include "vecmat.h"
 #include "ZTreeMgr.h"
 #include <vector>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <unordered_map>
+#include <unordered_set>
+#include <stdint.h>
 
 class CelestialBody;
 
 struct ElevationTile {
 	ElevationTile() { 
-		data = nullptr;
 		Clear();
 	}
-	~ElevationTile() { if (data) delete []data; }
 
 	void Clear() { 
-		if (data) delete[]data; 
-		data = nullptr;
+		data.reset();
 		mgr = nullptr;
 		lvl = tgtlvl = 0;
 		latmin = latmax = 0.0;
@@ -32,9 +39,11 @@ struct ElevationTile {
 		quadrants = 0;
 		celldiag = false;
 		nmlidx = 0;
+		provisional = false;
+		gen = 0;
 	}
 
-	INT16 *data;
+	std::shared_ptr<INT16[]> data; // shared with the elevation manager's tile cache
 	int lvl, tgtlvl;
 	double latmin, latmax;
 	double lngmin, lngmax;
@@ -45,6 +54,8 @@ struct ElevationTile {
 	int quadrants;
 	bool celldiag;
 	int nmlidx;
+	bool provisional;  // lower resolution than available, while the requested tile is loading
+	unsigned int gen;  // cache generation at which a provisional tile was selected
 	const class ElevationManager* mgr;
 };
 
@@ -53,6 +64,35 @@ public:
 	ElevationManager (const CelestialBody *_cbody);
 	~ElevationManager();
 	double Elevation (double lat, double lng, int reqlvl=0, std::vector<ElevationTile> *tilecache = 0, Vector *normal=0, int *lvl=0) const;
+
+	/**
+	* \brief Surface elevations for a batch of points
+	* \param n number of points
+	* \param lat point latitudes [rad]
+	* \param lng point longitudes [rad]
+	* \param [out] elev elevations [m] (0 where no elevation data are available)
+	* \param reqlvl requested resolution level, as for Elevation()
+	* \param tilecache tile cache, as for Elevation()
+	* \param [out] normal if != 0, receives the surface normals, as for Elevation()
+	* \note Tiles are resolved once per run of points on the same tile, so
+	*   neighbouring points (e.g. the touchdown points of a vessel) should be
+	*   passed consecutively. The interpolation is evaluated in a separate
+	*   loop over all points.
+	*/
+	void ElevationBatch (int n, const double *lat, const double *lng, double *elev, int reqlvl=0, std::vector<ElevationTile> *tilecache = 0, Vector *normal=0) const;
+
+	/**
+	* \brief Queue the tiles along a predicted ground track for background loading
+	* \param lat current latitude [rad]
+	* \param lng current longitude [rad]
+	* \param vlat latitude rate [rad/s]
+	* \param vlng longitude rate [rad/s]
+	* \param reqlvl requested resolution level, as for Elevation()
+	* \note Tiles are prefetched for the next PREFETCH_TIME seconds (see elevmgr.cpp). Does nothing
+	*   if background loading is disabled.
+	*/
+	void Prefetch (double lat, double lng, double vlat, double vlng, int reqlvl) const;
+
 	/**
 	* \brief Synthesize an elevation tile by interpolating from the parent
 	* \param ilat latitude index of target tile
@@ -71,11 +111,30 @@ public:
 
 protected:
 	int  Quadrant(double lat, double lng, int lvl) const;
+	ElevationTile *FindTile (double lat, double lng, int reqlvl, std::vector<ElevationTile> *tilecache) const;
+	// Tile containing (lat,lng) for tile level reqlvl, from tilecache (or
+	// the local cache), the tile cache, or loaded from file
 	bool TileIdx (double lat, double lng, int lvl, int *ilat, int *ilng) const;
 	INT16 *LoadElevationTile (int lvl, int ilat, int ilng, double tgt_res) const;
 	bool LoadElevationTile_mod (int lvl, int ilat, int ilng, double tgt_res, INT16 *elev) const;
 	bool HasElevationTile(int lvl, int ilat, int ilng) const;
 
+	// Tile cache and background loader. Tiles are keyed by file level
+	// (lvl+4), ilat and ilng. The cache is bounded and evicts the least
+	// recently used tiles. Tiles are read on the loader thread, but filtered
+	// by the graphics client and inserted into the cache on the caller's
+	// thread (ProcessLoaded).
+	static inline uint64_t TileKey (int lvl, int ilat, int ilng)
+	{ return ((uint64_t)lvl << 56) | ((uint64_t)ilat << 28) | (uint64_t)ilng; }
+	void ScanTileDir ();
+	INT16 *ReadTile (int lvl, int ilat, int ilng) const;
+	std::shared_ptr<INT16[]> CachedTile (int lvl, int ilat, int ilng) const;
+	std::shared_ptr<INT16[]> LoadTile (int lvl, int ilat, int ilng) const;
+	std::shared_ptr<INT16[]> InsertTile (uint64_t key, INT16 *data) const;
+	bool RequestTile (uint64_t key, bool urgent) const;
+	void ProcessLoaded () const;
+	void LoaderProc ();
+
 private:
 	const CelestialBody *cbody;
 	int maxlvl = 0;
@@ -85,6 +144,27 @@ private:
 	ZTreeMgr *treeMgr[5];
 	bool bDirExists, bModExists;
 	mutable std::vector<ElevationTile> *local_cache = nullptr;
+
+	std::vector<uint64_t> dirIndex;      // sorted keys of the tiles in the directory tree, scanned at startup
+
+	struct CacheEntry {
+		std::shared_ptr<INT16[]> data;
+		std::list<uint64_t>::iterator lru;
+	};
+	mutable std::mutex cacheMutex;       // protects everything below, except ioMutex
+	mutable std::mutex ioMutex;          // serialises tile file access
+	mutable std::unordered_map<uint64_t,CacheEntry> cache;
+	mutable std::list<uint64_t> lru;     // cache keys, most recently used first
+	mutable std::unordered_set<uint64_t> pending; // queued or being loaded
+	mutable std::unordered_set<uint64_t> failed;  // listed in the index, but could not be read
+	mutable std::deque<uint64_t> queue;  // load requests, in order of priority
+	mutable std::vector<std::pair<uint64_t,INT16*>> loaded; // read by the loader, not yet filtered
+	mutable std::atomic<bool> bLoaded;   // loaded is not empty
+	mutable unsigned int cacheGen = 0;   // incremented when tiles are added to the cache
+	size_t cacheMax = 256;               // max number of cached tiles
+	std::condition_variable loadCond;
+	std::thread loader;
+	bool bStopLoader = false;
 };
 
 #endif // !__ELEVMGR_H
\ No newline at end of file
@@ -139,7 +139,7 @@ void LuaConsole::clbkSimulationEnd ()
 void LuaConsole::clbkPreStep (double simt, double simdt, double mjd)
 {
 	if (interp) {
-		if (interp->IsBusy() || cConsoleCmd[0] || interp->nJobs()) { // let the interpreter do some work
+		if (interp->Schedule (simt) || cConsoleCmd[0]) { // let the interpreter do some work
 			interp->EndExec();        // orbiter hands over control
 			// At this point the interpreter is performing one cycle
 			interp->WaitExec();   // orbiter waits to get back control
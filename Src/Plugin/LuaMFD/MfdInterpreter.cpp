@@ -198,7 +198,7 @@ void InterpreterList::Update (double simt, double simdt, double mjd)
 	for (i = 0; i < nlist; i++) {
 		for (j = 0; j < list[i].nenv; j++) {
 			Environment *env = list[i].env[j];
-			if (env->interp->IsBusy() || env->cmd[0] || env->interp->nJobs()) { // let the interpreter do some work
+			if (env->interp->Schedule (simt) || env->cmd[0]) { // let the interpreter do some work
 				env->interp->EndExec();
 				env->interp->WaitExec();
 			}
@@ -133,12 +133,25 @@ static void lua_pushvector(lua_State* L, const VECTOR3& vec)
 
 static int lua_isvector(lua_State* L, int idx)
 {
-	if (!lua_istable(L, idx)) return 0;
 	static char fieldname[3] = { 'x','y','z' };
 	static char field[2] = "x";
 	int i, ii, n;
 	bool fail;
 
+	if (lua_type(L, idx) == LUA_TUSERDATA) { // vector object returned by the API
+		if (!luaL_getmetafield(L, idx, "__index")) return 0;
+		lua_pop(L, 1);
+		for (i = 0; i < 3; i++) {
+			field[0] = fieldname[i];
+			lua_getfield(L, idx, field);
+			fail = !lua_isnumber(L, -1);
+			lua_pop(L, 1);
+			if (fail) return 0;
+		}
+		return 1;
+	}
+	if (!lua_istable(L, idx)) return 0;
+
 	lua_pushnil(L);
 	ii = (idx >= 0 ? idx : idx - 1);
 	n = 0;
@@ -750,6 +763,7 @@ static int lua_crosscall(lua_State* L) {
 			lua_pushnil(Ltgt);
 			break;
 		case LUA_TTABLE:
+		case LUA_TUSERDATA:
 		{
 			if (lua_isvector(L, i)) {
 				VECTOR3 v = lua_tovector(L, i);
@@ -807,6 +821,7 @@ static int lua_crosscall(lua_State* L) {
 			lua_pushnil(L);
 			break;
 		case LUA_TTABLE:
+		case LUA_TUSERDATA:
 			if (lua_isvector(Ltgt, -i)) {
 				VECTOR3 v = lua_tovector(Ltgt, -i);
 				lua_pushvector(L, v);
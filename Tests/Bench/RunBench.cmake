@@ -0,0 +1,66 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Runs a single scenario in benchmark mode and checks the report.
+#
+# Usage:
+#   cmake -DORBITER=<Orbiter_server> -DWORKDIR=<orbiter root> -DSCENARIO=<scn>
+#         -DREPORT=<json> [-DFRAMES=<n>] [-DSTEP=<s>]
+#         [-DBASELINE=<dir>] [-DTOLERANCE=<percent>] -P RunBench.cmake
+
+if(NOT ORBITER OR NOT WORKDIR OR NOT SCENARIO OR NOT REPORT)
+	message(FATAL_ERROR "ORBITER, WORKDIR, SCENARIO and REPORT must be defined")
+endif()
+if(NOT FRAMES)
+	set(FRAMES 1000)
+endif()
+if(NOT STEP)
+	set(STEP 0.1)
+endif()
+if(NOT TOLERANCE)
+	set(TOLERANCE 25)
+endif()
+
+file(REMOVE ${REPORT})
+execute_process(
+	COMMAND ${ORBITER} "--scenariox=${SCENARIO}" "--bench=${REPORT}" "--maxframes=${FRAMES}" "--fixedstep=${STEP}"
+	WORKING_DIRECTORY ${WORKDIR}
+	RESULT_VARIABLE res
+	OUTPUT_QUIET
+)
+if(NOT res EQUAL 0)
+	message(FATAL_ERROR "Orbiter_server failed on ${SCENARIO} (code ${res})")
+endif()
+if(NOT EXISTS ${REPORT})
+	message(FATAL_ERROR "No benchmark report written for ${SCENARIO}")
+endif()
+
+file(READ ${REPORT} json)
+string(JSON nframe GET "${json}" frames)
+if(NOT nframe EQUAL FRAMES)
+	message(FATAL_ERROR "Benchmark ran ${nframe} frames, expected ${FRAMES}")
+endif()
+string(JSON frame_ms GET "${json}" frame mean_ms)
+string(JSON prop_ms GET "${json}" phases Propagation mean_ms)
+# allocations are only counted in builds with ORBITER_BENCH_ALLOC
+string(JSON nalloc ERROR_VARIABLE err GET "${json}" allocations mean_per_frame)
+if(err)
+	set(nalloc "n/a")
+endif()
+message(STATUS "${nframe} frames: ${frame_ms} ms/frame (propagation ${prop_ms} ms), ${nalloc} allocations/frame")
+
+# Compare against reference report. Times are written with three
+# decimals, so they can be compared as integer microseconds.
+if(BASELINE)
+	get_filename_component(name ${REPORT} NAME)
+	if(EXISTS "${BASELINE}/${name}")
+		file(READ "${BASELINE}/${name}" ref)
+		string(JSON ref_ms GET "${ref}" frame mean_ms)
+		string(REPLACE "." "" frame_us "${frame_ms}")
+		string(REPLACE "." "" ref_us "${ref_ms}")
+		math(EXPR limit_us "${ref_us} * (100 + ${TOLERANCE}) / 100")
+		if(frame_us GREATER limit_us)
+			message(FATAL_ERROR "Mean frame time ${frame_ms} ms exceeds reference ${ref_ms} ms by more than ${TOLERANCE}%")
+		endif()
+	endif()
+endif()
@@ -0,0 +1,68 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Common scaffolding for the benchmark scripts run with cmake -P: argument
+# checks, generated scenarios and Orbiter_server runs.
+# Scripts call bench_require first; ORBITER and WORKDIR are always needed.
+
+# Abort unless all of the listed variables are defined
+function(bench_require)
+	foreach(v ${ARGN})
+		if(NOT ${v})
+			set(vars ${ARGN})
+			list(POP_BACK vars last)
+			string(REPLACE ";" ", " names "${vars}")
+			message(FATAL_ERROR "${names} and ${last} must be defined")
+		endif()
+	endforeach()
+endfunction()
+
+# Set variable var to the remaining arguments unless it is already defined
+macro(bench_default var)
+	if(NOT ${var})
+		set(${var} ${ARGN})
+	endif()
+endmacro()
+
+# Directory for generated scenarios
+set(SCN_DIR "${WORKDIR}/Scenarios/Tests/Bench")
+
+# Write a scenario fname in Earth orbit at the benchmark epoch, with ship
+# focus as the focus object and ships as the contents of the ship list.
+# An optional fourth argument names a script started with the scenario.
+function(bench_write_scenario fname focus ships)
+	file(MAKE_DIRECTORY ${SCN_DIR})
+	set(scn "BEGIN_ENVIRONMENT\n  System Sol\n  Date MJD 51982.5\n")
+	if(ARGC GREATER 3)
+		string(APPEND scn "  Script ${ARGV3}\n")
+	endif()
+	string(APPEND scn "END_ENVIRONMENT\n\n")
+	string(APPEND scn "BEGIN_FOCUS\n  Ship ${focus}\nEND_FOCUS\n\nBEGIN_SHIPS\n${ships}END_SHIPS\n")
+	file(WRITE ${fname} ${scn})
+endfunction()
+
+# Run scenario scn with Orbiter_server and the additional command line
+# arguments, and abort if it fails
+function(bench_run scn)
+	execute_process(
+		COMMAND ${ORBITER} "--scenariox=${scn}" ${ARGN}
+		WORKING_DIRECTORY ${WORKDIR}
+		RESULT_VARIABLE res
+		OUTPUT_QUIET
+	)
+	if(NOT res EQUAL 0)
+		message(FATAL_ERROR "Orbiter_server failed on ${scn} (code ${res})")
+	endif()
+endfunction()
+
+# Return the last line of Orbiter.log containing tag in result (empty if
+# there is none)
+function(bench_log_line tag result)
+	file(STRINGS "${WORKDIR}/Orbiter.log" lines REGEX "${tag}")
+	if(lines)
+		list(GET lines -1 line)
+	else()
+		set(line "")
+	endif()
+	set(${result} "${line}" PARENT_SCOPE)
+endfunction()
@@ -0,0 +1,211 @@
+#include "MsisEvaluator.h"
+
+#include <random>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+// Test inputs of the reference implementation (see DOCUMENTATION of
+// nrlmsise-00): all cases are at doy 172, 29000 s UT, 400 km, 60N 70W,
+// 16 h local time, F10.7 = 150, ap = 4, except for the parameters listed.
+struct RefCase {
+	int doy;
+	double sec, alt, lat, lng, lst, f107A, f107, ap;
+	bool aph;                 // use the 3-hourly ap array (switch 9 = -1)
+};
+
+static std::vector<RefCase> RefCases ()
+{
+	RefCase c0 = {172, 29000.0, 400.0, 60.0, -70.0, 16.0, 150.0, 150.0, 4.0, false};
+	std::vector<RefCase> c (17, c0);
+	c[1].doy = 81;
+	c[2].sec = 75000.0, c[2].alt = 1000.0;
+	c[3].alt = 100.0;
+	c[4].lat = 0.0;
+	c[5].lng = 0.0;
+	c[6].lst = 4.0;
+	c[7].f107A = 70.0;
+	c[8].f107 = 180.0;
+	c[9].ap = 40.0;
+	c[10].alt = 0.0;
+	c[11].alt = 10.0;
+	c[12].alt = 30.0;
+	c[13].alt = 50.0;
+	c[14].alt = 70.0;
+	c[15].aph = true;
+	c[16].aph = true, c[16].alt = 100.0;
+	return c;
+}
+
+// Reference output: d[0..8], t[0..1]
+static const double RefOutput[17][11] = {
+	{6.665177e+05, 1.138806e+08, 1.998211e+07, 4.022764e+05, 3.557465e+03, 4.074714e-15, 3.475312e+04, 4.095913e+06, 2.667273e+04, 1.250540e+03, 1.241416e+03},
+	{3.407293e+06, 1.586333e+08, 1.391117e+07, 3.262560e+05, 1.559618e+03, 5.001846e-15, 4.854208e+04, 4.380967e+06, 6.956682e+03, 1.166754e+03, 1.161710e+03},
+	{1.123767e+05, 6.934130e+04, 4.247105e+01, 1.322750e-01, 2.618848e-05, 2.756772e-18, 2.016750e+04, 5.741256e+03, 2.374394e+04, 1.239892e+03, 1.239891e+03},
+	{5.411554e+07, 1.918893e+11, 6.115826e+12, 1.225201e+12, 6.023212e+10, 3.584426e-10, 1.059880e+07, 2.615737e+05, 2.819879e-42, 1.027318e+03, 2.068878e+02},
+	{1.851122e+06, 1.476555e+08, 1.579356e+07, 2.633795e+05, 1.588781e+03, 4.809630e-15, 5.816167e+04, 5.478984e+06, 1.264446e+03, 1.212396e+03, 1.208135e+03},
+	{8.673095e+05, 1.278862e+08, 1.822577e+07, 2.922214e+05, 2.402962e+03, 4.355866e-15, 3.686389e+04, 3.897276e+06, 2.667273e+04, 1.220146e+03, 1.212712e+03},
+	{5.776251e+05, 6.979139e+07, 1.236814e+07, 2.492868e+05, 1.405739e+03, 2.470651e-15, 5.291986e+04, 1.069814e+06, 2.667273e+04, 1.116385e+03, 1.112999e+03},
+	{3.740304e+05, 4.782720e+07, 5.240380e+06, 1.759875e+05, 5.501649e+02, 1.571889e-15, 8.896776e+04, 1.979741e+06, 9.121815e+03, 1.031247e+03, 1.024848e+03},
+	{6.748339e+05, 1.245315e+08, 2.369010e+07, 4.911583e+05, 4.578781e+03, 4.564420e-15, 3.244595e+04, 5.370833e+06, 2.667273e+04, 1.306052e+03, 1.293374e+03},
+	{5.528601e+05, 1.198041e+08, 3.495798e+07, 9.339618e+05, 1.096255e+04, 4.974543e-15, 2.686428e+04, 4.889974e+06, 2.805445e+04, 1.361868e+03, 1.347389e+03},
+	{1.375488e+14, 0.000000e+00, 2.049687e+19, 5.498695e+18, 2.451733e+17, 1.261066e-03, 0.000000e+00, 0.000000e+00, 0.000000e+00, 1.027318e+03, 2.814648e+02},
+	{4.427443e+13, 0.000000e+00, 6.597567e+18, 1.769929e+18, 7.891680e+16, 4.059139e-04, 0.000000e+00, 0.000000e+00, 0.000000e+00, 1.027318e+03, 2.274180e+02},
+	{2.127829e+12, 0.000000e+00, 3.170791e+17, 8.506280e+16, 3.792741e+15, 1.950822e-05, 0.000000e+00, 0.000000e+00, 0.000000e+00, 1.027318e+03, 2.374389e+02},
+	{1.412184e+11, 0.000000e+00, 2.104370e+16, 5.645392e+15, 2.517142e+14, 1.294709e-06, 0.000000e+00, 0.000000e+00, 0.000000e+00, 1.027318e+03, 2.795551e+02},
+	{1.254884e+10, 0.000000e+00, 1.874533e+15, 4.923051e+14, 2.239685e+13, 1.147668e-07, 0.000000e+00, 0.000000e+00, 0.000000e+00, 1.027318e+03, 2.190732e+02},
+	{5.196477e+05, 1.274494e+08, 4.850450e+07, 1.720838e+06, 2.354487e+04, 5.881940e-15, 2.500078e+04, 6.279210e+06, 2.667273e+04, 1.426412e+03, 1.408608e+03},
+	{4.260860e+07, 1.241342e+11, 4.929562e+12, 1.048407e+12, 4.993465e+10, 2.914304e-10, 8.831229e+06, 2.252516e+05, 2.415246e-42, 1.027318e+03, 1.934071e+02},
+};
+
+static void DefaultFlags (nrlmsise_flags &flags)
+{
+	flags.switches[0] = 0;
+	for (int i = 1; i < 24; i++) flags.switches[i] = 1;
+}
+
+static double RelErr (double a, double b)
+{
+	return (b ? fabs (a/b-1.0) : fabs (a));
+}
+
+TEST_CASE("MSIS evaluator reproduces the reference test cases", "[NRLMSISE00]")
+{
+	std::vector<RefCase> cases = RefCases();
+	ap_array aph;
+	for (int i = 0; i < 7; i++) aph.a[i] = 100.0;
+	nrlmsise_flags flags;
+	DefaultFlags (flags);
+
+	for (size_t i = 0; i < cases.size(); i++) {
+		const RefCase &c = cases[i];
+		INFO("case " << i);
+		flags.switches[9] = (c.aph ? -1 : 1);
+		MsisEvaluator msis (flags.switches);
+		msis.SetEpoch (c.doy, c.sec, c.f107A, c.f107, c.ap, c.aph ? &aph : 0);
+		MsisEvaluator::Point pt = {c.alt, c.lat, c.lng, c.lst};
+		nrlmsise_output out;
+		msis.Eval (&pt, &out, 1);
+		for (int j = 0; j < 9; j++) {
+			// the published table has 7 significant digits
+			if (RefOutput[i][j] > 1e-30) CHECK(RelErr (out.d[j], RefOutput[i][j]) < 1e-6);
+			else CHECK(out.d[j] < 1e-30);
+		}
+		CHECK(RelErr (out.t[0], RefOutput[i][9]) < 1e-6);
+		CHECK(RelErr (out.t[1], RefOutput[i][10]) < 1e-6);
+
+		// the reference implementation
+		nrlmsise_input in = {0, c.doy, c.sec, c.alt, c.lat, c.lng, c.lst, c.f107A, c.f107, c.ap, c.aph ? &aph : 0};
+		nrlmsise_output ref;
+		gtd7 (&in, &flags, &ref);
+		for (int j = 0; j < 9; j++) CHECK(RelErr (out.d[j], ref.d[j]) < 1e-12);
+		for (int j = 0; j < 2; j++) CHECK(RelErr (out.t[j], ref.t[j]) < 1e-12);
+	}
+}
+
+TEST_CASE("MSIS evaluator matches gtd7 at random points", "[NRLMSISE00]")
+{
+	nrlmsise_flags flags;
+	DefaultFlags (flags);
+	MsisEvaluator msis;
+	std::mt19937 rng (1);
+	std::uniform_real_distribution<double> U (0.0, 1.0);
+
+	// several points per epoch, evaluated in one batch
+	const int nepoch = 500, npt = 8;
+	double maxerr = 0.0;
+	for (int e = 0; e < nepoch; e++) {
+		int doy = 1 + (int)(U(rng)*365.0);
+		double sec = U(rng)*86400.0, f107A = 70.0+200.0*U(rng), f107 = 70.0+200.0*U(rng), ap = 100.0*U(rng);
+		msis.SetEpoch (doy, sec, f107A, f107, ap);
+		MsisEvaluator::Point pt[npt];
+		nrlmsise_output out[npt];
+		for (int i = 0; i < npt; i++)
+			pt[i] = msis.At ((i%3 ? 1500.0 : 200.0)*U(rng), -90.0+180.0*U(rng), -180.0+360.0*U(rng));
+		msis.Eval (pt, out, npt);
+		for (int i = 0; i < npt; i++) {
+			nrlmsise_input in = {0, doy, sec, pt[i].alt, pt[i].lat, pt[i].lng, pt[i].lst, f107A, f107, ap, 0};
+			nrlmsise_output ref;
+			gtd7 (&in, &flags, &ref);
+			for (int j = 0; j < 9; j++) maxerr = std::max (maxerr, RelErr (out[i].d[j], ref.d[j]));
+			for (int j = 0; j < 2; j++) maxerr = std::max (maxerr, RelErr (out[i].t[j], ref.t[j]));
+		}
+	}
+	CHECK(maxerr < 1e-12);
+
+	// changing only UT must give the same result as a new epoch
+	MsisEvaluator msis2;
+	msis.SetEpoch (100, 1000.0, 150.0, 150.0, 4.0);
+	unsigned int id = msis.EpochId();
+	msis.SetEpoch (100, 50000.0, 150.0, 150.0, 4.0);
+	REQUIRE(msis.EpochId() == id);
+	msis2.SetEpoch (100, 50000.0, 150.0, 150.0, 4.0);
+	MsisEvaluator::Point pt = msis.At (300.0, 20.0, 45.0);
+	MsisEvaluator::Prm p1, p2;
+	msis.Eval (&pt, &p1, 1);
+	msis2.Eval (&pt, &p2, 1);
+	CHECK(p1.rho == p2.rho);
+	CHECK(p1.T == p2.T);
+}
+
+// Ground track of a 51.6 deg, 400 km orbit with a period of 92 min
+static void LeoTrack (double t, double &alt, double &lat, double &lng)
+{
+	const double PI = 3.14159265358979323846;
+	double ph = t/5520.0*2.0*PI;
+	lat = asin (sin (51.6/180.0*PI) * sin (ph)) * 180.0/PI;
+	lng = fmod (-70.0 + t/5520.0*360.0 - t/86164.0*360.0 + 540.0, 360.0) - 180.0;
+	alt = 400.0 + 15.0*sin (2.0*ph);
+}
+
+TEST_CASE("MSIS band cache error and hit rate", "[NRLMSISE00]")
+{
+	const double tol = 1e-3;
+	MsisEvaluator msis;
+	MsisBandCache cache (&msis, tol);
+	MsisEvaluator::Prm prm, ref;
+
+	// out of range
+	msis.SetEpoch (172, 29000.0, 150.0, 150.0, 4.0);
+	REQUIRE(!cache.Eval (100.0, 0.0, 0.0, prm));
+	REQUIRE(!cache.Eval (3000.0, 0.0, 0.0, prm));
+
+	// 20 min along a LEO track at 50 frames/s
+	double maxerr = 0.0;
+	size_t nq = 0;
+	for (double t = 0.0; t < 1200.0; t += 0.02) {
+		double alt, lat, lng;
+		LeoTrack (t, alt, lat, lng);
+		msis.SetEpoch (172, 29000.0+t, 150.0, 150.0, 4.0);
+		MsisEvaluator::Point pt = msis.At (alt, lat, lng);
+		msis.Eval (&pt, &ref, 1);
+		REQUIRE(cache.Eval (alt, lat, lng, prm));
+		maxerr = std::max (maxerr, std::max (RelErr (prm.rho, ref.rho), std::max (RelErr (prm.p, ref.p), RelErr (prm.T, ref.T))));
+		nq++;
+	}
+	const MsisBandCache::Stats &st = cache.GetStats();
+	CHECK(maxerr < tol);
+	CHECK(st.hit + st.miss + st.exact == nq);
+	CHECK(st.hit > 0.95*nq);
+
+	// a change of the solar indices invalidates the cache
+	msis.SetEpoch (172, 30200.0, 200.0, 200.0, 4.0);
+	double alt, lat, lng;
+	LeoTrack (1200.0, alt, lat, lng);
+	MsisEvaluator::Point pt = msis.At (alt, lat, lng);
+	msis.Eval (&pt, &ref, 1);
+	REQUIRE(cache.Eval (alt, lat, lng, prm));
+	CHECK(RelErr (prm.rho, ref.rho) < tol);
+
+	// time acceleration: every query misses, so the cache is bypassed
+	cache.Clear();
+	size_t nserved = 0;
+	for (int i = 0; i < 2000; i++) {
+		double t = i*60.0;
+		LeoTrack (t, alt, lat, lng);
+		msis.SetEpoch (172, fmod (29000.0+t, 86400.0), 150.0, 150.0, 4.0);
+		if (cache.Eval (alt, lat, lng, prm)) nserved++;
+	}
+	CHECK(cache.GetStats().bypass > 0);
+	CHECK(nserved < 1000);
+}
@@ -0,0 +1,169 @@
+#include "DxtEnc.h"
+#include "ThreadPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+using std::string;
+
+static const DxtFormat Formats[] = { DXTFMT_DXT1, DXTFMT_DXT1A, DXTFMT_DXT5 };
+static const char *FormatName[] = { "DXT1", "DXT1A", "DXT5" };
+static const DxtQuality Qualities[] = { DXTQ_FAST, DXTQ_NORMAL, DXTQ_HIGH };
+static const char *QualityName[] = { "fast", "normal", "high" };
+
+// A surface-like test image: smooth colour gradients with some noise, a
+// sharp coastline and a circular alpha mask with a soft edge
+static vector<uint8_t> TestImage (int w, int h)
+{
+	vector<uint8_t> img((size_t)w*h*4);
+	unsigned int seed = 12345;
+	for (int y = 0; y < h; y++) {
+		for (int x = 0; x < w; x++) {
+			seed = seed*1103515245 + 12345;
+			int noise = (int)((seed >> 16) & 15) - 8;
+			bool water = (x + (y*y)/64) % 97 < 40;
+			int r = (water ?  20 : 90 + x*100/w) + noise;
+			int g = (water ?  50 : 80 + y*90/h) + noise;
+			int b = (water ? 120 + x*40/w : 40) + noise/2;
+			double dx = x - 0.5*w, dy = y - 0.5*h, d = sqrt(dx*dx + dy*dy) / (0.4*w);
+			int a = (d < 0.9 ? 255 : d > 1.1 ? 0 : (int)((1.1-d) * 5.0 * 255.0));
+			uint8_t *p = img.data() + ((size_t)y*w + x)*4;
+			p[0] = (uint8_t)std::max(0, std::min(255, r));
+			p[1] = (uint8_t)std::max(0, std::min(255, g));
+			p[2] = (uint8_t)std::max(0, std::min(255, b));
+			p[3] = (uint8_t)a;
+		}
+	}
+	return img;
+}
+
+static double PSNR (const vector<uint8_t> &img, const vector<uint8_t> &dxt, int w, int h, DxtFormat fmt)
+{
+	DxtErrorStat err;
+	DxtCompare (img.data(), dxt.data(), w, h, fmt, err);
+	return err.PSNR();
+}
+
+TEST_CASE("SIMD kernels match the scalar encoder", "[DxtEnc]")
+{
+	const int w = 128, h = 128;
+	vector<uint8_t> img = TestImage (w, h);
+
+	for (int f = 0; f < 3; f++) {
+		for (int q = 0; q < 3; q++) {
+			size_t size = DxtImageSize (w, h, Formats[f]);
+			vector<uint8_t> ref(size), dxt(size);
+			DxtCompress (img.data(), w, h, Formats[f], Qualities[q], ref.data(), 0, DXTKERNEL_SCALAR);
+			for (int type = DXTKERNEL_SSE41; type <= DxtKernelSupported(); type++) {
+				INFO(DxtKernelName ((DxtKernelType)type) << ", " << FormatName[f] << ", " << QualityName[q]);
+				DxtCompress (img.data(), w, h, Formats[f], Qualities[q], dxt.data(), 0, (DxtKernelType)type);
+				REQUIRE(dxt == ref);
+			}
+		}
+	}
+}
+
+TEST_CASE("Parallel compression matches sequential compression", "[DxtEnc]")
+{
+	const int w = 256, h = 192;
+	vector<uint8_t> img = TestImage (w, h);
+	ThreadPool pool(4);
+
+	for (int f = 0; f < 3; f++) {
+		size_t size = DxtImageSize (w, h, Formats[f]);
+		vector<uint8_t> ref(size), dxt(size);
+		DxtCompress (img.data(), w, h, Formats[f], DXTQ_NORMAL, ref.data());
+		DxtCompress (img.data(), w, h, Formats[f], DXTQ_NORMAL, dxt.data(), &pool);
+		INFO(FormatName[f]);
+		REQUIRE(dxt == ref);
+	}
+}
+
+TEST_CASE("Compression quality", "[DxtEnc]")
+{
+	const int w = 256, h = 256;
+	vector<uint8_t> img = TestImage (w, h);
+	vector<uint8_t> dxt(DxtImageSize (w, h, DXTFMT_DXT1));
+
+	double psnr[3];
+	for (int q = 0; q < 3; q++) {
+		DxtCompress (img.data(), w, h, DXTFMT_DXT1, Qualities[q], dxt.data());
+		psnr[q] = PSNR (img, dxt, w, h, DXTFMT_DXT1);
+		INFO(QualityName[q] << ": " << psnr[q] << " dB");
+		CHECK(psnr[q] > 32.0);
+	}
+	CHECK(psnr[DXTQ_NORMAL] > psnr[DXTQ_FAST]);
+	CHECK(psnr[DXTQ_HIGH] >= psnr[DXTQ_NORMAL]);
+
+	// uniform blocks are reproduced exactly if the colour is representable in 5:6:5
+	vector<uint8_t> flat((size_t)w*h*4);
+	for (size_t i = 0; i < (size_t)w*h; i++)
+		flat[i*4+0] = 0x84, flat[i*4+1] = 0x82, flat[i*4+2] = 0x42, flat[i*4+3] = 255;
+	for (int q = 0; q < 3; q++) {
+		DxtCompress (flat.data(), w, h, DXTFMT_DXT1, Qualities[q], dxt.data());
+		REQUIRE(PSNR (flat, dxt, w, h, DXTFMT_DXT1) == 100.0);
+	}
+}
+
+TEST_CASE("Alpha channel", "[DxtEnc]")
+{
+	const int w = 64, h = 64;
+	vector<uint8_t> img = TestImage (w, h);
+	vector<uint8_t> dec((size_t)w*h*4);
+
+	SECTION("DXT1A preserves binary transparency") {
+		vector<uint8_t> dxt(DxtImageSize (w, h, DXTFMT_DXT1A));
+		DxtCompress (img.data(), w, h, DXTFMT_DXT1A, DXTQ_NORMAL, dxt.data());
+		DxtDecompress (dxt.data(), w, h, DXTFMT_DXT1A, dec.data());
+		for (size_t i = 0; i < (size_t)w*h; i++)
+			REQUIRE(dec[i*4+3] == (img[i*4+3] < 128 ? 0 : 255));
+		CHECK(PSNR (img, dxt, w, h, DXTFMT_DXT1A) > 32.0);
+	}
+	SECTION("DXT5 interpolates alpha") {
+		vector<uint8_t> dxt(DxtImageSize (w, h, DXTFMT_DXT5));
+		DxtCompress (img.data(), w, h, DXTFMT_DXT5, DXTQ_NORMAL, dxt.data());
+		DxtDecompress (dxt.data(), w, h, DXTFMT_DXT5, dec.data());
+		for (size_t i = 0; i < (size_t)w*h; i++)
+			REQUIRE(abs ((int)dec[i*4+3] - (int)img[i*4+3]) <= 255/14 + 1);
+	}
+}
+
+TEST_CASE("DDS files with mipmaps", "[DxtEnc]")
+{
+	// sizes that are not multiples of the block size are padded
+	const int sizes[][2] = { {256, 256}, {64, 32}, {6, 3}, {1, 1} };
+
+	for (auto &s : sizes) {
+		int w = s[0], h = s[1];
+		vector<uint8_t> img = TestImage (w, h);
+		vector<uint8_t> dds;
+		DxtErrorStat err;
+		size_t expected = 128, nlevel = 0;
+		for (int lw = w, lh = h; ; lw = std::max(1, lw/2), lh = std::max(1, lh/2)) {
+			expected += DxtImageSize (lw, lh, DXTFMT_DXT1);
+			nlevel++;
+			if (lw == 1 && lh == 1) break;
+		}
+		INFO(w << " x " << h);
+		REQUIRE(DxtMakeDDS (img.data(), w, h, DXTFMT_DXT1, DXTQ_NORMAL, true, dds, 0, &err) == expected);
+		REQUIRE(dds.size() == expected);
+		REQUIRE(memcmp (dds.data(), "DDS ", 4) == 0);
+		uint32_t hdr[31];
+		memcpy (hdr, dds.data()+4, sizeof(hdr));
+		CHECK(hdr[2] == (uint32_t)h);
+		CHECK(hdr[3] == (uint32_t)w);
+		CHECK(hdr[6] == nlevel);
+		CHECK(memcmp (hdr+20, "DXT1", 4) == 0);
+		CHECK(err.npix == (uint64_t)w*h);
+
+		// the top level is the plain compressed image
+		vector<uint8_t> dxt(DxtImageSize (w, h, DXTFMT_DXT1));
+		DxtCompress (img.data(), w, h, DXTFMT_DXT1, DXTQ_NORMAL, dxt.data());
+		REQUIRE(memcmp (dds.data()+128, dxt.data(), dxt.size()) == 0);
+	}
+}
@@ -0,0 +1,121 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Benchmark for optional engine features.
+# Runs a scenario with Orbiter_server in benchmark mode (--bench), once with
+# the feature off and once with the feature on, and reports the mean frame
+# time and, if PHASE is given, the mean time of that frame phase of both runs.
+# The feature is switched on by SETTINGS and/or FEATURE_ARGS:
+#   BASE_SETTINGS, SETTINGS: "Key = Value" lines prepended to CONFIG for both
+#     runs and for the feature run, respectively (the first occurrence of a
+#     key is used). CONFIG is restored afterwards.
+#   FEATURE_ARGS: additional command line arguments for the feature run
+#   RESTORE_ARGS: arguments for a final single-frame run that undoes changes
+#     made by FEATURE_ARGS (e.g. a flight recording conversion)
+#   CLEANUP: globs (relative to WORKDIR) of files written by the feature run,
+#     which are removed unless they existed before
+# Without SCENARIO, VESSELS ShuttlePBs are placed on low orbits of radius
+# RADIUS [m] around PLANET.
+#
+# Usage:
+#   cmake -DORBITER=<Orbiter_server> -DWORKDIR=<orbiter root> -DNAME=<name>
+#         (-DSCENARIO=<scn> | -DPLANET=<body> -DRADIUS=<m> [-DVESSELS=<n>])
+#         [-DPHASE=<phase>] [-DCONFIG=<cfg>] [-DBASE_SETTINGS=<lines>]
+#         [-DSETTINGS=<lines>] [-DFEATURE_ARGS=<args>] [-DRESTORE_ARGS=<args>]
+#         [-DCLEANUP=<globs>] [-DFRAMES=<n>] [-DSTEP=<s>] [-DREPORT_DIR=<dir>]
+#         -P FeatureBench.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/BenchCommon.cmake)
+
+bench_require(ORBITER WORKDIR NAME)
+bench_default(CONFIG Orbiter.cfg)
+bench_default(VESSELS 100)
+bench_default(FRAMES 1000)
+bench_default(STEP 0.1)
+bench_default(REPORT_DIR ${WORKDIR})
+
+if(NOT SCENARIO)
+	bench_require(PLANET RADIUS)
+	set(SCENARIO "${SCN_DIR}/Feature_${NAME}.scn")
+	set(ships "")
+	math(EXPR imax "${VESSELS} - 1")
+	foreach(i RANGE ${imax})
+		math(EXPR a "${RADIUS} + (${i} % 20) * 25000")
+		math(EXPR inc "(${i} * 7) % 90")
+		math(EXPR lan "(${i} * 37) % 360")
+		math(EXPR lng "(${i} * 53) % 360")
+		string(APPEND ships "PB-${i}:ShuttlePB\n  STATUS Orbiting ${PLANET}\n")
+		string(APPEND ships "  ELEMENTS ${a} 0.001 ${inc} ${lan} 0 ${lng} 51982.5\n")
+		string(APPEND ships "  AROT 0 0 0\n  FUEL 1.000\nEND\n")
+	endforeach()
+	bench_write_scenario(${SCENARIO} PB-0 "${ships}")
+endif()
+
+set(cfg "${WORKDIR}/${CONFIG}")
+if(EXISTS ${cfg})
+	file(READ ${cfg} cfg_orig)
+endif()
+
+# Write CONFIG with the listed lines in front of its original contents
+function(write_config)
+	string(REPLACE ";" "\n" lines "${ARGN}")
+	file(WRITE ${cfg} "${lines}\n${cfg_orig}")
+endfunction()
+
+# Return the files matching the CLEANUP globs
+function(cleanup_files result)
+	set(globs "")
+	foreach(g ${CLEANUP})
+		list(APPEND globs "${WORKDIR}/${g}")
+	endforeach()
+	set(files "")
+	if(globs)
+		file(GLOB files ${globs})
+	endif()
+	set(${result} "${files}" PARENT_SCOPE)
+endfunction()
+
+# Run the scenario in benchmark mode and return frame and phase times
+function(run_bench tag result)
+	set(report "${REPORT_DIR}/Feature_${NAME}_${tag}.json")
+	file(REMOVE ${report})
+	bench_run(${SCENARIO} "--bench=${report}" "--maxframes=${FRAMES}" "--fixedstep=${STEP}" ${ARGN})
+	if(NOT EXISTS ${report})
+		message(FATAL_ERROR "No benchmark report written for ${SCENARIO}")
+	endif()
+	file(READ ${report} json)
+	string(JSON frame_ms GET "${json}" frame mean_ms)
+	set(t "${frame_ms} ms/frame")
+	if(PHASE)
+		string(JSON phase_ms GET "${json}" phases ${PHASE} mean_ms)
+		string(APPEND t " (${PHASE} ${phase_ms} ms)")
+	endif()
+	set(${result} "${t}" PARENT_SCOPE)
+endfunction()
+
+cleanup_files(existing)
+
+write_config(${BASE_SETTINGS})
+run_bench(off t_off)
+write_config(${BASE_SETTINGS} ${SETTINGS})
+run_bench(on t_on ${FEATURE_ARGS})
+
+if(RESTORE_ARGS)
+	bench_run(${SCENARIO} "--maxframes=1" ${RESTORE_ARGS})
+endif()
+if(DEFINED cfg_orig)
+	file(WRITE ${cfg} "${cfg_orig}")
+else()
+	file(REMOVE ${cfg})
+endif()
+cleanup_files(created)
+if(existing)
+	list(REMOVE_ITEM created ${existing})
+endif()
+if(created)
+	file(REMOVE ${created})
+endif()
+
+message(STATUS "${NAME} benchmark (${FRAMES} frames)")
+message(STATUS "off: ${t_off}")
+message(STATUS "on:  ${t_on}")
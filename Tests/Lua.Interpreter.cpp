@@ -1,6 +1,8 @@
 #include "Interpreter.h"
 
 #include <memory>
+#include <string.h>
+#include <string>
 
 // these collide with std::min/max
 #undef min
@@ -27,3 +29,140 @@ TEST_CASE("Create and test Lua interpreter", "[LuaInterpreter]" )
 	lua_getglobal(L, "a");
 	REQUIRE(lua_tointeger(L, -1) == 4);
 };
+
+static int Run (Interpreter *interp, const char *script)
+{
+	return interp->RunChunk (script, (int)strlen (script));
+}
+
+// Vectors and matrices returned by the API are userdata with operators;
+// table arguments are still accepted everywhere
+TEST_CASE("Vector and matrix userdata", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	auto L = interp->GetState();
+
+	REQUIRE(Run (interp.get(),
+		"a = vec.set(1,2,3)\n"
+		"b = a + _V(1,1,1)\n"
+		"c = 2*a - b/2\n"
+		"d = -a\n"
+		"a.z = 5\n"
+		"e = vec.crossp(_V(1,0,0), vec.set(0,1,0))\n"
+		"eq = (vec.set(1,2,3) == vec.set(1,2,3))\n"
+		"s = tostring(b)\n") == 0);
+
+	lua_getglobal (L, "a");
+	REQUIRE(lua_isuserdata (L, -1));
+	VECTOR3 a = lua_tovector (L, -1);
+	REQUIRE((a.x == 1.0 && a.y == 2.0 && a.z == 5.0));
+	lua_getglobal (L, "c");
+	VECTOR3 c = lua_tovector (L, -1);
+	REQUIRE((c.x == 1.0 && c.y == 2.5 && c.z == 4.0));
+	lua_getglobal (L, "d");
+	REQUIRE(lua_tovector (L, -1).y == -2.0);
+	lua_getglobal (L, "e");
+	REQUIRE(lua_tovector (L, -1).z == 1.0);
+	lua_getglobal (L, "eq");
+	REQUIRE(lua_toboolean (L, -1));
+	lua_getglobal (L, "s");
+	REQUIRE(std::string (lua_tostring (L, -1)) == "[2 3 4]");
+	lua_settop (L, 0);
+
+	// in-place operations write into the first argument, tables included
+	REQUIRE(Run (interp.get(),
+		"out = vec.set(0,0,0)\n"
+		"res = vec.add_to(out, vec.set(1,2,3), 1)\n"
+		"same = rawequal(out, res)\n"
+		"t = {x=0,y=0,z=0}\n"
+		"vec.crossp_to(t, _V(0,1,0), _V(0,0,1))\n"
+		"R = mat.rotm(_V(0,0,1), math.pi/2)\n"
+		"p = R * _V(1,0,0)\n"
+		"mat.tmul_to(out, R, p)\n"
+		"RR = mat.identity()\n"
+		"mat.mmul_to(RR, R, R)\n"
+		"m = RR.m11\n") == 0);
+	lua_getglobal (L, "same");
+	REQUIRE(lua_toboolean (L, -1));
+	lua_getglobal (L, "t");
+	REQUIRE(lua_istable (L, -1));
+	REQUIRE(lua_tovector (L, -1).x == 1.0);
+	lua_getglobal (L, "p");
+	REQUIRE(lua_tovector (L, -1).y == Catch::Approx(1.0));
+	lua_getglobal (L, "out");
+	REQUIRE(lua_tovector (L, -1).x == Catch::Approx(1.0));
+	lua_getglobal (L, "m");
+	REQUIRE(lua_tonumber (L, -1) == Catch::Approx(-1.0));
+	lua_settop (L, 0);
+
+	// invalid fields are rejected
+	REQUIRE(Run (interp.get(), "local v = vec.set(1,2,3); v.w = 1") != 0);
+	lua_settop (L, 0);
+}
+
+// Background jobs blocked in a wait don't need an interpreter cycle until
+// Schedule reports their condition as met
+TEST_CASE("Script scheduler", "[LuaInterpreter]")
+{
+	auto interp = make_unique<Interpreter>();
+	interp->Initialise();
+	auto L = interp->GetState();
+	REQUIRE(!interp->Schedule (0.0));
+
+	REQUIRE(Run (interp.get(),
+		"log = ''\n"
+		"proc.bg(function()\n"
+		"  proc.wait_simtime(10)\n"
+		"  log = log..'t'\n"
+		"  if proc.wait_event('go') then log = log..'e' end\n"
+		"  log = log..(proc.wait_event('never', 1) and 'x' or 'o')\n"
+		"end)\n") == 0);
+	REQUIRE(interp->nJobs() == 1);
+	REQUIRE(!interp->Schedule (5.0));
+	REQUIRE(interp->Schedule (10.0));
+	interp->RunChunk ("", 0);           // idle cycle resumes the job
+	REQUIRE(!interp->Schedule (11.0));  // waiting for 'go'
+	interp->SignalEvent ("go");
+	REQUIRE(interp->Schedule (11.0));
+	interp->RunChunk ("", 0);
+	REQUIRE(!interp->Schedule (11.5));
+	REQUIRE(interp->Schedule (12.0));   // 'never' timed out
+	interp->RunChunk ("", 0);
+	REQUIRE(interp->nJobs() == 0);
+	lua_getglobal (L, "log");
+	REQUIRE(string (lua_tostring (L, -1)) == "teo");
+	lua_settop (L, 0);
+
+	// predicates are evaluated by Schedule
+	REQUIRE(Run (interp.get(),
+		"flag = false\n"
+		"proc.bg(function() done = proc.wait_until(function() return flag end) end)\n") == 0);
+	REQUIRE(!interp->Schedule (13.0));
+	REQUIRE(Run (interp.get(), "flag = true") == 0);
+	REQUIRE(interp->Schedule (13.0));
+	interp->RunChunk ("", 0);
+	lua_getglobal (L, "done");
+	REQUIRE(lua_toboolean (L, -1));
+	lua_settop (L, 0);
+
+	// a script exceeding the budget is suspended (and, without an orbiter
+	// thread to hand control to, resumed immediately)
+	REQUIRE(Run (interp.get(),
+		"proc.set_budget(10000, 0)\n"
+		"sum = 0\n"
+		"for i = 1,100000 do sum = sum+i end\n"
+		"u = proc.usage()[1]\n"
+		"name, over = u.name, u.overrun\n") == 0);
+	lua_getglobal (L, "sum");
+	REQUIRE(lua_tonumber (L, -1) == 5000050000.0);
+	lua_getglobal (L, "name");
+	REQUIRE(string (lua_tostring (L, -1)) == "main");
+	lua_getglobal (L, "over");
+	REQUIRE(lua_tointeger (L, -1) > 0);
+	lua_settop (L, 0);
+
+	double total, last;
+	interp->GetCpuTime (total, last);
+	REQUIRE(total > 0.0);
+}
@@ -0,0 +1,65 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Benchmark for scenario startup with text and compiled meshes.
+# Runs stock scenarios with Orbiter_server for a single frame, first with
+# text meshes only, then after compiling all meshes with meshc --compile,
+# and reports the mesh loading time logged by the mesh manager at session
+# end. Compiled meshes are removed again afterwards.
+#
+# Usage:
+#   cmake -DORBITER=<Orbiter_server> -DMESHC=<meshc> -DWORKDIR=<orbiter root>
+#         [-DSCENARIOS="<scn>;<scn>"] -P MeshStartupBench.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/BenchCommon.cmake)
+
+bench_require(ORBITER MESHC WORKDIR)
+if(NOT SCENARIOS)
+	file(GLOB SCENARIOS
+		"${WORKDIR}/Scenarios/Space Stations/*.scn"
+		"${WORKDIR}/Scenarios/Delta-glider/*.scn"
+	)
+endif()
+
+file(GLOB_RECURSE MESHES "${WORKDIR}/Meshes/*.msh")
+
+function(remove_compiled)
+	file(GLOB_RECURSE compiled "${WORKDIR}/Meshes/*.mshb")
+	if(compiled)
+		file(REMOVE ${compiled})
+	endif()
+endfunction()
+
+# Run a scenario and return mesh count and loading time [ms]
+function(run_scenario scn result)
+	bench_run(${scn} "--maxframes=1")
+	bench_log_line("Mesh manager:" line)
+	if(NOT line)
+		set(${result} "0 meshes, 0 ms" PARENT_SCOPE)
+		return()
+	endif()
+	string(REGEX MATCH "([0-9]+) meshes loaded \\(([0-9]+) compiled\\) in ([0-9.]+) ms" match "${line}")
+	set(${result} "${CMAKE_MATCH_1} meshes (${CMAKE_MATCH_2} compiled), ${CMAKE_MATCH_3} ms" PARENT_SCOPE)
+endfunction()
+
+remove_compiled()
+foreach(scn ${SCENARIOS})
+	run_scenario(${scn} t_text)
+	set(text_${scn} ${t_text})
+endforeach()
+
+execute_process(
+	COMMAND ${MESHC} --compile ${MESHES}
+	WORKING_DIRECTORY ${WORKDIR}
+	OUTPUT_QUIET
+)
+
+message(STATUS "Scenario startup benchmark: mesh loading time")
+message(STATUS "scenario | text | compiled")
+foreach(scn ${SCENARIOS})
+	run_scenario(${scn} t_bin)
+	get_filename_component(name ${scn} NAME_WE)
+	message(STATUS "${name} | ${text_${scn}} | ${t_bin}")
+endforeach()
+
+remove_compiled()
@@ -0,0 +1,123 @@
+#include "AirfoilTable.h"
+
+#include <sstream>
+
+#include "catch2/catch_all.hpp"
+
+static const double RAD = 3.14159265358979323846/180.0;
+
+static double InducedDrag (double cl, double A, double eps)
+{
+	return (cl*cl)/(3.14159265358979323846*A*eps);
+}
+
+static double WaveDrag (double M, double M1, double M2, double M3, double cmax)
+{
+	if (M < M1) return 0.0;
+	if (M < M2) return cmax * (M-M1)/(M2-M1);
+	if (M < M3) return cmax;
+	return cmax * sqrt ((M3*M3-1.0)/(M*M-1.0));
+}
+
+// Vertical lift coefficients of the DeltaGlider
+static void VLiftCoeff (double aoa, double M, double /*Re*/, double *cl, double *cm, double *cd)
+{
+	const int nabsc = 9;
+	static const double AOA[nabsc] = {-180*RAD,-60*RAD,-30*RAD, -2*RAD, 15*RAD,20*RAD,25*RAD,60*RAD,180*RAD};
+	static const double CL[nabsc]  = {       0,      0,   -0.4,      0,    0.7,     1,   0.8,     0,      0};
+	static const double CM[nabsc]  = {       0,      0,  0.014, 0.0039, -0.006,-0.008,-0.010,     0,      0};
+	int i;
+	for (i = 0; i < nabsc-1 && AOA[i+1] < aoa; i++);
+	if (i < nabsc - 1) {
+		double f = (aoa - AOA[i]) / (AOA[i + 1] - AOA[i]);
+		*cl = CL[i] + (CL[i + 1] - CL[i]) * f;
+		*cm = CM[i] + (CM[i + 1] - CM[i]) * f;
+	}
+	else {
+		*cl = CL[nabsc - 1];
+		*cm = CM[nabsc - 1];
+	}
+	double saoa = sin(aoa);
+	double pd = 0.015 + 0.4*saoa*saoa;
+	*cd = pd + InducedDrag (*cl, 1.5, 0.7) + WaveDrag (M, 0.75, 1.0, 1.1, 0.04);
+}
+
+// Smooth lift curve with Reynolds-number dependent skin friction
+static void SmoothCoeff (double aoa, double M, double Re, double *cl, double *cm, double *cd)
+{
+	*cl = 1.2*sin(2.0*aoa) / sqrt (1.0 + 0.2*M*M);
+	*cm = -0.01*sin(aoa);
+	*cd = 0.074/pow (Re, 0.2) + 0.5*sin(aoa)*sin(aoa);
+}
+
+TEST_CASE("Airfoil table collapses unused axes", "[AirfoilTable]")
+{
+	AirfoilTable tab;
+	tab.Sample (VLiftCoeff);
+	REQUIRE(tab.nNode(0) == AirfoilTable::DefaultGrid.naoa);
+	REQUIRE(tab.nNode(1) == AirfoilTable::DefaultGrid.nmach);
+	REQUIRE(tab.nNode(2) == 1); // no Reynolds number dependence
+
+	tab.Sample ([](double aoa, double /*M*/, double Re, double *cl, double *cm, double *cd) {
+		VLiftCoeff (aoa, 0.0, Re, cl, cm, cd);
+	});
+	REQUIRE(tab.nNode(1) == 1);
+	REQUIRE(tab.nNode(2) == 1);
+
+	tab.Sample (SmoothCoeff);
+	REQUIRE(tab.nNode(1) == AirfoilTable::DefaultGrid.nmach);
+	REQUIRE(tab.nNode(2) == AirfoilTable::DefaultGrid.nre);
+}
+
+TEST_CASE("Airfoil table reproduces coefficients", "[AirfoilTable]")
+{
+	AirfoilTable tab;
+	AirfoilTable::Error err;
+
+	// DeltaGlider: lift breakpoints lie on grid nodes, so only the drag
+	// kinks of the wave drag model contribute a noticeable error
+	tab.Sample (VLiftCoeff);
+	tab.Validate (VLiftCoeff, err);
+	REQUIRE(err.nsample > 0);
+	CHECK(err.maxerr[0] < 1e-6);
+	CHECK(err.maxerr[1] < 1e-6);
+	CHECK(err.maxerr[2] < 5e-3);
+	CHECK(err.rmserr[2] < 5e-4);
+
+	tab.Sample (SmoothCoeff);
+	tab.Validate (SmoothCoeff, err);
+	CHECK(err.maxerr[0] < 2e-3);
+	CHECK(err.maxerr[1] < 1e-5);
+	CHECK(err.maxerr[2] < 2e-3);
+
+	// out of range parameters are clamped
+	double cl0, cm0, cd0, cl1, cm1, cd1;
+	tab.Eval (0.3, 100.0, 1e12, &cl0, &cm0, &cd0);
+	tab.Eval (0.3, AirfoilTable::DefaultGrid.mmax, pow (10.0, AirfoilTable::DefaultGrid.lgre1), &cl1, &cm1, &cd1);
+	REQUIRE(cl0 == Catch::Approx(cl1));
+	REQUIRE(cd0 == Catch::Approx(cd1));
+	tab.Eval (0.3, 0.5, 0.0, &cl0, &cm0, &cd0); // vacuum: Re = 0
+	REQUIRE(std::isfinite (cd0));
+}
+
+TEST_CASE("Airfoil table text round trip", "[AirfoilTable]")
+{
+	AirfoilTable tab, tab2;
+	tab.Sample (SmoothCoeff);
+	std::stringstream ss;
+	tab.Write (ss);
+	REQUIRE(tab2.Read (ss));
+	for (int i = 0; i < 3; i++)
+		REQUIRE(tab2.nNode(i) == tab.nNode(i));
+	for (double aoa = -3.0; aoa < 3.0; aoa += 0.37)
+		for (double M = 0.0; M < 20.0; M += 1.3) {
+			double c0[3], c1[3];
+			tab.Eval (aoa, M, 3e6, c0, c0+1, c0+2);
+			tab2.Eval (aoa, M, 3e6, c1, c1+1, c1+2);
+			for (int k = 0; k < 3; k++)
+				REQUIRE(c1[k] == Catch::Approx(c0[k]).margin(1e-7));
+		}
+
+	std::stringstream bad ("AOA 10\nMACH 5 3\nLOGRE 3 10 1\n0 0 0\n");
+	REQUIRE(!tab2.Read (bad));
+}
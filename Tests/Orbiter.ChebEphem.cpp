@@ -0,0 +1,112 @@
+#include "ChebEphem.h"
+#include "TestSources.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "catch2/catch_all.hpp"
+
+// Earth ephemeris as delivered to the table by CelestialBody::FitEphemerisTable:
+// true position and velocity (res[0-5]) and those of the Earth-Moon
+// barycentre (res[6-11])
+static void TestEphemeris (double mjd, double *r)
+{
+	Vector pe, ve, pm, vm;
+	TestBodyState (TEST_EARTH, mjd, pe, ve);
+	TestBodyState (TEST_MOON, mjd, pm, vm);
+	double f = TestBodies[TEST_MOON].gm / (TestBodies[TEST_EARTH].gm + TestBodies[TEST_MOON].gm);
+	Vector pb (pe + (pm-pe)*f), vb (ve + (vm-ve)*f);
+	r[0] = pe.x, r[1] = pe.y, r[2]  = pe.z, r[3] = ve.x, r[4]  = ve.y, r[5]  = ve.z;
+	r[6] = pb.x, r[7] = pb.y, r[8]  = pb.z, r[9] = vb.x, r[10] = vb.y, r[11] = vb.z;
+}
+
+static const double MJD0 = 51544.5, MJD1 = 51544.5 + 3652.5;
+
+TEST_CASE("Chebyshev table meets the fit tolerance", "[ChebEphem]")
+{
+	ChebEphemeris tab;
+	for (double tol : {100.0, 1.0, 0.1}) {
+		REQUIRE(tab.Fit (TestEphemeris, 0x1f, 3, MJD0, MJD1, tol, tol*1e-3));
+		ChebEphemeris::Accuracy acc = tab.Compare (TestEphemeris, 5000);
+		INFO("tol " << tol << ": " << tab.GetHeader()->nseg << " segments");
+		REQUIRE(acc.perr_max <= 2.0*tol);
+		REQUIRE(acc.verr_max <= 2e-3*tol);
+		REQUIRE(acc.perr_rms <= acc.perr_max);
+	}
+}
+
+TEST_CASE("Chebyshev table range and flags", "[ChebEphem]")
+{
+	ChebEphemeris tab;
+	REQUIRE(!tab.IsValid());
+	REQUIRE(tab.Fit (TestEphemeris, 0x1f, 3, MJD0, MJD0+100.0, 1.0, 1e-3));
+	double res[12];
+	REQUIRE(tab.Eval (MJD0-1.0, res) == 0);
+	REQUIRE(tab.Eval (MJD0+101.0, res) == 0);
+	REQUIRE(tab.Eval (MJD0, res) == 0x1f);
+	REQUIRE(tab.Eval (MJD0+100.0, res) == 0x1f); // end point belongs to the last segment
+
+	// single state vector: only res[6-11] is written
+	REQUIRE(tab.Fit (TestEphemeris, 0x0c, 2, MJD0, MJD0+100.0, 1.0, 1e-3));
+	REQUIRE(tab.GetHeader()->nvec == 1);
+	res[0] = -1.0;
+	REQUIRE(tab.Eval (MJD0+50.0, res) == 0x0c);
+	REQUIRE(res[0] == -1.0);
+	double ref[12];
+	TestEphemeris (MJD0+50.0, ref);
+	REQUIRE(fabs (res[6]-ref[6]) <= 1.0);
+
+	// tolerance that can't be met
+	REQUIRE(!tab.Fit (TestEphemeris, 0x1f, 3, MJD0, MJD0+100.0, 1e-9, 1e-12));
+	REQUIRE(!tab.IsValid());
+}
+
+TEST_CASE("Chebyshev table file round trip", "[ChebEphem]")
+{
+	const char *fname = "Orbiter.ChebEphem.test.cheb";
+	ChebEphemeris tab;
+	REQUIRE(tab.Fit (TestEphemeris, 0x1f, 3, MJD0, MJD0+1000.0, 1.0, 1e-3));
+	REQUIRE(tab.Save (fname));
+
+	ChebEphemeris map;
+	REQUIRE(map.Open (fname));
+	REQUIRE(map.Size() == tab.Size());
+	for (int i = 0; i < 100; i++) {
+		double mjd = MJD0 + i*9.99, r0[12], r1[12];
+		REQUIRE(tab.Eval (mjd, r0) == map.Eval (mjd, r1));
+		for (int j = 0; j < 12; j++)
+			REQUIRE(r0[j] == r1[j]);
+	}
+	map.Close();
+
+	// truncated file is rejected
+	FILE *f = fopen (fname, "wb");
+	fwrite (tab.GetHeader(), 1, tab.Size()/2, f);
+	fclose (f);
+	REQUIRE(!map.Open (fname));
+	remove (fname);
+}
+
+TEST_CASE("Chebyshev table is matched to its source", "[ChebEphem]")
+{
+	const char *fname = "Orbiter.ChebEphem.source.cheb";
+	ChebEphemeris tab;
+	REQUIRE(tab.Fit (TestEphemeris, 0x1f, 3, MJD0, MJD0+1000.0, 1.0, 1e-3));
+	tab.SetSource ("Earth.dll");
+	REQUIRE(tab.Save (fname));
+
+	ChebEphemeris map;
+	REQUIRE(map.Open (fname));
+	REQUIRE(map.Matches ("Earth.dll", TestEphemeris));
+	REQUIRE(!map.Matches ("Mars.dll", TestEphemeris));
+
+	// changes of the source within the fit tolerance are accepted, larger
+	// changes (e.g. an updated series) are not
+	auto shifted = [](double dp) {
+		return [dp](double mjd, double *r) { TestEphemeris (mjd, r); r[0] += dp; };
+	};
+	REQUIRE(map.Matches ("Earth.dll", shifted (0.5)));
+	REQUIRE(!map.Matches ("Earth.dll", shifted (10.0)));
+	map.Close();
+	remove (fname);
+}
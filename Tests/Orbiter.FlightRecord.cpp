@@ -0,0 +1,311 @@
+#include "FlightRecord.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <string>
+
+#include "catch2/catch_all.hpp"
+
+// Synthetic recording: circular equatorial orbit with a slowly rotating
+// attitude, a reference change halfway, and a few events.
+static const int NSAMPLE = 5000;
+
+static void TestPos (int i, FRecPosSample &s)
+{
+	double t = i*2.0, w = 1e-3, r = 6.6e6;
+	s.simt = t;
+	s.frm = (i < NSAMPLE/2 ? 0 : 1);
+	s.ref = (i < NSAMPLE/2 ? 0 : 1);
+	s.rpos.Set (r*cos(w*t), 0.01*r*sin(w*t), r*sin(w*t));
+	s.rvel.Set (-r*w*sin(w*t), 0.01*r*w*cos(w*t), r*w*cos(w*t));
+}
+
+static void TestAtt (int i, FRecAttSample &s)
+{
+	double a[3] = {0.3*sin(i*1e-3), 0.2*cos(i*2e-3), fmod (i*1e-3, 3.0)-1.5};
+	s.simt = i*2.0;
+	s.frm = (i < NSAMPLE/2 ? 0 : 1);
+	s.ref = s.frm ? 1 : -1;
+	FlightRecord::Euler2Quaternion (a, s.q, s.frm);
+}
+
+static void WriteTestRecord (const char *fname, bool quantise)
+{
+	FlightRecordWriter w;
+	REQUIRE(w.Open (fname, 51544.5, quantise));
+	REQUIRE(w.RefIndex ("Earth") == 0);
+	REQUIRE(w.RefIndex ("Moon") == 1);
+	REQUIRE(w.RefIndex ("Earth") == 0);
+	for (int i = 0; i < NSAMPLE; i++) {
+		FRecPosSample p;
+		FRecAttSample a;
+		TestPos (i, p);
+		TestAtt (i, a);
+		w.AddPos (p);
+		w.AddAtt (a);
+		if (i % 100 == 0) w.AddEvent (i*2.0, "ENG", "0:0.50 1:0.25");
+	}
+	w.AddEvent (NSAMPLE*2.0, "UNDOCK", "");
+	w.Close ();
+}
+
+static double AttError (const Quaternion &q0, const Quaternion &q1)
+{
+	// rotation angle between orientations [rad], from the quaternion chord
+	// length (q and -q represent the same orientation)
+	double dm = 0.0, dp = 0.0;
+	const double a[4] = {q0.qs, q0.qvx, q0.qvy, q0.qvz};
+	const double b[4] = {q1.qs, q1.qvx, q1.qvy, q1.qvz};
+	for (int i = 0; i < 4; i++) {
+		dm += (a[i]-b[i])*(a[i]-b[i]);
+		dp += (a[i]+b[i])*(a[i]+b[i]);
+	}
+	return 4.0*asin (0.5*sqrt (dm < dp ? dm : dp));
+}
+
+TEST_CASE("Binary flight record round trip", "[FlightRecord]")
+{
+	const char *fname = "Orbiter.FlightRecord.test.frb";
+	WriteTestRecord (fname, false);
+	REQUIRE(FlightRecord::IsBinary (fname));
+
+	FlightRecordReader rec;
+	REQUIRE(rec.Open (fname));
+	REQUIRE(rec.MJD0() == 51544.5);
+	REQUIRE(rec.Refs().size() == 2);
+	REQUIRE(rec.Refs()[1] == "Moon");
+	REQUIRE(rec.nPos() == NSAMPLE);
+	REQUIRE(rec.nAtt() == NSAMPLE);
+	REQUIRE(rec.nEvent() == NSAMPLE/100 + 1);
+	for (int i = 0; i < NSAMPLE; i += 7) {
+		FRecPosSample p0, p1;
+		FRecAttSample a0, a1;
+		TestPos (i, p0); rec.GetPos (i, p1);
+		TestAtt (i, a0); rec.GetAtt (i, a1);
+		REQUIRE(p1.simt == p0.simt);
+		REQUIRE(p1.frm == p0.frm);
+		REQUIRE(p1.ref == p0.ref);
+		REQUIRE(p1.rpos.x == p0.rpos.x);
+		REQUIRE(p1.rvel.z == p0.rvel.z);
+		REQUIRE(a1.ref == a0.ref);
+		REQUIRE(AttError (a0.q, a1.q) < 1e-12);
+	}
+	REQUIRE(rec.GetEvent(1).type == "ENG");
+	REQUIRE(rec.GetEvent(1).data == "0:0.50 1:0.25");
+	REQUIRE(rec.GetEvent(rec.nEvent()-1).type == "UNDOCK");
+
+	// time index
+	REQUIRE(rec.FindPos (-1.0) == 0);
+	REQUIRE(rec.FindPos (2.0) == 1);
+	REQUIRE(rec.FindPos (2.5) == 1);
+	REQUIRE(rec.FindPos (1e10) == NSAMPLE-1);
+	REQUIRE(rec.FindAtt (4321.0) == 2160);
+
+	// appending continues the record
+	FlightRecordWriter w;
+	REQUIRE(w.Open (fname, 0.0, false, true));
+	REQUIRE(w.RefIndex ("Moon") == 1);
+	FRecPosSample p;
+	TestPos (NSAMPLE, p);
+	w.AddPos (p);
+	w.Close ();
+	FlightRecordReader rec2;
+	REQUIRE(rec2.Open (fname));
+	REQUIRE(rec2.nPos() == NSAMPLE+1);
+	REQUIRE(rec2.MJD0() == 51544.5);
+	remove (fname);
+}
+
+TEST_CASE("Quantised attitude and interrupted records", "[FlightRecord]")
+{
+	const char *fname = "Orbiter.FlightRecord.test.frb";
+	WriteTestRecord (fname, true);
+	FlightRecordReader rec;
+	REQUIRE(rec.Open (fname));
+	double maxerr = 0.0;
+	for (int i = 0; i < NSAMPLE; i++) {
+		FRecAttSample a0, a1;
+		TestAtt (i, a0); rec.GetAtt (i, a1);
+		double err = AttError (a0.q, a1.q);
+		if (err > maxerr) maxerr = err;
+	}
+	REQUIRE(maxerr < 2e-4);
+
+	// drop the chunk index and part of the last chunk: complete chunks
+	// are still readable
+	FILE *f = fopen (fname, "rb");
+	fseek (f, 0, SEEK_END);
+	long size = ftell (f);
+	std::string buf (size, '\0');
+	fseek (f, 0, SEEK_SET);
+	fread (&buf[0], 1, size, f);
+	fclose (f);
+	FRecHeader hdr;
+	memcpy (&hdr, buf.data(), sizeof(FRecHeader));
+	uint64_t cut = 0;
+	for (uint32_t i = 0; i < hdr.nchunk; i++) {
+		FRecChunkInfo ci;
+		memcpy (&ci, buf.data() + hdr.indexOfs + i*sizeof(FRecChunkInfo), sizeof(FRecChunkInfo));
+		if (ci.stream == FlightRecord::STREAM_POS) cut = ci.ofs + 100; // inside the last position chunk
+	}
+	REQUIRE(cut > 0);
+	hdr.indexOfs = 0;
+	memcpy (&buf[0], &hdr, sizeof(FRecHeader));
+	f = fopen (fname, "wb");
+	fwrite (buf.data(), 1, (size_t)cut, f);
+	fclose (f);
+	FlightRecordReader part;
+	REQUIRE(part.Open (fname));
+	REQUIRE(part.nPos() >= NSAMPLE - FREC_CHUNKSIZE);
+	REQUIRE(part.nPos() < NSAMPLE);
+
+	// appending rebuilds the index and continues after the last complete chunk
+	FlightRecordWriter w;
+	REQUIRE(w.Open (fname, 0.0, true, true));
+	FRecPosSample p;
+	TestPos (NSAMPLE, p);
+	w.AddPos (p);
+	w.Close ();
+	FlightRecordReader cont;
+	REQUIRE(cont.Open (fname));
+	REQUIRE(cont.nPos() == part.nPos()+1);
+	REQUIRE(cont.nAtt() == part.nAtt());
+	REQUIRE(cont.Refs().size() == 2);
+	FRecPosSample p1;
+	cont.GetPos (cont.nPos()-1, p1);
+	REQUIRE(p1.simt == p.simt);
+	remove (fname);
+
+	// a file that isn't a record is not overwritten by appending
+	f = fopen (fname, "wb");
+	fputs ("not a flight record", f);
+	fclose (f);
+	REQUIRE(!w.Open (fname, 0.0, false, true));
+	REQUIRE(!w.IsOpen());
+	f = fopen (fname, "rb");
+	char cbuf[32] = "";
+	fgets (cbuf, 32, f);
+	fclose (f);
+	REQUIRE(!strcmp (cbuf, "not a flight record"));
+	remove (fname);
+}
+
+TEST_CASE("Damaged records are rejected", "[FlightRecord]")
+{
+	const char *fname = "Orbiter.FlightRecord.test.frb";
+	WriteTestRecord (fname, false);
+	FILE *f = fopen (fname, "rb");
+	fseek (f, 0, SEEK_END);
+	long size = ftell (f);
+	std::string buf (size, '\0');
+	fseek (f, 0, SEEK_SET);
+	fread (&buf[0], 1, size, f);
+	fclose (f);
+	FRecHeader hdr;
+	memcpy (&hdr, buf.data(), sizeof(FRecHeader));
+
+	// offsets of the first chunk of each stream
+	uint64_t chofs[5] = {0};
+	for (uint32_t i = 0; i < hdr.nchunk; i++) {
+		FRecChunkInfo ci;
+		memcpy (&ci, buf.data() + hdr.indexOfs + i*sizeof(FRecChunkInfo), sizeof(FRecChunkInfo));
+		if (ci.stream < 5 && !chofs[ci.stream]) chofs[ci.stream] = ci.ofs;
+	}
+
+	auto check = [&](uint32_t stream, uint32_t n, uint32_t len) {
+		std::string damaged (buf);
+		FRecChunkHeader ch;
+		memcpy (&ch, damaged.data() + chofs[stream], sizeof(FRecChunkHeader));
+		if (n) ch.n = n;
+		memcpy (&damaged[chofs[stream]], &ch, sizeof(FRecChunkHeader));
+		if (len) // length of the first event string
+			memcpy (&damaged[chofs[stream] + sizeof(FRecChunkHeader) + ch.n*sizeof(double)], &len, sizeof(uint32_t));
+		FILE *f = fopen (fname, "wb");
+		fwrite (damaged.data(), 1, damaged.size(), f);
+		fclose (f);
+		FlightRecordReader rec;
+		return rec.Open (fname);
+	};
+	REQUIRE(check (FlightRecord::STREAM_POS, 0, 0));                // undamaged
+	CHECK(!check (FlightRecord::STREAM_POS, 0x4000001, 0));         // more samples than the chunk holds
+	CHECK(!check (FlightRecord::STREAM_ATT, 0xffffffff, 0));
+	CHECK(!check (FlightRecord::STREAM_EVENT, 0x10000000, 0));
+	CHECK(!check (FlightRecord::STREAM_EVENT, 0, 0x7fffffff));     // string beyond the chunk
+	CHECK(!check (FlightRecord::STREAM_EVENT, 0, 3));              // data string not terminated
+	CHECK(!check (FlightRecord::STREAM_REF, 1000, 0));              // more names than stored
+	remove (fname);
+}
+
+TEST_CASE("Concurrent records", "[FlightRecord]")
+{
+	// several records written at the same time share the background writer
+	const int nrec = 4;
+	char fname[nrec][64];
+	FlightRecordWriter w[nrec];
+	for (int k = 0; k < nrec; k++) {
+		sprintf (fname[k], "Orbiter.FlightRecord.test%d.frb", k);
+		REQUIRE(w[k].Open (fname[k], 51544.5+k));
+		w[k].RefIndex ("Earth");
+	}
+	for (int i = 0; i < NSAMPLE; i++)
+		for (int k = 0; k < nrec; k++) {
+			FRecPosSample p;
+			TestPos (i, p);
+			p.ref = 0;
+			p.rpos.x += k;
+			w[k].AddPos (p);
+		}
+	for (int k = 0; k < nrec; k++) {
+		w[k].Close ();
+		FlightRecordReader rec;
+		REQUIRE(rec.Open (fname[k]));
+		REQUIRE(rec.MJD0() == 51544.5+k);
+		REQUIRE(rec.nPos() == NSAMPLE);
+		for (int i = 0; i < NSAMPLE; i += 13) {
+			FRecPosSample p0, p1;
+			TestPos (i, p0);
+			rec.GetPos (i, p1);
+			REQUIRE(p1.simt == p0.simt);
+			REQUIRE(p1.rpos.x == p0.rpos.x + k);
+		}
+		remove (fname[k]);
+	}
+}
+
+TEST_CASE("Flight record text conversion", "[FlightRecord]")
+{
+	const char *fname = "Orbiter.FlightRecord.test.frb";
+	const char *posname = "Orbiter.FlightRecord.test.pos";
+	const char *fname2 = "Orbiter.FlightRecord.test2.frb";
+	WriteTestRecord (fname, false);
+
+	FlightRecordReader rec;
+	REQUIRE(rec.Open (fname));
+	REQUIRE(rec.ExportText (posname));
+	REQUIRE(!FlightRecord::IsBinary (posname));
+	REQUIRE(FlightRecordWriter::ImportText (posname, fname2));
+
+	FlightRecordReader rec2;
+	REQUIRE(rec2.Open (fname2));
+	REQUIRE(rec2.MJD0() == rec.MJD0());
+	REQUIRE(rec2.nPos() == rec.nPos());
+	REQUIRE(rec2.nAtt() == rec.nAtt());
+	REQUIRE(rec2.nEvent() == rec.nEvent());
+	for (size_t i = 0; i < rec.nPos(); i += 11) {
+		FRecPosSample p0, p1;
+		FRecAttSample a0, a1;
+		rec.GetPos (i, p0); rec2.GetPos (i, p1);
+		rec.GetAtt (i, a0); rec2.GetAtt (i, a1);
+		REQUIRE(p1.frm == p0.frm);
+		REQUIRE(rec2.Refs()[p1.ref] == rec.Refs()[p0.ref]);
+		REQUIRE(fabs (p1.rpos.x - p0.rpos.x) < 1e-3*fabs (p0.rpos.x) + 1e-2);
+		REQUIRE(a1.frm == a0.frm);
+		REQUIRE(AttError (a0.q, a1.q) < 1e-5); // text stores 6 digits
+	}
+	REQUIRE(rec2.GetEvent(1).data == rec.GetEvent(1).data);
+
+	remove (fname); remove (fname2); remove (posname);
+	remove ("Orbiter.FlightRecord.test.att");
+	remove ("Orbiter.FlightRecord.test.atc");
+}
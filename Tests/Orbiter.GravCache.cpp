@@ -0,0 +1,130 @@
+#include "GravCache.h"
+#include "TestSources.h"
+
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// A perturbation field resembling the mascons of a Moon-sized body: point
+// masses below the surface (positions in km, GM in km^3/s^2). The shallow
+// mascon makes the field rough near its surface point, so cells there must
+// be subdivided, while the field is smooth elsewhere.
+struct MasconField {
+	vector<Vector> pos;
+	vector<double> gm;
+	MasconField ()
+	{
+		Add (Vector(1738.0-300.0, 0, 0), 2.0);     // deep, smooth
+		Add (Vector(0, 1738.0-200.0, 0), 1.0);
+		Add (Vector(0, 0, -(1738.0-250.0)), 1.5);
+		Add (Vector(0, 0, 1738.0-15.0), 0.05);     // shallow, rough
+	}
+	void Add (const Vector &p, double mu) { pos.push_back (p); gm.push_back (mu); }
+	Vector operator() (const Vector &p, int /*degree*/) const
+	{ return PointMassAcc (pos, gm, p); }
+};
+
+static const int DEGREE = 25;
+static const double TOL = 1e-4;
+
+// Points along a low orbit track over a region, at 10-20 km altitude
+static vector<Vector> Track (const Vector &centre, int n)
+{
+	vector<Vector> p(n);
+	Vector u = centre.unit(), v = crossp (u, Vector(0.3,0.4,0.5)).unit(), w = crossp (u, v);
+	for (int i = 0; i < n; i++) {
+		double s = (double)i/(double)n - 0.5;
+		p[i] = u*(1738.0 + 10.0 + 10.0*(i%7)/7.0) + v*(200.0*s) + w*(50.0*s*s);
+	}
+	return p;
+}
+
+TEST_CASE("Cached field matches the model within tolerance", "[GravCache]")
+{
+	MasconField field;
+	GravCache cache (field, TOL);
+
+	const Vector region[] = { Vector(1,0,0), Vector(0,1,0), Vector(0,0,-1), Vector(0,0,1), Vector(1,1,1) };
+	for (auto &c : region) {
+		vector<Vector> p = Track (c, 2000);
+		for (int pass = 0; pass < 2; pass++) {  // first pass builds the cells, second pass reuses them
+			for (auto &x : p) {
+				Vector g = cache.Eval (x, DEGREE), gref = field (x, DEGREE);
+				INFO("position " << x.x << ", " << x.y << ", " << x.z);
+				REQUIRE((g - gref).length() <= TOL * gref.length());
+			}
+		}
+	}
+	CHECK(cache.nHit() > cache.nMiss());
+}
+
+TEST_CASE("Cache statistics", "[GravCache]")
+{
+	MasconField field;
+	GravCache cache (field, TOL);
+	vector<Vector> p = Track (Vector(1,0,0), 500);
+
+	// every evaluation is counted as a hit or a miss
+	for (auto &x : p) cache.Eval (x, DEGREE);
+	uint64_t nmiss = cache.nMiss();
+	CHECK(cache.nHit() + nmiss == p.size());
+	CHECK(nmiss > 0);
+	CHECK(cache.nCell() > 0);
+
+	// the smooth region is covered by valid cells after the first pass
+	for (auto &x : p) cache.Eval (x, DEGREE);
+	CHECK(cache.nMiss() == nmiss);
+	CHECK(cache.nHit() + nmiss == 2*p.size());
+
+	// cells are per model degree
+	size_t ncell = cache.nCell();
+	cache.Eval (p[0], DEGREE-1);
+	CHECK(cache.nMiss() == nmiss+1);
+	CHECK(cache.nCell() > ncell);
+
+	cache.Clear();
+	CHECK(cache.nCell() == 0);
+	cache.Eval (p[0], DEGREE);
+	CHECK(cache.nMiss() == nmiss+2);
+}
+
+TEST_CASE("Cells are refined locally", "[GravCache]")
+{
+	MasconField field;
+	vector<Vector> smooth = Track (Vector(1,0,0), 500);
+	vector<Vector> rough  = Track (Vector(0,0,1), 500);
+
+	GravCache a (field, TOL);
+	for (auto &x : smooth) a.Eval (x, DEGREE);
+	size_t nsmooth = a.nCell();
+
+	// cells over the shallow mascon must be subdivided ...
+	GravCache b (field, TOL);
+	for (auto &x : rough) b.Eval (x, DEGREE);
+	size_t nrough = b.nCell();
+	CHECK(nrough > nsmooth);
+
+	// ... but this doesn't affect the cell size in the smooth region
+	for (auto &x : smooth) b.Eval (x, DEGREE);
+	CHECK(b.nCell() - nrough == nsmooth);
+}
+
+TEST_CASE("Unresolvable field is evaluated directly", "[GravCache]")
+{
+	// a mascon just below the surface can't be interpolated at any refinement level
+	MasconField field;
+	field.Add (Vector(1738.0-0.01, 0, 0), 0.01);
+	GravCache cache (field, TOL);
+	Vector p (1738.0+0.005, 0.002, 0.001);
+
+	for (int i = 0; i < 3; i++) {
+		Vector g = cache.Eval (p, DEGREE), gref = field (p, DEGREE);
+		REQUIRE(g.x == gref.x);
+		REQUIRE(g.y == gref.y);
+		REQUIRE(g.z == gref.z);
+	}
+	CHECK(cache.nHit() == 0);
+	CHECK(cache.nMiss() == 3);
+}
@@ -0,0 +1,57 @@
+#include "GravKernel.h"
+#include "TestSources.h"
+
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// Source positions at the start of the test step
+struct TestSources {
+	vector<Vector> pos;
+	vector<double> gm;
+	TestSources ()
+	{
+		Vector p, v;
+		for (int i = 0; i < nTestBody; i++) {
+			TestBodyState (i, 51544.5, p, v);
+			pos.push_back (p); gm.push_back (TestBodies[i].gm);
+		}
+	}
+	size_t size () const { return gm.size(); }
+};
+
+// Reference: per-source summation, as in SingleGacc
+static Vector GaccReference (const vector<Vector> &pos, const vector<double> &gm, const int *idx, int nidx, const Vector &gpos)
+{
+	Vector acc;
+	for (int j = 0; j < nidx; j++) {
+		Vector r (pos[idx[j]] - gpos);
+		double d = r.length();
+		acc += r * (gm[idx[j]] / (d*d*d));
+	}
+	return acc;
+}
+
+TEST_CASE("Batched point-mass kernel matches per-source summation", "[GravKernel]")
+{
+	TestSources ts;
+	vector<double> x, y, z;
+	for (auto &p : ts.pos) x.push_back (p.x), y.push_back (p.y), z.push_back (p.z);
+	GravSourceArray src = { x.data(), y.data(), z.data(), ts.gm.data() };
+	Vector gpos (ts.pos[TEST_EARTH] + Vector(6.7e6, 1.2e5, -3.1e5));
+
+	// all list lengths, to exercise the vector remainder handling
+	vector<int> idx;
+	for (int nidx = 0; nidx <= (int)ts.size(); nidx++) {
+		idx.clear();
+		for (int j = 0; j < nidx; j++) idx.push_back ((j*7) % (int)ts.size()); // permuted order
+		Vector ref = GaccReference (ts.pos, ts.gm, idx.data(), nidx, gpos);
+		for (int type = GRAVKERNEL_SCALAR; type <= GravKernelSupported(); type++) {
+			Vector acc = GaccPointMass (src, idx.data(), nidx, gpos, (GravKernelType)type);
+			INFO(GravKernelName ((GravKernelType)type) << ", " << nidx << " sources");
+			REQUIRE((acc - ref).length() <= 1e-13 * ref.length());
+		}
+	}
+}
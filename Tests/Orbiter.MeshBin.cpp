@@ -0,0 +1,154 @@
+#include "MeshBin.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include "catch2/catch_all.hpp"
+
+// Small mesh exercising the group options of the text format
+static const char *TestMesh =
+	"MSHX1\n"
+	"GROUPS 3\n"
+	"MATERIAL 1\n"
+	"TEXTURE 1\n"
+	"LABEL Box\n"
+	"FLAG 3\n"
+	"ZBIAS 2\n"
+	"TEXWRAP UV\n"
+	"GEOM 4 2\n"
+	"0 0 0 0 0 1 0 0\n"
+	"1 0 0 0 0 1 1 0\n"
+	"1 1 0 0 0 1 1 1\n"
+	"0 1 0 0 0 1 0 1\n"
+	"0 1 2\n"
+	"0 2 3\n"
+	"NONORMAL\n"
+	"FLIP\n"
+	"STATIC\n"
+	"GEOM 3 1\n"
+	"0 0 0 0 0\n"
+	"1 0 0 1 0\n"
+	"0 1 0 0 1\n"
+	"0 1 2\n"
+	"MATERIAL 0\n"
+	"GEOM 3 1\n"
+	"0 0 1\n"
+	"1 0 1\n"
+	"0 1 1\n"
+	"0 1 2\n"
+	"MATERIALS 1\n"
+	"white\n"
+	"MATERIAL white\n"
+	"1 1 1 1\n"
+	"0.5 0.5 0.5 1\n"
+	"0.2 0.2 0.2 1 10\n"
+	"0 0 0 1\n"
+	"TEXTURES 2\n"
+	"Test\\box.dds D\n"
+	"0\n";
+
+static std::string ReadFile (const char *fname)
+{
+	std::ifstream ifs (fname, std::ios::binary);
+	std::stringstream ss;
+	ss << ifs.rdbuf();
+	return ss.str();
+}
+
+static void WriteFile (const char *fname, const std::string &s)
+{
+	std::ofstream ofs (fname, std::ios::binary);
+	ofs << s;
+}
+
+TEST_CASE("Compiled mesh round trip", "[MeshBin]")
+{
+	const char *srcname = "Orbiter.MeshBin.test.msh";
+	const char *binname = "Orbiter.MeshBin.test.mshb";
+	WriteFile (srcname, TestMesh);
+
+	std::ifstream ifs (srcname);
+	MeshBinData mesh;
+	REQUIRE(MeshBin::ParseText (ifs, mesh));
+	REQUIRE(mesh.grp.size() == 3);
+	REQUIRE(mesh.grp[0].spec.mtrlIdx == 0);
+	REQUIRE(mesh.grp[0].spec.usrFlag == 3);
+	REQUIRE(mesh.grp[0].spec.zBias == 2);
+	REQUIRE(mesh.grp[0].spec.flags == 0x03);
+	REQUIRE(mesh.grp[1].spec.mtrlIdx == (uint32_t)(-2)); // inherited
+	REQUIRE(mesh.grp[1].spec.flags == 0x04);
+	REQUIRE(mesh.grp[1].idx[1] == 2);                    // flipped
+	REQUIRE(mesh.grp[1].vtx[1].tu == 1.0f);
+	REQUIRE(mesh.grp[1].vtx[0].nz == Catch::Approx(-1.0f)); // calculated normals
+	REQUIRE(mesh.grp[2].spec.mtrlIdx == (uint32_t)(-1)); // default
+	REQUIRE(mesh.grp[2].vtx[2].nz == Catch::Approx(1.0f));
+	REQUIRE(mesh.mtrl.size() == 1);
+	REQUIRE(mesh.mtrl[0].power == 10.0f);
+	REQUIRE(mesh.tex.size() == 2);
+	REQUIRE(!strcmp (mesh.tex[0].name, "Test\\box.dds"));
+	REQUIRE(mesh.tex[0].flags == MESHBIN_TEX_UNCOMPRESS);
+	REQUIRE(mesh.tex[1].name[0] == '\0');
+
+	REQUIRE(MeshBin::Compile (srcname, binname));
+	MeshBinFile f;
+	REQUIRE(f.Open (binname, srcname));
+	REQUIRE(f.Header().ngrp == 3);
+	REQUIRE(f.Header().nmtrl == 1);
+	REQUIRE(f.Header().ntex == 2);
+	for (uint32_t g = 0; g < 3; g++) {
+		const MeshBinGroup &gs = f.Group (g);
+		REQUIRE(gs.mtrlIdx == mesh.grp[g].spec.mtrlIdx);
+		REQUIRE(gs.flags == mesh.grp[g].spec.flags);
+		REQUIRE(gs.nVtx == mesh.grp[g].vtx.size());
+		REQUIRE(gs.nIdx == mesh.grp[g].idx.size());
+		REQUIRE(!memcmp (f.Vertices (g), mesh.grp[g].vtx.data(), gs.nVtx*sizeof(MeshBinVertex)));
+		REQUIRE(!memcmp (f.Indices (g), mesh.grp[g].idx.data(), gs.nIdx*sizeof(uint16_t)));
+	}
+	REQUIRE(f.Material(0).specular[0] == 0.2f);
+	REQUIRE(!strcmp (f.Texture(0).name, "Test\\box.dds"));
+	f.Close();
+
+	remove (srcname);
+	remove (binname);
+}
+
+TEST_CASE("Outdated and damaged compiled meshes are rejected", "[MeshBin]")
+{
+	const char *srcname = "Orbiter.MeshBin.test.msh";
+	const char *binname = "Orbiter.MeshBin.test.mshb";
+	WriteFile (srcname, TestMesh);
+	REQUIRE(MeshBin::Compile (srcname, binname));
+	MeshBinFile f;
+
+	// source modified
+	WriteFile (srcname, std::string (TestMesh) + "\n");
+	REQUIRE(!f.Open (binname, srcname));
+	REQUIRE(f.Open (binname));          // no source check
+	f.Close();
+
+	// source removed: the compiled mesh is used on its own
+	remove (srcname);
+	REQUIRE(f.Open (binname, srcname));
+	f.Close();
+
+	// truncated
+	std::string bin = ReadFile (binname);
+	WriteFile (binname, bin.substr (0, bin.size()-8));
+	REQUIRE(!f.Open (binname));
+
+	// vertex index out of range
+	MeshBinHeader hdr;
+	MeshBinGroup grp;
+	memcpy (&hdr, bin.data(), sizeof(MeshBinHeader));
+	memcpy (&grp, bin.data() + sizeof(MeshBinHeader), sizeof(MeshBinGroup));
+	uint16_t badidx = 4;
+	bin.replace ((size_t)grp.idxOfs, sizeof(uint16_t), (const char*)&badidx, sizeof(uint16_t));
+	WriteFile (binname, bin);
+	REQUIRE(!f.Open (binname));
+
+	REQUIRE(!f.Open ("Orbiter.MeshBin.missing.mshb"));
+	remove (binname);
+}
@@ -0,0 +1,211 @@
+#include "RKAdaptive.h"
+#include "Vecmat.h"
+
+#include <vector>
+#include <algorithm>
+
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+static const RKPair *Pairs[] = { &RK_DP54, &RK_RKF78 };
+static const char *PairName[] = { "DP5(4)", "RKF7(8)" };
+
+static const double MU = 3.986004418e14; // Earth GM [m^3/s^2]
+
+static Vector KeplerAcc (const Vector &r)
+{
+	double d = r.length();
+	return r * (-MU/(d*d*d));
+}
+
+static double Energy (const Vector &r, const Vector &v)
+{
+	return 0.5*dotp (v, v) - MU/r.length();
+}
+
+struct PropStats {
+	double hmin = 1e20, hmax = 0.0;  // range of accepted internal steps
+	int naccept = 0, nreject = 0;
+};
+
+// Propagates a Kepler orbit over interval h, with the stage evaluation and
+// error norm of RigidBody::RKdrv_LinAng_Adaptive (linear state only).
+// hs is the internal step carried over between calls.
+static void Propagate (const RKPair &rk, double tol, Vector &pos, Vector &vel, double h, double &hs, PropStats &stats)
+{
+	int i, j, n = rk.n;
+	Vector p[RK_MAXSTAGE], v[RK_MAXSTAGE], a[RK_MAXSTAGE];
+	RKStepControl ctrl (rk, h, hs);
+	double pscale = tol * std::max (pos.length(), 1.0);
+	double vscale = tol * std::max (vel.length(), 1.0);
+	Vector acc = KeplerAcc (pos);
+
+	while (!ctrl.Done()) {
+		double hh = ctrl.Step();
+		const double *b = rk.beta;
+		p[0] = pos, v[0] = vel, a[0] = acc;
+		for (i = 1; i < n; i++) {
+			p[i] = pos, v[i] = vel;
+			for (j = 0; j < i; j++) {
+				p[i] += v[j] * (b[j]*hh);
+				v[i] += a[j] * (b[j]*hh);
+			}
+			a[i] = KeplerAcc (p[i]);
+			b += n-1;
+		}
+		Vector ep, ev;
+		for (i = 0; i < n; i++) {
+			ep += v[i] * (rk.gerr[i]*hh);
+			ev += a[i] * (rk.gerr[i]*hh);
+		}
+		if (!ctrl.Update (std::max (ep.length()/pscale, ev.length()/vscale)))
+			continue;
+		for (i = 0; i < n; i++) {
+			pos += v[i] * (rk.gamma[i]*hh);
+			vel += a[i] * (rk.gamma[i]*hh);
+		}
+		acc = (rk.fsal ? a[n-1] : KeplerAcc (pos));
+		stats.hmin = std::min (stats.hmin, hh);
+		stats.hmax = std::max (stats.hmax, hh);
+	}
+	stats.naccept += ctrl.nAccepted();
+	stats.nreject += ctrl.nRejected();
+	hs = ctrl.NextStep();
+}
+
+TEST_CASE("Embedded pairs have consistent tableaux", "[RKAdaptive]")
+{
+	for (int k = 0; k < 2; k++) {
+		const RKPair &rk = *Pairs[k];
+		INFO(PairName[k]);
+		REQUIRE(rk.n <= RK_MAXSTAGE);
+		double sg = 0.0, se = 0.0;
+		for (int i = 0; i < rk.n; i++) {
+			sg += rk.gamma[i];
+			se += rk.gerr[i];
+		}
+		CHECK(sg == Approx(1.0).epsilon(1e-14));
+		CHECK(se == Approx(0.0).margin(1e-14));
+		for (int i = 1; i < rk.n; i++) {
+			double sb = 0.0;
+			for (int j = 0; j < i; j++) sb += rk.beta[(i-1)*(rk.n-1)+j];
+			INFO("stage " << i);
+			CHECK(sb == Approx(rk.alpha[i-1]).margin(1e-14));
+		}
+		if (rk.fsal) { // last stage is evaluated at the propagated solution
+			for (int j = 0; j < rk.n-1; j++)
+				CHECK(rk.beta[(rk.n-2)*(rk.n-1)+j] == rk.gamma[j]);
+			CHECK(rk.alpha[rk.n-2] == 1.0);
+		}
+	}
+}
+
+TEST_CASE("Circular orbit error is controlled by the tolerance", "[RKAdaptive]")
+{
+	const double r0 = 7.0e6, v0 = sqrt (MU/r0), w = v0/r0, T = Pi2/w;
+	const double tols[] = { 1e-8, 1e-10, 1e-12 };
+
+	for (int k = 0; k < 2; k++) {
+		double perr[3];
+		for (int m = 0; m < 3; m++) {
+			Vector pos (r0, 0, 0), vel (0, v0, 0);
+			double hs = 0.0, e0 = Energy (pos, vel);
+			PropStats stats;
+			const int nframe = 100;
+			for (int f = 0; f < nframe; f++)
+				Propagate (*Pairs[k], tols[m], pos, vel, T/nframe, hs, stats);
+			perr[m] = (pos - Vector(r0, 0, 0)).length() / r0;
+			double eerr = fabs ((Energy (pos, vel) - e0) / e0);
+			INFO(PairName[k] << ", tol " << tols[m] << ": position error " << perr[m] << ", energy error " << eerr
+				<< ", " << stats.naccept << " steps, " << stats.nreject << " rejected");
+			// the global error after one orbit stays within a modest multiple
+			// of the local tolerance per step
+			CHECK(perr[m] < 10.0 * tols[m] * stats.naccept);
+			CHECK(eerr < 10.0 * tols[m] * stats.naccept);
+			// steps are carried over between frames, so the step size settles
+			// and few steps are rejected
+			CHECK(stats.nreject <= 2);
+		}
+		// tighter tolerances reduce the error, until it reaches round-off
+		// (RKF7(8) with steps limited to the frame length is there already)
+		INFO("position errors " << perr[0] << ", " << perr[1] << ", " << perr[2]);
+		const double roundoff = 1e-12;
+		CHECK((perr[1] < perr[0] || perr[0] < roundoff));
+		CHECK((perr[2] < perr[1] || perr[1] < roundoff));
+	}
+}
+
+TEST_CASE("Step size follows the orbit", "[RKAdaptive]")
+{
+	// eccentric orbit (e = 0.7), started at periapsis
+	const double rp = 7.0e6, e = 0.7, a = rp/(1.0-e), T = Pi2*sqrt (a*a*a/MU);
+	const double vp = sqrt (MU*(1.0+e)/rp);
+
+	for (int k = 0; k < 2; k++) {
+		Vector pos (rp, 0, 0), vel (0, vp, 0);
+		double hs = T; // initial step far too large: must be rejected
+		PropStats peri, apo;
+		Propagate (*Pairs[k], 1e-10, pos, vel, 0.02*T, hs, peri);  // periapsis passage
+		INFO(PairName[k]);
+		CHECK(peri.nreject > 0);
+		for (int f = 0; f < 24; f++) {
+			PropStats stats;
+			Propagate (*Pairs[k], 1e-10, pos, vel, 0.02*T, hs, stats);
+		}
+		Propagate (*Pairs[k], 1e-10, pos, vel, 0.02*T, hs, apo);    // near apoapsis
+		INFO("step size at periapsis " << peri.hmin << ", at apoapsis " << apo.hmax);
+		CHECK(pos.length() > 0.99*a*(1.0+e));
+		CHECK(apo.hmax > 5.0*peri.hmin);
+		CHECK(apo.naccept < peri.naccept);
+	}
+}
+
+TEST_CASE("Step control", "[RKAdaptive]")
+{
+	const double keep = pow (0.9, 5.0); // DP5 error that keeps the step size
+	SECTION("final step is truncated at the end of the interval") {
+		RKStepControl ctrl (RK_DP54, 10.0, 4.0);
+		CHECK(ctrl.Step() == 4.0);
+		CHECK(ctrl.Update (keep));
+		CHECK(ctrl.Step() == Approx(4.0));
+		CHECK(ctrl.Update (keep));
+		CHECK(ctrl.Step() == Approx(2.0));
+		CHECK(ctrl.Update (1e-6));
+		CHECK(ctrl.Done());
+		CHECK(ctrl.Time() == 10.0);
+		// a truncated step with small error doesn't grow the step size
+		CHECK(ctrl.NextStep() == Approx(4.0));
+	}
+	SECTION("steps with large errors are rejected and repeated with a smaller step") {
+		RKStepControl ctrl (RK_DP54, 10.0, 10.0);
+		CHECK(ctrl.Step() == 10.0);
+		CHECK_FALSE(ctrl.Update (32.0));
+		CHECK(ctrl.Time() == 0.0);
+		CHECK(ctrl.NextStep() == Approx(10.0*0.9*pow (32.0, -0.2)));
+		CHECK_FALSE(ctrl.Update (1e10));  // shrink at most by a factor of 5
+		CHECK(ctrl.NextStep() == Approx(2.0));
+		CHECK(ctrl.nRejected() == 2);
+		CHECK(ctrl.nAccepted() == 0);
+	}
+	SECTION("steps with small errors grow the step size by at most a factor of 5") {
+		RKStepControl ctrl (RK_RKF78, 100.0, 1.0);
+		ctrl.Step();
+		CHECK(ctrl.Update (0.0));
+		CHECK(ctrl.NextStep() == 5.0);
+		ctrl.Step (2.0);
+		CHECK(ctrl.Update (0.5));
+		CHECK(ctrl.NextStep() == Approx(2.0*0.9*pow (0.5, -1.0/8.0)));
+	}
+	SECTION("steps are accepted after the step limit") {
+		RKStepControl ctrl (RK_DP54, 1.0, 1.0, 3);
+		ctrl.Step();
+		CHECK_FALSE(ctrl.Update (100.0));
+		ctrl.Step();
+		CHECK_FALSE(ctrl.Update (100.0));
+		ctrl.Step();
+		CHECK_FALSE(ctrl.Update (100.0));
+		ctrl.Step();
+		CHECK(ctrl.Update (100.0));
+	}
+}
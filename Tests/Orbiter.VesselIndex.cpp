@@ -0,0 +1,132 @@
+#include "VesselIndex.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "catch2/catch_all.hpp"
+
+using std::vector;
+
+// The index only stores vessel pointers, so the tests use the addresses of
+// the entries of a dummy array as vessel handles.
+struct TestFleet {
+	struct Ref {
+		const Body *body;
+		Vector pos;
+	};
+	vector<char> id;         // vessel handle storage
+	vector<Vector> gpos;
+	vector<int> ref;
+	vector<Ref> refs;
+
+	TestFleet (size_t n, unsigned int seed = 1)
+	{
+		const double au = 1.496e11;
+		// reference bodies: Earth, Moon and a body far out with a wide vessel spread
+		refs.push_back ({(const Body*)0x10, Vector(au,0,0)});
+		refs.push_back ({(const Body*)0x20, Vector(au+3.84e8,0,0)});
+		refs.push_back ({(const Body*)0x30, Vector(0,30.1*au,0)});
+		std::mt19937 rng (seed);
+		std::uniform_real_distribution<double> u (-1.0, 1.0);
+		std::uniform_int_distribution<int> pick (0, 9);
+		id.resize (n);
+		for (size_t i = 0; i < n; i++) {
+			int p = pick (rng);
+			int r;
+			Vector d;
+			if (p < 3) {        // cluster around a station in LEO
+				r = 0;
+				d = Vector(6.771e6,0,0) + Vector(u(rng),u(rng),u(rng))*2e3;
+			} else if (p < 7) { // scattered in Earth orbit
+				r = 0;
+				d = Vector(u(rng),u(rng),u(rng))*4e7;
+			} else if (p < 9) { // lunar orbit
+				r = 1;
+				d = Vector(u(rng),u(rng),u(rng))*3e6;
+			} else {            // interplanetary
+				r = 2;
+				d = Vector(u(rng),u(rng),u(rng))*1e12;
+			}
+			gpos.push_back (refs[r].pos + d);
+			ref.push_back (r);
+		}
+	}
+	Vessel *V (size_t i) const { return (Vessel*)&id[i]; }
+	size_t Idx (const Vessel *v) const { return (const char*)v - &id[0]; }
+	void Build (VesselIndex &idx) const
+	{
+		idx.Clear();
+		for (size_t i = 0; i < id.size(); i++)
+			idx.Add (V(i), refs[ref[i]].body, refs[ref[i]].pos, gpos[i], 10.0 + i%50);
+		idx.Finalise();
+	}
+};
+
+TEST_CASE("Range query matches brute force search", "[VesselIndex]")
+{
+	TestFleet fleet (4000);
+	VesselIndex idx;
+	fleet.Build (idx);
+	REQUIRE(idx.nVessel() == 4000);
+	REQUIRE(idx.MaxSize() == 59.0);
+
+	const double range[] = {10.0, 1e3, 5e3, 1e6, 1e8, 1e13};
+	for (size_t q = 0; q < fleet.gpos.size(); q += 97) {
+		for (double r : range) {
+			const Vessel *exclude = (q % 2 ? fleet.V(q) : 0);
+			vector<Vessel*> res;
+			idx.InRange (fleet.gpos[q], r, res, exclude);
+			vector<size_t> found, expected;
+			for (auto v : res) found.push_back (fleet.Idx (v));
+			for (size_t i = 0; i < fleet.gpos.size(); i++)
+				if (fleet.V(i) != exclude && fleet.gpos[i].dist (fleet.gpos[q]) <= r)
+					expected.push_back (i);
+			std::sort (found.begin(), found.end());
+			REQUIRE(found == expected);
+		}
+	}
+}
+
+TEST_CASE("Nearest neighbour query matches brute force search", "[VesselIndex]")
+{
+	TestFleet fleet (4000, 7);
+	VesselIndex idx;
+	fleet.Build (idx);
+
+	const size_t kval[] = {1, 5, 50};
+	for (size_t q = 0; q < fleet.gpos.size(); q += 131) {
+		for (size_t k : kval) {
+			vector<Vessel*> res;
+			vector<double> dist;
+			REQUIRE(idx.Nearest (fleet.gpos[q], k, res, fleet.V(q), &dist) == k);
+			vector<double> expected;
+			for (size_t i = 0; i < fleet.gpos.size(); i++)
+				if (i != q) expected.push_back (fleet.gpos[i].dist (fleet.gpos[q]));
+			std::sort (expected.begin(), expected.end());
+			for (size_t j = 0; j < k; j++) {
+				REQUIRE(dist[j] == Catch::Approx(expected[j]));
+				REQUIRE(fleet.gpos[fleet.Idx (res[j])].dist (fleet.gpos[q]) == Catch::Approx(dist[j]));
+			}
+		}
+	}
+
+	// asking for more vessels than exist returns all of them
+	vector<Vessel*> all;
+	REQUIRE(idx.Nearest (Vector(0,0,0), 10000, all) == 4000);
+}
+
+TEST_CASE("Empty and invalidated index", "[VesselIndex]")
+{
+	VesselIndex idx;
+	vector<Vessel*> res;
+	REQUIRE(idx.Valid());
+	REQUIRE(idx.InRange (Vector(0,0,0), 1e20, res) == 0);
+	REQUIRE(idx.Nearest (Vector(0,0,0), 3, res) == 0);
+	idx.Invalidate();
+	REQUIRE(!idx.Valid());
+	TestFleet fleet (10);
+	fleet.Build (idx);
+	REQUIRE(idx.Valid());
+	REQUIRE(idx.InRange (Vector(0,0,0), 1e20, res) == 10);
+}
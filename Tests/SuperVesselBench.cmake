@@ -0,0 +1,62 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Benchmark for large docked assemblies.
+# Generates scenarios with a chain of an increasing number of docked modules,
+# with propellant flowing in all components (see Script/Tests/SuperVesselBench.lua),
+# runs each with Orbiter_server in benchmark mode for a fixed number of frames,
+# and reports the mean frame and propagation times. The cost per module should
+# stay approximately constant as the assembly grows.
+#
+# Usage:
+#   cmake -DORBITER=<Orbiter_server> -DWORKDIR=<orbiter root> [-DMODULES="10;60"]
+#         [-DFRAMES=<n>] -P SuperVesselBench.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/BenchCommon.cmake)
+
+bench_require(ORBITER WORKDIR)
+bench_default(MODULES 10 30 60 120 240)
+bench_default(FRAMES 500)
+
+# Write a scenario with a chain of nmodule docked modules in low Earth orbit
+function(write_scenario fname nmodule)
+	set(ships "")
+	math(EXPR imax "${nmodule} - 1")
+	foreach(i RANGE ${imax})
+		math(EXPR z "${i} * 10")
+		math(EXPR inext "${i} + 1")
+		math(EXPR iprev "${i} - 1")
+		set(dock "")
+		if(i LESS imax)
+			string(APPEND dock " 0:1,M-${inext}")
+		endif()
+		if(i GREATER 0)
+			string(APPEND dock " 1:0,M-${iprev}")
+		endif()
+		string(APPEND ships "M-${i}:Module1\n  STATUS Orbiting Earth\n")
+		string(APPEND ships "  RPOS 6800000.00 0.00 ${z}.00\n  RVEL 0.000 7656.220 0.000\n")
+		string(APPEND ships "  AROT 0.00 0.00 0.00\n")
+		if(dock)
+			string(APPEND ships "  DOCKINFO${dock}\n")
+		endif()
+		string(APPEND ships "END\n")
+	endforeach()
+	bench_write_scenario(${fname} M-0 "${ships}" Tests/SuperVesselBench)
+endfunction()
+
+message(STATUS "Docked assembly benchmark (${FRAMES} frames)")
+message(STATUS "modules   frame [ms]   propagation [ms]")
+foreach(n ${MODULES})
+	set(scn "${SCN_DIR}/SuperVessel_${n}.scn")
+	set(report "${SCN_DIR}/SuperVessel_${n}.json")
+	write_scenario(${scn} ${n})
+	file(REMOVE ${report})
+	bench_run(${scn} "--bench=${report}" "--maxframes=${FRAMES}" "--fixedstep=0.1")
+	if(NOT EXISTS ${report})
+		message(FATAL_ERROR "No benchmark report for ${scn}")
+	endif()
+	file(READ ${report} json)
+	string(JSON frame_ms GET "${json}" frame mean_ms)
+	string(JSON prop_ms GET "${json}" phases Propagation mean_ms)
+	message(STATUS "${n}   ${frame_ms}   ${prop_ms}")
+endforeach()
@@ -0,0 +1,71 @@
+// Shared fixtures for the engine component tests: gravity and ephemeris
+// sources. Include before catch2.
+
+#ifndef __TESTSOURCES_H
+#define __TESTSOURCES_H
+
+#include "Vecmat.h"
+#include <vector>
+
+// these collide with std::min/max
+#undef min
+#undef max
+
+// Solar system bodies on circular orbits, in the ecliptic frame of the
+// engine (y = ecliptic north)
+struct TestBody {
+	const char *name;
+	double gm;     // gravitational parameter [m^3/s^2]
+	double a;      // orbit radius [m]
+	double T;      // orbit period [days] (0: at rest)
+	double incl;   // orbit inclination [rad]
+	double L0;     // mean longitude at MJD 51544.5 [rad]
+	int ref;       // index of the orbited body (-1: origin)
+};
+
+static const double TEST_AU = 1.496e11;
+static const double TEST_RAD = 3.14159265358979323846/180.0;
+
+static const TestBody TestBodies[] = {
+	{"Sun",     1.327e20, 0.0,          0.0,      0.0,          0.0,          -1},
+	{"Mercury", 2.203e13, 0.387*TEST_AU, 87.969,   7.00*TEST_RAD, 252.25*TEST_RAD, 0},
+	{"Venus",   3.249e14, 0.723*TEST_AU, 224.701,  3.39*TEST_RAD, 181.98*TEST_RAD, 0},
+	{"Earth",   3.986e14, 1.000*TEST_AU, 365.256,  0.0,          100.46*TEST_RAD, 0},
+	{"Moon",    4.905e12, 3.844e8,       27.3217,  5.15*TEST_RAD, 218.32*TEST_RAD, 3},
+	{"Mars",    4.283e13, 1.524*TEST_AU, 686.98,   1.85*TEST_RAD, 355.45*TEST_RAD, 0},
+	{"Jupiter", 1.267e17, 5.203*TEST_AU, 4332.6,   1.30*TEST_RAD,  34.40*TEST_RAD, 0},
+	{"Saturn",  3.793e16, 9.537*TEST_AU, 10759.2,  2.49*TEST_RAD,  49.94*TEST_RAD, 0},
+	{"Uranus",  5.794e15, 19.19*TEST_AU, 30687.2,  0.77*TEST_RAD, 313.23*TEST_RAD, 0},
+	{"Neptune", 6.837e15, 30.07*TEST_AU, 60190.0,  1.77*TEST_RAD, 304.88*TEST_RAD, 0}
+};
+static const int nTestBody = sizeof(TestBodies)/sizeof(TestBodies[0]);
+static const int TEST_EARTH = 3, TEST_MOON = 4;
+
+// Position [m] and velocity [m/s] of TestBodies[i] at mjd
+inline void TestBodyState (int i, double mjd, Vector &pos, Vector &vel)
+{
+	const TestBody &b = TestBodies[i];
+	if (b.ref >= 0) TestBodyState (b.ref, mjd, pos, vel);
+	else            pos = vel = Vector(0,0,0);
+	if (b.T) {
+		double w = 2.0*3.14159265358979323846/(b.T*86400.0);
+		double L = b.L0 + w*(mjd-51544.5)*86400.0;
+		double cL = cos(L), sL = sin(L), ci = cos(b.incl), si = sin(b.incl);
+		pos += Vector( b.a*cL,   b.a*sL*si,   b.a*sL*ci);
+		vel += Vector(-b.a*w*sL, b.a*w*cL*si, b.a*w*cL*ci);
+	}
+}
+
+// Acceleration at p from point masses gm at positions pos
+inline Vector PointMassAcc (const std::vector<Vector> &pos, const std::vector<double> &gm, const Vector &p)
+{
+	Vector acc;
+	for (size_t i = 0; i < gm.size(); i++) {
+		Vector d (pos[i] - p);
+		double r = d.length();
+		acc += d * (gm[i] / (r*r*r));
+	}
+	return acc;
+}
+
+#endif // !__TESTSOURCES_H
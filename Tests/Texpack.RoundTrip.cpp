@@ -0,0 +1,195 @@
+#include "TreePack.h"
+#include "ZTreeMgr.h"
+
+#include <string.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "catch2/catch_all.hpp"
+
+namespace fs = std::filesystem;
+
+static const char *Root = "Texpack.RoundTrip.test";
+
+struct TileId {
+	int lvl, ilat, ilng;
+	bool operator< (const TileId &t) const
+	{ return lvl != t.lvl ? lvl < t.lvl : ilat != t.ilat ? ilat < t.ilat : ilng < t.ilng; }
+};
+
+// The level 1-4 roots, and sparse tiles further down. Some of the deeper
+// tiles have ancestors without a tile file.
+static const TileId TestTiles[] = {
+	{1,0,0}, {2,0,0}, {3,0,0}, {4,0,0}, {4,0,1},
+	{5,0,1}, {5,1,2}, {6,2,5}, {7,5,10}, {7,5,11}, {8,11,22},
+	{9,20,50}, {10,41,101}
+};
+static const int NTestTiles = sizeof(TestTiles)/sizeof(TileId);
+
+typedef std::map<TileId, std::string> TileSet;
+
+// Partly compressible tile contents
+static std::string TileData (const TileId &t, int version = 0)
+{
+	size_t n = 1000 + 137*t.lvl + 11*t.ilat + 7*t.ilng + 50*version;
+	std::string s(n, 0);
+	unsigned int r = t.lvl*7919 + t.ilat*104729 + t.ilng*1299709 + version;
+	for (size_t i = 0; i < n; i++) {
+		r = r*1103515245 + 12345;
+		s[i] = (char)((i/16 + t.lvl) ^ ((r >> 16) & 3));
+	}
+	return s;
+}
+
+static fs::path TilePath (const TileId &t)
+{
+	char cbuf[64];
+	sprintf (cbuf, "%02d/%06d/%06d.dds", t.lvl, t.ilat, t.ilng);
+	return fs::path(Root) / "Surf" / cbuf;
+}
+
+static std::string ReadFile (const fs::path &fname)
+{
+	std::ifstream ifs (fname, std::ios::binary);
+	std::stringstream ss;
+	ss << ifs.rdbuf();
+	return ss.str();
+}
+
+static void WriteTile (const TileId &t, const std::string &data)
+{
+	fs::create_directories (TilePath (t).parent_path());
+	std::ofstream ofs (TilePath (t), std::ios::binary | std::ios::trunc);
+	ofs << data;
+}
+
+static TileSet WriteTestTiles ()
+{
+	fs::remove_all (Root);
+	TileSet tiles;
+	for (int i = 0; i < NTestTiles; i++) {
+		tiles[TestTiles[i]] = TileData (TestTiles[i]);
+		WriteTile (TestTiles[i], tiles[TestTiles[i]]);
+	}
+	return tiles;
+}
+
+static void SetFileAge (const fs::path &fname, int sec)
+{
+	// relative to the archive, independent of file system time resolution
+	fs::last_write_time (fname, fs::last_write_time (ArchivePath (Root, "Surf")) + std::chrono::seconds(sec));
+}
+
+// Read all tiles back through the tree manager used by Orbiter
+static void CheckArchive (const TileSet &tiles)
+{
+	ZTreeMgr *mgr = ZTreeMgr::CreateFromFile (Root, ZTreeMgr::LAYER_SURF);
+	REQUIRE(mgr);
+	for (auto it = tiles.begin(); it != tiles.end(); it++) {
+		const TileId &t = it->first;
+		BYTE *data = 0;
+		DWORD ndata = mgr->ReadData (t.lvl, t.ilat, t.ilng, &data);
+		REQUIRE(ndata == it->second.size());
+		REQUIRE(!memcmp (data, it->second.data(), ndata));
+		mgr->ReleaseData (data);
+	}
+	// ancestor without tile file: present, but no data
+	BYTE *data = 0;
+	CHECK(mgr->Idx (8, 10, 25) != (DWORD)-1);
+	CHECK(mgr->ReadData (8, 10, 25, &data) == 0);
+	// not in the tree
+	CHECK(mgr->Idx (6, 0, 0) == (DWORD)-1);
+	CHECK(mgr->Idx (11, 82, 202) == (DWORD)-1);
+	delete mgr;
+}
+
+TEST_CASE("Texpack archive round trip", "[Texpack]")
+{
+	TileSet tiles = WriteTestTiles();
+
+	// a tiny memory budget forces the producers to wait for the writer
+	TreePackParam prm;
+	prm.nthread = 4;
+	prm.membudget = 1;
+	prm.verbose = false;
+	TreePackStats stats;
+	REQUIRE(PackLayer (Root, "Surf", prm, &stats));
+	CHECK(stats.nnode == 17);
+	CHECK(stats.ndeflate == NTestTiles);
+	CHECK(stats.ncopy == 0);
+	CheckArchive (tiles);
+
+	// the archive doesn't depend on the number of threads
+	std::string arc = ReadFile (ArchivePath (Root, "Surf"));
+	prm.nthread = 1;
+	prm.membudget = 256 << 20;
+	REQUIRE(PackLayer (Root, "Surf", prm));
+	CHECK(ReadFile (ArchivePath (Root, "Surf")) == arc);
+
+	// level limit
+	prm.maxlvl = 8;
+	REQUIRE(PackLayer (Root, "Surf", prm, &stats));
+	CHECK(stats.ndeflate == NTestTiles-2);
+	prm.maxlvl = 19;
+	REQUIRE(PackLayer (Root, "Surf", prm));
+
+	// unpack
+	fs::remove_all (fs::path(Root) / "Surf");
+	REQUIRE(ExtractLayer (Root, "Surf", 19));
+	for (auto it = tiles.begin(); it != tiles.end(); it++)
+		REQUIRE(ReadFile (TilePath (it->first)) == it->second);
+
+	REQUIRE(!PackLayer (Root, "Unknown", prm));
+	fs::remove_all (Root);
+}
+
+TEST_CASE("Texpack incremental repack", "[Texpack]")
+{
+	TileSet tiles = WriteTestTiles();
+	TreePackParam prm;
+	prm.nthread = 4;
+	prm.verbose = false;
+	REQUIRE(PackLayer (Root, "Surf", prm));
+	for (auto it = tiles.begin(); it != tiles.end(); it++)
+		SetFileAge (TilePath (it->first), -10);
+
+	// changed tile size, changed tile contents, a new tile, and a tile
+	// that is only present in the archive
+	const TileId t1 = {7,5,10}, t2 = {4,0,1}, t3 = {8,11,23}, t4 = {9,20,50};
+	tiles[t1] = TileData (t1, 1);
+	WriteTile (t1, tiles[t1]);
+	std::string d2 = tiles[t2];
+	d2[100] ^= 1;
+	tiles[t2] = d2;
+	WriteTile (t2, tiles[t2]);
+	SetFileAge (TilePath (t2), 10);
+	tiles[t3] = TileData (t3);
+	WriteTile (t3, tiles[t3]);
+	fs::remove (TilePath (t4));
+
+	prm.incremental = true;
+	TreePackStats stats;
+	REQUIRE(PackLayer (Root, "Surf", prm, &stats));
+	CHECK(stats.ndeflate == 3);
+	CHECK(stats.ncopy == NTestTiles-2);
+	CheckArchive (tiles);
+
+	// same result as a full rebuild
+	WriteTile (t4, tiles[t4]);
+	for (auto it = tiles.begin(); it != tiles.end(); it++)
+		SetFileAge (TilePath (it->first), -10);
+	std::string arc = ReadFile (ArchivePath (Root, "Surf"));
+	REQUIRE(PackLayer (Root, "Surf", prm, &stats));
+	CHECK(stats.ndeflate == 0);
+	CHECK(ReadFile (ArchivePath (Root, "Surf")) == arc);
+	prm.incremental = false;
+	REQUIRE(PackLayer (Root, "Surf", prm, &stats));
+	CHECK(stats.ndeflate == NTestTiles+1);
+	CHECK(ReadFile (ArchivePath (Root, "Surf")) == arc);
+
+	fs::remove_all (Root);
+}
@@ -0,0 +1,69 @@
+# Copyright (c) Martin Schweiger
+# Licensed under the MIT License
+
+# Benchmark for concurrent vessel propagation.
+# Generates scenarios with an increasing number of free-flying vessels, runs
+# each with Orbiter_server for a fixed number of frames, single-threaded and
+# with the default number of propagation threads, and reports the speedup of
+# the propagation phase as logged by the planetary system at session end.
+#
+# Usage:
+#   cmake -DORBITER=<Orbiter_server> -DWORKDIR=<orbiter root> [-DVESSELS="10;100"]
+#         [-DFRAMES=<n>] [-DTHREADS=<n>] -P VesselPropagationBench.cmake
+
+include(${CMAKE_CURRENT_LIST_DIR}/BenchCommon.cmake)
+
+bench_require(ORBITER WORKDIR)
+bench_default(VESSELS 10 50 100 200 400)
+bench_default(FRAMES 500)
+bench_default(THREADS 0)
+
+# Write a scenario with nvessel ShuttlePBs distributed over low Earth orbits
+function(write_scenario fname nvessel)
+	set(ships "")
+	math(EXPR imax "${nvessel} - 1")
+	foreach(i RANGE ${imax})
+		math(EXPR a "6700000 + (${i} % 20) * 25000")
+		math(EXPR inc "(${i} * 7) % 90")
+		math(EXPR lan "(${i} * 37) % 360")
+		math(EXPR lng "(${i} * 53) % 360")
+		string(APPEND ships "PB-${i}:ShuttlePB\n  STATUS Orbiting Earth\n")
+		string(APPEND ships "  ELEMENTS ${a} 0.001 ${inc} ${lan} 0 ${lng} 51982.5\n")
+		string(APPEND ships "  AROT 0 0 0\n  FUEL 1.000\nEND\n")
+	endforeach()
+	bench_write_scenario(${fname} PB-0 "${ships}")
+endfunction()
+
+# Run a scenario and return the propagation time per frame in units of 0.1us
+function(run_scenario scn nthread result)
+	bench_run(${scn} "--maxframes=${FRAMES}" "--fixedstep=0.1" "--propthreads=${nthread}")
+	bench_log_line("Vessel propagation:" line)
+	string(REGEX MATCH "([0-9]+) thread.*, ([0-9]+)\\.([0-9]+) ms/frame" match "${line}")
+	if(NOT match)
+		message(FATAL_ERROR "No propagation statistics in Orbiter.log")
+	endif()
+	math(EXPR t "${CMAKE_MATCH_2} * 10000 + 1${CMAKE_MATCH_3} - 10000")
+	set(${result} ${t} PARENT_SCOPE)
+	set(${result}_threads ${CMAKE_MATCH_1} PARENT_SCOPE)
+	set(${result}_ms "${CMAKE_MATCH_2}.${CMAKE_MATCH_3}" PARENT_SCOPE)
+endfunction()
+
+message(STATUS "Vessel propagation benchmark (${FRAMES} frames)")
+message(STATUS "vessels   1 thread [ms/frame]   n threads [ms/frame]   speedup")
+foreach(n ${VESSELS})
+	set(scn "${SCN_DIR}/Propagation_${n}.scn")
+	write_scenario(${scn} ${n})
+	run_scenario(${scn} 1 t1)
+	run_scenario(${scn} ${THREADS} tn)
+	if(tn GREATER 0)
+		math(EXPR speedup "(${t1} * 100) / ${tn}")
+	else()
+		set(speedup 0)
+	endif()
+	math(EXPR s_int "${speedup} / 100")
+	math(EXPR s_frac "${speedup} % 100")
+	if(s_frac LESS 10)
+		set(s_frac "0${s_frac}")
+	endif()
+	message(STATUS "${n}   ${t1_ms}   ${tn_ms} (${tn_threads} threads)   ${s_int}.${s_frac}")
+endforeach()
@@ -55,6 +55,9 @@
 #include <windows.h>
 #include <math.h>
 #include <ddraw.h>
+#include <vector>
+#include "DxtEnc.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
@@ -139,7 +142,6 @@ void SortTextures (const char *rootname);
 void CopyTexturesAtLevel (TILEFILESPEC *td, DWORD baseidx, DWORD lvl, DWORD tgtlvl, DWORD &texidx, DWORD &maskidx,
 	FILE *srctexf, FILE *srcmaskf, FILE *tgttexf, FILE *tgtmaskf);
 
-void SetOutputHeader (BITMAPFILEHEADER &bmfh, BITMAPINFOHEADER &bmih, LONG w, LONG h);
 RGB *BinaryCompress (RGB *src, LONG srcw, LONG srch, LONG tgtw, long tgth);
 
 BYTE *Compress (int nch, BYTE *src, LONG srcw, LONG srch, LONG tgtw, long tgth, int which = HEMISPHERE_BOTH);
@@ -167,6 +169,10 @@ DWORD CatDDS (FILE *dds, RGB *img, Alpha *aimg, LONG imgw, LONG imgh, bool force
 
 WORD CatMaskDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh);
 
+DWORD WriteDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh, DxtFormat fmt, bool mipmap = false);
+// Compresses the texture and appends it to the texture file. Returns the size
+// of the texture data, including any mipmaps
+
 DWORD CopyDDS (FILE *ftgt, FILE *fsrc, DWORD idx, bool idx_is_ofs = false);
 // Copy a texture from a given position in a source file to the end of a target file.
 // Returns the size of the copied data block, including any mipmaps (or 0 if no
@@ -201,10 +207,10 @@ void FatalError (const char *msg);
 void InitProgress (int ntot, int len);
 void SetProgress (int p);
 void IncProgress ();
+void ReportCompression ();
 
 
 const double eps = 1e-10;
-const char *dxtex = ".\\dxtex.exe";
 char g_cwd[256];
 char fname[256] = "\0";
 char aname[256] = "\0";
@@ -216,6 +222,10 @@ int g_minres = 0, g_maxres = 0;
 double g_tol = 0.0;        // tolerance for suppressing opaque/transparent pixels in a tile
 double g_light_tol = 0.0;  // tolerance for suppressing light pixels in a tile
 int g_nsuppressed = 0;     // number of opacity/transparency suppressed tiles
+int g_nthread = 0;         // number of texture compression threads (0: one per CPU core)
+DxtQuality g_dxtQuality = DXTQ_NORMAL; // texture compression quality
+DxtErrorStat g_dxtError;   // accumulated texture compression error
+ThreadPool *g_pool = 0;    // texture compression thread pool
 
 const int nband = 8;
 const int np[8] = {6,12,18,24,28,30,32,32};
@@ -246,8 +256,16 @@ int main (int argc, char *argv[])
 		case 'h':
 			sscanf (argv[++i], "%d", &g_maxres);
 			break;
+		case 'q': // compression quality: 0=fast, 1=normal, 2=high
+			g_dxtQuality = (DxtQuality)max (0, min (2, atoi (argv[++i])));
+			break;
+		case 't':
+			sscanf (argv[++i], "%d", &g_nthread);
+			break;
 		}
 	}
+	ThreadPool pool (g_nthread);
+	g_pool = &pool;
 
 	cout << "+-----------------------------------------------------------------------+\n";
 	cout << "|             pltex: Planetary texture manager for ORBITER              |\n";
@@ -267,14 +285,17 @@ int main (int argc, char *argv[])
 		switch (toupper(task)) {
 		case 'G':
 			CreateGlobalSurface();
+			ReportCompression();
 			MessageBeep (-1);
 			return 0;
 		case 'L':
 			CreateLocalArea();
+			ReportCompression();
 			MessageBeep (-1);
 			return 0;
 		case 'C':
 			CreateCloudMap();
+			ReportCompression();
 			MessageBeep (-1);
 			return 0;
 		case 'M':
@@ -1874,29 +1895,6 @@ void CreateCloudMap ()
 	cout << "Rename to <planet>_cloud.tex and move to Orbiter\\Textures2 folder" << endl;
 }
 
-void SetOutputHeader (BITMAPFILEHEADER &bmfh, BITMAPINFOHEADER &bmih, LONG w, LONG h)
-{
-	char *id = (char*)&bmfh.bfType;
-	id[0] = 'B';
-	id[1] = 'M';
-	bmfh.bfSize = sizeof (BITMAPFILEHEADER) + sizeof (BITMAPINFOHEADER) + w*h*3;
-	bmfh.bfReserved1 = 0;
-	bmfh.bfReserved2 = 0;
-	bmfh.bfOffBits = sizeof (BITMAPINFOHEADER) + sizeof (BITMAPFILEHEADER);
-
-	bmih.biSize = sizeof (BITMAPINFOHEADER);
-	bmih.biWidth = w;
-	bmih.biHeight = h;
-	bmih.biPlanes = 1;
-	bmih.biBitCount = 24;
-	bmih.biCompression = BI_RGB;
-	bmih.biSizeImage = 0;
-	bmih.biXPelsPerMeter = 1;
-	bmih.biYPelsPerMeter = 1;
-	bmih.biClrUsed = 0;
-	bmih.biClrImportant = 0;
-}
-
 RGB *CompressRGB (RGB *src, LONG srcw, LONG srch, LONG tgtw, long tgth, int which)
 {
 	return (RGB*)Compress (3, (BYTE*)src, srcw, srch, tgtw, tgth, which);
@@ -2205,10 +2203,6 @@ void ErodeLights (RGB *limg, Alpha *aimg, LONG imgw, LONG imgh)
 
 DWORD CatDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh, bool force, bool mipmap)
 {
-	const char *bmpname  = "tmp.bmp";
-	const char *abmpname = "tmp_a.bmp";
-	const char *ddsname  = "tmp.dds";
-
 	static RGB *rgbdummy = 0;
 	if (!img) {
 		if (!rgbdummy) {
@@ -2218,27 +2212,12 @@ DWORD CatDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh, bool forc
 		img = rgbdummy;
 	}
 
-	FILE *bmpf;
-	BITMAPFILEHEADER bmfh;
-	BITMAPINFOHEADER bmih;
-	int i, res, ddssize = 0, fh;
+	int i;
 	bool bopaque = false, btransparent = false;
 	int nopaque, ntransparent;
-
-	SetOutputHeader (bmfh, bmih, imgw, imgh);
-	bmpf = fopen (bmpname, "wb");
-	if (!bmpf) FatalError ("Could not open temporary bitmap file.");
-	fwrite (&bmfh, sizeof(BITMAPFILEHEADER), 1, bmpf);
-	fwrite (&bmih, sizeof(BITMAPINFOHEADER), 1, bmpf);
-	fwrite (img, 3, imgw*imgh, bmpf);
-	fclose (bmpf);
+	DxtFormat fmt = DXTFMT_DXT1;
 
 	if (aimg) {
-		bmpf = fopen (abmpname, "wb");
-		if (!bmpf) FatalError ("Could not open temporary alpha file.");
-		fwrite (&bmfh, sizeof(BITMAPFILEHEADER), 1, bmpf);
-		fwrite (&bmih, sizeof(BITMAPINFOHEADER), 1, bmpf);
-
 		// make alpha binary black/white, and count opaque/transparent pixels 
 		for (i = nopaque = ntransparent = 0; i < imgw*imgh; i++) {
 			if (binary_alpha) {
@@ -2260,38 +2239,13 @@ DWORD CatDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh, bool forc
 			for (i = 0; i < imgw*imgh; i++) aimg[i] = 0;
 			g_nsuppressed++;
 		}
-
-		for (i = 0; i < imgw*imgh; i++) {
-			RGB rgb;
-			rgb.r = rgb.g = rgb.b = aimg[i];
-			fwrite (&rgb, 3, 1, bmpf);
-		}
-		fclose (bmpf);
-
-		res = _spawnl (_P_WAIT, dxtex, dxtex, bmpname, "-a", abmpname, mipmap ? "-m" : "", binary_alpha ? "DXT1" : "DXT5", ddsname, NULL);
-	} else {
-		res = _spawnl (_P_WAIT, dxtex, dxtex, bmpname, mipmap ? "-m" : "", "DXT1", ddsname, NULL);
+		fmt = (binary_alpha ? DXTFMT_DXT1A : DXTFMT_DXT5);
 	}
-	if (res != 0) FatalError ("Executing dxtex failed.");
 
-	// get file size
-    if ((fh = _open (ddsname, _O_RDONLY)) == -1) FatalError ("Could not open DDS file");
-    ddssize = _filelength (fh);
-	_close (fh);
-	
-	if (force || !aimg || !selective_alpha || (bopaque && btransparent)) {
-		FILE *ddsf = fopen (ddsname, "rb");
-		BYTE *buf = new BYTE[ddssize];
-		fread (buf, 1, ddssize, ddsf);
-		fclose (ddsf);
-		fwrite (buf, 1, ddssize, texf);
-		delete []buf;
-	} else ddssize = 0;
-
-	remove (bmpname);
-	remove (ddsname);
-	if (aimg) remove (abmpname);
-	return (DWORD)ddssize;
+	if (!force && aimg && selective_alpha && !(bopaque && btransparent))
+		return 0; // patch is not written
+
+	return WriteDDS (texf, img, aimg, imgw, imgh, fmt, mipmap);
 }
 
 WORD CatMaskDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh)
@@ -2304,24 +2258,13 @@ WORD CatMaskDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh)
 	// bit 1: patch contains water portion  (alpha)
 	// bit 2: patch contains city lights    (RGB)
 
-	const char *bmpname  = "tmp.bmp";
-	const char *abmpname = "tmp_a.bmp";
-	const char *ddsname  = "tmp.dds";
-
 	static RGB *rgbdummy = 0;
 	static RGB  zero = {0,0,0};
 
-	FILE *bmpf;
-	BITMAPFILEHEADER bmfh;
-	BITMAPINFOHEADER bmih;
-	int res, ddssize, fh;
 	bool bopaque = false, btransparent = false;
 	bool brgb = false, balpha = false;
 	int nlight, nopaque, ntransparent;
 	WORD flag = 0;
-	bool written = true;
-
-	SetOutputHeader (bmfh, bmih, imgw, imgh);
 
 	if (img)  { // city-light texture provided
 		// count light pixels
@@ -2392,54 +2335,24 @@ WORD CatMaskDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh)
 		}
 	}
 
-	// create a bitmap for the RGB channels
-	bmpf = fopen (bmpname, "wb");
-	if (!bmpf) FatalError ("Could not open temporary bitmap file.");
-	fwrite (&bmfh, sizeof(BITMAPFILEHEADER), 1, bmpf);
-	fwrite (&bmih, sizeof(BITMAPINFOHEADER), 1, bmpf);
-	fwrite (img, 3, imgw*imgh, bmpf);
-	fclose (bmpf);
-
-	// create a bitmap for the alpha channel
-	if (balpha) {
-		bmpf = fopen (abmpname, "wb");
-		if (!bmpf) FatalError ("Could not open temporary alpha file.");
-		fwrite (&bmfh, sizeof(BITMAPFILEHEADER), 1, bmpf);
-		fwrite (&bmih, sizeof(BITMAPINFOHEADER), 1, bmpf);
-		for (LONG i = 0; i < imgw*imgh; i++) {
-			RGB rgb;
-			rgb.r = rgb.g = rgb.b = aimg[i];
-			fwrite (&rgb, 3, 1, bmpf);
-		}
-		fclose (bmpf);
-	}
-
-	// now convert to DXT1 texture
-	if (balpha)
-		res = _spawnl (_P_WAIT, dxtex, dxtex, bmpname, "-a", abmpname, "DXT1", ddsname, NULL);
-	else
-		res = _spawnl (_P_WAIT, dxtex, dxtex, bmpname, "DXT1", ddsname, NULL);
-	if (res != 0) FatalError ("Executing dxtex failed.");
-
-	// get file size
-    if ((fh = _open (ddsname, _O_RDONLY)) == -1) FatalError ("Could not open DDS file");
-    ddssize = _filelength (fh);
-	_close (fh);
-	
-	// append to texture file
-	FILE *ddsf = fopen (ddsname, "rb");
-	BYTE *buf = new BYTE[ddssize];
-	fread (buf, 1, ddssize, ddsf);
-	fclose (ddsf);
-	fwrite (buf, 1, ddssize, texf);
-	delete[]buf;
-
-	remove (bmpname);
-	remove (ddsname);
-	if (aimg) remove (abmpname);
+	// now convert to DXT1 texture and append to texture file
+	WriteDDS (texf, img, balpha ? aimg : 0, imgw, imgh, balpha ? DXTFMT_DXT1A : DXTFMT_DXT1);
 	return flag;
 }
 
+DWORD WriteDDS (FILE *texf, RGB *img, Alpha *aimg, LONG imgw, LONG imgh, DxtFormat fmt, bool mipmap)
+{
+	// The image blocks are compressed in parallel; patches are still written
+	// one at a time since the texture file is assembled sequentially
+	std::vector<BYTE> rgba(imgw*imgh*4), dds;
+	DxtErrorStat err;
+	DxtPackBGR (img->data, aimg, imgw, imgh, true, rgba.data());
+	DxtMakeDDS (rgba.data(), imgw, imgh, fmt, g_dxtQuality, mipmap, dds, g_pool, &err);
+	fwrite (dds.data(), 1, dds.size(), texf);
+	g_dxtError.Add (err);
+	return (DWORD)dds.size();
+}
+
 void ReadBMP_data (char *fname, LONG &mapw, LONG &maph, WORD &bpp)
 {
 	char cbuf[256], *id;
@@ -2762,6 +2675,12 @@ void IncProgress ()
 	SetProgress (prog_p+1);
 }
 
+void ReportCompression ()
+{
+	cout << "Texture compression (" << DxtKernelName (DxtKernelSupported()) << "): PSNR = "
+		 << setprecision(4) << g_dxtError.PSNR() << " dB" << endl;
+}
+
 DWORD CopyDDS (FILE *ftgt, FILE *fsrc, DWORD idx, bool idx_is_ofs)
 {
 	static DWORD maxmip = 0; // max number of mipmap levels
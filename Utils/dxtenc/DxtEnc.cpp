@@ -0,0 +1,698 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// DXT1/DXT5 texture compression
+// =======================================================================
+
+#include "DxtEnc.h"
+#include "ThreadPool.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DXTENC_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSE41_TARGET
+#define AVX2_TARGET
+#else
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+#define AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+// -----------------------------------------------------------------------
+// A 4x4 pixel block, colour channels as separate arrays for the kernels
+
+struct DxtBlock {
+	int32_t r[16], g[16], b[16];
+	int32_t w[16];            // error weight: 0 for transparent pixels, 1 otherwise
+	uint8_t a[16];
+	uint32_t transparent;     // bit mask of transparent pixels (DXT1A only)
+};
+
+static void LoadBlock (const uint8_t *rgba, int w, int h, int bx, int by, DxtFormat fmt, DxtBlock &blk)
+{
+	blk.transparent = 0;
+	for (int y = 0; y < 4; y++) {
+		int iy = by*4 + y;
+		if (iy >= h) iy = h-1;
+		for (int x = 0; x < 4; x++) {
+			int ix = bx*4 + x;
+			if (ix >= w) ix = w-1;
+			const uint8_t *p = rgba + ((size_t)iy*w + ix)*4;
+			int i = y*4 + x;
+			blk.r[i] = p[0], blk.g[i] = p[1], blk.b[i] = p[2], blk.a[i] = p[3];
+			if (fmt == DXTFMT_DXT1A && p[3] < 128) {
+				blk.transparent |= 1u << i;
+				blk.w[i] = 0;
+			} else
+				blk.w[i] = 1;
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+// Colour index kernels: for each pixel, the index of the nearest of the
+// npal palette colours (the first one on ties), packed 2 bits per pixel.
+// err returns the weighted sum of squared distances.
+
+typedef uint32_t (*DxtIndexKernel)(const DxtBlock &blk, const int pal[4][3], int npal, int &err);
+
+static uint32_t ColourIndices_scalar (const DxtBlock &blk, const int pal[4][3], int npal, int &err)
+{
+	uint32_t idx = 0;
+	err = 0;
+	for (int i = 0; i < 16; i++) {
+		int best = INT_MAX, k = 0;
+		for (int j = 0; j < npal; j++) {
+			int dr = blk.r[i]-pal[j][0], dg = blk.g[i]-pal[j][1], db = blk.b[i]-pal[j][2];
+			int d = dr*dr + dg*dg + db*db;
+			if (d < best) best = d, k = j;
+		}
+		idx |= (uint32_t)k << (2*i);
+		err += best*blk.w[i];
+	}
+	return idx;
+}
+
+#ifdef DXTENC_X86
+
+static const uint32_t IndexScale[16] = {
+	1u<< 0, 1u<< 2, 1u<< 4, 1u<< 6, 1u<< 8, 1u<<10, 1u<<12, 1u<<14,
+	1u<<16, 1u<<18, 1u<<20, 1u<<22, 1u<<24, 1u<<26, 1u<<28, 1u<<30
+};
+
+// -----------------------------------------------------------------------
+// SSE4.1 version: 4 pixels per iteration
+
+SSE41_TARGET static uint32_t ColourIndices_sse41 (const DxtBlock &blk, const int pal[4][3], int npal, int &err)
+{
+	__m128i vidx = _mm_setzero_si128(), verr = _mm_setzero_si128();
+
+	for (int k = 0; k < 16; k += 4) {
+		__m128i r = _mm_loadu_si128 ((const __m128i*)(blk.r+k));
+		__m128i g = _mm_loadu_si128 ((const __m128i*)(blk.g+k));
+		__m128i b = _mm_loadu_si128 ((const __m128i*)(blk.b+k));
+		__m128i best = _mm_setzero_si128(), idx = _mm_setzero_si128();
+		for (int j = 0; j < npal; j++) {
+			__m128i dr = _mm_sub_epi32 (r, _mm_set1_epi32 (pal[j][0]));
+			__m128i dg = _mm_sub_epi32 (g, _mm_set1_epi32 (pal[j][1]));
+			__m128i db = _mm_sub_epi32 (b, _mm_set1_epi32 (pal[j][2]));
+			__m128i d = _mm_add_epi32 (_mm_add_epi32 (_mm_mullo_epi32 (dr, dr), _mm_mullo_epi32 (dg, dg)), _mm_mullo_epi32 (db, db));
+			if (!j) {
+				best = d;
+			} else {
+				__m128i lt = _mm_cmplt_epi32 (d, best);
+				best = _mm_min_epi32 (best, d);
+				idx = _mm_blendv_epi8 (idx, _mm_set1_epi32 (j), lt);
+			}
+		}
+		vidx = _mm_or_si128 (vidx, _mm_mullo_epi32 (idx, _mm_loadu_si128 ((const __m128i*)(IndexScale+k))));
+		verr = _mm_add_epi32 (verr, _mm_mullo_epi32 (best, _mm_loadu_si128 ((const __m128i*)(blk.w+k))));
+	}
+	vidx = _mm_or_si128 (vidx, _mm_shuffle_epi32 (vidx, _MM_SHUFFLE(1,0,3,2)));
+	vidx = _mm_or_si128 (vidx, _mm_shuffle_epi32 (vidx, _MM_SHUFFLE(2,3,0,1)));
+	verr = _mm_add_epi32 (verr, _mm_shuffle_epi32 (verr, _MM_SHUFFLE(1,0,3,2)));
+	verr = _mm_add_epi32 (verr, _mm_shuffle_epi32 (verr, _MM_SHUFFLE(2,3,0,1)));
+	err = _mm_cvtsi128_si32 (verr);
+	return (uint32_t)_mm_cvtsi128_si32 (vidx);
+}
+
+// -----------------------------------------------------------------------
+// AVX2 version: 8 pixels per iteration
+
+AVX2_TARGET static uint32_t ColourIndices_avx2 (const DxtBlock &blk, const int pal[4][3], int npal, int &err)
+{
+	__m256i vidx = _mm256_setzero_si256(), verr = _mm256_setzero_si256();
+
+	for (int k = 0; k < 16; k += 8) {
+		__m256i r = _mm256_loadu_si256 ((const __m256i*)(blk.r+k));
+		__m256i g = _mm256_loadu_si256 ((const __m256i*)(blk.g+k));
+		__m256i b = _mm256_loadu_si256 ((const __m256i*)(blk.b+k));
+		__m256i best = _mm256_setzero_si256(), idx = _mm256_setzero_si256();
+		for (int j = 0; j < npal; j++) {
+			__m256i dr = _mm256_sub_epi32 (r, _mm256_set1_epi32 (pal[j][0]));
+			__m256i dg = _mm256_sub_epi32 (g, _mm256_set1_epi32 (pal[j][1]));
+			__m256i db = _mm256_sub_epi32 (b, _mm256_set1_epi32 (pal[j][2]));
+			__m256i d = _mm256_add_epi32 (_mm256_add_epi32 (_mm256_mullo_epi32 (dr, dr), _mm256_mullo_epi32 (dg, dg)), _mm256_mullo_epi32 (db, db));
+			if (!j) {
+				best = d;
+			} else {
+				__m256i lt = _mm256_cmpgt_epi32 (best, d);
+				best = _mm256_min_epi32 (best, d);
+				idx = _mm256_blendv_epi8 (idx, _mm256_set1_epi32 (j), lt);
+			}
+		}
+		__m256i shift = _mm256_setr_epi32 (2*k, 2*k+2, 2*k+4, 2*k+6, 2*k+8, 2*k+10, 2*k+12, 2*k+14);
+		vidx = _mm256_or_si256 (vidx, _mm256_sllv_epi32 (idx, shift));
+		verr = _mm256_add_epi32 (verr, _mm256_mullo_epi32 (best, _mm256_loadu_si256 ((const __m256i*)(blk.w+k))));
+	}
+	__m128i vidx4 = _mm_or_si128 (_mm256_castsi256_si128 (vidx), _mm256_extracti128_si256 (vidx, 1));
+	__m128i verr4 = _mm_add_epi32 (_mm256_castsi256_si128 (verr), _mm256_extracti128_si256 (verr, 1));
+	vidx4 = _mm_or_si128 (vidx4, _mm_shuffle_epi32 (vidx4, _MM_SHUFFLE(1,0,3,2)));
+	vidx4 = _mm_or_si128 (vidx4, _mm_shuffle_epi32 (vidx4, _MM_SHUFFLE(2,3,0,1)));
+	verr4 = _mm_add_epi32 (verr4, _mm_shuffle_epi32 (verr4, _MM_SHUFFLE(1,0,3,2)));
+	verr4 = _mm_add_epi32 (verr4, _mm_shuffle_epi32 (verr4, _MM_SHUFFLE(2,3,0,1)));
+	err = _mm_cvtsi128_si32 (verr4);
+	return (uint32_t)_mm_cvtsi128_si32 (vidx4);
+}
+
+// -----------------------------------------------------------------------
+
+static void CpuFeatures (bool &sse41, bool &avx2)
+{
+#ifdef _MSC_VER
+	int info[4];
+	sse41 = avx2 = false;
+	__cpuid (info, 0);
+	int nid = info[0];
+	if (nid < 1) return;
+	__cpuid (info, 1);
+	sse41 = (info[2] & (1 << 19)) != 0;
+	bool osxsave = (info[2] & (1 << 27)) != 0;
+	bool avx     = (info[2] & (1 << 28)) != 0;
+	if (nid < 7 || !osxsave || !avx) return;
+	if ((_xgetbv (0) & 0x6) != 0x6) return; // OS saves YMM state
+	__cpuidex (info, 7, 0);
+	avx2 = (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init ();
+	sse41 = __builtin_cpu_supports ("sse4.1") != 0;
+	avx2  = __builtin_cpu_supports ("avx2") != 0;
+#endif
+}
+
+#endif // DXTENC_X86
+
+// -----------------------------------------------------------------------
+
+DxtKernelType DxtKernelSupported ()
+{
+#ifdef DXTENC_X86
+	static const DxtKernelType type = [] {
+		bool sse41, avx2;
+		CpuFeatures (sse41, avx2);
+		return avx2 ? DXTKERNEL_AVX2 : sse41 ? DXTKERNEL_SSE41 : DXTKERNEL_SCALAR;
+	}();
+	return type;
+#else
+	return DXTKERNEL_SCALAR;
+#endif
+}
+
+// -----------------------------------------------------------------------
+
+const char *DxtKernelName (DxtKernelType type)
+{
+	switch (type) {
+	case DXTKERNEL_AVX2:  return "AVX2";
+	case DXTKERNEL_SSE41: return "SSE4.1";
+	default:              return "scalar";
+	}
+}
+
+// -----------------------------------------------------------------------
+
+static DxtIndexKernel IndexKernel (DxtKernelType type)
+{
+	if (type > DxtKernelSupported())
+		type = DXTKERNEL_SCALAR;
+
+	switch (type) {
+#ifdef DXTENC_X86
+	case DXTKERNEL_AVX2:  return ColourIndices_avx2;
+	case DXTKERNEL_SSE41: return ColourIndices_sse41;
+#endif
+	default:              return ColourIndices_scalar;
+	}
+}
+
+// =======================================================================
+// Colour block
+
+static inline int Clamp255 (float v)
+{
+	int i = (int)(v + 0.5f);
+	return i < 0 ? 0 : i > 255 ? 255 : i;
+}
+
+static uint16_t Pack565 (const float c[3])
+{
+	int r = (Clamp255 (c[0]) * 31 + 127) / 255;
+	int g = (Clamp255 (c[1]) * 63 + 127) / 255;
+	int b = (Clamp255 (c[2]) * 31 + 127) / 255;
+	return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+static void Unpack565 (uint16_t c, int rgb[3])
+{
+	int r = (c >> 11) & 0x1f, g = (c >> 5) & 0x3f, b = c & 0x1f;
+	rgb[0] = (r << 3) | (r >> 2);
+	rgb[1] = (g << 2) | (g >> 4);
+	rgb[2] = (b << 3) | (b >> 2);
+}
+
+static void ColourPalette (uint16_t c0, uint16_t c1, bool four, int pal[4][3])
+{
+	Unpack565 (c0, pal[0]);
+	Unpack565 (c1, pal[1]);
+	for (int j = 0; j < 3; j++) {
+		if (four) {
+			pal[2][j] = (2*pal[0][j] + pal[1][j]) / 3;
+			pal[3][j] = (pal[0][j] + 2*pal[1][j]) / 3;
+		} else {
+			pal[2][j] = (pal[0][j] + pal[1][j]) / 2;
+			pal[3][j] = 0;
+		}
+	}
+}
+
+// Bounding box diagonal of the opaque pixels, inset by 1/16 of its size.
+// Channels that are anti-correlated with the widest one run along the
+// opposite diagonal.
+static void BoundingBoxEndpoints (const DxtBlock &blk, float e0[3], float e1[3])
+{
+	int mn[3] = {255, 255, 255}, mx[3] = {0, 0, 0}, sum[3] = {0, 0, 0};
+	int i, j, n = 0;
+	for (i = 0; i < 16; i++) {
+		if (!blk.w[i]) continue;
+		int c[3] = {blk.r[i], blk.g[i], blk.b[i]};
+		for (j = 0; j < 3; j++) {
+			if (c[j] < mn[j]) mn[j] = c[j];
+			if (c[j] > mx[j]) mx[j] = c[j];
+			sum[j] += c[j];
+		}
+		n++;
+	}
+	int jmax = 0;
+	for (j = 1; j < 3; j++)
+		if (mx[j]-mn[j] > mx[jmax]-mn[jmax]) jmax = j;
+	int cov[3] = {0, 0, 0};
+	for (i = 0; i < 16; i++) {
+		if (!blk.w[i]) continue;
+		int c[3] = {blk.r[i]*n - sum[0], blk.g[i]*n - sum[1], blk.b[i]*n - sum[2]};
+		for (j = 0; j < 3; j++)
+			cov[j] += c[j] * c[jmax];
+	}
+	for (j = 0; j < 3; j++) {
+		float inset = (mx[j] - mn[j]) / 16.0f;
+		bool flip = (cov[j] < 0);
+		e0[j] = (flip ? mn[j] + inset : mx[j] - inset);
+		e1[j] = (flip ? mx[j] - inset : mn[j] + inset);
+	}
+}
+
+// Extreme opaque pixels along the principal axis of the colour distribution
+static void PrincipalAxisEndpoints (const DxtBlock &blk, float e0[3], float e1[3])
+{
+	float mean[3] = {0.0f, 0.0f, 0.0f};
+	int i, j, n = 0;
+	for (i = 0; i < 16; i++) {
+		if (!blk.w[i]) continue;
+		mean[0] += blk.r[i], mean[1] += blk.g[i], mean[2] += blk.b[i];
+		n++;
+	}
+	for (j = 0; j < 3; j++) mean[j] /= n;
+
+	float cov[6] = {0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f};
+	float mn[3] = {255.0f, 255.0f, 255.0f}, mx[3] = {0.0f, 0.0f, 0.0f};
+	for (i = 0; i < 16; i++) {
+		if (!blk.w[i]) continue;
+		float d[3] = {blk.r[i]-mean[0], blk.g[i]-mean[1], blk.b[i]-mean[2]};
+		cov[0] += d[0]*d[0], cov[1] += d[0]*d[1], cov[2] += d[0]*d[2];
+		cov[3] += d[1]*d[1], cov[4] += d[1]*d[2], cov[5] += d[2]*d[2];
+		for (j = 0; j < 3; j++) {
+			float c = d[j] + mean[j];
+			if (c < mn[j]) mn[j] = c;
+			if (c > mx[j]) mx[j] = c;
+		}
+	}
+
+	// power iteration, starting from the bounding box diagonal
+	float axis[3] = {mx[0]-mn[0], mx[1]-mn[1], mx[2]-mn[2]};
+	for (int iter = 0; iter < 4; iter++) {
+		float v[3] = {
+			cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2],
+			cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2],
+			cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2]
+		};
+		float vmax = fabsf(v[0]);
+		if (fabsf(v[1]) > vmax) vmax = fabsf(v[1]);
+		if (fabsf(v[2]) > vmax) vmax = fabsf(v[2]);
+		if (vmax < 1e-4f) break; // (nearly) uniform block
+		for (j = 0; j < 3; j++) axis[j] = v[j] / vmax;
+	}
+
+	float dmin = 1e10f, dmax = -1e10f;
+	int imin = -1, imax = -1;
+	for (i = 0; i < 16; i++) {
+		if (!blk.w[i]) continue;
+		float d = blk.r[i]*axis[0] + blk.g[i]*axis[1] + blk.b[i]*axis[2];
+		if (d < dmin) dmin = d, imin = i;
+		if (d > dmax) dmax = d, imax = i;
+	}
+	e0[0] = (float)blk.r[imax], e0[1] = (float)blk.g[imax], e0[2] = (float)blk.b[imax];
+	e1[0] = (float)blk.r[imin], e1[1] = (float)blk.g[imin], e1[2] = (float)blk.b[imin];
+}
+
+// Least squares end points for the given indices
+static bool RefineEndpoints (const DxtBlock &blk, uint32_t idx, bool four, float e0[3], float e1[3])
+{
+	static const float w4[4] = {1.0f, 0.0f, 2.0f/3.0f, 1.0f/3.0f};
+	static const float w3[4] = {1.0f, 0.0f, 0.5f, 0.0f};
+	const float *wgt = (four ? w4 : w3);
+	float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+	float xa[3] = {0.0f, 0.0f, 0.0f}, xb[3] = {0.0f, 0.0f, 0.0f};
+
+	for (int i = 0; i < 16; i++) {
+		if (!blk.w[i]) continue;
+		float a = wgt[(idx >> (2*i)) & 3], b = 1.0f - a;
+		float c[3] = {(float)blk.r[i], (float)blk.g[i], (float)blk.b[i]};
+		aa += a*a, bb += b*b, ab += a*b;
+		for (int j = 0; j < 3; j++)
+			xa[j] += a*c[j], xb[j] += b*c[j];
+	}
+	float det = aa*bb - ab*ab;
+	if (fabsf(det) < 1e-6f) return false; // all pixels on one index
+	for (int j = 0; j < 3; j++) {
+		e0[j] = (bb*xa[j] - ab*xb[j]) / det;
+		e1[j] = (aa*xb[j] - ab*xa[j]) / det;
+	}
+	return true;
+}
+
+struct ColourFit {
+	uint16_t c0, c1;
+	uint32_t idx;
+	int err;
+};
+
+static void FitColours (const DxtBlock &blk, const float e0[3], const float e1[3], bool four,
+	DxtIndexKernel kernel, ColourFit &fit)
+{
+	int pal[4][3];
+	fit.c0 = Pack565 (e0);
+	fit.c1 = Pack565 (e1);
+	ColourPalette (fit.c0, fit.c1, four, pal);
+	fit.idx = kernel (blk, pal, four ? 4 : 3, fit.err);
+}
+
+static void EncodeColourBlock (const DxtBlock &blk, DxtQuality quality,
+	DxtIndexKernel kernel, uint8_t *out)
+{
+	uint16_t c0, c1;
+	uint32_t idx;
+
+	if (blk.transparent == 0xffff) {
+		// fully transparent: 3-colour mode, all pixels on the transparent index
+		c0 = c1 = 0;
+		idx = 0xffffffff;
+	} else {
+		// 3-colour mode is only used for blocks with transparent pixels
+		bool four = (blk.transparent == 0);
+		float e0[3], e1[3];
+		ColourFit best, fit;
+
+		if (quality == DXTQ_FAST) BoundingBoxEndpoints (blk, e0, e1);
+		else                      PrincipalAxisEndpoints (blk, e0, e1);
+		FitColours (blk, e0, e1, four, kernel, best);
+		if (quality == DXTQ_HIGH) {
+			BoundingBoxEndpoints (blk, e0, e1);
+			FitColours (blk, e0, e1, four, kernel, fit);
+			if (fit.err < best.err) best = fit;
+		}
+		int niter = (quality == DXTQ_FAST ? 0 : quality == DXTQ_NORMAL ? 1 : 3);
+		for (int iter = 0; iter < niter && best.err; iter++) {
+			if (!RefineEndpoints (blk, best.idx, four, e0, e1)) break;
+			FitColours (blk, e0, e1, four, kernel, fit);
+			if (fit.err < best.err) best = fit;
+			else break;
+		}
+
+		c0 = best.c0, c1 = best.c1, idx = best.idx;
+		if (four) { // needs c0 > c1
+			if (c0 < c1) {
+				c0 = best.c1, c1 = best.c0;
+				idx ^= 0x55555555;                  // 0<->1, 2<->3
+			} else if (c0 == c1)
+				idx = 0;                            // would decode as 3-colour block
+		} else {    // needs c0 <= c1
+			if (c0 > c1) {
+				c0 = best.c1, c1 = best.c0;
+				idx ^= ~(idx >> 1) & 0x55555555;    // 0<->1
+			}
+			for (int i = 0; i < 16; i++)
+				if (blk.transparent & (1u << i))
+					idx |= 3u << (2*i);
+		}
+	}
+	out[0] = (uint8_t)c0, out[1] = (uint8_t)(c0 >> 8);
+	out[2] = (uint8_t)c1, out[3] = (uint8_t)(c1 >> 8);
+	out[4] = (uint8_t)idx, out[5] = (uint8_t)(idx >> 8), out[6] = (uint8_t)(idx >> 16), out[7] = (uint8_t)(idx >> 24);
+}
+
+static void DecodeColourBlock (const uint8_t *in, bool dxt1, uint8_t px[16][4])
+{
+	uint16_t c0 = (uint16_t)(in[0] | (in[1] << 8));
+	uint16_t c1 = (uint16_t)(in[2] | (in[3] << 8));
+	uint32_t idx = (uint32_t)in[4] | ((uint32_t)in[5] << 8) | ((uint32_t)in[6] << 16) | ((uint32_t)in[7] << 24);
+	bool four = !dxt1 || c0 > c1;
+	int pal[4][3];
+	ColourPalette (c0, c1, four, pal);
+	for (int i = 0; i < 16; i++) {
+		int k = (idx >> (2*i)) & 3;
+		px[i][0] = (uint8_t)pal[k][0], px[i][1] = (uint8_t)pal[k][1], px[i][2] = (uint8_t)pal[k][2];
+		px[i][3] = (!four && k == 3 ? 0 : 255);
+	}
+}
+
+// =======================================================================
+// Alpha block (DXT5)
+
+static void EncodeAlphaBlock (const DxtBlock &blk, uint8_t *out)
+{
+	int amin = 255, amax = 0, i, k;
+	for (i = 0; i < 16; i++) {
+		if (blk.a[i] < amin) amin = blk.a[i];
+		if (blk.a[i] > amax) amax = blk.a[i];
+	}
+	// 8-value mode (a0 > a1); a uniform block uses index 0 only
+	int pal[8] = {amax, amin};
+	for (k = 2; k < 8; k++)
+		pal[k] = ((8-k)*amax + (k-1)*amin) / 7;
+
+	uint64_t bits = 0;
+	if (amax > amin) {
+		for (i = 0; i < 16; i++) {
+			int best = INT_MAX, kbest = 0;
+			for (k = 0; k < 8; k++) {
+				int d = abs (blk.a[i] - pal[k]);
+				if (d < best) best = d, kbest = k;
+			}
+			bits |= (uint64_t)kbest << (3*i);
+		}
+	}
+	out[0] = (uint8_t)amax;
+	out[1] = (uint8_t)amin;
+	for (i = 0; i < 6; i++)
+		out[2+i] = (uint8_t)(bits >> (8*i));
+}
+
+static void DecodeAlphaBlock (const uint8_t *in, uint8_t px[16][4])
+{
+	int a0 = in[0], a1 = in[1], pal[8] = {a0, a1}, k;
+	if (a0 > a1) {
+		for (k = 2; k < 8; k++) pal[k] = ((8-k)*a0 + (k-1)*a1) / 7;
+	} else {
+		for (k = 2; k < 6; k++) pal[k] = ((6-k)*a0 + (k-1)*a1) / 5;
+		pal[6] = 0, pal[7] = 255;
+	}
+	uint64_t bits = 0;
+	for (int i = 0; i < 6; i++)
+		bits |= (uint64_t)in[2+i] << (8*i);
+	for (int i = 0; i < 16; i++)
+		px[i][3] = (uint8_t)pal[(bits >> (3*i)) & 7];
+}
+
+// =======================================================================
+
+double DxtErrorStat::PSNR () const
+{
+	if (!npix || sqerr <= 0.0) return 100.0;
+	double mse = sqerr / (3.0 * (double)npix);
+	return 10.0 * log10 (255.0*255.0 / mse);
+}
+
+// -----------------------------------------------------------------------
+
+static inline int BlockBytes (DxtFormat fmt)
+{
+	return (fmt == DXTFMT_DXT5 ? 16 : 8);
+}
+
+size_t DxtImageSize (int w, int h, DxtFormat fmt)
+{
+	return (size_t)((w+3)/4) * (size_t)((h+3)/4) * BlockBytes (fmt);
+}
+
+// -----------------------------------------------------------------------
+
+void DxtCompress (const uint8_t *rgba, int w, int h, DxtFormat fmt, DxtQuality quality,
+	uint8_t *dxt, ThreadPool *pool, DxtKernelType type)
+{
+	const int nbx = (w+3)/4, nby = (h+3)/4, bs = BlockBytes (fmt);
+	const DxtIndexKernel kernel = IndexKernel (type);
+
+	auto blockRow = [&](size_t by) {
+		DxtBlock blk;
+		uint8_t *out = dxt + by*nbx*bs;
+		for (int bx = 0; bx < nbx; bx++, out += bs) {
+			LoadBlock (rgba, w, h, bx, (int)by, fmt, blk);
+			if (fmt == DXTFMT_DXT5) {
+				EncodeAlphaBlock (blk, out);
+				EncodeColourBlock (blk, quality, kernel, out+8);
+			} else
+				EncodeColourBlock (blk, quality, kernel, out);
+		}
+	};
+	if (pool && nby > 1) pool->ParallelFor (nby, blockRow);
+	else for (int by = 0; by < nby; by++) blockRow (by);
+}
+
+void DxtCompress (const uint8_t *rgba, int w, int h, DxtFormat fmt, DxtQuality quality,
+	uint8_t *dxt, ThreadPool *pool)
+{
+	static const DxtKernelType type = DxtKernelSupported();
+	DxtCompress (rgba, w, h, fmt, quality, dxt, pool, type);
+}
+
+// -----------------------------------------------------------------------
+
+void DxtDecompress (const uint8_t *dxt, int w, int h, DxtFormat fmt, uint8_t *rgba)
+{
+	const int nbx = (w+3)/4, nby = (h+3)/4, bs = BlockBytes (fmt);
+	uint8_t px[16][4];
+
+	for (int by = 0; by < nby; by++) {
+		for (int bx = 0; bx < nbx; bx++, dxt += bs) {
+			if (fmt == DXTFMT_DXT5) {
+				DecodeColourBlock (dxt+8, false, px);
+				DecodeAlphaBlock (dxt, px);
+			} else
+				DecodeColourBlock (dxt, true, px);
+			for (int y = 0; y < 4 && by*4+y < h; y++)
+				for (int x = 0; x < 4 && bx*4+x < w; x++)
+					memcpy (rgba + ((size_t)(by*4+y)*w + bx*4+x)*4, px[y*4+x], 4);
+		}
+	}
+}
+
+// -----------------------------------------------------------------------
+
+void DxtCompare (const uint8_t *rgba, const uint8_t *dxt, int w, int h, DxtFormat fmt, DxtErrorStat &err)
+{
+	std::vector<uint8_t> dec((size_t)w*h*4);
+	DxtDecompress (dxt, w, h, fmt, dec.data());
+
+	double sqerr = 0.0;
+	uint64_t npix = 0;
+	for (size_t i = 0; i < (size_t)w*h; i++) {
+		const uint8_t *p = rgba + i*4, *q = dec.data() + i*4;
+		if (fmt == DXTFMT_DXT1A && p[3] < 128) continue;
+		for (int j = 0; j < 3; j++) {
+			int d = (int)p[j] - (int)q[j];
+			sqerr += d*d;
+		}
+		npix++;
+	}
+	err.sqerr += sqerr;
+	err.npix += npix;
+}
+
+// -----------------------------------------------------------------------
+
+static void Downsample (const uint8_t *src, int w, int h, uint8_t *tgt, int tw, int th)
+{
+	for (int y = 0; y < th; y++) {
+		int y0 = 2*y, y1 = (2*y+1 < h ? 2*y+1 : 2*y);
+		for (int x = 0; x < tw; x++) {
+			int x0 = 2*x, x1 = (2*x+1 < w ? 2*x+1 : 2*x);
+			const uint8_t *p00 = src + ((size_t)y0*w + x0)*4, *p01 = src + ((size_t)y0*w + x1)*4;
+			const uint8_t *p10 = src + ((size_t)y1*w + x0)*4, *p11 = src + ((size_t)y1*w + x1)*4;
+			uint8_t *t = tgt + ((size_t)y*tw + x)*4;
+			for (int j = 0; j < 4; j++)
+				t[j] = (uint8_t)((p00[j] + p01[j] + p10[j] + p11[j] + 2) >> 2);
+		}
+	}
+}
+
+size_t DxtMakeDDS (const uint8_t *rgba, int w, int h, DxtFormat fmt, DxtQuality quality, bool mipmap,
+	std::vector<uint8_t> &dds, ThreadPool *pool, DxtErrorStat *err)
+{
+	const size_t hdrsize = 4 + 124;
+	int nlevel = 1;
+	size_t size = hdrsize + DxtImageSize (w, h, fmt);
+	if (mipmap) {
+		for (int lw = w, lh = h; lw > 1 || lh > 1; nlevel++) {
+			lw = (lw > 1 ? lw/2 : 1), lh = (lh > 1 ? lh/2 : 1);
+			size += DxtImageSize (lw, lh, fmt);
+		}
+	}
+	dds.assign (size, 0);
+
+	// DDS header (DDSURFACEDESC2 layout)
+	uint32_t hdr[31];
+	memset (hdr, 0, sizeof(hdr));
+	hdr[0] = 124;                                     // dwSize
+	hdr[1] = 0x00081007 | (mipmap ? 0x00020000 : 0);  // CAPS|HEIGHT|WIDTH|PIXELFORMAT|LINEARSIZE[|MIPMAPCOUNT]
+	hdr[2] = h;
+	hdr[3] = w;
+	hdr[4] = (uint32_t)DxtImageSize (w, h, fmt);      // dwPitchOrLinearSize
+	hdr[6] = (mipmap ? nlevel : 0);                   // dwMipMapCount
+	hdr[18] = 32;                                     // ddspf.dwSize
+	hdr[19] = 0x4;                                    // ddspf.dwFlags: FOURCC
+	memcpy (hdr+20, fmt == DXTFMT_DXT5 ? "DXT5" : "DXT1", 4);
+	hdr[26] = 0x1000 | (mipmap ? 0x00400008 : 0);     // dwCaps: TEXTURE[|COMPLEX|MIPMAP]
+	memcpy (dds.data(), "DDS ", 4);
+	memcpy (dds.data()+4, hdr, sizeof(hdr));
+
+	uint8_t *out = dds.data() + hdrsize;
+	DxtCompress (rgba, w, h, fmt, quality, out, pool);
+	if (err)
+		DxtCompare (rgba, out, w, h, fmt, *err);
+	out += DxtImageSize (w, h, fmt);
+
+	std::vector<uint8_t> mip[2];
+	const uint8_t *src = rgba;
+	for (int level = 1, lw = w, lh = h; level < nlevel; level++) {
+		int tw = (lw > 1 ? lw/2 : 1), th = (lh > 1 ? lh/2 : 1);
+		std::vector<uint8_t> &tgt = mip[level & 1];
+		tgt.resize ((size_t)tw*th*4);
+		Downsample (src, lw, lh, tgt.data(), tw, th);
+		DxtCompress (tgt.data(), tw, th, fmt, quality, out, pool);
+		out += DxtImageSize (tw, th, fmt);
+		src = tgt.data(), lw = tw, lh = th;
+	}
+	return size;
+}
+
+// -----------------------------------------------------------------------
+
+void DxtPackBGR (const uint8_t *bgr, const uint8_t *alpha, int w, int h, bool bottomUp, uint8_t *rgba)
+{
+	for (int y = 0; y < h; y++) {
+		size_t srow = (size_t)(bottomUp ? h-1-y : y) * w;
+		const uint8_t *s = bgr + srow*3;
+		const uint8_t *a = (alpha ? alpha + srow : 0);
+		uint8_t *t = rgba + (size_t)y*w*4;
+		for (int x = 0; x < w; x++, s += 3, t += 4) {
+			t[0] = s[2], t[1] = s[1], t[2] = s[0];
+			t[3] = (a ? a[x] : 255);
+		}
+	}
+}
@@ -0,0 +1,91 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// DxtEnc
+// DXT1 (BC1) and DXT5 (BC3) texture compression for the planet texture
+// tools (tileedit, plsplit, pltex).
+// Images are passed as 8-bit RGBA pixels (bytes in R,G,B,A order), top
+// row first. The colour indices of each block are selected by SSE4.1 or
+// AVX2 kernels if the CPU supports them, with a scalar fallback. All
+// kernels produce identical output.
+// =======================================================================
+
+#ifndef __DXTENC_H
+#define __DXTENC_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+class ThreadPool;
+
+enum DxtFormat {
+	DXTFMT_DXT1,          // opaque colour
+	DXTFMT_DXT1A,         // colour with 1-bit alpha (alpha < 128: transparent)
+	DXTFMT_DXT5           // colour with interpolated alpha
+};
+
+enum DxtQuality {
+	DXTQ_FAST,            // bounding box end points
+	DXTQ_NORMAL,          // principal axis end points, one least squares refinement
+	DXTQ_HIGH             // repeated refinement, best of principal axis and bounding box
+};
+
+enum DxtKernelType {
+	DXTKERNEL_SCALAR,
+	DXTKERNEL_SSE41,
+	DXTKERNEL_AVX2
+};
+
+// -----------------------------------------------------------------------
+// Accumulated colour error of compressed images
+
+struct DxtErrorStat {
+	double sqerr;         // sum of squared RGB errors
+	uint64_t npix;        // number of pixels compared
+
+	DxtErrorStat (): sqerr(0.0), npix(0) {}
+	void Add (const DxtErrorStat &e) { sqerr += e.sqerr; npix += e.npix; }
+
+	double PSNR () const;
+	// peak signal to noise ratio of the RGB channels [dB] (100 for lossless)
+};
+
+DxtKernelType DxtKernelSupported ();
+// Fastest kernel supported by the CPU
+
+const char *DxtKernelName (DxtKernelType type);
+
+size_t DxtImageSize (int w, int h, DxtFormat fmt);
+// Size of the compressed data of a w x h image [bytes]
+
+void DxtCompress (const uint8_t *rgba, int w, int h, DxtFormat fmt, DxtQuality quality,
+	uint8_t *dxt, ThreadPool *pool = 0);
+void DxtCompress (const uint8_t *rgba, int w, int h, DxtFormat fmt, DxtQuality quality,
+	uint8_t *dxt, ThreadPool *pool, DxtKernelType type);
+// Compresses a w x h image into dxt (DxtImageSize bytes). Image dimensions
+// that are not multiples of 4 are padded by repeating the edge pixels.
+// If pool is provided, the rows of blocks are distributed over its threads.
+// The first version uses the fastest supported kernel.
+
+void DxtDecompress (const uint8_t *dxt, int w, int h, DxtFormat fmt, uint8_t *rgba);
+// Reconstructs the RGBA image from compressed data
+
+void DxtCompare (const uint8_t *rgba, const uint8_t *dxt, int w, int h, DxtFormat fmt, DxtErrorStat &err);
+// Adds the error of the compressed image dxt with respect to the original
+// rgba to err. For DXT1A, pixels that are transparent in the original are
+// skipped.
+
+size_t DxtMakeDDS (const uint8_t *rgba, int w, int h, DxtFormat fmt, DxtQuality quality, bool mipmap,
+	std::vector<uint8_t> &dds, ThreadPool *pool = 0, DxtErrorStat *err = 0);
+// Creates the contents of a DDS file for the image in dds and returns its
+// size. If mipmap is set, a box-filtered mipmap chain down to 1x1 is added.
+// If err is provided, the error of the top level is added to it.
+
+void DxtPackBGR (const uint8_t *bgr, const uint8_t *alpha, int w, int h, bool bottomUp, uint8_t *rgba);
+// Converts 24-bit BGR pixels (as stored in BMP files) and an optional
+// alpha plane into RGBA. Without alpha plane, all pixels are opaque.
+// If bottomUp is set, the source rows are stored bottom row first.
+
+#endif // !__DXTENC_H
@@ -3,9 +3,11 @@
 
 #include <iostream>
 #include <fstream>
+#include <string>
 #include <stdio.h>
 #include <time.h>
 #include "Mesh.h"
+#include "MeshBin.h"
 
 using namespace std;
 
@@ -26,6 +28,25 @@ void PrintUsage()
 	std::cout << "  <suffix>:      Variable name suffix\n";
 	std::cout << "  /L:            Optional argument, output a Lua file when provided\n\n";
 	std::cout << "Any mandatory parameters not provided on the command line are queried interactively.\n\n";
+	std::cout << "Usage: meshc --compile <meshfile> [<meshfile> ...]\n";
+	std::cout << "  Writes a compiled binary mesh <meshfile>b for each mesh file, which\n";
+	std::cout << "  Orbiter loads instead of the text mesh as long as the latter is not\n";
+	std::cout << "  modified.\n\n";
+}
+
+int Compile(int argc, char *argv[])
+{
+	int nfail = 0;
+	for (int i = 2; i < argc; i++) {
+		std::string binname = std::string(argv[i]) + 'b';
+		if (MeshBin::Compile(argv[i], binname.c_str())) {
+			cout << "Compiled " << argv[i] << " -> " << binname << endl;
+		} else {
+			cerr << "Error compiling " << argv[i] << endl;
+			nfail++;
+		}
+	}
+	return nfail ? 1 : 0;
 }
 
 void ParseError()
@@ -164,6 +185,9 @@ int main (int argc, char *argv[])
 	Mesh mesh;
 	Param param;
 
+	if (argc > 1 && (!strcmp(argv[1], "--compile") || !_stricmp(argv[1], "/C")))
+		return Compile(argc, argv);
+
 	cout << "+-----------------------------------------------------------------------+\n";
 	cout << "|                   meshc: Mesh compiler for ORBITER                    |\n";
 	cout << "|        Build: " << __DATE__ << "      (c) 2001-2018 Martin Schweiger         |\n";
@@ -22,6 +22,11 @@
 #include <ddraw.h>
 #include <shlobj.h>
 #include <wincodec.h>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include "DxtEnc.h"
+#include "ThreadPool.h"
 
 using namespace std;
 
@@ -38,11 +43,14 @@ bool operator!= (const BGR &c1, const BGR &c2)
 typedef BYTE Alpha;
 
 int PS = 512; // patch size: size of patch textures
-const char *dxtex = ".\\dxtex.exe";
 
 char g_cwd[256];
 double g_tol = 0.0;        // tolerance for suppressing opaque/transparent pixels in a tile
 int g_nsuppressed = 0;     // number of opacity/transparency suppressed tiles
+int g_nthread = 0;         // number of threads for tile generation (0: one per CPU core)
+DxtQuality g_dxtQuality = DXTQ_NORMAL; // texture compression quality
+DxtErrorStat g_dxtError;   // accumulated texture compression error
+std::mutex g_outputLock;   // serialises console output, directory creation and g_dxtError updates
 
 IWICImagingFactory *g_pIWICFactory;
 
@@ -61,8 +69,6 @@ BGR *ReadPNG (char *fname, LONG &mapw, LONG &maph, WORD &bpp);
 DWORD WriteDDS (BGR *img, Alpha *aimg, LONG imgw, LONG imgh, const char *root,
 				const char *layer, int res, int ilng, int ilat, bool mipmap = false, bool binary_alpha = true);
 
-void SetOutputHeader (BITMAPFILEHEADER &bmfh, BITMAPINFOHEADER &bmih, LONG w, LONG h);
-
 void FatalError (char *msg);
 void InitProgress (int ntot, int len);
 void SetProgress (int p);
@@ -72,6 +78,7 @@ bool MakePath (const char *fname);
 
 void SplitBitmap ();
 void SplitBitmap_cloud ();
+void ReportCompression ();
 
 // ==============================================================================
 
@@ -90,9 +97,22 @@ int main (int argc, char *argv[])
 	if (hr != S_OK)
 		g_pIWICFactory = NULL;
 		
+	for (int i = 1; i < argc; i++) {
+		if (argv[i][0] != '-') continue;
+		switch (argv[i][1]) {
+		case 'q': // compression quality: 0=fast, 1=normal, 2=high
+			g_dxtQuality = (DxtQuality)max (0, min (2, atoi (argv[i]+2)));
+			break;
+		case 't': // number of threads
+			g_nthread = atoi (argv[i]+2);
+			break;
+		}
+	}
+
 	char cmd;
 
-	std::cout << "plsplit: Orbiter planetary texture generation tool.\n\n";
+	std::cout << "plsplit: Orbiter planetary texture generation tool.\n";
+	std::cout << "Options: -q<0|1|2> compression quality (fast|normal|high), -t<n> threads\n\n";
 	std::cout << "(S) Generate textures for a planetary surface\n";
 	std::cout << "(C) Generate cloud textures\n";
 	std::cout << "[S|C] >> ";
@@ -286,31 +306,6 @@ BGR *ReadPNG (char *fname, LONG &mapw, LONG &maph, WORD &bpp)
 
 // ==============================================================================
 
-void SetOutputHeader (BITMAPFILEHEADER &bmfh, BITMAPINFOHEADER &bmih, LONG w, LONG h)
-{
-	char *id = (char*)&bmfh.bfType;
-	id[0] = 'B';
-	id[1] = 'M';
-	bmfh.bfSize = sizeof (BITMAPFILEHEADER) + sizeof (BITMAPINFOHEADER) + w*h*3;
-	bmfh.bfReserved1 = 0;
-	bmfh.bfReserved2 = 0;
-	bmfh.bfOffBits = sizeof (BITMAPINFOHEADER) + sizeof (BITMAPFILEHEADER);
-
-	bmih.biSize = sizeof (BITMAPINFOHEADER);
-	bmih.biWidth = w;
-	bmih.biHeight = h;
-	bmih.biPlanes = 1;
-	bmih.biBitCount = 24;
-	bmih.biCompression = BI_RGB;
-	bmih.biSizeImage = 0;
-	bmih.biXPelsPerMeter = 1;
-	bmih.biYPelsPerMeter = 1;
-	bmih.biClrUsed = 0;
-	bmih.biClrImportant = 0;
-}
-
-// ==============================================================================
-
 void FatalError (char *msg)
 {
 	cerr << endl << "pltex ERROR: " << msg << endl;
@@ -425,71 +420,46 @@ bool PureDiffuse (const Alpha *apatch)
 DWORD WriteDDS (BGR *img, Alpha *aimg, LONG imgw, LONG imgh, const char *root, const char *layer, int lvl, int ilng, int ilat,
 				bool mipmap, bool binary_alpha)
 {
-	const char *bmpname  = "tmp.bmp";
-	const char *abmpname = "tmp_a.bmp";
 	char ddsname[256];
 	sprintf (ddsname, "%s\\%s\\%02d\\%06d\\%06d.dds", root, layer, lvl, ilat, ilng);
-	MakePath (ddsname);
-	cout << "Writing  patch  " << ddsname << endl;
+	{
+		// directory creation is serialised since patches share parent directories
+		std::lock_guard<std::mutex> lock (g_outputLock);
+		MakePath (ddsname);
+		cout << "Writing  patch  " << ddsname << endl;
+	}
 
-	static BGR *bgrdummy = 0;
+	std::vector<BGR> bgrdummy;
 	if (!img) {
-		if (!bgrdummy) {
-			bgrdummy = new BGR[PS*PS];
-			memset (bgrdummy, 0, sizeof(BGR)*PS*PS);
-		}
-		img = bgrdummy;
+		bgrdummy.resize (imgw*imgh);
+		memset (bgrdummy.data(), 0, sizeof(BGR)*imgw*imgh);
+		img = bgrdummy.data();
 	}
 
-	FILE *bmpf;
-	BITMAPFILEHEADER bmfh;
-	BITMAPINFOHEADER bmih;
-	int i, ddssize = 0;
-	intptr_t res;
-	bool bopaque = false, btransparent = false;
-	int nopaque, ntransparent;
-
-	SetOutputHeader (bmfh, bmih, imgw, imgh);
-	bmpf = fopen (bmpname, "wb");
-	if (!bmpf) FatalError ("Could not open temporary bitmap file.");
-	fwrite (&bmfh, sizeof(BITMAPFILEHEADER), 1, bmpf);
-	fwrite (&bmih, sizeof(BITMAPINFOHEADER), 1, bmpf);
-	fwrite (img, 3, imgw*imgh, bmpf);
-	fclose (bmpf);
-
+	DxtFormat fmt = DXTFMT_DXT1;
 	if (aimg) { // add an alpha layer to the patch
-		bmpf = fopen (abmpname, "wb");
-		if (!bmpf) FatalError ("Could not open temporary alpha file.");
-		fwrite (&bmfh, sizeof(BITMAPFILEHEADER), 1, bmpf);
-		fwrite (&bmih, sizeof(BITMAPINFOHEADER), 1, bmpf);
-
-		// make alpha binary black/white, and count opaque/transparent pixels 
-		for (i = nopaque = ntransparent = 0; i < imgw*imgh; i++) {
-			if (binary_alpha) {
-				aimg[i] = 255 - aimg[i];   // invert
-				if (aimg[i] < 128) aimg[i] =   0, ntransparent++;
-				else               aimg[i] = 255, nopaque++;
-			} else {
-				if (aimg[i] < 128) ntransparent++;
-				else               nopaque++;
-			}
-		}
-		for (i = 0; i < imgw*imgh; i++) {
-			BGR bgr;
-			bgr.r = bgr.g = bgr.b = aimg[i];
-			fwrite (&bgr, 3, 1, bmpf);
-		}
-		fclose (bmpf);
-
-		res = _spawnl (_P_WAIT, dxtex, dxtex, bmpname, "-a", abmpname, mipmap ? "-m" : "", binary_alpha ? "DXT1" : "DXT5", ddsname, NULL);
-	} else {
-		res = _spawnl (_P_WAIT, dxtex, dxtex, bmpname, mipmap ? "-m" : "", "DXT1", ddsname, NULL);
+		if (binary_alpha) {
+			// make alpha binary black/white
+			for (int i = 0; i < imgw*imgh; i++)
+				aimg[i] = (255 - aimg[i] < 128 ? 0 : 255);   // invert
+			fmt = DXTFMT_DXT1A;
+		} else
+			fmt = DXTFMT_DXT5;
 	}
-	if (res != 0) FatalError ("Executing dxtex failed.");
 
-	remove (bmpname);
-	if (aimg) remove (abmpname);
-	return (DWORD)ddssize;
+	std::vector<uint8_t> rgba(imgw*imgh*4), dds;
+	DxtErrorStat err;
+	DxtPackBGR ((const uint8_t*)img, aimg, imgw, imgh, true, rgba.data());
+	DxtMakeDDS (rgba.data(), imgw, imgh, fmt, g_dxtQuality, mipmap, dds, 0, &err);
+
+	FILE *ddsf = fopen (ddsname, "wb");
+	if (!ddsf) FatalError ("Could not open texture file.");
+	fwrite (dds.data(), 1, dds.size(), ddsf);
+	fclose (ddsf);
+
+	std::lock_guard<std::mutex> lock (g_outputLock);
+	g_dxtError.Add (err);
+	return (DWORD)dds.size();
 }
 
 // ==============================================================================
@@ -506,25 +476,19 @@ void SplitBitmap ()
 
 	char fname[256], aname[256], lname[256], root[256], c;
 	LONG mapw, maph;
-	LONG px, py, nx, ny;
+	LONG nx, ny;
 	WORD bpp, abpp, lbpp;
 	int lvl, nlng, nlat, ilng0, ilat0;
-	int nwritten = 0, nskipped = 0;
+	std::atomic<int> nwritten(0), nskipped(0);
 	double lng0, lat0;
 	BGR *img = 0;
-	BGR *patch = new BGR[PS*PS];
 	BGR *limg = 0;
-	BGR *lpatch = new BGR[PS*PS];
 	Alpha *aimg = 0;
-	Alpha *apatch = new Alpha[PS*PS];
 	bool has_wmask;
-	bool skip_specular;
+	bool skip_specular = false;
 	bool has_lights;
 	bool output_mask;
 
-	memset (lpatch, 0, PS*PS*sizeof(BGR));
-	memset (apatch, 0, PS*PS*sizeof(Alpha));
-
 	cout << "Enter the file name for the bitmap representing the planetary surface\n";
 	cout << "area (must be in 8-bit or 24-bit BMP format). The bitmap must contain a\n";
 	cout << "surface patch in cylindrical projection, with longitude linear along the\n";
@@ -633,50 +597,57 @@ void SplitBitmap ()
 	ilng0 = (int)((lng0+180)/dlng+0.5);
 	ilat0 = (int)((90-lat0)/dlng+0.5);
 
-	for (py = 0; py < ny; py++) {
-		for (px = 0; px < nx; px++) {
-			ExtractPatch<BGR> (img, patch, py, px, mapw, maph);
-			bool genpatch = PatchHasFeatures<BGR> (patch);
-			bool skipspec = false;
-			if (output_mask) {
-				if (has_wmask) {
-					ExtractPatch<Alpha> (aimg, apatch, py, px, mapw, maph);
-					if (skip_specular) skipspec = PureSpecular (apatch);
-					genpatch = !skipspec && (genpatch || !PureDiffuse (apatch));
-					//genpatch = !skipspec && (genpatch || PatchHasFeatures<Alpha> (apatch));
-				}
-				if (has_lights && !skipspec) {
-					ExtractPatch<BGR> (limg, lpatch, py, px, mapw, maph);
-					genpatch = genpatch || PatchHasFeatures<BGR> (lpatch);
-				}
-				if (genpatch && ((has_lights && PatchHasFeatures<BGR> (lpatch)) || (has_wmask && !PureDiffuse (apatch)))) {
-					if (!has_lights) memset (lpatch, 0, PS*PS*sizeof(BGR));
-					if (!has_wmask) memset (apatch, 0, PS*PS*sizeof(Alpha));
-					WriteDDS (lpatch, apatch, PS, PS, root, "Mask", level, ilng0+px, ilat0+py);
-					nwritten++;
-				} else {
-					char cbuf[256];
-					sprintf (cbuf, "%s\\%s\\%02d\\%06d\\%06d.dds", root, "Mask", level, ilat0+py, ilng0+px);
-					cout << "Skipping patch  " << cbuf << endl;
-					nskipped++;
-				}
+	// patches are independent and are generated in parallel
+	ThreadPool pool (g_nthread);
+	pool.ParallelFor (nx*ny, [&](size_t i) {
+		LONG py = (LONG)i / nx, px = (LONG)i % nx;
+		std::vector<BGR> patch(PS*PS), lpatch(PS*PS);
+		std::vector<Alpha> apatch(PS*PS);
+		memset (lpatch.data(), 0, PS*PS*sizeof(BGR));
+		memset (apatch.data(), 0, PS*PS*sizeof(Alpha));
+
+		ExtractPatch<BGR> (img, patch.data(), py, px, mapw, maph);
+		bool genpatch = PatchHasFeatures<BGR> (patch.data());
+		bool skipspec = false;
+		if (output_mask) {
+			if (has_wmask) {
+				ExtractPatch<Alpha> (aimg, apatch.data(), py, px, mapw, maph);
+				if (skip_specular) skipspec = PureSpecular (apatch.data());
+				genpatch = !skipspec && (genpatch || !PureDiffuse (apatch.data()));
+				//genpatch = !skipspec && (genpatch || PatchHasFeatures<Alpha> (apatch));
 			}
-			if (genpatch) {
-				WriteDDS (patch, 0, PS, PS, root, "Surf", level, ilng0+px, ilat0+py);
+			if (has_lights && !skipspec) {
+				ExtractPatch<BGR> (limg, lpatch.data(), py, px, mapw, maph);
+				genpatch = genpatch || PatchHasFeatures<BGR> (lpatch.data());
+			}
+			if (genpatch && ((has_lights && PatchHasFeatures<BGR> (lpatch.data())) || (has_wmask && !PureDiffuse (apatch.data())))) {
+				WriteDDS (lpatch.data(), apatch.data(), PS, PS, root, "Mask", level, ilng0+px, ilat0+py);
 				nwritten++;
 			} else {
 				char cbuf[256];
-				sprintf (cbuf, "%s\\%s\\%02d\\%06d\\%06d.dds", root, "Surf", level, ilat0+py, ilng0+px);
+				sprintf (cbuf, "%s\\%s\\%02d\\%06d\\%06d.dds", root, "Mask", level, ilat0+py, ilng0+px);
+				std::lock_guard<std::mutex> lock (g_outputLock);
 				cout << "Skipping patch  " << cbuf << endl;
 				nskipped++;
 			}
 		}
-	}
+		if (genpatch) {
+			WriteDDS (patch.data(), 0, PS, PS, root, "Surf", level, ilng0+px, ilat0+py);
+			nwritten++;
+		} else {
+			char cbuf[256];
+			sprintf (cbuf, "%s\\%s\\%02d\\%06d\\%06d.dds", root, "Surf", level, ilat0+py, ilng0+px);
+			std::lock_guard<std::mutex> lock (g_outputLock);
+			cout << "Skipping patch  " << cbuf << endl;
+			nskipped++;
+		}
+	});
 	cout << "Wrote " << nwritten << " patches, skipped " << nskipped << endl;
+	ReportCompression ();
 
 	delete []img;
 	if (aimg) delete []aimg;
-	delete []patch;
+	if (limg) delete []limg;
 }
 
 // ==============================================================================
@@ -684,7 +655,7 @@ void SplitBitmap ()
 void SplitBitmap_cloud ()
 {
 	int level, lvl, r, g, b, nlng, nlat, ilng0, ilat0;
-	LONG mapw=0, maph=0, amapw, amaph, px, py, nx, ny;
+	LONG mapw=0, maph=0, amapw, amaph, nx, ny;
 	WORD bpp=0, abpp;
 	double lng0, lat0;
 	char cmd, fname[256], aname[256], root[256];
@@ -697,11 +668,7 @@ void SplitBitmap_cloud ()
 	if (level < 2) PS /= 2;
 
 	BGR *img = 0;
-	BGR *patch = new BGR[PS*PS];
 	Alpha *aimg = 0;
-	Alpha *apatch = new Alpha[PS*PS];
-
-	memset (apatch, 0, PS*PS*sizeof(Alpha));
 
 	cout << "Cloud colour information:\n";
 	cout << "(H) Use homogeneous cloud colour\n";
@@ -816,20 +783,29 @@ void SplitBitmap_cloud ()
 	ilng0 = (int)((lng0+180)/dlng+0.5);
 	ilat0 = (int)((90-lat0)/dlng+0.5);
 
-	for (py = 0; py < ny; py++) {
-		for (px = 0; px < nx; px++) {
-			ExtractPatch<BGR> (img, patch, py, px, mapw, maph);
-			if (has_wmask) {
-				ExtractPatch<Alpha> (aimg, apatch, py, px, mapw, maph);
-				WriteDDS (patch, apatch, PS, PS, root, "Cloud", level, ilng0+px, ilat0+py, false, false);
-			} else
-				WriteDDS (patch, 0, PS, PS, root, "Cloud", level, ilng0+px, ilat0+py);
-		}
-	}
+	ThreadPool pool (g_nthread);
+	pool.ParallelFor (nx*ny, [&](size_t i) {
+		LONG py = (LONG)i / nx, px = (LONG)i % nx;
+		std::vector<BGR> patch(PS*PS);
+		std::vector<Alpha> apatch(PS*PS);
+		ExtractPatch<BGR> (img, patch.data(), py, px, mapw, maph);
+		if (has_wmask) {
+			ExtractPatch<Alpha> (aimg, apatch.data(), py, px, mapw, maph);
+			WriteDDS (patch.data(), apatch.data(), PS, PS, root, "Cloud", level, ilng0+px, ilat0+py, false, false);
+		} else
+			WriteDDS (patch.data(), 0, PS, PS, root, "Cloud", level, ilng0+px, ilat0+py);
+	});
 	cout << "Wrote " << nx*ny << " patches" << endl;
+	ReportCompression ();
 
 	delete []img;
 	if (aimg) delete []aimg;
-	delete []patch;
-	delete []apatch;
+}
+
+// ==============================================================================
+
+void ReportCompression ()
+{
+	cout << "Texture compression (" << DxtKernelName (DxtKernelSupported()) << "): PSNR = "
+		 << setprecision(4) << g_dxtError.PSNR() << " dB" << endl;
 }
\ No newline at end of file
@@ -0,0 +1,529 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+#include "TreePack.h"
+#include "ThreadPool.h"
+#include <iostream>
+#include <condition_variable>
+#include <thread>
+#include <ctype.h>
+#include <stdio.h>
+#include <string.h>
+#include <zlib.h>
+
+namespace fs = std::filesystem;
+
+static_assert(sizeof(TreeArchiveHeader) == 48, "unexpected archive header layout");
+static_assert(sizeof(TreeArchiveEntry) == 32, "unexpected archive TOC layout");
+
+static const uint32_t NONE = (uint32_t)-1;
+
+static std::string Num (const char *fmt, int n)
+{
+	char cbuf[32];
+	snprintf (cbuf, 32, fmt, n);
+	return cbuf;
+}
+
+//==============================================================================
+
+std::string LayerExt (const char *layer)
+{
+	static const char *map[6][2] = {
+		{ "Surf", "dds" }, { "Mask", "dds" }, { "Cloud", "dds" },
+		{ "Elev", "elv" }, { "Elev_mod", "elv" }, { "Label", "lab" }
+	};
+	for (int i = 0; i < 6; i++) {
+		const char *a = map[i][0], *b = layer;
+		while (*a && *b && tolower(*a) == tolower(*b)) a++, b++;
+		if (!*a && !*b) return map[i][1];
+	}
+	return "";
+}
+
+// -----------------------------------------------------------------------------
+
+fs::path ArchivePath (const char *root, const char *layer)
+{
+	return fs::path(root) / "Archive" / (std::string(layer) + ".tree");
+}
+
+//==============================================================================
+// class TreeArchive
+
+TreeArchive::TreeArchive ()
+{
+	memset (&header, 0, sizeof(header));
+}
+
+// -----------------------------------------------------------------------------
+
+bool TreeArchive::Open (const fs::path &fname)
+{
+	Close();
+	std::error_code ec;
+	ftime = fs::last_write_time (fname, ec);
+	if (ec) return false;
+	is.open (fname, std::ios::binary);
+	if (!is) return false;
+	if (!is.read ((char*)&header, sizeof(header)) ||
+		header.magic[0] != 'T' || header.magic[1] != 'X' || header.magic[2] != 1 ||
+		header.size != sizeof(header)) {
+		Close();
+		return false;
+	}
+	toc.resize (header.ntoc);
+	if (!is.read ((char*)toc.data(), (std::streamsize)header.ntoc * sizeof(TreeArchiveEntry))) {
+		Close();
+		return false;
+	}
+	return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void TreeArchive::Close ()
+{
+	if (is.is_open()) is.close();
+	is.clear();
+	toc.clear();
+	memset (&header, 0, sizeof(header));
+}
+
+// -----------------------------------------------------------------------------
+
+uint32_t TreeArchive::NodeSizeDeflated (uint32_t idx) const
+{
+	return (uint32_t)((idx < header.ntoc-1 ? toc[idx+1].pos : header.totlength) - toc[idx].pos);
+}
+
+// -----------------------------------------------------------------------------
+
+bool TreeArchive::ReadNode (uint32_t idx, std::vector<uint8_t> &zdata)
+{
+	if (idx >= header.ntoc) return false;
+	zdata.resize (NodeSizeDeflated (idx));
+	std::lock_guard<std::mutex> lock(mutex);
+	is.seekg ((std::streamoff)header.dataOfs + toc[idx].pos);
+	return (bool)is.read ((char*)zdata.data(), zdata.size());
+}
+
+//==============================================================================
+// class MemTree
+
+MemTreeNode::MemTreeNode (int _lvl, int _ilat, int _ilng): lvl(_lvl), ilat(_ilat), ilng(_ilng)
+{
+	hasFile = false;
+	fsize = 0;
+	arcidx = NONE;
+	for (int i = 0; i < 4; i++) child[i] = 0;
+}
+
+// -----------------------------------------------------------------------------
+
+MemTree::MemTree (const char *rootpath, const char *layer)
+{
+	root1 = root2 = root3 = root4[0] = root4[1] = 0;
+	path = fs::path(rootpath) / layer;
+	ext = LayerExt (layer);
+}
+
+// -----------------------------------------------------------------------------
+
+MemTree::~MemTree ()
+{
+	DeleteSubtree (root1);
+	DeleteSubtree (root2);
+	DeleteSubtree (root3);
+	for (int i = 0; i < 2; i++)
+		DeleteSubtree (root4[i]);
+}
+
+// -----------------------------------------------------------------------------
+
+void MemTree::DeleteSubtree (MemTreeNode *node)
+{
+	if (!node) return;
+
+	for (int i = 0; i < 4; i++)
+		DeleteSubtree (node->child[i]);
+	delete node;
+}
+
+// -----------------------------------------------------------------------------
+
+void MemTree::AddLevels (int minlvl, int maxlvl)
+{
+	for (int lvl = minlvl; lvl <= maxlvl; lvl++)
+		AddLevel (lvl);
+}
+
+// -----------------------------------------------------------------------------
+
+static bool IsNumber (const std::string &s, size_t len = 0)
+{
+	if (s.empty() || (len && s.size() != len)) return false;
+	for (size_t i = 0; i < s.size(); i++)
+		if (s[i] < '0' || s[i] > '9') return false;
+	return true;
+}
+
+void MemTree::AddLevel (int lvl)
+{
+	std::error_code ec;
+	fs::path lvlpath = path / Num ("%02d", lvl);
+	if (!fs::is_directory (lvlpath, ec)) return;
+
+	std::string fext = "." + ext;
+	for (fs::directory_iterator lat(lvlpath, ec), end; !ec && lat != end; lat.increment(ec)) {
+		std::string latname = lat->path().filename().string();
+		if (!IsNumber (latname, 6) || !lat->is_directory(ec)) continue;
+		int ilat = atoi (latname.c_str());
+		for (fs::directory_iterator lng(lat->path(), ec), end; !ec && lng != end; lng.increment(ec)) {
+			if (lng->path().extension() != fext || !IsNumber (lng->path().stem().string())) continue;
+			int ilng = atoi (lng->path().stem().string().c_str());
+			if (lvl <= 4 && (ilat || ilng > (lvl == 4 ? 1 : 0))) continue; // not a valid tile
+			std::error_code fec;
+			MemTreeNode *node = InsertNode (lvl, ilat, ilng);
+			node->hasFile = true;
+			node->fsize = lng->file_size(fec);
+			node->ftime = lng->last_write_time(fec);
+		}
+		ec.clear();
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+void MemTree::AddArchive (const TreeArchive &arc, int maxlvl)
+{
+	arc.ForEachNode ([&](int lvl, int ilat, int ilng, uint32_t idx) {
+		if (lvl <= maxlvl && arc.Node(idx).size)
+			InsertNode (lvl, ilat, ilng)->arcidx = idx;
+	});
+}
+
+// -----------------------------------------------------------------------------
+
+int MemTree::NodeCount () const
+{
+	int count = 0;
+	if (root1) count++;
+	if (root2) count++;
+	if (root3) count++;
+	for (int i = 0; i < 2; i++)
+		SubtreeCount (root4[i], count);
+	return count;
+}
+
+// -----------------------------------------------------------------------------
+
+void MemTree::SubtreeCount (const MemTreeNode *node, int &count) const
+{
+	if (node) {
+		count++;
+		for (int i = 0; i < 4; i++) SubtreeCount (node->child[i], count);
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+fs::path MemTree::TilePath (int lvl, int ilat, int ilng) const
+{
+	return path / Num ("%02d", lvl) / Num ("%06d", ilat) / (Num ("%06d", ilng) + "." + ext);
+}
+
+// -----------------------------------------------------------------------------
+
+MemTreeNode *MemTree::InsertNode (int lvl, int ilat, int ilng)
+{
+	MemTreeNode *node = FindNode (lvl, ilat, ilng);
+	if (node) return node;
+
+	if (lvl == 1) {
+		return (root1 = new MemTreeNode(lvl, ilat, ilng));
+	} else if (lvl == 2) {
+		return (root2 = new MemTreeNode(lvl, ilat, ilng));
+	} else if (lvl == 3) {
+		return (root3 = new MemTreeNode(lvl, ilat, ilng));
+	} else if (lvl == 4) {
+		return (root4[ilng] = new MemTreeNode(lvl, ilat, ilng));
+	} else {
+		MemTreeNode *parent = InsertNode (lvl-1, ilat/2, ilng/2);
+		return (parent->child[((ilat&1) << 1) + (ilng&1)] = new MemTreeNode(lvl, ilat, ilng));
+	}
+}
+
+// -----------------------------------------------------------------------------
+
+const MemTreeNode *MemTree::FindNode (int lvl, int ilat, int ilng) const
+{
+	return const_cast<MemTree*>(this)->FindNode (lvl, ilat, ilng);
+}
+
+// -----------------------------------------------------------------------------
+
+MemTreeNode *MemTree::FindNode (int lvl, int ilat, int ilng)
+{
+	if (lvl == 1) {
+		return root1;
+	} else if (lvl == 2) {
+		return root2;
+	} else if (lvl == 3) {
+		return root3;
+	} else if (lvl == 4) {
+		return (ilng == 0 || ilng == 1 ? root4[ilng] : 0);
+	} else {
+		MemTreeNode *parent = FindNode (lvl-1, ilat/2, ilng/2);
+		if (!parent) return 0;
+		return parent->child[((ilat&1) << 1) + (ilng&1)];
+	}
+}
+
+//==============================================================================
+// Packing
+
+// Build the TOC in archive order (depth first, children in index order),
+// and the list of nodes in the same order
+static uint32_t AddSubtree (const MemTreeNode *node, std::vector<TreeArchiveEntry> &toc, std::vector<const MemTreeNode*> &list)
+{
+	if (!node) return NONE;
+	uint32_t idx = (uint32_t)toc.size();
+	toc.emplace_back(); // zero-initialised
+	for (int i = 0; i < 4; i++) toc[idx].child[i] = NONE;
+	list.push_back (node);
+	if (node->lvl >= 4) {
+		for (int i = 0; i < 4; i++) {
+			uint32_t cidx = AddSubtree (node->child[i], toc, list);
+			toc[idx].child[i] = cidx;
+		}
+	}
+	return idx;
+}
+
+// -----------------------------------------------------------------------------
+
+static bool ReadTile (const fs::path &fname, std::vector<uint8_t> &buf)
+{
+	std::ifstream ifs (fname, std::ios::binary | std::ios::ate);
+	if (!ifs) return false;
+	std::streamoff n = ifs.tellg();
+	buf.resize ((size_t)n);
+	ifs.seekg (0);
+	return n == 0 || (bool)ifs.read ((char*)buf.data(), n);
+}
+
+// -----------------------------------------------------------------------------
+
+bool PackLayer (const char *root, const char *layer, const TreePackParam &prm, TreePackStats *stats)
+{
+	fs::path arcname = ArchivePath (root, layer);
+
+	// build the tree of existing tiles in memory
+	MemTree tree(root, layer);
+	if (tree.Ext().empty()) {
+		std::cerr << "Unknown layer " << layer << std::endl;
+		return false;
+	}
+	tree.AddLevels (1, prm.maxlvl);
+	TreeArchive arc;
+	if (prm.incremental && arc.Open (arcname))
+		tree.AddArchive (arc, prm.maxlvl);
+
+	// construct the TOC from the tree
+	TreeArchiveHeader header;
+	header.magic[0] = 'T';
+	header.magic[1] = 'X';
+	header.magic[2] = 1;
+	header.magic[3] = 0;
+	header.size = sizeof(TreeArchiveHeader);
+	header.flags = TREE_DEFLATE;
+	header.totlength = 0;
+	std::vector<TreeArchiveEntry> toc;
+	std::vector<const MemTreeNode*> list;
+	toc.reserve (tree.NodeCount());
+	list.reserve (tree.NodeCount());
+	const MemTree &ctree = tree;
+	header.rootPos1 = AddSubtree (ctree.FindNode (1, 0, 0), toc, list);
+	header.rootPos2 = AddSubtree (ctree.FindNode (2, 0, 0), toc, list);
+	header.rootPos3 = AddSubtree (ctree.FindNode (3, 0, 0), toc, list);
+	for (int i = 0; i < 2; i++)
+		header.rootPos4[i] = AddSubtree (ctree.FindNode (4, 0, i), toc, list);
+	header.ntoc = (uint32_t)toc.size();
+	header.dataOfs = header.size + header.ntoc*sizeof(TreeArchiveEntry);
+	if (!header.ntoc) {
+		std::cerr << "No tiles found for layer " << layer << std::endl;
+		return false;
+	}
+
+	// the archive is written to a temporary file, starting with a placeholder
+	// for the header and TOC, which are filled in when all node sizes are known
+	std::error_code ec;
+	fs::create_directories (arcname.parent_path(), ec);
+	fs::path tmpname = arcname;
+	tmpname += ".tmp";
+	std::ofstream ofs (tmpname, std::ios::binary | std::ios::trunc);
+	if (!ofs) {
+		std::cerr << "Cannot write " << tmpname.string() << std::endl;
+		return false;
+	}
+	std::vector<char> zero (header.dataOfs, 0);
+	ofs.write (zero.data(), zero.size());
+
+	// Node data are produced concurrently in the order of the TOC, and written
+	// in that order by the writer thread. A producer waits before starting a
+	// new node while the data waiting to be written exceed the memory budget,
+	// unless its node is the next one to be written.
+	struct Result {
+		std::vector<uint8_t> data; // deflated node data
+		uint32_t size;             // inflated size
+		bool copied;               // copied from previous archive
+		bool done;
+	};
+	std::vector<Result> res(list.size());
+	std::mutex mutex;
+	std::condition_variable cv;
+	size_t nwritten = 0;           // number of nodes written
+	size_t buffered = 0;           // deflated data waiting to be written [bytes]
+	bool failed = false;
+	uint32_t ndeflate = 0, ncopy = 0;
+
+	std::thread writer ([&]() {
+		for (size_t i = 0; i < list.size(); i++) {
+			Result &r = res[i];
+			{
+				std::unique_lock<std::mutex> lock(mutex);
+				cv.wait (lock, [&]{ return r.done || failed; });
+				if (failed) return;
+			}
+			toc[i].pos = header.totlength;
+			toc[i].size = r.size;
+			if (r.data.size()) {
+				ofs.write ((const char*)r.data.data(), r.data.size());
+				header.totlength += r.data.size();
+				if (r.copied) ncopy++;
+				else ndeflate++;
+				if (prm.verbose) {
+					const MemTreeNode *node = list[i];
+					if (r.copied) std::cout << "copying ";
+					else std::cout << "deflating ";
+					std::cout << tree.TilePath (node->lvl, node->ilat, node->ilng).string();
+					if (!r.copied) std::cout << " [" << (r.data.size() * 100) / r.size << "%]";
+					std::cout << std::endl;
+				}
+			}
+			size_t nbuf = r.data.capacity();
+			std::vector<uint8_t>().swap (r.data);
+			std::lock_guard<std::mutex> lock(mutex);
+			buffered -= nbuf;
+			nwritten = i+1;
+			if (!ofs) failed = true;
+			cv.notify_all();
+		}
+	});
+
+	ThreadPool pool(prm.nthread);
+	pool.ParallelFor (list.size(), [&](size_t i) {
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			cv.wait (lock, [&]{ return buffered < prm.membudget || i == nwritten || failed; });
+			if (failed) return;
+		}
+		thread_local std::vector<uint8_t> buf;
+		const MemTreeNode *node = list[i];
+		Result &r = res[i];
+		r.size = 0;
+		r.copied = false;
+		bool ok = true;
+		bool reuse = node->arcidx != NONE &&
+			(!node->hasFile || (node->fsize == arc.Node(node->arcidx).size && node->ftime <= arc.Time()));
+		if (reuse) {
+			ok = arc.ReadNode (node->arcidx, r.data);
+			r.size = arc.Node(node->arcidx).size;
+			r.copied = true;
+		} else if (node->hasFile) {
+			fs::path fname = tree.TilePath (node->lvl, node->ilat, node->ilng);
+			ok = ReadTile (fname, buf);
+			if (ok && buf.size()) {
+				uLongf zsize = compressBound ((uLong)buf.size());
+				r.data.resize (zsize);
+				ok = (compress2 (r.data.data(), &zsize, buf.data(), (uLong)buf.size(), Z_DEFAULT_COMPRESSION) == Z_OK);
+				r.data.resize (zsize);
+				r.data.shrink_to_fit();
+				r.size = (uint32_t)buf.size();
+			}
+			if (!ok) std::cerr << "Error reading " << fname.string() << std::endl;
+		}
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!ok) failed = true;
+		r.done = true;
+		buffered += r.data.capacity();
+		cv.notify_all();
+	});
+	writer.join();
+
+	if (!failed) {
+		ofs.seekp (0);
+		ofs.write ((const char*)&header, sizeof(header));
+		ofs.write ((const char*)toc.data(), toc.size()*sizeof(TreeArchiveEntry));
+	}
+	ofs.close();
+	arc.Close();
+	if (failed || !ofs) {
+		std::cerr << "Error writing " << arcname.string() << std::endl;
+		fs::remove (tmpname, ec);
+		return false;
+	}
+	fs::rename (tmpname, arcname, ec);
+	if (ec) {
+		std::cerr << "Cannot replace " << arcname.string() << ": " << ec.message() << std::endl;
+		return false;
+	}
+
+	if (stats) {
+		stats->nnode = header.ntoc;
+		stats->ndeflate = ndeflate;
+		stats->ncopy = ncopy;
+		stats->datasize = header.totlength;
+	}
+	return true;
+}
+
+//==============================================================================
+// Unpacking
+
+bool ExtractLayer (const char *root, const char *layer, int maxlvl)
+{
+	fs::path arcname = ArchivePath (root, layer);
+	MemTree tree(root, layer);
+	TreeArchive arc;
+	if (!arc.Open (arcname)) {
+		std::cerr << "Cannot open " << arcname.string() << std::endl;
+		return false;
+	}
+
+	bool ok = true;
+	std::vector<uint8_t> zbuf, ebuf;
+	arc.ForEachNode ([&](int lvl, int ilat, int ilng, uint32_t idx) {
+		// nodes without data may still have descendants with data
+		uLongf esize = arc.Node(idx).size;
+		if (!ok || lvl > maxlvl || !esize) return;
+		ebuf.resize (esize);
+		if (!arc.ReadNode (idx, zbuf) ||
+			uncompress (ebuf.data(), &esize, zbuf.data(), (uLong)zbuf.size()) != Z_OK) {
+			std::cerr << "Error inflating node " << idx << std::endl;
+			ok = false;
+			return;
+		}
+		fs::path fname = tree.TilePath (lvl, ilat, ilng);
+		std::error_code ec;
+		fs::create_directories (fname.parent_path(), ec);
+		std::cout << "inflating " << fname.string() << std::endl;
+		std::ofstream ofs (fname, std::ios::binary | std::ios::trunc);
+		if (!ofs.write ((const char*)ebuf.data(), esize)) {
+			std::cerr << "Error writing " << fname.string() << std::endl;
+			ok = false;
+		}
+	});
+	return ok;
+}
@@ -0,0 +1,188 @@
+// Copyright (c) Martin Schweiger
+// Licensed under the MIT License
+
+// =======================================================================
+// TreePack
+// Packing and unpacking of planet texture layer trees into .tree archives
+// (as read by ZTreeMgr).
+// Tiles are read from <root>/<layer>/<lvl>/<ilat>/<ilng>.<ext>. Node data
+// are deflated by a pool of threads and streamed to the archive in TOC
+// order by a writer thread; the deflated data waiting to be written are
+// limited by a memory budget. In incremental mode, the deflated data of
+// tiles that haven't changed since an existing archive was written are
+// copied from that archive instead of being recompressed.
+// =======================================================================
+
+#ifndef __TREEPACK_H
+#define __TREEPACK_H
+
+#include <filesystem>
+#include <mutex>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#define TREE_DEFLATE 1
+
+// =======================================================================
+// Archive file header
+
+struct TreeArchiveHeader {
+	uint8_t magic[4];     // file ID and version
+	uint32_t size;        // header size [bytes]
+	uint32_t flags;       // bit flags
+	uint32_t dataOfs;     // file offset of start of data block (header + TOC)
+	int64_t totlength;    // total deflated data size
+	uint32_t ntoc;        // number of tree nodes
+	uint32_t rootPos1;    // array index of level 1 tile ((uint32_t)-1 for not present)
+	uint32_t rootPos2;    // array index of level 2 tile ((uint32_t)-1 for not present)
+	uint32_t rootPos3;    // array index of level 3 tile ((uint32_t)-1 for not present)
+	uint32_t rootPos4[2]; // array indices of level 4 tiles (quadtree roots; (uint32_t)-1 for not present)
+};
+
+// =======================================================================
+// Table of contents entry for a tree node
+
+struct TreeArchiveEntry {
+	int64_t pos;          // file position of compressed data block (from end of TOC)
+	uint32_t size;        // uncompressed data size
+	uint32_t child[4];    // array positions of the children ((uint32_t)-1=no child)
+	uint32_t reserved;    // alignment padding, written as 0
+};
+
+// =======================================================================
+// Read access to an existing archive
+
+class TreeArchive {
+public:
+	TreeArchive ();
+
+	bool Open (const std::filesystem::path &fname);
+	void Close ();
+	inline bool IsOpen () const { return is.is_open(); }
+
+	inline const TreeArchiveHeader &Header () const { return header; }
+	inline uint32_t nNode () const { return header.ntoc; }
+	inline const TreeArchiveEntry &Node (uint32_t idx) const { return toc[idx]; }
+	uint32_t NodeSizeDeflated (uint32_t idx) const;
+
+	inline std::filesystem::file_time_type Time () const { return ftime; }
+	// modification time of the archive file
+
+	bool ReadNode (uint32_t idx, std::vector<uint8_t> &zdata);
+	// Deflated data of node idx. Can be called concurrently.
+
+	template<class F> void ForEachNode (F func) const;
+	// Calls func(lvl, ilat, ilng, idx) for all nodes in the archive
+
+private:
+	std::ifstream is;
+	std::mutex mutex;
+	TreeArchiveHeader header;
+	std::vector<TreeArchiveEntry> toc;
+	std::filesystem::file_time_type ftime;
+};
+
+// =======================================================================
+// A single MemTree node
+
+struct MemTreeNode {
+	MemTreeNode (int _lvl, int _ilat, int _ilng);
+
+	int lvl;
+	int ilat, ilng;
+	bool hasFile;                          // tile file exists
+	uint64_t fsize;                        // tile file size
+	std::filesystem::file_time_type ftime; // tile file modification time
+	uint32_t arcidx;                       // node index in previous archive ((uint32_t)-1: none)
+	MemTreeNode *child[4];
+};
+
+// =======================================================================
+// Represents the tile tree in memory (including missing links)
+
+class MemTree {
+public:
+	MemTree (const char *rootpath, const char *layer);
+	~MemTree ();
+	void AddLevel (int lvl);
+	void AddLevels (int minlvl, int maxlvl);
+	void AddArchive (const TreeArchive &arc, int maxlvl);
+	// Add the nodes with data in an existing archive of the layer
+	int NodeCount () const;
+	const MemTreeNode *FindNode (int lvl, int ilat, int ilng) const;
+	std::filesystem::path TilePath (int lvl, int ilat, int ilng) const;
+	inline const std::string &Ext () const { return ext; }
+
+protected:
+	MemTreeNode *InsertNode (int lvl, int ilat, int ilng);
+	void SubtreeCount (const MemTreeNode *node, int &count) const;
+	MemTreeNode *FindNode (int lvl, int ilat, int ilng);
+	void DeleteSubtree (MemTreeNode *node);
+
+private:
+	MemTreeNode *root1;
+	MemTreeNode *root2;
+	MemTreeNode *root3;
+	MemTreeNode *root4[2];
+	std::filesystem::path path;
+	std::string ext;
+};
+
+// =======================================================================
+// Packing and unpacking
+
+struct TreePackParam {
+	int maxlvl;           // highest level to pack
+	int nthread;          // number of threads (0: one per hardware thread)
+	size_t membudget;     // limit for deflated data waiting to be written [bytes]
+	bool incremental;     // reuse the unchanged nodes of an existing archive
+	bool verbose;         // report each node
+	TreePackParam (): maxlvl(19), nthread(0), membudget(256 << 20), incremental(false), verbose(true) {}
+};
+
+struct TreePackStats {
+	uint32_t nnode;       // number of tree nodes
+	uint32_t ndeflate;    // number of tiles deflated
+	uint32_t ncopy;       // number of tiles copied from previous archive
+	int64_t datasize;     // deflated data size [bytes]
+};
+
+std::string LayerExt (const char *layer);
+// File extension of the tiles of a layer ("" if unknown)
+
+std::filesystem::path ArchivePath (const char *root, const char *layer);
+// Archive file of a layer: <root>/Archive/<layer>.tree
+
+bool PackLayer (const char *root, const char *layer, const TreePackParam &prm, TreePackStats *stats = 0);
+// Pack the tiles of a layer into its archive. In incremental mode, tiles
+// are copied from the existing archive if their file is not newer than
+// the archive and the size is unchanged, or if they have no tile file.
+// The archive is replaced when the new one has been written completely.
+
+bool ExtractLayer (const char *root, const char *layer, int maxlvl);
+// Unpack the archive of a layer into individual tile files
+
+// =======================================================================
+// Inline functions
+
+template<class F> void TreeArchive::ForEachNode (F func) const
+{
+	struct Item { int lvl, ilat, ilng; uint32_t idx; };
+	std::vector<Item> stack;
+	const uint32_t rootPos[5] = { header.rootPos1, header.rootPos2, header.rootPos3, header.rootPos4[0], header.rootPos4[1] };
+	for (int i = 4; i >= 0; i--)
+		stack.push_back (Item{ i < 3 ? i+1 : 4, 0, i < 3 ? 0 : i-3, rootPos[i] });
+	while (stack.size()) {
+		Item item = stack.back();
+		stack.pop_back();
+		if (item.idx >= header.ntoc) continue; // not present, or corrupt TOC
+		func (item.lvl, item.ilat, item.ilng, item.idx);
+		if (item.lvl < 4) continue;
+		for (int c = 3; c >= 0; c--)
+			stack.push_back (Item{ item.lvl+1, item.ilat*2 + (c >> 1), item.ilng*2 + (c & 1), toc[item.idx].child[c] });
+	}
+}
+
+#endif // !__TREEPACK_H
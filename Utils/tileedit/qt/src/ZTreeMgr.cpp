@@ -171,12 +171,16 @@ DWORD ZTreeMgr::ReadData(DWORD idx, BYTE **outp) const
 	if (!esize) // node doesn't have data, but has descendants with data
 		return 0;
 
-	if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET))
-		return 0;
-
 	DWORD zsize = NodeSizeDeflated(idx);
-	BYTE *zbuf = new BYTE[zsize];	
-	fread(zbuf, 1, zsize, treef);
+	BYTE *zbuf = new BYTE[zsize];
+	{
+		std::lock_guard<std::mutex> lock(treef_lock);
+		if (_fseeki64(treef, toc[idx].pos+dofs, SEEK_SET)) {
+			delete []zbuf;
+			return 0;
+		}
+		fread(zbuf, 1, zsize, treef);
+	}
 
 	BYTE *ebuf = new BYTE[esize];
 
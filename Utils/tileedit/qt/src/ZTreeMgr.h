@@ -7,6 +7,7 @@
 #define __ZTREEMGR_H
 
 #include <iostream>
+#include <mutex>
 #include <windows.h>
 
 // =======================================================================
@@ -89,6 +90,7 @@ public:
 	// return the array index of an arbitrary tile ((DWORD)-1: not present)
 
 	DWORD ReadData(DWORD idx, BYTE **outp) const;
+	// Can be called concurrently from multiple threads
 
 	inline DWORD ReadData(int lvl, int ilat, int ilng, BYTE **outp) const
 	{ return ReadData(Idx(lvl, ilat, ilng), outp); }
@@ -112,6 +114,7 @@ private:
 	DWORD rootPos3;    // index of level-3 tile ((DWORD)-1 for not present)
 	DWORD rootPos4[2]; // index of the level-4 tiles (quadtree roots; (DWORD)-1 for not present)
 	__int64 dofs;
+	mutable std::mutex treef_lock; // serialises file access in ReadData
 };
 
 #endif // !__ZTREEMGR_H
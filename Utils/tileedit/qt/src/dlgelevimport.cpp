@@ -1,10 +1,13 @@
 #include "dlgelevimport.h"
 #include "ui_dlgElevImport.h"
 #include "tileedit.h"
-#include "tileblock.h"
+#include "elevimport.h"
 
 #include <QFileDialog>
 #include <QMessageBox>
+#include <QProgressDialog>
+#include <chrono>
+#include <thread>
 
 DlgElevImport::DlgElevImport(tileedit *parent)
 	: QDialog(parent)
@@ -59,7 +62,7 @@ void DlgElevImport::onOpenMetaFileDialog()
 
 void DlgElevImport::onMetaFileChanged(const QString &name)
 {
-	m_haveMeta = scanMetaFile(name.toLatin1(), m_metaInfo);
+	m_haveMeta = elvreadmeta(name.toLatin1(), m_metaInfo);
 	if (m_haveMeta) {
 		ui->labelLvl->setText(QString::number(m_metaInfo.lvl));
 		ui->spinIlat0->setValue(m_metaInfo.ilat0);
@@ -114,38 +117,6 @@ void DlgElevImport::onPropagateChanges(int state)
 	ui->widgetPropagateChanges->setEnabled(state == Qt::Checked);
 }
 
-bool DlgElevImport::scanMetaFile(const char *fname, ElevPatchMetaInfo &meta)
-{
-	FILE *f = fopen(fname, "rt");
-	if (!f) return false;
-
-	int ilat, ilng, n;
-	double smin, emin, smean, emean, smax, emax;
-	char str[1024];
-	fscanf(f, "vmin=%lf vmax=%lf scale=%lf offset=%lf type=%d padding=1x1 colormap=%d smin=%lf emin=%lf smean=%lf emean=%lf smax=%lf emax=%lf latmin=%lf latmax=%lf lngmin=%lf lngmax=%lf\n",
-		&meta.dmin, &meta.dmax, &meta.scale, &meta.offset, &meta.type, &meta.colormap, &smin, &emin, &smean, &emean, &smax, &emax,
-		&meta.latmin, &meta.latmax, &meta.lngmin, &meta.lngmax);
-	if (fscanf(f, "lvl=%d ilat0=%d ilat1=%d ilng0=%d ilng1=%d\n",
-		&meta.lvl, &meta.ilat0, &meta.ilat1, &meta.ilng0, &meta.ilng1) != 5) {
-		meta.lvl = meta.ilat0 = meta.ilat1 = meta.ilng0 = meta.ilng1 = 0;
-	}
-	else {
-		fscanf(f, "%s", str);
-		if (!strncmp(str, "missing", 7)) {
-			while (true) {
-				n = fscanf(f, "%d/%d", &ilat, &ilng);
-				if (n == 2) {
-					meta.missing.push_back(std::make_pair(ilat, ilng));
-				}
-				else
-					break;
-			}
-		}
-	}
-	fclose(f);
-	return true;
-}
-
 void DlgElevImport::accept()
 {
 	if (!m_haveMeta) {
@@ -181,43 +152,44 @@ void DlgElevImport::accept()
 		}
 	}
 
-	if (m_metaInfo.colormap != 0) {
-		QMessageBox mbox(QMessageBox::Warning, tr("tileedit: Warning"), tr("Unsupported colormap specified in metafile. PNG file must be 16-bit greyscale image (colormap 0)."), QMessageBox::Close);
-		mbox.exec();
-		return;
-	}
-	ElevTileBlock *eblock = ElevTileBlock::Load(m_metaInfo.lvl, m_metaInfo.ilat0, m_metaInfo.ilat1, m_metaInfo.ilng0, m_metaInfo.ilng1);
-	if (!elvread_png(ui->editPath->text().toLatin1(), m_metaInfo, eblock->getData())) {
-		QMessageBox mbox(QMessageBox::Warning, tr("tileedit: Warning"), tr("Error reading PNG file"), QMessageBox::Close);
-		mbox.exec();
-		return;
+	ElevImportParam prm;
+	prm.ilat0 = ui->spinIlat0->value();
+	prm.ilat1 = ui->spinIlat1->value() + 1;
+	prm.ilng0 = ui->spinIlng0->value();
+	prm.ilng1 = ui->spinIlng1->value() + 1;
+	prm.propagationLevel = m_propagationLevel;
+	prm.writeMode = (ui->checkSkipMissing->isChecked() ? ELEVWRITE_MOD : ELEVWRITE_MODCREATE);
+	ElevImport import(m_metaInfo, prm);
+
+	// run the import on a worker thread to keep the GUI responsive
+	std::string path = ui->editPath->text().toLatin1().constData();
+	std::atomic<bool> done(false);
+	bool ok = false;
+	std::thread worker([&]() {
+		ok = import.Run(path.c_str());
+		done = true;
+	});
+
+	QProgressDialog progress(tr("Importing elevation tiles ..."), tr("Cancel"), 0, import.nTiles(), this);
+	progress.setWindowModality(Qt::WindowModal);
+	progress.setMinimumDuration(500);
+	while (!done) {
+		if (progress.wasCanceled())
+			import.Cancel();
+		progress.setValue(import.nTilesDone());
+		QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+		std::this_thread::sleep_for(std::chrono::milliseconds(20));
 	}
+	worker.join();
+	bool cancelled = progress.wasCanceled();
+	progress.reset();
 
-	int ilat0 = ui->spinIlat0->value();
-	int ilat1 = ui->spinIlat1->value() + 1;
-	int ilng0 = ui->spinIlng0->value();
-	int ilng1 = ui->spinIlng1->value() + 1;
-
-	for (int ilat = ilat0; ilat < ilat1; ilat++)
-		for (int ilng = ilng0; ilng < ilng1; ilng++) {
-			eblock->syncTile(ilat, ilng);
-			ElevTile *etile = (ElevTile*)eblock->_getTile(ilat, ilng);
-			if (etile->Level() == etile->subLevel())
-				etile->SaveMod();
-			else if (!ui->checkSkipMissing->isChecked()) {
-				ElevTile *tile = ElevTile::InterpolateFromAncestor(m_metaInfo.lvl, ilat, ilng);
-				if (tile) {
-					tile->dataChanged();
-					tile->Save();
-					tile->getData() = etile->getData();
-					tile->dataChanged();
-					tile->SaveMod();
-				}
-			}
-		}
-	if (m_propagationLevel) {
-		eblock->mapToAncestors(m_propagationLevel);
+	if (!ok && !cancelled) {
+		QMessageBox mbox(QMessageBox::Warning, tr("tileedit: Warning"), QString::fromStdString(import.Error()), QMessageBox::Close);
+		mbox.exec();
+		if (!import.nTilesWritten())
+			return;
 	}
 
-	QDialog::accept();
+	QDialog::accept(); // refresh, also after partial imports
 }
\ No newline at end of file
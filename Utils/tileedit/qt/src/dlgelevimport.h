@@ -27,9 +27,6 @@ public slots:
 	void onPropagateChanges(int);
 	void accept();
 
-protected:
-	bool scanMetaFile(const char *fname, ElevPatchMetaInfo &meta);
-
 private:
 	Ui::DlgElevImport *ui;
 	tileedit *m_tileedit;
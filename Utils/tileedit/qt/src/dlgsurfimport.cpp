@@ -2,6 +2,7 @@
 #include "ui_dlgSurfImport.h"
 #include "tileedit.h"
 #include "tileblock.h"
+#include "ThreadPool.h"
 
 #include <QFileDialog>
 #include <QMessageBox>
@@ -145,12 +146,17 @@ void DlgSurfImport::accept()
 		settings->setValue("export/path", fi.absolutePath());
 	}
 
-	for (int ilat = m_metaInfo.ilat0; ilat < m_metaInfo.ilat1; ilat++)
-		for (int ilng = m_metaInfo.ilng0; ilng < m_metaInfo.ilng1; ilng++) {
-			sblock->syncTile(ilat, ilng);
-			SurfTile *stile = (SurfTile*)sblock->_getTile(ilat, ilng);
-			stile->Save();
-		}
+	// The tiles are independent, so they are compressed and written in parallel
+	ThreadPool pool;
+	int nlng = max(0, m_metaInfo.ilng1 - m_metaInfo.ilng0);
+	int ntile = max(0, m_metaInfo.ilat1 - m_metaInfo.ilat0) * nlng;
+	pool.ParallelFor(ntile, [&](size_t i) {
+		int ilat = m_metaInfo.ilat0 + (int)i / nlng;
+		int ilng = m_metaInfo.ilng0 + (int)i % nlng;
+		sblock->syncTile(ilat, ilng);
+		SurfTile *stile = (SurfTile*)sblock->_getTile(ilat, ilng);
+		stile->Save();
+	});
 	if (ui->checkPropagateChanges->isChecked())
 		sblock->mapToAncestors(ui->spinPropagationLevel->value());
 	
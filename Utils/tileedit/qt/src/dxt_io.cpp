@@ -1,74 +1,22 @@
 #include "dxt_io.h"
 #include <png.h>
-#include <libdxt.h>
-
-struct DDS_PIXELFORMAT {
-	DWORD dwSize;
-	DWORD dwFlags;
-	DWORD dwFourCC;
-	DWORD dwRGBBitCount;
-	DWORD dwRBitMask;
-	DWORD dwGBitMask;
-	DWORD dwBBitMask;
-	DWORD dwABitMask;
-};
-
-struct DDS_HEADER{
-	DWORD           dwSize;
-	DWORD           dwFlags;
-	DWORD           dwHeight;
-	DWORD           dwWidth;
-	DWORD           dwPitchOrLinearSize;
-	DWORD           dwDepth;
-	DWORD           dwMipMapCount;
-	DWORD           dwReserved1[11];
-	DDS_PIXELFORMAT ddspf;
-	DWORD           dwCaps;
-	DWORD           dwCaps2;
-	DWORD           dwCaps3;
-	DWORD           dwCaps4;
-	DWORD           dwReserved2;
-};
-
-void setdxt1header(const Image &idata, DDS_HEADER &hdr)
-{
-	const char fourcc[4] = { 'D', 'X', 'T', '1' };
-
-	memset(&hdr, 0, sizeof(DDS_HEADER));
-	hdr.dwSize = sizeof(DDS_HEADER);
-	hdr.dwFlags = 0x00081007;
-	hdr.dwHeight = idata.height;
-	hdr.dwWidth = idata.width;
-	hdr.dwPitchOrLinearSize = idata.height * idata.width / 2;
-	hdr.ddspf.dwSize = sizeof(DDS_PIXELFORMAT);
-	hdr.ddspf.dwFlags = 0x4;
-	hdr.ddspf.dwFourCC = *(DWORD*)fourcc;
-	hdr.dwCaps = 0x1000;
-}
+#include <DxtEnc.h>
 
 void dxt1write(const char *fname, const Image &idata)
 {
-	const char magic[4] = { 'D', 'D', 'S', ' ' };
-	int format = FORMAT_DXT1;
-	byte *dxt1 = new byte[idata.width * idata.height * 4];
-
 	// Need to flip RGB order for the compression engine
-	DWORD *inp = new DWORD[idata.width * idata.height];
+	std::vector<uint32_t> inp(idata.width * idata.height);
 	const DWORD *id = idata.data.data();
 	for (int i = 0; i < idata.width*idata.height; i++)
 		inp[i] = 0xff000000 | ((id[i] & 0xff) << 16) | (id[i] & 0xff00) | ((id[i] & 0xff0000) >> 16);
 
-	int n = CompressDXT((const byte*)inp, dxt1, idata.width, idata.height, format);
+	std::vector<uint8_t> dds;
+	DxtMakeDDS((const uint8_t*)inp.data(), idata.width, idata.height, DXTFMT_DXT1, DXTQ_NORMAL, false, dds);
 
-	DDS_HEADER hdr;
-	setdxt1header(idata, hdr);
 	FILE *f = fopen(fname, "wb");
-	fwrite(magic, 1, 4, f);
-	fwrite(&hdr, sizeof(DDS_HEADER), 1, f);
-	fwrite(dxt1, n, 1, f);
+	if (!f) return;
+	fwrite(dds.data(), 1, dds.size(), f);
 	fclose(f);
-	delete[]dxt1;
-	delete[]inp;
 }
 
 bool pngread_tmp(const char *fname, Image &idata)
@@ -0,0 +1,145 @@
+#include "elevimport.h"
+#include "ThreadPool.h"
+
+// ==================================================================================
+
+ElevImport::ElevImport(const ElevPatchMetaInfo &meta, const ElevImportParam &prm)
+	: m_meta(meta)
+	, m_prm(prm)
+	, m_cancel(false)
+	, m_ndone(0)
+	, m_nwritten(0)
+{
+	LevelRange r;
+	r.ilat0 = r.ilatNext = prm.ilat0;
+	r.ilat1 = prm.ilat1;
+	r.ilng0 = prm.ilng0;
+	r.ilng1 = prm.ilng1;
+	m_range.push_back(r);
+	m_ntile = max(0, r.ilat1 - r.ilat0) * max(0, r.ilng1 - r.ilng0);
+
+	m_minlvl = (prm.propagationLevel ? max(4, prm.propagationLevel) : meta.lvl);
+	if (!m_ntile)
+		return;
+
+	// ancestor tiles covering the imported range
+	for (int lvl = meta.lvl - 1; lvl >= m_minlvl; lvl--) {
+		const LevelRange &c = m_range.back();
+		LevelRange p;
+		p.ilat0 = p.ilatNext = c.ilat0 / 2;
+		p.ilat1 = (c.ilat1 - 1) / 2 + 1;
+		p.ilng0 = c.ilng0 / 2;
+		p.ilng1 = (c.ilng1 - 1) / 2 + 1;
+		m_range.push_back(p);
+		m_ntile += (p.ilat1 - p.ilat0) * (p.ilng1 - p.ilng0);
+	}
+}
+
+bool ElevImport::Run(const char *fname)
+{
+	if (m_meta.colormap != 0) {
+		m_error = "Unsupported colormap specified in metafile. PNG file must be 16-bit greyscale image (colormap 0).";
+		return false;
+	}
+	if (m_prm.ilat0 < m_meta.ilat0 || m_prm.ilat1 > m_meta.ilat1 || m_prm.ilat0 >= m_prm.ilat1 ||
+		m_prm.ilng0 < m_meta.ilng0 || m_prm.ilng1 > m_meta.ilng1 || m_prm.ilng0 >= m_prm.ilng1) {
+		m_error = "Tile range is empty or not covered by the image";
+		return false;
+	}
+
+	ElevPngReader png;
+	if (!png.Open(fname)) {
+		m_error = "Error reading PNG file. Must be a non-interlaced 16-bit greyscale image.";
+		return false;
+	}
+	int w = (m_meta.ilng1 - m_meta.ilng0) * TILE_FILERES + 3;
+	int h = (m_meta.ilat1 - m_meta.ilat0) * TILE_FILERES + 3;
+	if (png.Width() != w || png.Height() != h) {
+		m_error = "Image size doesn't match the tile range in the metadata";
+		return false;
+	}
+
+	// Image rows of one row of tiles, including padding. Consecutive tile rows
+	// share 3 image rows, which are kept when the next band is read.
+	const int nshare = TILE_ELEVSTRIDE - TILE_FILERES;
+	std::vector<unsigned short> band((size_t)w * TILE_ELEVSTRIDE);
+	bool ok = png.ReadRows(nshare, band.data());
+
+	ThreadPool pool(m_prm.nthread);
+	for (int ilat = m_meta.ilat0; ok && ilat < m_prm.ilat1 && !m_cancel; ilat++) {
+		if (ilat > m_meta.ilat0)
+			memmove(band.data(), band.data() + (size_t)w * TILE_FILERES, (size_t)w * nshare * sizeof(unsigned short));
+		ok = png.ReadRows(TILE_FILERES, band.data() + (size_t)w * nshare);
+		if (ok && ilat >= m_prm.ilat0) {
+			ImportRow(pool, ilat, band);
+			PropagateRows(pool);
+		}
+	}
+	if (!ok) {
+		m_error = "Error reading PNG file";
+		return false;
+	}
+	if (m_cancel) {
+		m_error = "Import cancelled";
+		return false;
+	}
+	return true;
+}
+
+void ElevImport::ImportRow(ThreadPool &pool, int ilat, const std::vector<unsigned short> &band)
+{
+	LevelRange &r = m_range[0];
+	const size_t w = band.size() / TILE_ELEVSTRIDE;
+
+	pool.ParallelFor(r.ilng1 - r.ilng0, [&](size_t i) {
+		if (m_cancel) return;
+		int ilng = r.ilng0 + (int)i;
+		int x0 = (ilng - m_meta.ilng0) * TILE_FILERES;
+		ElevData edata;
+		edata.width = edata.height = TILE_ELEVSTRIDE;
+		edata.data.resize(TILE_ELEVSTRIDE * TILE_ELEVSTRIDE);
+		edata.dres = m_meta.scale;
+		for (int y = 0; y < TILE_ELEVSTRIDE; y++) {
+			// image rows run north to south, tile rows south to north
+			const unsigned short *v16 = band.data() + (TILE_ELEVSTRIDE - 1 - y) * w + x0;
+			for (int x = 0; x < TILE_ELEVSTRIDE; x++)
+				edata.data[y * TILE_ELEVSTRIDE + x] = ElevPngReader::Elevation(v16[x], m_meta);
+		}
+		if (ElevTile::Import(m_meta.lvl, ilat, ilng, edata, m_prm.writeMode))
+			m_nwritten++;
+		m_ndone++;
+	});
+	r.ilatNext = ilat + 1;
+}
+
+void ElevImport::PropagateRows(ThreadPool &pool)
+{
+	for (size_t k = 1; k < m_range.size(); k++) {
+		LevelRange &p = m_range[k];
+		const LevelRange &c = m_range[k - 1];
+		while (p.ilatNext < p.ilat1 && !m_cancel) {
+			// the children of a tile row and their neighbours span child rows 2*ilat-1 to 2*ilat+2
+			if (c.ilatNext < min(p.ilatNext * 2 + 3, c.ilat1))
+				break;
+			DownsampleRow(pool, m_meta.lvl - (int)k, p.ilatNext);
+			p.ilatNext++;
+		}
+	}
+}
+
+void ElevImport::DownsampleRow(ThreadPool &pool, int lvl, int ilat)
+{
+	const LevelRange &r = m_range[m_meta.lvl - lvl];
+
+	pool.ParallelFor(r.ilng1 - r.ilng0, [&](size_t i) {
+		if (m_cancel) return;
+		bool isModified;
+		ElevTile *etile = ElevTile::LoadFromChildren(lvl, ilat, r.ilng0 + (int)i, isModified);
+		if (etile) {
+			if (isModified && etile->Write(m_prm.writeMode))
+				m_nwritten++;
+			delete etile;
+		}
+		m_ndone++;
+	});
+}
@@ -0,0 +1,82 @@
+#ifndef ELEVIMPORT_H
+#define ELEVIMPORT_H
+
+#include "elv_io.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+struct ElevImportParam {
+	int ilat0, ilat1;          ///< latitude index range of the tiles to import
+	int ilng0, ilng1;          ///< longitude index range of the tiles to import
+	int propagationLevel;      ///< map the changes down to this level (0: don't propagate)
+	ElevWriteMode writeMode;   ///< target layer, and handling of missing tiles
+	int nthread;               ///< number of threads (0: one per hardware thread)
+
+	ElevImportParam() {
+		ilat0 = ilat1 = ilng0 = ilng1 = 0;
+		propagationLevel = 0;
+		writeMode = ELEVWRITE_MODCREATE;
+		nthread = 0;
+	}
+};
+
+/**
+ * \brief Import of an elevation image into the tile tree, independent of the GUI
+ *
+ * The image is read sequentially, one row of tiles at a time, and the tiles
+ * of each row are written in parallel. Changes are propagated to the lower
+ * resolution levels as soon as all children (and their neighbours) of a row
+ * of ancestor tiles have been written, so the memory requirement doesn't
+ * depend on the size of the image.
+ * Tile::setRoot and ElevTile::setTreeMgr must have been set up by the caller.
+ */
+class ElevImport
+{
+public:
+	ElevImport(const ElevPatchMetaInfo &meta, const ElevImportParam &prm);
+
+	/**
+	 * \brief Import the image. Can be called from a worker thread.
+	 * \return false on error or if cancelled. See Error() for details.
+	 */
+	bool Run(const char *fname);
+
+	/**
+	 * \brief Stop the import after the tiles currently being processed.
+	 *    Can be called from any thread.
+	 */
+	void Cancel() { m_cancel = true; }
+
+	int nTiles() const { return m_ntile; }             ///< number of tiles to process, including ancestors
+	int nTilesDone() const { return m_ndone; }         ///< number of tiles processed so far
+	int nTilesWritten() const { return m_nwritten; }   ///< number of tiles written so far
+	const std::string &Error() const { return m_error; }
+
+protected:
+	void ImportRow(ThreadPool &pool, int ilat, const std::vector<unsigned short> &band);
+	void PropagateRows(ThreadPool &pool);
+	void DownsampleRow(ThreadPool &pool, int lvl, int ilat);
+
+private:
+	ElevPatchMetaInfo m_meta;
+	ElevImportParam m_prm;
+	std::string m_error;
+	std::atomic<bool> m_cancel;
+	std::atomic<int> m_ndone;
+	std::atomic<int> m_nwritten;
+	int m_ntile;
+	int m_minlvl;    ///< lowest level to propagate to
+
+	/// tile ranges and progress for the import level (index 0) and its ancestors
+	struct LevelRange {
+		int ilat0, ilat1;
+		int ilng0, ilng1;
+		int ilatNext;  ///< first row that has not been processed yet
+	};
+	std::vector<LevelRange> m_range;
+};
+
+#endif // !ELEVIMPORT_H
@@ -0,0 +1,126 @@
+// Headless front end for the tileedit elevation import
+
+#include "elevimport.h"
+#include "ZTreeMgr.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <thread>
+
+int main(int narg, char *arg[])
+{
+	if (narg < 3) {
+		std::cerr << "\nelevimport: Orbiter elevation tile import tool" << std::endl;
+		std::cerr << "  Imports an elevation image into the elevation tile tree of a planet," << std::endl;
+		std::cerr << "  and maps the changes to the lower resolution levels." << std::endl;
+		std::cerr << "\nUsage: elevimport <Planet-tree-root> <PNG-file> [<Flags>]" << std::endl;
+		std::cerr << "\n<Planet-tree-root>:" << std::endl;
+		std::cerr << "  Path to planet textures, e.g." << std::endl;
+		std::cerr << "  c:\\Orbiter\\Textures\\Earth" << std::endl;
+		std::cerr << "\n<PNG-file>:" << std::endl;
+		std::cerr << "  16-bit greyscale image in the format written by the tileedit" << std::endl;
+		std::cerr << "  elevation export, with metadata in <PNG-file>.hdr" << std::endl;
+		std::cerr << "\n<Flags>:" << std::endl;
+		std::cerr << "  -h<file>: read metadata from <file>" << std::endl;
+		std::cerr << "  -r<ilat0>,<ilat1>,<ilng0>,<ilng1>: import only this tile range" << std::endl;
+		std::cerr << "         (inclusive; default: all tiles of the image)" << std::endl;
+		std::cerr << "  -p<x>: map changes down to level <x> (default: none)" << std::endl;
+		std::cerr << "  -b   : write to the Elev layer instead of Elev_mod" << std::endl;
+		std::cerr << "  -s   : skip tiles that don't exist at the import level" << std::endl;
+		std::cerr << "  -t<n>: use <n> threads (default: one per CPU core)" << std::endl;
+		std::cerr << "  -d   : read existing tiles from the tile directories only," << std::endl;
+		std::cerr << "         not from the archives" << std::endl;
+		exit(1);
+	}
+
+	const char *root = arg[1];
+	const char *fname = arg[2];
+	std::string metaname = std::string(fname) + ".hdr";
+	ElevImportParam prm;
+	bool haveRange = false;
+	bool base = false, skipMissing = false, useArchive = true;
+
+	for (int i = 3; i < narg; i++) {
+		if (arg[i][0] != '-') continue;
+		switch (arg[i][1]) {
+		case 'h':
+			metaname = arg[i] + 2;
+			break;
+		case 'r':
+			haveRange = (sscanf(arg[i] + 2, "%d,%d,%d,%d", &prm.ilat0, &prm.ilat1, &prm.ilng0, &prm.ilng1) == 4);
+			prm.ilat1++;
+			prm.ilng1++;
+			break;
+		case 'p':
+			sscanf(arg[i] + 2, "%d", &prm.propagationLevel);
+			break;
+		case 'b':
+			base = true;
+			break;
+		case 's':
+			skipMissing = true;
+			break;
+		case 't':
+			sscanf(arg[i] + 2, "%d", &prm.nthread);
+			break;
+		case 'd':
+			useArchive = false;
+			break;
+		}
+	}
+	prm.writeMode = (base ? ELEVWRITE_BASE : skipMissing ? ELEVWRITE_MOD : ELEVWRITE_MODCREATE);
+
+	ElevPatchMetaInfo meta;
+	if (!elvreadmeta(metaname.c_str(), meta)) {
+		std::cerr << "Error reading metadata file " << metaname << std::endl;
+		return 1;
+	}
+	if (!meta.lvl) {
+		std::cerr << "Metadata do not contain tile index information" << std::endl;
+		return 1;
+	}
+	if (!haveRange) {
+		prm.ilat0 = meta.ilat0;
+		prm.ilat1 = meta.ilat1;
+		prm.ilng0 = meta.ilng0;
+		prm.ilng1 = meta.ilng1;
+	}
+
+	Tile::setRoot(root);
+	Tile::setOpenMode(useArchive ? 0x3 : 0x1);
+	ZTreeMgr *mgrElev = 0, *mgrElevMod = 0;
+	if (useArchive) {
+		mgrElev = ZTreeMgr::CreateFromFile(root, ZTreeMgr::LAYER_ELEV);
+		mgrElevMod = ZTreeMgr::CreateFromFile(root, ZTreeMgr::LAYER_ELEVMOD);
+	}
+	ElevTile::setTreeMgr(mgrElev, mgrElevMod);
+
+	std::cout << "Importing " << fname << " into " << root << std::endl;
+	std::cout << "Level " << meta.lvl << ", tiles " << prm.ilat0 << "-" << prm.ilat1 - 1
+		<< " / " << prm.ilng0 << "-" << prm.ilng1 - 1 << std::endl;
+
+	ElevImport import(meta, prm);
+	bool ok = false;
+	std::atomic<bool> done(false);
+	std::thread worker([&]() {
+		ok = import.Run(fname);
+		done = true;
+	});
+	while (!done) {
+		std::cout << "\r" << import.nTilesDone() << "/" << import.nTiles() << " tiles" << std::flush;
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+	}
+	worker.join();
+	std::cout << "\r" << import.nTilesDone() << "/" << import.nTiles() << " tiles" << std::endl;
+
+	ElevTile::setTreeMgr(0, 0);
+	if (mgrElev) delete mgrElev;
+	if (mgrElevMod) delete mgrElevMod;
+
+	if (!ok) {
+		std::cerr << import.Error() << std::endl;
+		return 1;
+	}
+	std::cout << import.nTilesWritten() << " tiles written" << std::endl;
+	return 0;
+}
@@ -333,23 +333,71 @@ void ElevTile::MatchNeighbourTiles()
 	}
 }
 
-bool ElevTile::mapToAncestors(int minlvl) const
+bool ElevTile::Write(ElevWriteMode mode)
 {
-	const double eps = 1e-6;
+	if (mode == ELEVWRITE_BASE) {
+		m_modified = true;
+		Save();
+	}
+	else if (m_lvl == m_sublvl) {
+		m_modified = true;
+		SaveMod();
+	}
+	else if (mode == ELEVWRITE_MODCREATE) {
+		// synthesized tile: the ancestor interpolation becomes the base data
+		ElevTile *etile = ElevTile::InterpolateFromAncestor(m_lvl, m_ilat, m_ilng);
+		if (!etile)
+			return false;
+		etile->dataChanged();
+		etile->Save();
+		etile->m_edata = m_edata;
+		etile->dataChanged();
+		etile->SaveMod();
+		delete etile;
+	}
+	else
+		return false;
 
+	return true;
+}
+
+bool ElevTile::mapToAncestors(int minlvl) const
+{
 	if (m_lvl <= 4 || m_lvl <= minlvl)
 		return false;
 
-	int lvl = m_lvl - 1;
-	int ilat = m_ilat / 2;
-	int ilng = m_ilng / 2;
+	bool isModified;
+	ElevTile *etile = LoadFromChildren(m_lvl - 1, m_ilat / 2, m_ilng / 2, isModified);
+	if (!etile)
+		return false;
+
+	if (isModified) {
+		etile->dataChanged();
+		etile->SaveMod();
+		etile->mapToAncestors(minlvl); // recursively propagate changes down the quadtree
+	}
+	delete etile;
+
+	return isModified;
+}
+
+ElevTile *ElevTile::LoadFromChildren(int lvl, int ilat, int ilng, bool &isModified)
+{
+	const double eps = 1e-6;
 
+	isModified = false;
 	ElevTile *etile = ElevTile::Load(lvl, ilat, ilng);
 	if (!etile)
-		return false;
+		return 0;
+	if (etile->m_edata.width < TILE_ELEVSTRIDE)
+		etile->InterpolateFromAncestor();
 
 	ElevData &edata = etile->getData();
-	ElevTileBlock *etile4 = ElevTileBlock::Load(m_lvl, ilat * 2 - 1, ilat * 2 + 3, ilng * 2 - 1, ilng * 2 + 3);
+	ElevTileBlock *etile4 = ElevTileBlock::Load(lvl + 1, ilat * 2 - 1, ilat * 2 + 3, ilng * 2 - 1, ilng * 2 + 3);
+	if (!etile4) {
+		delete etile;
+		return 0;
+	}
 	ElevData &edata4 = etile4->getData();
 
 	int w4 = edata4.width;
@@ -357,7 +405,6 @@ bool ElevTile::mapToAncestors(int minlvl) const
 	int xofs = TILE_FILERES - 1;
 	int yofs = TILE_FILERES - 1;
 	int ofs = xofs + yofs * w4;
-	bool isModified = false;
 
 	for (int y = 0; y < edata.height; y++) {
 		for (int x = 0; x < edata.width; x++) {
@@ -373,14 +420,7 @@ bool ElevTile::mapToAncestors(int minlvl) const
 	}
 	delete etile4;
 
-	if (isModified) {
-		etile->dataChanged();
-		etile->SaveMod();
-		etile->mapToAncestors(minlvl); // recursively propagate changes down the quadtree
-	}
-	delete etile;
-
-	return isModified;
+	return etile;
 }
 
 TileBlock *ElevTile::ProlongToChildren() const
@@ -480,6 +520,34 @@ ElevTile *ElevTile::InterpolateFromAncestor(int lvl, int ilat, int ilng, const C
 	return etile;
 }
 
+bool ElevTile::Import(int lvl, int ilat, int ilng, const ElevData &edata, ElevWriteMode mode)
+{
+	ElevTile *etile = ElevTile::Load(lvl, ilat, ilng);
+	if (etile && etile->m_sublvl != lvl) { // synthesized from an ancestor subregion
+		delete etile;
+		etile = 0;
+	}
+	if (!etile) {
+		if (mode == ELEVWRITE_MOD)
+			return false;
+		etile = ElevTile::InterpolateFromAncestor(lvl, ilat, ilng);
+		if (!etile) {
+			if (mode != ELEVWRITE_BASE)
+				return false;
+			// no ancestor data either: start from scratch
+			etile = new ElevTile(lvl, ilat, ilng);
+			etile->m_edata.width = etile->m_edata.height = TILE_ELEVSTRIDE;
+			etile->m_edata.dres = edata.dres;
+			etile->m_edataBase = etile->m_edata;
+		}
+	}
+	etile->m_edata.data = edata.data;
+	etile->RescanLimits();
+	bool ok = etile->Write(mode);
+	delete etile;
+	return ok;
+}
+
 void ElevTile::setTreeMgr(const ZTreeMgr *treeMgr, const ZTreeMgr *treeModMgr)
 {
 	s_treeMgr = treeMgr;
@@ -38,6 +38,12 @@ struct ElevDisplayParam {
 	}
 };
 
+enum ElevWriteMode {
+	ELEVWRITE_MOD,       ///< write to the modification layer, skip tiles that don't exist
+	ELEVWRITE_MODCREATE, ///< write to the modification layer, create missing tiles from their ancestors
+	ELEVWRITE_BASE       ///< write to the base layer
+};
+
 
 class ElevTile : public Tile {
 	friend class TileBlock;
@@ -48,6 +54,24 @@ public:
 	static ElevTile *Load(int lvl, int ilat, int ilng);
 	static ElevTile *InterpolateFromAncestor(int lvl, int ilat, int ilng, const Cmap *cm = 0);
 	static void setTreeMgr(const ZTreeMgr *mgr, const ZTreeMgr *modMgr = 0);
+
+	/**
+	 * \brief Replace the elevations of a tile with imported data and write the tile
+	 * \param edata imported elevation grid (TILE_ELEVSTRIDE x TILE_ELEVSTRIDE)
+	 * \return true if the tile was written
+	 * \note Can be called concurrently for different tiles.
+	 */
+	static bool Import(int lvl, int ilat, int ilng, const ElevData &edata, ElevWriteMode mode);
+
+	/**
+	 * \brief Load a tile and recompute its elevations from the 4x4 block of
+	 *    its children and their neighbours at level lvl+1
+	 * \param isModified set to true if any elevations have changed
+	 * \return Recomputed tile, or 0 if the tile or its children can't be loaded.
+	 *    The caller owns the tile.
+	 */
+	static ElevTile *LoadFromChildren(int lvl, int ilat, int ilng, bool &isModified);
+
 	const std::string Layer() const { return std::string("Elev"); }
 	double nodeElevation(int ndx, int ndy);
 
@@ -61,6 +85,13 @@ public:
 	void dataChanged(int exmin = -1, int exmax = -1, int eymin = -1, int eymax = -1);
 	void Save();
 	void SaveMod();
+
+	/**
+	 * \brief Save the tile to the layer selected by mode
+	 * \return false if the tile was not written because it doesn't exist
+	 */
+	bool Write(ElevWriteMode mode);
+
 	void MatchNeighbourTiles();
 	bool mapToAncestors(int minlvl) const;
 
@@ -436,6 +436,114 @@ bool elvread_png(const char *fname, const ElevPatchMetaInfo &meta, ElevData &eda
 
 // ==================================================================================
 
+bool elvreadmeta(const char *fname, ElevPatchMetaInfo &meta)
+{
+	FILE *f = fopen(fname, "rt");
+	if (!f) return false;
+
+	int ilat, ilng, n;
+	double smin, emin, smean, emean, smax, emax;
+	char str[1024];
+	fscanf(f, "vmin=%lf vmax=%lf scale=%lf offset=%lf type=%d padding=1x1 colormap=%d smin=%lf emin=%lf smean=%lf emean=%lf smax=%lf emax=%lf latmin=%lf latmax=%lf lngmin=%lf lngmax=%lf\n",
+		&meta.dmin, &meta.dmax, &meta.scale, &meta.offset, &meta.type, &meta.colormap, &smin, &emin, &smean, &emean, &smax, &emax,
+		&meta.latmin, &meta.latmax, &meta.lngmin, &meta.lngmax);
+	if (fscanf(f, "lvl=%d ilat0=%d ilat1=%d ilng0=%d ilng1=%d\n",
+		&meta.lvl, &meta.ilat0, &meta.ilat1, &meta.ilng0, &meta.ilng1) != 5) {
+		meta.lvl = meta.ilat0 = meta.ilat1 = meta.ilng0 = meta.ilng1 = 0;
+	}
+	else {
+		fscanf(f, "%s", str);
+		if (!strncmp(str, "missing", 7)) {
+			while (true) {
+				n = fscanf(f, "%d/%d", &ilat, &ilng);
+				if (n == 2) {
+					meta.missing.push_back(std::make_pair(ilat, ilng));
+				}
+				else
+					break;
+			}
+		}
+	}
+	fclose(f);
+	return true;
+}
+
+// ==================================================================================
+
+ElevPngReader::ElevPngReader()
+{
+	m_file = 0;
+	m_png = 0;
+	m_info = 0;
+	m_width = m_height = 0;
+}
+
+ElevPngReader::~ElevPngReader()
+{
+	Close();
+}
+
+bool ElevPngReader::Open(const char *fname)
+{
+	Close();
+	m_file = fopen(fname, "rb");
+	if (!m_file)
+		return false;
+
+	m_png = png_create_read_struct(PNG_LIBPNG_VER_STRING, NULL, NULL, NULL);
+	if (m_png)
+		m_info = png_create_info_struct(m_png);
+	if (!m_info) {
+		Close();
+		return false;
+	}
+	if (setjmp(png_jmpbuf(m_png))) { // libpng error
+		Close();
+		return false;
+	}
+	png_init_io(m_png, m_file);
+	png_read_info(m_png, m_info);
+
+	// only non-interlaced images can be read row by row
+	if (png_get_bit_depth(m_png, m_info) != 16 ||
+		png_get_color_type(m_png, m_info) != PNG_COLOR_TYPE_GRAY ||
+		png_get_interlace_type(m_png, m_info) != PNG_INTERLACE_NONE) {
+		Close();
+		return false;
+	}
+	png_set_swap(m_png); // PNG stores 16-bit samples big-endian
+	png_read_update_info(m_png, m_info);
+
+	m_width = png_get_image_width(m_png, m_info);
+	m_height = png_get_image_height(m_png, m_info);
+	return true;
+}
+
+void ElevPngReader::Close()
+{
+	if (m_png)
+		png_destroy_read_struct(&m_png, m_info ? &m_info : NULL, NULL);
+	if (m_file)
+		fclose(m_file);
+	m_file = 0;
+	m_png = 0;
+	m_info = 0;
+	m_width = m_height = 0;
+}
+
+bool ElevPngReader::ReadRows(int nrow, unsigned short *buf)
+{
+	if (!m_png)
+		return false;
+	if (setjmp(png_jmpbuf(m_png))) // libpng error
+		return false;
+	for (int i = 0; i < nrow; i++)
+		png_read_row(m_png, (png_bytep)(buf + (size_t)i * m_width), NULL);
+	return true;
+}
+
+// ==================================================================================
+
 void elvwrite_png(const char *fname, const ElevData &edata, double vmin, double vmax)
 {
 	int w = edata.width;
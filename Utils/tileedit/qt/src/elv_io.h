@@ -15,6 +15,45 @@ struct ElevPatchMetaInfo
 	std::vector<std::pair<int, int> > missing;
 };
 
+/**
+ * \brief Read the metadata file (.hdr) of an exported elevation image
+ */
+bool elvreadmeta(const char *fname, ElevPatchMetaInfo &meta);
+
+/**
+ * \brief Sequential row reader for 16-bit greyscale PNG elevation images
+ *
+ * Unlike elvread_png, only the rows being processed need to be held in
+ * memory, so images covering large tile ranges can be imported.
+ */
+class ElevPngReader
+{
+public:
+	ElevPngReader();
+	~ElevPngReader();
+	bool Open(const char *fname);
+	void Close();
+	int Width() const { return m_width; }
+	int Height() const { return m_height; }
+
+	/**
+	 * \brief Read the next nrow image rows (top to bottom) into buf
+	 */
+	bool ReadRows(int nrow, unsigned short *buf);
+
+	/**
+	 * \brief Map a raw image value to elevation, consistent with elvread_png
+	 */
+	static double Elevation(unsigned short v16, const ElevPatchMetaInfo &meta)
+	{ return (double)v16 * ((meta.dmax - meta.dmin) / (double)USHRT_MAX) + meta.dmin; }
+
+private:
+	FILE *m_file;
+	struct png_struct_def *m_png;
+	struct png_info_def *m_info;
+	int m_width, m_height;
+};
+
 ElevData elvread(const char *fname);
 bool elvmodread(const char *fname, ElevData &edata);
 